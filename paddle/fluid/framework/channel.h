@@ -21,18 +21,29 @@
 
 #include <glog/logging.h>
 #include <algorithm>
+#include <atomic>
 #include <condition_variable>  // NOLINT
 #include <deque>
 #include <limits>
 #include <memory>
 #include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
 #include <utility>
 #include <vector>
 #include "paddle/fluid/framework/expect.h"
+#include "paddle/fluid/framework/mpmc_queue.h"
+#include "paddle/fluid/platform/monitor.h"
 
 namespace paddle {
 namespace framework {
 
+// kMutex: an unbounded (or bounded) deque guarded by one mutex.
+// kLockFree: a bounded lock-free ring buffer, producers and consumers only
+//   block on the mutex when the channel is full or empty. The capacity of a
+//   kLockFree channel is fixed when it is created.
+enum class ChannelBackend { kMutex, kLockFree };
+
 template <class T>
 class ChannelObject {
  public:
@@ -43,8 +54,33 @@ class ChannelObject {
     capacity_ = (std::min)(MaxCapacity(), capacity);
   }
 
-  const std::deque<T>& GetData() const { return data_; }
+  ChannelObject(size_t capacity, ChannelBackend backend)
+      : ChannelObject(capacity) {
+    if (backend == ChannelBackend::kLockFree) {
+      CHECK(capacity_ < MaxCapacity())
+          << "lock-free channel must be bounded";
+      ring_.reset(new MPMCQueue<T>(std::max(capacity_, size_t(1))));
+      capacity_ = ring_->Capacity();
+    }
+  }
+
+  ChannelBackend Backend() const {
+    return ring_ ? ChannelBackend::kLockFree : ChannelBackend::kMutex;
+  }
+
+  const std::deque<T>& GetData() const {
+    CHECK(!ring_) << "GetData() is not supported by lock-free channel";
+    return data_;
+  }
+
   void Clear() {
+    if (ring_) {
+      T val;
+      while (ring_->TryPop(&val)) {
+      }
+      NotifyLockFree();
+      return;
+    }
     std::unique_lock<std::mutex> lock(mutex_);
     data_.clear();
     data_.shrink_to_fit();
@@ -55,6 +91,7 @@ class ChannelObject {
   }
 
   void SetCapacity(size_t x) {  // capacity can be zero
+    CHECK(!ring_) << "capacity of lock-free channel can not be changed";
     std::lock_guard<std::mutex> lock(mutex_);
     capacity_ = std::min(MaxCapacity(), x);
     Notify();
@@ -73,7 +110,9 @@ class ChannelObject {
   template <class U>
   void InheritFrom(const std::shared_ptr<ChannelObject<U>>& other) {
     std::lock_guard<std::mutex> lock(mutex_);
-    capacity_ = other->Capacity();
+    if (!ring_) {
+      capacity_ = other->Capacity();
+    }
     block_size_ = other->BlockSize();
   }
 
@@ -85,22 +124,45 @@ class ChannelObject {
   void Open() {
     std::lock_guard<std::mutex> lock(mutex_);
     closed_ = false;
-    Notify();
+    if (ring_) {
+      empty_cond_.notify_all();
+      full_cond_.notify_all();
+    } else {
+      Notify();
+    }
   }
 
   // close channel, then no more data can be write() to channel
   void Close() {
     std::lock_guard<std::mutex> lock(mutex_);
     closed_ = true;
-    Notify();
+    if (ring_) {
+      empty_cond_.notify_all();
+      full_cond_.notify_all();
+    } else {
+      Notify();
+    }
   }
 
   size_t Size() {
+    if (ring_) {
+      return ring_->SizeApprox();
+    }
     std::lock_guard<std::mutex> lock(mutex_);
     return data_.size();
   }
 
+  // Export the size of the channel as the gauge of the name, which is summed
+  // with those of the other channels of the same name, e.g. of a dataset.
+  void SetStatName(const std::string& name) {
+    stat_gauge_.reset(new platform::StatGauge(
+        name, [this] { return static_cast<int64_t>(Size()); }));
+  }
+
   bool Empty() {
+    if (ring_) {
+      return ring_->SizeApprox() == 0;
+    }
     std::lock_guard<std::mutex> lock(mutex_);
     return EmptyUnlocked();
   }
@@ -114,6 +176,9 @@ class ChannelObject {
     if (n == 0) {
       return 0;
     }
+    if (ring_) {
+      return LockFreeRead(n, p);
+    }
 
     std::unique_lock<std::mutex> lock(mutex_);
     size_t finished = Read(n, p, lock);
@@ -133,6 +198,9 @@ class ChannelObject {
     if (n == 0) {
       return 0;
     }
+    if (ring_) {
+      return LockFreeWrite(n, p);
+    }
     std::unique_lock<std::mutex> lock(mutex_);
     size_t finished = Write(n, p, lock);
     Notify();
@@ -144,6 +212,9 @@ class ChannelObject {
     if (n == 0) {
       return 0;
     }
+    if (ring_) {
+      return LockFreeWriteMove(n, p);
+    }
     std::unique_lock<std::mutex> lock(mutex_);
     size_t finished = WriteMove(n, p, lock);
     Notify();
@@ -182,7 +253,7 @@ class ChannelObject {
  private:
   size_t capacity_ = MaxCapacity();
   size_t block_size_ = 1024;
-  bool closed_ = false;
+  std::atomic<bool> closed_{false};
   std::mutex mutex_;
   // use deque to store data
   std::deque<T> data_;
@@ -191,6 +262,14 @@ class ChannelObject {
   int full_waiters_ = 0;
   std::condition_variable empty_cond_;
   std::condition_variable full_cond_;
+  // Only used by kLockFree backend, the mutex and condition variables above
+  // are only taken by threads which find the ring empty or full.
+  std::unique_ptr<MPMCQueue<T>> ring_;
+  std::atomic<int> lf_empty_waiters_{0};
+  std::atomic<int> lf_full_waiters_{0};
+  static constexpr int kLockFreeSpinCount = 64;
+  // destroyed first, so that the gauge never samples a destroyed channel
+  std::unique_ptr<platform::StatGauge> stat_gauge_;
 
   static constexpr size_t MaxCapacity() {
     return (std::numeric_limits<size_t>::max)() / 2;
@@ -271,6 +350,101 @@ class ChannelObject {
     return finished;
   }
 
+  // Wake up the threads sleeping on the ring. The lock makes sure that a
+  // waiter is either still checking the ring or already waiting.
+  void NotifyLockFree() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (lf_empty_waiters_.load(std::memory_order_relaxed) != 0 ||
+        lf_full_waiters_.load(std::memory_order_relaxed) != 0) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      empty_cond_.notify_all();
+      full_cond_.notify_all();
+    }
+  }
+
+  // returns false if the channel is closed and empty
+  bool LockFreeWaitForRead() {
+    for (int i = 0; i < kLockFreeSpinCount; ++i) {
+      if (ring_->SizeApprox() != 0) {
+        return true;
+      }
+      if (closed_) {
+        return ring_->SizeApprox() != 0;
+      }
+      std::this_thread::yield();
+    }
+    NotifyLockFree();
+    std::unique_lock<std::mutex> lock(mutex_);
+    lf_empty_waiters_++;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    while (ring_->SizeApprox() == 0 && !closed_) {
+      empty_cond_.wait(lock);
+    }
+    lf_empty_waiters_--;
+    return ring_->SizeApprox() != 0;
+  }
+
+  // returns false if the channel is closed
+  bool LockFreeWaitForWrite() {
+    for (int i = 0; i < kLockFreeSpinCount; ++i) {
+      if (closed_) {
+        return false;
+      }
+      if (ring_->SizeApprox() < capacity_) {
+        return true;
+      }
+      std::this_thread::yield();
+    }
+    NotifyLockFree();
+    std::unique_lock<std::mutex> lock(mutex_);
+    lf_full_waiters_++;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    while (ring_->SizeApprox() >= capacity_ && !closed_) {
+      full_cond_.wait(lock);
+    }
+    lf_full_waiters_--;
+    return !closed_;
+  }
+
+  size_t LockFreeRead(size_t n, T* p) {
+    size_t finished = 0;
+    while (finished < n) {
+      if (ring_->TryPop(&p[finished])) {
+        ++finished;
+      } else if (!LockFreeWaitForRead()) {
+        break;
+      }
+    }
+    NotifyLockFree();
+    return finished;
+  }
+
+  size_t LockFreeWrite(size_t n, const T* p) {
+    size_t finished = 0;
+    while (finished < n && !closed_) {
+      if (ring_->TryPush(p[finished])) {
+        ++finished;
+      } else if (!LockFreeWaitForWrite()) {
+        break;
+      }
+    }
+    NotifyLockFree();
+    return finished;
+  }
+
+  size_t LockFreeWriteMove(size_t n, T* p) {
+    size_t finished = 0;
+    while (finished < n && !closed_) {
+      if (ring_->TryPush(std::move(p[finished]))) {
+        ++finished;
+      } else if (!LockFreeWaitForWrite()) {
+        break;
+      }
+    }
+    NotifyLockFree();
+    return finished;
+  }
+
   size_t WriteMove(size_t n,
                    T* p,                                  // NOLINT
                    std::unique_lock<std::mutex>& lock) {  // NOLINT
@@ -294,6 +468,13 @@ Channel<T> MakeChannel(size_t capacity = (std::numeric_limits<size_t>::max)()) {
   return std::make_shared<ChannelObject<T>>(capacity);
 }
 
+// The capacity of a lock-free channel would be rounded up to the power of 2.
+template <class T>
+Channel<T> MakeLockFreeChannel(size_t capacity) {
+  return std::make_shared<ChannelObject<T>>(capacity,
+                                            ChannelBackend::kLockFree);
+}
+
 template <class T, class U>
 Channel<T> MakeChannel(const Channel<U>& other) {
   CHECK(other != nullptr) << "channel can not be NULL";
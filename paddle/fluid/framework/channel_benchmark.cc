@@ -0,0 +1,106 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Throughput benchmark of ChannelObject backends. Half of the threads write
+// instances into one channel and the other half read from it, which is how
+// the parser threads of InMemoryDataFeed feed DatasetImpl.
+//
+// Usage:
+//   ./channel_benchmark --threads=2,8,32,64 --block_size=1
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <iostream>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/channel.h"
+#include "paddle/fluid/string/split.h"
+
+DEFINE_string(threads, "2,4,8,16,32,64",
+              "Comma separated total thread numbers (producers + consumers).");
+DEFINE_int32(instances, 1000000, "Instances written by all producers.");
+DEFINE_int32(capacity, 4096, "Capacity of the channel.");
+DEFINE_int32(block_size, 1,
+             "Instances written or read by each Write/Read call.");
+
+namespace paddle {
+namespace framework {
+
+// An instance of the size of a small Record.
+struct BenchInstance {
+  uint64_t feasigns[8];
+};
+
+static double RunBenchmark(ChannelBackend backend, int thread_num) {
+  int producer_num = std::max(thread_num / 2, 1);
+  int consumer_num = std::max(thread_num - producer_num, 1);
+  int per_producer = FLAGS_instances / producer_num;
+  size_t block_size = static_cast<size_t>(FLAGS_block_size);
+
+  auto chan = backend == ChannelBackend::kLockFree
+                  ? MakeLockFreeChannel<BenchInstance>(FLAGS_capacity)
+                  : MakeChannel<BenchInstance>(FLAGS_capacity);
+  chan->SetBlockSize(block_size);
+
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < consumer_num; ++i) {
+    threads.emplace_back([&] {
+      std::vector<BenchInstance> data;
+      while (chan->Read(data) != 0) {
+      }
+    });
+  }
+  for (int i = 0; i < producer_num; ++i) {
+    threads.emplace_back([&] {
+      std::vector<BenchInstance> data(block_size);
+      for (int j = 0; j < per_producer; j += block_size) {
+        chan->Write(data);
+      }
+    });
+  }
+  for (int i = 0; i < producer_num; ++i) {
+    threads[consumer_num + i].join();
+  }
+  chan->Close();
+  for (int i = 0; i < consumer_num; ++i) {
+    threads[i].join();
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end - start).count();
+}
+
+}  // namespace framework
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  using paddle::framework::ChannelBackend;
+
+  std::cout << "backend\tthreads\tseconds\tM instances/s" << std::endl;
+  for (auto& s : paddle::string::Split(FLAGS_threads, ',')) {
+    int thread_num = std::stoi(s);
+    for (auto backend : {ChannelBackend::kMutex, ChannelBackend::kLockFree}) {
+      double seconds = paddle::framework::RunBenchmark(backend, thread_num);
+      std::cout << (backend == ChannelBackend::kMutex ? "mutex" : "lock_free")
+                << "\t" << thread_num << "\t" << seconds << "\t"
+                << FLAGS_instances / seconds / 1e6 << std::endl;
+    }
+  }
+  return 0;
+}
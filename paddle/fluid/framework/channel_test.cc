@@ -0,0 +1,149 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/channel.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+namespace paddle {
+namespace framework {
+
+static Channel<int> CreateChannel(ChannelBackend backend, size_t capacity) {
+  return backend == ChannelBackend::kLockFree
+             ? MakeLockFreeChannel<int>(capacity)
+             : MakeChannel<int>(capacity);
+}
+
+static void TestProducerConsumer(ChannelBackend backend, int producer_num,
+                                 int consumer_num) {
+  const int kNumPerProducer = 10000;
+  auto chan = CreateChannel(backend, 64);
+  chan->SetBlockSize(16);
+
+  std::atomic<int64_t> sum{0};
+  std::atomic<int64_t> count{0};
+  std::vector<std::thread> producers;
+  std::vector<std::thread> consumers;
+  for (int i = 0; i < consumer_num; ++i) {
+    consumers.emplace_back([&] {
+      std::vector<int> data;
+      while (chan->Read(data) != 0) {
+        for (int x : data) {
+          sum += x;
+        }
+        count += data.size();
+      }
+    });
+  }
+  for (int i = 0; i < producer_num; ++i) {
+    producers.emplace_back([&, i] {
+      std::vector<int> data;
+      for (int j = 0; j < kNumPerProducer; ++j) {
+        data.push_back(i * kNumPerProducer + j);
+        if (data.size() == 10) {
+          ASSERT_EQ(chan->Write(std::move(data)), 10UL);
+          data.clear();
+        }
+      }
+      if (!data.empty()) {
+        chan->Write(data);
+      }
+    });
+  }
+  for (auto& th : producers) {
+    th.join();
+  }
+  chan->Close();
+  for (auto& th : consumers) {
+    th.join();
+  }
+
+  int64_t total = static_cast<int64_t>(producer_num) * kNumPerProducer;
+  EXPECT_EQ(count, total);
+  EXPECT_EQ(sum, total * (total - 1) / 2);
+  EXPECT_TRUE(chan->Empty());
+}
+
+TEST(Channel, mutex_producer_consumer) {
+  TestProducerConsumer(ChannelBackend::kMutex, 1, 1);
+  TestProducerConsumer(ChannelBackend::kMutex, 8, 4);
+}
+
+TEST(Channel, lock_free_producer_consumer) {
+  TestProducerConsumer(ChannelBackend::kLockFree, 1, 1);
+  TestProducerConsumer(ChannelBackend::kLockFree, 4, 8);
+  TestProducerConsumer(ChannelBackend::kLockFree, 8, 4);
+}
+
+TEST(Channel, lock_free_close) {
+  auto chan = MakeLockFreeChannel<int>(3);
+  EXPECT_EQ(chan->Backend(), ChannelBackend::kLockFree);
+  EXPECT_EQ(chan->Capacity(), 4UL);
+
+  std::vector<int> data = {0, 1, 2, 3, 4, 5};
+  std::thread writer([&] {
+    // blocks when the channel is full, and stops when it is closed
+    EXPECT_EQ(chan->Write(data.size(), data.data()), 4UL);
+  });
+  while (chan->Size() < 4) {
+    std::this_thread::yield();
+  }
+  chan->Close();
+  writer.join();
+
+  EXPECT_FALSE(chan->Put(6));
+  std::vector<int> out;
+  EXPECT_EQ(chan->ReadAll(out), 4UL);
+  EXPECT_EQ(out, std::vector<int>({0, 1, 2, 3}));
+  int val;
+  EXPECT_FALSE(chan->Get(val));
+
+  chan->Open();
+  EXPECT_TRUE(chan->Put(7));
+  EXPECT_TRUE(chan->Get(val));
+  EXPECT_EQ(val, 7);
+}
+
+static int64_t GetGauge(const std::string& name) {
+  for (auto& stat : platform::StatGaugeRegistry::Instance().publish()) {
+    if (stat.key == name) {
+      return stat.value;
+    }
+  }
+  return -1;
+}
+
+TEST(Channel, stat_gauge) {
+  auto chan = MakeChannel<int>();
+  auto lock_free_chan = MakeLockFreeChannel<int>(8);
+  chan->SetStatName("STAT_channel_test_size");
+  lock_free_chan->SetStatName("STAT_channel_test_size");
+  EXPECT_EQ(GetGauge("STAT_channel_test_size"), 0);
+
+  chan->Put(1);
+  chan->Put(2);
+  lock_free_chan->Put(3);
+  EXPECT_EQ(GetGauge("STAT_channel_test_size"), 3);
+
+  chan.reset();
+  EXPECT_EQ(GetGauge("STAT_channel_test_size"), 1);
+  lock_free_chan.reset();
+  EXPECT_EQ(GetGauge("STAT_channel_test_size"), -1);
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -35,6 +35,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/feed_fetch_type.h"
 #include "paddle/fluid/framework/fleet/box_wrapper.h"
 #include "paddle/fluid/framework/fleet/fleet_wrapper.h"
+#include "paddle/fluid/framework/slot_record_file.h"
 #include "paddle/fluid/platform/monitor.h"
 #include "paddle/fluid/platform/timer.h"
 
@@ -132,6 +133,14 @@ bool DataFeed::PickOneFile(std::string* filename) {
   return true;
 }
 
+std::shared_ptr<FILE> DataFeed::OpenPickedFile(const std::string& filename,
+                                               int* err_no) {
+  if (file_prefetcher_ != nullptr) {
+    return file_prefetcher_->Open(filename, err_no);
+  }
+  return fs_open_read(filename, err_no, pipe_command_);
+}
+
 void DataFeed::CheckInit() {
   PADDLE_ENFORCE(finish_init_, "Initialization did not succeed.");
 }
@@ -173,6 +182,14 @@ void PrivateQueueDataFeed<T>::SetQueueSize(int queue_size) {
   queue_->SetCapacity(queue_size);
 }
 
+template <typename T>
+void PrivateQueueDataFeed<T>::SetLockFreeQueueCapacity(int64_t capacity) {
+  if (capacity > 0) {
+    queue_ = paddle::framework::MakeLockFreeChannel<T>(
+        static_cast<size_t>(capacity));
+  }
+}
+
 template <typename T>
 bool PrivateQueueDataFeed<T>::Start() {
   CheckSetFileList();
@@ -189,7 +206,7 @@ void PrivateQueueDataFeed<T>::ReadThread() {
   std::string filename;
   while (PickOneFile(&filename)) {
     int err_no = 0;
-    fp_ = fs_open_read(filename, &err_no, pipe_command_);
+    fp_ = OpenPickedFile(filename, &err_no);
     __fsetlocking(&*fp_, FSETLOCKING_BYCALLER);
     T instance;
     while (ParseOneInstanceFromPipe(&instance)) {
@@ -379,7 +396,7 @@ void InMemoryDataFeed<T>::LoadIntoMemory() {
     } else {
 #endif
       int err_no = 0;
-      this->fp_ = fs_open_read(filename, &err_no, this->pipe_command_);
+      this->fp_ = this->OpenPickedFile(filename, &err_no);
 #ifdef PADDLE_WITH_BOX_PS
     }
 #endif
@@ -470,7 +487,7 @@ void MultiSlotDataFeed::ReadThread() {
   std::string filename;
   while (PickOneFile(&filename)) {
     int err_no = 0;
-    fp_ = fs_open_read(filename, &err_no, pipe_command_);
+    fp_ = OpenPickedFile(filename, &err_no);
     CHECK(fp_ != nullptr);
     __fsetlocking(&*fp_, FSETLOCKING_BYCALLER);
     std::vector<MultiSlotType> instance;
@@ -824,6 +841,24 @@ void MultiSlotInMemoryDataFeed::Init(
   input_type_ = data_feed_desc.input_type();
 }
 
+bool MultiSlotInMemoryDataFeed::Start() {
+#ifdef _LINUX
+  bool need_data = output_channel_->Size() == 0;
+  InMemoryDataFeed<Record>::Start();
+  // Records loaded from slot record files stay in the mapped files until
+  // now, each reader copies one block of them into its output channel.
+  if (need_data && slot_record_index_ != nullptr &&
+      slot_record_index_->Size() != 0) {
+    std::vector<Record> data;
+    if (slot_record_index_->ReadBlock(&data) != 0) {
+      output_channel_->Write(std::move(data));
+    }
+  }
+#endif
+  this->finish_start_ = true;
+  return true;
+}
+
 void MultiSlotInMemoryDataFeed::GetMsgFromLogKey(const std::string& log_key,
                                                  uint64_t* search_id,
                                                  uint32_t* cmatch,
@@ -841,13 +876,17 @@ void MultiSlotInMemoryDataFeed::GetMsgFromLogKey(const std::string& log_key,
 bool MultiSlotInMemoryDataFeed::ParseOneInstanceFromPipe(Record* instance) {
 #ifdef _LINUX
   thread_local string::LineFileReader reader;
+  // feasigns are parsed into buffers and then inserted into the instance at
+  // once, so that the instance allocates only once
+  thread_local std::vector<FeatureItem> uint64_feasigns;
+  thread_local std::vector<FeatureItem> float_feasigns;
+  uint64_feasigns.clear();
+  float_feasigns.clear();
 
   if (!reader.getline(&*(fp_.get()))) {
     return false;
   } else {
     const char* str = reader.get();
-    std::string line = std::string(str);
-    // VLOG(3) << line;
     char* endptr = const_cast<char*>(str);
     int pos = 0;
     if (parse_ins_id_) {
@@ -858,7 +897,7 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstanceFromPipe(Record* instance) {
       while (str[pos + len] != ' ') {
         ++len;
       }
-      instance->ins_id_ = std::string(str + pos, len);
+      instance->ins_id_.assign(str + pos, len);
       pos += len + 1;
       VLOG(3) << "ins_id " << instance->ins_id_;
     }
@@ -870,7 +909,7 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstanceFromPipe(Record* instance) {
       while (str[pos + len] != ' ') {
         ++len;
       }
-      instance->content_ = std::string(str + pos, len);
+      instance->content_.assign(str + pos, len);
       pos += len + 1;
       VLOG(3) << "content " << instance->content_;
     }
@@ -916,7 +955,7 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstanceFromPipe(Record* instance) {
             }
             FeatureKey f;
             f.float_feasign_ = feasign;
-            instance->float_feasigns_.push_back(FeatureItem(f, idx));
+            float_feasigns.push_back(FeatureItem(f, idx));
           }
         } else if (all_slots_type_[i][0] == 'u') {  // uint64
           for (int j = 0; j < num; ++j) {
@@ -928,21 +967,25 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstanceFromPipe(Record* instance) {
             }
             FeatureKey f;
             f.uint64_feasign_ = feasign;
-            instance->uint64_feasigns_.push_back(FeatureItem(f, idx));
+            uint64_feasigns.push_back(FeatureItem(f, idx));
           }
         }
         pos = endptr - str;
       } else {
         for (int j = 0; j <= num; ++j) {
           // pos = line.find_first_of(' ', pos + 1);
-          while (line[pos + 1] != ' ') {
+          while (str[pos + 1] != ' ') {
             pos++;
           }
         }
       }
     }
-    instance->float_feasigns_.shrink_to_fit();
-    instance->uint64_feasigns_.shrink_to_fit();
+    instance->float_feasigns_.insert(instance->float_feasigns_.end(),
+                                     float_feasigns.begin(),
+                                     float_feasigns.end());
+    instance->uint64_feasigns_.insert(instance->uint64_feasigns_.end(),
+                                      uint64_feasigns.begin(),
+                                      uint64_feasigns.end());
     fea_num_ += instance->uint64_feasigns_.size();
     return true;
   }
@@ -954,6 +997,12 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstanceFromPipe(Record* instance) {
 bool MultiSlotInMemoryDataFeed::ParseOneInstance(Record* instance) {
 #ifdef _LINUX
   std::string line;
+  // feasigns are parsed into buffers and then inserted into the instance at
+  // once, so that the instance allocates only once
+  thread_local std::vector<FeatureItem> uint64_feasigns;
+  thread_local std::vector<FeatureItem> float_feasigns;
+  uint64_feasigns.clear();
+  float_feasigns.clear();
   if (getline(file_, line)) {
     VLOG(3) << line;
     // parse line
@@ -980,7 +1029,7 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstance(Record* instance) {
             }
             FeatureKey f;
             f.float_feasign_ = feasign;
-            instance->float_feasigns_.push_back(FeatureItem(f, idx));
+            float_feasigns.push_back(FeatureItem(f, idx));
           }
         } else if (all_slots_type_[i][0] == 'u') {  // uint64
           for (int j = 0; j < num; ++j) {
@@ -990,7 +1039,7 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstance(Record* instance) {
             }
             FeatureKey f;
             f.uint64_feasign_ = feasign;
-            instance->uint64_feasigns_.push_back(FeatureItem(f, idx));
+            uint64_feasigns.push_back(FeatureItem(f, idx));
           }
         }
         pos = endptr - str;
@@ -1000,8 +1049,12 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstance(Record* instance) {
         }
       }
     }
-    instance->float_feasigns_.shrink_to_fit();
-    instance->uint64_feasigns_.shrink_to_fit();
+    instance->float_feasigns_.insert(instance->float_feasigns_.end(),
+                                     float_feasigns.begin(),
+                                     float_feasigns.end());
+    instance->uint64_feasigns_.insert(instance->uint64_feasigns_.end(),
+                                      uint64_feasigns.begin(),
+                                      uint64_feasigns.end());
     return true;
   } else {
     return false;
@@ -36,14 +36,18 @@ limitations under the License. */
 #include "paddle/fluid/framework/channel.h"
 #include "paddle/fluid/framework/data_feed.pb.h"
 #include "paddle/fluid/framework/fleet/fleet_wrapper.h"
+#include "paddle/fluid/framework/io/file_prefetcher.h"
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/reader.h"
+#include "paddle/fluid/framework/record_arena.h"
 #include "paddle/fluid/framework/variable.h"
 #include "paddle/fluid/string/string_helper.h"
 
 namespace paddle {
 namespace framework {
 
+class SlotRecordIndex;
+
 // DataFeed is the base virtual class for all ohther DataFeeds.
 // It is used to read files and parse the data for subsequent trainer.
 // Example:
@@ -85,12 +89,19 @@ struct FeatureItem {
   uint16_t slot_;
 };
 
-// sizeof Record is much less than std::vector<MultiSlotType>
+// Feasigns of a Record, the first kInlineFeasignNum of which are stored in
+// the Record itself.
+constexpr size_t kInlineFeasignNum = 3;
+using FeasignVector = ArenaVector<FeatureItem, kInlineFeasignNum>;
+
+// sizeof Record is much less than std::vector<MultiSlotType>. The feasigns
+// and strings of a Record are allocated from RecordArena, and moving a
+// Record never allocates.
 struct Record {
-  std::vector<FeatureItem> uint64_feasigns_;
-  std::vector<FeatureItem> float_feasigns_;
-  std::string ins_id_;
-  std::string content_;
+  FeasignVector uint64_feasigns_;
+  FeasignVector float_feasigns_;
+  InternedString ins_id_;
+  InternedString content_;
   uint64_t search_id;
   uint32_t rank;
   uint32_t cmatch;
@@ -156,6 +167,10 @@ class DataFeed {
   // This function will do nothing at default
   virtual void SetConsumeChannel(void* channel) {}
   // This function will do nothing at default
+  virtual void SetSlotRecordIndex(SlotRecordIndex* index) {}
+  // This function will do nothing at default
+  virtual void SetLockFreeQueueCapacity(int64_t capacity) {}
+  // This function will do nothing at default
   virtual void SetThreadId(int thread_id) {}
   // This function will do nothing at default
   virtual void SetThreadNum(int thread_num) {}
@@ -171,6 +186,11 @@ class DataFeed {
   virtual void SetFeaNumMutex(std::mutex* mutex) { mutex_for_fea_num_ = mutex; }
   virtual void SetFileListIndex(size_t* file_index) { file_idx_ = file_index; }
   virtual void SetFeaNum(uint64_t* fea_num) { total_fea_num_ = fea_num; }
+  // The picked files are read from the prefetcher if it is set, which should
+  // prefetch the same filelist with the same pipe command.
+  virtual void SetFilePrefetcher(FilePrefetcher* prefetcher) {
+    file_prefetcher_ = prefetcher;
+  }
   virtual const std::vector<std::string>& GetInsIdVec() const {
     return ins_id_vec_;
   }
@@ -198,6 +218,9 @@ class DataFeed {
   // This function is used to pick one file from the global filelist(thread
   // safe).
   virtual bool PickOneFile(std::string* filename);
+  // Open the file picked by PickOneFile with pipe_command_.
+  virtual std::shared_ptr<FILE> OpenPickedFile(const std::string& filename,
+                                               int* err_no);
   virtual void CopyToFeedTensor(void* dst, const void* src, size_t size);
 
   std::vector<std::string> filelist_;
@@ -205,6 +228,7 @@ class DataFeed {
   std::mutex* mutex_for_pick_file_;
   std::mutex* mutex_for_fea_num_ = nullptr;
   uint64_t* total_fea_num_ = nullptr;
+  FilePrefetcher* file_prefetcher_ = nullptr;
   uint64_t fea_num_ = 0;
 
   // the alias of used slots, and its order is determined by
@@ -256,6 +280,9 @@ class PrivateQueueDataFeed : public DataFeed {
   virtual ~PrivateQueueDataFeed() {}
   virtual bool Start();
   virtual int Next();
+  // Replace the private-queue with a lock-free channel of the capacity if it
+  // is positive, which should be called before Start().
+  virtual void SetLockFreeQueueCapacity(int64_t capacity);
 
  protected:
   // The thread implementation function for reading file and parse.
@@ -492,7 +519,7 @@ paddle::framework::Archive<AR>& operator>>(paddle::framework::Archive<AR>& ar,
 }
 
 struct RecordCandidate {
-  std::string ins_id_;
+  InternedString ins_id_;
   std::unordered_multimap<uint16_t, FeatureKey> feas_;
   size_t shadow_index_ = -1;  // Optimization for Reservoir Sample
 
@@ -615,6 +642,62 @@ paddle::framework::Archive<AR>& operator>>(paddle::framework::Archive<AR>& ar,
   return ar;
 }
 
+// FeasignVector and InternedString are serialized as std::vector and
+// std::string are.
+template <class AR>
+paddle::framework::Archive<AR>& operator<<(paddle::framework::Archive<AR>& ar,
+                                           const FeasignVector& v) {
+#ifdef _LINUX
+  ar << (size_t)v.size();
+#else
+  ar << (uint64_t)v.size();
+#endif
+  for (const auto& x : v) {
+    ar << x;
+  }
+  return ar;
+}
+
+template <class AR>
+paddle::framework::Archive<AR>& operator>>(paddle::framework::Archive<AR>& ar,
+                                           FeasignVector& v) {
+#ifdef _LINUX
+  v.resize(ar.template Get<size_t>());
+#else
+  v.resize(ar.template Get<uint64_t>());
+#endif
+  for (auto& x : v) {
+    ar >> x;
+  }
+  return ar;
+}
+
+template <class AR>
+paddle::framework::Archive<AR>& operator<<(paddle::framework::Archive<AR>& ar,
+                                           const InternedString& s) {
+#ifdef _LINUX
+  ar << (size_t)s.length();
+#else
+  ar << (uint64_t)s.length();
+#endif
+  ar.Write(s.data(), s.length());
+  return ar;
+}
+
+template <class AR>
+paddle::framework::Archive<AR>& operator>>(paddle::framework::Archive<AR>& ar,
+                                           InternedString& s) {
+#ifdef _LINUX
+  size_t len = ar.template Get<size_t>();
+#else
+  size_t len = ar.template Get<uint64_t>();
+#endif
+  ar.PrepareRead(len);
+  s.assign(ar.Cursor(), len);
+  ar.AdvanceCursor(len);
+  return ar;
+}
+
 template <class AR>
 paddle::framework::Archive<AR>& operator<<(paddle::framework::Archive<AR>& ar,
                                            const Record& r) {
@@ -659,6 +742,10 @@ class MultiSlotInMemoryDataFeed : public InMemoryDataFeed<Record> {
   MultiSlotInMemoryDataFeed() {}
   virtual ~MultiSlotInMemoryDataFeed() {}
   virtual void Init(const DataFeedDesc& data_feed_desc);
+  virtual bool Start();
+  virtual void SetSlotRecordIndex(SlotRecordIndex* index) {
+    slot_record_index_ = index;
+  }
 
  protected:
   virtual bool ParseOneInstance(Record* instance);
@@ -670,6 +757,8 @@ class MultiSlotInMemoryDataFeed : public InMemoryDataFeed<Record> {
   std::vector<std::vector<uint64_t>> batch_uint64_feasigns_;
   std::vector<std::vector<size_t>> offset_;
   std::vector<bool> visit_;
+  // records loaded from slot record files, which are not in input channel
+  SlotRecordIndex* slot_record_index_ = nullptr;
 };
 
 class PaddleBoxDataFeed : public MultiSlotInMemoryDataFeed {
@@ -57,6 +57,7 @@ DatasetImpl<T>::DatasetImpl() {
   parse_logkey_ = false;
   preload_thread_num_ = 0;
   global_index_ = 0;
+  slot_record_index_ = std::make_shared<SlotRecordIndex>();
 }
 
 // set filelist, file_idx_ will reset to zero.
@@ -168,6 +169,22 @@ void DatasetImpl<T>::SetFeaEval(bool fea_eval, int record_candidate_size) {
           << " with record candidate size: " << record_candidate_size;
 }
 
+template <typename T>
+void DatasetImpl<T>::SetUseSlotRecordFile(bool use_slot_record_file) {
+  use_slot_record_file_ = use_slot_record_file;
+}
+
+template <typename T>
+void DatasetImpl<T>::SetFilePrefetchThreadNum(int thread_num) {
+  file_prefetch_thread_num_ = thread_num;
+}
+
+template <typename T>
+void DatasetImpl<T>::SetLockFreeChannelCapacity(int64_t capacity) {
+  CHECK(capacity >= 0) << "capacity of lock-free channel must be >= 0";
+  lock_free_channel_capacity_ = capacity;
+}
+
 template <typename T>
 std::vector<paddle::framework::DataFeed*> DatasetImpl<T>::GetReaders() {
   std::vector<paddle::framework::DataFeed*> ret;
@@ -182,17 +199,22 @@ template <typename T>
 void DatasetImpl<T>::CreateChannel() {
   if (input_channel_ == nullptr) {
     input_channel_ = paddle::framework::MakeChannel<T>();
+    input_channel_->SetStatName("STAT_dataset_input_channel_size");
   }
   if (multi_output_channel_.size() == 0) {
     multi_output_channel_.reserve(channel_num_);
     for (int i = 0; i < channel_num_; ++i) {
       multi_output_channel_.push_back(paddle::framework::MakeChannel<T>());
+      multi_output_channel_.back()->SetStatName(
+          "STAT_dataset_memory_channel_size");
     }
   }
   if (multi_consume_channel_.size() == 0) {
     multi_consume_channel_.reserve(channel_num_);
     for (int i = 0; i < channel_num_; ++i) {
       multi_consume_channel_.push_back(paddle::framework::MakeChannel<T>());
+      multi_consume_channel_.back()->SetStatName(
+          "STAT_dataset_memory_channel_size");
     }
   }
   if (input_pv_channel_ == nullptr) {
@@ -231,6 +253,15 @@ void DatasetImpl<T>::LoadIntoMemory() {
   VLOG(3) << "DatasetImpl<T>::LoadIntoMemory() begin";
   platform::Timer timeline;
   timeline.Start();
+  if (use_slot_record_file_) {
+    LoadSlotRecordFiles();
+    timeline.Pause();
+    VLOG(3) << "DatasetImpl<T>::LoadIntoMemory() end"
+            << ", slot record size=" << slot_record_index_->Size()
+            << ", cost time=" << timeline.ElapsedSec() << " seconds";
+    return;
+  }
+  StartFilePrefetch(readers_);
   std::vector<std::thread> load_threads;
   for (int64_t i = 0; i < thread_num_; ++i) {
     load_threads.push_back(std::thread(
@@ -239,6 +270,7 @@ void DatasetImpl<T>::LoadIntoMemory() {
   for (std::thread& t : load_threads) {
     t.join();
   }
+  StopFilePrefetch(readers_);
   input_channel_->Close();
   int64_t in_chan_size = input_channel_->Size();
   input_channel_->SetBlockSize(in_chan_size / thread_num_ + 1);
@@ -252,8 +284,13 @@ void DatasetImpl<T>::LoadIntoMemory() {
 template <typename T>
 void DatasetImpl<T>::PreLoadIntoMemory() {
   VLOG(3) << "DatasetImpl<T>::PreLoadIntoMemory() begin";
-  if (preload_thread_num_ != 0) {
+  if (use_slot_record_file_) {
+    preload_threads_.clear();
+    preload_threads_.push_back(
+        std::thread(&DatasetImpl<T>::LoadSlotRecordFiles, this));
+  } else if (preload_thread_num_ != 0) {
     CHECK(static_cast<size_t>(preload_thread_num_) == preload_readers_.size());
+    StartFilePrefetch(preload_readers_);
     preload_threads_.clear();
     for (int64_t i = 0; i < preload_thread_num_; ++i) {
       preload_threads_.push_back(
@@ -262,6 +299,7 @@ void DatasetImpl<T>::PreLoadIntoMemory() {
     }
   } else {
     CHECK(static_cast<size_t>(thread_num_) == readers_.size());
+    StartFilePrefetch(readers_);
     preload_threads_.clear();
     for (int64_t i = 0; i < thread_num_; ++i) {
       preload_threads_.push_back(std::thread(
@@ -277,12 +315,79 @@ void DatasetImpl<T>::WaitPreLoadDone() {
   for (std::thread& t : preload_threads_) {
     t.join();
   }
+  StopFilePrefetch(readers_);
+  StopFilePrefetch(preload_readers_);
   input_channel_->Close();
   int64_t in_chan_size = input_channel_->Size();
   input_channel_->SetBlockSize(in_chan_size / thread_num_ + 1);
   VLOG(3) << "DatasetImpl<T>::WaitPreLoadDone() end";
 }
 
+// prefetch the files which have not been picked by the readers
+template <typename T>
+void DatasetImpl<T>::StartFilePrefetch(
+    const std::vector<std::shared_ptr<paddle::framework::DataFeed>>& readers) {
+  if (file_prefetch_thread_num_ <= 0 || file_idx_ >= filelist_.size()) {
+    return;
+  }
+  VLOG(3) << "start prefetching files with " << file_prefetch_thread_num_
+          << " threads";
+  std::vector<std::string> files(filelist_.begin() + file_idx_,
+                                 filelist_.end());
+  file_prefetcher_ = std::make_shared<FilePrefetcher>(
+      files, data_feed_desc_.pipe_command(), file_prefetch_thread_num_);
+  for (auto& reader : readers) {
+    reader->SetFilePrefetcher(file_prefetcher_.get());
+  }
+}
+
+template <typename T>
+void DatasetImpl<T>::StopFilePrefetch(
+    const std::vector<std::shared_ptr<paddle::framework::DataFeed>>& readers) {
+  for (auto& reader : readers) {
+    reader->SetFilePrefetcher(nullptr);
+  }
+  file_prefetcher_ = nullptr;
+}
+
+// map slot record files, the records are not copied into input_channel_
+// until readers start
+template <typename T>
+void DatasetImpl<T>::LoadSlotRecordFiles() {
+  VLOG(3) << "DatasetImpl<T>::LoadSlotRecordFiles() begin";
+  for (auto& filename : filelist_) {
+    auto file = SlotRecordFile::Open(filename);
+    VLOG(3) << "map slot record file " << filename << ", " << file->Size()
+            << " records";
+    slot_record_index_->AddFile(file);
+  }
+  slot_record_index_->SetBlockSize(slot_record_index_->Size() / thread_num_ +
+                                   1);
+  VLOG(3) << "DatasetImpl<T>::LoadSlotRecordFiles() end";
+}
+
+template <typename T>
+void DatasetImpl<T>::SaveIntoSlotRecordFile(const std::string& filename) {
+  VLOG(3) << "DatasetImpl<T>::SaveIntoSlotRecordFile() begin";
+  PADDLE_ENFORCE_NOT_NULL(
+      input_channel_,
+      platform::errors::PreconditionNotMet(
+          "Data should be loaded into memory before saved into file %s.",
+          filename));
+  platform::Timer timeline;
+  timeline.Start();
+  input_channel_->Close();
+  std::vector<T> data;
+  input_channel_->ReadAll(data);
+  WriteSlotRecordFile(filename, data);
+  input_channel_->Open();
+  input_channel_->Write(std::move(data));
+  input_channel_->Close();
+  timeline.Pause();
+  VLOG(3) << "DatasetImpl<T>::SaveIntoSlotRecordFile() end, cost time="
+          << timeline.ElapsedSec() << " seconds";
+}
+
 // release memory data
 template <typename T>
 void DatasetImpl<T>::ReleaseMemory() {
@@ -332,6 +437,8 @@ void DatasetImpl<T>::ReleaseMemory() {
   input_records_.clear();
   std::vector<T>().swap(input_records_);
   std::vector<T>().swap(slots_shuffle_original_data_);
+  slot_record_index_->Clear();
+  RecordArena::Trim();
   VLOG(3) << "DatasetImpl<T>::ReleaseMemory() end";
   VLOG(3) << "total_feasign_num_(" << STAT_GET(STAT_total_feasign_num_in_mem)
           << ") - current_fea_num_(" << total_fea_num_ << ") = ("
@@ -347,11 +454,13 @@ void DatasetImpl<T>::LocalShuffle() {
   platform::Timer timeline;
   timeline.Start();
 
+  auto fleet_ptr = FleetWrapper::GetInstance();
+  // only the references to the records in slot record files are shuffled
+  slot_record_index_->Shuffle(&fleet_ptr->LocalRandomEngine());
   if (!input_channel_ || input_channel_->Size() == 0) {
     VLOG(3) << "DatasetImpl<T>::LocalShuffle() end, no data to shuffle";
     return;
   }
-  auto fleet_ptr = FleetWrapper::GetInstance();
   input_channel_->Close();
   std::vector<T> data;
   input_channel_->ReadAll(data);
@@ -375,10 +484,15 @@ void DatasetImpl<T>::GlobalShuffle(int thread_num) {
   timeline.Start();
   auto fleet_ptr = FleetWrapper::GetInstance();
 
-  if (!input_channel_ || input_channel_->Size() == 0) {
+  if (!input_channel_ ||
+      (input_channel_->Size() == 0 && slot_record_index_->Size() == 0)) {
     VLOG(3) << "DatasetImpl<T>::GlobalShuffle() end, no data to shuffle";
     return;
   }
+  // Records of slot record files are copied out block by block when they
+  // are sent, rather than all at once.
+  slot_record_index_->Shuffle(&fleet_ptr->LocalRandomEngine());
+  slot_record_index_->SetBlockSize(fleet_send_batch_size_);
 
   // local shuffle
   input_channel_->Close();
@@ -407,7 +521,8 @@ void DatasetImpl<T>::GlobalShuffle(int thread_num) {
   auto global_shuffle_func = [this, get_client_id]() {
     auto fleet_ptr = FleetWrapper::GetInstance();
     std::vector<T> data;
-    while (this->input_channel_->Read(data)) {
+    while (this->input_channel_->Read(data) ||
+           this->slot_record_index_->ReadBlock(&data)) {
       std::vector<paddle::framework::BinaryArchive> ars(this->trainer_num_);
       for (auto& t : data) {
         auto client_id = get_client_id(t);
@@ -538,6 +653,10 @@ void DatasetImpl<T>::DynamicAdjustChannelNum(int channel_num,
     input_channel_->SetBlockSize(input_channel_->Size() / channel_num +
                                  (discard_remaining_ins ? 0 : 1));
   }
+  if (static_cast<int>(slot_record_index_->Size()) >= channel_num) {
+    slot_record_index_->SetBlockSize(slot_record_index_->Size() / channel_num +
+                                     (discard_remaining_ins ? 0 : 1));
+  }
   if (static_cast<int>(input_pv_channel_->Size()) >= channel_num) {
     input_pv_channel_->SetBlockSize(input_pv_channel_->Size() / channel_num +
                                     (discard_remaining_ins ? 0 : 1));
@@ -550,6 +669,8 @@ void DatasetImpl<T>::DynamicAdjustChannelNum(int channel_num,
     total_data_channel->Read(local_vec);
     new_other_channels.push_back(paddle::framework::MakeChannel<T>());
     new_channels.push_back(paddle::framework::MakeChannel<T>());
+    new_other_channels[i]->SetStatName("STAT_dataset_memory_channel_size");
+    new_channels[i]->SetStatName("STAT_dataset_memory_channel_size");
     new_channels[i]->Write(std::move(local_vec));
     new_other_pv_channels.push_back(
         paddle::framework::MakeChannel<PvInstance>());
@@ -629,6 +750,7 @@ void DatasetImpl<T>::CreateReaders() {
     readers_[i]->SetFeaNumMutex(&mutex_for_fea_num_);
     readers_[i]->SetFeaNum(&total_fea_num_);
     readers_[i]->SetFileList(filelist_);
+    readers_[i]->SetLockFreeQueueCapacity(lock_free_channel_capacity_);
     readers_[i]->SetParseInsId(parse_ins_id_);
     readers_[i]->SetParseContent(parse_content_);
     readers_[i]->SetParseLogKey(parse_logkey_);
@@ -637,6 +759,7 @@ void DatasetImpl<T>::CreateReaders() {
     // In fact, it does not affect the train process when paddle is
     // complied with Box_Ps.
     readers_[i]->SetCurrentPhase(current_phase_);
+    readers_[i]->SetSlotRecordIndex(slot_record_index_.get());
     if (input_channel_ != nullptr) {
       readers_[i]->SetInputChannel(input_channel_.get());
     }
@@ -724,7 +847,7 @@ void DatasetImpl<T>::DestroyPreLoadReaders() {
 
 template <typename T>
 int64_t DatasetImpl<T>::GetMemoryDataSize() {
-  return input_channel_->Size();
+  return input_channel_->Size() + slot_record_index_->Size();
 }
 
 template <typename T>
@@ -26,6 +26,7 @@
 #include <vector>
 
 #include "paddle/fluid/framework/data_feed.h"
+#include "paddle/fluid/framework/slot_record_file.h"
 
 namespace paddle {
 namespace framework {
@@ -74,6 +75,16 @@ class Dataset {
   virtual void SetGenerateUniqueFeasign(bool gen_uni_feasigns) = 0;
   // set fea eval mode
   virtual void SetFeaEval(bool fea_eval, int record_candidate_size) = 0;
+  // load the filelist as slot record files rather than text files
+  virtual void SetUseSlotRecordFile(bool use_slot_record_file) = 0;
+  // set the num of threads prefetching files when loading into memory,
+  // 0 means no prefetching
+  virtual void SetFilePrefetchThreadNum(int thread_num) = 0;
+  // create the queues from the reading threads of the readers to the trainer
+  // with the lock-free backend of the capacity, 0 means the queues guarded
+  // by a mutex. The channels holding the instances in memory are unbounded,
+  // and always guarded by a mutex.
+  virtual void SetLockFreeChannelCapacity(int64_t capacity) = 0;
   // get file list
   virtual const std::vector<std::string>& GetFileList() = 0;
   // get thread num
@@ -105,6 +116,9 @@ class Dataset {
   virtual void WaitPreLoadDone() = 0;
   // release all memory data
   virtual void ReleaseMemory() = 0;
+  // save memory data into a slot record file, which can be loaded later
+  // without parsing
+  virtual void SaveIntoSlotRecordFile(const std::string& filename) = 0;
   // local shuffle data
   virtual void LocalShuffle() = 0;
   // global shuffle data
@@ -177,6 +191,9 @@ class DatasetImpl : public Dataset {
   virtual void SetMergeByInsId(int merge_size);
   virtual void SetGenerateUniqueFeasign(bool gen_uni_feasigns);
   virtual void SetFeaEval(bool fea_eval, int record_candidate_size);
+  virtual void SetUseSlotRecordFile(bool use_slot_record_file);
+  virtual void SetFilePrefetchThreadNum(int thread_num);
+  virtual void SetLockFreeChannelCapacity(int64_t capacity);
   virtual const std::vector<std::string>& GetFileList() { return filelist_; }
   virtual int GetThreadNum() { return thread_num_; }
   virtual int GetTrainerNum() { return trainer_num_; }
@@ -201,6 +218,7 @@ class DatasetImpl : public Dataset {
   virtual void PreLoadIntoMemory();
   virtual void WaitPreLoadDone();
   virtual void ReleaseMemory();
+  virtual void SaveIntoSlotRecordFile(const std::string& filename);
   virtual void LocalShuffle();
   virtual void GlobalShuffle(int thread_num = -1);
   virtual void SlotsShuffle(const std::set<std::string>& slots_to_replace) {}
@@ -232,6 +250,11 @@ class DatasetImpl : public Dataset {
  protected:
   virtual int ReceiveFromClient(int msg_type, int client_id,
                                 const std::string& msg);
+  virtual void LoadSlotRecordFiles();
+  virtual void StartFilePrefetch(
+      const std::vector<std::shared_ptr<paddle::framework::DataFeed>>& readers);
+  virtual void StopFilePrefetch(
+      const std::vector<std::shared_ptr<paddle::framework::DataFeed>>& readers);
   std::vector<std::shared_ptr<paddle::framework::DataFeed>> readers_;
   std::vector<std::shared_ptr<paddle::framework::DataFeed>> preload_readers_;
   paddle::framework::Channel<T> input_channel_;
@@ -278,6 +301,12 @@ class DatasetImpl : public Dataset {
   int64_t global_index_ = 0;
   std::vector<std::shared_ptr<ThreadPool>> consume_task_pool_;
   std::vector<T> input_records_;  // only for paddleboxdatafeed
+  bool use_slot_record_file_ = false;
+  // records of the mapped slot record files, which are not in input_channel_
+  std::shared_ptr<SlotRecordIndex> slot_record_index_;
+  int file_prefetch_thread_num_ = 0;
+  std::shared_ptr<FilePrefetcher> file_prefetcher_;
+  int64_t lock_free_channel_capacity_ = 0;
 };
 
 // use std::vector<MultiSlotType> or Record as data type
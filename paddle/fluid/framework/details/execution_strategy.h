@@ -37,6 +37,9 @@ struct ExecutionStrategy {
   // This debug option.
   bool dry_run_{false};
   bool thread_barrier_{false};
+  // Only used by the kExperimental executor. If true, ops are scheduled in
+  // a WorkStealingThreadPool instead of a thread pool with a single queue.
+  bool use_work_stealing_pool_{false};
 
   // only use with async_ssa_graph_executor
   // and pyreader with data queue
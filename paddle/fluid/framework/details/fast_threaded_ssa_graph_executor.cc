@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 #include "paddle/fluid/framework/details/fast_threaded_ssa_graph_executor.h"
+#include <algorithm>
 #include <deque>
 #include <memory>
 #include <string>
@@ -37,9 +38,14 @@ FastThreadedSSAGraphExecutor::FastThreadedSSAGraphExecutor(
       places_(places),
       graph_(graph),
       fetch_ctxs_(places),
-      pool_(strategy.num_threads_),
       // add one more thread for generate op_deps
       prepare_pool_(1) {
+  if (strategy.use_work_stealing_pool_) {
+    work_stealing_pool_.reset(
+        new WorkStealingThreadPool(std::max<size_t>(strategy.num_threads_, 1)));
+  } else {
+    pool_.reset(new ::ThreadPool(strategy.num_threads_));
+  }
   for (auto &op : ir::FilterByNodeWrapper<OpHandleBase>(*graph_)) {
     int dep = static_cast<int>(op->NotReadyInputSize());
     op_deps_.emplace(op, dep);
@@ -204,7 +210,7 @@ void FastThreadedSSAGraphExecutor::RunOpAsync(
     OpHandleBase *op,
     const std::shared_ptr<BlockingQueue<size_t>> &complete_q) {
   ++remaining_;
-  this->pool_.enqueue([=] {
+  auto task = [=] {
     std::deque<OpHandleBase *> op_queue;
     op_queue.push_front(op);
 
@@ -244,7 +250,14 @@ void FastThreadedSSAGraphExecutor::RunOpAsync(
     }
     --remaining_;
     complete_q->Push(complete);
-  });
+  };
+
+  if (work_stealing_pool_) {
+    // The exceptions are caught by RunOp, no future is needed.
+    work_stealing_pool_->RunAndForget(std::move(task));
+  } else {
+    this->pool_->enqueue(std::move(task));
+  }
 }
 
 void FastThreadedSSAGraphExecutor::PrepareAtomicOpDeps() {
@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include "paddle/fluid/framework/executor.h"
+#include <chrono>  // NOLINT
 #include <deque>
 #include <memory>
 #include <unordered_map>
@@ -35,10 +36,14 @@ limitations under the License. */
 #include "paddle/fluid/operators/controlflow/recurrent_op_helper.h"
 #include "paddle/fluid/operators/controlflow/while_op_helper.h"
 #include "paddle/fluid/operators/distributed/distributed.h"
+#include "paddle/fluid/platform/monitor.h"
 #include "paddle/fluid/platform/place.h"
 #include "paddle/fluid/platform/profiler.h"
 
 DECLARE_bool(benchmark);
+
+USE_INT_STAT(STAT_executor_op_count);
+USE_HISTOGRAM_STAT(STAT_executor_run_us);
 DEFINE_bool(use_mkldnn, false, "Use MKLDNN to run");
 
 namespace paddle {
@@ -435,6 +440,7 @@ void Executor::RunPartialPreparedContext(ExecutorPrepareContext* ctx,
                                          bool create_local_scope,
                                          bool create_vars, bool keep_kids) {
   platform::RecordBlock b(kProgramId);
+  auto start = std::chrono::steady_clock::now();
   PADDLE_ENFORCE_NOT_NULL(
       scope, platform::errors::InvalidArgument("Scope shouldn't be null"));
   Scope* local_scope = scope;
@@ -475,6 +481,11 @@ void Executor::RunPartialPreparedContext(ExecutorPrepareContext* ctx,
   }
 
   platform::DeviceContextPool::Instance().Get(place_)->Wait();
+  STAT_ADD(STAT_executor_op_count, end_op_index - start_op_index);
+  STAT_OBSERVE(STAT_executor_run_us,
+               std::chrono::duration_cast<std::chrono::microseconds>(
+                   std::chrono::steady_clock::now() - start)
+                   .count());
 
   if (local_scope != scope) {
     scope->DeleteScope(local_scope);
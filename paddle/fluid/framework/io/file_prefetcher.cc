@@ -0,0 +1,298 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#if defined _WIN32 || defined __APPLE__
+#else
+#define _LINUX
+#endif
+
+#include "paddle/fluid/framework/io/file_prefetcher.h"
+#include <string.h>
+#include <algorithm>
+#include <exception>
+#include <utility>
+#include "glog/logging.h"
+#include "paddle/fluid/framework/io/fs.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace framework {
+
+// Reusable chunk buffers of a FilePrefetcher.
+class PrefetchBufferPool {
+ public:
+  explicit PrefetchBufferPool(size_t chunk_size) : chunk_size_(chunk_size) {}
+
+  std::unique_ptr<char[]> Acquire() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!buffers_.empty()) {
+        auto buffer = std::move(buffers_.back());
+        buffers_.pop_back();
+        return buffer;
+      }
+    }
+    return std::unique_ptr<char[]>(new char[chunk_size_]);
+  }
+
+  void Release(std::unique_ptr<char[]> buffer) {
+    if (buffer == nullptr) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffers_.push_back(std::move(buffer));
+  }
+
+  size_t ChunkSize() const { return chunk_size_; }
+
+ private:
+  size_t chunk_size_;
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<char[]>> buffers_;
+};
+
+// The prefetched chunks of one file. A prefetch thread pushes chunks into
+// it, and the FILE* returned by FilePrefetcher::Open reads from it.
+class PrefetchStream {
+ public:
+  PrefetchStream(const std::shared_ptr<PrefetchBufferPool>& pool,
+                 size_t max_chunk_num)
+      : pool_(pool), max_chunk_num_(max_chunk_num) {}
+
+  // Blocks when the stream is full. Returns false if the stream has been
+  // closed, and then the rest of the file should not be read.
+  bool Push(std::unique_ptr<char[]> data, size_t size) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock,
+               [this] { return closed_ || chunks_.size() < max_chunk_num_; });
+    if (closed_) {
+      pool_->Release(std::move(data));
+      return false;
+    }
+    chunks_.push_back(Chunk{std::move(data), size});
+    cond_.notify_all();
+    return true;
+  }
+
+  void Finish(const std::string& error) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    finished_ = true;
+    error_ = error;
+    cond_.notify_all();
+  }
+
+  // Stop prefetching. The chunks already prefetched can still be read.
+  void Cancel() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    finished_ = true;
+    cond_.notify_all();
+  }
+
+  ssize_t Read(char* buf, size_t size) {
+    size_t copied = 0;
+    while (copied < size) {
+      if (pos_ == current_.size) {
+        pool_->Release(std::move(current_.data));
+        current_.size = 0;
+        pos_ = 0;
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (copied == 0) {
+          cond_.wait(lock, [this] { return !chunks_.empty() || finished_; });
+        }
+        if (chunks_.empty()) {
+          if (copied == 0 && !error_.empty()) {
+            LOG(FATAL) << "Prefetch file failed: " << error_;
+          }
+          break;
+        }
+        current_ = std::move(chunks_.front());
+        chunks_.pop_front();
+        cond_.notify_all();
+      }
+      size_t n = std::min(size - copied, current_.size - pos_);
+      memcpy(buf + copied, current_.data.get() + pos_, n);
+      pos_ += n;
+      copied += n;
+    }
+    return static_cast<ssize_t>(copied);
+  }
+
+  void Close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    for (auto& chunk : chunks_) {
+      pool_->Release(std::move(chunk.data));
+    }
+    chunks_.clear();
+    pool_->Release(std::move(current_.data));
+    current_.size = 0;
+    pos_ = 0;
+    cond_.notify_all();
+  }
+
+ private:
+  struct Chunk {
+    std::unique_ptr<char[]> data;
+    size_t size;
+  };
+
+  std::shared_ptr<PrefetchBufferPool> pool_;
+  size_t max_chunk_num_;
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::deque<Chunk> chunks_;
+  bool finished_{false};
+  bool closed_{false};
+  std::string error_;
+  // only accessed by the consumer
+  Chunk current_{nullptr, 0};
+  size_t pos_{0};
+};
+
+#ifdef _LINUX
+static ssize_t PrefetchStreamRead(void* cookie, char* buf, size_t size) {
+  return static_cast<PrefetchStream*>(cookie)->Read(buf, size);
+}
+
+static int PrefetchStreamClose(void* cookie) {
+  static_cast<PrefetchStream*>(cookie)->Close();
+  return 0;
+}
+#endif
+
+FilePrefetcher::FilePrefetcher(const std::vector<std::string>& files,
+                               const std::string& converter, int thread_num,
+                               size_t chunk_size, int chunk_num)
+    : files_(files),
+      converter_(converter),
+      chunk_size_(chunk_size),
+      chunk_num_(chunk_num),
+      thread_num_(thread_num) {
+  PADDLE_ENFORCE_GT(thread_num, 0,
+                    platform::errors::InvalidArgument(
+                        "Thread num of FilePrefetcher should be > 0."));
+  PADDLE_ENFORCE_GT(chunk_size, 0,
+                    platform::errors::InvalidArgument(
+                        "Chunk size of FilePrefetcher should be > 0."));
+  PADDLE_ENFORCE_GT(chunk_num, 0,
+                    platform::errors::InvalidArgument(
+                        "Chunk num of FilePrefetcher should be > 0."));
+#ifdef _LINUX
+  pool_ = std::make_shared<PrefetchBufferPool>(chunk_size_);
+  for (size_t i = 0; i < files_.size(); ++i) {
+    streams_.emplace_back(std::make_shared<PrefetchStream>(pool_, chunk_num_));
+    unopened_[files_[i]].push_back(i);
+  }
+  for (int i = 0; i < thread_num_; ++i) {
+    threads_.emplace_back(&FilePrefetcher::PrefetchThread, this);
+  }
+#endif
+}
+
+FilePrefetcher::~FilePrefetcher() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+    cond_.notify_all();
+  }
+  for (auto& stream : streams_) {
+    stream->Cancel();
+  }
+  for (auto& th : threads_) {
+    th.join();
+  }
+}
+
+void FilePrefetcher::PrefetchThread() {
+  while (true) {
+    size_t idx = 0;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond_.wait(lock, [this] {
+        return stop_ || next_file_ >= files_.size() ||
+               next_file_ < opened_num_ + thread_num_;
+      });
+      if (stop_ || next_file_ >= files_.size()) {
+        return;
+      }
+      idx = next_file_++;
+    }
+
+    auto& stream = streams_[idx];
+    std::string error;
+    try {
+      int err_no = 0;
+      {
+        std::shared_ptr<FILE> fp = fs_open_read(files_[idx], &err_no,
+                                                converter_);
+        while (true) {
+          auto buffer = pool_->Acquire();
+          size_t n = fread(buffer.get(), 1, chunk_size_, fp.get());
+          if (n == 0) {
+            pool_->Release(std::move(buffer));
+            break;
+          }
+          if (!stream->Push(std::move(buffer), n) || n < chunk_size_) {
+            break;
+          }
+        }
+      }
+      // err_no is set when the pipe is closed
+      if (err_no != 0) {
+        LOG(WARNING) << "prefetch " << files_[idx] << " with error "
+                     << err_no;
+      }
+    } catch (std::exception& e) {
+      error = e.what();
+    }
+    VLOG(3) << "prefetch " << files_[idx] << " done";
+    stream->Finish(error);
+  }
+}
+
+std::shared_ptr<FILE> FilePrefetcher::Open(const std::string& path,
+                                           int* err_no) {
+#ifdef _LINUX
+  std::shared_ptr<PrefetchStream> stream;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = unopened_.find(path);
+    if (it != unopened_.end() && !it->second.empty()) {
+      stream = streams_[it->second.front()];
+      it->second.pop_front();
+      ++opened_num_;
+      cond_.notify_all();
+    }
+  }
+  if (stream != nullptr) {
+    cookie_io_functions_t funcs;
+    memset(&funcs, 0, sizeof(funcs));
+    funcs.read = PrefetchStreamRead;
+    funcs.close = PrefetchStreamClose;
+    FILE* fp = fopencookie(stream.get(), "r", funcs);
+    PADDLE_ENFORCE_NOT_NULL(
+        fp, platform::errors::Unavailable(
+                "Failed to open prefetched file %s, %s.", path,
+                strerror(errno)));
+    // the stream is kept alive until the FILE is closed
+    return std::shared_ptr<FILE>(fp, [stream](FILE* fp) { fclose(fp); });
+  }
+#endif
+  VLOG(3) << path << " is not prefetched";
+  return fs_open_read(path, err_no, converter_);
+}
+
+}  // namespace framework
+}  // namespace paddle
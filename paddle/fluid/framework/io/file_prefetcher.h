@@ -0,0 +1,83 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdio.h>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+namespace paddle {
+namespace framework {
+
+class PrefetchStream;
+class PrefetchBufferPool;
+
+// FilePrefetcher reads the files of a filelist ahead of their consumers.
+//
+// Background threads open the files in the order of the filelist by
+// fs_open_read, so local files, hdfs files and converters are all supported,
+// and read them in large chunks into reusable buffers. At most thread_num
+// files are prefetched before they are opened, and at most chunk_num chunks
+// of each file are buffered.
+//
+// Open() returns a FILE* reading from the prefetched chunks, so consumers
+// such as the readers of DataFeed, which pick files from the same filelist
+// in order, need not wait on the disk or the pipe.
+class FilePrefetcher {
+ public:
+  FilePrefetcher(const std::vector<std::string>& files,
+                 const std::string& converter, int thread_num,
+                 size_t chunk_size = 4 << 20, int chunk_num = 4);
+  ~FilePrefetcher();
+
+  // Open a file of the filelist, thread safe. Files not in the filelist, or
+  // opened more times than they appear in it, are opened by fs_open_read.
+  std::shared_ptr<FILE> Open(const std::string& path, int* err_no);
+
+ private:
+  FilePrefetcher(const FilePrefetcher&) = delete;
+  FilePrefetcher& operator=(const FilePrefetcher&) = delete;
+
+  void PrefetchThread();
+
+  std::vector<std::string> files_;
+  std::string converter_;
+  size_t chunk_size_;
+  int chunk_num_;
+  int thread_num_;
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  bool stop_{false};
+  // files_[0, next_file_) have been started by the prefetch threads
+  size_t next_file_{0};
+  size_t opened_num_{0};
+  std::vector<std::shared_ptr<PrefetchStream>> streams_;
+  // indexes of the files which have not been opened
+  std::unordered_map<std::string, std::deque<size_t>> unopened_;
+  // buffers are shared with the streams, which may outlive the prefetcher
+  std::shared_ptr<PrefetchBufferPool> pool_;
+
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,159 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Local disk read benchmark of fs_open_read and FilePrefetcher. Reader
+// threads pick files from a shared filelist and read them line by line,
+// which is how DataFeed::LoadIntoMemory reads the files of a dataset.
+//
+// Usage:
+//   ./file_prefetcher_benchmark --dir=/ssd/bench --file_num=32 --file_mb=64
+//       --readers=8 --prefetch_threads=4
+// Drop the page cache between runs to measure the disk rather than memory.
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/io/file_prefetcher.h"
+#include "paddle/fluid/framework/io/fs.h"
+#include "paddle/fluid/string/string_helper.h"
+
+DEFINE_string(dir, "./file_prefetcher_benchmark_data",
+              "Directory of the files to be read.");
+DEFINE_int32(file_num, 16, "Number of files.");
+DEFINE_int32(file_mb, 64, "Size (MB) of each file.");
+DEFINE_int32(readers, 4, "Number of reader threads.");
+DEFINE_int32(prefetch_threads, 4, "Number of prefetch threads.");
+DEFINE_int32(chunk_mb, 4, "Chunk size (MB) of the prefetcher.");
+DEFINE_string(converter, "", "Pipe command the files are read through.");
+DEFINE_bool(generate, true, "Generate the files if they do not exist.");
+
+namespace paddle {
+namespace framework {
+
+static std::vector<std::string> PrepareFiles() {
+  mkdir(FLAGS_dir.c_str(), 0755);
+  std::vector<std::string> files;
+  // lines like a slot record text: "1 123456789 1 234567890 ..."
+  std::string line;
+  for (int i = 0; i < 40; ++i) {
+    line += "1 " + std::to_string(1000000007ULL * (i + 1)) + " ";
+  }
+  line += "\n";
+  for (int i = 0; i < FLAGS_file_num; ++i) {
+    std::string name = FLAGS_dir + "/part-" + std::to_string(i);
+    files.push_back(name);
+    struct stat st;
+    if (!FLAGS_generate ||
+        (stat(name.c_str(), &st) == 0 &&
+         st.st_size >= static_cast<int64_t>(FLAGS_file_mb) << 20)) {
+      continue;
+    }
+    FILE* fp = fopen(name.c_str(), "w");
+    CHECK(fp != nullptr) << "failed to create " << name;
+    for (size_t size = 0; size < (static_cast<size_t>(FLAGS_file_mb) << 20);
+         size += line.size()) {
+      fwrite(line.data(), 1, line.size(), fp);
+    }
+    fclose(fp);
+  }
+  return files;
+}
+
+template <typename OpenFunc>
+static double ReadFiles(const std::vector<std::string>& files,
+                        OpenFunc open_func, size_t* total_bytes) {
+  std::mutex mutex;
+  size_t file_idx = 0;
+  std::vector<size_t> bytes(FLAGS_readers, 0);
+  std::vector<std::thread> readers;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < FLAGS_readers; ++i) {
+    readers.emplace_back([&, i] {
+      string::LineFileReader reader;
+      while (true) {
+        std::string name;
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          if (file_idx == files.size()) {
+            return;
+          }
+          name = files[file_idx++];
+        }
+        std::shared_ptr<FILE> fp = open_func(name);
+        while (reader.getline(fp.get())) {
+          bytes[i] += reader.length() + 1;
+        }
+      }
+    });
+  }
+  for (auto& th : readers) {
+    th.join();
+  }
+  auto end = std::chrono::steady_clock::now();
+  *total_bytes = 0;
+  for (size_t b : bytes) {
+    *total_bytes += b;
+  }
+  return std::chrono::duration<double>(end - start).count();
+}
+
+static void Report(const std::string& name, double seconds, size_t bytes) {
+  std::cout << name << "\t" << seconds << "\t"
+            << bytes / seconds / (1 << 30) << std::endl;
+}
+
+}  // namespace framework
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  using paddle::framework::FilePrefetcher;
+
+  auto files = paddle::framework::PrepareFiles();
+  size_t bytes = 0;
+  std::cout << "reader\tseconds\tGB/s" << std::endl;
+  double seconds = paddle::framework::ReadFiles(
+      files,
+      [](const std::string& name) {
+        int err_no = 0;
+        return paddle::framework::fs_open_read(name, &err_no,
+                                               FLAGS_converter);
+      },
+      &bytes);
+  paddle::framework::Report("fs_open_read", seconds, bytes);
+
+  {
+    FilePrefetcher prefetcher(files, FLAGS_converter, FLAGS_prefetch_threads,
+                              static_cast<size_t>(FLAGS_chunk_mb) << 20);
+    seconds = paddle::framework::ReadFiles(
+        files,
+        [&](const std::string& name) {
+          int err_no = 0;
+          return prefetcher.Open(name, &err_no);
+        },
+        &bytes);
+  }
+  paddle::framework::Report("FilePrefetcher", seconds, bytes);
+  return 0;
+}
@@ -0,0 +1,139 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <fstream>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+#include "paddle/fluid/framework/io/file_prefetcher.h"
+#include "paddle/fluid/string/string_helper.h"
+
+#if defined _WIN32 || defined __APPLE__
+#else
+#define _LINUX
+#endif
+
+namespace paddle {
+namespace framework {
+
+static std::vector<std::string> CreateFiles(int file_num, int line_num) {
+  std::vector<std::string> files;
+  for (int i = 0; i < file_num; ++i) {
+    std::string name = "prefetch_test_" + std::to_string(i) + ".txt";
+    std::ofstream out(name);
+    for (int j = 0; j < line_num; ++j) {
+      out << i << " " << j << "\n";
+    }
+    out.close();
+    files.push_back(name);
+  }
+  return files;
+}
+
+static std::vector<std::string> ReadLines(const std::shared_ptr<FILE>& fp) {
+  std::vector<std::string> lines;
+  string::LineFileReader reader;
+  while (reader.getline(fp.get())) {
+    lines.push_back(reader.get());
+  }
+  return lines;
+}
+
+TEST(FilePrefetcher, read_in_parallel) {
+#ifdef _LINUX
+  const int kFileNum = 10;
+  const int kLineNum = 1000;
+  auto files = CreateFiles(kFileNum, kLineNum);
+  // a small chunk size, so that lines are split among chunks
+  FilePrefetcher prefetcher(files, "", 2, 7, 2);
+
+  std::mutex mutex;
+  size_t file_idx = 0;
+  std::atomic<int> file_done{0};
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 3; ++i) {
+    readers.emplace_back([&] {
+      while (true) {
+        std::string name;
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          if (file_idx == files.size()) {
+            return;
+          }
+          name = files[file_idx++];
+        }
+        int err_no = 0;
+        auto lines = ReadLines(prefetcher.Open(name, &err_no));
+        ASSERT_EQ(lines.size(), static_cast<size_t>(kLineNum));
+        std::string prefix = name.substr(name.rfind('_') + 1);
+        prefix = prefix.substr(0, prefix.find('.')) + " ";
+        for (int j = 0; j < kLineNum; ++j) {
+          EXPECT_EQ(lines[j], prefix + std::to_string(j));
+        }
+        ++file_done;
+      }
+    });
+  }
+  for (auto& th : readers) {
+    th.join();
+  }
+  EXPECT_EQ(file_done, kFileNum);
+  for (auto& name : files) {
+    remove(name.c_str());
+  }
+#endif
+}
+
+TEST(FilePrefetcher, close_early) {
+#ifdef _LINUX
+  auto files = CreateFiles(4, 10000);
+  {
+    FilePrefetcher prefetcher(files, "", 1, 64, 2);
+    int err_no = 0;
+    {
+      auto fp = prefetcher.Open(files[0], &err_no);
+      string::LineFileReader reader;
+      ASSERT_NE(reader.getline(fp.get()), nullptr);
+      EXPECT_EQ(std::string(reader.get()), "0 0");
+    }
+    // opened twice, so it is read by fs_open_read directly
+    EXPECT_EQ(ReadLines(prefetcher.Open(files[0], &err_no)).size(), 10000UL);
+    EXPECT_EQ(ReadLines(prefetcher.Open(files[1], &err_no)).size(), 10000UL);
+    // files[2] and files[3] are never opened
+  }
+  for (auto& name : files) {
+    remove(name.c_str());
+  }
+#endif
+}
+
+TEST(FilePrefetcher, converter) {
+#ifdef _LINUX
+  auto files = CreateFiles(2, 100);
+  FilePrefetcher prefetcher(files, "head -n 10", 2);
+  for (auto& name : files) {
+    int err_no = 0;
+    EXPECT_EQ(ReadLines(prefetcher.Open(name, &err_no)).size(), 10UL);
+  }
+  for (auto& name : files) {
+    remove(name.c_str());
+  }
+#endif
+}
+
+}  // namespace framework
+}  // namespace paddle
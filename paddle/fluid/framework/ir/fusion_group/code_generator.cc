@@ -16,6 +16,7 @@ limitations under the License. */
 #include <sstream>
 #include <unordered_set>
 #include "paddle/fluid/framework/ir/fusion_group/code_generator_helper.h"
+#include "paddle/fluid/framework/ir/fusion_group/cpu_resources.h"
 #include "paddle/fluid/framework/ir/fusion_group/cuda_resources.h"
 #include "paddle/fluid/framework/ir/fusion_group/operation.h"
 
@@ -45,11 +46,12 @@ std::string ExtractDataType(const std::vector<Node*>& nodes) {
   return dtype_str;
 }
 
-CodeGenerator::CodeGenerator() {
+CodeGenerator::CodeGenerator(bool use_gpu) : use_gpu_(use_gpu) {
   // Only support elementwise operations now.
   code_templates_.resize(1);
 
-  CodeTemplate elementwise_t(cuda_kernel_template_1d);
+  CodeTemplate elementwise_t(use_gpu ? cuda_kernel_template_1d
+                                     : cpu_kernel_template_1d);
   code_templates_[0] = elementwise_t;
 }
 
@@ -158,6 +160,10 @@ std::string CodeGenerator::Generate(
                    EmitComputeBody(expressions, input_ids, output_ids,
                                    intermediate_ids, dtypes));
 
+  if (!use_gpu_) {
+    return predefined_cpu_functions + code_templates_[0].Format(template_var);
+  }
+
   std::set<std::string> all_dtype;
   for (const auto& type : dtypes) {
     all_dtype.insert(type.second);
@@ -254,6 +260,27 @@ std::string CodeGenerator::EmitParameters(
     const std::set<int>& intermediate_ids,
     const std::unordered_map<int, std::string>& dtypes) const {
   std::stringstream ret;
+  if (!use_gpu_) {
+    // The arguments are unpacked from args, in the same order as those of
+    // the CUDA kernels.
+    size_t index = 1;
+    for (auto id : input_ids) {
+      if (output_ids.find(id) == output_ids.end()) {
+        ret << "const " << dtypes.at(id) << "* " << ArgName(id)
+            << " = *static_cast<const " << dtypes.at(id)
+            << "* const*>(args[" << index++ << "]);";
+      }
+    }
+    for (auto id : output_ids) {
+      if (intermediate_ids.find(id) == intermediate_ids.end()) {
+        ret << dtypes.at(id) << "* " << ArgName(id) << " = *static_cast<"
+            << dtypes.at(id) << "* const*>(args["
+            << index++ << "]);";
+      }
+    }
+    return ret.str();
+  }
+
   ret << "int N, ";
 
   // If a id is in the input and output list at the same time, then remove it
@@ -300,9 +327,14 @@ std::string CodeGenerator::EmitComputeBody(
   for (auto id : input_ids) {
     if (output_ids.find(id) == output_ids.end() &&
         used.find(id) != used.end()) {
-      load << dtypes.at(id) << " " << TmpName(id) << " = "
-           << "__ldg(&" << VarName(id) << ")"
-           << ";";
+      if (use_gpu_) {
+        load << dtypes.at(id) << " " << TmpName(id) << " = "
+             << "__ldg(&" << VarName(id) << ")"
+             << ";";
+      } else {
+        load << dtypes.at(id) << " " << TmpName(id) << " = " << VarName(id)
+             << ";";
+      }
     }
   }
   // Store temporal variables to memory.
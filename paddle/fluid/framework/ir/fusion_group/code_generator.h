@@ -29,7 +29,9 @@ namespace fusion_group {
 
 class CodeGenerator {
  public:
-  CodeGenerator();
+  // Generate CUDA kernels if use_gpu is true, otherwise C++ functions for
+  // CPU, which are compiled by CUDADeviceCode and CPUDeviceCode respectively.
+  explicit CodeGenerator(bool use_gpu = true);
 
   std::string Generate(std::string func_name,
                        const std::vector<OperationExpression>& expressions);
@@ -64,6 +66,7 @@ class CodeGenerator {
   std::unordered_map<std::string, int> EncodeVarNodes(SubGraph* subgraph);
 
  private:
+  bool use_gpu_;
   std::vector<CodeTemplate> code_templates_;
 };
 
@@ -170,6 +170,9 @@ std::string OperationExpression::GetRHS(std::unordered_set<int>* used,
       std::string number_str = rhs.substr(pos + 2, length);
       if (rhs_type_ == "__half")
         number_str = "__float2half(" + number_str + ")";
+      else if (rhs_type_ == "float")
+        // keep the computation of float in single precision
+        number_str = "static_cast<float>(" + number_str + ")";
       rhs.replace(pos, length + 3, number_str);
       pos = pos + number_str.length();
     }
@@ -16,6 +16,7 @@ limitations under the License. */
 #include <gtest/gtest.h>
 #include <cmath>
 #include <string>
+#include <utility>
 #include <vector>
 #include "paddle/fluid/framework/ir/fusion_group/operation.h"
 #include "paddle/fluid/framework/ir/pass_tester_helper.h"
@@ -25,8 +26,6 @@ limitations under the License. */
 #include "paddle/fluid/platform/float16.h"
 #include "paddle/fluid/platform/init.h"
 
-#ifdef PADDLE_WITH_CUDA
-
 namespace paddle {
 namespace framework {
 namespace ir {
@@ -169,6 +168,46 @@ void SetupRandomCPUTensor(LoDTensor* tensor) {
 
 namespace fusion_group = paddle::framework::ir::fusion_group;
 
+// The places and the data types tested for them, where float16 is only
+// supported on GPU.
+std::vector<std::pair<bool, std::string>> TestedConfigs() {
+  std::vector<std::pair<bool, std::string>> configs = {{false, "float"}};
+#ifdef PADDLE_WITH_CUDA
+  configs.emplace_back(true, "float");
+  configs.emplace_back(true, "__half");
+#endif
+  return configs;
+}
+
+void TestMainImplCPU(std::string func_name, std::string code_str,
+                     std::vector<paddle::framework::LoDTensor> cpu_tensors,
+                     int n, std::vector<int> input_ids,
+                     std::vector<int> output_ids) {
+  paddle::platform::CPUPlace place;
+  paddle::platform::CPUDeviceCode device_code(place, func_name, code_str);
+  EXPECT_EQ(device_code.Compile(), true);
+
+  std::vector<float*> cpu_ptrs(cpu_tensors.size());
+  std::vector<void*> args;
+  args.push_back(&n);
+
+  for (auto id : input_ids) {
+    if (id >= 0) {
+      fusion_group::SetupRandomCPUTensor<float>(&cpu_tensors[id]);
+      cpu_ptrs[id] = cpu_tensors[id].data<float>();
+      args.push_back(&cpu_ptrs[id]);
+    }
+  }
+
+  for (auto id : output_ids) {
+    cpu_ptrs[id] = cpu_tensors[id].mutable_data<float>(place);
+    args.push_back(&cpu_ptrs[id]);
+  }
+
+  device_code.Launch(n, &args);
+}
+
+#ifdef PADDLE_WITH_CUDA
 template <typename T>
 void TestMainImpl(std::string func_name, std::string code_str,
                   std::vector<paddle::framework::LoDTensor> cpu_tensors, int n,
@@ -242,12 +281,13 @@ void TestMainImpl(std::string func_name, std::string code_str,
     }
   }
 }
+#endif
 
 void TestElementwiseMain(
     std::string func_name, std::string code_str,
     std::vector<fusion_group::OperationExpression> expressions,
     std::vector<int> input_ids, std::vector<int> output_ids,
-    std::string dtype) {
+    std::string dtype, bool use_gpu) {
   std::unordered_set<int> ids;
   for (auto id : input_ids) {
     ids.insert(id);
@@ -265,12 +305,19 @@ void TestElementwiseMain(
   }
 
   int n = cpu_tensors[0].numel();
-  if (dtype == "__half") {
-    TestMainImpl<paddle::platform::float16>(func_name, code_str, cpu_tensors, n,
-                                            input_ids, output_ids);
+  if (!use_gpu) {
+    TestMainImplCPU(func_name, code_str, cpu_tensors, n, input_ids,
+                    output_ids);
   } else {
-    TestMainImpl<float>(func_name, code_str, cpu_tensors, n, input_ids,
-                        output_ids);
+#ifdef PADDLE_WITH_CUDA
+    if (dtype == "__half") {
+      TestMainImpl<paddle::platform::float16>(func_name, code_str, cpu_tensors,
+                                              n, input_ids, output_ids);
+    } else {
+      TestMainImpl<float>(func_name, code_str, cpu_tensors, n, input_ids,
+                          output_ids);
+    }
+#endif
   }
 
   // Check the results
@@ -281,24 +328,39 @@ void TestElementwiseMain(
   }
 }
 
+// The code for CPU can't be tested without a C++ compiler.
+bool SkipTest(bool use_gpu) {
+  if (!use_gpu) {
+    paddle::platform::DeviceCodePool::Init({paddle::platform::CPUPlace()});
+    return !paddle::platform::CPUDeviceCode::IsAvailable();
+  }
+  return false;
+}
+
 void TestMain(std::string func_name,
               std::vector<fusion_group::OperationExpression> expressions,
               std::vector<int> input_ids, std::vector<int> output_ids,
-              std::string dtype) {
+              std::string dtype, bool use_gpu) {
+  if (SkipTest(use_gpu)) {
+    return;
+  }
   fusion_group::OperationMap::Init();
-  fusion_group::CodeGenerator code_generator;
+  fusion_group::CodeGenerator code_generator(use_gpu);
   std::string code_str = code_generator.Generate(func_name, expressions);
   VLOG(3) << code_str;
 
-  LOG(INFO) << "dtype: " << dtype;
+  LOG(INFO) << "dtype: " << dtype << ", use_gpu: " << use_gpu;
   TestElementwiseMain(func_name, code_str, expressions, input_ids, output_ids,
-                      dtype);
+                      dtype, use_gpu);
 }
 
 void TestMain(fusion_group::SubGraph* subgraph, std::vector<int> input_ids,
-              std::vector<int> output_ids, std::string dtype) {
+              std::vector<int> output_ids, std::string dtype, bool use_gpu) {
+  if (SkipTest(use_gpu)) {
+    return;
+  }
   fusion_group::OperationMap::Init();
-  fusion_group::CodeGenerator code_generator;
+  fusion_group::CodeGenerator code_generator(use_gpu);
   std::string code_str = code_generator.Generate(subgraph);
   VLOG(3) << code_str;
 
@@ -307,11 +369,13 @@ void TestMain(fusion_group::SubGraph* subgraph, std::vector<int> input_ids,
       code_generator.ConvertToExpressions(subgraph);
 
   TestElementwiseMain(subgraph->GetFuncName(), code_str, expressions, input_ids,
-                      output_ids, dtype);
+                      output_ids, dtype, use_gpu);
 }
 
 TEST(code_generator, elementwise) {
-  for (std::string dtype : {"float", "__half"}) {
+  for (auto& config : TestedConfigs()) {
+    bool use_gpu = config.first;
+    std::string dtype = config.second;
     // t2 = t0 * t1
     // t4 = t2 + t3
     // t6 = t4 - t5
@@ -336,12 +400,15 @@ TEST(code_generator, elementwise) {
     //  Op(sigmoid), inputs:{7}, outputs:{8}
     std::vector<int> input_ids = {0, 1, 3, 5};
     std::vector<int> output_ids = {2, 4, 6, 7, 8};
-    TestMain("elementwise_kernel_0", expressions, input_ids, output_ids, dtype);
+    TestMain("elementwise_kernel_0", expressions, input_ids, output_ids, dtype,
+             use_gpu);
   }
 }
 
 TEST(code_generator, elementwise_grad) {
-  for (std::string dtype : {"float", "__half"}) {
+  for (auto& config : TestedConfigs()) {
+    bool use_gpu = config.first;
+    std::string dtype = config.second;
     // The var order: t0, t1, t2, t3, t0', t1', t2', t3'
     // t2 = t0 * t1
     // t3 = relu(t2)
@@ -359,7 +426,7 @@ TEST(code_generator, elementwise_grad) {
     std::vector<int> input_ids = {0, 1, 2, 3, 7};
     std::vector<int> output_ids = {4, 5, 6};
     TestMain("elementwise_grad_kernel_0", expressions, input_ids, output_ids,
-             dtype);
+             dtype, use_gpu);
   }
 }
 
@@ -462,7 +529,9 @@ std::unordered_set<paddle::framework::ir::Node*> DistilGradNodes(
 }
 
 TEST(code_generator, subgraph) {
-  for (std::string dtype : {"float", "__half"}) {
+  for (auto& config : TestedConfigs()) {
+    bool use_gpu = config.first;
+    std::string dtype = config.second;
     std::unique_ptr<paddle::framework::ir::Graph> graph =
         BuildGraph(false, dtype);
     fusion_group::SubGraph subgraph(0, "elementwise_kernel_1", false,
@@ -476,12 +545,14 @@ TEST(code_generator, subgraph) {
     //  Op(elementwise_add), inputs:{7,6}, outputs:{8}
     std::vector<int> input_ids = {0, 1, 2, 3};
     std::vector<int> output_ids = {4, 5, 6, 7, 8};
-    TestMain(&subgraph, input_ids, output_ids, dtype);
+    TestMain(&subgraph, input_ids, output_ids, dtype, use_gpu);
   }
 }
 
 TEST(code_generator, subgraph_grad) {
-  for (std::string dtype : {"float", "__half"}) {
+  for (auto& config : TestedConfigs()) {
+    bool use_gpu = config.first;
+    std::string dtype = config.second;
     std::unique_ptr<paddle::framework::ir::Graph> graph =
         BuildGraph(true, dtype);
     fusion_group::SubGraph subgraph(0, "elementwise_grad_kernel_1", false,
@@ -495,7 +566,6 @@ TEST(code_generator, subgraph_grad) {
     //  Op(tanh_grad), inputs:{9,4,13}, outputs:{14}
     std::vector<int> input_ids = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
     std::vector<int> output_ids = {10, 11, 12, 13, 14, 15, 16, 17};
-    TestMain(&subgraph, input_ids, output_ids, dtype);
+    TestMain(&subgraph, input_ids, output_ids, dtype, use_gpu);
   }
 }
-#endif
@@ -0,0 +1,72 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+namespace paddle {
+namespace framework {
+namespace ir {
+namespace fusion_group {
+
+// glibc declares the vector variants of exp and log in libmvec only with
+// -ffast-math, so they are declared here for the loops calling them to be
+// vectorized. They are accurate within 4 ulp, rather than the 1 ulp of the
+// scalar ones.
+static constexpr char predefined_cpu_functions[] = R"(
+#include <math.h>
+#include <stddef.h>
+
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__clang__) && \
+    defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 22)
+extern "C" {
+float expf(float) __attribute__((simd("notinbranch")));
+float logf(float) __attribute__((simd("notinbranch")));
+double exp(double) __attribute__((simd("notinbranch")));
+double log(double) __attribute__((simd("notinbranch")));
+}
+#endif
+
+static inline float Max(float x, float y) { return fmaxf(x, y); }
+static inline float Exp(float x) { return expf(x); }
+static inline float Log(float x) { return logf(x); }
+static inline float Sqrt(float x) { return sqrtf(x); }
+
+static inline double Max(double x, double y) { return fmax(x, y); }
+static inline double Exp(double x) { return exp(x); }
+static inline double Log(double x) { return log(x); }
+static inline double Sqrt(double x) { return sqrt(x); }
+
+)";
+
+// The arguments are unpacked from args in $parameters, where args[0] points
+// to the number of elements like the arguments of the CUDA kernels. An
+// output may share the memory of an input, but the elements are computed
+// independently, so the loop is declared free of carried dependencies to be
+// vectorized.
+static constexpr char cpu_kernel_template_1d[] = R"(
+extern "C" void $func_name(size_t begin, size_t end, void** args) {
+  $parameters
+  #pragma GCC ivdep
+  for(size_t idx = begin;
+      idx < end;
+      ++idx) {
+    $compute_body
+  }
+}
+)";
+
+}  // namespace fusion_group
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
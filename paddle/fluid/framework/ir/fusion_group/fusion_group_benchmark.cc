@@ -0,0 +1,252 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+// Time of the elementwise subgraphs of CTR models on CPU, run by a kernel for
+// each operation, which writes a full intermediate tensor like the unfused
+// operators do, and by a single kernel fused by fusion_group. The kernels are
+// generated by CodeGenerator and compiled by CPUDeviceCode, so that the
+// difference is the passes over memory saved by the fusion.
+//
+// Usage:
+//   ./fusion_group_benchmark --numel=1048576 --repeat=100
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/ir/fusion_group/code_generator.h"
+#include "paddle/fluid/framework/ir/fusion_group/operation.h"
+#include "paddle/fluid/platform/device_code.h"
+
+DEFINE_int32(numel, 1 << 20, "Number of the elements of each tensor.");
+DEFINE_int32(repeat, 100, "Times to run each subgraph.");
+
+namespace paddle {
+namespace framework {
+namespace ir {
+namespace fusion_group {
+
+struct Subgraph {
+  std::string name;
+  std::vector<OperationExpression> expressions;
+  std::set<int> fetch_ids;
+};
+
+static OperationExpression Op(const std::string& op_type,
+                              const std::vector<int>& input_ids, int output_id,
+                              const AttributeMap& attrs = {}) {
+  OperationExpression expression(op_type, input_ids, {output_id}, "float",
+                                 "float");
+  expression.SetAttr(attrs);
+  return expression;
+}
+
+// The elementwise subgraphs which run between the fc and the embedding
+// lookups of CTR models.
+static std::vector<Subgraph> CTRSubgraphs() {
+  std::vector<Subgraph> subgraphs;
+  // The GRU unit of the interest evolution layer of DIEN:
+  //   u = sigmoid(xu + hu), r = sigmoid(xr + hr),
+  //   c = tanh(xc + r * hc), h = c + u * (h_prev - c)
+  subgraphs.push_back({"dien_gru_unit",
+                       {Op("elementwise_add", {0, 1}, 7),
+                        Op("sigmoid", {7}, 8),
+                        Op("elementwise_add", {2, 3}, 9),
+                        Op("sigmoid", {9}, 10),
+                        Op("elementwise_mul", {10, 5}, 11),
+                        Op("elementwise_add", {4, 11}, 12),
+                        Op("tanh", {12}, 13),
+                        Op("elementwise_sub", {6, 13}, 14),
+                        Op("elementwise_mul", {8, 14}, 15),
+                        Op("elementwise_add", {13, 15}, 16)},
+                       {16}});
+  // The second order term of DeepFM:
+  //   0.5 * (square(sum(v)) - sum(square(v)))
+  subgraphs.push_back({"deepfm_second_order",
+                       {Op("square", {0}, 2), Op("elementwise_sub", {2, 1}, 3),
+                        Op("scale", {3}, 4, {{"scale", 0.5f},
+                                             {"bias", 0.0f},
+                                             {"bias_after_scale", true}})},
+                       {4}});
+  // The gated activation with a residual connection of the gating networks:
+  //   relu(tanh(x) * sigmoid(y) + z)
+  subgraphs.push_back({"gated_residual",
+                       {Op("tanh", {0}, 3), Op("sigmoid", {1}, 4),
+                        Op("elementwise_mul", {3, 4}, 5),
+                        Op("elementwise_add", {5, 2}, 6), Op("relu", {6}, 7)},
+                       {7}});
+  return subgraphs;
+}
+
+// A kernel compiled for CPU, and its arguments following the order of the
+// parameters emitted by CodeGenerator.
+struct Kernel {
+  std::unique_ptr<platform::CPUDeviceCode> device_code;
+  std::vector<void*> args;
+};
+
+static Kernel CreateKernel(const std::string& func_name,
+                           const std::vector<OperationExpression>& expressions,
+                           size_t* n, std::vector<float*>* ptrs) {
+  std::set<int> input_ids;
+  std::set<int> output_ids;
+  std::set<int> intermediate_ids;
+  for (auto& expression : expressions) {
+    for (auto id : expression.GetInputIds()) {
+      input_ids.insert(id);
+    }
+    auto intermediate_state = expression.GetIntermediateState();
+    for (auto id : expression.GetOutputIds()) {
+      output_ids.insert(id);
+      if (intermediate_state[id]) {
+        intermediate_ids.insert(id);
+      }
+    }
+  }
+
+  Kernel kernel;
+  kernel.args.push_back(n);
+  for (auto id : input_ids) {
+    if (output_ids.find(id) == output_ids.end()) {
+      kernel.args.push_back(&(*ptrs)[id]);
+    }
+  }
+  for (auto id : output_ids) {
+    if (intermediate_ids.find(id) == intermediate_ids.end()) {
+      kernel.args.push_back(&(*ptrs)[id]);
+    }
+  }
+
+  CodeGenerator code_generator(false);
+  std::string code_str = code_generator.Generate(func_name, expressions);
+  VLOG(3) << code_str;
+  kernel.device_code.reset(
+      new platform::CPUDeviceCode(platform::CPUPlace(), func_name, code_str));
+  PADDLE_ENFORCE_EQ(kernel.device_code->Compile(), true,
+                    platform::errors::External(
+                        "Failed to compile the kernel %s.", func_name));
+  return kernel;
+}
+
+static double RunKernels(const std::vector<Kernel>& kernels, size_t n) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < FLAGS_repeat; ++i) {
+    for (auto& kernel : kernels) {
+      std::vector<void*> args = kernel.args;
+      kernel.device_code->Launch(n, &args);
+    }
+  }
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+             .count() /
+         FLAGS_repeat;
+}
+
+static void RunBenchmark(const Subgraph& subgraph) {
+  int num_vars = 0;
+  for (auto& expression : subgraph.expressions) {
+    for (auto id : expression.GetOutputIds()) {
+      num_vars = std::max(num_vars, id + 1);
+    }
+  }
+  size_t n = FLAGS_numel;
+  std::vector<std::vector<float>> unfused_data(num_vars,
+                                               std::vector<float>(n));
+  std::vector<std::vector<float>> fused_data(num_vars, std::vector<float>(n));
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> dist(-1.f, 1.f);
+  for (int id = 0; id < num_vars; ++id) {
+    for (size_t i = 0; i < n; ++i) {
+      unfused_data[id][i] = dist(rng);
+    }
+    fused_data[id] = unfused_data[id];
+  }
+  std::vector<float*> unfused_ptrs(num_vars);
+  std::vector<float*> fused_ptrs(num_vars);
+  for (int id = 0; id < num_vars; ++id) {
+    unfused_ptrs[id] = unfused_data[id].data();
+    fused_ptrs[id] = fused_data[id].data();
+  }
+
+  // A kernel for each operation, which writes all its outputs.
+  std::vector<Kernel> unfused;
+  for (size_t i = 0; i < subgraph.expressions.size(); ++i) {
+    unfused.push_back(CreateKernel(
+        subgraph.name + "_unfused_" + std::to_string(i),
+        {subgraph.expressions[i]}, &n, &unfused_ptrs));
+  }
+  // A single kernel, which only writes the fetched outputs.
+  std::vector<OperationExpression> expressions;
+  for (auto expression : subgraph.expressions) {
+    std::unordered_map<int, bool> intermediate_state;
+    for (auto id : expression.GetOutputIds()) {
+      intermediate_state[id] =
+          subgraph.fetch_ids.find(id) == subgraph.fetch_ids.end();
+    }
+    expressions.emplace_back(expression.GetOpType(), expression.GetInputIds(),
+                             expression.GetOutputIds(), "float", "float",
+                             intermediate_state);
+    expressions.back().SetAttr(expression.GetAttr());
+  }
+  std::vector<Kernel> fused;
+  fused.push_back(
+      CreateKernel(subgraph.name + "_fused", expressions, &n, &fused_ptrs));
+
+  double unfused_ms = RunKernels(unfused, n);
+  double fused_ms = RunKernels(fused, n);
+
+  float max_diff = 0;
+  for (auto id : subgraph.fetch_ids) {
+    for (size_t i = 0; i < n; ++i) {
+      max_diff = std::max(
+          max_diff, std::fabs(unfused_data[id][i] - fused_data[id][i]));
+    }
+  }
+  std::cout << subgraph.name << "\t" << subgraph.expressions.size() << "\t"
+            << unfused_ms << "\t" << fused_ms << "\t"
+            << unfused_ms / fused_ms << "\t" << max_diff << std::endl;
+}
+
+}  // namespace fusion_group
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+
+  namespace fusion_group = paddle::framework::ir::fusion_group;
+  paddle::platform::DeviceCodePool::Init({paddle::platform::CPUPlace()});
+  if (!paddle::platform::CPUDeviceCode::IsAvailable()) {
+    LOG(ERROR) << "The C++ compiler for the JIT compiling is not available.";
+    return 1;
+  }
+  fusion_group::OperationMap::Init();
+
+  std::cout << "subgraph\toperations\tunfused ms\tfused ms\tspeedup\t"
+            << "max diff" << std::endl;
+  for (auto& subgraph : fusion_group::CTRSubgraphs()) {
+    fusion_group::RunBenchmark(subgraph);
+  }
+  return 0;
+}
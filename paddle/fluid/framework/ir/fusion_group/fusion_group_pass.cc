@@ -23,13 +23,16 @@ limitations under the License. */
 #include "paddle/fluid/framework/op_proto_maker.h"
 #include "paddle/fluid/platform/device_code.h"
 
+DECLARE_string(cpu_jit_compiler);
+
 namespace paddle {
 namespace framework {
 namespace ir {
 
 void FusionGroupPass::ApplyImpl(ir::Graph* graph) const {
   FusePassBase::Init("fusion_group_pass", graph);
-  if (Get<bool>("use_gpu")) {
+  bool use_gpu = Get<bool>("use_gpu");
+  if (use_gpu) {
     // TODO(liuyiqun): open this check.
     // if (!platform::CUDADeviceCode::IsAvailable()) {
     //   LOG(WARNING)
@@ -37,18 +40,52 @@ void FusionGroupPass::ApplyImpl(ir::Graph* graph) const {
     //       avaiable.";
     //   return 0;
     // }
+#ifndef PADDLE_WITH_CUDA
+    LOG(WARNING) << "Disable fusion_group on GPU because Paddle is not "
+                    "compiled with CUDA.";
+    return;
+#endif
+  } else {
+    // Check the compiler when the places are added to the DeviceCodePool.
+    platform::DeviceCodePool::Init({platform::CPUPlace()});
+    if (!platform::CPUDeviceCode::IsAvailable()) {
+      LOG(WARNING) << "Disable fusion_group on CPU because the compiler "
+                   << FLAGS_cpu_jit_compiler << " is not available.";
+      return;
+    }
+  }
+
+  fusion_group::OperationMap::Init();
+  int num_elementwise_groups = DetectFusionGroup(graph, 0);
+  AddStatis(num_elementwise_groups);
+  LOG(INFO) << "Detect " << num_elementwise_groups
+            << " elementwise fusion groups on "
+            << (use_gpu ? "GPU" : "CPU") << ".";
+}
+
+static platform::Place GetFusionGroupPlace(bool use_gpu) {
+  // TODO(liuyiqun): supported different places
+  if (use_gpu) {
+    return platform::CUDAPlace(0);
+  }
+  return platform::CPUPlace();
+}
 
-    fusion_group::OperationMap::Init();
-    int num_elementwise_groups = DetectFusionGroup(graph, 0);
-    AddStatis(num_elementwise_groups);
-    LOG(INFO) << "Detect " << num_elementwise_groups
-              << " elementwise fusion groups.";
+// The kernels for CPU are not generated for float16, which has no arithmetic
+// in C++.
+static bool HasFloat16Var(const fusion_group::SubGraph& subgraph) {
+  for (auto* n : subgraph.Nodes()) {
+    if (n && n->IsVar() && n->Var() &&
+        n->Var()->GetDataType() == proto::VarType::FP16) {
+      return true;
+    }
   }
+  return false;
 }
 
 int FusionGroupPass::DetectFusionGroup(Graph* graph, int type) const {
-  // TODO(liuyiqun): supported different places
-  platform::CUDAPlace place = platform::CUDAPlace(0);
+  bool use_gpu = Get<bool>("use_gpu");
+  platform::Place place = GetFusionGroupPlace(use_gpu);
   int index = platform::DeviceCodePool::Init({place}).size(place);
 
   std::vector<std::vector<Node*>> subgraphs =
@@ -62,6 +99,10 @@ int FusionGroupPass::DetectFusionGroup(Graph* graph, int type) const {
         type, "", save_intermediate_out,
         std::unordered_set<Node*>(vec.begin(), vec.end()));
     VLOG(3) << "subgraph: {\n" << DebugString(subgraph.SortedNodes()) << "}\n";
+    if (!use_gpu && HasFloat16Var(subgraph)) {
+      VLOG(2) << "Skip the subgraph of float16 on CPU.";
+      continue;
+    }
 
     // In elementwise fused kernel, memory is the bound of execution,
     // here we remove the output id to use less memory and less time.
@@ -80,15 +121,23 @@ int FusionGroupPass::DetectFusionGroup(Graph* graph, int type) const {
 }
 
 bool FusionGroupPass::GenerateCode(fusion_group::SubGraph* subgraph) const {
-  fusion_group::CodeGenerator code_generator;
+  bool use_gpu = Get<bool>("use_gpu");
+  fusion_group::CodeGenerator code_generator(use_gpu);
   std::string code_str = code_generator.Generate(subgraph);
   VLOG(4) << code_str;
 
-  // TODO(liuyiqun): supported different places
-  platform::CUDAPlace place = platform::CUDAPlace(0);
-  std::unique_ptr<platform::CUDADeviceCode> device_code(
-      new platform::CUDADeviceCode(place, subgraph->GetFuncName(), code_str));
-  bool is_compiled = device_code->Compile();
+  platform::Place place = GetFusionGroupPlace(use_gpu);
+  std::unique_ptr<platform::DeviceCode> device_code;
+  if (use_gpu) {
+#ifdef PADDLE_WITH_CUDA
+    device_code.reset(new platform::CUDADeviceCode(
+        place, subgraph->GetFuncName(), code_str));
+#endif
+  } else {
+    device_code.reset(new platform::CPUDeviceCode(
+        place, subgraph->GetFuncName(), code_str));
+  }
+  bool is_compiled = device_code && device_code->Compile();
   if (is_compiled) {
     platform::DeviceCodePool& pool = platform::DeviceCodePool::Init({place});
     pool.Set(std::move(device_code));
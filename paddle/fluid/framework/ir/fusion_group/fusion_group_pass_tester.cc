@@ -17,6 +17,7 @@ limitations under the License. */
 #include <gtest/gtest.h>
 #include "paddle/fluid/framework/ir/fusion_group/operation.h"
 #include "paddle/fluid/framework/ir/pass_tester_helper.h"
+#include "paddle/fluid/platform/device_code.h"
 
 namespace paddle {
 namespace framework {
@@ -133,10 +134,11 @@ std::unique_ptr<Graph> BuildElementwiseTreeGraph(bool backward = false) {
 #endif
 }
 
-int TestMain(std::unique_ptr<Graph> graph, std::string prefix) {
+int TestMain(std::unique_ptr<Graph> graph, std::string prefix,
+             bool use_gpu = true) {
   // VisualizeGraph(&graph, prefix + ".dot");
   auto pass = PassRegistry::Instance().Get("fusion_group_pass");
-  pass->Set("use_gpu", new bool(true));
+  pass->Set("use_gpu", new bool(use_gpu));
   VLOG(3) << DebugString(graph);
 
   graph.reset(pass->Apply(graph.release()));
@@ -147,6 +149,7 @@ int TestMain(std::unique_ptr<Graph> graph, std::string prefix) {
   return num_fusion_group_ops;
 }
 
+#ifdef PADDLE_WITH_CUDA
 TEST(FusionGroupPass, elementwise_list) {
   std::unique_ptr<Graph> graph = BuildElementwiseListGraph(true);
   int num_fusion_group_ops = TestMain(std::move(graph), "elementwise_list");
@@ -158,6 +161,29 @@ TEST(FusionGroupPass, elementwise_tree) {
   int num_fusion_group_ops = TestMain(std::move(graph), "elementwise_tree");
   EXPECT_EQ(num_fusion_group_ops, 4);
 }
+#endif
+
+TEST(FusionGroupPass, elementwise_cpu) {
+  platform::DeviceCodePool::Init({platform::CPUPlace()});
+  if (!platform::CPUDeviceCode::IsAvailable()) {
+    return;
+  }
+
+  std::unique_ptr<Graph> list_graph = BuildElementwiseListGraph(true);
+  EXPECT_EQ(TestMain(std::move(list_graph), "elementwise_list_cpu", false), 2);
+
+  std::unique_ptr<Graph> tree_graph = BuildElementwiseTreeGraph(true);
+  EXPECT_EQ(TestMain(std::move(tree_graph), "elementwise_tree_cpu", false), 4);
+
+  // The subgraphs of float16 are not fused on CPU.
+  std::unique_ptr<Graph> fp16_graph = BuildElementwiseListGraph(false);
+  for (auto* n : fp16_graph->Nodes()) {
+    if (n && n->IsVar() && n->Var()) {
+      n->Var()->SetDataType(proto::VarType::FP16);
+    }
+  }
+  EXPECT_EQ(TestMain(std::move(fp16_graph), "elementwise_fp16_cpu", false), 0);
+}
 
 }  // namespace ir
 }  // namespace framework
@@ -0,0 +1,148 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <glog/logging.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace paddle {
+namespace framework {
+
+// A bounded lock-free multi-producer/multi-consumer queue.
+//
+// Each cell carries a sequence number, which tells producers and consumers
+// whether the cell is ready to be written or read in the current lap of the
+// ring. Producers and consumers only contend on a single atomic counter
+// each, and never take a lock. See
+// http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+//
+// NOTE: T must be default constructible and move assignable.
+template <class T>
+class MPMCQueue {
+ public:
+  // capacity would be rounded up to the power of 2.
+  explicit MPMCQueue(size_t capacity) {
+    CHECK(capacity >= 1) << "capacity of MPMCQueue must be >= 1";
+    capacity_ = 2;
+    while (capacity_ < capacity) {
+      capacity_ <<= 1;
+    }
+    mask_ = capacity_ - 1;
+    cells_.reset(new Cell[capacity_]);
+    for (size_t i = 0; i < capacity_; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    enqueue_pos_.store(0, std::memory_order_relaxed);
+    dequeue_pos_.store(0, std::memory_order_relaxed);
+  }
+
+  MPMCQueue(const MPMCQueue&) = delete;
+  MPMCQueue& operator=(const MPMCQueue&) = delete;
+
+  size_t Capacity() const { return capacity_; }
+
+  // The size may be out of date as soon as it returns.
+  size_t SizeApprox() const {
+    size_t tail = enqueue_pos_.load(std::memory_order_relaxed);
+    size_t head = dequeue_pos_.load(std::memory_order_relaxed);
+    return tail > head ? tail - head : 0;
+  }
+
+  // non-blocking, returns false if the queue is full
+  bool TryPush(T&& val) {
+    size_t pos;
+    Cell* cell = AcquireCell(&enqueue_pos_, 0, &pos);
+    if (cell == nullptr) {
+      return false;
+    }
+    cell->data = std::move(val);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool TryPush(const T& val) {
+    size_t pos;
+    Cell* cell = AcquireCell(&enqueue_pos_, 0, &pos);
+    if (cell == nullptr) {
+      return false;
+    }
+    cell->data = val;
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  // non-blocking, returns false if the queue is empty
+  bool TryPop(T* val) {
+    size_t pos;
+    Cell* cell = AcquireCell(&dequeue_pos_, 1, &pos);
+    if (cell == nullptr) {
+      return false;
+    }
+    *val = std::move(cell->data);
+    cell->sequence.store(pos + capacity_, std::memory_order_release);
+    return true;
+  }
+
+ private:
+  static constexpr size_t kCacheLineSize = 64;
+
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T data;
+  };
+
+  // Claim the cell at *pos whose sequence should be (*pos + lap_offset), and
+  // store the claimed position to *claimed. Returns nullptr if the queue is
+  // full (for producers) or empty (for consumers).
+  Cell* AcquireCell(std::atomic<size_t>* pos, size_t lap_offset,
+                    size_t* claimed) {
+    size_t cur = pos->load(std::memory_order_relaxed);
+    while (true) {
+      Cell* cell = &cells_[cur & mask_];
+      size_t seq = cell->sequence.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(seq) -
+                      static_cast<intptr_t>(cur + lap_offset);
+      if (diff == 0) {
+        if (pos->compare_exchange_weak(cur, cur + 1,
+                                       std::memory_order_relaxed)) {
+          *claimed = cur;
+          return cell;
+        }
+      } else if (diff < 0) {
+        return nullptr;
+      } else {
+        cur = pos->load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  size_t capacity_;
+  size_t mask_;
+  std::unique_ptr<Cell[]> cells_;
+  // Keep the producer and consumer counters on different cache lines to
+  // avoid false sharing.
+  char pad0_[kCacheLineSize];
+  std::atomic<size_t> enqueue_pos_;
+  char pad1_[kCacheLineSize - sizeof(std::atomic<size_t>)];
+  std::atomic<size_t> dequeue_pos_;
+  char pad2_[kCacheLineSize - sizeof(std::atomic<size_t>)];
+};
+
+}  // namespace framework
+}  // namespace paddle
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <chrono>  // NOLINT
 #include <memory>
 #include <string>
 #include <utility>
@@ -24,8 +25,12 @@
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/reader.h"
 #include "paddle/fluid/framework/variable_helper.h"
+#include "paddle/fluid/platform/monitor.h"
 #include "paddle/fluid/string/pretty_log.h"
 
+USE_INT_STAT(STAT_executor_op_count);
+USE_HISTOGRAM_STAT(STAT_executor_run_us);
+
 namespace paddle {
 namespace framework {
 void NaiveExecutor::Prepare(Scope *scope, const ProgramDesc &program_desc,
@@ -41,12 +46,32 @@ void NaiveExecutor::Prepare(Scope *scope, const ProgramDesc &program_desc,
 }
 
 void NaiveExecutor::Run() {
+  auto start = std::chrono::steady_clock::now();
+  bool planned = memory_planner_ && memory_planner_->Apply();
   for (auto &op : ops_) {
     VLOG(4) << std::this_thread::get_id() << " run "
             << op->DebugStringEx(scope_) << " on scope " << scope_;
     op->SetIsCalledByExecutor(false);
     op->Run(*scope_, place_);
   }
+  if (memory_planner_ && !planned) {
+    memory_planner_->Plan();
+  }
+  STAT_ADD(STAT_executor_op_count, static_cast<int64_t>(ops_.size()));
+  STAT_OBSERVE(STAT_executor_run_us,
+               std::chrono::duration_cast<std::chrono::microseconds>(
+                   std::chrono::steady_clock::now() - start)
+                   .count());
+}
+
+void NaiveExecutor::EnableStaticMemoryPlan(
+    const std::vector<std::string> &outputs, size_t max_num_plans) {
+  PADDLE_ENFORCE_NOT_NULL(
+      scope_, platform::errors::PreconditionNotMet(
+                  "The NaiveExecutor should be prepared before the static "
+                  "memory plan is enabled."));
+  memory_planner_.reset(
+      new StaticMemoryPlanner(ops_, scope_, place_, outputs, max_num_plans));
 }
 
 void NaiveExecutor::CreateVariables(const ProgramDesc &desc, int block_id,
@@ -14,11 +14,13 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 #include <vector>
 #include "paddle/fluid/framework/operator.h"
 #include "paddle/fluid/framework/program_desc.h"
 #include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/framework/static_memory_planner.h"
 #include "paddle/fluid/platform/device_context.h"
 
 namespace paddle {
@@ -49,6 +51,16 @@ class NaiveExecutor {
   // Run all the operators.
   void Run();
 
+  // Plan the memory of the temporary variables in one arena for each
+  // signature of the inputs, up to max_num_plans of them, after Prepare.
+  // @outputs: the variables read after the runs.
+  void EnableStaticMemoryPlan(const std::vector<std::string>& outputs,
+                              size_t max_num_plans);
+
+  const StaticMemoryPlanner* memory_planner() const {
+    return memory_planner_.get();
+  }
+
   // Get an tensor to operating directly, without the need for feed_ops.
   LoDTensor* FindTensor(const std::string& name);
 
@@ -64,7 +76,8 @@ class NaiveExecutor {
   const platform::Place place_;
   // Catch the required resource to avoid recreate.
   std::vector<std::unique_ptr<OperatorBase>> ops_;
-  Scope* scope_;
+  Scope* scope_{nullptr};
+  std::unique_ptr<StaticMemoryPlanner> memory_planner_;
 };
 
 }  // namespace framework
@@ -0,0 +1,297 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Per-op dispatch overhead of small CPU programs, with and without the
+// cached RuntimeContext and the cached InferShape.
+//
+// --model=chain runs a chain of ops which add a parameter of the root scope
+// to a one-element tensor of the leaf scope, so the time is dominated by
+// OperatorWithKernel::RunImpl rather than by the kernel. --model=mlp runs a
+// small CTR model: the embeddings of --slot_num slots are concatenated and
+// fed to two fully connected layers of --hidden_size with relu, and a
+// sigmoid output, so the saving of the dispatch is compared with the time of
+// real kernels. The leaf scope is --scope_depth levels below the root, as
+// the local scopes of the executors are.
+//
+// Usage:
+//   ./op_dispatch_benchmark --op_num=100 --iterations=10000 --scope_depth=2
+//   ./op_dispatch_benchmark --model=mlp --slot_num=26 --batch_size=1
+
+#include <chrono>  // NOLINT
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/framework/operator.h"
+#include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/platform/init.h"
+
+DECLARE_bool(cache_runtime_context);
+DECLARE_bool(cache_infer_shape);
+
+DEFINE_string(model, "chain", "The program to run, chain or mlp.");
+DEFINE_int32(op_num, 100, "Number of ops of the chain program.");
+DEFINE_int32(slot_num, 26, "Number of sparse slots of the mlp program.");
+DEFINE_int32(embedding_size, 8, "Size of the embeddings of the mlp program.");
+DEFINE_int32(hidden_size, 64,
+             "Size of the fully connected layers of the mlp program.");
+DEFINE_int32(batch_size, 1, "Batch size of the mlp program.");
+DEFINE_int32(iterations, 10000, "Runs of the program.");
+DEFINE_int32(repeat, 3,
+             "Repeats of each measurement, of which the fastest is reported.");
+DEFINE_int32(scope_depth, 2,
+             "Levels of the scope the program runs in below the root scope "
+             "holding the parameters.");
+
+namespace paddle {
+namespace framework {
+
+class DispatchBenchOp : public OperatorWithKernel {
+ public:
+  using OperatorWithKernel::OperatorWithKernel;
+
+ protected:
+  void InferShape(InferShapeContext* ctx) const override {
+    ctx->SetOutputDim("Out", ctx->GetInputDim("X"));
+  }
+  OpKernelType GetExpectedKernelType(
+      const ExecutionContext& ctx) const override {
+    return OpKernelType(proto::VarType::FP32, ctx.GetPlace());
+  }
+};
+
+class DispatchBenchOpMaker : public OpProtoAndCheckerMaker {
+ public:
+  void Make() {
+    AddInput("X", "input of the op");
+    AddInput("Y", "parameter of the op");
+    AddOutput("Out", "output of the op");
+    AddComment("Out = X + Y, with tensors of one element.");
+  }
+};
+
+template <typename T>
+class DispatchBenchKernel : public OpKernel<T> {
+ public:
+  void Compute(const ExecutionContext& ctx) const override {
+    auto* x = ctx.Input<Tensor>("X");
+    auto* y = ctx.Input<Tensor>("Y");
+    auto* out = ctx.Output<Tensor>("Out");
+    out->mutable_data<T>(ctx.GetPlace())[0] = x->data<T>()[0] + y->data<T>()[0];
+  }
+};
+
+static void SetScalar(Variable* var, float value) {
+  auto* tensor = var->GetMutable<LoDTensor>();
+  tensor->Resize({1});
+  tensor->mutable_data<float>(platform::CPUPlace())[0] = value;
+}
+
+using OpList = std::vector<std::unique_ptr<OperatorBase>>;
+
+// The chain of ops, whose last output is 1 + 0.5 * op_num.
+static OpList CreateChainOps(Scope* root, Scope* scope) {
+  SetScalar(root->Var("w"), 0.5f);
+  SetScalar(scope->Var("x"), 1.f);
+  OpList ops;
+  for (int i = 0; i < FLAGS_op_num; ++i) {
+    std::string x = i == 0 ? "x" : "tmp_" + std::to_string(i - 1);
+    std::string out = "tmp_" + std::to_string(i);
+    scope->Var(out)->GetMutable<LoDTensor>();
+    ops.push_back(OpRegistry::CreateOp("dispatch_bench",
+                                       {{"X", {x}}, {"Y", {"w"}}},
+                                       {{"Out", {out}}}, AttributeMap()));
+  }
+  return ops;
+}
+
+static void CheckChainOutput(const Scope& scope) {
+  float expected = 1 + FLAGS_op_num * 0.5f;
+  float result = scope.FindVar("tmp_" + std::to_string(FLAGS_op_num - 1))
+                     ->Get<LoDTensor>()
+                     .data<float>()[0];
+  CHECK_EQ(result, expected);
+}
+
+static void SetParameter(Variable* var, const DDim& dims) {
+  auto* tensor = var->GetMutable<LoDTensor>();
+  tensor->Resize(dims);
+  auto* data = tensor->mutable_data<float>(platform::CPUPlace());
+  for (int64_t i = 0; i < tensor->numel(); ++i) {
+    data[i] = static_cast<float>(i % 7 - 3) * 0.01f;
+  }
+}
+
+// The fully connected layer of x, with the activation if it is not empty.
+static std::string AppendFC(Scope* root, Scope* scope, const std::string& x,
+                            int in_size, int out_size,
+                            const std::string& activation,
+                            const std::string& name, OpList* ops) {
+  SetParameter(root->Var(name + "_w"), make_ddim({in_size, out_size}));
+  SetParameter(root->Var(name + "_b"), make_ddim({out_size}));
+  for (auto suffix : {"_mul", "_add", "_act"}) {
+    scope->Var(name + suffix)->GetMutable<LoDTensor>();
+  }
+  ops->push_back(OpRegistry::CreateOp(
+      "mul", {{"X", {x}}, {"Y", {name + "_w"}}}, {{"Out", {name + "_mul"}}},
+      AttributeMap()));
+  ops->push_back(OpRegistry::CreateOp(
+      "elementwise_add", {{"X", {name + "_mul"}}, {"Y", {name + "_b"}}},
+      {{"Out", {name + "_add"}}}, AttributeMap()));
+  if (activation.empty()) {
+    return name + "_add";
+  }
+  ops->push_back(OpRegistry::CreateOp(activation, {{"X", {name + "_add"}}},
+                                      {{"Out", {name + "_act"}}},
+                                      AttributeMap()));
+  return name + "_act";
+}
+
+// The CTR model, whose output fc_2_act is the click probability of each
+// sample.
+static OpList CreateMLPOps(Scope* root, Scope* scope) {
+  const int64_t vocab_size = 1000;
+  OpList ops;
+  std::vector<std::string> embeddings;
+  for (int i = 0; i < FLAGS_slot_num; ++i) {
+    std::string slot = "slot_" + std::to_string(i);
+    auto* ids = scope->Var(slot)->GetMutable<LoDTensor>();
+    ids->Resize({FLAGS_batch_size, 1});
+    auto* ids_data = ids->mutable_data<int64_t>(platform::CPUPlace());
+    for (int j = 0; j < FLAGS_batch_size; ++j) {
+      ids_data[j] = (i * 131 + j * 17) % vocab_size;
+    }
+    SetParameter(root->Var(slot + "_table"),
+                 make_ddim({vocab_size, FLAGS_embedding_size}));
+    embeddings.push_back(slot + "_emb");
+    scope->Var(embeddings.back())->GetMutable<LoDTensor>();
+    ops.push_back(OpRegistry::CreateOp(
+        "lookup_table", {{"W", {slot + "_table"}}, {"Ids", {slot}}},
+        {{"Out", {embeddings.back()}}}, AttributeMap()));
+  }
+  scope->Var("concat")->GetMutable<LoDTensor>();
+  ops.push_back(OpRegistry::CreateOp("concat", {{"X", embeddings}},
+                                     {{"Out", {"concat"}}},
+                                     AttributeMap({{"axis", 1}})));
+  std::string x = AppendFC(root, scope, "concat",
+                           FLAGS_slot_num * FLAGS_embedding_size,
+                           FLAGS_hidden_size, "relu", "fc_0", &ops);
+  x = AppendFC(root, scope, x, FLAGS_hidden_size, FLAGS_hidden_size, "relu",
+               "fc_1", &ops);
+  AppendFC(root, scope, x, FLAGS_hidden_size, 1, "sigmoid", "fc_2", &ops);
+  return ops;
+}
+
+static void CheckMLPOutput(const Scope& scope) {
+  auto& prob = scope.FindVar("fc_2_act")->Get<LoDTensor>();
+  CHECK_EQ(prob.numel(), FLAGS_batch_size);
+  for (int64_t i = 0; i < prob.numel(); ++i) {
+    CHECK(prob.data<float>()[i] > 0.f && prob.data<float>()[i] < 1.f);
+  }
+}
+
+// Returns nanoseconds per op, the fastest of the repeats.
+static double RunBenchmark(const OpList& ops, const Scope& scope) {
+  platform::CPUPlace place;
+  for (auto& op : ops) {
+    op->Run(scope, place);
+  }
+  double min_seconds = 0;
+  for (int r = 0; r < FLAGS_repeat; ++r) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < FLAGS_iterations; ++i) {
+      for (auto& op : ops) {
+        op->Run(scope, place);
+      }
+    }
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    if (r == 0 || seconds < min_seconds) {
+      min_seconds = seconds;
+    }
+  }
+  return min_seconds / FLAGS_iterations / ops.size() * 1e9;
+}
+
+// Returns nanoseconds per FindVar of a variable of the root scope.
+static double RunFindVar(const Scope& scope) {
+  auto start = std::chrono::steady_clock::now();
+  size_t found = 0;
+  for (int i = 0; i < FLAGS_iterations * 10; ++i) {
+    found += scope.FindVar("w") != nullptr;
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  CHECK_EQ(found, static_cast<size_t>(FLAGS_iterations) * 10);
+  return seconds / FLAGS_iterations / 10 * 1e9;
+}
+
+}  // namespace framework
+}  // namespace paddle
+
+REGISTER_OP_WITHOUT_GRADIENT(dispatch_bench,
+                             paddle::framework::DispatchBenchOp,
+                             paddle::framework::DispatchBenchOpMaker);
+REGISTER_OP_CPU_KERNEL(dispatch_bench,
+                       paddle::framework::DispatchBenchKernel<float>);
+
+USE_OP(lookup_table);
+USE_OP(concat);
+USE_OP(mul);
+USE_OP(elementwise_add);
+USE_OP(relu);
+USE_OP(sigmoid);
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  paddle::framework::InitDevices(false);
+
+  paddle::framework::Scope root;
+  paddle::framework::Scope* scope = &root;
+  for (int i = 0; i < FLAGS_scope_depth; ++i) {
+    scope = &scope->NewScope();
+  }
+  bool mlp = FLAGS_model == "mlp";
+  CHECK(mlp || FLAGS_model == "chain") << "Unknown model " << FLAGS_model;
+
+  std::cout << "cache_runtime_context\tcache_infer_shape\tns/op" << std::endl;
+  for (bool cache_context : {false, true}) {
+    for (bool cache_shape : {false, true}) {
+      FLAGS_cache_runtime_context = cache_context;
+      FLAGS_cache_infer_shape = cache_shape;
+      // new ops, whose caches are empty
+      auto ops = mlp ? paddle::framework::CreateMLPOps(&root, scope)
+                     : paddle::framework::CreateChainOps(&root, scope);
+      double ns = paddle::framework::RunBenchmark(ops, *scope);
+      if (mlp) {
+        paddle::framework::CheckMLPOutput(*scope);
+      } else {
+        paddle::framework::CheckChainOutput(*scope);
+      }
+      std::cout << cache_context << "\t" << cache_shape << "\t" << ns
+                << std::endl;
+    }
+  }
+  if (!mlp) {
+    std::cout << "FindVar of the root scope: "
+              << paddle::framework::RunFindVar(*scope) << " ns" << std::endl;
+  }
+  return 0;
+}
@@ -31,6 +31,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/transfer_scope_cache.h"
 #include "paddle/fluid/framework/unused_var_check.h"
 #include "paddle/fluid/framework/var_type.h"
+#include "paddle/fluid/platform/op_tracer.h"
 #include "paddle/fluid/platform/profiler.h"
 
 #ifdef PADDLE_WITH_MKLDNN
@@ -44,6 +45,19 @@ DEFINE_int32(inner_op_parallelism, 0, "number of threads for inner op");
 DEFINE_bool(fast_check_nan_inf, false,
             "Fast checking NAN/INF after each operation. It will be a little"
             "bit slow, much faster than check_nan_inf");
+DEFINE_bool(cache_runtime_context, false,
+            "Cache the variables of the RuntimeContext of an operator across "
+            "runs in the same scope, until the variables of the scope or its "
+            "ancestors change. It only helps when the operators run in the "
+            "same scope repeatedly, rather than in a new local scope each "
+            "run. If false, only the ops with attribute "
+            "@ENABLE_CACHE_RUNTIME_CONTEXT@ cache them.");
+DEFINE_bool(cache_infer_shape, false,
+            "Skip InferShape and the check of the data transform of an "
+            "operator when the dims, LoDs, data types, layouts and places of "
+            "its inputs are the same as the last run, and restore the shapes "
+            "of the outputs inferred then. It assumes the shapes don't depend "
+            "on the values of the inputs, which is true for most ops.");
 
 namespace paddle {
 namespace framework {
@@ -174,6 +188,7 @@ void OperatorBase::Run(const Scope& scope, const platform::Place& place) {
       auto op_name = platform::OpName(outputs_, Type());
       platform::RecordEvent op_name_record_event(
           op_name, platform::EventRole::kUniqueOp);
+      platform::ScopedOpTrace op_trace(Type());
       RunImpl(scope, place);
     }
 
@@ -914,20 +929,139 @@ void OperatorWithKernel::RunImpl(const Scope& scope,
   if (!all_kernels_must_compute_runtime_shape_ &&
       HasAttr(kAllKernelsMustComputeRuntimeShape))
     all_kernels_must_compute_runtime_shape_ = true;
-  const Scope* cur_scope = &scope;
-  if (!enable_cache_runtime_context_) {
+  if (!enable_cache_runtime_context_ && !FLAGS_cache_runtime_context) {
     RuntimeContext ctx(Inputs(), Outputs(), scope);
     RunImpl(scope, place, &ctx);
-    pre_scope_ = cur_scope;
   } else {
-    if (runtime_ctx_.get() == nullptr || pre_scope_ != cur_scope) {
-      std::lock_guard<std::mutex> lock(cache_update_mutex_);
-      if (runtime_ctx_.get() == nullptr || pre_scope_ != cur_scope) {
-        runtime_ctx_.reset(new RuntimeContext(Inputs(), Outputs(), scope));
-        pre_scope_ = cur_scope;
+    // holds the context in case another thread replaces the cached one
+    std::shared_ptr<RuntimeContext> ctx = GetRuntimeContext(scope);
+    RunImpl(scope, place, ctx.get());
+  }
+  pre_scope_id_ = scope.id();
+}
+
+std::shared_ptr<RuntimeContext> OperatorWithKernel::GetRuntimeContext(
+    const Scope& scope) const {
+  // read before the variables are found, so that a change during the finding
+  // makes the context resolved again at the next run
+  uint64_t var_version = scope.VarVersion();
+  std::lock_guard<std::mutex> lock(cache_update_mutex_);
+  if (runtime_ctx_ == nullptr || runtime_ctx_scope_id_ != scope.id() ||
+      runtime_ctx_var_version_ != var_version) {
+    runtime_ctx_ = std::make_shared<RuntimeContext>(Inputs(), Outputs(), scope);
+    runtime_ctx_scope_id_ = scope.id();
+    runtime_ctx_var_version_ = var_version;
+  }
+  return runtime_ctx_;
+}
+
+void OperatorWithKernel::InvalidateRuntimeContext() const {
+  std::lock_guard<std::mutex> lock(cache_update_mutex_);
+  runtime_ctx_scope_id_ = 0;
+}
+
+// Appends the signature of an input, or returns false if it is not a
+// LoDTensor.
+static bool AppendInputSignature(const Variable* var,
+                                 std::vector<int64_t>* signature) {
+  if (var == nullptr) {
+    signature->push_back(-1);
+    return true;
+  }
+  if (!var->IsType<LoDTensor>()) {
+    return false;
+  }
+  auto& tensor = var->Get<LoDTensor>();
+  if (tensor.IsInitialized()) {
+    signature->push_back(static_cast<int64_t>(tensor.type()));
+    auto& tensor_place = tensor.place();
+    signature->push_back(tensor_place.which());
+    // not is_gpu_place, whose visitor costs more than the rest
+    auto* gpu_place = boost::get<platform::CUDAPlace>(&tensor_place);
+    signature->push_back(gpu_place ? gpu_place->device : 0);
+  } else {
+    signature->push_back(-1);
+  }
+  signature->push_back(static_cast<int64_t>(tensor.layout()));
+  auto& dims = tensor.dims();
+  signature->push_back(dims.size());
+  for (int i = 0; i < dims.size(); ++i) {
+    signature->push_back(dims[i]);
+  }
+  auto& lod = tensor.lod();
+  signature->push_back(static_cast<int64_t>(lod.size()));
+  for (auto& level : lod) {
+    signature->push_back(static_cast<int64_t>(level.size()));
+    signature->insert(signature->end(), level.begin(), level.end());
+  }
+  return true;
+}
+
+bool OperatorWithKernel::MatchInferShapeCache(const RuntimeContext& ctx) const {
+  auto& cache = infer_shape_cache_;
+  cache.next_signature.clear();
+  for (auto& item : ctx.inputs) {
+    for (auto* var : item.second) {
+      if (!AppendInputSignature(var, &cache.next_signature)) {
+        VLOG(3) << "Do not cache the InferShape of op " << type_
+                << ", whose input " << item.first << " is not a LoDTensor";
+        infer_shape_cacheable_ = false;
+        return false;
       }
     }
-    RunImpl(scope, place, runtime_ctx_.get());
+  }
+  // the outputs found, whose shapes are restored
+  for (auto& item : ctx.outputs) {
+    for (auto* var : item.second) {
+      cache.next_signature.push_back(var == nullptr ? -1 : 0);
+    }
+  }
+  return cache.valid && cache.next_signature == cache.signature;
+}
+
+void OperatorWithKernel::SaveInferShapeCache(const RuntimeContext& ctx,
+                                             bool transformed) const {
+  auto& cache = infer_shape_cache_;
+  cache.valid = false;
+  cache.output_dims.clear();
+  cache.output_lods.clear();
+  for (auto& item : ctx.outputs) {
+    for (auto* var : item.second) {
+      if (var == nullptr) {
+        continue;
+      }
+      if (!var->IsType<LoDTensor>()) {
+        VLOG(3) << "Do not cache the InferShape of op " << type_
+                << ", whose output " << item.first << " is not a LoDTensor";
+        infer_shape_cacheable_ = false;
+        return;
+      }
+      auto& tensor = var->Get<LoDTensor>();
+      cache.output_dims.push_back(tensor.dims());
+      cache.output_lods.push_back(tensor.lod());
+    }
+  }
+  cache.signature.swap(cache.next_signature);
+  cache.transformed = transformed;
+  cache.valid = true;
+}
+
+void OperatorWithKernel::RestoreInferShapeCache(
+    const RuntimeContext& ctx) const {
+  auto& cache = infer_shape_cache_;
+  size_t idx = 0;
+  for (auto& item : ctx.outputs) {
+    for (auto* var : item.second) {
+      if (var == nullptr) {
+        continue;
+      }
+      auto* tensor = var->GetMutable<LoDTensor>();
+      tensor->Resize(cache.output_dims[idx]);
+      if (!(tensor->lod() == cache.output_lods[idx])) {
+        tensor->set_lod(cache.output_lods[idx]);
+      }
+      ++idx;
+    }
   }
 }
 
@@ -937,6 +1071,17 @@ void OperatorWithKernel::RunImpl(const Scope& scope,
   platform::DeviceContextPool& pool = platform::DeviceContextPool::Instance();
   auto* dev_ctx = pool.Get(place);
 
+  std::unique_lock<std::mutex> cache_lock;
+  bool cache_hit = false;
+  if (FLAGS_cache_infer_shape) {
+    // the threads running the op at the same time run it without the cache
+    cache_lock = std::unique_lock<std::mutex>(infer_shape_cache_mutex_,
+                                              std::try_to_lock);
+    if (cache_lock.owns_lock() && infer_shape_cacheable_) {
+      cache_hit = MatchInferShapeCache(*runtime_ctx);
+    }
+  }
+
   if (kernel_type_.get() == nullptr || kernel_func_.get() == nullptr) {
     ChooseKernel(*runtime_ctx, scope, place);
   }
@@ -947,7 +1092,8 @@ void OperatorWithKernel::RunImpl(const Scope& scope,
   {
     platform::RecordEvent record_event("prepare_data",
                                        platform::EventRole::kInnerOp);
-    if (need_prepare_data_) {
+    if (need_prepare_data_ &&
+        !(cache_hit && !infer_shape_cache_.transformed)) {
       transfer_scope = PrepareData(scope, *kernel_type_,
                                    &transfered_inplace_vars, runtime_ctx);
     }
@@ -963,8 +1109,15 @@ void OperatorWithKernel::RunImpl(const Scope& scope,
   if (!all_kernels_must_compute_runtime_shape_) {
     platform::RecordEvent record_event("infer_shape",
                                        platform::EventRole::kInnerOp);
-    RuntimeInferShapeContext infer_shape_ctx(*this, *runtime_ctx);
-    this->InferShape(&infer_shape_ctx);
+    if (cache_hit) {
+      RestoreInferShapeCache(*runtime_ctx);
+    } else {
+      RuntimeInferShapeContext infer_shape_ctx(*this, *runtime_ctx);
+      this->InferShape(&infer_shape_ctx);
+    }
+  }
+  if (cache_lock.owns_lock() && infer_shape_cacheable_ && !cache_hit) {
+    SaveInferShapeCache(*runtime_ctx, transfer_scope != nullptr);
   }
 
   if (FLAGS_enable_unused_var_check) {
@@ -1239,12 +1392,10 @@ Scope* OperatorWithKernel::PrepareData(
       // each result of different input will be the same with the first one.
       // The reason is that if a gpu tensor is the input of a cpu kernel,
       // we will create a new cpu tensor in new scope.
-      // However, if enable_cache_runtime_context_, we get the cpu tensor each
-      // time, not the gpu tensor. Thus, we set pre_scope_ = nullptr
-      // to trigger `new RuntimeContext()` in RunImpl().
-      if (enable_cache_runtime_context_) {
-        pre_scope_ = nullptr;
-      }
+      // However, the cached RuntimeContext refers to the cpu tensor after
+      // this run, not the gpu tensor. Thus, we invalidate it to trigger
+      // `new RuntimeContext()` in RunImpl().
+      InvalidateRuntimeContext();
       auto* trans_var = new_scope->Var(var_name);
       input_vars[i] = trans_var;
       Tensor out;
@@ -1252,13 +1403,13 @@ Scope* OperatorWithKernel::PrepareData(
       SetTensorToVariable(*var, out, trans_var);
     }
   }
-  // If pre_scope = &scope, it means that scope is cached and the op is not in
-  // while block. If new_scope = nullptr, it means that for each input of this
-  // Op, there is no need to do PrepareData. So PrepareData could be skipped at
-  // the rest iterations to save the elapsed time.
+  // If pre_scope_id_ = scope.id(), it means that scope is cached and the op
+  // is not in while block. If new_scope = nullptr, it means that for each
+  // input of this Op, there is no need to do PrepareData. So PrepareData could
+  // be skipped at the rest iterations to save the elapsed time.
   // We do not support skipping PrepareData in while block, because the Op's
   // input may be changed by subsequent Ops, which may cause an error.
-  if (pre_scope_ == &scope && new_scope == nullptr) {
+  if (pre_scope_id_ == scope.id() && new_scope == nullptr) {
     need_prepare_data_ = false;
   }
 
@@ -72,7 +72,9 @@ constexpr char kLoadedVarSuffix[] = "@LOADED";
 /// If an Op has attribute kEnableCacheRuntimeContext, it means that in a same
 /// name scope, since the input/output names of this Op do not change in the
 /// execution, RuntimeContext could be created only at the first iteration of
-/// this Op's execution to save the elapsed time.
+/// this Op's execution to save the elapsed time. The cached RuntimeContext is
+/// created again once the variables of the scope change, see
+/// Scope::VarVersion. With FLAGS_cache_runtime_context, all Ops cache it.
 constexpr char kEnableCacheRuntimeContext[] = "@ENABLE_CACHE_RUNTIME_CONTEXT@";
 
 /// If an Op has this attribute, all its kernels should calculate output
@@ -518,16 +520,55 @@ class OperatorWithKernel : public OperatorBase {
   void ChooseKernel(const RuntimeContext& ctx, const Scope& scope,
                     const platform::Place& place) const;
 
+  /**
+   * The cached RuntimeContext, whose variables are found in scope again only
+   * if the scope or its variables change.
+   */
+  std::shared_ptr<RuntimeContext> GetRuntimeContext(const Scope& scope) const;
+
+  void InvalidateRuntimeContext() const;
+
+  /**
+   * The signature of the inputs of the last run, i.e. their data types,
+   * layouts, places, dims and LoDs, and the shapes of the outputs inferred
+   * from them. With FLAGS_cache_infer_shape, the runs with the same signature
+   * restore the shapes instead of calling InferShape, and skip PrepareData if
+   * the last run transformed no input. The ops whose variables are not all
+   * LoDTensors are not cached.
+   */
+  struct InferShapeCache {
+    bool valid{false};
+    bool transformed{false};
+    std::vector<int64_t> signature;
+    // the signature of the current run
+    std::vector<int64_t> next_signature;
+    std::vector<DDim> output_dims;
+    std::vector<LoD> output_lods;
+  };
+
+  // Returns whether the signature of the inputs matches the last run.
+  bool MatchInferShapeCache(const RuntimeContext& ctx) const;
+  void SaveInferShapeCache(const RuntimeContext& ctx, bool transformed) const;
+  void RestoreInferShapeCache(const RuntimeContext& ctx) const;
+
  protected:
   mutable std::unique_ptr<OpKernelType> kernel_type_;
   mutable std::unique_ptr<OpKernelFunc> kernel_func_;
-  mutable std::unique_ptr<RuntimeContext> runtime_ctx_;
-  mutable const Scope* pre_scope_ = nullptr;
+  mutable std::shared_ptr<RuntimeContext> runtime_ctx_;
+  // Scope::id and Scope::VarVersion of the scope runtime_ctx_ is created in.
+  // Scope ids start from 1, so 0 means runtime_ctx_ is invalid.
+  mutable uint64_t runtime_ctx_scope_id_ = 0;
+  mutable uint64_t runtime_ctx_var_version_ = 0;
+  // Scope::id of the scope of the last run
+  mutable uint64_t pre_scope_id_ = 0;
   mutable bool need_prepare_data_ = true;
   mutable bool enable_cache_runtime_context_ = false;
   mutable bool all_kernels_must_compute_runtime_shape_ = false;
   mutable std::mutex cache_update_mutex_;
   mutable bool enable_cache_transfer_scope_ = false;
+  mutable InferShapeCache infer_shape_cache_;
+  mutable bool infer_shape_cacheable_ = true;
+  mutable std::mutex infer_shape_cache_mutex_;
 };
 
 extern bool OpSupportGPU(const std::string& op_type);
@@ -18,6 +18,8 @@ limitations under the License. */
 #include "paddle/fluid/framework/operator.h"
 #include "paddle/fluid/platform/init.h"
 
+DECLARE_bool(cache_infer_shape);
+DECLARE_bool(cache_runtime_context);
 DECLARE_bool(enable_unused_var_check);
 
 namespace paddle {
@@ -746,3 +748,197 @@ TEST(OpWithoutUnusedVar, all) {
   ASSERT_NO_THROW(op->Run(scope, cpu_place));
   FLAGS_enable_unused_var_check = false;
 }
+
+namespace paddle {
+namespace framework {
+
+static const Variable* recorded_input_var = nullptr;
+static const Variable* recorded_output_var = nullptr;
+
+class OpRecordingVarsTest : public OperatorWithKernel {
+ public:
+  using OperatorWithKernel::OperatorWithKernel;
+
+ protected:
+  void InferShape(framework::InferShapeContext* ctx) const override {}
+  OpKernelType GetExpectedKernelType(
+      const ExecutionContext& ctx) const override {
+    return OpKernelType(proto::VarType::FP32, ctx.GetPlace());
+  }
+};
+
+class OpRecordingVarsTestProtoAndCheckerMaker : public OpProtoAndCheckerMaker {
+ public:
+  void Make() {
+    AddInput("X", "input of test op");
+    AddOutput("Y", "output of test op");
+    AddComment("This is test op for the cached RuntimeContext");
+  }
+};
+
+template <typename T>
+class OpRecordingVarsKernelTest : public OpKernel<T> {
+ public:
+  void Compute(const ExecutionContext& ctx) const {
+    recorded_input_var = ctx.InputVar("X");
+    recorded_output_var = ctx.OutputVar("Y");
+  }
+};
+
+}  // namespace framework
+}  // namespace paddle
+
+REGISTER_OP_WITHOUT_GRADIENT(
+    op_recording_vars, paddle::framework::OpRecordingVarsTest,
+    paddle::framework::OpRecordingVarsTestProtoAndCheckerMaker);
+
+REGISTER_OP_CPU_KERNEL(op_recording_vars,
+                       paddle::framework::OpRecordingVarsKernelTest<float>);
+
+TEST(OpWithKernel, cache_runtime_context) {
+  paddle::framework::InitDevices(true);
+  FLAGS_cache_runtime_context = true;
+  paddle::framework::proto::OpDesc op_desc;
+  op_desc.set_type("op_recording_vars");
+  BuildVar("X", {"X"}, op_desc.add_inputs());
+  BuildVar("Y", {"Y"}, op_desc.add_outputs());
+  auto op = paddle::framework::OpRegistry::CreateOp(op_desc);
+
+  paddle::platform::CPUPlace cpu_place;
+  paddle::framework::Scope scope;
+  auto* x = scope.Var("X");
+  x->GetMutable<paddle::framework::LoDTensor>();
+  op->Run(scope, cpu_place);
+  ASSERT_EQ(paddle::framework::recorded_input_var, x);
+  ASSERT_EQ(paddle::framework::recorded_output_var, nullptr);
+
+  // the created output is found
+  auto* y = scope.Var("Y");
+  op->Run(scope, cpu_place);
+  ASSERT_EQ(paddle::framework::recorded_output_var, y);
+
+  // a variable of a kid scope shadows the one of its parent
+  auto& kid = scope.NewScope();
+  op->Run(kid, cpu_place);
+  ASSERT_EQ(paddle::framework::recorded_input_var, x);
+  auto* kid_x = kid.Var("X");
+  kid_x->GetMutable<paddle::framework::LoDTensor>();
+  op->Run(kid, cpu_place);
+  ASSERT_EQ(paddle::framework::recorded_input_var, kid_x);
+
+  // erased and renamed variables are not found any more
+  kid.EraseVars({"X"});
+  op->Run(kid, cpu_place);
+  ASSERT_EQ(paddle::framework::recorded_input_var, x);
+  scope.Rename("Y", "Z");
+  op->Run(kid, cpu_place);
+  ASSERT_EQ(paddle::framework::recorded_output_var, nullptr);
+
+  // a new scope, even at the address of a dropped one, is searched again
+  scope.DropKids();
+  auto& new_kid = scope.NewScope();
+  auto* new_kid_x = new_kid.Var("X");
+  new_kid_x->GetMutable<paddle::framework::LoDTensor>();
+  op->Run(new_kid, cpu_place);
+  ASSERT_EQ(paddle::framework::recorded_input_var, new_kid_x);
+  FLAGS_cache_runtime_context = false;
+}
+
+namespace paddle {
+namespace framework {
+
+static int infer_shape_count = 0;
+
+class OpCountingInferShapeTest : public OperatorWithKernel {
+ public:
+  using OperatorWithKernel::OperatorWithKernel;
+
+ protected:
+  void InferShape(framework::InferShapeContext* ctx) const override {
+    ++infer_shape_count;
+    auto dims = ctx->GetInputDim("X");
+    dims[0] *= 2;
+    ctx->SetOutputDim("Y", dims);
+    ctx->ShareLoD("X", "Y");
+  }
+  OpKernelType GetExpectedKernelType(
+      const ExecutionContext& ctx) const override {
+    return OpKernelType(proto::VarType::FP32, ctx.GetPlace());
+  }
+};
+
+class OpCountingInferShapeTestProtoAndCheckerMaker
+    : public OpProtoAndCheckerMaker {
+ public:
+  void Make() {
+    AddInput("X", "input of test op");
+    AddOutput("Y", "output of test op, twice the rows of X");
+    AddComment("This is test op for the cached InferShape");
+  }
+};
+
+template <typename T>
+class OpCountingInferShapeKernelTest : public OpKernel<T> {
+ public:
+  void Compute(const ExecutionContext& ctx) const {
+    ctx.Output<Tensor>("Y")->mutable_data<T>(ctx.GetPlace());
+  }
+};
+
+}  // namespace framework
+}  // namespace paddle
+
+REGISTER_OP_WITHOUT_GRADIENT(
+    op_counting_infer_shape, paddle::framework::OpCountingInferShapeTest,
+    paddle::framework::OpCountingInferShapeTestProtoAndCheckerMaker);
+
+REGISTER_OP_CPU_KERNEL(
+    op_counting_infer_shape,
+    paddle::framework::OpCountingInferShapeKernelTest<float>);
+
+TEST(OpWithKernel, cache_infer_shape) {
+  paddle::framework::InitDevices(true);
+  paddle::framework::proto::OpDesc op_desc;
+  op_desc.set_type("op_counting_infer_shape");
+  BuildVar("X", {"X"}, op_desc.add_inputs());
+  BuildVar("Y", {"Y"}, op_desc.add_outputs());
+  auto op = paddle::framework::OpRegistry::CreateOp(op_desc);
+
+  paddle::platform::CPUPlace cpu_place;
+  paddle::framework::Scope scope;
+  auto* x = scope.Var("X")->GetMutable<paddle::framework::LoDTensor>();
+  auto* y = scope.Var("Y")->GetMutable<paddle::framework::LoDTensor>();
+  x->Resize({2, 3});
+  x->mutable_data<float>(cpu_place);
+
+  FLAGS_cache_infer_shape = true;
+  paddle::framework::infer_shape_count = 0;
+  op->Run(scope, cpu_place);
+  op->Run(scope, cpu_place);
+  ASSERT_EQ(paddle::framework::infer_shape_count, 1);
+  ASSERT_EQ(y->dims(), paddle::framework::make_ddim({4, 3}));
+
+  // the shape changed by another op is restored
+  y->Resize({1});
+  op->Run(scope, cpu_place);
+  ASSERT_EQ(paddle::framework::infer_shape_count, 1);
+  ASSERT_EQ(y->dims(), paddle::framework::make_ddim({4, 3}));
+
+  // a new shape or LoD of the input is inferred again
+  x->Resize({3, 3});
+  op->Run(scope, cpu_place);
+  ASSERT_EQ(paddle::framework::infer_shape_count, 2);
+  ASSERT_EQ(y->dims(), paddle::framework::make_ddim({6, 3}));
+  x->set_lod({{0, 1, 3}});
+  op->Run(scope, cpu_place);
+  op->Run(scope, cpu_place);
+  ASSERT_EQ(paddle::framework::infer_shape_count, 3);
+  y->set_lod({});
+  op->Run(scope, cpu_place);
+  ASSERT_EQ(paddle::framework::infer_shape_count, 3);
+  ASSERT_EQ(y->lod(), x->lod());
+
+  FLAGS_cache_infer_shape = false;
+  op->Run(scope, cpu_place);
+  ASSERT_EQ(paddle::framework::infer_shape_count, 4);
+}
@@ -0,0 +1,379 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/record_arena.h"
+#include <stdlib.h>
+#include <mutex>  // NOLINT
+#include <vector>
+
+namespace paddle {
+namespace framework {
+
+namespace {
+
+// classes of every 16 bytes up to 4KB, then 16 classes per power of two
+constexpr int kClassNum = 256 + 16 * 4;
+// sizes larger than kMaxClassSize are rounded up to pages
+constexpr size_t kPageSize = 4096;
+// a thread caches at most this many bytes of a class
+constexpr size_t kThreadCacheBytes = 32 << 10;
+
+inline int SizeClass(size_t size) {
+  if (size <= 4096) {
+    return size == 0 ? 0 : static_cast<int>((size - 1) / 16);
+  }
+  int shift = 12;
+  while ((static_cast<size_t>(2) << shift) < size) {
+    ++shift;
+  }
+  size_t base = static_cast<size_t>(1) << shift;
+  return 256 + (shift - 12) * 16 +
+         static_cast<int>((size - 1 - base) / (base / 16));
+}
+
+inline size_t ClassSize(int cls) {
+  if (cls < 256) {
+    return (cls + 1) * 16;
+  }
+  size_t base = static_cast<size_t>(1) << (12 + (cls - 256) / 16);
+  return base + ((cls - 256) % 16 + 1) * (base / 16);
+}
+
+struct FreeBlock {
+  FreeBlock* next;
+};
+
+std::atomic<size_t> g_system_bytes{0};
+
+void* SystemAlloc(size_t size) {
+  void* ptr = malloc(size);
+  PADDLE_ENFORCE_NOT_NULL(
+      ptr, platform::errors::ResourceExhausted(
+               "Failed to allocate %d bytes for records.", size));
+  g_system_bytes.fetch_add(size, std::memory_order_relaxed);
+  return ptr;
+}
+
+void SystemFree(void* ptr, size_t size) {
+  free(ptr);
+  g_system_bytes.fetch_sub(size, std::memory_order_relaxed);
+}
+
+// Blocks flushed from the thread caches.
+class GlobalCache {
+ public:
+  static GlobalCache* Instance() {
+    // never destroyed, records may be freed by static destructors
+    static GlobalCache* cache = new GlobalCache();
+    return cache;
+  }
+
+  // Move up to max_num blocks of class cls to *list.
+  size_t Get(int cls, size_t max_num, FreeBlock** list) {
+    std::lock_guard<std::mutex> lock(lists_[cls].mutex);
+    size_t num = 0;
+    while (num < max_num && lists_[cls].head != nullptr) {
+      FreeBlock* block = lists_[cls].head;
+      lists_[cls].head = block->next;
+      block->next = *list;
+      *list = block;
+      ++num;
+    }
+    return num;
+  }
+
+  void Put(int cls, FreeBlock* head, FreeBlock* tail) {
+    std::lock_guard<std::mutex> lock(lists_[cls].mutex);
+    tail->next = lists_[cls].head;
+    lists_[cls].head = head;
+  }
+
+  void Trim() {
+    for (int cls = 0; cls < kClassNum; ++cls) {
+      FreeBlock* head = nullptr;
+      {
+        std::lock_guard<std::mutex> lock(lists_[cls].mutex);
+        std::swap(head, lists_[cls].head);
+      }
+      while (head != nullptr) {
+        FreeBlock* next = head->next;
+        SystemFree(head, ClassSize(cls));
+        head = next;
+      }
+    }
+  }
+
+ private:
+  struct List {
+    std::mutex mutex;
+    FreeBlock* head{nullptr};
+  };
+  List lists_[kClassNum];
+};
+
+class ThreadCache {
+ public:
+  ThreadCache() {
+    for (int cls = 0; cls < kClassNum; ++cls) {
+      lists_[cls] = nullptr;
+      nums_[cls] = 0;
+      max_nums_[cls] = std::max<size_t>(kThreadCacheBytes / ClassSize(cls), 8);
+    }
+  }
+
+  ~ThreadCache() {
+    FlushAll();
+    destroyed_ = true;
+  }
+
+  void FlushAll() {
+    for (int cls = 0; cls < kClassNum; ++cls) {
+      Flush(cls, nums_[cls]);
+    }
+  }
+
+  void* Alloc(int cls) {
+    if (lists_[cls] == nullptr) {
+      nums_[cls] +=
+          GlobalCache::Instance()->Get(cls, max_nums_[cls] / 2, &lists_[cls]);
+      if (lists_[cls] == nullptr) {
+        return SystemAlloc(ClassSize(cls));
+      }
+    }
+    FreeBlock* block = lists_[cls];
+    lists_[cls] = block->next;
+    --nums_[cls];
+    return block;
+  }
+
+  void Free(int cls, void* ptr) {
+    FreeBlock* block = static_cast<FreeBlock*>(ptr);
+    block->next = lists_[cls];
+    lists_[cls] = block;
+    if (++nums_[cls] > max_nums_[cls]) {
+      Flush(cls, nums_[cls] / 2);
+    }
+  }
+
+  static bool Destroyed() { return destroyed_; }
+
+ private:
+  void Flush(int cls, size_t num) {
+    if (num == 0) {
+      return;
+    }
+    FreeBlock* head = lists_[cls];
+    FreeBlock* tail = head;
+    for (size_t i = 1; i < num; ++i) {
+      tail = tail->next;
+    }
+    lists_[cls] = tail->next;
+    nums_[cls] -= num;
+    GlobalCache::Instance()->Put(cls, head, tail);
+  }
+
+  FreeBlock* lists_[kClassNum];
+  size_t nums_[kClassNum];
+  size_t max_nums_[kClassNum];
+  static thread_local bool destroyed_;
+};
+
+thread_local bool ThreadCache::destroyed_ = false;
+
+ThreadCache* GetThreadCache() {
+  static thread_local ThreadCache cache;
+  return ThreadCache::Destroyed() ? nullptr : &cache;
+}
+
+}  // namespace
+
+constexpr size_t RecordArena::kMaxClassSize;
+
+size_t RecordArena::BlockSize(size_t size) {
+  if (size > kMaxClassSize) {
+    return (size + kPageSize - 1) / kPageSize * kPageSize;
+  }
+  return ClassSize(SizeClass(size));
+}
+
+void* RecordArena::Alloc(size_t size) {
+  if (size > kMaxClassSize) {
+    return SystemAlloc(BlockSize(size));
+  }
+  int cls = SizeClass(size);
+  ThreadCache* cache = GetThreadCache();
+  if (cache == nullptr) {
+    return SystemAlloc(ClassSize(cls));
+  }
+  return cache->Alloc(cls);
+}
+
+void RecordArena::Free(void* ptr, size_t size) {
+  if (size > kMaxClassSize) {
+    SystemFree(ptr, BlockSize(size));
+    return;
+  }
+  int cls = SizeClass(size);
+  ThreadCache* cache = GetThreadCache();
+  if (cache == nullptr) {
+    FreeBlock* block = static_cast<FreeBlock*>(ptr);
+    GlobalCache::Instance()->Put(cls, block, block);
+    return;
+  }
+  cache->Free(cls, ptr);
+}
+
+void RecordArena::Trim() {
+  ThreadCache* cache = GetThreadCache();
+  if (cache != nullptr) {
+    cache->FlushAll();
+  }
+  GlobalCache::Instance()->Trim();
+}
+
+size_t RecordArena::SystemBytes() {
+  return g_system_bytes.load(std::memory_order_relaxed);
+}
+
+namespace {
+
+constexpr int kShardNum = 64;
+
+uint64_t HashString(const char* str, size_t len) {
+  // FNV-1a
+  uint64_t hash = 14695981039346656037ULL;
+  for (size_t i = 0; i < len; ++i) {
+    hash ^= static_cast<unsigned char>(str[i]);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+inline size_t EntrySize(size_t len) {
+  return offsetof(InternedStringEntry, data) + len + 1;
+}
+
+// A shard of the intern table, chaining the entries in their next field.
+class InternShard {
+ public:
+  InternedStringEntry* Intern(const char* str, size_t len, uint64_t hash) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!buckets_.empty()) {
+      for (auto* entry = buckets_[hash & (buckets_.size() - 1)];
+           entry != nullptr; entry = entry->next) {
+        if (entry->hash == hash && entry->size == len &&
+            memcmp(entry->data, str, len) == 0) {
+          entry->ref.fetch_add(1, std::memory_order_relaxed);
+          return entry;
+        }
+      }
+    }
+    if (size_ >= buckets_.size()) {
+      Rehash(std::max<size_t>(buckets_.size() * 2, 64));
+    }
+    auto* entry =
+        static_cast<InternedStringEntry*>(RecordArena::Alloc(EntrySize(len)));
+    entry->hash = hash;
+    new (&entry->ref) std::atomic<uint32_t>(1);
+    entry->size = static_cast<uint32_t>(len);
+    memcpy(entry->data, str, len);
+    entry->data[len] = '\0';
+    auto& bucket = buckets_[hash & (buckets_.size() - 1)];
+    entry->next = bucket;
+    bucket = entry;
+    ++size_;
+    return entry;
+  }
+
+  // Entries in the table always have a positive reference count, which is
+  // only decreased to zero with the lock held.
+  void Release(InternedStringEntry* entry) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (entry->ref.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+      return;
+    }
+    auto* prev = &buckets_[entry->hash & (buckets_.size() - 1)];
+    while (*prev != entry) {
+      prev = &(*prev)->next;
+    }
+    *prev = entry->next;
+    --size_;
+    RecordArena::Free(entry, EntrySize(entry->size));
+  }
+
+  size_t Size() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return size_;
+  }
+
+ private:
+  void Rehash(size_t bucket_num) {
+    std::vector<InternedStringEntry*> buckets(bucket_num, nullptr);
+    for (auto* entry : buckets_) {
+      while (entry != nullptr) {
+        auto* next = entry->next;
+        auto& bucket = buckets[entry->hash & (bucket_num - 1)];
+        entry->next = bucket;
+        bucket = entry;
+        entry = next;
+      }
+    }
+    buckets_.swap(buckets);
+  }
+
+  std::mutex mutex_;
+  std::vector<InternedStringEntry*> buckets_;
+  size_t size_{0};
+};
+
+InternShard* GetInternShards() {
+  // never destroyed, records may be freed by static destructors
+  static InternShard* shards = new InternShard[kShardNum];
+  return shards;
+}
+
+}  // namespace
+
+InternedStringEntry* InternedString::Intern(const char* str, size_t len) {
+  if (len == 0) {
+    return nullptr;
+  }
+  uint64_t hash = HashString(str, len);
+  return GetInternShards()[hash >> 58].Intern(str, len, hash);
+}
+
+void InternedString::Release(InternedStringEntry* entry) {
+  if (entry == nullptr) {
+    return;
+  }
+  uint32_t ref = entry->ref.load(std::memory_order_relaxed);
+  while (ref > 1) {
+    if (entry->ref.compare_exchange_weak(ref, ref - 1,
+                                         std::memory_order_acq_rel)) {
+      return;
+    }
+  }
+  GetInternShards()[entry->hash >> 58].Release(entry);
+}
+
+size_t InternedString::InternedNum() {
+  size_t num = 0;
+  for (int i = 0; i < kShardNum; ++i) {
+    num += GetInternShards()[i].Size();
+  }
+  return num;
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,348 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace framework {
+
+// RecordArena allocates the variable-length parts of Record, i.e. the
+// feasigns which overflow the inline storage of ArenaVector and the
+// entries of InternedString.
+//
+// Sizes are rounded up to size classes, which are 16 bytes apart up to 4KB and
+// 16 per power of two above, so the rounding wastes few bytes. Freed
+// blocks are cached by the freeing thread and then in global lists, so the
+// records parsed, moved through channels, shuffled and destroyed pass after
+// pass reuse the same blocks instead of calling malloc and free. Blocks
+// larger than kMaxClassSize are allocated from the system directly.
+class RecordArena {
+ public:
+  static constexpr size_t kMaxClassSize = 64 << 10;
+
+  static void* Alloc(size_t size);
+  // size may be any size whose BlockSize is the size of the block.
+  static void Free(void* ptr, size_t size);
+  // Size of the block allocated for size bytes.
+  static size_t BlockSize(size_t size);
+
+  // Return the blocks cached in the global lists and by the calling thread to
+  // the system, e.g. after the memory data of a dataset is released.
+  static void Trim();
+  // Bytes allocated from the system and not returned yet.
+  static size_t SystemBytes();
+};
+
+// A vector of trivially copyable items which stores up to N items inline and
+// the rest in a block of RecordArena. Moving it never allocates.
+template <typename T, size_t N>
+class ArenaVector {
+  static_assert(N > 0, "N must be larger than 0");
+  // BlockSize of capacity() * sizeof(T) is the size of the block only when
+  // sizeof(T) is not larger than the minimum size class step.
+  static_assert(sizeof(T) <= 16, "ArenaVector is for small items");
+
+ public:
+  typedef T value_type;
+  typedef T& reference;
+  typedef const T& const_reference;
+  typedef T* iterator;
+  typedef const T* const_iterator;
+  typedef size_t size_type;
+
+  ArenaVector() : size_(0), capacity_(N) {}
+  ArenaVector(const ArenaVector& other) : size_(0), capacity_(N) {
+    assign(other.begin(), other.end());
+  }
+  ArenaVector(ArenaVector&& other) noexcept : size_(0), capacity_(N) {
+    Steal(&other);
+  }
+  ~ArenaVector() { ReleaseBlock(); }
+
+  ArenaVector& operator=(const ArenaVector& other) {
+    if (this != &other) {
+      assign(other.begin(), other.end());
+    }
+    return *this;
+  }
+  ArenaVector& operator=(ArenaVector&& other) noexcept {
+    if (this != &other) {
+      ReleaseBlock();
+      Steal(&other);
+    }
+    return *this;
+  }
+
+  T* data() { return IsInline() ? InlineData() : heap_; }
+  const T* data() const { return IsInline() ? InlineData() : heap_; }
+  iterator begin() { return data(); }
+  iterator end() { return data() + size_; }
+  const_iterator begin() const { return data(); }
+  const_iterator end() const { return data() + size_; }
+
+  size_t size() const { return size_; }
+  size_t capacity() const { return capacity_; }
+  bool empty() const { return size_ == 0; }
+
+  T& operator[](size_t i) { return data()[i]; }
+  const T& operator[](size_t i) const { return data()[i]; }
+  T& front() { return data()[0]; }
+  const T& front() const { return data()[0]; }
+  T& back() { return data()[size_ - 1]; }
+  const T& back() const { return data()[size_ - 1]; }
+
+  void clear() { size_ = 0; }
+
+  void reserve(size_t n) {
+    if (n > capacity_) {
+      Reallocate(n);
+    }
+  }
+
+  void resize(size_t n) { resize(n, T()); }
+  void resize(size_t n, const T& value) {
+    reserve(n);
+    std::fill(data() + std::min<size_t>(size_, n), data() + n, value);
+    size_ = static_cast<uint32_t>(n);
+  }
+
+  void push_back(const T& value) {
+    if (UNLIKELY(size_ == capacity_)) {
+      T copy = value;  // value may be an item of this vector
+      Reallocate(static_cast<size_t>(capacity_) * 2);
+      data()[size_++] = copy;
+    } else {
+      data()[size_++] = value;
+    }
+  }
+
+  template <typename... Args>
+  void emplace_back(Args&&... args) {
+    push_back(T(std::forward<Args>(args)...));
+  }
+
+  void pop_back() { --size_; }
+
+  template <typename InputIt>
+  void assign(InputIt first, InputIt last) {
+    size_ = 0;
+    reserve(std::distance(first, last));
+    insert(end(), first, last);
+  }
+
+  iterator insert(const_iterator pos, const T& value) {
+    return insert(pos, &value, &value + 1);
+  }
+
+  // first and last must not point into this vector.
+  template <typename InputIt>
+  iterator insert(const_iterator pos, InputIt first, InputIt last) {
+    size_t offset = pos - begin();
+    size_t n = std::distance(first, last);
+    if (size_ + n > capacity_) {
+      Reallocate(std::max(size_ + n, static_cast<size_t>(capacity_) * 2));
+    }
+    T* p = data() + offset;
+    memmove(p + n, p, (size_ - offset) * sizeof(T));
+    std::copy(first, last, p);
+    size_ += static_cast<uint32_t>(n);
+    return p;
+  }
+
+  iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+  iterator erase(const_iterator first, const_iterator last) {
+    T* p = data() + (first - begin());
+    size_t n = last - first;
+    memmove(p, p + n, (end() - p - n) * sizeof(T));
+    size_ -= static_cast<uint32_t>(n);
+    return p;
+  }
+
+  // Move the items inline, or into the smallest block holding them.
+  void shrink_to_fit() {
+    if (IsInline()) {
+      return;
+    }
+    if (size_ <= N) {
+      T* block = heap_;
+      size_t capacity = capacity_;
+      memcpy(InlineData(), block, size_ * sizeof(T));
+      capacity_ = N;
+      RecordArena::Free(block, capacity * sizeof(T));
+    } else if (RecordArena::BlockSize(size_ * sizeof(T)) <
+               RecordArena::BlockSize(capacity_ * sizeof(T))) {
+      Reallocate(size_);
+    }
+  }
+
+ private:
+  bool IsInline() const { return capacity_ == N; }
+  T* InlineData() { return reinterpret_cast<T*>(&inline_); }
+  const T* InlineData() const { return reinterpret_cast<const T*>(&inline_); }
+
+  void Reallocate(size_t n) {
+    size_t bytes = RecordArena::BlockSize(n * sizeof(T));
+    T* block = static_cast<T*>(RecordArena::Alloc(bytes));
+    memcpy(block, data(), size_ * sizeof(T));
+    ReleaseBlock();
+    heap_ = block;
+    capacity_ = static_cast<uint32_t>(bytes / sizeof(T));
+  }
+
+  void ReleaseBlock() {
+    if (!IsInline()) {
+      RecordArena::Free(heap_, capacity_ * sizeof(T));
+      capacity_ = N;
+    }
+  }
+
+  void Steal(ArenaVector* other) {
+    if (other->IsInline()) {
+      memcpy(InlineData(), other->InlineData(), other->size_ * sizeof(T));
+    } else {
+      heap_ = other->heap_;
+      capacity_ = other->capacity_;
+      other->capacity_ = N;
+    }
+    size_ = other->size_;
+    other->size_ = 0;
+  }
+
+  uint32_t size_;
+  // capacity_ == N iff the items are stored inline
+  uint32_t capacity_;
+  union {
+    T* heap_;
+    typename std::aligned_storage<sizeof(T) * N, alignof(T)>::type inline_;
+  };
+};
+
+struct InternedStringEntry {
+  InternedStringEntry* next;
+  uint64_t hash;
+  std::atomic<uint32_t> ref;
+  uint32_t size;
+  char data[1];
+};
+
+// A string interned in a global table, so equal strings share one entry of
+// RecordArena. Copying it only increases the reference count of the entry,
+// moving it never allocates, and the empty string has no entry at all.
+//
+// Record stores ins_id and content as InternedString: the records merged by
+// ins_id share their ins_id, and most records share an empty content.
+class InternedString {
+ public:
+  InternedString() : entry_(nullptr) {}
+  InternedString(const char* str, size_t len) : entry_(Intern(str, len)) {}
+  InternedString(const std::string& str)  // NOLINT
+      : entry_(Intern(str.data(), str.size())) {}
+  InternedString(const char* str)  // NOLINT
+      : entry_(Intern(str, strlen(str))) {}
+  InternedString(const InternedString& other) : entry_(other.entry_) {
+    if (entry_ != nullptr) {
+      entry_->ref.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  InternedString(InternedString&& other) noexcept : entry_(other.entry_) {
+    other.entry_ = nullptr;
+  }
+  ~InternedString() { Release(entry_); }
+
+  InternedString& operator=(const InternedString& other) {
+    if (entry_ != other.entry_) {
+      InternedString(other).swap(*this);
+    }
+    return *this;
+  }
+  InternedString& operator=(InternedString&& other) noexcept {
+    if (this != &other) {
+      Release(entry_);
+      entry_ = other.entry_;
+      other.entry_ = nullptr;
+    }
+    return *this;
+  }
+  InternedString& operator=(const std::string& str) {
+    assign(str.data(), str.size());
+    return *this;
+  }
+  InternedString& operator=(const char* str) {
+    assign(str, strlen(str));
+    return *this;
+  }
+
+  void assign(const char* str, size_t len) {
+    InternedStringEntry* entry = Intern(str, len);
+    Release(entry_);
+    entry_ = entry;
+  }
+  void clear() {
+    Release(entry_);
+    entry_ = nullptr;
+  }
+  void swap(InternedString& other) { std::swap(entry_, other.entry_); }
+
+  const char* data() const { return entry_ == nullptr ? "" : entry_->data; }
+  const char* c_str() const { return data(); }
+  size_t size() const { return entry_ == nullptr ? 0 : entry_->size; }
+  size_t length() const { return size(); }
+  bool empty() const { return entry_ == nullptr; }
+
+  std::string str() const { return std::string(data(), size()); }
+  operator std::string() const { return str(); }  // NOLINT
+
+  // Equal strings are interned into the same entry.
+  friend bool operator==(const InternedString& a, const InternedString& b) {
+    return a.entry_ == b.entry_;
+  }
+  friend bool operator!=(const InternedString& a, const InternedString& b) {
+    return a.entry_ != b.entry_;
+  }
+  friend bool operator<(const InternedString& a, const InternedString& b) {
+    if (a.entry_ == b.entry_) {
+      return false;
+    }
+    int ret = memcmp(a.data(), b.data(), std::min(a.size(), b.size()));
+    return ret < 0 || (ret == 0 && a.size() < b.size());
+  }
+
+  // Number of distinct strings interned now.
+  static size_t InternedNum();
+
+ private:
+  static InternedStringEntry* Intern(const char* str, size_t len);
+  static void Release(InternedStringEntry* entry);
+
+  InternedStringEntry* entry_;
+};
+
+inline std::ostream& operator<<(std::ostream& os, const InternedString& s) {
+  return os.write(s.data(), s.size());
+}
+
+}  // namespace framework
+}  // namespace paddle
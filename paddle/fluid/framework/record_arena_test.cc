@@ -0,0 +1,185 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/record_arena.h"
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+namespace paddle {
+namespace framework {
+
+TEST(RecordArena, block_size) {
+  EXPECT_EQ(RecordArena::BlockSize(1), 16UL);
+  EXPECT_EQ(RecordArena::BlockSize(16), 16UL);
+  EXPECT_EQ(RecordArena::BlockSize(17), 32UL);
+  EXPECT_EQ(RecordArena::BlockSize(64), 64UL);
+  EXPECT_EQ(RecordArena::BlockSize(65), 80UL);
+  EXPECT_EQ(RecordArena::BlockSize(1000), 1008UL);
+  EXPECT_EQ(RecordArena::BlockSize(1024), 1024UL);
+  EXPECT_EQ(RecordArena::BlockSize(1025), 1040UL);
+  EXPECT_EQ(RecordArena::BlockSize(4097), 4352UL);
+  EXPECT_EQ(RecordArena::BlockSize(RecordArena::kMaxClassSize),
+            RecordArena::kMaxClassSize);
+  EXPECT_EQ(RecordArena::BlockSize(RecordArena::kMaxClassSize + 1),
+            RecordArena::kMaxClassSize + 4096);
+  for (size_t size = 1; size < 100000; size += 7) {
+    size_t block_size = RecordArena::BlockSize(size);
+    EXPECT_GE(block_size, size);
+    EXPECT_EQ(RecordArena::BlockSize(block_size), block_size);
+  }
+}
+
+TEST(RecordArena, reuse_blocks) {
+  void* ptr = RecordArena::Alloc(100);
+  RecordArena::Free(ptr, 100);
+  size_t system_bytes = RecordArena::SystemBytes();
+  // the cached block is reused
+  EXPECT_EQ(RecordArena::Alloc(110), ptr);
+  RecordArena::Free(ptr, 110);
+  EXPECT_EQ(RecordArena::SystemBytes(), system_bytes);
+
+  // blocks freed by another thread are reused after the thread exits
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 10000; ++i) {
+    ptrs.push_back(RecordArena::Alloc(1000));
+  }
+  system_bytes = RecordArena::SystemBytes();
+  std::thread th([&ptrs] {
+    for (void* p : ptrs) {
+      RecordArena::Free(p, 1000);
+    }
+  });
+  th.join();
+  for (int i = 0; i < 10000; ++i) {
+    ptrs[i] = RecordArena::Alloc(1000);
+  }
+  EXPECT_EQ(RecordArena::SystemBytes(), system_bytes);
+  for (void* p : ptrs) {
+    RecordArena::Free(p, 1000);
+  }
+}
+
+TEST(ArenaVector, push_and_erase) {
+  ArenaVector<uint64_t, 3> vec;
+  EXPECT_EQ(vec.capacity(), 3UL);
+  for (uint64_t i = 0; i < 100; ++i) {
+    vec.push_back(i);
+  }
+  ASSERT_EQ(vec.size(), 100UL);
+  for (uint64_t i = 0; i < 100; ++i) {
+    EXPECT_EQ(vec[i], i);
+  }
+  // erase the odd numbers
+  for (auto it = vec.begin(); it != vec.end();) {
+    if (*it % 2 == 1) {
+      it = vec.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  ASSERT_EQ(vec.size(), 50UL);
+  std::vector<uint64_t> tail = {1, 3};
+  vec.insert(vec.begin() + 1, tail.begin(), tail.end());
+  EXPECT_EQ(vec[0], 0UL);
+  EXPECT_EQ(vec[1], 1UL);
+  EXPECT_EQ(vec[2], 3UL);
+  EXPECT_EQ(vec[3], 2UL);
+  EXPECT_EQ(vec.back(), 98UL);
+
+  vec.resize(2);
+  vec.shrink_to_fit();
+  EXPECT_EQ(vec.capacity(), 3UL);
+  EXPECT_EQ(vec[1], 1UL);
+  vec.resize(5, 7);
+  EXPECT_EQ(vec[4], 7UL);
+}
+
+TEST(ArenaVector, copy_and_move) {
+  ArenaVector<uint64_t, 3> small;
+  small.push_back(1);
+  ArenaVector<uint64_t, 3> large;
+  for (uint64_t i = 0; i < 10; ++i) {
+    large.push_back(i);
+  }
+  const uint64_t* data = large.data();
+
+  ArenaVector<uint64_t, 3> copied(large);
+  EXPECT_NE(copied.data(), data);
+  EXPECT_EQ(copied.size(), 10UL);
+
+  // moving does not allocate
+  ArenaVector<uint64_t, 3> moved(std::move(large));
+  EXPECT_EQ(moved.data(), data);
+  EXPECT_TRUE(large.empty());  // NOLINT
+  moved = std::move(small);
+  EXPECT_EQ(moved.size(), 1UL);
+  EXPECT_EQ(moved[0], 1UL);
+  EXPECT_EQ(moved.capacity(), 3UL);
+}
+
+TEST(InternedString, intern) {
+  size_t num = InternedString::InternedNum();
+  InternedString a("ins_0");
+  InternedString b(std::string("ins_0"));
+  InternedString c("ins_1", 5);
+  EXPECT_EQ(a, b);
+  EXPECT_EQ(a.data(), b.data());
+  EXPECT_NE(a, c);
+  EXPECT_TRUE(a < c);
+  EXPECT_FALSE(c < a);
+  EXPECT_EQ(InternedString::InternedNum(), num + 2);
+
+  InternedString empty;
+  EXPECT_TRUE(empty.empty());
+  EXPECT_EQ(empty, InternedString(""));
+  EXPECT_TRUE(empty < a);
+  EXPECT_EQ(std::string(empty), "");
+
+  std::string str = c;
+  EXPECT_EQ(str, "ins_1");
+  a = c;
+  b.clear();
+  // "ins_0" is released
+  EXPECT_EQ(InternedString::InternedNum(), num + 1);
+  EXPECT_EQ(std::string(a.c_str()), "ins_1");
+}
+
+TEST(InternedString, multi_thread) {
+  size_t num = InternedString::InternedNum();
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([] {
+      std::vector<InternedString> strs;
+      for (int round = 0; round < 10; ++round) {
+        for (int i = 0; i < 1000; ++i) {
+          strs.emplace_back("ins_" + std::to_string(i));
+        }
+        for (int i = 0; i < 1000; ++i) {
+          ASSERT_EQ(strs[i], InternedString("ins_" + std::to_string(i)));
+        }
+        strs.clear();
+      }
+    });
+  }
+  for (auto& th : threads) {
+    th.join();
+  }
+  EXPECT_EQ(InternedString::InternedNum(), num);
+}
+
+}  // namespace framework
+}  // namespace paddle
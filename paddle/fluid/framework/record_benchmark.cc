@@ -0,0 +1,294 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Memory and parse benchmark of Record against the former layout of it, which
+// stored feasigns in std::vector and ins_id and content in std::string.
+// Text lines in the format read by MultiSlotInMemoryDataFeed with ins_id and
+// content are parsed into records, which are then moved through a channel.
+// Each layout runs in a child process, so that their resident memory is
+// measured separately.
+//
+// Usage:
+//   ./record_benchmark --ins_num=1000000 --slot_num=50 --feasign_per_slot=2
+
+#ifdef __linux__
+#include <malloc.h>
+#endif
+#include <sys/wait.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/channel.h"
+#include "paddle/fluid/framework/data_feed.h"
+
+DEFINE_int32(ins_num, 1000000, "Number of instances.");
+DEFINE_int32(slot_num, 50, "Number of uint64 slots of an instance.");
+DEFINE_int32(float_slot_num, 1, "Number of float slots of an instance.");
+DEFINE_int32(feasign_per_slot, 2, "Average number of feasigns of a slot.");
+DEFINE_int32(ins_per_id, 1, "Number of instances sharing an ins_id.");
+DEFINE_int32(passes, 2,
+             "Passes of parsing, moving and freeing the records. Memory is "
+             "measured in the first pass, and the rest in the last pass, which "
+             "reuses the memory freed by the former passes.");
+DEFINE_string(layout, "both", "legacy, arena or both.");
+
+#ifdef __GLIBC__
+// count the calls of malloc, which std::allocator and RecordArena both call
+static std::atomic<size_t> g_malloc_num{0};
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* malloc(size_t size) {
+  g_malloc_num.fetch_add(1, std::memory_order_relaxed);
+  return __libc_malloc(size);
+}
+static size_t MallocNum() { return g_malloc_num.load(); }
+#else
+static size_t MallocNum() { return 0; }
+#endif
+
+namespace paddle {
+namespace framework {
+
+// The former layout of Record.
+struct LegacyRecord {
+  std::vector<FeatureItem> uint64_feasigns_;
+  std::vector<FeatureItem> float_feasigns_;
+  std::string ins_id_;
+  std::string content_;
+  uint64_t search_id;
+  uint32_t rank;
+  uint32_t cmatch;
+};
+
+static std::vector<std::string> GenerateLines() {
+  std::default_random_engine engine(0);
+  std::uniform_int_distribution<int> num_dist(1,
+                                              FLAGS_feasign_per_slot * 2 - 1);
+  std::uniform_int_distribution<uint64_t> sign_dist(1, 1ULL << 60);
+  std::vector<std::string> lines;
+  lines.reserve(FLAGS_ins_num);
+  for (int i = 0; i < FLAGS_ins_num; ++i) {
+    std::string line = "1 ins_id_" +
+                       std::to_string(1000000000000LL +
+                                      i / std::max(FLAGS_ins_per_id, 1)) +
+                       " 1 - ";
+    for (int s = 0; s < FLAGS_float_slot_num; ++s) {
+      line += "1 0.5 ";
+    }
+    for (int s = 0; s < FLAGS_slot_num; ++s) {
+      int num = FLAGS_feasign_per_slot <= 1 ? 1 : num_dist(engine);
+      line += std::to_string(num);
+      for (int j = 0; j < num; ++j) {
+        line += " " + std::to_string(sign_dist(engine));
+      }
+      line += " ";
+    }
+    lines.push_back(std::move(line));
+  }
+  return lines;
+}
+
+static void ParseString(const char* str, int* pos, InternedString* out) {
+  char* endptr = nullptr;
+  strtol(str + *pos, &endptr, 10);
+  *pos = endptr - str + 1;
+  size_t len = 0;
+  while (str[*pos + len] != ' ') {
+    ++len;
+  }
+  out->assign(str + *pos, len);
+  *pos += len + 1;
+}
+
+static void ParseString(const char* str, int* pos, std::string* out) {
+  char* endptr = nullptr;
+  strtol(str + *pos, &endptr, 10);
+  *pos = endptr - str + 1;
+  size_t len = 0;
+  while (str[*pos + len] != ' ') {
+    ++len;
+  }
+  *out = std::string(str + *pos, len);
+  *pos += len + 1;
+}
+
+// The parsing of MultiSlotInMemoryDataFeed::ParseOneInstanceFromPipe.
+template <typename Vector>
+static void ParseFeasigns(const char* str, int pos, Vector* uint64_feasigns,
+                          Vector* float_feasigns) {
+  char* endptr = const_cast<char*>(str);
+  int slot_num = FLAGS_float_slot_num + FLAGS_slot_num;
+  for (int i = 0; i < slot_num; ++i) {
+    int num = strtol(&str[pos], &endptr, 10);
+    uint16_t slot = static_cast<uint16_t>(i);
+    if (i < FLAGS_float_slot_num) {
+      for (int j = 0; j < num; ++j) {
+        FeatureKey f;
+        f.float_feasign_ = strtof(endptr, &endptr);
+        float_feasigns->push_back(FeatureItem(f, slot));
+      }
+    } else {
+      for (int j = 0; j < num; ++j) {
+        FeatureKey f;
+        f.uint64_feasign_ = strtoull(endptr, &endptr, 10);
+        uint64_feasigns->push_back(FeatureItem(f, slot));
+      }
+    }
+    pos = endptr - str;
+  }
+}
+
+// The former parsing pushed feasigns into the instance.
+static void ParseLine(const char* str, LegacyRecord* rec) {
+  int pos = 0;
+  ParseString(str, &pos, &rec->ins_id_);
+  ParseString(str, &pos, &rec->content_);
+  ParseFeasigns(str, pos, &rec->uint64_feasigns_, &rec->float_feasigns_);
+  rec->float_feasigns_.shrink_to_fit();
+  rec->uint64_feasigns_.shrink_to_fit();
+}
+
+static void ParseLine(const char* str, Record* rec) {
+  thread_local std::vector<FeatureItem> uint64_feasigns;
+  thread_local std::vector<FeatureItem> float_feasigns;
+  uint64_feasigns.clear();
+  float_feasigns.clear();
+  int pos = 0;
+  ParseString(str, &pos, &rec->ins_id_);
+  ParseString(str, &pos, &rec->content_);
+  ParseFeasigns(str, pos, &uint64_feasigns, &float_feasigns);
+  rec->float_feasigns_.insert(rec->float_feasigns_.end(),
+                              float_feasigns.begin(), float_feasigns.end());
+  rec->uint64_feasigns_.insert(rec->uint64_feasigns_.end(),
+                               uint64_feasigns.begin(), uint64_feasigns.end());
+}
+
+static size_t ResidentBytes() {
+  FILE* fp = fopen("/proc/self/statm", "r");
+  CHECK(fp != nullptr);
+  size_t size = 0, resident = 0;
+  int ret = fscanf(fp, "%zu %zu", &size, &resident);
+  fclose(fp);
+  CHECK_EQ(ret, 2);
+  return resident * sysconf(_SC_PAGESIZE);
+}
+
+static double Seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+template <typename R>
+static void RunBenchmark(const std::string& name,
+                         const std::vector<std::string>& lines) {
+  size_t text_bytes = 0;
+  for (auto& line : lines) {
+    text_bytes += line.size() + 1;
+  }
+  double million = FLAGS_ins_num / 1e6;
+
+#ifdef __linux__
+  malloc_trim(0);
+#endif
+  size_t memory = 0;
+  double parse_seconds = 0, move_seconds = 0, free_seconds = 0;
+  size_t parse_malloc_num = 0, move_malloc_num = 0;
+  for (int pass = 0; pass < FLAGS_passes; ++pass) {
+    size_t resident = ResidentBytes();
+    size_t malloc_num = MallocNum();
+    auto start = std::chrono::steady_clock::now();
+    std::vector<R> records(lines.size());
+    R rec;
+    for (size_t i = 0; i < lines.size(); ++i) {
+      ParseLine(lines[i].c_str(), &rec);
+      records[i] = std::move(rec);
+      rec = R();
+    }
+    parse_seconds = Seconds(start);
+    parse_malloc_num = MallocNum() - malloc_num;
+    if (pass == 0) {
+      memory = ResidentBytes() - resident;
+    }
+
+    // move the records through a channel and back, as DatasetImpl does
+    auto chan = MakeChannel<R>();
+    chan->SetBlockSize(1024);
+    malloc_num = MallocNum();
+    start = std::chrono::steady_clock::now();
+    chan->Write(std::move(records));
+    chan->Close();
+    std::vector<R> moved;
+    chan->ReadAll(moved);
+    move_seconds = Seconds(start);
+    move_malloc_num = MallocNum() - malloc_num;
+
+    start = std::chrono::steady_clock::now();
+    std::vector<R>().swap(moved);
+    free_seconds = Seconds(start);
+  }
+
+  std::cout << name << "\t" << sizeof(R) << "\t"
+            << memory / million / (1 << 20) << "\t"
+            << FLAGS_ins_num / parse_seconds / 1e6 << "\t"
+            << text_bytes / parse_seconds / (1 << 20) << "\t"
+            << parse_malloc_num / static_cast<double>(FLAGS_ins_num) << "\t"
+            << move_seconds << "\t"
+            << move_malloc_num / static_cast<double>(FLAGS_ins_num) << "\t"
+            << free_seconds << std::endl;
+}
+
+}  // namespace framework
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+
+  auto lines = paddle::framework::GenerateLines();
+  std::cout << "layout\tsizeof\tMB/million ins\tM ins/s\tMB/s\t"
+            << "mallocs/ins\tmove seconds\tmove mallocs/ins\tfree seconds"
+            << std::endl;
+  std::vector<std::string> layouts;
+  if (FLAGS_layout == "both") {
+    layouts = {"legacy", "arena"};
+  } else {
+    layouts = {FLAGS_layout};
+  }
+  for (auto& layout : layouts) {
+    pid_t pid = fork();
+    CHECK_GE(pid, 0) << "fork failed";
+    if (pid == 0) {
+      if (layout == "legacy") {
+        paddle::framework::RunBenchmark<paddle::framework::LegacyRecord>(
+            layout, lines);
+      } else {
+        paddle::framework::RunBenchmark<paddle::framework::Record>(layout,
+                                                                   lines);
+      }
+      return 0;
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+  }
+  return 0;
+}
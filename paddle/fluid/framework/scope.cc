@@ -48,6 +48,13 @@ DEFINE_bool(
 namespace paddle {
 namespace framework {
 
+// Ids start from 1, so that 0 never matches a scope.
+static std::atomic<uint64_t> g_next_scope_id{1};
+
+Scope::Scope() : id_(g_next_scope_id++) {}
+
+Scope::Scope(Scope const* parent) : parent_(parent), id_(g_next_scope_id++) {}
+
 Scope::~Scope() { DropKids(); }
 
 Scope& Scope::NewScope() const {
@@ -98,6 +105,15 @@ const Scope* Scope::FindScope(const std::string& name) const {
   return FindScopeInternal(name);
 }
 
+uint64_t Scope::VarVersion() const {
+  // Versions only increase, so their sum changes whenever any of them does.
+  uint64_t version = 0;
+  for (const Scope* s = this; s != nullptr; s = s->parent_) {
+    version += s->var_version_.load(std::memory_order_relaxed);
+  }
+  return version;
+}
+
 void Scope::DropKids() {
   SCOPE_KIDS_WRITER_LOCK
   for (Scope* s : kids_) delete s;
@@ -143,6 +159,7 @@ void Scope::EraseVars(const std::vector<std::string>& var_names) {
   for (auto it = vars_.begin(); it != vars_.end();) {
     if (var_set.find(it->first) != var_set.end()) {
       it = vars_.erase(it);
+      BumpVarVersion();
     } else {
       ++it;
     }
@@ -167,6 +184,7 @@ Variable* Scope::VarInternal(const std::string& name) {
   if (v != nullptr) return v;
   v = new Variable();
   vars_.emplace(name, std::unique_ptr<Variable>(v));
+  BumpVarVersion();
   VLOG(3) << "Create variable " << name;
   return v;
 }
@@ -202,6 +220,7 @@ void Scope::RenameInternal(const std::string& origin_name,
           "The variable with name %s already exists in the scope.", new_name));
   vars_[new_name].reset(origin_it->second.release());
   vars_.erase(origin_it);
+  BumpVarVersion();
 }
 
 Variable* Scope::FindVarInternal(const std::string& name) const {
@@ -227,6 +246,7 @@ void Scope::EraseVarsExcept(const std::unordered_set<Variable*>& vars) {
       ++iter;
     } else {
       vars_.erase(iter++);
+      BumpVarVersion();
     }
   }
 }
@@ -18,6 +18,9 @@ extern "C" {
 #include <xxhash.h>
 }
 
+#include <stdint.h>
+
+#include <atomic>
 #include <list>
 #include <memory>
 #include <string>
@@ -45,7 +48,7 @@ class Scope;
  */
 class Scope {
  public:
-  Scope() {}
+  Scope();
   ~Scope();
 
   /// Create a sub-scope. Returns a reference other than a pointer so
@@ -82,6 +85,16 @@ class Scope {
 
   const Scope* parent() const { return parent_; }
 
+  /// The unique id of the scope, which is never reused by other scopes even
+  /// after this scope is deleted.
+  uint64_t id() const { return id_; }
+
+  /// Changes whenever a variable is created in, erased from or renamed in
+  /// this scope or any of its ancestors. Variable pointers found in the scope
+  /// stay valid as long as id() and VarVersion() do not change, so they can
+  /// be cached across runs, e.g. in the RuntimeContext of an operator.
+  uint64_t VarVersion() const;
+
   /// Find the scope or an ancestor scope that contains the given variable.
   const Scope* FindScope(const Variable* var) const;
 
@@ -120,7 +133,7 @@ class Scope {
 
  private:
   // Call Scope::NewScope for a sub-scope.
-  explicit Scope(Scope const* parent) : parent_(parent) {}
+  explicit Scope(Scope const* parent);
 
   // Called by Var.
   Variable* VarInternal(const std::string& name);
@@ -141,10 +154,18 @@ class Scope {
   // Called by FindVarInternal and Var.
   Variable* FindVarLocally(const std::string& name) const;
 
+  // Called when the variables of this scope are changed.
+  void BumpVarVersion() const {
+    var_version_.fetch_add(1, std::memory_order_relaxed);
+  }
+
   // Scope in `kids_` are owned by this class.
   mutable std::list<Scope*> kids_;
   const Scope* parent_{nullptr};
 
+  const uint64_t id_;
+  mutable std::atomic<uint64_t> var_version_{0};
+
   DISABLE_COPY_AND_ASSIGN(Scope);
 
 #ifndef PADDLE_ON_INFERENCE
@@ -71,3 +71,36 @@ TEST(Scope, GetAllNames) {
 
   EXPECT_STREQ("a", str.c_str());
 }
+
+TEST(Scope, IdAndVarVersion) {
+  Scope s;
+  Scope& ss = s.NewScope();
+  EXPECT_NE(s.id(), ss.id());
+  EXPECT_NE(s.id(), 0UL);
+
+  uint64_t version = ss.VarVersion();
+  ss.Var("a");
+  EXPECT_NE(ss.VarVersion(), version);
+
+  // finding or creating an existing variable changes nothing
+  version = ss.VarVersion();
+  uint64_t parent_version = s.VarVersion();
+  ss.Var("a");
+  ss.FindVar("a");
+  EXPECT_EQ(ss.VarVersion(), version);
+  EXPECT_EQ(s.VarVersion(), parent_version);
+
+  // changes of the parent change the versions of its kids
+  s.Var("b");
+  EXPECT_NE(ss.VarVersion(), version);
+  version = ss.VarVersion();
+  s.Rename("b", "c");
+  EXPECT_NE(ss.VarVersion(), version);
+  version = ss.VarVersion();
+  s.EraseVars({"c"});
+  EXPECT_NE(ss.VarVersion(), version);
+  version = ss.VarVersion();
+  ss.EraseVarsExcept({});
+  EXPECT_NE(ss.VarVersion(), version);
+  EXPECT_EQ(nullptr, ss.FindVar("a"));
+}
@@ -13,6 +13,9 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include "paddle/fluid/framework/selected_rows.h"
+#include "gflags/gflags.h"
+
+DECLARE_bool(selected_rows_open_addressing_index);
 
 namespace paddle {
 namespace framework {
@@ -38,49 +41,34 @@ struct ReAllocateVisitor {
   framework::Tensor* tensor_;
 };
 
-struct TensorCopyVisitor {
-  TensorCopyVisitor(framework::Tensor* dst, int64_t dst_offset,
-                    const framework::Tensor src, int64_t src_offset,
-                    int64_t size)
-      : dst_(dst),
-        dst_offset_(dst_offset),
-        src_(src),
-        src_offset_(src_offset),
-        size_(size) {}
-
-  template <typename T>
-  void apply() const {
-    // TODO(Yancey1989): support other place
-    platform::CPUPlace cpu;
-    memory::Copy(cpu, dst_->mutable_data<T>(cpu) + dst_offset_, cpu,
-                 src_.data<T>() + src_offset_, size_ * sizeof(T));
-  }
-
-  framework::Tensor* dst_;
-  int64_t dst_offset_;
-  framework::Tensor src_;
-  int64_t src_offset_;
-  int64_t size_;
-};
-
-struct TensorFillVisitor {
-  TensorFillVisitor(framework::Tensor* dst, int64_t dst_offset, int64_t size,
-                    float value)
-      : dst_(dst), dst_offset_(dst_offset), size_(size) {}
+// Copy the rows of the indexes of src to dst, and fill the rows of negative
+// indexes with 0.
+struct TensorRowsCopyVisitor {
+  TensorRowsCopyVisitor(framework::Tensor* dst, const framework::Tensor& src,
+                        const std::vector<int64_t>& indexes, int64_t width)
+      : dst_(dst), src_(src), indexes_(indexes), width_(width) {}
 
   template <typename T>
   void apply() const {
-    // TODO(qiao): support other place
     platform::CPUPlace cpu;
-    auto* tensor_data = dst_->mutable_data<T>(cpu);
-    auto* start = tensor_data + dst_offset_;
-    auto* end = start + size_;
-    std::fill(start, end, static_cast<T>(0.0));
+    T* dst_data = dst_->mutable_data<T>(cpu);
+    const T* src_data = src_.data<T>();
+    for (size_t i = 0; i < indexes_.size(); ++i) {
+      T* dst_row = dst_data + i * width_;
+      if (indexes_[i] < 0) {
+        VLOG(5) << "row " << i << " not in the table, return 0";
+        std::fill(dst_row, dst_row + width_, static_cast<T>(0.0));
+      } else {
+        const T* src_row = src_data + indexes_[i] * width_;
+        std::copy(src_row, src_row + width_, dst_row);
+      }
+    }
   }
 
   framework::Tensor* dst_;
-  int64_t dst_offset_;
-  int64_t size_;
+  const framework::Tensor& src_;
+  const std::vector<int64_t>& indexes_;
+  int64_t width_;
 };
 
 void SerializeToStream(std::ostream& os, const SelectedRows& selected_rows,
@@ -140,60 +128,155 @@ bool SelectedRows::HasKey(int64_t key) const {
                                                                    : true;
 }
 
+void SelectedRows::Index(const int64_t* keys, int64_t num,
+                         int64_t* indexes) const {
+  if (row_index_) {
+    row_index_->Find(keys, static_cast<size_t>(num), indexes);
+  } else {
+    AutoRDLock lock(rwlock_.get());
+    for (int64_t i = 0; i < num; ++i) {
+      auto iter = id_to_index_.find(keys[i]);
+      indexes[i] = iter == id_to_index_.end() ? -1 : iter->second;
+    }
+  }
+  // The index only holds the rows added by AutoGrownIndex or SyncIndex, so
+  // the keys it misses, or maps to other keys after set_rows, are searched
+  // in the rows, which are marked by the index -2 until they are found.
+  constexpr int64_t kNotFound = -2;
+  const int64_t* rows = rows_.data();
+  int64_t num_rows = static_cast<int64_t>(rows_.size());
+  SparseRowIndex missing_keys;
+  for (int64_t i = 0; i < num; ++i) {
+    int64_t index = indexes[i];
+    if (index < 0 || index >= num_rows || rows[index] != keys[i]) {
+      indexes[i] = -1;
+      if (keys[i] != SparseRowIndex::kEmptyKey) {
+        missing_keys.Insert(keys[i], kNotFound);
+      }
+    }
+  }
+  if (missing_keys.size() == 0) {
+    return;
+  }
+  size_t num_found = 0;
+  for (int64_t i = 0; i < num_rows && num_found < missing_keys.size(); ++i) {
+    int64_t key = rows[i];
+    if (key != SparseRowIndex::kEmptyKey &&
+        missing_keys.Find(key) == kNotFound) {
+      missing_keys.Insert(key, i);
+      ++num_found;
+    }
+  }
+  for (int64_t i = 0; i < num; ++i) {
+    if (indexes[i] < 0 && keys[i] != SparseRowIndex::kEmptyKey) {
+      indexes[i] = std::max(missing_keys.Find(keys[i]), int64_t(-1));
+    }
+  }
+}
+
+void SelectedRows::InitRowIndex() {
+  if (FLAGS_selected_rows_open_addressing_index) {
+    row_index_.reset(new SparseRowIndex());
+  }
+}
+
+int64_t SelectedRows::FindOrAddRow(int64_t key) {
+  size_t index_size =
+      row_index_ ? row_index_->size() : id_to_index_.size();
+  PADDLE_ENFORCE_EQ(index_size, rows_.size(),
+                    platform::errors::PreconditionNotMet(
+                        "The index of SelectedRows has %d keys, which should "
+                        "be the same as the number of rows %d.",
+                        index_size, rows_.size()));
+  int64_t index = GetIndexFromId(key);
+  if (index >= 0) {
+    return index;
+  }
+  PADDLE_ENFORCE_LT(static_cast<int64_t>(rows_.size()), value_->dims()[0],
+                    platform::errors::ResourceExhausted(
+                        "SelectedRows is full, the number of rows exceeds %d.",
+                        value_->dims()[0]));
+  // key logic to put a key into the index
+  rows_.push_back(key);
+  index = static_cast<int64_t>(rows_.size() - 1);
+  if (row_index_) {
+    row_index_->Insert(key, index);
+  } else {
+    id_to_index_[key] = index;
+  }
+  return index;
+}
+
 int64_t SelectedRows::AutoGrownIndex(int64_t key, bool auto_grown,
                                      bool is_test) {
-  if (is_test) {
+  if (row_index_) {
+    // the open addressing index is looked up without the lock
+    int64_t index = row_index_->Find(key);
+    if (index >= 0 || is_test) {
+      return index;
+    }
+  } else if (is_test) {
+    return GetIndexFromId(key);
+  } else {
+    AutoRDLock lock(rwlock_.get());
     auto iter = id_to_index_.find(key);
-    if (iter == id_to_index_.end()) {
-      return -1;
-    } else {
+    if (iter != id_to_index_.end()) {
       return iter->second;
     }
   }
+  PADDLE_ENFORCE_EQ(auto_grown, true,
+                    platform::errors::NotFound("key %d not found", key));
+  AutoWRLock lock(rwlock_.get());
+  return FindOrAddRow(key);
+}
 
-  rwlock_->RDLock();
-  auto iter = id_to_index_.find(key);
-  if (iter == id_to_index_.end()) {
-    rwlock_->UNLock();
-    if (!auto_grown) {
-      PADDLE_THROW("key %d not found", key);
+void SelectedRows::AutoGrownIndex(const int64_t* keys, int64_t num,
+                                  int64_t* indexes, bool auto_grown,
+                                  bool is_test) {
+  if (row_index_) {
+    row_index_->Find(keys, static_cast<size_t>(num), indexes);
+  } else if (is_test) {
+    for (int64_t i = 0; i < num; ++i) {
+      indexes[i] = GetIndexFromId(keys[i]);
     }
-    rwlock_->WRLock();
-    auto map_size = id_to_index_.size();
-    auto vector_size = rows_.size();
-    if (map_size != vector_size) {
-      rwlock_->UNLock();
-      PADDLE_THROW(
-          "id_to_index_ size %d should have the same size with rows_ %d",
-          map_size, vector_size);
+  } else {
+    AutoRDLock lock(rwlock_.get());
+    for (int64_t i = 0; i < num; ++i) {
+      indexes[i] = GetIndexFromId(keys[i]);
     }
-    auto write_iter = id_to_index_.find(key);
-    if (write_iter == id_to_index_.end()) {
-      int row_num = rows_.size();
-      if (row_num == value_->dims()[0]) {
-        rwlock_->UNLock();
-        PADDLE_THROW("selected rows is full, then length exceed %d", row_num);
-      }
-      // key logic to put a key into id_to_index_
-      rows_.push_back(key);
-      auto index = static_cast<int64_t>(rows_.size() - 1);
-      id_to_index_[key] = index;
-      rwlock_->UNLock();
-      return index;
-    } else {
-      auto index = write_iter->second;
-      rwlock_->UNLock();
-      return index;
+  }
+  if (is_test) {
+    return;
+  }
+  int64_t first_missing =
+      std::find_if(indexes, indexes + num,
+                   [](int64_t index) { return index < 0; }) -
+      indexes;
+  if (first_missing == num) {
+    return;
+  }
+  PADDLE_ENFORCE_EQ(auto_grown, true,
+                    platform::errors::NotFound("key %d not found",
+                                               keys[first_missing]));
+  AutoWRLock lock(rwlock_.get());
+  for (int64_t i = first_missing; i < num; ++i) {
+    if (indexes[i] < 0) {
+      indexes[i] = FindOrAddRow(keys[i]);
     }
-  } else {
-    auto index = iter->second;
-    rwlock_->UNLock();
-    return index;
   }
 }
 
 void SelectedRows::SyncIndex() {
   rwlock_->WRLock();
+  if (row_index_) {
+    row_index_->Clear();
+    row_index_->Reserve(rows_.size());
+    for (size_t i = 0; i < rows_.size(); ++i) {
+      row_index_->Insert(rows_[i], i);
+    }
+    rwlock_->UNLock();
+    return;
+  }
   id_to_index_.clear();
   for (size_t i = 0; i < rows_.size(); ++i) {
     id_to_index_[rows_[i]] = i;
@@ -203,30 +286,32 @@ void SelectedRows::SyncIndex() {
 
 void SelectedRows::Get(const framework::Tensor& ids, framework::Tensor* value,
                        bool auto_grown, bool is_test) {
+  if (ids.numel() == 0) {
+    PADDLE_ENFORCE(value->IsInitialized(),
+                   "The value tensor should be initialized.");
+    VLOG(3) << "keys is empty, please check data!";
+    return;
+  }
+  Get(ids.data<int64_t>(), ids.numel(), value, auto_grown, is_test);
+}
+
+void SelectedRows::Get(const int64_t* ids, int64_t num,
+                       framework::Tensor* value, bool auto_grown,
+                       bool is_test) {
   PADDLE_ENFORCE(value->IsInitialized(),
                  "The value tensor should be initialized.");
-  if (ids.numel() == 0) {
+  if (num == 0) {
     VLOG(3) << "keys is empty, please check data!";
   } else {
     int64_t value_width = value_->numel() / value_->dims()[0];
     PADDLE_ENFORCE_EQ(value_width, value->numel() / value->dims()[0],
                       "output tensor should have the same shape with table "
                       "except the dims[0].");
-    for (int i = 0; i < ids.numel(); ++i) {
-      auto id = ids.data<int64_t>()[i];
-      int64_t index = AutoGrownIndex(id, auto_grown, is_test);
-      if (index < 0) {
-        VLOG(5) << "id " << id << " not in the table, return 0";
-        framework::VisitDataType(
-            value_->type(),
-            TensorFillVisitor(value, i * value_width, value_width, 0.0));
-      } else {
-        framework::VisitDataType(
-            value_->type(),
-            TensorCopyVisitor(value, i * value_width, *value_.get(),
-                              index * value_width, value_width));
-      }
-    }
+    std::vector<int64_t> indexes(num);
+    AutoGrownIndex(ids, num, indexes.data(), auto_grown, is_test);
+    framework::VisitDataType(
+        value_->type(),
+        TensorRowsCopyVisitor(value, *value_, indexes, value_width));
   }
 }
 
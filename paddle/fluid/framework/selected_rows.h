@@ -23,6 +23,7 @@ limitations under the License. */
 
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/rw_lock.h"
+#include "paddle/fluid/framework/sparse_row_index.h"
 #include "paddle/fluid/framework/tensor.h"
 #include "paddle/fluid/memory/memcpy.h"
 
@@ -50,12 +51,14 @@ class SelectedRows {
       : rows_(rows), height_(height) {
     value_.reset(new Tensor());
     rwlock_.reset(new RWLock);
+    InitRowIndex();
   }
 
   SelectedRows() {
     height_ = 0;
     value_.reset(new Tensor());
     rwlock_.reset(new RWLock);
+    InitRowIndex();
   }
 
   const platform::Place& place() const { return value_->place(); }
@@ -87,6 +90,14 @@ class SelectedRows {
     return static_cast<int64_t>(std::distance(rows_.begin(), it));
   }
 
+  /*
+   * @brief Get the indexes of num keys in rows into indexes, -1 for the keys
+   * which do not exist. The keys are looked up in the index of the rows
+   * first, and the rows are scanned once for all the keys the index misses,
+   * rather than once for each key as Index(key) does.
+   */
+  void Index(const int64_t* keys, int64_t num, int64_t* indexes) const;
+
   /*
    * @brief whether has the specified key in the table.
    *
@@ -106,6 +117,13 @@ class SelectedRows {
   void Get(const framework::Tensor& ids, framework::Tensor* value,
            bool auto_grown = false, bool is_test = false);
 
+  /*
+   * @brief Get value by an array of num keys, which looks up all the keys
+   * before copying the rows, as Get(ids, ...) does.
+   */
+  void Get(const int64_t* ids, int64_t num, framework::Tensor* value,
+           bool auto_grown = false, bool is_test = false);
+
   /*
    * @brief Get the index of the key from id_to_index_ map. If the key not
    * exist,
@@ -119,10 +137,21 @@ class SelectedRows {
    */
   int64_t AutoGrownIndex(int64_t key, bool auto_grown, bool is_test = false);
 
+  /*
+   * @brief Get the indexes of an array of num keys into indexes, as
+   * AutoGrownIndex(key, ...) does for each of them. The lock is taken once
+   * for all the keys, and at most once more to add the missing keys.
+   */
+  void AutoGrownIndex(const int64_t* keys, int64_t num, int64_t* indexes,
+                      bool auto_grown, bool is_test = false);
+
   /*
    * @brief Get the index of the key from id_to_index_ map.
    */
   inline int64_t GetIndexFromId(int64_t key) {
+    if (row_index_) {
+      return row_index_->Find(key);
+    }
     auto iter = id_to_index_.find(key);
     if (iter == id_to_index_.end()) {
       return -1;
@@ -142,12 +171,20 @@ class SelectedRows {
   }
 
  private:
+  void InitRowIndex();
+
+  // Look up the key of the index, and add it to the rows if it does not
+  // exist. The write lock must be held.
+  int64_t FindOrAddRow(int64_t key);
+
   // Notice: rows can be duplicate. We can have {0, 4, 7, 0, 5, 7, 9} here.
   // SelectedRows are simply concated when adding together. Until a
   // SelectedRows add a Tensor, will the duplicate rows be handled.
   Vector<int64_t> rows_;
   std::unordered_map<int64_t, int64_t>
       id_to_index_;  // should not be used when rows_ has duplicate member
+  // replaces id_to_index_ if FLAGS_selected_rows_open_addressing_index is set
+  std::unique_ptr<SparseRowIndex> row_index_{nullptr};
   std::unique_ptr<Tensor> value_{nullptr};
   int64_t height_;  // height indicates the underline tensor's height
   std::unique_ptr<RWLock> rwlock_{nullptr};
@@ -0,0 +1,158 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Lookup throughput of the index of a SelectedRows used as a sparse table,
+// with std::unordered_map and with the open addressing index, looking up
+// keys one by one and in batches. The keys follow a Zipf distribution, as the
+// ids of the sparse features do, and are scattered over the int64 range. The
+// table starts empty, so the first lookups of the keys add them to the table,
+// as on a parameter server.
+//
+// Usage:
+//   ./selected_rows_benchmark --threads=1,4,16 --rows=1000000 --zipf=1.1
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/selected_rows.h"
+#include "paddle/fluid/string/split.h"
+
+DECLARE_bool(selected_rows_open_addressing_index);
+
+DEFINE_string(threads, "1,4,16",
+              "Comma separated thread numbers to be tested.");
+DEFINE_int64(rows, 1000000, "Number of distinct keys.");
+DEFINE_double(zipf, 1.1, "Exponent of the Zipf distribution of the keys.");
+DEFINE_int32(lookups, 1000000, "Keys looked up by each thread.");
+DEFINE_int32(batch_size, 512,
+             "Keys of a batched lookup, as the ids of a lookup_table op.");
+
+namespace paddle {
+namespace framework {
+
+// Sample the ranks of the keys by the inverted cumulative distribution.
+static std::vector<int64_t> GenerateKeys(unsigned int seed) {
+  std::vector<double> cdf(FLAGS_rows);
+  double sum = 0;
+  for (int64_t i = 0; i < FLAGS_rows; ++i) {
+    sum += 1.0 / std::pow(static_cast<double>(i + 1), FLAGS_zipf);
+    cdf[i] = sum;
+  }
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> dist(0, sum);
+  std::vector<int64_t> keys(FLAGS_lookups);
+  for (auto& key : keys) {
+    int64_t rank = std::lower_bound(cdf.begin(), cdf.end(), dist(rng)) -
+                   cdf.begin();
+    rank = std::min(rank, FLAGS_rows - 1);
+    // a bijection scattering the ranks, like the hashed feature ids
+    key = static_cast<int64_t>(static_cast<uint64_t>(rank) *
+                               0x9E3779B97F4A7C15ULL >> 1);
+  }
+  return keys;
+}
+
+static void Lookup(SelectedRows* table, const std::vector<int64_t>& keys,
+                   bool batched) {
+  int64_t checksum = 0;
+  if (batched) {
+    std::vector<int64_t> indexes(FLAGS_batch_size);
+    for (size_t i = 0; i < keys.size(); i += FLAGS_batch_size) {
+      int64_t num = std::min<int64_t>(FLAGS_batch_size, keys.size() - i);
+      table->AutoGrownIndex(keys.data() + i, num, indexes.data(), true);
+      checksum += indexes[0];
+    }
+  } else {
+    for (auto key : keys) {
+      checksum += table->AutoGrownIndex(key, true);
+    }
+  }
+  CHECK_GE(checksum, 0);
+}
+
+static void RunBenchmark(bool open_addressing, bool batched, int thread_num,
+                         const std::vector<std::vector<int64_t>>& keys) {
+  FLAGS_selected_rows_open_addressing_index = open_addressing;
+  SelectedRows table;
+  // only the height of the value is used by the index
+  table.mutable_value()->Resize(framework::make_ddim({FLAGS_rows, 1}));
+
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < thread_num; ++i) {
+    threads.emplace_back(Lookup, &table, std::cref(keys[i]), batched);
+  }
+  for (auto& th : threads) {
+    th.join();
+  }
+  double cold_seconds = std::chrono::duration<double>(
+                            std::chrono::steady_clock::now() - start)
+                            .count();
+
+  // all the keys are in the table now
+  threads.clear();
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < thread_num; ++i) {
+    threads.emplace_back(Lookup, &table, std::cref(keys[i]), batched);
+  }
+  for (auto& th : threads) {
+    th.join();
+  }
+  double warm_seconds = std::chrono::duration<double>(
+                            std::chrono::steady_clock::now() - start)
+                            .count();
+
+  double lookups = static_cast<double>(thread_num) * FLAGS_lookups;
+  std::cout << (open_addressing ? "open_addressing" : "unordered_map") << "\t"
+            << (batched ? "batched" : "single") << "\t" << thread_num << "\t"
+            << table.rows().size() << "\t" << lookups / cold_seconds / 1e6
+            << "\t" << lookups / warm_seconds / 1e6 << std::endl;
+}
+
+}  // namespace framework
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+
+  std::vector<int> thread_nums;
+  for (auto& s : paddle::string::Split(FLAGS_threads, ',')) {
+    thread_nums.push_back(std::stoi(s));
+  }
+  std::vector<std::vector<int64_t>> keys;
+  for (int i = 0;
+       i < *std::max_element(thread_nums.begin(), thread_nums.end()); ++i) {
+    keys.push_back(paddle::framework::GenerateKeys(i + 1));
+  }
+
+  std::cout << "index\tlookup\tthreads\tkeys\tcold M lookups/s\t"
+            << "warm M lookups/s" << std::endl;
+  for (bool open_addressing : {false, true}) {
+    for (bool batched : {false, true}) {
+      for (int thread_num : thread_nums) {
+        paddle::framework::RunBenchmark(open_addressing, batched, thread_num,
+                                        keys);
+      }
+    }
+  }
+  return 0;
+}
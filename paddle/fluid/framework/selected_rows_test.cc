@@ -12,9 +12,12 @@ limitations under the License. */
 #include <time.h>
 #include <thread>  // NOLINT
 
+#include "gflags/gflags.h"
 #include "gtest/gtest.h"
 #include "paddle/fluid/framework/selected_rows.h"
 
+DECLARE_bool(selected_rows_open_addressing_index);
+
 namespace paddle {
 namespace framework {
 
@@ -198,5 +201,118 @@ TEST(SelectedRows, MultiThreadAutoIndex) {
   t4.join();
 }
 
+TEST(SelectedRows, BatchedAutoGrownIndex) {
+  platform::CPUPlace cpu;
+  for (bool open_addressing : {false, true}) {
+    FLAGS_selected_rows_open_addressing_index = open_addressing;
+    SelectedRows table;
+    int64_t table_size = 8;
+    int64_t embedding_width = 2;
+    auto* data = table.mutable_value()->mutable_data<float>(
+        framework::make_ddim({table_size, embedding_width}), cpu);
+    for (int64_t i = 0; i < table_size * embedding_width; ++i) {
+      data[i] = static_cast<float>(i / embedding_width);
+    }
+    ASSERT_EQ(table.AutoGrownIndex(10, true), 0);
+
+    std::vector<int64_t> keys{8, 10, 8, 6, -3};
+    std::vector<int64_t> indexes(keys.size());
+    table.AutoGrownIndex(keys.data(), keys.size(), indexes.data(), false, true);
+    ASSERT_EQ(indexes, std::vector<int64_t>({-1, 0, -1, -1, -1}));
+    ASSERT_THROW(table.AutoGrownIndex(keys.data(), keys.size(),
+                                      indexes.data(), false),
+                 platform::EnforceNotMet);
+    table.AutoGrownIndex(keys.data(), keys.size(), indexes.data(), true);
+    ASSERT_EQ(indexes, std::vector<int64_t>({1, 0, 1, 2, 3}));
+    ASSERT_EQ(table.rows().size(), 4UL);
+    ASSERT_EQ(table.GetIndexFromId(-3), 3);
+    ASSERT_EQ(table.AutoGrownIndex(6, false), 2);
+
+    // missing keys are filled with 0 by Get in test mode
+    std::vector<int64_t> ids{6, 7, 10};
+    framework::Tensor value;
+    auto* value_data = value.mutable_data<float>(
+        framework::make_ddim({3, embedding_width}), cpu);
+    table.Get(ids.data(), ids.size(), &value, false, true);
+    ASSERT_EQ(value_data[0], 2);
+    ASSERT_EQ(value_data[1], 2);
+    ASSERT_EQ(value_data[2], 0);
+    ASSERT_EQ(value_data[3], 0);
+    ASSERT_EQ(value_data[4], 0);
+    ASSERT_EQ(value_data[5], 0);
+    table.Get(ids.data(), ids.size(), &value, true);
+    ASSERT_EQ(value_data[2], 4);
+    ASSERT_EQ(table.rows().size(), 5UL);
+
+    std::vector<int64_t> full_keys{20, 21, 22, 23};
+    ASSERT_THROW(table.AutoGrownIndex(full_keys.data(), full_keys.size(),
+                                      indexes.data(), true),
+                 platform::EnforceNotMet);
+
+    table.set_rows(std::vector<int64_t>{5, 9, 5, 11});
+    table.SyncIndex();
+    ASSERT_EQ(table.GetIndexFromId(5), 2);
+    ASSERT_EQ(table.GetIndexFromId(11), 3);
+    ASSERT_EQ(table.GetIndexFromId(6), -1);
+  }
+  FLAGS_selected_rows_open_addressing_index = false;
+}
+
+TEST(SelectedRows, BatchedIndex) {
+  platform::CPUPlace cpu;
+  for (bool open_addressing : {false, true}) {
+    FLAGS_selected_rows_open_addressing_index = open_addressing;
+    SelectedRows table;
+    table.mutable_value()->mutable_data<float>(framework::make_ddim({8, 2}),
+                                               cpu);
+    std::vector<int64_t> keys{9, 3, 9, 4, -5};
+    std::vector<int64_t> indexes(keys.size());
+
+    // the rows are only in the index
+    for (int64_t key : {3, 9, 5}) {
+      table.AutoGrownIndex(key, true);
+    }
+    table.Index(keys.data(), keys.size(), indexes.data());
+    ASSERT_EQ(indexes, std::vector<int64_t>({1, 0, 1, -1, -1}));
+
+    // the rows are not in the index, and the first of the duplicate rows
+    // is found as Index(key) does
+    table.set_rows(std::vector<int64_t>{4, 4, 9, -5, 3});
+    table.Index(keys.data(), keys.size(), indexes.data());
+    ASSERT_EQ(indexes, std::vector<int64_t>({2, 4, 2, 0, 3}));
+    for (size_t i = 0; i < keys.size(); ++i) {
+      ASSERT_EQ(indexes[i], table.Index(keys[i]));
+    }
+    table.Index(keys.data(), 0, indexes.data());
+  }
+  FLAGS_selected_rows_open_addressing_index = false;
+}
+
+TEST(SelectedRows, OpenAddressingMultiThreadAutoIndex) {
+  FLAGS_selected_rows_open_addressing_index = true;
+  platform::CPUPlace cpu;
+  SelectedRows table;
+  FLAGS_selected_rows_open_addressing_index = false;
+
+  int64_t table_size = 100000;
+  int64_t embedding_width = 8;
+  table.mutable_value()->mutable_data<float>(
+      framework::make_ddim({table_size, embedding_width}), cpu);
+
+  std::thread t1(f1, &table, table_size);
+  std::thread t11(f1, &table, table_size);
+  std::thread t2(f2, &table, table_size);
+  std::thread t22(f2, &table, table_size);
+  t1.join();
+  t11.join();
+  t2.join();
+  t22.join();
+  ASSERT_EQ(table.rows().size(), static_cast<size_t>(table_size));
+  std::thread t3(f3, &table, table_size);
+  std::thread t4(f4, &table, table_size);
+  t3.join();
+  t4.join();
+}
+
 }  // namespace framework
 }  // namespace paddle
@@ -0,0 +1,385 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#if defined _WIN32 || defined __APPLE__
+#else
+#define _LINUX
+#endif
+
+#include "paddle/fluid/framework/slot_record_file.h"
+#ifdef _LINUX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace framework {
+
+static constexpr char kSlotRecordFileMagic[8] = {'P', 'D', 'S', 'L',
+                                                 'O', 'T', 'B', '1'};
+static constexpr uint32_t kSlotRecordFileVersion = 1;
+
+static inline size_t AlignTo8(size_t size) { return (size + 7) & ~size_t(7); }
+
+// Offsets of the sections, which are computed from the header both when
+// writing and when reading a file.
+struct SlotRecordSections {
+  explicit SlotRecordSections(const SlotRecordFileHeader& h) {
+    metas = AlignTo8(sizeof(SlotRecordFileHeader));
+    uint64_feasigns = metas + h.record_num * sizeof(SlotRecordMeta);
+    float_feasigns = uint64_feasigns + h.uint64_num * sizeof(uint64_t);
+    uint64_slots =
+        AlignTo8(float_feasigns + h.float_num * sizeof(float));  // NOLINT
+    float_slots = uint64_slots + h.uint64_num * sizeof(uint16_t);
+    strings = AlignTo8(float_slots + h.float_num * sizeof(uint16_t));
+    end = strings + h.string_bytes;
+  }
+  size_t metas;
+  size_t uint64_feasigns;
+  size_t float_feasigns;
+  size_t uint64_slots;
+  size_t float_slots;
+  size_t strings;
+  size_t end;
+};
+
+class SlotRecordFileWriter {
+ public:
+  explicit SlotRecordFileWriter(const std::string& filename)
+      : filename_(filename), offset_(0) {
+    fp_ = fopen(filename.c_str(), "wb");
+    PADDLE_ENFORCE_NOT_NULL(
+        fp_, platform::errors::Unavailable("Failed to open file %s, %s.",
+                                           filename, strerror(errno)));
+  }
+
+  ~SlotRecordFileWriter() {
+    if (fp_ != nullptr) {
+      fclose(fp_);
+    }
+  }
+
+  void Write(const void* data, size_t size) {
+    if (size == 0) {
+      return;
+    }
+    PADDLE_ENFORCE_EQ(
+        fwrite(data, 1, size, fp_), size,
+        platform::errors::Unavailable("Failed to write file %s, %s.",
+                                      filename_, strerror(errno)));
+    offset_ += size;
+  }
+
+  void PadTo(size_t offset) {
+    static const char zeros[8] = {0};
+    PADDLE_ENFORCE_LE(offset_, offset,
+                      platform::errors::PreconditionNotMet(
+                          "Section of file %s overlaps.", filename_));
+    PADDLE_ENFORCE_LE(offset - offset_, sizeof(zeros),
+                      platform::errors::PreconditionNotMet(
+                          "Section of file %s is not aligned.", filename_));
+    Write(zeros, offset - offset_);
+  }
+
+  void Close() {
+    PADDLE_ENFORCE_EQ(fclose(fp_), 0,
+                      platform::errors::Unavailable("Failed to close file %s.",
+                                                    filename_));
+    fp_ = nullptr;
+  }
+
+ private:
+  std::string filename_;
+  FILE* fp_;
+  size_t offset_;
+};
+
+void WriteSlotRecordFile(const std::string& filename,
+                         const std::vector<Record>& records) {
+  SlotRecordFileHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kSlotRecordFileMagic, sizeof(header.magic));
+  header.version = kSlotRecordFileVersion;
+  header.record_num = records.size();
+  for (auto& rec : records) {
+    header.uint64_num += rec.uint64_feasigns_.size();
+    header.float_num += rec.float_feasigns_.size();
+    header.string_bytes += rec.ins_id_.size() + rec.content_.size();
+  }
+  SlotRecordSections sections(header);
+
+  SlotRecordFileWriter writer(filename);
+  writer.Write(&header, sizeof(header));
+  writer.PadTo(sections.metas);
+
+  SlotRecordMeta meta;
+  memset(&meta, 0, sizeof(meta));
+  uint64_t uint64_offset = 0;
+  uint64_t float_offset = 0;
+  uint64_t string_offset = 0;
+  for (auto& rec : records) {
+    meta.uint64_offset = uint64_offset;
+    meta.float_offset = float_offset;
+    meta.string_offset = string_offset;
+    meta.uint64_num = static_cast<uint32_t>(rec.uint64_feasigns_.size());
+    meta.float_num = static_cast<uint32_t>(rec.float_feasigns_.size());
+    meta.ins_id_len = static_cast<uint32_t>(rec.ins_id_.size());
+    meta.content_len = static_cast<uint32_t>(rec.content_.size());
+    meta.search_id = rec.search_id;
+    meta.rank = rec.rank;
+    meta.cmatch = rec.cmatch;
+    writer.Write(&meta, sizeof(meta));
+    uint64_offset += meta.uint64_num;
+    float_offset += meta.float_num;
+    string_offset += meta.ins_id_len + meta.content_len;
+  }
+
+  // Feasigns and slots are stored column by column, so that a reader only
+  // touches the pages of the columns it uses.
+  for (auto& rec : records) {
+    for (auto& fea : rec.uint64_feasigns_) {
+      writer.Write(&fea.sign().uint64_feasign_, sizeof(uint64_t));
+    }
+  }
+  for (auto& rec : records) {
+    for (auto& fea : rec.float_feasigns_) {
+      writer.Write(&fea.sign().float_feasign_, sizeof(float));
+    }
+  }
+  writer.PadTo(sections.uint64_slots);
+  for (auto& rec : records) {
+    for (auto& fea : rec.uint64_feasigns_) {
+      writer.Write(&fea.slot(), sizeof(uint16_t));
+    }
+  }
+  for (auto& rec : records) {
+    for (auto& fea : rec.float_feasigns_) {
+      writer.Write(&fea.slot(), sizeof(uint16_t));
+    }
+  }
+  writer.PadTo(sections.strings);
+  for (auto& rec : records) {
+    writer.Write(rec.ins_id_.data(), rec.ins_id_.size());
+    writer.Write(rec.content_.data(), rec.content_.size());
+  }
+  writer.Close();
+}
+
+std::shared_ptr<SlotRecordFile> SlotRecordFile::Open(
+    const std::string& filename) {
+#ifdef _LINUX
+  std::shared_ptr<SlotRecordFile> file(new SlotRecordFile());
+  file->filename_ = filename;
+
+  int fd = open(filename.c_str(), O_RDONLY);
+  PADDLE_ENFORCE_NE(fd, -1,
+                    platform::errors::Unavailable("Failed to open file %s, %s.",
+                                                  filename, strerror(errno)));
+  struct stat sb;
+  if (fstat(fd, &sb) != 0) {
+    int err = errno;
+    close(fd);
+    PADDLE_THROW(platform::errors::Unavailable("Failed to stat file %s, %s.",
+                                               filename, strerror(err)));
+  }
+  file->length_ = static_cast<size_t>(sb.st_size);
+  if (file->length_ < sizeof(SlotRecordFileHeader)) {
+    close(fd);
+    PADDLE_THROW(platform::errors::InvalidArgument(
+        "File %s is too small to be a slot record file.", filename));
+  }
+  void* buffer = mmap(NULL, file->length_, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  PADDLE_ENFORCE_NE(buffer, MAP_FAILED,
+                    platform::errors::Unavailable("Failed to mmap file %s, %s.",
+                                                  filename, strerror(errno)));
+  file->buffer_ = static_cast<char*>(buffer);
+
+  file->header_ = reinterpret_cast<const SlotRecordFileHeader*>(file->buffer_);
+  PADDLE_ENFORCE_EQ(memcmp(file->header_->magic, kSlotRecordFileMagic,
+                           sizeof(kSlotRecordFileMagic)),
+                    0, platform::errors::InvalidArgument(
+                           "File %s is not a slot record file.", filename));
+  PADDLE_ENFORCE_EQ(
+      file->header_->version, kSlotRecordFileVersion,
+      platform::errors::InvalidArgument(
+          "Version of slot record file %s is %d, but only %d is supported.",
+          filename, file->header_->version, kSlotRecordFileVersion));
+  // Bound the counts by the file length first, so that the sections
+  // computed from them cannot overflow.
+  const SlotRecordFileHeader& header = *file->header_;
+  PADDLE_ENFORCE_EQ(
+      header.record_num <= file->length_ / sizeof(SlotRecordMeta) &&
+          header.uint64_num <= file->length_ / sizeof(uint64_t) &&
+          header.float_num <= file->length_ / sizeof(float) &&
+          header.string_bytes <= file->length_,
+      true, platform::errors::InvalidArgument(
+                "Header of slot record file %s is corrupted.", filename));
+  SlotRecordSections sections(header);
+  PADDLE_ENFORCE_EQ(
+      sections.end, file->length_,
+      platform::errors::InvalidArgument(
+          "Slot record file %s is truncated or corrupted, expected %d bytes "
+          "but got %d bytes.",
+          filename, sections.end, file->length_));
+  PADDLE_ENFORCE_LT(file->header_->record_num, UINT32_MAX,
+                    platform::errors::InvalidArgument(
+                        "Too many records in slot record file %s.", filename));
+
+  file->metas_ =
+      reinterpret_cast<const SlotRecordMeta*>(file->buffer_ + sections.metas);
+  file->uint64_feasigns_ = reinterpret_cast<const uint64_t*>(
+      file->buffer_ + sections.uint64_feasigns);
+  file->float_feasigns_ =
+      reinterpret_cast<const float*>(file->buffer_ + sections.float_feasigns);
+  file->uint64_slots_ =
+      reinterpret_cast<const uint16_t*>(file->buffer_ + sections.uint64_slots);
+  file->float_slots_ =
+      reinterpret_cast<const uint16_t*>(file->buffer_ + sections.float_slots);
+  file->strings_ = file->buffer_ + sections.strings;
+
+  // Get() trusts the metas, so check every record against the sections
+  // once here.
+  for (uint64_t i = 0; i < header.record_num; ++i) {
+    const SlotRecordMeta& meta = file->metas_[i];
+    bool valid =
+        meta.uint64_offset <= header.uint64_num &&
+        meta.uint64_num <= header.uint64_num - meta.uint64_offset &&
+        meta.float_offset <= header.float_num &&
+        meta.float_num <= header.float_num - meta.float_offset &&
+        meta.string_offset <= header.string_bytes &&
+        meta.ins_id_len <= header.string_bytes - meta.string_offset &&
+        meta.content_len <=
+            header.string_bytes - meta.string_offset - meta.ins_id_len;
+    PADDLE_ENFORCE_EQ(
+        valid, true,
+        platform::errors::InvalidArgument(
+            "Record %d of slot record file %s is out of range.", i, filename));
+  }
+  return file;
+#else
+  PADDLE_THROW(platform::errors::Unimplemented(
+      "Slot record file is only supported on Linux."));
+#endif
+}
+
+SlotRecordFile::~SlotRecordFile() {
+#ifdef _LINUX
+  if (buffer_ != nullptr) {
+    munmap(buffer_, length_);
+  }
+#endif
+}
+
+SlotRecordView SlotRecordFile::Get(size_t i) const {
+  const SlotRecordMeta& meta = metas_[i];
+  SlotRecordView view;
+  view.uint64_feasigns = uint64_feasigns_ + meta.uint64_offset;
+  view.uint64_slots = uint64_slots_ + meta.uint64_offset;
+  view.uint64_num = meta.uint64_num;
+  view.float_feasigns = float_feasigns_ + meta.float_offset;
+  view.float_slots = float_slots_ + meta.float_offset;
+  view.float_num = meta.float_num;
+  view.ins_id = strings_ + meta.string_offset;
+  view.ins_id_len = meta.ins_id_len;
+  view.content = view.ins_id + meta.ins_id_len;
+  view.content_len = meta.content_len;
+  view.search_id = meta.search_id;
+  view.rank = meta.rank;
+  view.cmatch = meta.cmatch;
+  return view;
+}
+
+void SlotRecordFile::ToRecord(size_t i, Record* record) const {
+  SlotRecordView view = Get(i);
+  record->uint64_feasigns_.resize(view.uint64_num);
+  for (size_t j = 0; j < view.uint64_num; ++j) {
+    auto& fea = record->uint64_feasigns_[j];
+    fea.sign().uint64_feasign_ = view.uint64_feasigns[j];
+    fea.slot() = view.uint64_slots[j];
+  }
+  record->float_feasigns_.resize(view.float_num);
+  for (size_t j = 0; j < view.float_num; ++j) {
+    auto& fea = record->float_feasigns_[j];
+    fea.sign().float_feasign_ = view.float_feasigns[j];
+    fea.slot() = view.float_slots[j];
+  }
+  record->ins_id_.assign(view.ins_id, view.ins_id_len);
+  record->content_.assign(view.content, view.content_len);
+  record->search_id = view.search_id;
+  record->rank = view.rank;
+  record->cmatch = view.cmatch;
+}
+
+void SlotRecordIndex::AddFile(const std::shared_ptr<SlotRecordFile>& file) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  PADDLE_ENFORCE_LT(files_.size(), UINT32_MAX,
+                    platform::errors::OutOfRange(
+                        "Too many slot record files in one dataset."));
+  uint32_t file_id = static_cast<uint32_t>(files_.size());
+  files_.push_back(file);
+  refs_.reserve(refs_.size() + file->Size());
+  for (size_t i = 0; i < file->Size(); ++i) {
+    refs_.push_back({file_id, static_cast<uint32_t>(i)});
+  }
+}
+
+void SlotRecordIndex::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<SlotRecordRef>().swap(refs_);
+  files_.clear();
+  cursor_ = 0;
+}
+
+size_t SlotRecordIndex::Size() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return refs_.size() - cursor_;
+}
+
+void SlotRecordIndex::SetBlockSize(size_t block_size) {
+  PADDLE_ENFORCE_GT(block_size, 0,
+                    platform::errors::InvalidArgument(
+                        "Block size of SlotRecordIndex should be > 0."));
+  std::lock_guard<std::mutex> lock(mutex_);
+  block_size_ = block_size;
+}
+
+size_t SlotRecordIndex::ReadBlock(std::vector<Record>* records) {
+  size_t begin = 0;
+  size_t end = 0;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    begin = cursor_;
+    end = std::min(refs_.size(), cursor_ + block_size_);
+    cursor_ = end;
+  }
+  // Records are copied out of the lock, so readers materialize their blocks
+  // in parallel.
+  records->resize(end - begin);
+  for (size_t i = begin; i < end; ++i) {
+    const SlotRecordRef& ref = refs_[i];
+    files_[ref.file_id]->ToRecord(ref.record_id, &(*records)[i - begin]);
+  }
+  return end - begin;
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,159 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/data_feed.h"
+
+namespace paddle {
+namespace framework {
+
+// SlotRecordFile is a columnar binary format of Record, which is written
+// once from the parsed records and then memory-mapped by InMemoryDataset,
+// so the text slots do not need to be parsed again in every load.
+//
+// Layout of a file (all sections are 8 bytes aligned):
+//   SlotRecordFileHeader
+//   SlotRecordMeta[record_num]    per-record offset index
+//   uint64_t[uint64_num]          uint64 feasigns of all records
+//   float[float_num]              float feasigns of all records
+//   uint16_t[uint64_num]          slots of the uint64 feasigns
+//   uint16_t[float_num]           slots of the float feasigns
+//   char[string_bytes]            ins_id and content of all records
+struct SlotRecordFileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t record_num;
+  uint64_t uint64_num;
+  uint64_t float_num;
+  uint64_t string_bytes;
+};
+
+struct SlotRecordMeta {
+  uint64_t uint64_offset;
+  uint64_t float_offset;
+  uint64_t string_offset;
+  uint32_t uint64_num;
+  uint32_t float_num;
+  uint32_t ins_id_len;
+  uint32_t content_len;
+  uint64_t search_id;
+  uint32_t rank;
+  uint32_t cmatch;
+};
+
+// A zero-copy view of one record in a mapped SlotRecordFile. The pointers
+// are valid as long as the SlotRecordFile is alive.
+struct SlotRecordView {
+  const uint64_t* uint64_feasigns;
+  const uint16_t* uint64_slots;
+  size_t uint64_num;
+  const float* float_feasigns;
+  const uint16_t* float_slots;
+  size_t float_num;
+  const char* ins_id;
+  size_t ins_id_len;
+  const char* content;
+  size_t content_len;
+  uint64_t search_id;
+  uint32_t rank;
+  uint32_t cmatch;
+};
+
+// Write records into a SlotRecordFile.
+void WriteSlotRecordFile(const std::string& filename,
+                         const std::vector<Record>& records);
+
+// A read-only memory-mapped SlotRecordFile.
+class SlotRecordFile {
+ public:
+  static std::shared_ptr<SlotRecordFile> Open(const std::string& filename);
+
+  ~SlotRecordFile();
+
+  const std::string& FileName() const { return filename_; }
+  size_t Size() const { return header_->record_num; }
+
+  SlotRecordView Get(size_t i) const;
+  // Copy the i-th record out of the file.
+  void ToRecord(size_t i, Record* record) const;
+
+ private:
+  SlotRecordFile() = default;
+  SlotRecordFile(const SlotRecordFile&) = delete;
+  SlotRecordFile& operator=(const SlotRecordFile&) = delete;
+
+  std::string filename_;
+  char* buffer_{nullptr};
+  size_t length_{0};
+  const SlotRecordFileHeader* header_{nullptr};
+  const SlotRecordMeta* metas_{nullptr};
+  const uint64_t* uint64_feasigns_{nullptr};
+  const float* float_feasigns_{nullptr};
+  const uint16_t* uint64_slots_{nullptr};
+  const uint16_t* float_slots_{nullptr};
+  const char* strings_{nullptr};
+};
+
+struct SlotRecordRef {
+  uint32_t file_id;
+  uint32_t record_id;
+};
+
+// SlotRecordIndex holds the mapped files of a dataset and the references to
+// their records. Shuffles only permute the 8-byte references, and records
+// are copied out of the files block by block when readers start.
+class SlotRecordIndex {
+ public:
+  SlotRecordIndex() {}
+
+  void AddFile(const std::shared_ptr<SlotRecordFile>& file);
+  void Clear();
+
+  // The number of records that have not been read.
+  size_t Size();
+  void SetBlockSize(size_t block_size);
+
+  template <typename Engine>
+  void Shuffle(Engine* engine) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::shuffle(refs_.begin() + cursor_, refs_.end(), *engine);
+  }
+
+  SlotRecordView Get(const SlotRecordRef& ref) const {
+    return files_[ref.file_id]->Get(ref.record_id);
+  }
+
+  // Read at most block_size records, thread safe. Returns the number of
+  // records read, and 0 when all records have been read.
+  size_t ReadBlock(std::vector<Record>* records);
+
+ private:
+  std::mutex mutex_;
+  std::vector<std::shared_ptr<SlotRecordFile>> files_;
+  std::vector<SlotRecordRef> refs_;
+  size_t cursor_{0};
+  size_t block_size_{1024};
+};
+
+}  // namespace framework
+}  // namespace paddle
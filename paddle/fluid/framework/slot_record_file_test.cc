@@ -0,0 +1,195 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/slot_record_file.h"
+#include <gtest/gtest.h>
+#include <cstddef>
+#include <cstdio>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace paddle {
+namespace framework {
+
+static std::vector<Record> CreateRecords(int num, int offset) {
+  std::vector<Record> records(num);
+  for (int i = 0; i < num; ++i) {
+    Record& rec = records[i];
+    int id = offset + i;
+    // the i-th record has i uint64 feasigns, and (i % 3) float feasigns
+    for (int j = 0; j < i; ++j) {
+      FeatureKey key;
+      key.uint64_feasign_ = static_cast<uint64_t>(id) * 1000 + j;
+      rec.uint64_feasigns_.emplace_back(key, static_cast<uint16_t>(j));
+    }
+    for (int j = 0; j < i % 3; ++j) {
+      FeatureKey key;
+      key.float_feasign_ = id + 0.5f * j;
+      rec.float_feasigns_.emplace_back(key, static_cast<uint16_t>(j + 100));
+    }
+    rec.ins_id_ = "ins_" + std::to_string(id);
+    rec.content_ = i % 2 == 0 ? "" : "content_" + std::to_string(id);
+    rec.search_id = id;
+    rec.rank = i;
+    rec.cmatch = 222;
+  }
+  return records;
+}
+
+static void ExpectRecordEq(const Record& a, const Record& b) {
+  ASSERT_EQ(a.uint64_feasigns_.size(), b.uint64_feasigns_.size());
+  for (size_t i = 0; i < a.uint64_feasigns_.size(); ++i) {
+    EXPECT_EQ(a.uint64_feasigns_[i].sign().uint64_feasign_,
+              b.uint64_feasigns_[i].sign().uint64_feasign_);
+    EXPECT_EQ(a.uint64_feasigns_[i].slot(), b.uint64_feasigns_[i].slot());
+  }
+  ASSERT_EQ(a.float_feasigns_.size(), b.float_feasigns_.size());
+  for (size_t i = 0; i < a.float_feasigns_.size(); ++i) {
+    EXPECT_EQ(a.float_feasigns_[i].sign().float_feasign_,
+              b.float_feasigns_[i].sign().float_feasign_);
+    EXPECT_EQ(a.float_feasigns_[i].slot(), b.float_feasigns_[i].slot());
+  }
+  EXPECT_EQ(a.ins_id_, b.ins_id_);
+  EXPECT_EQ(a.content_, b.content_);
+  EXPECT_EQ(a.search_id, b.search_id);
+  EXPECT_EQ(a.rank, b.rank);
+  EXPECT_EQ(a.cmatch, b.cmatch);
+}
+
+TEST(SlotRecordFile, write_and_read) {
+  std::string filename = "slot_record_file_test_0.bin";
+  auto records = CreateRecords(20, 0);
+  WriteSlotRecordFile(filename, records);
+
+  auto file = SlotRecordFile::Open(filename);
+  ASSERT_EQ(file->Size(), records.size());
+  for (size_t i = 0; i < records.size(); ++i) {
+    SlotRecordView view = file->Get(i);
+    ASSERT_EQ(view.uint64_num, records[i].uint64_feasigns_.size());
+    for (size_t j = 0; j < view.uint64_num; ++j) {
+      EXPECT_EQ(view.uint64_feasigns[j],
+                records[i].uint64_feasigns_[j].sign().uint64_feasign_);
+      EXPECT_EQ(view.uint64_slots[j], records[i].uint64_feasigns_[j].slot());
+    }
+    ASSERT_EQ(view.float_num, records[i].float_feasigns_.size());
+    EXPECT_EQ(std::string(view.ins_id, view.ins_id_len), records[i].ins_id_);
+
+    Record rec;
+    file->ToRecord(i, &rec);
+    ExpectRecordEq(rec, records[i]);
+  }
+  remove(filename.c_str());
+}
+
+TEST(SlotRecordFile, empty_file) {
+  std::string filename = "slot_record_file_test_1.bin";
+  WriteSlotRecordFile(filename, std::vector<Record>());
+  auto file = SlotRecordFile::Open(filename);
+  EXPECT_EQ(file->Size(), 0UL);
+  remove(filename.c_str());
+}
+
+TEST(SlotRecordFile, invalid_file) {
+  std::string filename = "slot_record_file_test_2.bin";
+  FILE* fp = fopen(filename.c_str(), "w");
+  ASSERT_NE(fp, nullptr);
+  std::string text(128, 'a');
+  fwrite(text.data(), 1, text.size(), fp);
+  fclose(fp);
+  EXPECT_THROW(SlotRecordFile::Open(filename), platform::EnforceNotMet);
+  remove(filename.c_str());
+}
+
+static void CorruptFile(const std::string& filename, long offset,  // NOLINT
+                        const void* data, size_t size) {
+  FILE* fp = fopen(filename.c_str(), "r+b");
+  ASSERT_NE(fp, nullptr);
+  ASSERT_EQ(fseek(fp, offset, SEEK_SET), 0);
+  ASSERT_EQ(fwrite(data, 1, size, fp), size);
+  fclose(fp);
+}
+
+TEST(SlotRecordFile, corrupted_meta) {
+  std::string filename = "slot_record_file_test_5.bin";
+  auto records = CreateRecords(4, 0);
+  // offset of the metas, see SlotRecordFile layout
+  long metas = (sizeof(SlotRecordFileHeader) + 7) / 8 * 8;  // NOLINT
+
+  // uint64 feasigns of the last record run past the section
+  WriteSlotRecordFile(filename, records);
+  uint32_t uint64_num = 100;
+  CorruptFile(filename,
+              metas + 3 * sizeof(SlotRecordMeta) +
+                  offsetof(SlotRecordMeta, uint64_num),
+              &uint64_num, sizeof(uint64_num));
+  EXPECT_THROW(SlotRecordFile::Open(filename), platform::EnforceNotMet);
+
+  // an offset that overflows when added to the length
+  WriteSlotRecordFile(filename, records);
+  uint64_t string_offset = UINT64_MAX;
+  CorruptFile(filename,
+              metas + sizeof(SlotRecordMeta) +
+                  offsetof(SlotRecordMeta, string_offset),
+              &string_offset, sizeof(string_offset));
+  EXPECT_THROW(SlotRecordFile::Open(filename), platform::EnforceNotMet);
+
+  // a record number whose sections overflow size_t
+  WriteSlotRecordFile(filename, records);
+  uint64_t record_num = UINT64_MAX / sizeof(SlotRecordMeta) + 2;
+  CorruptFile(filename, offsetof(SlotRecordFileHeader, record_num),
+              &record_num, sizeof(record_num));
+  EXPECT_THROW(SlotRecordFile::Open(filename), platform::EnforceNotMet);
+  remove(filename.c_str());
+}
+
+TEST(SlotRecordIndex, shuffle_and_read) {
+  SlotRecordIndex index;
+  std::vector<std::string> filenames = {"slot_record_file_test_3.bin",
+                                        "slot_record_file_test_4.bin"};
+  WriteSlotRecordFile(filenames[0], CreateRecords(30, 0));
+  WriteSlotRecordFile(filenames[1], CreateRecords(50, 30));
+  for (auto& filename : filenames) {
+    index.AddFile(SlotRecordFile::Open(filename));
+  }
+  ASSERT_EQ(index.Size(), 80UL);
+
+  std::default_random_engine engine(0);
+  index.Shuffle(&engine);
+  index.SetBlockSize(32);
+
+  std::set<uint64_t> search_ids;
+  std::vector<Record> block;
+  std::vector<size_t> block_sizes;
+  while (index.ReadBlock(&block) != 0) {
+    block_sizes.push_back(block.size());
+    for (auto& rec : block) {
+      search_ids.insert(rec.search_id);
+    }
+  }
+  EXPECT_EQ(block_sizes, std::vector<size_t>({32, 32, 16}));
+  EXPECT_EQ(search_ids.size(), 80UL);
+  EXPECT_EQ(*search_ids.begin(), 0UL);
+  EXPECT_EQ(*search_ids.rbegin(), 79UL);
+  EXPECT_EQ(index.Size(), 0UL);
+
+  index.Clear();
+  for (auto& filename : filenames) {
+    remove(filename.c_str());
+  }
+}
+
+}  // namespace framework
+}  // namespace paddle
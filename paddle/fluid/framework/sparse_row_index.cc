@@ -0,0 +1,152 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/sparse_row_index.h"
+#include <algorithm>
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace framework {
+
+namespace {
+
+constexpr size_t kInitCapacity = 16;
+// keys prefetched ahead of the probed one by the batched Find
+constexpr size_t kPrefetchDistance = 8;
+
+inline void Prefetch(const void* addr) {
+#if defined(__GNUC__)
+  __builtin_prefetch(addr);
+#endif
+}
+
+// the capacity keeping the load factor at most 1/2
+inline size_t CapacityFor(size_t num) {
+  size_t capacity = kInitCapacity;
+  while (capacity < num * 2) {
+    capacity *= 2;
+  }
+  return capacity;
+}
+
+}  // namespace
+
+constexpr int64_t SparseRowIndex::kEmptyKey;
+
+SparseRowIndex::Table::Table(size_t capacity)
+    : mask(capacity - 1), slots(new Slot[capacity]) {
+  for (size_t i = 0; i < capacity; ++i) {
+    slots[i].key.store(kEmptyKey, std::memory_order_relaxed);
+    slots[i].index.store(-1, std::memory_order_relaxed);
+  }
+}
+
+SparseRowIndex::SparseRowIndex() {
+  tables_.emplace_back(new Table(kInitCapacity));
+  table_.store(tables_.back().get(), std::memory_order_release);
+}
+
+void SparseRowIndex::Find(const int64_t* keys, size_t num,
+                          int64_t* indexes) const {
+  const Table* table = table_.load(std::memory_order_acquire);
+  size_t prefetched = std::min(num, kPrefetchDistance);
+  for (size_t i = 0; i < prefetched; ++i) {
+    Prefetch(&table->slots[Hash(keys[i]) & table->mask]);
+  }
+  for (size_t i = 0; i < num; ++i) {
+    if (prefetched < num) {
+      Prefetch(&table->slots[Hash(keys[prefetched]) & table->mask]);
+      ++prefetched;
+    }
+    int64_t key = keys[i];
+    indexes[i] = -1;
+    for (size_t pos = Hash(key) & table->mask;;
+         pos = (pos + 1) & table->mask) {
+      const Slot& slot = table->slots[pos];
+      int64_t slot_key = slot.key.load(std::memory_order_acquire);
+      if (slot_key == key) {
+        indexes[i] = slot.index.load(std::memory_order_relaxed);
+        break;
+      }
+      if (slot_key == kEmptyKey) {
+        break;
+      }
+    }
+  }
+}
+
+void SparseRowIndex::Insert(int64_t key, int64_t index) {
+  PADDLE_ENFORCE_NE(key, kEmptyKey,
+                    platform::errors::InvalidArgument(
+                        "The key %d of a row is reserved by the open "
+                        "addressing index of SelectedRows.",
+                        key));
+  size_t size = size_.load(std::memory_order_relaxed);
+  Table* table = table_.load(std::memory_order_relaxed);
+  if ((size + 1) * 2 > table->mask + 1) {
+    Rehash(CapacityFor(size + 1));
+    table = table_.load(std::memory_order_relaxed);
+  }
+  if (InsertToTable(table, key, index)) {
+    size_.store(size + 1, std::memory_order_relaxed);
+  }
+}
+
+bool SparseRowIndex::InsertToTable(Table* table, int64_t key, int64_t index) {
+  for (size_t pos = Hash(key) & table->mask;; pos = (pos + 1) & table->mask) {
+    Slot& slot = table->slots[pos];
+    int64_t slot_key = slot.key.load(std::memory_order_relaxed);
+    if (slot_key == key) {
+      slot.index.store(index, std::memory_order_relaxed);
+      return false;
+    }
+    if (slot_key == kEmptyKey) {
+      slot.index.store(index, std::memory_order_relaxed);
+      slot.key.store(key, std::memory_order_release);
+      return true;
+    }
+  }
+}
+
+void SparseRowIndex::Reserve(size_t num) {
+  size_t capacity = CapacityFor(num);
+  if (capacity > table_.load(std::memory_order_relaxed)->mask + 1) {
+    Rehash(capacity);
+  }
+}
+
+void SparseRowIndex::Rehash(size_t capacity) {
+  const Table* old_table = table_.load(std::memory_order_relaxed);
+  std::unique_ptr<Table> table(new Table(capacity));
+  for (size_t i = 0; i <= old_table->mask; ++i) {
+    const Slot& slot = old_table->slots[i];
+    int64_t key = slot.key.load(std::memory_order_relaxed);
+    if (key != kEmptyKey) {
+      InsertToTable(table.get(), key,
+                    slot.index.load(std::memory_order_relaxed));
+    }
+  }
+  table_.store(table.get(), std::memory_order_release);
+  tables_.push_back(std::move(table));
+}
+
+void SparseRowIndex::Clear() {
+  tables_.clear();
+  tables_.emplace_back(new Table(kInitCapacity));
+  table_.store(tables_.back().get(), std::memory_order_release);
+  size_.store(0, std::memory_order_relaxed);
+}
+
+}  // namespace framework
+}  // namespace paddle
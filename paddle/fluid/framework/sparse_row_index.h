@@ -0,0 +1,126 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace paddle {
+namespace framework {
+
+/*
+ * @brief An open addressing hash table from the keys of the rows of a
+ * SelectedRows to their indexes, which SelectedRows uses in place of
+ * std::unordered_map when FLAGS_selected_rows_open_addressing_index is set.
+ *
+ * The keys and indexes are stored inline in a power of two array of slots
+ * probed linearly, so a lookup usually touches a single cache line. Find
+ * takes no lock and may run concurrently with Insert, while Insert must be
+ * serialized by the caller. A slot is published by storing its key after its
+ * index, so Find never sees a key without its index. When the table grows,
+ * the former arrays are kept until Clear or the destruction of the index,
+ * since concurrent Find calls may still probe them; they take at most as
+ * much memory as the current array.
+ */
+class SparseRowIndex {
+ public:
+  // The key reserved to mark empty slots, which can't be inserted.
+  static constexpr int64_t kEmptyKey = std::numeric_limits<int64_t>::min();
+
+  SparseRowIndex();
+
+  /*
+   * @return the index of the key, or -1 if the key does not exist.
+   */
+  int64_t Find(int64_t key) const {
+    const Table* table = table_.load(std::memory_order_acquire);
+    for (size_t pos = Hash(key) & table->mask;;
+         pos = (pos + 1) & table->mask) {
+      const Slot& slot = table->slots[pos];
+      int64_t slot_key = slot.key.load(std::memory_order_acquire);
+      if (slot_key == key) {
+        return slot.index.load(std::memory_order_relaxed);
+      }
+      if (slot_key == kEmptyKey) {
+        return -1;
+      }
+    }
+  }
+
+  /*
+   * @brief Find the indexes of num keys, -1 for the keys which do not exist.
+   * The slots of the following keys are prefetched while probing, which hides
+   * most of the cache misses of large tables.
+   */
+  void Find(const int64_t* keys, size_t num, int64_t* indexes) const;
+
+  /*
+   * @brief Insert the key, or update the index of it if it exists.
+   */
+  void Insert(int64_t key, int64_t index);
+
+  /*
+   * @brief Grow the table to hold num keys without growing again.
+   */
+  void Reserve(size_t num);
+
+  /*
+   * @brief Remove all the keys. It must not run concurrently with Find.
+   */
+  void Clear();
+
+  size_t size() const { return size_.load(std::memory_order_relaxed); }
+
+  // the murmur3 finalizer, which scatters the sequential and strided keys
+  // the sparse tables usually have
+  static size_t Hash(int64_t key) {
+    uint64_t h = static_cast<uint64_t>(key);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return static_cast<size_t>(h);
+  }
+
+ private:
+  struct Slot {
+    std::atomic<int64_t> key;
+    std::atomic<int64_t> index;
+  };
+
+  struct Table {
+    explicit Table(size_t capacity);
+
+    size_t mask;
+    std::unique_ptr<Slot[]> slots;
+  };
+
+  // @return true if the key is new.
+  bool InsertToTable(Table* table, int64_t key, int64_t index);
+  void Rehash(size_t capacity);
+
+  std::atomic<Table*> table_;
+  // the current table and the former ones
+  std::vector<std::unique_ptr<Table>> tables_;
+  std::atomic<size_t> size_{0};
+};
+
+}  // namespace framework
+}  // namespace paddle
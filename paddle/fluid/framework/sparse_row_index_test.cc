@@ -0,0 +1,112 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/sparse_row_index.h"
+#include <atomic>
+#include <thread>  // NOLINT
+#include <vector>
+#include "gtest/gtest.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace framework {
+
+TEST(SparseRowIndex, InsertAndFind) {
+  SparseRowIndex index;
+  EXPECT_EQ(index.Find(0), -1);
+  // strided keys, which the sparse tables of the pservers have
+  for (int64_t i = 0; i < 10000; ++i) {
+    index.Insert(i * 64 + 3, i);
+  }
+  EXPECT_EQ(index.size(), 10000UL);
+  for (int64_t i = 0; i < 10000; ++i) {
+    EXPECT_EQ(index.Find(i * 64 + 3), i);
+    EXPECT_EQ(index.Find(i * 64 + 4), -1);
+  }
+  EXPECT_EQ(index.Find(-1), -1);
+
+  index.Insert(3, 100);
+  EXPECT_EQ(index.size(), 10000UL);
+  EXPECT_EQ(index.Find(3), 100);
+
+  index.Insert(-7, 10000);
+  EXPECT_EQ(index.Find(-7), 10000);
+  EXPECT_THROW(index.Insert(SparseRowIndex::kEmptyKey, 0),
+               platform::EnforceNotMet);
+
+  index.Clear();
+  EXPECT_EQ(index.size(), 0UL);
+  EXPECT_EQ(index.Find(3), -1);
+}
+
+TEST(SparseRowIndex, BatchedFind) {
+  SparseRowIndex index;
+  index.Reserve(1000);
+  for (int64_t i = 0; i < 1000; ++i) {
+    index.Insert(i * 3, i);
+  }
+  std::vector<int64_t> keys;
+  for (int64_t i = 0; i < 3000; ++i) {
+    keys.push_back(2999 - i);
+  }
+  std::vector<int64_t> indexes(keys.size());
+  index.Find(keys.data(), keys.size(), indexes.data());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    EXPECT_EQ(indexes[i], keys[i] % 3 == 0 ? keys[i] / 3 : -1);
+  }
+  index.Find(keys.data(), 0, indexes.data());
+}
+
+// Find runs concurrently with Insert, which grows the table many times.
+TEST(SparseRowIndex, ConcurrentFind) {
+  SparseRowIndex index;
+  const int64_t key_num = 200000;
+  std::atomic<int64_t> inserted{0};
+  std::atomic<bool> failed{false};
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 4; ++t) {
+    readers.emplace_back([&, t] {
+      std::vector<int64_t> keys(64), indexes(64);
+      int64_t round = 0;
+      while (inserted.load() < key_num) {
+        int64_t num = inserted.load();
+        for (size_t i = 0; i < keys.size(); ++i) {
+          keys[i] = num == 0 ? 0 : (round * 7919 + i * 31 + t) % num;
+        }
+        index.Find(keys.data(), keys.size(), indexes.data());
+        for (size_t i = 0; i < keys.size(); ++i) {
+          if (num > 0 && indexes[i] != keys[i] * 2) {
+            failed = true;
+          }
+        }
+        if (index.Find(num + key_num) != -1) {
+          failed = true;
+        }
+        ++round;
+      }
+    });
+  }
+  for (int64_t i = 0; i < key_num; ++i) {
+    index.Insert(i, i * 2);
+    inserted.store(i + 1);
+  }
+  for (auto& th : readers) {
+    th.join();
+  }
+  EXPECT_FALSE(failed.load());
+  EXPECT_EQ(index.size(), static_cast<size_t>(key_num));
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,364 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/static_memory_planner.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/memory/malloc.h"
+#include "paddle/fluid/platform/monitor.h"
+
+USE_INT_STAT(STAT_static_memory_arena_bytes);
+
+namespace paddle {
+namespace framework {
+
+static constexpr size_t kAlignment = 64;
+
+static size_t AlignedSize(size_t size) {
+  return (size + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+namespace {
+
+// The slot of a block in the arena, which keeps the arena alive while a
+// tensor holds it.
+class ArenaSlot : public memory::Allocation {
+ public:
+  ArenaSlot(const std::shared_ptr<memory::Allocation>& arena, size_t offset,
+            size_t size)
+      : Allocation(static_cast<uint8_t*>(arena->ptr()) + offset, size,
+                   arena->place()),
+        arena_(arena) {}
+
+ private:
+  std::shared_ptr<memory::Allocation> arena_;
+};
+
+}  // namespace
+
+size_t StaticMemoryPlanner::AssignOffsets(std::vector<MemoryBlock>* blocks) {
+  std::vector<size_t> order(blocks->size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [blocks](size_t a, size_t b) {
+    return (*blocks)[a].size > (*blocks)[b].size;
+  });
+
+  size_t arena_size = 0;
+  std::vector<size_t> assigned;
+  std::vector<std::pair<size_t, size_t>> used;
+  for (size_t idx : order) {
+    auto& block = (*blocks)[idx];
+    block.offset = 0;
+    if (block.size == 0) {
+      continue;
+    }
+    // the ranges of the arena used by the blocks living at the same time
+    used.clear();
+    for (size_t other_idx : assigned) {
+      auto& other = (*blocks)[other_idx];
+      if (other.first_op <= block.last_op && block.first_op <= other.last_op) {
+        used.emplace_back(other.offset, other.offset + other.size);
+      }
+    }
+    std::sort(used.begin(), used.end());
+
+    size_t best_offset = std::numeric_limits<size_t>::max();
+    size_t best_gap = std::numeric_limits<size_t>::max();
+    size_t offset = 0;
+    for (auto& range : used) {
+      if (range.first >= offset + block.size &&
+          range.first - offset < best_gap) {
+        best_gap = range.first - offset;
+        best_offset = offset;
+      }
+      offset = std::max(offset, range.second);
+    }
+    if (best_offset == std::numeric_limits<size_t>::max()) {
+      best_offset = offset;
+    }
+    block.offset = best_offset;
+    arena_size = std::max(arena_size, block.offset + block.size);
+    assigned.push_back(idx);
+  }
+  return arena_size;
+}
+
+StaticMemoryPlanner::StaticMemoryPlanner(
+    const std::vector<std::unique_ptr<OperatorBase>>& ops, Scope* scope,
+    const platform::Place& place, const std::vector<std::string>& outputs,
+    size_t max_num_plans)
+    : place_(place),
+      scope_(scope),
+      max_num_plans_(max_num_plans),
+      num_ops_(ops.size()) {
+  PADDLE_ENFORCE_NOT_NULL(
+      scope, platform::errors::InvalidArgument(
+                 "The scope of the StaticMemoryPlanner should not be null."));
+  std::unordered_map<std::string, size_t> first_read, first_write;
+  std::unordered_map<std::string, size_t> last_use;
+  std::vector<std::string> names;
+  auto use = [&](const std::string& name, size_t idx,
+                 std::unordered_map<std::string, size_t>* first) {
+    if (name == kEmptyVarName) {
+      return;
+    }
+    if (!last_use.count(name)) {
+      names.push_back(name);
+    }
+    first->emplace(name, idx);
+    last_use[name] = idx;
+  };
+  for (size_t i = 0; i < ops.size(); ++i) {
+    auto& op = ops[i];
+    // the ops of the sub-blocks use the variables out of sight
+    if (op->HasAttr("sub_block")) {
+      LOG(WARNING) << "The static memory plan is disabled since the op "
+                   << op->Type() << " has a sub-block.";
+      disabled_ = true;
+      return;
+    }
+    for (auto& input : op->Inputs()) {
+      for (auto& name : input.second) {
+        use(name, i, &first_read);
+      }
+    }
+    for (auto& output : op->Outputs()) {
+      for (auto& name : output.second) {
+        use(name, i, &first_write);
+      }
+    }
+  }
+
+  std::unordered_set<std::string> output_set(outputs.begin(), outputs.end());
+  for (auto& name : names) {
+    auto write = first_write.find(name);
+    auto read = first_read.find(name);
+    if (write == first_write.end() ||
+        (read != first_read.end() && read->second <= write->second)) {
+      // read before written, e.g. fed or updated in place
+      input_names_.push_back(name);
+      continue;
+    }
+    size_t last_op = last_use[name];
+    if (read == first_read.end() || output_set.count(name)) {
+      last_op = num_ops_;
+    }
+    temp_names_.push_back(name);
+    temp_lifetimes_.emplace_back(write->second, last_op);
+  }
+}
+
+StaticMemoryPlanner::~StaticMemoryPlanner() {
+  if (arena_) {
+    STAT_SUB(STAT_static_memory_arena_bytes,
+             static_cast<int64_t>(arena_->size()));
+  }
+}
+
+void StaticMemoryPlanner::FindVariables() {
+  // The variables not in the local scope, i.e. the parameters, are neither
+  // planned nor in the signature.
+  for (auto& name : input_names_) {
+    auto* var = scope_->FindLocalVar(name);
+    if (var) {
+      input_vars_.push_back(var);
+    } else {
+      other_names_.push_back(name);
+    }
+  }
+  std::vector<std::string> temp_names;
+  std::vector<std::pair<size_t, size_t>> temp_lifetimes;
+  for (size_t i = 0; i < temp_names_.size(); ++i) {
+    auto* var = scope_->FindLocalVar(temp_names_[i]);
+    if (var) {
+      temp_names.push_back(temp_names_[i]);
+      temp_lifetimes.push_back(temp_lifetimes_[i]);
+      temp_vars_.push_back(var);
+    } else {
+      other_names_.push_back(temp_names_[i]);
+    }
+  }
+  temp_names_.swap(temp_names);
+  temp_lifetimes_.swap(temp_lifetimes);
+}
+
+void StaticMemoryPlanner::MakeSignature(std::vector<int64_t>* signature) const {
+  signature->clear();
+  for (auto* var : input_vars_) {
+    if (!var->IsType<LoDTensor>()) {
+      signature->push_back(-1);
+      continue;
+    }
+    auto& tensor = var->Get<LoDTensor>();
+    auto& dims = tensor.dims();
+    signature->push_back(dims.size());
+    for (int i = 0; i < dims.size(); ++i) {
+      signature->push_back(dims[i]);
+    }
+    auto& lod = tensor.lod();
+    signature->push_back(static_cast<int64_t>(lod.size()));
+    for (auto& level : lod) {
+      signature->push_back(static_cast<int64_t>(level.size()));
+      signature->insert(signature->end(), level.begin(), level.end());
+    }
+  }
+}
+
+void StaticMemoryPlanner::GroupVariables() {
+  grouped_ = true;
+  // the buffers of the inputs and the parameters
+  std::unordered_set<const memory::Allocation*> external;
+  auto add_external = [&](const Variable* var) {
+    if (var && var->IsType<LoDTensor>()) {
+      external.insert(var->Get<LoDTensor>().Holder().get());
+    }
+  };
+  for (auto* var : input_vars_) {
+    add_external(var);
+  }
+  for (auto& name : other_names_) {
+    add_external(scope_->FindVar(name));
+  }
+
+  std::unordered_map<const memory::Allocation*, size_t> group_of_holder;
+  for (size_t i = 0; i < temp_vars_.size(); ++i) {
+    auto* var = temp_vars_[i];
+    // the variables not allocated in the run may share a buffer later
+    if (!var->IsType<LoDTensor>() || !var->Get<LoDTensor>().IsInitialized()) {
+      continue;
+    }
+    auto* holder = var->Get<LoDTensor>().Holder().get();
+    if (!(holder->place() == place_)) {
+      continue;
+    }
+    auto it = group_of_holder.find(holder);
+    if (it == group_of_holder.end()) {
+      it = group_of_holder.emplace(holder, groups_.size()).first;
+      groups_.emplace_back();
+      group_lifetimes_.push_back(temp_lifetimes_[i]);
+    }
+    size_t group = it->second;
+    groups_[group].push_back(i);
+    auto& lifetime = group_lifetimes_[group];
+    lifetime.first = std::min(lifetime.first, temp_lifetimes_[i].first);
+    lifetime.second = std::max(lifetime.second, temp_lifetimes_[i].second);
+  }
+  for (auto& item : group_of_holder) {
+    if (external.count(item.first)) {
+      groups_[item.second].clear();
+    }
+  }
+}
+
+void StaticMemoryPlanner::MakeSlots(MemoryPlan* plan) const {
+  plan->slots.assign(plan->blocks.size(), nullptr);
+  for (size_t i = 0; i < plan->blocks.size(); ++i) {
+    auto& block = plan->blocks[i];
+    if (block.size > 0) {
+      plan->slots[i] = std::make_shared<ArenaSlot>(arena_, block.offset,
+                                                   block.size);
+    }
+  }
+}
+
+bool StaticMemoryPlanner::Apply() {
+  if (disabled_) {
+    return false;
+  }
+  if (!found_) {
+    FindVariables();
+    found_ = true;
+  }
+  MakeSignature(&signature_);
+  auto it = plans_.find(signature_);
+  if (it == plans_.end()) {
+    return false;
+  }
+  auto& plan = it->second;
+  for (size_t i = 0; i < groups_.size(); ++i) {
+    auto& slot = plan.slots[i];
+    if (!slot) {
+      continue;
+    }
+    for (size_t idx : groups_[i]) {
+      auto* tensor = temp_vars_[idx]->GetMutable<LoDTensor>();
+      if (tensor->Holder() != slot) {
+        tensor->clear();
+        tensor->ResetHolder(slot);
+      }
+    }
+  }
+  return true;
+}
+
+void StaticMemoryPlanner::Plan() {
+  if (disabled_ || !found_ || plans_.size() >= max_num_plans_) {
+    return;
+  }
+  if (!grouped_) {
+    GroupVariables();
+  }
+
+  MemoryPlan plan;
+  plan.blocks.resize(groups_.size());
+  size_t unplanned_size = 0;
+  for (size_t i = 0; i < groups_.size(); ++i) {
+    auto& block = plan.blocks[i];
+    block.first_op = group_lifetimes_[i].first;
+    block.last_op = group_lifetimes_[i].second;
+    size_t size = 0;
+    for (size_t idx : groups_[i]) {
+      auto& tensor = temp_vars_[idx]->Get<LoDTensor>();
+      if (!tensor.IsInitialized() || !(tensor.place() == place_)) {
+        continue;
+      }
+      size = std::max(size, tensor.offset() + tensor.numel() *
+                                                  SizeOfType(tensor.type()));
+    }
+    block.size = AlignedSize(size);
+    unplanned_size += block.size;
+  }
+  plan.arena_size = AssignOffsets(&plan.blocks);
+
+  if (plan.arena_size > arena_size()) {
+    // The tensors holding the slots in the former arena keep it until they
+    // are pointed to the new one.
+    if (arena_) {
+      STAT_SUB(STAT_static_memory_arena_bytes,
+               static_cast<int64_t>(arena_->size()));
+    }
+    arena_ = memory::AllocShared(place_, plan.arena_size);
+    STAT_ADD(STAT_static_memory_arena_bytes,
+             static_cast<int64_t>(arena_->size()));
+    for (auto& item : plans_) {
+      MakeSlots(&item.second);
+    }
+  }
+  MakeSlots(&plan);
+  VLOG(3) << "Static memory plan " << plans_.size() << ": " << groups_.size()
+          << " blocks of " << unplanned_size << " bytes in an arena of "
+          << plan.arena_size << " bytes";
+  unplanned_size_ = std::max(unplanned_size_, unplanned_size);
+  plans_.emplace(signature_, std::move(plan));
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,143 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "paddle/fluid/framework/operator.h"
+#include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/memory/allocation/allocator.h"
+#include "paddle/fluid/platform/macros.h"
+#include "paddle/fluid/platform/place.h"
+
+namespace paddle {
+namespace framework {
+
+/*
+ * @brief Plans the memory of the temporary variables of a block run by the
+ * NaiveExecutor in one arena allocated ahead of the runs.
+ *
+ * The lifetime of a temporary variable is the range of the ops which use
+ * it, and does not change with the shapes. The sizes do, so the first run
+ * with a new signature, i.e. the shapes and LoDs of the input variables,
+ * allocates as usual, after which the planner records the sizes and assigns
+ * each variable an offset in the arena, so that the variables living at the
+ * same time don't overlap. Before the later runs with the signature, the
+ * planner points the variables to their slots in the arena, and the kernels
+ * find their outputs allocated.
+ *
+ * The variables sharing a buffer, e.g. by ShareDataWith, are planned as one,
+ * and those sharing it with the inputs or the parameters are not planned.
+ */
+class StaticMemoryPlanner {
+ public:
+  // The memory of one or more variables sharing a buffer.
+  struct MemoryBlock {
+    size_t size{0};
+    // the first and the last index of the ops using the memory
+    size_t first_op{0};
+    size_t last_op{0};
+    size_t offset{0};
+  };
+
+  /*
+   * @brief Assign the offsets of the blocks, the larger first, each to the
+   * smallest gap between the blocks living at the same time it fits in.
+   * @return the size of the arena.
+   */
+  static size_t AssignOffsets(std::vector<MemoryBlock>* blocks);
+
+  /*
+   * @param outputs the variables read after the runs, which live to the end.
+   * @param max_num_plans the number of the signatures planned at most, after
+   * which the runs with a new signature allocate as usual.
+   */
+  StaticMemoryPlanner(const std::vector<std::unique_ptr<OperatorBase>>& ops,
+                      Scope* scope, const platform::Place& place,
+                      const std::vector<std::string>& outputs,
+                      size_t max_num_plans);
+
+  ~StaticMemoryPlanner();
+
+  /*
+   * @brief Called before a run, point the variables to their slots if the
+   * signature of the inputs is planned.
+   * @return whether the run is planned.
+   */
+  bool Apply();
+
+  // Called after a run which was not planned, plan its signature.
+  void Plan();
+
+  size_t num_plans() const { return plans_.size(); }
+  // the size of the arena, the largest of the plans
+  size_t arena_size() const { return arena_ ? arena_->size() : 0; }
+  // the bytes of the temporary variables of the largest plan, which they
+  // hold without the plan
+  size_t unplanned_size() const { return unplanned_size_; }
+
+ private:
+  struct MemoryPlan {
+    std::vector<MemoryBlock> blocks;
+    size_t arena_size{0};
+    // the slots of the blocks in the arena, or null for the empty blocks
+    std::vector<std::shared_ptr<memory::Allocation>> slots;
+  };
+
+  void FindVariables();
+  void MakeSignature(std::vector<int64_t>* signature) const;
+  void GroupVariables();
+  void MakeSlots(MemoryPlan* plan) const;
+
+  const platform::Place place_;
+  Scope* scope_;
+  const size_t max_num_plans_;
+  size_t num_ops_{0};
+  bool disabled_{false};
+  // whether the variables are found in the scope, on the first run
+  bool found_{false};
+
+  // the temporary variables and their lifetimes
+  std::vector<std::string> temp_names_;
+  std::vector<std::pair<size_t, size_t>> temp_lifetimes_;
+  std::vector<Variable*> temp_vars_;
+  // the variables read before they are written, whose shapes make the
+  // signature
+  std::vector<std::string> input_names_;
+  std::vector<Variable*> input_vars_;
+  // the other variables used by the ops, e.g. the parameters
+  std::vector<std::string> other_names_;
+
+  // the groups of the temporary variables sharing a buffer, found in the
+  // first run, and their lifetimes
+  bool grouped_{false};
+  std::vector<std::vector<size_t>> groups_;
+  std::vector<std::pair<size_t, size_t>> group_lifetimes_;
+
+  std::map<std::vector<int64_t>, MemoryPlan> plans_;
+  // the signature of the current run
+  std::vector<int64_t> signature_;
+  std::shared_ptr<memory::Allocation> arena_;
+  size_t unplanned_size_{0};
+
+  DISABLE_COPY_AND_ASSIGN(StaticMemoryPlanner);
+};
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,175 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/static_memory_planner.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/framework/lod_tensor.h"
+
+namespace paddle {
+namespace framework {
+
+// Out = X + 1
+class PlanTestAddOneOp : public OperatorBase {
+ public:
+  PlanTestAddOneOp(const std::string& x, const std::string& out)
+      : OperatorBase("plan_test_add_one", {{"X", {x}}}, {{"Out", {out}}},
+                     AttributeMap{}) {}
+
+ private:
+  void RunImpl(const Scope& scope,
+               const platform::Place& place) const override {
+    auto& x = scope.FindVar(Input("X"))->Get<LoDTensor>();
+    auto* out = scope.FindVar(Output("Out"))->GetMutable<LoDTensor>();
+    out->Resize(x.dims());
+    auto* out_data = out->mutable_data<float>(place);
+    for (int64_t i = 0; i < x.numel(); ++i) {
+      out_data[i] = x.data<float>()[i] + 1;
+    }
+  }
+};
+
+// Out shares the buffer of X
+class PlanTestShareOp : public OperatorBase {
+ public:
+  PlanTestShareOp(const std::string& x, const std::string& out)
+      : OperatorBase("plan_test_share", {{"X", {x}}}, {{"Out", {out}}},
+                     AttributeMap{}) {}
+
+ private:
+  void RunImpl(const Scope& scope,
+               const platform::Place& place) const override {
+    auto& x = scope.FindVar(Input("X"))->Get<LoDTensor>();
+    scope.FindVar(Output("Out"))->GetMutable<LoDTensor>()->ShareDataWith(x);
+  }
+};
+
+TEST(StaticMemoryPlanner, AssignOffsets) {
+  std::vector<StaticMemoryPlanner::MemoryBlock> blocks(5);
+  blocks[0].size = 100;
+  blocks[0].last_op = 1;
+  blocks[1].size = 50;
+  blocks[1].last_op = 3;
+  blocks[2].size = 60;
+  blocks[2].first_op = 2;
+  blocks[2].last_op = 3;
+  blocks[3].size = 40;
+  blocks[3].first_op = 2;
+  blocks[3].last_op = 3;
+  blocks[4].first_op = 1;
+  blocks[4].last_op = 2;
+  EXPECT_EQ(StaticMemoryPlanner::AssignOffsets(&blocks), 150UL);
+  EXPECT_EQ(blocks[0].offset, 0UL);
+  // the first one living at the same time as both 0 and 2
+  EXPECT_EQ(blocks[1].offset, 100UL);
+  EXPECT_EQ(blocks[2].offset, 0UL);
+  // the gap between 2 and 1
+  EXPECT_EQ(blocks[3].offset, 60UL);
+  EXPECT_EQ(blocks[4].offset, 0UL);
+}
+
+class StaticMemoryPlannerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    auto* w = scope_.Var("w")->GetMutable<LoDTensor>();
+    w->Resize({4});
+    w->mutable_data<float>(place_);
+    local_scope_ = &scope_.NewScope();
+    for (auto name : {"x", "a", "b", "c", "d", "f", "out"}) {
+      local_scope_->Var(name)->GetMutable<LoDTensor>();
+    }
+    ops_.emplace_back(new PlanTestAddOneOp("x", "a"));
+    ops_.emplace_back(new PlanTestAddOneOp("a", "b"));
+    ops_.emplace_back(new PlanTestAddOneOp("b", "c"));
+    ops_.emplace_back(new PlanTestShareOp("c", "d"));
+    ops_.emplace_back(new PlanTestShareOp("w", "f"));
+    ops_.emplace_back(new PlanTestAddOneOp("d", "out"));
+  }
+
+  // Run the ops on the input of rows x 8, and check the output.
+  bool Run(StaticMemoryPlanner* planner, int64_t rows) {
+    auto* x = local_scope_->FindVar("x")->GetMutable<LoDTensor>();
+    x->Resize({rows, 8});
+    auto* x_data = x->mutable_data<float>(place_);
+    for (int64_t i = 0; i < x->numel(); ++i) {
+      x_data[i] = i;
+    }
+    bool planned = planner->Apply();
+    for (auto& op : ops_) {
+      op->Run(*local_scope_, place_);
+    }
+    if (!planned) {
+      planner->Plan();
+    }
+    auto& out = Get("out");
+    EXPECT_EQ(out.numel(), rows * 8);
+    for (int64_t i = 0; i < out.numel(); ++i) {
+      EXPECT_EQ(out.data<float>()[i], i + 4);
+    }
+    return planned;
+  }
+
+  const LoDTensor& Get(const std::string& name) {
+    return local_scope_->FindVar(name)->Get<LoDTensor>();
+  }
+
+  platform::CPUPlace place_;
+  Scope scope_;
+  Scope* local_scope_;
+  std::vector<std::unique_ptr<OperatorBase>> ops_;
+};
+
+TEST_F(StaticMemoryPlannerTest, ReuseArena) {
+  StaticMemoryPlanner planner(ops_, local_scope_, place_, {"out"}, 2);
+  EXPECT_FALSE(Run(&planner, 2));
+  EXPECT_EQ(planner.num_plans(), 1UL);
+  // a, b, c and d, out of 64 bytes each, in which a and c, b and out reuse
+  // the memory
+  EXPECT_EQ(planner.unplanned_size(), 256UL);
+  EXPECT_EQ(planner.arena_size(), 128UL);
+
+  EXPECT_TRUE(Run(&planner, 2));
+  EXPECT_EQ(Get("a").data<float>(), Get("c").data<float>());
+  EXPECT_EQ(Get("b").data<float>(), Get("out").data<float>());
+  EXPECT_NE(Get("a").data<float>(), Get("b").data<float>());
+  EXPECT_TRUE(Get("d").IsSharedBufferWith(Get("c")));
+  // the buffer of the parameter is not planned
+  EXPECT_TRUE(
+      Get("f").IsSharedBufferWith(scope_.FindVar("w")->Get<LoDTensor>()));
+
+  auto out_holder = Get("out").Holder();
+  EXPECT_TRUE(Run(&planner, 2));
+  EXPECT_EQ(Get("out").Holder(), out_holder);
+
+  // a new signature grows the arena
+  EXPECT_FALSE(Run(&planner, 4));
+  EXPECT_EQ(planner.num_plans(), 2UL);
+  EXPECT_EQ(planner.arena_size(), 256UL);
+  EXPECT_TRUE(Run(&planner, 4));
+  EXPECT_TRUE(Run(&planner, 2));
+  EXPECT_NE(Get("out").Holder(), out_holder);
+
+  // no more plans
+  EXPECT_FALSE(Run(&planner, 3));
+  EXPECT_FALSE(Run(&planner, 3));
+  EXPECT_EQ(planner.num_plans(), 2UL);
+  EXPECT_TRUE(Run(&planner, 4));
+}
+
+}  // namespace framework
+}  // namespace paddle
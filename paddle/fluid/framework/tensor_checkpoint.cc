@@ -0,0 +1,495 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/tensor_checkpoint.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <future>  // NOLINT
+#include <memory>
+#include <sstream>
+
+#include "gflags/gflags.h"
+#include "paddle/fluid/framework/data_type.h"
+#include "paddle/fluid/framework/framework.pb.h"
+#include "paddle/fluid/framework/threadpool.h"
+#ifndef _WIN32
+#include <unistd.h>
+#include "paddle/fluid/memory/allocation/mmap_allocator.h"
+#else
+#include <process.h>
+#endif
+
+DEFINE_int32(checkpoint_io_threads, 8,
+             "Number of the threads of ThreadPoolIO, which read and write the "
+             "data of the checkpoints of save_combine and load_combine.");
+
+namespace paddle {
+namespace framework {
+
+namespace {
+
+struct CheckpointHeader {
+  uint64_t magic;
+  uint32_t version;
+  uint32_t num_tensors;
+};
+static_assert(sizeof(CheckpointHeader) == 16,
+              "CheckpointHeader is written to the checkpoints as it is.");
+
+// The data of the tensors are read and written in chunks of it, so that a
+// large tensor is read by several threads too.
+constexpr uint64_t kIOChunkSize = 64 << 20;
+
+template <typename CharT>
+struct IOChunk {
+  uint64_t offset;
+  CharT* data;
+  uint64_t size;
+};
+
+template <typename CharT>
+void AppendChunks(uint64_t offset, CharT* data, uint64_t size,
+                  std::vector<IOChunk<CharT>>* chunks) {
+  for (uint64_t begin = 0; begin < size; begin += kIOChunkSize) {
+    chunks->push_back(
+        {offset + begin, data + begin, std::min(kIOChunkSize, size - begin)});
+  }
+}
+
+// Run the worker on the threads of ThreadPoolIO, which share num_chunks chunks
+// of work, and rethrow the first exception of them.
+void RunWorkers(size_t num_chunks, const std::function<void()>& worker) {
+  size_t num_threads = std::min(
+      static_cast<size_t>(std::max(FLAGS_checkpoint_io_threads, 1)),
+      num_chunks);
+  if (num_threads <= 1) {
+    worker();
+    return;
+  }
+  std::vector<std::future<std::unique_ptr<platform::EnforceNotMet>>> futures;
+  futures.reserve(num_threads);
+  for (size_t i = 0; i < num_threads; ++i) {
+    futures.emplace_back(
+        ThreadPoolIO::GetInstanceIO()->RunAndGetException(worker));
+  }
+  std::unique_ptr<platform::EnforceNotMet> exception;
+  for (auto& future : futures) {
+    auto ex = future.get();
+    if (ex != nullptr && exception == nullptr) {
+      exception = std::move(ex);
+    }
+  }
+  if (exception != nullptr) {
+    throw *exception;
+  }
+}
+
+void ReadChunks(const std::string& file_path,
+                const std::vector<IOChunk<char>>& chunks) {
+  std::atomic<size_t> next(0);
+  RunWorkers(chunks.size(), [&] {
+    std::ifstream fin(file_path, std::ios::binary);
+    PADDLE_ENFORCE_EQ(static_cast<bool>(fin), true,
+                      platform::errors::Unavailable(
+                          "Cannot open %s to load the checkpoint.", file_path));
+    for (size_t i = next++; i < chunks.size(); i = next++) {
+      fin.seekg(static_cast<std::streamoff>(chunks[i].offset));
+      fin.read(chunks[i].data, static_cast<std::streamsize>(chunks[i].size));
+      PADDLE_ENFORCE_EQ(
+          static_cast<uint64_t>(fin.gcount()), chunks[i].size,
+          platform::errors::Unavailable(
+              "The checkpoint %s is truncated, please check whether the "
+              "file is complete or damaged.",
+              file_path));
+    }
+  });
+}
+
+void WriteChunks(const std::string& file_path,
+                 const std::vector<IOChunk<const char>>& chunks) {
+  std::atomic<size_t> next(0);
+  RunWorkers(chunks.size(), [&] {
+    std::fstream fout(file_path,
+                      std::ios::in | std::ios::out | std::ios::binary);
+    PADDLE_ENFORCE_EQ(static_cast<bool>(fout), true,
+                      platform::errors::Unavailable(
+                          "Cannot open %s to save the checkpoint.", file_path));
+    for (size_t i = next++; i < chunks.size(); i = next++) {
+      fout.seekp(static_cast<std::streamoff>(chunks[i].offset));
+      fout.write(chunks[i].data, static_cast<std::streamsize>(chunks[i].size));
+    }
+    fout.flush();
+    PADDLE_ENFORCE_EQ(static_cast<bool>(fout), true,
+                      platform::errors::Unavailable(
+                          "Failed to write the checkpoint %s.", file_path));
+  });
+}
+
+uint64_t AlignUp(uint64_t offset) {
+  return (offset + kCheckpointAlignment - 1) / kCheckpointAlignment *
+         kCheckpointAlignment;
+}
+
+std::string SerializeMeta(const LoDTensor& tensor) {
+  std::ostringstream os;
+  uint64_t lod_level = tensor.lod().size();
+  os.write(reinterpret_cast<const char*>(&lod_level), sizeof(lod_level));
+  for (auto& each : tensor.lod()) {
+    uint64_t size = each.size() * sizeof(LoD::value_type::value_type);
+    os.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    os.write(reinterpret_cast<const char*>(each.data()),
+             static_cast<std::streamsize>(size));
+  }
+  proto::VarType::TensorDesc desc;
+  desc.set_data_type(tensor.type());
+  auto dims = vectorize(tensor.dims());
+  auto* pb_dims = desc.mutable_dims();
+  pb_dims->Resize(static_cast<int>(dims.size()), 0);
+  std::copy(dims.begin(), dims.end(), pb_dims->begin());
+  auto desc_str = desc.SerializeAsString();
+  int32_t size = static_cast<int32_t>(desc_str.size());
+  os.write(reinterpret_cast<const char*>(&size), sizeof(size));
+  os.write(desc_str.data(), size);
+  return os.str();
+}
+
+// Set the LoD and the dims of the tensor by its meta, and return the size of
+// its data.
+uint64_t DeserializeMeta(const char* meta, uint64_t meta_size,
+                         LoDTensor* tensor, proto::VarType::Type* type) {
+  // the sizes are checked before the buffers are allocated by them, so that a
+  // damaged file fails the enforce below instead of the allocation
+  std::istringstream is(std::string(meta, meta_size));
+  uint64_t lod_level = 0;
+  is.read(reinterpret_cast<char*>(&lod_level), sizeof(lod_level));
+  LoD lod(static_cast<size_t>(std::min(lod_level, meta_size)));
+  for (auto& each : lod) {
+    uint64_t size = 0;
+    is.read(reinterpret_cast<char*>(&size), sizeof(size));
+    if (size > meta_size) {
+      is.setstate(std::ios::failbit);
+      break;
+    }
+    each.resize(size / sizeof(size_t));
+    is.read(reinterpret_cast<char*>(each.data()),
+            static_cast<std::streamsize>(size));
+  }
+  int32_t size = 0;
+  is.read(reinterpret_cast<char*>(&size), sizeof(size));
+  if (size < 0 || static_cast<uint64_t>(size) > meta_size) {
+    is.setstate(std::ios::failbit);
+    size = 0;
+  }
+  std::string desc_str(size, '\0');
+  is.read(&desc_str[0], size);
+  proto::VarType::TensorDesc desc;
+  PADDLE_ENFORCE_EQ(
+      static_cast<bool>(is) && lod.size() == lod_level &&
+          desc.ParseFromString(desc_str),
+      true, platform::errors::InvalidArgument(
+                "Cannot parse the meta of the tensor in the checkpoint, "
+                "please check whether the file is complete or damaged."));
+
+  tensor->set_lod(lod);
+  std::vector<int64_t> dims(desc.dims().begin(), desc.dims().end());
+  tensor->Resize(make_ddim(dims));
+  *type = desc.data_type();
+  return static_cast<uint64_t>(tensor->numel()) * SizeOfType(*type);
+}
+
+// Lay out the checkpoint of the tensors, and return its head, which is all
+// before the data of the first tensor.
+std::string LayOutCheckpoint(const std::vector<const LoDTensor*>& tensors,
+                             std::vector<CheckpointEntry>* entries,
+                             uint64_t* total_size) {
+  std::vector<std::string> metas;
+  metas.reserve(tensors.size());
+  entries->resize(tensors.size());
+  uint64_t offset =
+      sizeof(CheckpointHeader) + tensors.size() * sizeof(CheckpointEntry);
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    PADDLE_ENFORCE_EQ(platform::is_cpu_place(tensors[i]->place()), true,
+                      platform::errors::InvalidArgument(
+                          "Only the tensors on CPU can be saved to a "
+                          "checkpoint, but the tensor %d is on %s.",
+                          i, tensors[i]->place()));
+    metas.push_back(SerializeMeta(*tensors[i]));
+    (*entries)[i].meta_offset = offset;
+    (*entries)[i].meta_size = metas.back().size();
+    offset += metas.back().size();
+  }
+  uint64_t head_size = offset;
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    offset = AlignUp(offset);
+    (*entries)[i].data_offset = offset;
+    (*entries)[i].data_size = static_cast<uint64_t>(tensors[i]->numel()) *
+                              SizeOfType(tensors[i]->type());
+    offset += (*entries)[i].data_size;
+  }
+  *total_size = offset;
+
+  CheckpointHeader header{kCheckpointMagic, kCheckpointVersion,
+                          static_cast<uint32_t>(tensors.size())};
+  std::string head;
+  head.reserve(head_size);
+  head.append(reinterpret_cast<const char*>(&header), sizeof(header));
+  head.append(reinterpret_cast<const char*>(entries->data()),
+              entries->size() * sizeof(CheckpointEntry));
+  for (auto& meta : metas) {
+    head.append(meta);
+  }
+  return head;
+}
+
+// Check the head of a checkpoint of total_size bytes, whose first head_size
+// bytes are in head, and return its entries.
+std::vector<CheckpointEntry> ParseEntries(const char* head, uint64_t head_size,
+                                          uint64_t total_size,
+                                          size_t num_tensors) {
+  PADDLE_ENFORCE_EQ(IsCheckpoint(head, head_size), true,
+                    platform::errors::InvalidArgument(
+                        "The buffer is not a checkpoint saved by "
+                        "save_combine with with_offset_index."));
+  CheckpointHeader header;
+  std::memcpy(&header, head, sizeof(header));
+  PADDLE_ENFORCE_EQ(header.version, kCheckpointVersion,
+                    platform::errors::InvalidArgument(
+                        "The checkpoint version %u is not supported, only "
+                        "version %u is supported.",
+                        header.version, kCheckpointVersion));
+  PADDLE_ENFORCE_EQ(static_cast<size_t>(header.num_tensors), num_tensors,
+                    platform::errors::InvalidArgument(
+                        "The checkpoint has %u tensors, but %d tensors are "
+                        "to be loaded.",
+                        header.num_tensors, num_tensors));
+  uint64_t entries_end =
+      sizeof(CheckpointHeader) + num_tensors * sizeof(CheckpointEntry);
+  PADDLE_ENFORCE_LE(entries_end, head_size,
+                    platform::errors::InvalidArgument(
+                        "The checkpoint is truncated, please check whether "
+                        "the file is complete or damaged."));
+  std::vector<CheckpointEntry> entries(num_tensors);
+  std::memcpy(entries.data(), head + sizeof(CheckpointHeader),
+              num_tensors * sizeof(CheckpointEntry));
+  for (auto& entry : entries) {
+    PADDLE_ENFORCE_EQ(
+        entry.meta_offset >= entries_end && entry.meta_offset <= total_size &&
+            entry.meta_size <= total_size - entry.meta_offset &&
+            entry.data_offset <= total_size &&
+            entry.data_size <= total_size - entry.data_offset,
+        true, platform::errors::InvalidArgument(
+                  "The index of the checkpoint is out of its size %d, please "
+                  "check whether the file is complete or damaged.",
+                  total_size));
+  }
+  return entries;
+}
+
+// Set the LoD and the dims of the tensor i by its meta in the head, and return
+// the size of its data.
+uint64_t PrepareTensor(const char* head, const CheckpointEntry& entry,
+                       size_t i, LoDTensor* tensor,
+                       proto::VarType::Type* type) {
+  uint64_t size =
+      DeserializeMeta(head + entry.meta_offset, entry.meta_size, tensor, type);
+  PADDLE_ENFORCE_EQ(size, entry.data_size,
+                    platform::errors::InvalidArgument(
+                        "The data of the tensor %d in the checkpoint is %d "
+                        "bytes, but its dims need %d bytes.",
+                        i, entry.data_size, size));
+  return size;
+}
+
+uint64_t MetasEnd(const std::vector<CheckpointEntry>& entries) {
+  uint64_t end = 0;
+  for (auto& entry : entries) {
+    end = std::max(end, entry.meta_offset + entry.meta_size);
+  }
+  return end;
+}
+
+}  // namespace
+
+bool IsCheckpoint(const char* buffer, size_t size) {
+  uint64_t magic = 0;
+  if (size < sizeof(CheckpointHeader)) {
+    return false;
+  }
+  std::memcpy(&magic, buffer, sizeof(magic));
+  return magic == kCheckpointMagic;
+}
+
+bool IsCheckpointFile(const std::string& file_path) {
+  std::ifstream fin(file_path, std::ios::binary);
+  char buffer[sizeof(CheckpointHeader)];
+  fin.read(buffer, sizeof(buffer));
+  return static_cast<bool>(fin) && IsCheckpoint(buffer, sizeof(buffer));
+}
+
+// A file next to the checkpoint, unique to the process and the save, which
+// the checkpoint is written to before it is renamed to the checkpoint.
+static std::string TempCheckpointPath(const std::string& file_path) {
+  static std::atomic<uint64_t> save_id(0);
+#ifndef _WIN32
+  int pid = getpid();
+#else
+  int pid = _getpid();
+#endif
+  return file_path + ".tmp." + std::to_string(pid) + "." +
+         std::to_string(save_id++);
+}
+
+void SaveCheckpoint(const std::vector<const LoDTensor*>& tensors,
+                    const std::string& file_path) {
+  std::vector<CheckpointEntry> entries;
+  uint64_t total_size = 0;
+  std::string head = LayOutCheckpoint(tensors, &entries, &total_size);
+  // The checkpoint is written to a new file and renamed over the old one,
+  // since the old one may still be mapped by the tensors loaded with
+  // use_mmap, which would see it truncated and rewritten otherwise.
+  std::string tmp_path = TempCheckpointPath(file_path);
+  try {
+    {
+      std::ofstream fout(tmp_path, std::ios::binary | std::ios::trunc);
+      PADDLE_ENFORCE_EQ(
+          static_cast<bool>(fout), true,
+          platform::errors::Unavailable(
+              "Cannot open %s to save the checkpoint.", tmp_path));
+      fout.write(head.data(), static_cast<std::streamsize>(head.size()));
+      // extend the file to its full size, so that the threads write the data
+      // into the file at their offsets
+      if (total_size > head.size()) {
+        fout.seekp(static_cast<std::streamoff>(total_size - 1));
+        fout.put('\0');
+      }
+      fout.close();
+      PADDLE_ENFORCE_EQ(static_cast<bool>(fout), true,
+                        platform::errors::Unavailable(
+                            "Failed to write the checkpoint %s.", tmp_path));
+    }
+
+    std::vector<IOChunk<const char>> chunks;
+    for (size_t i = 0; i < tensors.size(); ++i) {
+      if (entries[i].data_size > 0) {
+        AppendChunks(entries[i].data_offset,
+                     static_cast<const char*>(tensors[i]->data<void>()),
+                     entries[i].data_size, &chunks);
+      }
+    }
+    WriteChunks(tmp_path, chunks);
+
+#ifdef _WIN32
+    // rename does not replace an existing file on Windows
+    std::remove(file_path.c_str());
+#endif
+    PADDLE_ENFORCE_EQ(
+        std::rename(tmp_path.c_str(), file_path.c_str()), 0,
+        platform::errors::Unavailable(
+            "Failed to rename %s to the checkpoint %s.", tmp_path, file_path));
+  } catch (...) {
+    std::remove(tmp_path.c_str());
+    throw;
+  }
+}
+
+void SaveCheckpointToString(const std::vector<const LoDTensor*>& tensors,
+                            std::string* buffer) {
+  std::vector<CheckpointEntry> entries;
+  uint64_t total_size = 0;
+  std::string head = LayOutCheckpoint(tensors, &entries, &total_size);
+  buffer->assign(total_size, '\0');
+  std::memcpy(&(*buffer)[0], head.data(), head.size());
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    if (entries[i].data_size > 0) {
+      std::memcpy(&(*buffer)[entries[i].data_offset],
+                  tensors[i]->data<void>(), entries[i].data_size);
+    }
+  }
+}
+
+void LoadCheckpoint(const std::string& file_path, bool use_mmap,
+                    const std::vector<LoDTensor*>& tensors) {
+  std::ifstream fin(file_path, std::ios::binary | std::ios::ate);
+  PADDLE_ENFORCE_EQ(static_cast<bool>(fin), true,
+                    platform::errors::Unavailable(
+                        "Cannot open %s to load the checkpoint.", file_path));
+  uint64_t total_size = static_cast<uint64_t>(fin.tellg());
+  fin.seekg(0);
+  // read the header and the entries, and then the metas they index
+  std::string head(std::min<uint64_t>(
+                       total_size, sizeof(CheckpointHeader) +
+                                       tensors.size() * sizeof(CheckpointEntry)),
+                   '\0');
+  fin.read(&head[0], static_cast<std::streamsize>(head.size()));
+  auto entries =
+      ParseEntries(head.data(), head.size(), total_size, tensors.size());
+  uint64_t metas_end = MetasEnd(entries);
+  if (metas_end > head.size()) {
+    size_t entries_end = head.size();
+    head.resize(metas_end);
+    fin.read(&head[entries_end],
+             static_cast<std::streamsize>(metas_end - entries_end));
+  }
+  PADDLE_ENFORCE_EQ(static_cast<bool>(fin), true,
+                    platform::errors::Unavailable(
+                        "The checkpoint %s is truncated, please check whether "
+                        "the file is complete or damaged.",
+                        file_path));
+  fin.close();
+
+  std::vector<IOChunk<char>> chunks;
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    auto* tensor = tensors[i];
+    proto::VarType::Type type;
+    uint64_t size = PrepareTensor(head.data(), entries[i], i, tensor, &type);
+#ifndef _WIN32
+    if (use_mmap && size >= kCheckpointMmapMinSize) {
+      tensor->clear();
+      tensor->ResetHolderWithType(
+          memory::allocation::AllocateMemoryMapFileAllocation(
+              file_path, entries[i].data_offset, size),
+          type);
+      continue;
+    }
+#endif
+    AppendChunks(entries[i].data_offset,
+                 static_cast<char*>(
+                     tensor->mutable_data(platform::CPUPlace(), type)),
+                 size, &chunks);
+  }
+  ReadChunks(file_path, chunks);
+}
+
+void LoadCheckpointFromString(const std::string& buffer,
+                              const std::vector<LoDTensor*>& tensors) {
+  auto entries = ParseEntries(buffer.data(), buffer.size(), buffer.size(),
+                              tensors.size());
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    proto::VarType::Type type;
+    uint64_t size =
+        PrepareTensor(buffer.data(), entries[i], i, tensors[i], &type);
+    void* data = tensors[i]->mutable_data(platform::CPUPlace(), type);
+    if (size > 0) {
+      std::memcpy(data, buffer.data() + entries[i].data_offset, size);
+    }
+  }
+}
+
+}  // namespace framework
+}  // namespace paddle
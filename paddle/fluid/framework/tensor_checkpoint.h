@@ -0,0 +1,89 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/lod_tensor.h"
+
+namespace paddle {
+namespace framework {
+
+// A checkpoint stores a list of LoDTensors with an index of the offsets of
+// their data, so that the tensors can be read in parallel, or mapped from the
+// file without being read at all. Its layout is
+//
+//   uint64_t        magic, which tells it from the files of SerializeToStream
+//   uint32_t        version
+//   uint32_t        number of the tensors
+//   CheckpointEntry entries[number of the tensors]
+//   the metas of the tensors, each of which is
+//     uint64_t lod_level
+//     uint64_t lod_level_1 size in byte
+//     size_t*  lod_level_1 data
+//     ...
+//     int32_t  size of the TensorDesc
+//     void*    protobuf message of the TensorDesc
+//   the data of the tensors, each of which starts at a multiple of
+//   kCheckpointAlignment
+//
+// All the integers are in the byte order of the host, as those written by
+// SerializeToStream are.
+constexpr uint64_t kCheckpointMagic = 0x54504b4344444150ULL;  // "PADDCKPT"
+constexpr uint32_t kCheckpointVersion = 0;
+constexpr uint64_t kCheckpointAlignment = 64;
+
+struct CheckpointEntry {
+  uint64_t meta_offset;
+  uint64_t meta_size;
+  uint64_t data_offset;
+  uint64_t data_size;
+};
+static_assert(sizeof(CheckpointEntry) == 32,
+              "CheckpointEntry is written to the checkpoints as it is.");
+
+// Tensors smaller than it are read even if use_mmap is true, since each of
+// the mappings takes a whole page and a system call.
+constexpr uint64_t kCheckpointMmapMinSize = 64 * 1024;
+
+// Whether the buffer starts with the magic of a checkpoint.
+bool IsCheckpoint(const char* buffer, size_t size);
+bool IsCheckpointFile(const std::string& file_path);
+
+// Save the tensors on CPU to a checkpoint. The data of the tensors are written
+// in chunks by FLAGS_checkpoint_io_threads threads of ThreadPoolIO, to a
+// temporary file which then replaces file_path, so the tensors still mapped
+// from the old file keep their data.
+void SaveCheckpoint(const std::vector<const LoDTensor*>& tensors,
+                    const std::string& file_path);
+void SaveCheckpointToString(const std::vector<const LoDTensor*>& tensors,
+                            std::string* buffer);
+
+// Load the tensors of a checkpoint to CPU. The number of the tensors has to be
+// the number of the tensors in the checkpoint. The data of the tensors are
+// read in chunks by FLAGS_checkpoint_io_threads threads of ThreadPoolIO, or,
+// if use_mmap is true, the tensors larger than kCheckpointMmapMinSize share
+// the pages of the file by copy-on-write mappings, which are read by the page
+// faults of the first access. use_mmap is ignored on Windows.
+void LoadCheckpoint(const std::string& file_path, bool use_mmap,
+                    const std::vector<LoDTensor*>& tensors);
+void LoadCheckpointFromString(const std::string& buffer,
+                              const std::vector<LoDTensor*>& tensors);
+
+}  // namespace framework
+}  // namespace paddle
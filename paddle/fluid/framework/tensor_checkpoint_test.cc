@@ -0,0 +1,171 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/tensor_checkpoint.h"
+
+#include <gflags/gflags.h>
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+DECLARE_int32(checkpoint_io_threads);
+
+namespace paddle {
+namespace framework {
+
+// Tensors of several types, a tensor larger than kCheckpointMmapMinSize, a
+// tensor with LoD and an empty tensor.
+static std::vector<LoDTensor> CreateTensors() {
+  platform::CPUPlace cpu;
+  std::vector<LoDTensor> tensors(5);
+  float* f = tensors[0].mutable_data<float>(make_ddim({3, 5}), cpu);
+  for (int i = 0; i < 15; ++i) {
+    f[i] = 0.5f * i;
+  }
+  int64_t* l = tensors[1].mutable_data<int64_t>(make_ddim({7}), cpu);
+  for (int i = 0; i < 7; ++i) {
+    l[i] = (1LL << 40) + i;
+  }
+  int64_t numel = kCheckpointMmapMinSize / sizeof(float) * 3 + 17;
+  f = tensors[2].mutable_data<float>(make_ddim({numel}), cpu);
+  for (int64_t i = 0; i < numel; ++i) {
+    f[i] = static_cast<float>(i % 1001);
+  }
+  int* n = tensors[3].mutable_data<int>(make_ddim({6, 1}), cpu);
+  for (int i = 0; i < 6; ++i) {
+    n[i] = -i;
+  }
+  tensors[3].set_lod({{0, 2, 6}, {0, 1, 2, 3, 4, 5, 6}});
+  tensors[4].mutable_data<double>(make_ddim({0, 4}), cpu);
+  return tensors;
+}
+
+static void CheckTensors(const std::vector<LoDTensor>& expected,
+                         const std::vector<LoDTensor>& actual) {
+  ASSERT_EQ(expected.size(), actual.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    ASSERT_EQ(expected[i].type(), actual[i].type());
+    ASSERT_EQ(expected[i].dims(), actual[i].dims());
+    ASSERT_EQ(expected[i].lod(), actual[i].lod());
+    ASSERT_TRUE(platform::is_cpu_place(actual[i].place()));
+    size_t size = expected[i].numel() * SizeOfType(expected[i].type());
+    if (size > 0) {
+      ASSERT_EQ(std::memcmp(expected[i].data<void>(), actual[i].data<void>(),
+                            size),
+                0);
+    }
+  }
+}
+
+template <typename T>
+static std::vector<T*> Pointers(std::vector<LoDTensor>* tensors) {
+  std::vector<T*> pointers;
+  for (auto& tensor : *tensors) {
+    pointers.push_back(&tensor);
+  }
+  return pointers;
+}
+
+static std::string FilePath(const std::string& name) {
+  return name + "_" + std::to_string(getpid()) + ".ckpt";
+}
+
+TEST(TensorCheckpoint, File) {
+  auto expected = CreateTensors();
+  std::string file_path = FilePath("tensor_checkpoint_file");
+  int io_threads = FLAGS_checkpoint_io_threads;
+  for (int threads : {1, 4}) {
+    FLAGS_checkpoint_io_threads = threads;
+    SaveCheckpoint(Pointers<const LoDTensor>(&expected), file_path);
+    ASSERT_TRUE(IsCheckpointFile(file_path));
+    for (bool use_mmap : {false, true}) {
+      // the tensors to load into are initialized by other dims and types
+      std::vector<LoDTensor> actual(expected.size());
+      for (auto& tensor : actual) {
+        tensor.mutable_data<int8_t>(make_ddim({3}), platform::CPUPlace());
+      }
+      LoadCheckpoint(file_path, use_mmap, Pointers<LoDTensor>(&actual));
+      CheckTensors(expected, actual);
+    }
+  }
+  FLAGS_checkpoint_io_threads = io_threads;
+
+  // the mapped tensor is copy-on-write, and outlives the removed file
+  std::vector<LoDTensor> mapped(expected.size());
+  LoadCheckpoint(file_path, true, Pointers<LoDTensor>(&mapped));
+  // saving over the file replaces it, and keeps the mapped one unchanged
+  auto changed = CreateTensors();
+  changed[2].data<float>()[1] = 2.f;
+  SaveCheckpoint(Pointers<const LoDTensor>(&changed), file_path);
+  ASSERT_EQ(mapped[2].data<float>()[1], 1.f);
+  std::vector<LoDTensor> reloaded(expected.size());
+  LoadCheckpoint(file_path, true, Pointers<LoDTensor>(&reloaded));
+  CheckTensors(changed, reloaded);
+  std::remove(file_path.c_str());
+  mapped[2].data<float>()[0] = -1.f;
+  ASSERT_EQ(mapped[2].data<float>()[1], 1.f);
+  ASSERT_FALSE(IsCheckpointFile(file_path));
+  ASSERT_THROW(LoadCheckpoint(file_path, false, Pointers<LoDTensor>(&mapped)),
+               platform::EnforceNotMet);
+}
+
+TEST(TensorCheckpoint, String) {
+  auto expected = CreateTensors();
+  std::string buffer;
+  SaveCheckpointToString(Pointers<const LoDTensor>(&expected), &buffer);
+  ASSERT_TRUE(IsCheckpoint(buffer.data(), buffer.size()));
+
+  std::vector<LoDTensor> actual(expected.size());
+  LoadCheckpointFromString(buffer, Pointers<LoDTensor>(&actual));
+  CheckTensors(expected, actual);
+
+  // the file saved has the same bytes
+  std::string file_path = FilePath("tensor_checkpoint_string");
+  SaveCheckpoint(Pointers<const LoDTensor>(&expected), file_path);
+  std::FILE* file = std::fopen(file_path.c_str(), "rb");
+  std::string file_buffer(buffer.size() + 1, '\0');
+  file_buffer.resize(
+      std::fread(&file_buffer[0], 1, file_buffer.size(), file));
+  std::fclose(file);
+  std::remove(file_path.c_str());
+  ASSERT_EQ(buffer, file_buffer);
+}
+
+TEST(TensorCheckpoint, Invalid) {
+  auto expected = CreateTensors();
+  std::string buffer;
+  SaveCheckpointToString(Pointers<const LoDTensor>(&expected), &buffer);
+
+  // the number of the tensors mismatches
+  std::vector<LoDTensor> actual(expected.size() - 1);
+  ASSERT_THROW(LoadCheckpointFromString(buffer, Pointers<LoDTensor>(&actual)),
+               platform::EnforceNotMet);
+  actual.resize(expected.size());
+  // truncated
+  ASSERT_THROW(LoadCheckpointFromString(buffer.substr(0, buffer.size() - 1),
+                                        Pointers<LoDTensor>(&actual)),
+               platform::EnforceNotMet);
+  // not a checkpoint
+  std::string damaged = buffer;
+  damaged[0] = 'X';
+  ASSERT_FALSE(IsCheckpoint(damaged.data(), damaged.size()));
+  ASSERT_THROW(LoadCheckpointFromString(damaged, Pointers<LoDTensor>(&actual)),
+               platform::EnforceNotMet);
+}
+
+}  // namespace framework
+}  // namespace paddle
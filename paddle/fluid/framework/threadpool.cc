@@ -95,6 +95,123 @@ void ThreadPool::TaskLoop() {
   }
 }
 
+thread_local WorkStealingThreadPool* WorkStealingThreadPool::current_pool_ =
+    nullptr;
+thread_local size_t WorkStealingThreadPool::current_worker_id_ = 0;
+
+WorkStealingThreadPool::WorkStealingThreadPool(size_t num_threads) {
+  PADDLE_ENFORCE_GT(num_threads, 0,
+                    platform::errors::InvalidArgument(
+                        "The number of threads should be larger than 0."));
+  workers_.resize(num_threads);
+  for (auto& worker : workers_) {
+    worker.reset(new Worker());
+  }
+  threads_.resize(num_threads);
+  for (size_t i = 0; i < num_threads; ++i) {
+    threads_[i].reset(
+        new std::thread(std::bind(&WorkStealingThreadPool::TaskLoop, this, i)));
+  }
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    running_ = false;
+  }
+  sleep_cond_.notify_all();
+
+  for (auto& t : threads_) {
+    t->join();
+    t.reset(nullptr);
+  }
+}
+
+void WorkStealingThreadPool::RunAndForget(Task fn) {
+  size_t worker_id = current_pool_ == this
+                         ? current_worker_id_
+                         : next_worker_.fetch_add(1) % workers_.size();
+  // Count the task before it is visible, so that pending_ never goes below
+  // zero.
+  pending_.fetch_add(1);
+  {
+    auto& worker = workers_[worker_id];
+    std::lock_guard<std::mutex> lock(worker->mutex);
+    worker->tasks.emplace_back(std::move(fn));
+  }
+  if (sleepers_.load() > 0) {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    sleep_cond_.notify_one();
+  }
+}
+
+bool WorkStealingThreadPool::PopTask(size_t worker_id, Task* task) {
+  {
+    auto& worker = workers_[worker_id];
+    std::lock_guard<std::mutex> lock(worker->mutex);
+    if (!worker->tasks.empty()) {
+      *task = std::move(worker->tasks.back());
+      worker->tasks.pop_back();
+      return true;
+    }
+  }
+  size_t num_workers = workers_.size();
+  for (size_t i = 1; i < num_workers; ++i) {
+    auto& victim = workers_[(worker_id + i) % num_workers];
+    std::lock_guard<std::mutex> lock(victim->mutex);
+    if (!victim->tasks.empty()) {
+      *task = std::move(victim->tasks.front());
+      victim->tasks.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+void WorkStealingThreadPool::TaskLoop(size_t worker_id) {
+  current_pool_ = this;
+  current_worker_id_ = worker_id;
+  constexpr int kSpinCount = 64;
+
+  while (true) {
+    Task task;
+    if (PopTask(worker_id, &task)) {
+      pending_.fetch_sub(1);
+      try {
+        task();
+      } catch (std::exception& ex) {
+        LOG(FATAL) << "Unexpected exception is catched in "
+                      "WorkStealingThreadPool, the task submitted by "
+                      "RunAndForget should handle its own exception: "
+                   << ex.what();
+      }
+      continue;
+    }
+
+    // A task may be in flight between pending_ and the deques, spin a while
+    // before going to sleep.
+    bool has_pending = false;
+    for (int i = 0; i < kSpinCount && !has_pending; ++i) {
+      has_pending = pending_.load() > 0;
+      if (!has_pending) {
+        std::this_thread::yield();
+      }
+    }
+    if (has_pending) {
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(sleep_mutex_);
+    ++sleepers_;
+    sleep_cond_.wait(lock,
+                     [this] { return pending_.load() > 0 || !running_; });
+    --sleepers_;
+    if (!running_ && pending_.load() == 0) {
+      return;
+    }
+  }
+}
+
 std::unique_ptr<ThreadPool> ThreadPoolIO::io_threadpool_(nullptr);
 std::once_flag ThreadPoolIO::io_init_flag_;
 
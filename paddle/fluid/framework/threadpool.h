@@ -14,7 +14,9 @@ limitations under the License. */
 
 #pragma once
 
+#include <atomic>
 #include <condition_variable>  // NOLINT
+#include <deque>
 #include <functional>
 #include <future>  // NOLINT
 #include <memory>
@@ -121,6 +123,70 @@ class ThreadPool {
   std::condition_variable scheduled_;
 };
 
+// WorkStealingThreadPool runs tasks using a fixed number of threads, each of
+// which owns a task deque. A task submitted by a worker is pushed to the
+// worker's own deque and popped in LIFO order, so that dependent tasks run on
+// the thread whose cache is hot. Idle workers steal tasks from the other end
+// of the other workers' deques. Tasks submitted by other threads are
+// distributed to the workers round-robin.
+class WorkStealingThreadPool {
+ public:
+  using Task = std::function<void()>;
+
+  explicit WorkStealingThreadPool(size_t num_threads);
+
+  // Waits until all submitted tasks are finished.
+  ~WorkStealingThreadPool();
+
+  size_t NumThreads() const { return threads_.size(); }
+
+  // Run pushes a function to the pool and returns a std::future object. The
+  // exception thrown by the function would be rethrown by
+  // std::future::get().
+  template <typename Callback>
+  std::future<void> Run(Callback fn) {
+    auto task = std::make_shared<std::packaged_task<void()>>(std::move(fn));
+    std::future<void> f = task->get_future();
+    RunAndForget([task] { (*task)(); });
+    return f;
+  }
+
+  // RunAndForget pushes a function to the pool without creating a future,
+  // which saves the shared state allocation and synchronization of each
+  // task. The function must handle its own exceptions.
+  void RunAndForget(Task fn);
+
+ private:
+  DISABLE_COPY_AND_ASSIGN(WorkStealingThreadPool);
+
+  struct Worker {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  void TaskLoop(size_t worker_id);
+
+  // Pops a task from the back of the own deque, or steals one from the front
+  // of other deques.
+  bool PopTask(size_t worker_id, Task* task);
+
+  // The pool and id of the worker running on the current thread.
+  static thread_local WorkStealingThreadPool* current_pool_;
+  static thread_local size_t current_worker_id_;
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::unique_ptr<std::thread>> threads_;
+
+  // number of tasks which are submitted but not popped yet
+  std::atomic<int64_t> pending_{0};
+  std::atomic<size_t> next_worker_{0};
+  std::atomic<bool> running_{true};
+
+  std::mutex sleep_mutex_;
+  std::condition_variable sleep_cond_;
+  std::atomic<int> sleepers_{0};
+};
+
 class ThreadPoolIO : ThreadPool {
  public:
   static ThreadPool* GetInstanceIO();
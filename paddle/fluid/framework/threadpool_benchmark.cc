@@ -0,0 +1,112 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Scheduling overhead benchmark of ThreadPool and WorkStealingThreadPool.
+// Each task does a tiny amount of work and then schedules its successors,
+// which is how FastThreadedSSAGraphExecutor runs the ready op handles.
+//
+// Usage:
+//   ./threadpool_benchmark --threads=4 --tasks=1000000 --fanout=2
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <condition_variable>  // NOLINT
+#include <iostream>
+#include <mutex>  // NOLINT
+#include <string>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/threadpool.h"
+
+DEFINE_int32(threads, 4, "Number of threads of the pools.");
+DEFINE_int32(tasks, 1000000, "Number of tasks to be scheduled.");
+DEFINE_int32(fanout, 2, "Number of successors scheduled by each task.");
+DEFINE_int32(work, 100, "Iterations of dummy work done by each task.");
+
+namespace paddle {
+namespace framework {
+
+static void DummyWork() {
+  volatile int x = 0;
+  for (int i = 0; i < FLAGS_work; ++i) {
+    x = x + i;
+  }
+}
+
+// Runs FLAGS_tasks tasks in a tree whose degree is FLAGS_fanout, and returns
+// the seconds it takes.
+template <typename SubmitFunc>
+static double RunTaskTree(SubmitFunc submit) {
+  std::atomic<int64_t> scheduled{1};
+  std::atomic<int64_t> finished{0};
+  std::mutex mutex;
+  std::condition_variable cv;
+
+  std::function<void()> task;
+  task = [&] {
+    DummyWork();
+    for (int i = 0; i < FLAGS_fanout; ++i) {
+      if (scheduled.fetch_add(1) >= FLAGS_tasks) {
+        scheduled.fetch_sub(1);
+        break;
+      }
+      submit(task);
+    }
+    if (finished.fetch_add(1) + 1 == scheduled.load()) {
+      std::lock_guard<std::mutex> lock(mutex);
+      cv.notify_one();
+    }
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  submit(task);
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [&] { return finished.load() == scheduled.load(); });
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end - start).count();
+}
+
+static void Report(const std::string& name, double seconds) {
+  std::cout << name << "\t" << seconds << "\t"
+            << FLAGS_tasks / seconds / 1e6 << std::endl;
+}
+
+}  // namespace framework
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  using paddle::framework::RunTaskTree;
+  using paddle::framework::Report;
+
+  std::cout << "pool\tseconds\tM tasks/s" << std::endl;
+  {
+    paddle::framework::ThreadPool pool(FLAGS_threads);
+    Report("ThreadPool::Run", RunTaskTree([&](const std::function<void()>& t) {
+             pool.Run(t);
+           }));
+  }
+  {
+    paddle::framework::WorkStealingThreadPool pool(FLAGS_threads);
+    Report("WorkStealingThreadPool::Run",
+           RunTaskTree([&](const std::function<void()>& t) { pool.Run(t); }));
+    Report("WorkStealingThreadPool::RunAndForget",
+           RunTaskTree(
+               [&](const std::function<void()>& t) { pool.RunAndForget(t); }));
+  }
+  return 0;
+}
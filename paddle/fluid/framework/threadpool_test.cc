@@ -59,3 +59,51 @@ TEST(ThreadPool, ConcurrentRun) {
   }
   EXPECT_EQ(sum, ((n + 1) * n) / 2);
 }
+
+TEST(WorkStealingThreadPool, RunAndForget) {
+  std::atomic<int> sum(0);
+  std::function<void(int)> spawn;
+  {
+    framework::WorkStealingThreadPool pool(4);
+    // Every task spawns children in the pool until the depth reaches 0, like
+    // how the executor schedules the pending ops of a finished op.
+    spawn = [&](int depth) {
+      sum.fetch_add(1);
+      if (depth > 0) {
+        pool.RunAndForget([&spawn, depth] { spawn(depth - 1); });
+        pool.RunAndForget([&spawn, depth] { spawn(depth - 1); });
+      }
+    };
+    pool.RunAndForget([&spawn] { spawn(10); });
+    // The destructor waits for all tasks.
+  }
+  EXPECT_EQ(sum, (1 << 11) - 1);
+}
+
+TEST(WorkStealingThreadPool, ConcurrentRun) {
+  framework::WorkStealingThreadPool pool(3);
+  std::atomic<int> sum(0);
+  std::vector<std::thread> threads;
+  std::vector<std::future<void>> fs;
+  std::mutex fs_mu;
+  int n = 50;
+  for (int i = 1; i <= n; ++i) {
+    threads.emplace_back([&, i] {
+      for (int j = 0; j < i; ++j) {
+        auto f = pool.Run([&sum] { sum.fetch_add(1); });
+        std::lock_guard<std::mutex> l(fs_mu);
+        fs.push_back(std::move(f));
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  for (auto& f : fs) {
+    f.get();
+  }
+  EXPECT_EQ(sum, ((n + 1) * n) / 2);
+
+  auto f = pool.Run([] { throw std::runtime_error("error in task"); });
+  EXPECT_THROW(f.get(), std::runtime_error);
+}
@@ -0,0 +1,160 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Time of the dygraph backward of a model of independent towers, run by the
+// BasicEngine with different numbers of threads.
+//
+// Each of the --tower_num towers is --layer_num layers of
+// h = relu(h * w) on a --batch_size x --hidden_size input, and the outputs
+// of the towers are summed, so that the grad ops of the towers are
+// independent of each other. The BLAS runs in one thread, so that the
+// speedup is that of the engine.
+//
+// Usage:
+//   ./backward_benchmark --tower_num=8 --layer_num=4 --hidden_size=256
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/imperative/basic_engine.h"
+#include "paddle/fluid/imperative/tracer.h"
+#include "paddle/fluid/platform/cpu_helper.h"
+#include "paddle/fluid/platform/init.h"
+
+DECLARE_int32(dygraph_backward_threads);
+
+DEFINE_int32(tower_num, 8, "Independent towers of the model.");
+DEFINE_int32(layer_num, 4, "Layers of each tower.");
+DEFINE_int32(hidden_size, 256, "Width of the layers.");
+DEFINE_int32(batch_size, 32, "Rows of the input.");
+DEFINE_int32(iterations, 20, "Backward runs of each measurement.");
+DEFINE_int32(repeat, 3,
+             "Repeats of each measurement, of which the fastest is reported.");
+DEFINE_string(threads, "1,2,4", "Numbers of the backward threads to time.");
+
+namespace paddle {
+namespace imperative {
+
+using VarPtr = std::shared_ptr<VarBase>;
+
+static VarPtr NewVar(Tracer* tracer, int64_t rows, int64_t cols,
+                     float scale) {
+  auto var = std::make_shared<VarBase>(true, tracer->GenerateUniqueName());
+  auto* tensor = var->MutableVar()->GetMutable<framework::LoDTensor>();
+  tensor->Resize({rows, cols});
+  auto* data = tensor->mutable_data<float>(platform::CPUPlace());
+  for (int64_t i = 0; i < tensor->numel(); ++i) {
+    data[i] = scale * static_cast<float>(i % 7 + 1);
+  }
+  var->SetOverridedStopGradient(false);
+  return var;
+}
+
+static VarPtr Trace(Tracer* tracer, const std::string& type,
+                    const NameVarBaseMap& ins) {
+  auto out = std::make_shared<VarBase>(true, tracer->GenerateUniqueName());
+  tracer->TraceOp(type, ins, {{"Out", {out}}}, framework::AttributeMap{},
+                  platform::CPUPlace(), true);
+  return out;
+}
+
+// Returns the milliseconds of one backward.
+static double RunBenchmark(int num_threads) {
+  FLAGS_dygraph_backward_threads = num_threads;
+  Tracer tracer;
+  auto x = NewVar(&tracer, FLAGS_batch_size, FLAGS_hidden_size, 0.1f);
+  std::vector<std::vector<VarPtr>> weights(FLAGS_tower_num);
+  for (auto& tower : weights) {
+    for (int l = 0; l < FLAGS_layer_num; ++l) {
+      tower.push_back(NewVar(&tracer, FLAGS_hidden_size, FLAGS_hidden_size,
+                             0.01f / FLAGS_hidden_size));
+    }
+  }
+
+  BasicEngine engine;
+  detail::BackwardStrategy strategy;
+  auto backward = [&] {
+    VarPtr loss;
+    for (auto& tower : weights) {
+      auto h = x;
+      for (auto& w : tower) {
+        h = Trace(&tracer, "relu", {{"X", {Trace(&tracer, "mul",
+                                                 {{"X", {h}}, {"Y", {w}}})}}});
+      }
+      loss = loss ? Trace(&tracer, "elementwise_add",
+                          {{"X", {loss}}, {"Y", {h}}})
+                  : h;
+    }
+    auto start = std::chrono::steady_clock::now();
+    engine.Init(loss.get(), strategy);
+    engine.Execute();
+    return std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+  };
+
+  backward();
+  double min_ms = 0;
+  for (int r = 0; r < FLAGS_repeat; ++r) {
+    double ms = 0;
+    for (int i = 0; i < FLAGS_iterations; ++i) {
+      ms += backward();
+    }
+    if (r == 0 || ms < min_ms) {
+      min_ms = ms;
+    }
+  }
+  return min_ms / FLAGS_iterations;
+}
+
+}  // namespace imperative
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  paddle::framework::InitDevices(false);
+  paddle::platform::SetNumThreads(1);
+
+  std::vector<int> threads;
+  std::string list = FLAGS_threads;
+  size_t pos = 0;
+  while (pos < list.size()) {
+    size_t end = std::min(list.find(',', pos), list.size());
+    threads.push_back(std::stoi(list.substr(pos, end - pos)));
+    pos = end + 1;
+  }
+
+  std::cout << "threads\tms/backward\tspeedup" << std::endl;
+  double base_ms = 0;
+  for (int num_threads : threads) {
+    double ms = paddle::imperative::RunBenchmark(num_threads);
+    if (base_ms == 0) {
+      base_ms = ms;
+    }
+    std::cout << num_threads << "\t" << ms << "\t" << base_ms / ms
+              << std::endl;
+  }
+  return 0;
+}
+
+USE_OP(relu);
+USE_OP(elementwise_add);
+USE_OP(mul);
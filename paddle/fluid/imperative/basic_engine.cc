@@ -15,6 +15,9 @@
 #include "paddle/fluid/imperative/basic_engine.h"
 
 #include <algorithm>
+#include <condition_variable>  // NOLINT
+#include <exception>
+#include <functional>
 #include <memory>
 #include <queue>
 #include <sstream>
@@ -23,6 +26,7 @@
 #include <unordered_set>
 #include <utility>
 #include <vector>
+#include "paddle/fluid/imperative/flags.h"
 #include "paddle/fluid/imperative/gradient_accumulator.h"
 #include "paddle/fluid/imperative/layer.h"
 #include "paddle/fluid/imperative/op_base.h"
@@ -132,6 +136,7 @@ void BasicEngine::PrepareDeps() {
 
   q.push(init_node_.get());
   visited.insert(init_node_.get());
+  all_cpu_ = true;
 
   while (!q.empty()) {
     auto* cur_node = q.front();
@@ -140,6 +145,7 @@ void BasicEngine::PrepareDeps() {
     for (auto& cur_op : *cur_node) {
       cur_op.EnforceHasInOut();
       PrepareGradAccumulators(cur_op);
+      all_cpu_ = all_cpu_ && platform::is_cpu_place(cur_op.place());
     }
 
     const auto& grad_pending_nodes = cur_node->GradPendingNodes();
@@ -154,91 +160,205 @@ void BasicEngine::PrepareDeps() {
       }
     }
   }
+  node_num_ = visited.size();
 }
 
-void BasicEngine::Execute() {
-  if (init_node_ == nullptr) {
-    return;
-  }
-
-  PrepareDeps();
-  // Start execute Computation graph
-  std::queue<std::shared_ptr<GradOpNode>> q;
-  q.push(std::move(init_node_));
-
-  size_t op_num = 0;
+size_t BasicEngine::RunGradNode(GradOpNode* node, bool parallel) {
+  std::vector<std::pair<GradientAccumulator*, std::shared_ptr<VariableWrapper>>>
+      need_accu_var_list;
+  for (auto& cur_op : *node) {
+    // CheckBackWardInput
+    if (parallel) {
+      std::lock_guard<std::mutex> guard(mutex_);
+      CheckBackwardInputs(cur_op);
+    } else {
+      CheckBackwardInputs(cur_op);
+    }
 
-  while (!q.empty()) {
-    auto shared_cur_node = std::move(q.front());
-    q.pop();
+    // Step 1: Run Backward
+    auto& bwd_ins = cur_op.GetInsMap();
+    auto& bwd_outs = cur_op.GetOutsMap();
 
-    for (auto& cur_op : *shared_cur_node) {
-      ++op_num;
+    NameVarMap<VariableWrapper> tmp_outs(bwd_outs);
+    // 1. construct the output map 2. replace the element in the map
+    // A var may be coresponding to several grad var in one op
+    for (auto& pair : tmp_outs) {
+      if (!pair.second.IsGrad()) {
+        continue;
+      }
 
-      // CheckBackWardInput
-      CheckBackwardInputs(cur_op);
+      for (auto& var : pair.second) {
+        if (!var) {
+          continue;
+        }
 
-      // Step 1: Run Backward
-      auto& bwd_ins = cur_op.GetInsMap();
-      auto& bwd_outs = cur_op.GetOutsMap();
+        auto iter = accumulators_.find(var.get());
+        PADDLE_ENFORCE_EQ(
+            iter != accumulators_.end(), true,
+            platform::errors::NotFound("Cannot find gradient of variable %s",
+                                       var->Name()));
 
-      NameVarMap<VariableWrapper> tmp_outs(bwd_outs);
-      // 1. construct the output map 2. replace the element in the map
-      // A var may be coresponding to several grad var in one op
-      for (auto& pair : tmp_outs) {
-        if (!pair.second.IsGrad()) {
+        if (!var->OverridedStopGradient() && iter->second->RefCnt() == 1) {
           continue;
         }
 
-        for (auto& var : pair.second) {
-          if (!var) {
-            continue;
-          }
+        var = std::make_shared<VariableWrapper>(var->Name());
+        need_accu_var_list.emplace_back(iter->second.get(), var);
+      }
+    }
+
+    {
+      VLOG(3) << "Start to execute grad op " << cur_op.Type();
+      OpBase::Run(cur_op.InnerOp(), bwd_ins, tmp_outs, cur_op.Attrs(),
+                  cur_op.place());
+    }
+
+    // Step 2: Sum Gradient
+    for (auto& pair : need_accu_var_list) {
+      if (parallel) {
+        pair.first->SyncAdd(std::move(pair.second), cur_op.id());
+      } else {
+        pair.first->Add(std::move(pair.second), cur_op.id());
+      }
+    }
 
-          auto iter = accumulators_.find(var.get());
-          PADDLE_ENFORCE_EQ(
-              iter != accumulators_.end(), true,
-              platform::errors::NotFound("Cannot find gradient of variable %s",
-                                         var->Name()));
+    need_accu_var_list.clear();
 
-          if (!var->OverridedStopGradient() && iter->second->RefCnt() == 1) {
-            continue;
-          }
+    VLOG(3) << "Remove op after op " << cur_op.Type() << " runs";
+    cur_op.ClearBackwardTrace();
+  }
+  return node->size();
+}
 
-          var = std::make_shared<VariableWrapper>(var->Name());
-          need_accu_var_list_.emplace_back(iter->second.get(), var);
+void BasicEngine::CollectReadyNodes(
+    const GradOpNode& node, std::vector<std::shared_ptr<GradOpNode>>* ready) {
+  for (auto& grad_pending_node : node.GradPendingNodes()) {
+    PADDLE_ENFORCE_NOT_NULL(grad_pending_node,
+                            platform::errors::NotFound(
+                                "Grad pending node should not be nullptr"));
+    auto iter = node_deps_.find(grad_pending_node.get());
+    if (iter == node_deps_.end()) {
+      continue;
+    }
+
+    if (--(iter->second) == 0) {
+      ready->push_back(grad_pending_node);
+    }
+  }
+}
+
+size_t BasicEngine::ExecuteParallel(int num_threads) {
+  if (thread_pool_size_ != num_threads) {
+    thread_pool_.reset(new ::ThreadPool(num_threads));
+    thread_pool_size_ = num_threads;
+  }
+
+  // The state of the run is shared by the caller and the tasks, since the
+  // task finishing last may still be running when the caller returns. The
+  // dependencies of the nodes are updated under its lock too.
+  struct ParallelState {
+    std::function<void(const std::shared_ptr<ParallelState>&,
+                       std::shared_ptr<GradOpNode>)>
+        run;
+    std::mutex mutex;
+    std::condition_variable finished;
+    // the nodes running or waiting in the pool
+    size_t running{1};
+    size_t op_num{0};
+    std::exception_ptr exception;
+  };
+  auto state = std::make_shared<ParallelState>();
+
+  // The node is moved out of the task when it runs, so that it is released
+  // before the run is done rather than with the task.
+  auto schedule = [this](const std::shared_ptr<ParallelState>& state,
+                         std::shared_ptr<GradOpNode> node) {
+    auto holder =
+        std::make_shared<std::shared_ptr<GradOpNode>>(std::move(node));
+    thread_pool_->enqueue(
+        [state, holder] { state->run(state, std::move(*holder)); });
+  };
+  state->run = [this, schedule](const std::shared_ptr<ParallelState>& state,
+                                std::shared_ptr<GradOpNode> node) {
+    std::vector<std::shared_ptr<GradOpNode>> ready;
+    while (node) {
+      size_t node_op_num = 0;
+      try {
+        node_op_num = RunGradNode(node.get(), true);
+      } catch (...) {
+        std::lock_guard<std::mutex> guard(state->mutex);
+        if (!state->exception) {
+          state->exception = std::current_exception();
         }
       }
 
+      ready.clear();
       {
-        VLOG(3) << "Start to execute grad op " << cur_op.Type();
-        OpBase::Run(cur_op.InnerOp(), bwd_ins, tmp_outs, cur_op.Attrs(),
-                    cur_op.place());
+        std::lock_guard<std::mutex> guard(state->mutex);
+        state->op_num += node_op_num;
+        // no more nodes run after an exception
+        if (!state->exception) {
+          CollectReadyNodes(*node, &ready);
+        }
+        if (ready.size() > 1) {
+          state->running += ready.size() - 1;
+        }
       }
-
-      // Step 2: Sum Gradient
-      for (auto& pair : need_accu_var_list_) {
-        pair.first->Add(std::move(pair.second), cur_op.id());
+      for (size_t i = 1; i < ready.size(); ++i) {
+        schedule(state, std::move(ready[i]));
       }
+      node = ready.empty() ? nullptr : std::move(ready[0]);
+    }
 
-      need_accu_var_list_.clear();
-
-      VLOG(3) << "Remove op after op " << cur_op.Type() << " runs";
-      cur_op.ClearBackwardTrace();
+    std::lock_guard<std::mutex> guard(state->mutex);
+    if (--state->running == 0) {
+      state->finished.notify_all();
     }
+  };
 
-    // Step 3: Collect ready ops
-    for (auto& grad_pending_node : shared_cur_node->GradPendingNodes()) {
-      PADDLE_ENFORCE_NOT_NULL(grad_pending_node,
-                              platform::errors::NotFound(
-                                  "Grad pending node should not be nullptr"));
-      auto iter = node_deps_.find(grad_pending_node.get());
-      if (iter == node_deps_.end()) {
-        continue;
-      }
+  schedule(state, std::move(init_node_));
+  {
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&state] { return state->running == 0; });
+  }
+
+  if (state->exception) {
+    Clear();
+    std::rethrow_exception(state->exception);
+  }
+  return state->op_num;
+}
+
+void BasicEngine::Execute() {
+  if (init_node_ == nullptr) {
+    return;
+  }
 
-      if (--(iter->second) == 0) {
-        q.push(grad_pending_node);
+  PrepareDeps();
+
+  size_t op_num = 0;
+  int num_threads = GetBackwardThreadNum();
+  if (num_threads > 1 && all_cpu_ && node_num_ > 1) {
+    VLOG(3) << "Run " << node_num_ << " grad nodes by " << num_threads
+            << " threads";
+    op_num = ExecuteParallel(num_threads);
+  } else {
+    // Start execute Computation graph
+    std::queue<std::shared_ptr<GradOpNode>> q;
+    q.push(std::move(init_node_));
+    std::vector<std::shared_ptr<GradOpNode>> ready;
+
+    while (!q.empty()) {
+      auto shared_cur_node = std::move(q.front());
+      q.pop();
+
+      op_num += RunGradNode(shared_cur_node.get(), false);
+
+      // Step 3: Collect ready ops
+      ready.clear();
+      CollectReadyNodes(*shared_cur_node, &ready);
+      for (auto& node : ready) {
+        q.push(std::move(node));
       }
     }
   }
@@ -251,7 +371,7 @@ void BasicEngine::Clear() {
   init_node_.reset();
   node_deps_.clear();
   accumulators_.clear();
-  need_accu_var_list_.clear();
+  node_num_ = 0;
 }
 
 }  // namespace imperative
@@ -15,9 +15,11 @@
 #pragma once
 
 #include <memory>
+#include <mutex>  // NOLINT
 #include <unordered_map>
 #include <utility>
 #include <vector>
+#include "ThreadPool.h"
 #include "paddle/fluid/imperative/backward_strategy.h"
 #include "paddle/fluid/imperative/engine.h"
 #include "paddle/fluid/imperative/gradient_accumulator.h"
@@ -28,6 +30,18 @@ namespace imperative {
 class VarBase;
 class OpBase;
 
+/*
+ * Runs the grad ops from the loss in the order of their dependencies. If
+ * FLAGS_dygraph_backward_threads is larger than 1 and all the grad ops are
+ * on CPU, the grad nodes whose dependencies are done run at the same time
+ * on a thread pool, where a thread goes on with one of the nodes made ready
+ * by the node it ran, and passes the others to the pool.
+ *
+ * The grads of a variable produced by the nodes running at the same time are
+ * added under the lock of its accumulator. With sorted_sum_gradient_ they are
+ * summed in the order of the trace, so the result is the same as the serial
+ * run, and otherwise in the order they are produced.
+ */
 class BasicEngine : public Engine {
  public:
   void Init(VarBase* var, const detail::BackwardStrategy& strategy);
@@ -41,6 +55,16 @@ class BasicEngine : public Engine {
 
   void PrepareGradAccumulators(const OpBase& op);
 
+  // Returns the number of the grad ops run.
+  size_t RunGradNode(GradOpNode* node, bool parallel);
+
+  // Counts down the dependencies of the pending nodes of the node run, and
+  // collects those ready to run.
+  void CollectReadyNodes(const GradOpNode& node,
+                         std::vector<std::shared_ptr<GradOpNode>>* ready);
+
+  size_t ExecuteParallel(int num_threads);
+
   void Clear();
 
  private:
@@ -49,8 +73,14 @@ class BasicEngine : public Engine {
   std::unordered_map<GradOpNode*, size_t> node_deps_;
   std::unordered_map<VariableWrapper*, std::unique_ptr<GradientAccumulator>>
       accumulators_;
-  std::vector<std::pair<GradientAccumulator*, std::shared_ptr<VariableWrapper>>>
-      need_accu_var_list_;
+  // the number of the grad nodes, and whether all the grad ops are on CPU
+  size_t node_num_{0};
+  bool all_cpu_{true};
+
+  std::unique_ptr<::ThreadPool> thread_pool_;
+  int thread_pool_size_{0};
+  // guards the zero grads set by CheckBackwardInputs in the parallel run
+  std::mutex mutex_;
 };
 
 }  // namespace imperative
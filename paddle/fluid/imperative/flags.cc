@@ -18,6 +18,17 @@
 DEFINE_uint64(dygraph_debug, 0,
               "Debug level of dygraph. This flag is not "
               "open to users");
+DEFINE_bool(dygraph_cache_prepared_op, false,
+            "Reuse the op instances and the kernels prepared for the dygraph "
+            "ops traced with the same attributes and the same data types, "
+            "places and layouts of the inputs, and the shapes inferred for "
+            "the same dims and LoDs of the inputs. It assumes the shapes "
+            "don't depend on the values of the inputs, which is true for most "
+            "ops.");
+DEFINE_int32(dygraph_backward_threads, 1,
+             "Number of the threads running the grad ops of the dygraph "
+             "backward on CPU. The grad ops whose inputs are ready run at "
+             "the same time if it is larger than 1.");
 
 namespace paddle {
 namespace imperative {
@@ -26,5 +37,9 @@ bool IsDebugEnabled() { return FLAGS_dygraph_debug != 0; }
 
 uint64_t GetDebugLevel() { return FLAGS_dygraph_debug; }
 
+bool IsPreparedOpCacheEnabled() { return FLAGS_dygraph_cache_prepared_op; }
+
+int GetBackwardThreadNum() { return FLAGS_dygraph_backward_threads; }
+
 }  // namespace imperative
 }  // namespace paddle
@@ -21,6 +21,8 @@ namespace imperative {
 
 extern bool IsDebugEnabled();
 extern uint64_t GetDebugLevel();
+extern bool IsPreparedOpCacheEnabled();
+extern int GetBackwardThreadNum();
 
 }  // namespace imperative
 }  // namespace paddle
@@ -15,6 +15,7 @@
 #pragma once
 
 #include <memory>
+#include <mutex>  // NOLINT
 #include <utility>
 #include <vector>
 #include "paddle/fluid/imperative/layer.h"
@@ -29,6 +30,13 @@ class GradientAccumulator {
   virtual void Add(std::shared_ptr<VariableWrapper> var, size_t trace_id,
                    bool unchange_input = false) = 0;
 
+  // Add from the grad ops run at the same time by the parallel backward.
+  void SyncAdd(std::shared_ptr<VariableWrapper> var, size_t trace_id,
+               bool unchange_input = false) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    Add(std::move(var), trace_id, unchange_input);
+  }
+
   virtual ~GradientAccumulator() = default;
 
   inline void IncreaseRefCnt() { ++ref_cnt_; }
@@ -38,6 +46,9 @@ class GradientAccumulator {
  protected:
   VariableWrapper* var_;
   size_t ref_cnt_{0};
+
+ private:
+  std::mutex mutex_;
 };
 
 class EagerGradientAccumulator : public GradientAccumulator {
@@ -51,6 +62,8 @@ class EagerGradientAccumulator : public GradientAccumulator {
   size_t cur_cnt_{0};
 };
 
+// Sums the grads in the reversed order of the ops tracing them, whatever
+// order they are added in, so the sum is deterministic.
 class SortedGradientAccumulator : public GradientAccumulator {
  public:
   using GradientAccumulator::GradientAccumulator;
@@ -15,6 +15,7 @@
 #include "paddle/fluid/imperative/prepared_operator.h"
 #include <sstream>
 #include "paddle/fluid/imperative/execution_context.h"
+#include "paddle/fluid/imperative/flags.h"
 #include "paddle/fluid/imperative/infer_shape_context.h"
 #include "paddle/fluid/imperative/infer_var_type_context.h"
 
@@ -63,11 +64,113 @@ static void PrepareData(const platform::Place& place,
   }
 }
 
+// the signatures cached for an op at most
+static constexpr size_t kMaxCachedSignaturesPerOp = 16;
+
+PreparedOpCache& PreparedOpCache::Instance() {
+  static thread_local PreparedOpCache cache;
+  return cache;
+}
+
+PreparedOpCache::Entry* PreparedOpCache::Find(
+    const std::string& type, const platform::Place& place,
+    const framework::AttributeMap& attrs, const std::string& slots,
+    const std::vector<int64_t>& signature) {
+  auto it = entries_.find(type);
+  if (it == entries_.end()) {
+    return nullptr;
+  }
+  for (auto& entry : it->second) {
+    if (entry->signature == signature && entry->slots == slots &&
+        entry->place == place && entry->attrs == attrs) {
+      return entry.get();
+    }
+  }
+  return nullptr;
+}
+
+PreparedOpCache::Entry* PreparedOpCache::Insert(const std::string& type,
+                                                std::unique_ptr<Entry> entry) {
+  auto& entries = entries_[type];
+  if (entries.size() >= kMaxCachedSignaturesPerOp) {
+    VLOG(3) << "Do not cache more signatures of op " << type;
+    return nullptr;
+  }
+  entries.emplace_back(std::move(entry));
+  ++size_;
+  return entries.back().get();
+}
+
+// Appends the names of the slots, and the types, data types, places and
+// layouts of their variables to the signature. The dims and LoDs of the
+// inputs are appended to the shapes, unless one is not a LoDTensor, when
+// it returns false.
+template <typename VarType>
+static bool AppendSignature(const NameVarMap<VarType>& vars, bool is_input,
+                            std::string* slots,
+                            std::vector<int64_t>* signature,
+                            std::vector<int64_t>* shapes) {
+  bool shape_cacheable = true;
+  for (auto& pair : vars) {
+    slots->append(pair.first);
+    slots->push_back(' ');
+    signature->push_back(static_cast<int64_t>(pair.second.size()));
+    for (auto& var : pair.second) {
+      if (!var) {
+        signature->push_back(-1);
+        shapes->push_back(-1);
+        continue;
+      }
+      signature->push_back(static_cast<int64_t>(var->Type()));
+      if (!is_input) {
+        shape_cacheable &= var->Type() == framework::proto::VarType::LOD_TENSOR;
+        continue;
+      }
+      const auto* tensor = GetTensorFromVar(var->Var());
+      if (tensor && tensor->IsInitialized()) {
+        signature->push_back(static_cast<int64_t>(tensor->type()));
+        auto& tensor_place = tensor->place();
+        signature->push_back(tensor_place.which());
+        auto* gpu_place = boost::get<platform::CUDAPlace>(&tensor_place);
+        signature->push_back(gpu_place ? gpu_place->device : 0);
+      } else {
+        signature->push_back(-1);
+      }
+      if (tensor) {
+        signature->push_back(static_cast<int64_t>(tensor->layout()));
+      }
+
+      if (!var->Var().template IsType<framework::LoDTensor>()) {
+        shape_cacheable = false;
+        continue;
+      }
+      auto& lod_tensor = var->Var().template Get<framework::LoDTensor>();
+      auto& dims = lod_tensor.dims();
+      shapes->push_back(dims.size());
+      for (int i = 0; i < dims.size(); ++i) {
+        shapes->push_back(dims[i]);
+      }
+      auto& lod = lod_tensor.lod();
+      shapes->push_back(static_cast<int64_t>(lod.size()));
+      for (auto& level : lod) {
+        shapes->push_back(static_cast<int64_t>(level.size()));
+        shapes->insert(shapes->end(), level.begin(), level.end());
+      }
+    }
+  }
+  return shape_cacheable;
+}
+
 PreparedOp::PreparedOp(const framework::OperatorBase& op,
                        const framework::RuntimeContext& ctx,
                        const framework::OperatorWithKernel::OpKernelFunc& func,
-                       platform::DeviceContext* dev_ctx)
-    : op_(op), ctx_(ctx), func_(func), dev_ctx_(dev_ctx) {}
+                       platform::DeviceContext* dev_ctx,
+                       PreparedOpCache::Entry* cache_entry)
+    : op_(op),
+      ctx_(ctx),
+      func_(func),
+      dev_ctx_(dev_ctx),
+      cache_entry_(cache_entry) {}
 
 template <typename VarType>
 PreparedOp PrepareOpImpl(const NameVarMap<VarType>& ins,
@@ -75,6 +178,29 @@ PreparedOp PrepareOpImpl(const NameVarMap<VarType>& ins,
                          const framework::OperatorWithKernel& op,
                          platform::Place place,
                          const framework::AttributeMap& attrs) {
+  bool use_cache = IsPreparedOpCacheEnabled();
+  std::string slots;
+  std::vector<int64_t> signature, shapes;
+  // the place may be changed to that of the kernel below
+  const platform::Place signature_place = place;
+  bool shape_cacheable = false;
+  if (use_cache) {
+    shape_cacheable =
+        AppendSignature<VarType>(ins, true, &slots, &signature, &shapes);
+    shape_cacheable &=
+        AppendSignature<VarType>(outs, false, &slots, &signature, &shapes);
+    auto* entry = PreparedOpCache::Instance().Find(op.Type(), place, attrs,
+                                                   slots, signature);
+    if (entry) {
+      PrepareData<VarType>(entry->dev_ctx->GetPlace(), ins, op,
+                           entry->kernel_type);
+      entry->shape_cacheable &= shape_cacheable;
+      entry->next_shapes.swap(shapes);
+      return PreparedOp(op, framework::RuntimeContext({}, {}), entry->func,
+                        entry->dev_ctx, entry);
+    }
+  }
+
   platform::DeviceContextPool& pool = platform::DeviceContextPool::Instance();
   auto* dev_ctx = pool.Get(place);
 
@@ -109,7 +235,20 @@ PreparedOp PrepareOpImpl(const NameVarMap<VarType>& ins,
   }
 
   PrepareData<VarType>(place, ins, op, expected_kernel_key);
-  return PreparedOp(op, ctx, kernel_iter->second, dev_ctx);
+
+  PreparedOpCache::Entry* entry = nullptr;
+  if (use_cache) {
+    entry = PreparedOpCache::Instance().Insert(
+        op.Type(), std::unique_ptr<PreparedOpCache::Entry>(
+                       new PreparedOpCache::Entry(
+                           signature_place, attrs, slots, signature,
+                           expected_kernel_key, kernel_iter->second, dev_ctx)));
+    if (entry) {
+      entry->shape_cacheable = shape_cacheable;
+      entry->next_shapes.swap(shapes);
+    }
+  }
+  return PreparedOp(op, ctx, kernel_iter->second, dev_ctx, entry);
 }
 
 PreparedOp PreparedOp::Prepare(const NameVarMap<VarBase>& ins,
@@ -128,18 +267,63 @@ PreparedOp PreparedOp::Prepare(const NameVarMap<VariableWrapper>& ins,
   return PrepareOpImpl<VariableWrapper>(ins, outs, op, place, attrs);
 }
 
+template <typename VarType>
+static void SaveOutputShapes(const NameVarMap<VarType>& outs,
+                             PreparedOpCache::Entry* entry) {
+  entry->output_dims.clear();
+  entry->output_lods.clear();
+  for (auto& pair : outs) {
+    for (auto& var : pair.second) {
+      if (var) {
+        auto& tensor = var->Var().template Get<framework::LoDTensor>();
+        entry->output_dims.push_back(tensor.dims());
+        entry->output_lods.push_back(tensor.lod());
+      }
+    }
+  }
+  entry->shapes.swap(entry->next_shapes);
+  entry->shape_valid = true;
+}
+
+template <typename VarType>
+static void RestoreOutputShapes(const NameVarMap<VarType>& outs,
+                                const PreparedOpCache::Entry& entry) {
+  size_t idx = 0;
+  for (auto& pair : outs) {
+    for (auto& var : pair.second) {
+      if (var) {
+        auto* tensor =
+            var->MutableVar()->template GetMutable<framework::LoDTensor>();
+        tensor->Resize(entry.output_dims[idx]);
+        tensor->set_lod(entry.output_lods[idx]);
+        ++idx;
+      }
+    }
+  }
+}
+
 template <typename VarType>
 static void PreparedOpRunImpl(
     const framework::OperatorBase& op, const framework::RuntimeContext& ctx,
     const framework::OperatorWithKernel::OpKernelFunc& func,
-    platform::DeviceContext* dev_ctx, const NameVarMap<VarType>& ins,
-    const NameVarMap<VarType>& outs, const framework::AttributeMap& attrs) {
+    platform::DeviceContext* dev_ctx, PreparedOpCache::Entry* cache_entry,
+    const NameVarMap<VarType>& ins, const NameVarMap<VarType>& outs,
+    const framework::AttributeMap& attrs) {
   // TODO(zjl): remove scope in dygraph
   framework::Scope scope;
 
-  DygraphInferShapeContext<VarType> infer_shape_ctx(&ins, &outs, &attrs);
-  static_cast<const framework::OperatorWithKernel&>(op).InferShape(
-      &infer_shape_ctx);
+  bool cache_shape = cache_entry && cache_entry->shape_cacheable;
+  if (cache_shape && cache_entry->shape_valid &&
+      cache_entry->next_shapes == cache_entry->shapes) {
+    RestoreOutputShapes<VarType>(outs, *cache_entry);
+  } else {
+    DygraphInferShapeContext<VarType> infer_shape_ctx(&ins, &outs, &attrs);
+    static_cast<const framework::OperatorWithKernel&>(op).InferShape(
+        &infer_shape_ctx);
+    if (cache_shape) {
+      SaveOutputShapes<VarType>(outs, cache_entry);
+    }
+  }
 
   func(DygraphExecutionContext<VarType>(op, scope, *dev_ctx, ctx, ins, outs,
                                         attrs));
@@ -148,14 +332,15 @@ static void PreparedOpRunImpl(
 void PreparedOp::Run(const NameVarMap<VarBase>& ins,
                      const NameVarMap<VarBase>& outs,
                      const framework::AttributeMap& attrs) {
-  PreparedOpRunImpl<VarBase>(op_, ctx_, func_, dev_ctx_, ins, outs, attrs);
+  PreparedOpRunImpl<VarBase>(op_, ctx_, func_, dev_ctx_, cache_entry_, ins,
+                             outs, attrs);
 }
 
 void PreparedOp::Run(const NameVarMap<VariableWrapper>& ins,
                      const NameVarMap<VariableWrapper>& outs,
                      const framework::AttributeMap& attrs) {
-  PreparedOpRunImpl<VariableWrapper>(op_, ctx_, func_, dev_ctx_, ins, outs,
-                                     attrs);
+  PreparedOpRunImpl<VariableWrapper>(op_, ctx_, func_, dev_ctx_, cache_entry_,
+                                     ins, outs, attrs);
 }
 
 }  // namespace imperative
@@ -15,6 +15,7 @@
 #pragma once
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 #include "paddle/fluid/framework/data_transform.h"
@@ -22,18 +23,96 @@
 #include "paddle/fluid/framework/operator.h"
 #include "paddle/fluid/imperative/layer.h"
 #include "paddle/fluid/imperative/type_defs.h"
+#include "paddle/fluid/platform/macros.h"
 
 namespace paddle {
 namespace imperative {
 
 const framework::Tensor* GetTensorFromVar(const framework::Variable& var);
 
+/*
+ * @brief The kernels prepared for the dygraph ops, reused by the later runs
+ * of an op with the same signature, i.e. the place, the attributes, the
+ * slots and the types, data types, places and layouts of the inputs.
+ *
+ * For each signature it also keeps the shapes of the outputs inferred from
+ * the dims and LoDs of the inputs of the last run, which are restored
+ * instead of running InferShape if the next run has the same. It assumes
+ * the shapes don't depend on the values of the inputs, which is true for
+ * most ops.
+ *
+ * Each thread has its own cache, used if FLAGS_dygraph_cache_prepared_op.
+ */
+class PreparedOpCache {
+ public:
+  struct Entry {
+    Entry(const platform::Place& place, const framework::AttributeMap& attrs,
+          const std::string& slots, const std::vector<int64_t>& signature,
+          const framework::OpKernelType& kernel_type,
+          const framework::OperatorWithKernel::OpKernelFunc& func,
+          platform::DeviceContext* dev_ctx)
+        : place(place),
+          attrs(attrs),
+          slots(slots),
+          signature(signature),
+          kernel_type(kernel_type),
+          func(func),
+          dev_ctx(dev_ctx) {}
+
+    const platform::Place place;
+    const framework::AttributeMap attrs;
+    // the names of the input and output slots
+    const std::string slots;
+    const std::vector<int64_t> signature;
+
+    const framework::OpKernelType kernel_type;
+    const framework::OperatorWithKernel::OpKernelFunc func;
+    platform::DeviceContext* const dev_ctx;
+
+    // false if an input or output is not a LoDTensor
+    bool shape_cacheable{true};
+    bool shape_valid{false};
+    std::vector<int64_t> shapes;
+    // the shapes of the inputs of the run being prepared
+    std::vector<int64_t> next_shapes;
+    std::vector<framework::DDim> output_dims;
+    std::vector<framework::LoD> output_lods;
+  };
+
+  static PreparedOpCache& Instance();
+
+  // Returns the entry of the signature, or null if it is not cached.
+  Entry* Find(const std::string& type, const platform::Place& place,
+              const framework::AttributeMap& attrs, const std::string& slots,
+              const std::vector<int64_t>& signature);
+
+  // Returns the entry added, or null if the op has too many signatures.
+  Entry* Insert(const std::string& type, std::unique_ptr<Entry> entry);
+
+  size_t size() const { return size_; }
+
+  void Clear() {
+    entries_.clear();
+    size_ = 0;
+  }
+
+ private:
+  PreparedOpCache() = default;
+
+  std::unordered_map<std::string, std::vector<std::unique_ptr<Entry>>>
+      entries_;
+  size_t size_{0};
+
+  DISABLE_COPY_AND_ASSIGN(PreparedOpCache);
+};
+
 class PreparedOp {
  public:
   PreparedOp(const framework::OperatorBase& op,
              const framework::RuntimeContext& ctx,
              const framework::OperatorWithKernel::OpKernelFunc& func,
-             platform::DeviceContext* dev_ctx);
+             platform::DeviceContext* dev_ctx,
+             PreparedOpCache::Entry* cache_entry = nullptr);
 
   static PreparedOp Prepare(const NameVarMap<VarBase>& ins,
                             const NameVarMap<VarBase>& outs,
@@ -56,9 +135,10 @@ class PreparedOp {
 
  private:
   const framework::OperatorBase& op_;
-  const framework::RuntimeContext& ctx_;
+  const framework::RuntimeContext ctx_;
   framework::OperatorWithKernel::OpKernelFunc func_;
   platform::DeviceContext* dev_ctx_;
+  PreparedOpCache::Entry* cache_entry_;
 };
 
 }  // namespace imperative
@@ -17,15 +17,21 @@
 //
 
 #include <paddle/fluid/framework/op_registry.h>
+#include <algorithm>
+#include <cmath>
 #include <memory>
 #include <set>
 #include <string>
 #include <vector>
 #include "gtest/gtest.h"
 #include "paddle/fluid/imperative/basic_engine.h"
+#include "paddle/fluid/imperative/prepared_operator.h"
 #include "paddle/fluid/imperative/tracer.h"
 #include "paddle/fluid/memory/memcpy.h"
 
+DECLARE_bool(dygraph_cache_prepared_op);
+DECLARE_int32(dygraph_backward_threads);
+
 namespace imperative = paddle::imperative;
 namespace platform = paddle::platform;
 namespace framework = paddle::framework;
@@ -379,6 +385,139 @@ TEST(test_tracer, test_var_without_grad_var) {
   }
 }
 
+TEST(test_tracer, test_prepared_op_cache) {
+  FLAGS_dygraph_cache_prepared_op = true;
+  auto& cache = PreparedOpCache::Instance();
+  cache.Clear();
+
+  Tracer tracer;
+  platform::CPUPlace place;
+  auto y = std::make_shared<VarBase>(true, "y");
+  auto* y_tensor = y->MutableVar()->GetMutable<framework::LoDTensor>();
+  y_tensor->Resize({5, 2});
+  std::fill_n(y_tensor->mutable_data<float>(place), 10, 2.0f);
+  y->SetOverridedStopGradient(false);
+
+  auto trace_mul = [&](int64_t rows) {
+    auto x = std::make_shared<VarBase>(true, "x");
+    auto* x_tensor = x->MutableVar()->GetMutable<framework::LoDTensor>();
+    x_tensor->Resize({rows, 5});
+    std::fill_n(x_tensor->mutable_data<float>(place), rows * 5, 2.0f);
+    auto out = std::make_shared<VarBase>(true, "out");
+    tracer.TraceOp("mul", NameVarBaseMap{{"X", {x}}, {"Y", {y}}},
+                   NameVarBaseMap{{"Out", {out}}}, framework::AttributeMap{},
+                   place, true);
+    auto& out_tensor = out->Var().Get<framework::LoDTensor>();
+    EXPECT_EQ(out_tensor.dims(), framework::make_ddim({rows, 2}));
+    for (int64_t i = 0; i < out_tensor.numel(); ++i) {
+      EXPECT_EQ(out_tensor.data<float>()[i], 20.0f);
+    }
+    return out;
+  };
+
+  trace_mul(2);
+  ASSERT_EQ(cache.size(), 1UL);
+  // the kernel and the shape of the output are reused
+  trace_mul(2);
+  ASSERT_EQ(cache.size(), 1UL);
+  // the shape is inferred again for the new shape of the input
+  trace_mul(3);
+  ASSERT_EQ(cache.size(), 1UL);
+
+  auto out = trace_mul(2);
+  detail::BackwardStrategy back_st;
+  BasicEngine engine;
+  engine.Init(out.get(), back_st);
+  engine.Execute();
+  // mul_grad
+  ASSERT_EQ(cache.size(), 2UL);
+  auto& y_grad = y->GradVar().Get<framework::LoDTensor>();
+  ASSERT_EQ(y_grad.numel(), 10);
+  for (int64_t i = 0; i < y_grad.numel(); ++i) {
+    ASSERT_EQ(y_grad.data<float>()[i], 4.0f);
+  }
+
+  cache.Clear();
+  FLAGS_dygraph_cache_prepared_op = false;
+}
+
+// Runs the backward of the sum of towers x * w_i, and returns the grads of x
+// and the w_i.
+static std::vector<std::vector<float>> RunTowersBackward(
+    int num_threads, bool sorted_sum_gradient) {
+  FLAGS_dygraph_backward_threads = num_threads;
+  Tracer tracer;
+  platform::CPUPlace place;
+  auto new_var = [&](const std::string& name, int64_t rows, int64_t cols,
+                     float start) {
+    auto var = std::make_shared<VarBase>(true, name);
+    auto* tensor = var->MutableVar()->GetMutable<framework::LoDTensor>();
+    tensor->Resize({rows, cols});
+    auto* data = tensor->mutable_data<float>(place);
+    for (int64_t i = 0; i < tensor->numel(); ++i) {
+      data[i] = start + 0.01f * i;
+    }
+    var->SetOverridedStopGradient(false);
+    return var;
+  };
+  auto trace = [&](const std::string& type, std::shared_ptr<VarBase> x,
+                   std::shared_ptr<VarBase> y) {
+    auto out = std::make_shared<VarBase>(true, tracer.GenerateUniqueName());
+    tracer.TraceOp(type, NameVarBaseMap{{"X", {x}}, {"Y", {y}}},
+                   NameVarBaseMap{{"Out", {out}}}, framework::AttributeMap{},
+                   place, true);
+    return out;
+  };
+
+  auto x = new_var("x", 4, 8, 0.3f);
+  std::vector<std::shared_ptr<VarBase>> ws;
+  std::shared_ptr<VarBase> sum;
+  for (int i = 0; i < 8; ++i) {
+    ws.push_back(new_var("w_" + std::to_string(i), 8, 8, 0.1f * i));
+    // the grads of x of the towers and of w_i of the layers are summed
+    auto hidden = trace("mul", x, ws.back());
+    auto out = trace("mul", trace("mul", hidden, ws.back()), ws.back());
+    sum = sum ? trace("elementwise_add", sum, out) : out;
+  }
+
+  detail::BackwardStrategy back_st;
+  back_st.sorted_sum_gradient_ = sorted_sum_gradient;
+  BasicEngine engine;
+  engine.Init(sum.get(), back_st);
+  engine.Execute();
+
+  std::vector<std::vector<float>> grads;
+  ws.insert(ws.begin(), x);
+  for (auto& var : ws) {
+    auto& grad = var->GradVar().Get<framework::LoDTensor>();
+    grads.emplace_back(grad.data<float>(), grad.data<float>() + grad.numel());
+  }
+  FLAGS_dygraph_backward_threads = 1;
+  return grads;
+}
+
+TEST(test_tracer, test_parallel_backward) {
+  for (bool sorted : {false, true}) {
+    auto expected = RunTowersBackward(1, sorted);
+    for (int repeat = 0; repeat < 10; ++repeat) {
+      auto grads = RunTowersBackward(4, sorted);
+      ASSERT_EQ(grads.size(), expected.size());
+      for (size_t i = 0; i < grads.size(); ++i) {
+        ASSERT_EQ(grads[i].size(), expected[i].size());
+        for (size_t j = 0; j < grads[i].size(); ++j) {
+          if (sorted) {
+            // summed in the same order
+            ASSERT_EQ(grads[i][j], expected[i][j]);
+          } else {
+            ASSERT_NEAR(grads[i][j], expected[i][j],
+                        1e-5 * std::abs(expected[i][j]));
+          }
+        }
+      }
+    }
+  }
+}
+
 template <typename T>
 using WeakPtrSet =
     std::set<std::weak_ptr<T>, std::owner_less<std::weak_ptr<T>>>;
@@ -16,6 +16,7 @@
 #include <unordered_set>
 #include <utility>
 #include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/imperative/flags.h"
 #include "paddle/fluid/imperative/op_base.h"
 #include "paddle/fluid/platform/profiler.h"
 #include "paddle/fluid/string/string_helper.h"
@@ -42,19 +43,35 @@ static void PassStopGradient(const NameVarBaseMap& outs, bool generate_grad) {
   }
 }
 
+const framework::OperatorBase& Tracer::GetOp(
+    const std::string& type,
+    std::unique_ptr<framework::OperatorBase>* op_holder) {
+  if (!IsPreparedOpCacheEnabled()) {
+    *op_holder = framework::OpRegistry::CreateOp(type, {}, {}, {}, false);
+    return **op_holder;
+  }
+  std::lock_guard<std::mutex> guard(op_cache_mutex_);
+  auto& op = op_cache_[type];
+  if (!op) {
+    op = framework::OpRegistry::CreateOp(type, {}, {}, {}, false);
+  }
+  return *op;
+}
+
 void Tracer::TraceOp(const std::string& type, const NameVarBaseMap& ins,
                      const NameVarBaseMap& outs, framework::AttributeMap attrs,
                      const platform::Place& place, bool trace_backward) {
   VLOG(1) << "Trace Op: " << type;
-  auto op = framework::OpRegistry::CreateOp(type, {}, {}, {}, false);
-  const auto& op_info = op->Info();
+  std::unique_ptr<framework::OperatorBase> op_holder;
+  const auto& op = GetOp(type, &op_holder);
+  const auto& op_info = op.Info();
   auto* attr_checker = op_info.Checker();
   if (attr_checker) {
     attr_checker->Check(&attrs, true);
   }
 
   try {
-    OpBase::Run(*op, ins, outs, attrs, place);
+    OpBase::Run(op, ins, outs, attrs, place);
   } catch (platform::EnforceNotMet& exception) {
     framework::AppendErrorOpHint(type, &exception);
     throw std::move(exception);
@@ -77,7 +94,7 @@ void Tracer::TraceOp(const std::string& type, const NameVarBaseMap& ins,
   }
 
   if (ComputeRequiredGrad(ins, outs, trace_backward)) {
-    CreateGradOpNode(*op, ins, outs, attrs, place);
+    CreateGradOpNode(op, ins, outs, attrs, place);
   } else {
     VLOG(3) << "No Grad to track for Op: " << type;
   }
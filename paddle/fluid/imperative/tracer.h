@@ -17,6 +17,7 @@
 #include <atomic>
 #include <future>  // NOLINT
 #include <memory>
+#include <mutex>  // NOLINT
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -98,12 +99,22 @@ class Tracer {
   void SetHasGrad(bool has_grad) { has_grad_ = has_grad; }
 
  private:
+  // Returns the op of the type, created once if FLAGS_dygraph_cache_prepared_op
+  // since the ops traced take the inputs, outputs and attributes as the
+  // arguments of the runs, or created into op_holder otherwise.
+  const framework::OperatorBase& GetOp(
+      const std::string& type,
+      std::unique_ptr<framework::OperatorBase>* op_holder);
+
   std::unique_ptr<BasicEngine> basic_engine_;
   std::unique_ptr<jit::ProgramDescTracer> program_desc_tracer_;
   bool enable_program_desc_tracing_{false};
   std::unique_ptr<UniqueNameGenerator> generator_;
   platform::Place expected_place_;
   bool has_grad_{true};
+  std::unordered_map<std::string, std::unique_ptr<framework::OperatorBase>>
+      op_cache_;
+  std::mutex op_cache_mutex_;
 };
 
 // To access static variable current_tracer
@@ -0,0 +1,153 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Throughput of the eager ops traced by the dygraph Tracer, with and without
+// the cached op instances, kernels and shapes.
+//
+// Each of the small ops runs on --size x --size tensors into a new output, as
+// in a dygraph program, so the time is dominated by Tracer::TraceOp rather
+// than by the kernel. The rnn row runs the steps of a small recurrent cell,
+// h = sigmoid(x * w + h * u), of 4 ops each, restarting from the initial
+// state every --seq_len steps.
+//
+// Usage:
+//   ./tracer_benchmark --size=4 --iterations=100000
+//   ./tracer_benchmark --trace_backward=true --seq_len=16
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/imperative/prepared_operator.h"
+#include "paddle/fluid/imperative/tracer.h"
+#include "paddle/fluid/platform/init.h"
+
+DECLARE_bool(dygraph_cache_prepared_op);
+
+DEFINE_int32(size, 4, "Rows and columns of the tensors.");
+DEFINE_int32(iterations, 100000, "Ops traced of each measurement.");
+DEFINE_int32(repeat, 3,
+             "Repeats of each measurement, of which the fastest is reported.");
+DEFINE_bool(trace_backward, false, "Whether to create the grad ops.");
+DEFINE_int32(seq_len, 16, "Steps of the rnn before it restarts.");
+
+namespace paddle {
+namespace imperative {
+
+using VarPtr = std::shared_ptr<VarBase>;
+
+static VarPtr NewVar(Tracer* tracer, float value) {
+  auto var = std::make_shared<VarBase>(FLAGS_trace_backward,
+                                       tracer->GenerateUniqueName());
+  auto* tensor = var->MutableVar()->GetMutable<framework::LoDTensor>();
+  tensor->Resize({FLAGS_size, FLAGS_size});
+  std::fill_n(tensor->mutable_data<float>(platform::CPUPlace()),
+              tensor->numel(), value);
+  var->SetOverridedStopGradient(!FLAGS_trace_backward);
+  return var;
+}
+
+static VarPtr Trace(Tracer* tracer, const std::string& type,
+                    const NameVarBaseMap& ins) {
+  auto out = std::make_shared<VarBase>(FLAGS_trace_backward,
+                                       tracer->GenerateUniqueName());
+  tracer->TraceOp(type, ins, {{"Out", {out}}}, framework::AttributeMap{},
+                  platform::CPUPlace(), FLAGS_trace_backward);
+  return out;
+}
+
+// Returns the ops traced per second.
+template <typename Callback>
+static double RunBenchmark(Callback callback, int ops_per_call) {
+  int calls = std::max(FLAGS_iterations / ops_per_call, 1);
+  callback();
+  double min_seconds = 0;
+  for (int r = 0; r < FLAGS_repeat; ++r) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < calls; ++i) {
+      callback();
+    }
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    if (r == 0 || seconds < min_seconds) {
+      min_seconds = seconds;
+    }
+  }
+  return calls * ops_per_call / min_seconds;
+}
+
+static void RunAll(bool cache) {
+  FLAGS_dygraph_cache_prepared_op = cache;
+  PreparedOpCache::Instance().Clear();
+  Tracer tracer;
+  auto x = NewVar(&tracer, 0.5f);
+  auto y = NewVar(&tracer, 0.25f);
+
+  for (std::string type : {"relu", "sigmoid"}) {
+    double ops = RunBenchmark([&] { Trace(&tracer, type, {{"X", {x}}}); }, 1);
+    std::cout << type << "\t" << cache << "\t" << ops << std::endl;
+  }
+  for (std::string type : {"elementwise_add", "mul"}) {
+    double ops = RunBenchmark(
+        [&] { Trace(&tracer, type, {{"X", {x}}, {"Y", {y}}}); }, 1);
+    std::cout << type << "\t" << cache << "\t" << ops << std::endl;
+  }
+
+  auto w = NewVar(&tracer, 0.1f);
+  auto u = NewVar(&tracer, 0.2f);
+  auto h0 = NewVar(&tracer, 0.0f);
+  double ops = RunBenchmark(
+      [&] {
+        auto h = h0;
+        for (int i = 0; i < FLAGS_seq_len; ++i) {
+          auto xw = Trace(&tracer, "mul", {{"X", {x}}, {"Y", {w}}});
+          auto hu = Trace(&tracer, "mul", {{"X", {h}}, {"Y", {u}}});
+          auto sum =
+              Trace(&tracer, "elementwise_add", {{"X", {xw}}, {"Y", {hu}}});
+          h = Trace(&tracer, "sigmoid", {{"X", {sum}}});
+        }
+        auto& tensor = h->Var().Get<framework::LoDTensor>();
+        PADDLE_ENFORCE_EQ(
+            tensor.dims(), h0->Var().Get<framework::LoDTensor>().dims(),
+            platform::errors::Fatal("The state of the rnn is reshaped."));
+      },
+      FLAGS_seq_len * 4);
+  std::cout << "rnn\t" << cache << "\t" << ops << std::endl;
+}
+
+}  // namespace imperative
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  paddle::framework::InitDevices(false);
+
+  std::cout << "op\tdygraph_cache_prepared_op\tops/s" << std::endl;
+  for (bool cache : {false, true}) {
+    paddle::imperative::RunAll(cache);
+  }
+  return 0;
+}
+
+USE_OP(relu);
+USE_OP(sigmoid);
+USE_OP(elementwise_add);
+USE_OP(mul);
@@ -108,6 +108,8 @@ AnalysisConfig::AnalysisConfig(const AnalysisConfig &other) {
   CP_MEMBER(memory_pool_init_size_mb_);
 
   CP_MEMBER(enable_memory_optim_);
+  CP_MEMBER(static_memory_plan_);
+  CP_MEMBER(static_memory_plan_max_num_plans_);
   // TensorRT related.
   CP_MEMBER(use_tensorrt_);
   CP_MEMBER(tensorrt_workspace_size_);
@@ -147,6 +149,15 @@ AnalysisConfig::AnalysisConfig(const AnalysisConfig &other) {
 
   CP_MEMBER(cpu_math_library_num_threads_);
 
+  CP_MEMBER(dynamic_batching_);
+  CP_MEMBER(dynamic_batching_max_batch_size_);
+  CP_MEMBER(dynamic_batching_max_latency_us_);
+  CP_MEMBER(dynamic_batching_num_workers_);
+
+  CP_MEMBER(numa_pool_);
+  CP_MEMBER(numa_pool_workers_per_node_);
+  CP_MEMBER(numa_pool_num_nodes_);
+
   CP_MEMBER(serialized_info_cache_);
 
   CP_MEMBER(thread_local_stream_);
@@ -366,6 +377,8 @@ std::string AnalysisConfig::SerializeInfoCache() {
   ss << tensorrt_min_subgraph_size_;
 
   ss << enable_memory_optim_;
+  ss << static_memory_plan_;
+  ss << static_memory_plan_max_num_plans_;
 
   ss << use_mkldnn_;
   ss << mkldnn_cache_capacity_;
@@ -386,6 +399,15 @@ std::string AnalysisConfig::SerializeInfoCache() {
   ss << specify_input_name_;
   ss << cpu_math_library_num_threads_;
 
+  ss << dynamic_batching_;
+  ss << dynamic_batching_max_batch_size_;
+  ss << dynamic_batching_max_latency_us_;
+  ss << dynamic_batching_num_workers_;
+
+  ss << numa_pool_;
+  ss << numa_pool_workers_per_node_;
+  ss << numa_pool_num_nodes_;
+
   ss << use_lite_;
 
   ss << thread_local_stream_;
@@ -400,6 +422,50 @@ void AnalysisConfig::SetCpuMathLibraryNumThreads(
   Update();
 }
 
+void AnalysisConfig::EnableDynamicBatching(int max_batch_size,
+                                           int max_latency_us,
+                                           int num_workers) {
+  PADDLE_ENFORCE_GT(max_batch_size, 0,
+                    platform::errors::InvalidArgument(
+                        "The max batch size of dynamic batching should be "
+                        "greater than 0, but received %d.",
+                        max_batch_size));
+  PADDLE_ENFORCE_GE(max_latency_us, 0,
+                    platform::errors::InvalidArgument(
+                        "The max latency of dynamic batching should not be "
+                        "negative, but received %d.",
+                        max_latency_us));
+  PADDLE_ENFORCE_GT(num_workers, 0,
+                    platform::errors::InvalidArgument(
+                        "The number of workers of dynamic batching should be "
+                        "greater than 0, but received %d.",
+                        num_workers));
+  dynamic_batching_ = true;
+  dynamic_batching_max_batch_size_ = max_batch_size;
+  dynamic_batching_max_latency_us_ = max_latency_us;
+  dynamic_batching_num_workers_ = num_workers;
+
+  Update();
+}
+
+void AnalysisConfig::EnableNumaPool(int workers_per_node, int num_nodes) {
+  PADDLE_ENFORCE_GT(workers_per_node, 0,
+                    platform::errors::InvalidArgument(
+                        "The number of workers of each node of the NUMA pool "
+                        "should be greater than 0, but received %d.",
+                        workers_per_node));
+  PADDLE_ENFORCE_GE(num_nodes, 0,
+                    platform::errors::InvalidArgument(
+                        "The number of nodes of the NUMA pool should not be "
+                        "negative, but received %d.",
+                        num_nodes));
+  numa_pool_ = true;
+  numa_pool_workers_per_node_ = workers_per_node;
+  numa_pool_num_nodes_ = num_nodes;
+
+  Update();
+}
+
 float AnalysisConfig::fraction_of_gpu_memory_for_pool() const {
 #ifdef PADDLE_WITH_CUDA
   // Get the GPU memory details and calculate the fraction of memory for the
@@ -425,6 +491,18 @@ bool AnalysisConfig::enable_memory_optim() const {
   return enable_memory_optim_;
 }
 
+void AnalysisConfig::EnableStaticMemoryPlan(int max_num_plans) {
+  PADDLE_ENFORCE_GT(max_num_plans, 0,
+                    platform::errors::InvalidArgument(
+                        "The max number of the static memory plans should be "
+                        "greater than 0, but received %d.",
+                        max_num_plans));
+  static_memory_plan_ = true;
+  static_memory_plan_max_num_plans_ = max_num_plans;
+
+  Update();
+}
+
 void AnalysisConfig::SetModelBuffer(const char *prog_buffer,
                                     size_t prog_buffer_size,
                                     const char *param_buffer,
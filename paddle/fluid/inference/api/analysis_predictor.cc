@@ -31,12 +31,15 @@
 #include "paddle/fluid/framework/version.h"
 #include "paddle/fluid/inference/analysis/helper.h"
 #include "paddle/fluid/inference/analysis/passes/memory_optimize_pass.h"
+#include "paddle/fluid/inference/api/batching_predictor.h"
 #include "paddle/fluid/inference/api/helper.h"
+#include "paddle/fluid/inference/api/numa_predictor_pool.h"
 #include "paddle/fluid/inference/api/paddle_inference_api.h"
 #include "paddle/fluid/inference/api/paddle_inference_pass.h"
 #include "paddle/fluid/inference/utils/singleton.h"
 #include "paddle/fluid/memory/memcpy.h"
 #include "paddle/fluid/platform/cpu_helper.h"
+#include "paddle/fluid/platform/cpu_info.h"
 #include "paddle/fluid/platform/device_context.h"
 #include "paddle/fluid/platform/gpu_info.h"
 #include "paddle/fluid/platform/place.h"
@@ -162,6 +165,16 @@ bool AnalysisPredictor::Init(
   // Get the feed_target_names and fetch_target_names
   PrepareFeedFetch();
 
+  if (config_.static_memory_plan_enabled()) {
+    if (config_.use_feed_fetch_ops_enabled()) {
+      LOG(WARNING) << "The static memory plan is only for ZeroCopyRun, "
+                      "turn off the feed and fetch ops to enable it.";
+    } else {
+      executor_->EnableStaticMemoryPlan(
+          GetOutputNames(), config_.static_memory_plan_max_num_plans());
+    }
+  }
+
   return true;
 }
 
@@ -588,17 +601,67 @@ std::unique_ptr<PaddlePredictor> CreatePaddlePredictor<
     }
   }
 
-  std::unique_ptr<PaddlePredictor> predictor(new AnalysisPredictor(config));
+  auto create = [&config]() -> std::unique_ptr<PaddlePredictor> {
+    std::unique_ptr<PaddlePredictor> predictor(new AnalysisPredictor(config));
+    auto predictor_p = dynamic_cast<AnalysisPredictor *>(predictor.get());
+
+    if (!predictor_p->Init(nullptr)) {
+      return nullptr;
+    }
+
+    if (config.mkldnn_quantizer_enabled() && !predictor_p->MkldnnQuantize()) {
+      return nullptr;
+    }
+    return predictor;
+  };
+
+  if (config.numa_pool_enabled()) {
+    PADDLE_ENFORCE_EQ(
+        config.use_gpu() || config.dynamic_batching_enabled(), false,
+        platform::errors::InvalidArgument(
+            "The NUMA pool can't be used with GPU or dynamic batching."));
+    auto node_cpus = platform::GetNumaNodeCpus();
+    if (config.numa_pool_num_nodes() > 0 &&
+        node_cpus.size() > static_cast<size_t>(config.numa_pool_num_nodes())) {
+      node_cpus.resize(config.numa_pool_num_nodes());
+    }
+    int workers_per_node = config.numa_pool_workers_per_node();
+    for (auto &cpus : node_cpus) {
+      int worker_cpu_num =
+          std::max(static_cast<int>(cpus.size()) / workers_per_node, 1);
+      if (config.cpu_math_library_num_threads() > worker_cpu_num) {
+        LOG(WARNING) << "The " << config.cpu_math_library_num_threads()
+                     << " math library threads of a worker of the NUMA pool "
+                     << "share its " << worker_cpu_num << " CPUs";
+        break;
+      }
+    }
+    VLOG(3) << "create the NUMA pool of " << node_cpus.size() << " nodes, "
+            << workers_per_node << " workers per node";
+    std::unique_ptr<PaddlePredictor> predictor(new NumaPredictorPool(
+        [&create](int node) { return create(); }, node_cpus,
+        workers_per_node));
+    // Each config can only be used for one predictor.
+    config.SetInValid();
+    return predictor;
+  }
+
+  auto predictor = create();
   // Each config can only be used for one predictor.
   config.SetInValid();
-  auto predictor_p = dynamic_cast<AnalysisPredictor *>(predictor.get());
-
-  if (!predictor_p->Init(nullptr)) {
+  if (!predictor) {
     return nullptr;
   }
 
-  if (config.mkldnn_quantizer_enabled() && !predictor_p->MkldnnQuantize()) {
-    return nullptr;
+  if (config.dynamic_batching_enabled()) {
+    std::vector<std::unique_ptr<PaddlePredictor>> predictors;
+    predictors.push_back(std::move(predictor));
+    for (int i = 1; i < config.dynamic_batching_num_workers(); ++i) {
+      predictors.push_back(predictors[0]->Clone());
+    }
+    predictor.reset(new BatchingPredictor(
+        std::move(predictors), config.dynamic_batching_max_batch_size(),
+        config.dynamic_batching_max_latency_us()));
   }
 
   return predictor;
@@ -667,6 +730,19 @@ AnalysisPredictor::GetInputTensorShape() {
   return input_shapes;
 }
 
+std::map<std::string, std::vector<int64_t>>
+AnalysisPredictor::GetOutputTensorShape() {
+  std::map<std::string, std::vector<int64_t>> output_shapes;
+  std::vector<std::string> names = GetOutputNames();
+  for (std::string name : names) {
+    auto *var = inference_program_->Block(0).FindVar(name);
+    PADDLE_ENFORCE_NOT_NULL(var, platform::errors::PreconditionNotMet(
+                                     "The output %s does not exist.", name));
+    output_shapes[name] = var->GetShape();
+  }
+  return output_shapes;
+}
+
 std::vector<std::string> AnalysisPredictor::GetOutputNames() {
   std::vector<std::string> output_names;
   for (auto &item : idx2fetches_) {
@@ -682,6 +758,7 @@ std::unique_ptr<ZeroCopyTensor> AnalysisPredictor::GetInputTensor(
       new ZeroCopyTensor(static_cast<void *>(executor_->scope())));
   res->input_or_output_ = true;
   res->SetName(name);
+  res->external_data_ = &external_data_;
   if (platform::is_cpu_place(place_)) {
     res->SetPlace(PaddlePlace::kCPU);
   } else {
@@ -699,6 +776,7 @@ std::unique_ptr<ZeroCopyTensor> AnalysisPredictor::GetOutputTensor(
       new ZeroCopyTensor(static_cast<void *>(executor_->scope())));
   res->input_or_output_ = false;
   res->SetName(name);
+  res->external_data_ = &external_data_;
   if (platform::is_cpu_place(place_)) {
     res->SetPlace(PaddlePlace::kCPU);
   } else {
@@ -711,6 +789,7 @@ std::unique_ptr<ZeroCopyTensor> AnalysisPredictor::GetOutputTensor(
 bool AnalysisPredictor::ZeroCopyRun() {
   paddle::platform::SetNumThreads(config_.cpu_math_library_num_threads());
   executor_->Run();
+  external_data_.SyncOutputs();
   // Fix TensorArray reuse not cleaned bug.
   tensor_array_batch_cleaner_.CollectTensorArrays(sub_scope_);
   tensor_array_batch_cleaner_.ResetTensorArray();
@@ -893,6 +972,7 @@ AnalysisPredictor::~AnalysisPredictor() {
     platform::DisableProfiler(platform::EventSortingKey::kTotal,
                               "./profile.log");
   }
+  external_data_.Clear();
   if (sub_scope_) {
     scope_->DeleteScope(sub_scope_);
   }
@@ -22,6 +22,7 @@
 #include "paddle/fluid/framework/op_compatible_info.h"
 #include "paddle/fluid/inference/analysis/analyzer.h"
 #include "paddle/fluid/inference/api/api_impl.h"
+#include "paddle/fluid/inference/api/details/external_data.h"
 #include "paddle/fluid/inference/api/details/reset_tensor_array.h"
 #include "paddle/fluid/inference/api/helper.h"
 #include "paddle/fluid/inference/api/paddle_inference_api.h"
@@ -156,6 +157,12 @@ class AnalysisPredictor : public PaddlePredictor {
   /// \return the map of input names and shapes
   ///
   std::map<std::string, std::vector<int64_t>> GetInputTensorShape() override;
+  ///
+  /// \brief Get all output names and their corresponding shapes
+  ///
+  /// \return the map of output names and shapes
+  ///
+  std::map<std::string, std::vector<int64_t>> GetOutputTensorShape() override;
 
   ///
   /// \brief Run the prediction engine
@@ -382,6 +389,9 @@ class AnalysisPredictor : public PaddlePredictor {
   // concurrency problems, wrong results and memory leak, so cache them.
   std::vector<framework::LoDTensor> feed_tensors_;
   details::TensorArrayBatchCleaner tensor_array_batch_cleaner_;
+  // The caller-owned buffers bound to the inputs and outputs by
+  // ZeroCopyTensor::ShareExternalData.
+  details::ExternalDataBindings external_data_;
   // A mutex help to make Clone thread safe.
   std::mutex clone_mutex_;
 
@@ -15,6 +15,8 @@
 #include "paddle/fluid/inference/api/analysis_predictor.h"
 #include <glog/logging.h>
 #include <gtest/gtest.h>
+#include <functional>
+#include <numeric>
 #include <thread>  // NOLINT
 #include "paddle/fluid/framework/ir/pass.h"
 #include "paddle/fluid/framework/tensor.h"
@@ -137,6 +139,58 @@ TEST(AnalysisPredictor, ZeroCopy) {
   LOG(INFO) << "output_data: " << out_data;
 }
 
+TEST(AnalysisPredictor, ZeroCopyExternalData) {
+  AnalysisConfig config;
+  config.SetModel(FLAGS_dirname);
+  config.SwitchUseFeedFetchOps(false);
+  auto predictor = CreatePaddlePredictor<AnalysisConfig>(config);
+  const std::vector<std::string> input_names = {"firstw", "secondw", "thirdw",
+                                                "forthw"};
+
+  // the output copied from the predictor
+  for (auto& name : input_names) {
+    auto input = predictor->GetInputTensor(name);
+    input->Reshape({4, 1});
+    int64_t data[4] = {0, 1, 2, 3};
+    input->copy_from_cpu(data);
+  }
+  ASSERT_TRUE(predictor->ZeroCopyRun());
+  auto out = predictor->GetOutputTensor("fc_1.tmp_2");
+  auto out_shape = out->shape();
+  int out_num = std::accumulate(out_shape.begin(), out_shape.end(), 1,
+                                std::multiplies<int>());
+  std::vector<float> expected(out_num);
+  out->copy_to_cpu(expected.data());
+
+  // the inputs and the output in the buffers of the caller
+  std::vector<std::vector<int64_t>> inputs(input_names.size(),
+                                           std::vector<int64_t>{0, 1, 2, 3});
+  for (size_t i = 0; i < input_names.size(); ++i) {
+    predictor->GetInputTensor(input_names[i])
+        ->ShareExternalData(inputs[i].data(), {4, 1});
+  }
+  std::vector<float> out_data(out_num, -1.f);
+  predictor->GetOutputTensor("fc_1.tmp_2")
+      ->ShareExternalData(out_data.data(), out_shape);
+  for (int r = 0; r < 2; ++r) {
+    ASSERT_TRUE(predictor->ZeroCopyRun());
+    out = predictor->GetOutputTensor("fc_1.tmp_2");
+    PaddlePlace place;
+    int size = 0;
+    EXPECT_EQ(out->data<float>(&place, &size), out_data.data());
+    EXPECT_EQ(size, out_num);
+    for (int i = 0; i < out_num; ++i) {
+      EXPECT_NEAR(out_data[i], expected[i], 1e-6);
+    }
+  }
+
+  // a buffer of the output too small
+  std::vector<float> small(1);
+  predictor->GetOutputTensor("fc_1.tmp_2")
+      ->ShareExternalData(small.data(), {1});
+  EXPECT_THROW(predictor->ZeroCopyRun(), platform::EnforceNotMet);
+}
+
 TEST(AnalysisPredictor, Clone) {
   AnalysisConfig config;
   config.SetModel(FLAGS_dirname);
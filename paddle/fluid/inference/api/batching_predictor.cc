@@ -0,0 +1,454 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/inference/api/batching_predictor.h"
+#include <glog/logging.h>
+#include <string.h>
+#include <algorithm>
+#include <exception>
+#include <utility>
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+
+namespace {
+
+size_t RowNum(const PaddleTensor &tensor) {
+  return tensor.shape.empty() ? 1 : static_cast<size_t>(tensor.shape[0]);
+}
+
+size_t RowBytes(const PaddleTensor &tensor) {
+  size_t bytes = PaddleDtypeSize(tensor.dtype);
+  for (size_t i = 1; i < tensor.shape.size(); ++i) {
+    bytes *= tensor.shape[i];
+  }
+  return bytes;
+}
+
+// The samples of a request are the sequences of its first input if it has
+// LoD, otherwise the rows of it.
+size_t SampleNum(const std::vector<PaddleTensor> &inputs) {
+  if (inputs.empty()) {
+    return 0;
+  }
+  const auto &lod = inputs[0].lod;
+  if (!lod.empty() && !lod[0].empty()) {
+    return lod[0].size() - 1;
+  }
+  return RowNum(inputs[0]);
+}
+
+bool CanConcat(const PaddleTensor &tensor) {
+  if (tensor.shape.empty() || tensor.shape[0] < 0) {
+    return false;
+  }
+  if (tensor.data.length() != RowNum(tensor) * RowBytes(tensor)) {
+    return false;
+  }
+  for (auto &level : tensor.lod) {
+    if (level.empty()) {
+      return false;
+    }
+  }
+  return tensor.lod.empty() || tensor.lod.back().back() == RowNum(tensor);
+}
+
+// Whether the inputs of two requests can be concatenated into a batch.
+bool Batchable(const std::vector<PaddleTensor> &a,
+               const std::vector<PaddleTensor> &b) {
+  if (a.size() != b.size() || a.empty()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.size(); ++i) {
+    const auto &x = a[i];
+    const auto &y = b[i];
+    if (x.name != y.name || x.dtype != y.dtype ||
+        x.shape.size() != y.shape.size() || x.lod.size() != y.lod.size() ||
+        !CanConcat(x) || !CanConcat(y) ||
+        !std::equal(x.shape.begin() + 1, x.shape.end(), y.shape.begin() + 1)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Concatenate the i-th inputs of the inputs along the first dimension. The
+// offsets of each level of LoD are shifted by the units of the next level the
+// former inputs have.
+PaddleTensor ConcatInputs(
+    const std::vector<const std::vector<PaddleTensor> *> &inputs, size_t i) {
+  const PaddleTensor &first = (*inputs[0])[i];
+  PaddleTensor tensor;
+  tensor.name = first.name;
+  tensor.dtype = first.dtype;
+  tensor.shape = first.shape;
+  tensor.lod.resize(first.lod.size(), std::vector<size_t>{0});
+  size_t row_num = 0;
+  for (auto *input : inputs) {
+    const PaddleTensor &t = (*input)[i];
+    row_num += RowNum(t);
+    for (size_t level = 0; level < t.lod.size(); ++level) {
+      auto &offsets = tensor.lod[level];
+      size_t shift = offsets.back();
+      for (size_t j = 1; j < t.lod[level].size(); ++j) {
+        offsets.push_back(t.lod[level][j] - t.lod[level][0] + shift);
+      }
+    }
+  }
+  tensor.shape[0] = static_cast<int>(row_num);
+  size_t row_bytes = RowBytes(first);
+  tensor.data.Resize(row_num * row_bytes);
+  char *dst = static_cast<char *>(tensor.data.data());
+  for (auto *input : inputs) {
+    const PaddleTensor &t = (*input)[i];
+    size_t bytes = RowNum(t) * row_bytes;
+    if (bytes > 0) {
+      memcpy(dst, t.data.data(), bytes);
+      dst += bytes;
+    }
+  }
+  return tensor;
+}
+
+// The rows and LoD of an output of a batch which belong to a request.
+struct OutputPart {
+  size_t begin;
+  size_t end;
+  std::vector<std::vector<size_t>> lod;
+};
+
+// Split an output of a batch into the parts of the requests, by the
+// sequences of its LoD, or by its rows.
+bool SplitOutput(const PaddleTensor &output,
+                 const std::vector<size_t> &sample_nums,
+                 const std::vector<size_t> &input_row_nums,
+                 std::vector<OutputPart> *parts) {
+  if (output.shape.empty()) {
+    return false;
+  }
+  size_t sample_num = 0, input_row_num = 0;
+  for (size_t i = 0; i < sample_nums.size(); ++i) {
+    sample_num += sample_nums[i];
+    input_row_num += input_row_nums[i];
+  }
+  size_t row_num = RowNum(output);
+  if (output.data.length() < row_num * RowBytes(output)) {
+    return false;
+  }
+  parts->clear();
+  if (!output.lod.empty() && output.lod[0].size() == sample_num + 1) {
+    size_t sequence = 0;
+    for (size_t n : sample_nums) {
+      OutputPart part;
+      size_t begin = sequence, end = sequence + n;
+      for (auto &level : output.lod) {
+        if (end >= level.size() || level[begin] > level[end]) {
+          return false;
+        }
+        std::vector<size_t> offsets;
+        for (size_t j = begin; j <= end; ++j) {
+          offsets.push_back(level[j] - level[begin]);
+        }
+        part.lod.push_back(std::move(offsets));
+        size_t next_begin = level[begin];
+        end = level[end];
+        begin = next_begin;
+      }
+      part.begin = begin;
+      part.end = end;
+      parts->push_back(std::move(part));
+      sequence += n;
+    }
+    return parts->back().end <= row_num;
+  }
+  if (!output.lod.empty()) {
+    return false;
+  }
+  const std::vector<size_t> *row_nums = nullptr;
+  if (row_num == sample_num) {
+    row_nums = &sample_nums;
+  } else if (row_num == input_row_num) {
+    row_nums = &input_row_nums;
+  } else {
+    return false;
+  }
+  size_t row = 0;
+  for (size_t n : *row_nums) {
+    parts->push_back(OutputPart{row, row + n, {}});
+    row += n;
+  }
+  return true;
+}
+
+void CopyOutputPart(const PaddleTensor &output, const OutputPart &part,
+                    PaddleTensor *tensor) {
+  size_t row_bytes = RowBytes(output);
+  tensor->name = output.name;
+  tensor->dtype = output.dtype;
+  tensor->shape = output.shape;
+  tensor->shape[0] = static_cast<int>(part.end - part.begin);
+  tensor->lod = part.lod;
+  size_t bytes = (part.end - part.begin) * row_bytes;
+  tensor->data.Resize(bytes);
+  if (bytes > 0) {
+    memcpy(tensor->data.data(),
+           static_cast<const char *>(output.data.data()) +
+               part.begin * row_bytes,
+           bytes);
+  }
+}
+
+}  // namespace
+
+BatchingPredictor::BatchingPredictor(
+    std::vector<std::unique_ptr<PaddlePredictor>> predictors,
+    int max_batch_size, int max_latency_us)
+    : predictors_(std::move(predictors)),
+      max_batch_size_(static_cast<size_t>(std::max(max_batch_size, 1))),
+      max_latency_(std::max(max_latency_us, 0)) {
+  PADDLE_ENFORCE_EQ(predictors_.empty(), false,
+                    platform::errors::InvalidArgument(
+                        "BatchingPredictor needs at least one predictor."));
+  for (auto &predictor : predictors_) {
+    PADDLE_ENFORCE_NOT_NULL(predictor.get(),
+                            platform::errors::InvalidArgument(
+                                "The predictors of BatchingPredictor should "
+                                "not be nullptr."));
+  }
+  // An output whose first dimension is fixed, e.g. a reduction of the batch,
+  // may happen to have as many rows as a batch has samples, and can't be
+  // split by them.
+  auto output_shapes = predictors_[0]->GetOutputTensorShape();
+  for (auto &item : output_shapes) {
+    if (!item.second.empty() && item.second[0] == -1) {
+      batch_outputs_.insert(item.first);
+    }
+  }
+  auto output_names = predictors_[0]->GetOutputNames();
+  batchable_ = !output_names.empty();
+  for (auto &name : output_names) {
+    batchable_ = batchable_ && batch_outputs_.count(name) > 0;
+  }
+  if (!batchable_) {
+    LOG(WARNING) << "The outputs of the model are not known to scale with "
+                    "the batch, BatchingPredictor runs the requests one by "
+                    "one";
+  }
+  for (auto &predictor : predictors_) {
+    workers_.emplace_back(&BatchingPredictor::WorkerLoop, this,
+                          predictor.get());
+  }
+}
+
+BatchingPredictor::~BatchingPredictor() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  queue_cv_.notify_all();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+bool BatchingPredictor::Run(const std::vector<PaddleTensor> &inputs,
+                            std::vector<PaddleTensor> *output_data,
+                            int batch_size) {
+  PADDLE_ENFORCE_NOT_NULL(output_data,
+                          platform::errors::InvalidArgument(
+                              "The output of Run should not be nullptr."));
+  Request request;
+  request.inputs = &inputs;
+  request.outputs = output_data;
+  request.sample_num = SampleNum(inputs);
+  request.arrival = std::chrono::steady_clock::now();
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (stop_) {
+    LOG(ERROR) << "BatchingPredictor is stopped";
+    return false;
+  }
+  queue_.push_back(&request);
+  queued_sample_num_ += request.sample_num;
+  queue_cv_.notify_one();
+  done_cv_.wait(lock, [&request] { return request.done; });
+  return request.success;
+}
+
+void BatchingPredictor::WorkerLoop(PaddlePredictor *predictor) {
+  while (true) {
+    std::vector<Request *> batch;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      while (true) {
+        if (queue_.empty()) {
+          if (stop_) {
+            return;
+          }
+          queue_cv_.wait(lock);
+          continue;
+        }
+        auto deadline = queue_.front()->arrival + max_latency_;
+        if (stop_ || queued_sample_num_ >= max_batch_size_ ||
+            std::chrono::steady_clock::now() >= deadline) {
+          break;
+        }
+        queue_cv_.wait_until(lock, deadline);
+      }
+      batch = TakeBatch();
+      if (!queue_.empty()) {
+        // the rest may be run by another worker
+        queue_cv_.notify_one();
+      }
+    }
+    bool success = false;
+    try {
+      success = RunBatch(predictor, batch);
+    } catch (std::exception &e) {
+      LOG(ERROR) << "BatchingPredictor failed to run a batch of "
+                 << batch.size() << " requests: " << e.what();
+    }
+    Finish(batch, success);
+  }
+}
+
+std::vector<BatchingPredictor::Request *> BatchingPredictor::TakeBatch() {
+  std::vector<Request *> batch{queue_.front()};
+  queue_.pop_front();
+  size_t sample_num = batch[0]->sample_num;
+  while (batchable_ && !queue_.empty() &&
+         sample_num + queue_.front()->sample_num <= max_batch_size_ &&
+         Batchable(*batch[0]->inputs, *queue_.front()->inputs)) {
+    sample_num += queue_.front()->sample_num;
+    batch.push_back(queue_.front());
+    queue_.pop_front();
+  }
+  queued_sample_num_ -= sample_num;
+  request_num_ += batch.size();
+  sample_num_ += sample_num;
+  return batch;
+}
+
+bool BatchingPredictor::RunBatch(PaddlePredictor *predictor,
+                                 const std::vector<Request *> &batch) {
+  ++batch_num_;
+  if (batch.size() == 1) {
+    return predictor->Run(*batch[0]->inputs, batch[0]->outputs);
+  }
+
+  std::vector<const std::vector<PaddleTensor> *> inputs;
+  std::vector<size_t> sample_nums, input_row_nums;
+  for (auto *request : batch) {
+    inputs.push_back(request->inputs);
+    sample_nums.push_back(request->sample_num);
+    input_row_nums.push_back(RowNum((*request->inputs)[0]));
+  }
+  std::vector<PaddleTensor> batch_inputs;
+  for (size_t i = 0; i < inputs[0]->size(); ++i) {
+    batch_inputs.push_back(ConcatInputs(inputs, i));
+  }
+  std::vector<PaddleTensor> batch_outputs;
+  if (!predictor->Run(batch_inputs, &batch_outputs)) {
+    return false;
+  }
+
+  std::vector<std::vector<OutputPart>> parts(batch_outputs.size());
+  bool splittable = true;
+  for (size_t i = 0; i < batch_outputs.size() && splittable; ++i) {
+    splittable =
+        batch_outputs_.count(batch_outputs[i].name) > 0 &&
+        SplitOutput(batch_outputs[i], sample_nums, input_row_nums, &parts[i]);
+  }
+  if (!splittable) {
+    VLOG(3) << "The outputs of a batch can't be split, run the "
+            << batch.size() << " requests one by one";
+    unbatched_num_ += batch.size();
+    bool success = true;
+    for (auto *request : batch) {
+      success = predictor->Run(*request->inputs, request->outputs) && success;
+    }
+    return success;
+  }
+  for (size_t r = 0; r < batch.size(); ++r) {
+    auto *outputs = batch[r]->outputs;
+    outputs->resize(batch_outputs.size());
+    for (size_t i = 0; i < batch_outputs.size(); ++i) {
+      CopyOutputPart(batch_outputs[i], parts[i][r], &(*outputs)[i]);
+    }
+  }
+  return true;
+}
+
+void BatchingPredictor::Finish(const std::vector<Request *> &batch,
+                               bool success) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto *request : batch) {
+      request->success = success;
+      request->done = true;
+    }
+  }
+  done_cv_.notify_all();
+}
+
+std::vector<std::string> BatchingPredictor::GetInputNames() {
+  return predictors_[0]->GetInputNames();
+}
+
+std::map<std::string, std::vector<int64_t>>
+BatchingPredictor::GetInputTensorShape() {
+  return predictors_[0]->GetInputTensorShape();
+}
+
+std::vector<std::string> BatchingPredictor::GetOutputNames() {
+  return predictors_[0]->GetOutputNames();
+}
+
+std::map<std::string, std::vector<int64_t>>
+BatchingPredictor::GetOutputTensorShape() {
+  return predictors_[0]->GetOutputTensorShape();
+}
+
+bool BatchingPredictor::ZeroCopyRun() {
+  LOG(ERROR) << "ZeroCopyRun is not supported with dynamic batching, please "
+                "use Run instead.";
+  return false;
+}
+
+std::unique_ptr<PaddlePredictor> BatchingPredictor::Clone() {
+  std::vector<std::unique_ptr<PaddlePredictor>> predictors;
+  for (auto &predictor : predictors_) {
+    predictors.push_back(predictor->Clone());
+    if (!predictors.back()) {
+      return nullptr;
+    }
+  }
+  return std::unique_ptr<PaddlePredictor>(new BatchingPredictor(
+      std::move(predictors), static_cast<int>(max_batch_size_),
+      static_cast<int>(max_latency_.count())));
+}
+
+std::string BatchingPredictor::GetSerializedProgram() const {
+  return predictors_[0]->GetSerializedProgram();
+}
+
+BatchingStat BatchingPredictor::GetStat() const {
+  BatchingStat stat;
+  stat.request_num = request_num_.load();
+  stat.batch_num = batch_num_.load();
+  stat.sample_num = sample_num_.load();
+  stat.unbatched_num = unbatched_num_.load();
+  return stat;
+}
+
+}  // namespace paddle
@@ -0,0 +1,158 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <atomic>
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <set>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+#include "paddle/fluid/inference/api/paddle_inference_api.h"
+
+///
+/// \file batching_predictor.h
+///
+/// \brief A predictor which batches the requests run concurrently by several
+/// threads, returned by CreatePaddlePredictor when
+/// AnalysisConfig::EnableDynamicBatching is called.
+///
+
+namespace paddle {
+
+///
+/// \brief Statistics of the batches run by a BatchingPredictor.
+///
+struct BatchingStat {
+  size_t request_num{0};  ///< requests run
+  size_t batch_num{0};    ///< batches taken from the queue
+  size_t sample_num{0};   ///< samples of the requests
+  /// runs of requests one by one, when their outputs can't be split
+  size_t unbatched_num{0};
+};
+
+///
+/// \class BatchingPredictor
+///
+/// \brief Run is thread safe, and the requests of the threads calling it are
+/// queued and concatenated into batches, which are run by a worker thread for
+/// each of the underlying predictors. The outputs of a batch are split back
+/// into the outputs of its requests.
+///
+/// A batch takes the queued requests in order while they have at most
+/// max_batch_size samples in total, and is run once it is full, or when its
+/// first request has waited max_latency_us microseconds. The samples of a
+/// request are the sequences of its first input if it has LoD, otherwise the
+/// first dimension of it. Requests are only batched together if their inputs
+/// have the same names, data types, LoD levels and dimensions except the
+/// first one. The inputs are concatenated along the first dimension and their
+/// LoD are merged.
+///
+/// Requests are only batched if all the outputs of the model scale with the
+/// batch, i.e. their first dimensions are -1 in GetOutputTensorShape of the
+/// predictors, otherwise they are run one by one. An output of a batch is
+/// split by the sequences of its LoD if it has as many sequences as the batch
+/// has samples, otherwise by its rows if it has as many rows as the batch has
+/// samples, or as the first inputs of the batch have rows. If an output can't
+/// be split, the requests of the batch are run one by one.
+///
+/// ZeroCopyRun is not supported, since the zero copy tensors belong to a
+/// single predictor.
+///
+class BatchingPredictor : public PaddlePredictor {
+ public:
+  ///
+  /// \param[in] predictors The predictors which run the batches, each by a
+  /// worker thread. They usually are the clones of a predictor.
+  /// \param[in] max_batch_size The maximum number of samples of a batch.
+  /// \param[in] max_latency_us The maximum time in microseconds a request
+  /// waits for other requests to join its batch.
+  ///
+  BatchingPredictor(std::vector<std::unique_ptr<PaddlePredictor>> predictors,
+                    int max_batch_size, int max_latency_us);
+  ///
+  /// \brief Run the queued requests and stop the worker threads.
+  ///
+  ~BatchingPredictor() override;
+
+  bool Run(const std::vector<PaddleTensor>& inputs,
+           std::vector<PaddleTensor>* output_data,
+           int batch_size = -1) override;
+
+  std::vector<std::string> GetInputNames() override;
+  std::map<std::string, std::vector<int64_t>> GetInputTensorShape() override;
+  std::vector<std::string> GetOutputNames() override;
+  std::map<std::string, std::vector<int64_t>> GetOutputTensorShape() override;
+
+  bool ZeroCopyRun() override;
+
+  ///
+  /// \brief Clone the underlying predictors into a new BatchingPredictor
+  /// with the same options and its own queue.
+  ///
+  std::unique_ptr<PaddlePredictor> Clone() override;
+
+  std::string GetSerializedProgram() const override;
+
+  BatchingStat GetStat() const;
+
+ private:
+  struct Request {
+    const std::vector<PaddleTensor>* inputs;
+    std::vector<PaddleTensor>* outputs;
+    size_t sample_num;
+    std::chrono::steady_clock::time_point arrival;
+    bool done{false};
+    bool success{false};
+  };
+
+  void WorkerLoop(PaddlePredictor* predictor);
+  // Take the requests of the next batch from the queue, which must not be
+  // empty. The lock must be held.
+  std::vector<Request*> TakeBatch();
+  // Run the batch and set the outputs of its requests.
+  bool RunBatch(PaddlePredictor* predictor,
+                const std::vector<Request*>& batch);
+  void Finish(const std::vector<Request*>& batch, bool success);
+
+  std::vector<std::unique_ptr<PaddlePredictor>> predictors_;
+  const size_t max_batch_size_;
+  const std::chrono::microseconds max_latency_;
+  // the outputs whose first dimensions scale with the batch
+  std::set<std::string> batch_outputs_;
+  // whether all the outputs scale with the batch, so requests are batched
+  bool batchable_{false};
+
+  std::mutex mutex_;
+  // notified when a request is queued or the predictor stops
+  std::condition_variable queue_cv_;
+  // notified when requests are done
+  std::condition_variable done_cv_;
+  std::deque<Request*> queue_;
+  size_t queued_sample_num_{0};
+  bool stop_{false};
+  std::vector<std::thread> workers_;
+
+  std::atomic<size_t> request_num_{0};
+  std::atomic<size_t> batch_num_{0};
+  std::atomic<size_t> sample_num_{0};
+  std::atomic<size_t> unbatched_num_{0};
+};
+
+}  // namespace paddle
@@ -0,0 +1,242 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Throughput and latency of serving small requests by a pool of predictors,
+// each running a request at a time, and by a BatchingPredictor with as many
+// workers. The clients send the requests in closed loops, with an optional
+// think time between them. The model is synthetic: a run costs a fixed
+// overhead, as the op dispatch and the kernel launches of a real model do,
+// plus a cost for each sample, so batching amortizes the overhead.
+//
+// Usage:
+//   ./batching_predictor_benchmark --clients=1,8,32 --workers=2 \
+//       --max_batch_size=32 --max_latency_us=1000
+
+#include <algorithm>
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/inference/api/batching_predictor.h"
+#include "paddle/fluid/string/split.h"
+
+DEFINE_string(clients, "1,8,32",
+              "Comma separated numbers of client threads to be tested.");
+DEFINE_int32(requests, 200, "Requests sent by each client.");
+DEFINE_int32(workers, 2, "Predictors serving the requests.");
+DEFINE_int32(max_batch_size, 32, "Maximum samples of a batch.");
+DEFINE_int32(max_latency_us, 1000,
+             "Maximum time a request waits for its batch to be filled.");
+DEFINE_int32(max_samples, 4, "Maximum samples of a request.");
+DEFINE_int32(width, 64, "Floats of a sample.");
+DEFINE_int32(run_overhead_us, 500, "Fixed cost of a run of the model.");
+DEFINE_int32(sample_cost_us, 20, "Cost of a sample in a run of the model.");
+DEFINE_int32(think_us, 0,
+             "Maximum random time a client waits between its requests.");
+
+namespace paddle {
+
+static void Spin(int us) {
+  auto end = std::chrono::steady_clock::now() + std::chrono::microseconds(us);
+  while (std::chrono::steady_clock::now() < end) {
+  }
+}
+
+// A model whose output is the sum of each sample of its input, and whose
+// cost is run_overhead_us + sample_cost_us * samples. The overhead sleeps,
+// like the waits of the real runs for the devices, and the samples spin.
+class SyntheticPredictor : public PaddlePredictor {
+ public:
+  bool Run(const std::vector<PaddleTensor> &inputs,
+           std::vector<PaddleTensor> *output_data,
+           int batch_size = -1) override {
+    const PaddleTensor &x = inputs[0];
+    size_t rows = x.shape[0];
+    size_t width = x.shape[1];
+    std::this_thread::sleep_for(
+        std::chrono::microseconds(FLAGS_run_overhead_us));
+    Spin(FLAGS_sample_cost_us * static_cast<int>(rows));
+
+    const float *data = static_cast<const float *>(x.data.data());
+    output_data->resize(1);
+    PaddleTensor &sum = (*output_data)[0];
+    sum.name = "sum";
+    sum.dtype = PaddleDType::FLOAT32;
+    sum.shape = {static_cast<int>(rows), 1};
+    sum.data.Resize(rows * sizeof(float));
+    float *sum_data = static_cast<float *>(sum.data.data());
+    for (size_t i = 0; i < rows; ++i) {
+      sum_data[i] = 0;
+      for (size_t j = 0; j < width; ++j) {
+        sum_data[i] += data[i * width + j];
+      }
+    }
+    return true;
+  }
+
+  std::vector<std::string> GetOutputNames() override { return {"sum"}; }
+
+  std::map<std::string, std::vector<int64_t>> GetOutputTensorShape() override {
+    return {{"sum", {-1, 1}}};
+  }
+
+  std::unique_ptr<PaddlePredictor> Clone() override {
+    return std::unique_ptr<PaddlePredictor>(new SyntheticPredictor);
+  }
+};
+
+// Predictors each serving a request at a time, taken by the clients from a
+// free list, as a service without batching does.
+class PredictorPool {
+ public:
+  explicit PredictorPool(int size) {
+    for (int i = 0; i < size; ++i) {
+      predictors_.emplace_back(new SyntheticPredictor);
+      free_.push_back(predictors_.back().get());
+    }
+  }
+
+  bool Run(const std::vector<PaddleTensor> &inputs,
+           std::vector<PaddleTensor> *outputs) {
+    PaddlePredictor *predictor;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this] { return !free_.empty(); });
+      predictor = free_.back();
+      free_.pop_back();
+    }
+    bool success = predictor->Run(inputs, outputs);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      free_.push_back(predictor);
+    }
+    cv_.notify_one();
+    return success;
+  }
+
+ private:
+  std::vector<std::unique_ptr<PaddlePredictor>> predictors_;
+  std::vector<PaddlePredictor *> free_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+};
+
+// Send the requests of a client, and record their latencies in microseconds.
+template <typename RunFunc>
+static void RunClient(int id, RunFunc run, std::vector<double> *latencies) {
+  std::mt19937 rng(id + 1);
+  std::uniform_int_distribution<int> samples_dist(1, FLAGS_max_samples);
+  std::uniform_int_distribution<int> think_dist(0, FLAGS_think_us);
+  std::vector<float> data(FLAGS_max_samples * FLAGS_width, 1.f);
+  std::vector<PaddleTensor> inputs(1), outputs;
+  PaddleTensor &x = inputs[0];
+  x.name = "x";
+  x.dtype = PaddleDType::FLOAT32;
+  for (int i = 0; i < FLAGS_requests; ++i) {
+    int samples = samples_dist(rng);
+    x.shape = {samples, FLAGS_width};
+    x.data.Reset(data.data(), samples * FLAGS_width * sizeof(float));
+    outputs.clear();
+    auto start = std::chrono::steady_clock::now();
+    bool success = run(inputs, &outputs);
+    latencies->push_back(std::chrono::duration<double, std::micro>(
+                             std::chrono::steady_clock::now() - start)
+                             .count());
+    CHECK(success);
+    CHECK_EQ(outputs[0].shape[0], samples);
+    CHECK_EQ(static_cast<float *>(outputs[0].data.data())[0], FLAGS_width);
+    if (FLAGS_think_us > 0) {
+      std::this_thread::sleep_for(std::chrono::microseconds(think_dist(rng)));
+    }
+  }
+}
+
+template <typename RunFunc>
+static void RunBenchmark(const std::string &mode, int client_num, RunFunc run,
+                         BatchingPredictor *batching) {
+  std::vector<std::vector<double>> latencies(client_num);
+  std::vector<std::thread> clients;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < client_num; ++i) {
+    clients.emplace_back(RunClient<RunFunc>, i, run, &latencies[i]);
+  }
+  for (auto &th : clients) {
+    th.join();
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  std::vector<double> all;
+  for (auto &l : latencies) {
+    all.insert(all.end(), l.begin(), l.end());
+  }
+  std::sort(all.begin(), all.end());
+  auto percentile = [&all](double p) {
+    return all[std::min(all.size() - 1, static_cast<size_t>(p * all.size()))];
+  };
+  double avg_batch_size = 1;
+  if (batching != nullptr) {
+    auto stat = batching->GetStat();
+    avg_batch_size = static_cast<double>(stat.request_num) /
+                     std::max<size_t>(stat.batch_num, 1);
+  }
+  std::cout << mode << "\t" << client_num << "\t" << all.size() / seconds
+            << "\t" << percentile(0.5) << "\t" << percentile(0.99) << "\t"
+            << avg_batch_size << std::endl;
+}
+
+}  // namespace paddle
+
+int main(int argc, char *argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+
+  std::cout << "mode\tclients\trequests/s\tp50 us\tp99 us\t"
+            << "requests/batch" << std::endl;
+  for (auto &s : paddle::string::Split(FLAGS_clients, ',')) {
+    int client_num = std::stoi(s);
+    using Tensors = std::vector<paddle::PaddleTensor>;
+
+    paddle::PredictorPool pool(FLAGS_workers);
+    paddle::RunBenchmark("pool", client_num,
+                         [&pool](const Tensors &inputs, Tensors *outputs) {
+                           return pool.Run(inputs, outputs);
+                         },
+                         nullptr);
+
+    std::vector<std::unique_ptr<paddle::PaddlePredictor>> predictors;
+    for (int i = 0; i < FLAGS_workers; ++i) {
+      predictors.emplace_back(new paddle::SyntheticPredictor);
+    }
+    paddle::BatchingPredictor batching(std::move(predictors),
+                                       FLAGS_max_batch_size,
+                                       FLAGS_max_latency_us);
+    paddle::RunBenchmark(
+        "batching", client_num,
+        [&batching](const Tensors &inputs, Tensors *outputs) {
+          return batching.Run(inputs, outputs);
+        },
+        &batching);
+  }
+  return 0;
+}
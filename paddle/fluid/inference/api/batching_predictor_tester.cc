@@ -0,0 +1,329 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/inference/api/batching_predictor.h"
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+namespace paddle {
+
+/*
+ * A predictor of a model with a float input x, whose outputs are x * 2 with
+ * the LoD of x, and the sum of each sample of x. With total_sum, it outputs
+ * the sum of all the samples instead, which can't be split. With fixed_rows,
+ * it outputs fixed_rows rows of the sum of all the samples, whose shape tells
+ * they don't scale with the batch.
+ */
+class FakePredictor : public PaddlePredictor {
+ public:
+  explicit FakePredictor(int run_us = 0, bool total_sum = false,
+                         int fixed_rows = 0)
+      : run_us_(run_us), total_sum_(total_sum), fixed_rows_(fixed_rows) {}
+
+  bool Run(const std::vector<PaddleTensor> &inputs,
+           std::vector<PaddleTensor> *output_data,
+           int batch_size = -1) override {
+    if (inputs.empty() || inputs[0].dtype != PaddleDType::FLOAT32) {
+      return false;
+    }
+    const PaddleTensor &x = inputs[0];
+    const float *data = static_cast<const float *>(x.data.data());
+    size_t rows = x.shape[0];
+    size_t width = x.data.length() / sizeof(float) / std::max<size_t>(rows, 1);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      batch_rows_.push_back(rows);
+    }
+    if (run_us_ > 0) {
+      std::this_thread::sleep_for(std::chrono::microseconds(run_us_));
+    }
+
+    output_data->resize(2);
+    PaddleTensor &doubled = (*output_data)[0];
+    doubled.name = "doubled";
+    doubled.dtype = PaddleDType::FLOAT32;
+    doubled.shape = x.shape;
+    doubled.lod = x.lod;
+    doubled.data.Resize(x.data.length());
+    float *doubled_data = static_cast<float *>(doubled.data.data());
+    for (size_t i = 0; i < rows * width; ++i) {
+      doubled_data[i] = data[i] * 2;
+    }
+
+    // the rows of each sample, by the top level sequences of the LoD
+    std::vector<size_t> offsets;
+    if (x.lod.empty()) {
+      for (size_t i = 0; i <= rows; ++i) {
+        offsets.push_back(i);
+      }
+    } else {
+      offsets = x.lod[0];
+      for (size_t level = 1; level < x.lod.size(); ++level) {
+        for (auto &offset : offsets) {
+          offset = x.lod[level][offset];
+        }
+      }
+    }
+    if (total_sum_ || fixed_rows_ > 0) {
+      offsets = {0, rows};
+    }
+    size_t sum_rows = fixed_rows_ > 0 ? fixed_rows_ : offsets.size() - 1;
+    PaddleTensor &sum = (*output_data)[1];
+    sum.name = "sum";
+    sum.dtype = PaddleDType::FLOAT32;
+    sum.shape = {static_cast<int>(sum_rows), 1};
+    sum.lod.clear();
+    sum.data.Resize(sum_rows * sizeof(float));
+    float *sum_data = static_cast<float *>(sum.data.data());
+    for (size_t s = 0; s < sum_rows; ++s) {
+      size_t sample = std::min(s, offsets.size() - 2);
+      sum_data[s] = 0;
+      for (size_t i = offsets[sample] * width;
+           i < offsets[sample + 1] * width; ++i) {
+        sum_data[s] += data[i];
+      }
+    }
+    return true;
+  }
+
+  std::vector<std::string> GetInputNames() override { return {"x"}; }
+
+  std::vector<std::string> GetOutputNames() override {
+    return {"doubled", "sum"};
+  }
+
+  std::map<std::string, std::vector<int64_t>> GetOutputTensorShape() override {
+    return {{"doubled", {-1, -1}},
+            {"sum", {fixed_rows_ > 0 ? fixed_rows_ : -1, 1}}};
+  }
+
+  std::unique_ptr<PaddlePredictor> Clone() override {
+    return std::unique_ptr<PaddlePredictor>(
+        new FakePredictor(run_us_, total_sum_, fixed_rows_));
+  }
+
+  std::vector<size_t> batch_rows() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return batch_rows_;
+  }
+
+ private:
+  int run_us_;
+  bool total_sum_;
+  int fixed_rows_;
+  std::mutex mutex_;
+  std::vector<size_t> batch_rows_;
+};
+
+struct TestRequest {
+  std::vector<PaddleTensor> inputs;
+  std::vector<float> data;
+  std::vector<PaddleTensor> outputs;
+  bool success{false};
+};
+
+static void MakeRequest(size_t rows, size_t width,
+                        const std::vector<std::vector<size_t>> &lod,
+                        float base, TestRequest *request) {
+  request->data.resize(rows * width);
+  for (size_t i = 0; i < request->data.size(); ++i) {
+    request->data[i] = base + i;
+  }
+  PaddleTensor x;
+  x.name = "x";
+  x.dtype = PaddleDType::FLOAT32;
+  x.shape = {static_cast<int>(rows), static_cast<int>(width)};
+  x.lod = lod;
+  x.data.Reset(request->data.data(), request->data.size() * sizeof(float));
+  request->inputs.clear();
+  request->inputs.push_back(std::move(x));
+  // PaddleBuf::Resize doesn't shrink the outputs of a previous run
+  request->outputs.clear();
+}
+
+static void ExpectSameOutputs(const std::vector<PaddleTensor> &expected,
+                              const std::vector<PaddleTensor> &actual) {
+  ASSERT_EQ(expected.size(), actual.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(expected[i].name, actual[i].name);
+    EXPECT_EQ(expected[i].shape, actual[i].shape);
+    EXPECT_EQ(expected[i].lod, actual[i].lod);
+    ASSERT_EQ(expected[i].data.length(), actual[i].data.length());
+    EXPECT_EQ(memcmp(expected[i].data.data(), actual[i].data.data(),
+                     expected[i].data.length()),
+              0);
+  }
+}
+
+// Run the requests concurrently, each by a thread, and check the outputs
+// against those of running them one by one.
+static void RunConcurrently(BatchingPredictor *predictor,
+                            std::vector<TestRequest> *requests) {
+  std::vector<std::thread> threads;
+  for (auto &request : *requests) {
+    threads.emplace_back([predictor, &request] {
+      request.success = predictor->Run(request.inputs, &request.outputs);
+    });
+  }
+  for (auto &th : threads) {
+    th.join();
+  }
+  FakePredictor reference;
+  for (auto &request : *requests) {
+    EXPECT_TRUE(request.success);
+    std::vector<PaddleTensor> expected;
+    ASSERT_TRUE(reference.Run(request.inputs, &expected));
+    ExpectSameOutputs(expected, request.outputs);
+  }
+}
+
+static std::unique_ptr<BatchingPredictor> CreateBatchingPredictor(
+    int worker_num, int run_us, bool total_sum, int max_batch_size,
+    int max_latency_us, int fixed_rows = 0) {
+  std::vector<std::unique_ptr<PaddlePredictor>> predictors;
+  for (int i = 0; i < worker_num; ++i) {
+    predictors.emplace_back(new FakePredictor(run_us, total_sum, fixed_rows));
+  }
+  return std::unique_ptr<BatchingPredictor>(new BatchingPredictor(
+      std::move(predictors), max_batch_size, max_latency_us));
+}
+
+TEST(BatchingPredictor, dense) {
+  auto predictor = CreateBatchingPredictor(2, 2000, false, 16, 5000);
+  std::vector<TestRequest> requests(32);
+  for (size_t i = 0; i < requests.size(); ++i) {
+    MakeRequest(1 + i % 3, 4, {}, i * 100.f, &requests[i]);
+  }
+  RunConcurrently(predictor.get(), &requests);
+  auto stat = predictor->GetStat();
+  EXPECT_EQ(stat.request_num, requests.size());
+  EXPECT_EQ(stat.sample_num, 63UL);
+  EXPECT_LT(stat.batch_num, requests.size());
+  EXPECT_EQ(stat.unbatched_num, 0UL);
+  EXPECT_EQ(predictor->GetInputNames(), std::vector<std::string>({"x"}));
+}
+
+TEST(BatchingPredictor, lod) {
+  auto predictor = CreateBatchingPredictor(1, 2000, false, 8, 5000);
+  std::vector<TestRequest> requests(24);
+  for (size_t i = 0; i < requests.size(); ++i) {
+    if (i % 2 == 0) {
+      // two sequences of 1 and 2 sub-sequences of 2, 1 and 2 rows
+      MakeRequest(5, 3, {{0, 1, 3}, {0, 2, 3, 5}}, i * 100.f, &requests[i]);
+    } else {
+      // two sequences of a sub-sequence each
+      MakeRequest(i % 4 + 1, 3, {{0, 1, 2}, {0, 1, i % 4 + 1}}, i * 100.f,
+                  &requests[i]);
+    }
+  }
+  RunConcurrently(predictor.get(), &requests);
+  auto stat = predictor->GetStat();
+  EXPECT_EQ(stat.sample_num, 48UL);
+  EXPECT_LT(stat.batch_num, requests.size());
+  EXPECT_EQ(stat.unbatched_num, 0UL);
+}
+
+TEST(BatchingPredictor, unbatchable) {
+  auto predictor = CreateBatchingPredictor(1, 2000, false, 64, 5000);
+  std::vector<TestRequest> requests(12);
+  for (size_t i = 0; i < requests.size(); ++i) {
+    // requests of different widths can't be batched together
+    MakeRequest(2, i % 2 + 1, {}, i * 100.f, &requests[i]);
+  }
+  MakeRequest(2, 1, {}, 0, &requests[0]);
+  requests[0].inputs[0].name = "y";
+  RunConcurrently(predictor.get(), &requests);
+  EXPECT_EQ(predictor->GetStat().request_num, requests.size());
+
+  // the sum of all the samples can't be split
+  predictor = CreateBatchingPredictor(1, 2000, true, 64, 5000);
+  for (size_t i = 0; i < requests.size(); ++i) {
+    MakeRequest(2, 2, {}, i * 100.f, &requests[i]);
+  }
+  std::vector<std::thread> threads;
+  for (auto &request : requests) {
+    threads.emplace_back([&predictor, &request] {
+      request.success = predictor->Run(request.inputs, &request.outputs);
+    });
+  }
+  for (auto &th : threads) {
+    th.join();
+  }
+  FakePredictor reference(0, true);
+  for (auto &request : requests) {
+    EXPECT_TRUE(request.success);
+    std::vector<PaddleTensor> expected;
+    ASSERT_TRUE(reference.Run(request.inputs, &expected));
+    ExpectSameOutputs(expected, request.outputs);
+  }
+  auto stat = predictor->GetStat();
+  EXPECT_LT(stat.batch_num, requests.size());
+  EXPECT_GT(stat.unbatched_num, 0UL);
+}
+
+TEST(BatchingPredictor, fixed_output) {
+  // an output of 4 rows, as many as the samples of a batch of 2 requests,
+  // which is not split but run by the requests one by one
+  auto predictor = CreateBatchingPredictor(1, 2000, false, 4, 5000, 4);
+  std::vector<TestRequest> requests(8);
+  for (size_t i = 0; i < requests.size(); ++i) {
+    MakeRequest(2, 2, {}, i * 100.f, &requests[i]);
+  }
+  std::vector<std::thread> threads;
+  for (auto &request : requests) {
+    threads.emplace_back([&predictor, &request] {
+      request.success = predictor->Run(request.inputs, &request.outputs);
+    });
+  }
+  for (auto &th : threads) {
+    th.join();
+  }
+  FakePredictor reference(0, false, 4);
+  for (auto &request : requests) {
+    EXPECT_TRUE(request.success);
+    std::vector<PaddleTensor> expected;
+    ASSERT_TRUE(reference.Run(request.inputs, &expected));
+    ExpectSameOutputs(expected, request.outputs);
+  }
+  auto stat = predictor->GetStat();
+  EXPECT_EQ(stat.batch_num, requests.size());
+  EXPECT_EQ(stat.unbatched_num, 0UL);
+}
+
+TEST(BatchingPredictor, failure_and_clone) {
+  auto predictor = CreateBatchingPredictor(1, 0, false, 16, 0);
+  TestRequest request;
+  MakeRequest(1, 2, {}, 0, &request);
+  request.inputs[0].dtype = PaddleDType::INT64;
+  EXPECT_FALSE(predictor->Run(request.inputs, &request.outputs));
+  EXPECT_FALSE(predictor->ZeroCopyRun());
+
+  auto clone = predictor->Clone();
+  ASSERT_NE(clone, nullptr);
+  MakeRequest(3, 2, {}, 0, &request);
+  std::vector<PaddleTensor> outputs;
+  ASSERT_TRUE(clone->Run(request.inputs, &outputs));
+  ASSERT_EQ(outputs.size(), 2UL);
+  EXPECT_EQ(outputs[0].shape, std::vector<int>({3, 2}));
+  EXPECT_EQ(static_cast<float *>(outputs[1].data.data())[2], 9.f);
+}
+
+}  // namespace paddle
@@ -0,0 +1,149 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/inference/api/details/external_data.h"
+
+#include <cstdint>
+
+#include "paddle/fluid/framework/data_type.h"
+#include "paddle/fluid/framework/tensor_util.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace details {
+
+namespace {
+
+// The memory of a caller-owned buffer, which is not freed with the tensors
+// holding it.
+class ExternalAllocation : public memory::Allocation {
+ public:
+  ExternalAllocation(void *ptr, size_t size, const platform::Place &place)
+      : Allocation(ptr, size, place) {}
+};
+
+}  // namespace
+
+void ExternalDataBindings::Bind(const std::string &name, bool is_input,
+                                framework::LoDTensor *tensor, void *data,
+                                size_t size,
+                                framework::proto::VarType::Type type,
+                                const framework::DDim &dims,
+                                const platform::Place &place) {
+  PADDLE_ENFORCE_NOT_NULL(
+      data, platform::errors::InvalidArgument(
+                "The buffer bound to the tensor %s should not be null.", name));
+  size_t type_size = framework::SizeOfType(type);
+  PADDLE_ENFORCE_EQ(
+      reinterpret_cast<uintptr_t>(data) % type_size, 0,
+      platform::errors::InvalidArgument(
+          "The buffer bound to the tensor %s should be aligned to the size "
+          "of its data type, %d bytes, but its address is %p.",
+          name, type_size, data));
+  PADDLE_ENFORCE_GT(framework::product(dims), 0,
+                    platform::errors::InvalidArgument(
+                        "The shape [%s] of the buffer bound to the tensor %s "
+                        "should have positive dimensions.",
+                        dims, name));
+  PADDLE_ENFORCE_LE(
+      framework::product(dims) * type_size, size,
+      platform::errors::InvalidArgument(
+          "The data of the shape [%s] does not fit in the %d bytes of the "
+          "buffer bound to the tensor %s.",
+          dims, size, name));
+  auto *begin = static_cast<uint8_t *>(data);
+  for (auto &item : bindings_) {
+    auto &other = item.second.allocation;
+    auto *other_begin = static_cast<uint8_t *>(other->ptr());
+    PADDLE_ENFORCE_EQ(
+        item.first == name || begin + size <= other_begin ||
+            other_begin + other->size() <= begin,
+        true,
+        platform::errors::InvalidArgument(
+            "The buffer bound to the tensor %s overlaps that bound to the "
+            "tensor %s.",
+            name, item.first));
+  }
+
+  Unbind(name);
+  Binding binding;
+  binding.tensor = tensor;
+  binding.is_input = is_input;
+  binding.type = type;
+  binding.allocation = std::make_shared<ExternalAllocation>(data, size, place);
+  tensor->Resize(dims);
+  tensor->ResetHolderWithType(binding.allocation, type);
+  bindings_.emplace(name, std::move(binding));
+}
+
+void ExternalDataBindings::Unbind(const std::string &name) {
+  auto it = bindings_.find(name);
+  if (it == bindings_.end()) {
+    return;
+  }
+  auto &binding = it->second;
+  if (binding.tensor->Holder() == binding.allocation) {
+    binding.tensor->clear();
+  }
+  bindings_.erase(it);
+}
+
+void ExternalDataBindings::SyncOutputs() {
+  num_copied_outputs_ = 0;
+  for (auto &item : bindings_) {
+    auto &binding = item.second;
+    auto *tensor = binding.tensor;
+    if (binding.is_input || !tensor->IsInitialized() ||
+        (tensor->Holder() == binding.allocation && tensor->offset() == 0)) {
+      continue;
+    }
+    PADDLE_ENFORCE_EQ(
+        tensor->type(), binding.type,
+        platform::errors::InvalidArgument(
+            "The output %s is of the data type %s, but the buffer bound to it "
+            "is of %s.",
+            item.first, framework::DataTypeToString(tensor->type()),
+            framework::DataTypeToString(binding.type)));
+    size_t size = tensor->numel() * framework::SizeOfType(tensor->type());
+    PADDLE_ENFORCE_LE(
+        size, binding.allocation->size(),
+        platform::errors::OutOfRange(
+            "The output %s of the shape [%s] does not fit in the %d bytes of "
+            "the buffer bound to it.",
+            item.first, tensor->dims(), binding.allocation->size()));
+    framework::Tensor src;
+    if (tensor->Holder() == binding.allocation) {
+      // a slice of the buffer, which may overlap the range copied to
+      framework::TensorCopySync(*tensor, tensor->place(), &src);
+    } else {
+      src.ShareDataWith(*tensor);
+    }
+    framework::Tensor dst;
+    dst.Resize(tensor->dims());
+    dst.ResetHolderWithType(binding.allocation, tensor->type());
+    framework::TensorCopySync(src, binding.allocation->place(), &dst);
+    tensor->ShareBufferWith(dst);
+    ++num_copied_outputs_;
+  }
+}
+
+void ExternalDataBindings::Clear() {
+  while (!bindings_.empty()) {
+    Unbind(bindings_.begin()->first);
+  }
+  num_copied_outputs_ = 0;
+}
+
+}  // namespace details
+}  // namespace paddle
@@ -0,0 +1,78 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/memory/allocation/allocator.h"
+#include "paddle/fluid/platform/place.h"
+
+namespace paddle {
+namespace details {
+
+// The caller-owned buffers bound to the input and output tensors of a
+// predictor, which the tensors hold without copying or freeing them.
+//
+// An input reads the buffer bound to it. An output is written into the
+// buffer by the kernel producing it, which finds it allocated if the bound
+// shape is large enough. If the output is produced elsewhere, e.g. shared
+// from another tensor or larger than the buffer, SyncOutputs copies it to
+// the buffer after the run, or fails if it does not fit. So are the outputs
+// planned in the arena of the static memory plan.
+//
+// The buffers are not owned, so a binding lasts until it is unbound, or the
+// tensor is bound again, and the caller keeps the buffer alive until then.
+struct ExternalDataBindings {
+  // Bind the buffer of size bytes to the tensor of the name, and reshape the
+  // tensor to dims, whose data should fit in the buffer.
+  void Bind(const std::string &name, bool is_input,
+            framework::LoDTensor *tensor, void *data, size_t size,
+            framework::proto::VarType::Type type, const framework::DDim &dims,
+            const platform::Place &place);
+
+  // Unbind the buffer of the tensor of the name, if any, after which the
+  // tensor holds no memory.
+  void Unbind(const std::string &name);
+
+  bool IsBound(const std::string &name) const {
+    return bindings_.count(name) > 0;
+  }
+
+  // Called after a run, copy the outputs which are not written in place to
+  // their buffers, and point the outputs to the buffers.
+  void SyncOutputs();
+
+  // Unbind all the buffers, before the scope of the tensors is deleted.
+  void Clear();
+
+  // the outputs copied by the last SyncOutputs
+  size_t num_copied_outputs() const { return num_copied_outputs_; }
+
+ private:
+  struct Binding {
+    framework::LoDTensor *tensor;
+    bool is_input;
+    framework::proto::VarType::Type type;
+    std::shared_ptr<memory::Allocation> allocation;
+  };
+
+  std::map<std::string, Binding> bindings_;
+  size_t num_copied_outputs_{0};
+};
+
+}  // namespace details
+}  // namespace paddle
@@ -0,0 +1,129 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/inference/api/details/external_data.h"
+
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace paddle {
+namespace details {
+
+using framework::LoDTensor;
+using framework::make_ddim;
+constexpr auto kFP32 = framework::proto::VarType::FP32;
+
+TEST(ExternalDataBindings, input) {
+  platform::CPUPlace place;
+  ExternalDataBindings bindings;
+  std::vector<float> x_data(6, 1.f);
+  LoDTensor x;
+  bindings.Bind("x", true, &x, x_data.data(), x_data.size() * sizeof(float),
+                kFP32, make_ddim({2, 3}), place);
+  EXPECT_TRUE(bindings.IsBound("x"));
+  EXPECT_EQ(x.data<float>(), x_data.data());
+  EXPECT_EQ(x.dims(), make_ddim({2, 3}));
+  // the kernels find the input allocated
+  EXPECT_EQ(x.mutable_data<float>(place), x_data.data());
+
+  // the inputs are not copied
+  bindings.SyncOutputs();
+  EXPECT_EQ(bindings.num_copied_outputs(), 0UL);
+
+  bindings.Unbind("x");
+  EXPECT_FALSE(bindings.IsBound("x"));
+  EXPECT_FALSE(x.IsInitialized());
+}
+
+TEST(ExternalDataBindings, output) {
+  platform::CPUPlace place;
+  ExternalDataBindings bindings;
+  std::vector<float> out_data(8, 0.f);
+  LoDTensor out;
+  bindings.Bind("out", false, &out, out_data.data(),
+                out_data.size() * sizeof(float), kFP32, make_ddim({2, 4}),
+                place);
+
+  // written in place, of a smaller shape
+  out.Resize({2, 3});
+  auto* data = out.mutable_data<float>(place);
+  EXPECT_EQ(data, out_data.data());
+  for (int i = 0; i < 6; ++i) {
+    data[i] = i;
+  }
+  bindings.SyncOutputs();
+  EXPECT_EQ(bindings.num_copied_outputs(), 0UL);
+
+  // shared from another tensor
+  LoDTensor other;
+  other.Resize({2, 2});
+  auto* other_data = other.mutable_data<float>(place);
+  for (int i = 0; i < 4; ++i) {
+    other_data[i] = 10 + i;
+  }
+  out.ShareDataWith(other);
+  bindings.SyncOutputs();
+  EXPECT_EQ(bindings.num_copied_outputs(), 1UL);
+  EXPECT_EQ(out.data<float>(), out_data.data());
+  EXPECT_EQ(out.dims(), make_ddim({2, 2}));
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(out_data[i], 10 + i);
+  }
+
+  // larger than the buffer
+  out.Resize({4, 4});
+  EXPECT_NE(out.mutable_data<float>(place), out_data.data());
+  EXPECT_THROW(bindings.SyncOutputs(), platform::EnforceNotMet);
+
+  bindings.Clear();
+  EXPECT_FALSE(bindings.IsBound("out"));
+  // the tensor not holding the buffer is kept
+  EXPECT_TRUE(out.IsInitialized());
+}
+
+TEST(ExternalDataBindings, check) {
+  platform::CPUPlace place;
+  ExternalDataBindings bindings;
+  std::vector<float> data(16);
+  LoDTensor x, y;
+  // misaligned
+  EXPECT_THROW(bindings.Bind("x", true, &x,
+                             reinterpret_cast<char*>(data.data()) + 1,
+                             4 * sizeof(float), kFP32, make_ddim({4}), place),
+               platform::EnforceNotMet);
+  // too small
+  EXPECT_THROW(bindings.Bind("x", true, &x, data.data(), 4 * sizeof(float),
+                             kFP32, make_ddim({5}), place),
+               platform::EnforceNotMet);
+  EXPECT_THROW(bindings.Bind("x", true, &x, nullptr, 4 * sizeof(float), kFP32,
+                             make_ddim({4}), place),
+               platform::EnforceNotMet);
+  EXPECT_FALSE(bindings.IsBound("x"));
+
+  bindings.Bind("x", true, &x, data.data(), 8 * sizeof(float), kFP32,
+                make_ddim({8}), place);
+  // overlapping
+  EXPECT_THROW(bindings.Bind("y", false, &y, data.data() + 4,
+                             4 * sizeof(float), kFP32, make_ddim({4}), place),
+               platform::EnforceNotMet);
+  bindings.Bind("y", false, &y, data.data() + 8, 8 * sizeof(float), kFP32,
+                make_ddim({8}), place);
+  // bound again
+  bindings.Bind("x", true, &x, data.data() + 4, 4 * sizeof(float), kFP32,
+                make_ddim({4}), place);
+  EXPECT_EQ(x.data<float>(), data.data() + 4);
+}
+
+}  // namespace details
+}  // namespace paddle
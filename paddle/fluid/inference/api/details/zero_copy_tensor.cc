@@ -14,6 +14,7 @@
 
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/inference/api/details/external_data.h"
 #include "paddle/fluid/inference/api/paddle_inference_api.h"
 #include "paddle/fluid/memory/memcpy.h"
 #include "paddle/fluid/platform/enforce.h"
@@ -31,6 +32,7 @@ void ZeroCopyTensor::Reshape(const std::vector<int> &shape) {
   auto *var = scope->FindVar(name_);
   PADDLE_ENFORCE(var, "No tensor called [%s] in the runtime scope", name_);
   auto *tensor = var->GetMutable<framework::LoDTensor>();
+  UnbindExternalData();
   tensor->Resize(framework::make_ddim(shape));
 }
 
@@ -47,6 +49,7 @@ T *ZeroCopyTensor::mutable_data(PaddlePlace place) {
       tensor->numel(), 0,
       "You should call ZeroCopyTensor::Reshape(const std::vector<int> &shape)"
       "function before retrieving mutable_data from input tensor.");
+  UnbindExternalData();
   switch (static_cast<int>(place)) {
     case static_cast<int>(PaddlePlace::kCPU): {
       return tensor->mutable_data<T>(platform::CPUPlace());
@@ -101,6 +104,7 @@ void ZeroCopyTensor::copy_from_cpu(const T *data) {
       "You should call ZeroCopyTensor::Reshape(const std::vector<int> &shape)"
       "function before copying data from cpu.");
   size_t ele_size = tensor->numel() * sizeof(T);
+  UnbindExternalData();
 
   if (place_ == PaddlePlace::kCPU) {
     auto *t_data = tensor->mutable_data<T>(platform::CPUPlace());
@@ -145,6 +149,38 @@ void ZeroCopyTensor::copy_to_cpu(T *data) {
 #endif
   }
 }
+template <typename T>
+void ZeroCopyTensor::ShareExternalData(T *data,
+                                       const std::vector<int> &shape) {
+  EAGER_GET_TENSOR;
+  PADDLE_ENFORCE_NOT_NULL(
+      external_data_,
+      platform::errors::Unavailable(
+          "The tensor %s can not be bound to a caller-owned buffer.", name_));
+  platform::Place place;
+  if (place_ == PaddlePlace::kCPU) {
+    place = platform::CPUPlace();
+  } else {
+#ifdef PADDLE_WITH_CUDA
+    place = platform::CUDAPlace(device_);
+#else
+    PADDLE_THROW(platform::errors::Unavailable(
+        "Not compiled with CUDA, should not reach here."));
+#endif
+  }
+  auto dims = framework::make_ddim(shape);
+  size_t size = framework::product(dims) * sizeof(T);
+  static_cast<details::ExternalDataBindings *>(external_data_)
+      ->Bind(name_, input_or_output_, tensor, data, size,
+             framework::DataTypeTrait<T>::DataType(), dims, place);
+}
+
+void ZeroCopyTensor::UnbindExternalData() {
+  if (external_data_) {
+    static_cast<details::ExternalDataBindings *>(external_data_)->Unbind(name_);
+  }
+}
+
 template PD_INFER_DECL void ZeroCopyTensor::copy_from_cpu<float>(
     const float *data);
 template PD_INFER_DECL void ZeroCopyTensor::copy_from_cpu<int64_t>(
@@ -153,6 +189,14 @@ template PD_INFER_DECL void ZeroCopyTensor::copy_from_cpu<int32_t>(
     const int32_t *data);
 template PD_INFER_DECL void ZeroCopyTensor::copy_from_cpu<uint8_t>(
     const uint8_t *data);
+template PD_INFER_DECL void ZeroCopyTensor::ShareExternalData<float>(
+    float *data, const std::vector<int> &shape);
+template PD_INFER_DECL void ZeroCopyTensor::ShareExternalData<int64_t>(
+    int64_t *data, const std::vector<int> &shape);
+template PD_INFER_DECL void ZeroCopyTensor::ShareExternalData<int32_t>(
+    int32_t *data, const std::vector<int> &shape);
+template PD_INFER_DECL void ZeroCopyTensor::ShareExternalData<uint8_t>(
+    uint8_t *data, const std::vector<int> &shape);
 template PD_INFER_DECL void ZeroCopyTensor::copy_to_cpu<float>(float *data);
 template PD_INFER_DECL void ZeroCopyTensor::copy_to_cpu<int64_t>(int64_t *data);
 template PD_INFER_DECL void ZeroCopyTensor::copy_to_cpu<int32_t>(int32_t *data);
@@ -0,0 +1,196 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Latency of serving the requests of a model by ZeroCopyRun, with the inputs
+// and the outputs copied between the buffers of the requests and the
+// predictor, and with the buffers bound to the predictor by
+// ZeroCopyTensor::ShareExternalData. The requests rotate among --buffers
+// buffers held by the caller, as those of the requests in flight would, so
+// each binds other buffers than the last one. The inputs are float, of the
+// shapes of the model with the batch dimension set to --batch_size.
+//
+// Usage:
+//   ./external_data_benchmark --model_dir=resnet50 --batch_size=16
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <vector>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/inference/api/paddle_inference_api.h"
+
+DEFINE_string(model_dir, "", "Directory of the model.");
+DEFINE_string(prog_file, "", "Program of the model, with --params_file.");
+DEFINE_string(params_file, "", "Parameters of the model.");
+DEFINE_int32(batch_size, 1, "Samples of a request.");
+DEFINE_int32(requests, 100, "Requests of each measurement.");
+DEFINE_int32(buffers, 4, "Buffers of the requests held by the caller.");
+DEFINE_int32(threads, 1, "Threads of the math library.");
+
+namespace paddle {
+
+// A buffer of floats aligned to 64 bytes, like those of a serving layer.
+class AlignedBuffer {
+ public:
+  explicit AlignedBuffer(size_t num) : data_(num + 16) {
+    auto addr = reinterpret_cast<uintptr_t>(data_.data());
+    offset_ = (64 - addr % 64) % 64 / sizeof(float);
+  }
+  float *data() { return data_.data() + offset_; }
+
+ private:
+  std::vector<float> data_;
+  size_t offset_;
+};
+
+struct Request {
+  std::vector<AlignedBuffer> inputs;
+  std::vector<AlignedBuffer> outputs;
+};
+
+static int Product(const std::vector<int> &shape) {
+  return std::accumulate(shape.begin(), shape.end(), 1,
+                         std::multiplies<int>());
+}
+
+// Returns the latencies of the requests in ms, sorted.
+static std::vector<double> RunBenchmark(
+    PaddlePredictor *predictor, std::vector<Request> *requests,
+    const std::vector<std::string> &input_names,
+    const std::vector<std::vector<int>> &input_shapes,
+    const std::vector<std::string> &output_names,
+    const std::vector<std::vector<int>> &output_shapes, bool share) {
+  std::vector<double> latencies;
+  for (int r = 0; r < FLAGS_requests; ++r) {
+    auto &request = (*requests)[r % requests->size()];
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < input_names.size(); ++i) {
+      auto input = predictor->GetInputTensor(input_names[i]);
+      if (share) {
+        input->ShareExternalData(request.inputs[i].data(), input_shapes[i]);
+      } else {
+        input->Reshape(input_shapes[i]);
+        input->copy_from_cpu(request.inputs[i].data());
+      }
+    }
+    if (share) {
+      for (size_t i = 0; i < output_names.size(); ++i) {
+        predictor->GetOutputTensor(output_names[i])
+            ->ShareExternalData(request.outputs[i].data(), output_shapes[i]);
+      }
+    }
+    CHECK(predictor->ZeroCopyRun());
+    if (!share) {
+      for (size_t i = 0; i < output_names.size(); ++i) {
+        predictor->GetOutputTensor(output_names[i])
+            ->copy_to_cpu(request.outputs[i].data());
+      }
+    }
+    latencies.push_back(std::chrono::duration<double, std::milli>(
+                            std::chrono::steady_clock::now() - start)
+                            .count());
+  }
+  std::sort(latencies.begin(), latencies.end());
+  return latencies;
+}
+
+static void Run() {
+  AnalysisConfig config;
+  if (!FLAGS_model_dir.empty()) {
+    config.SetModel(FLAGS_model_dir);
+  } else {
+    config.SetModel(FLAGS_prog_file, FLAGS_params_file);
+  }
+  config.DisableGpu();
+  config.SwitchUseFeedFetchOps(false);
+  config.SetCpuMathLibraryNumThreads(FLAGS_threads);
+  auto predictor = CreatePaddlePredictor(config);
+
+  std::vector<std::string> input_names = predictor->GetInputNames();
+  std::vector<std::vector<int>> input_shapes;
+  auto model_shapes = predictor->GetInputTensorShape();
+  int64_t input_bytes = 0;
+  for (auto &name : input_names) {
+    std::vector<int> shape(model_shapes[name].begin(),
+                           model_shapes[name].end());
+    for (auto &dim : shape) {
+      if (dim < 0) {
+        dim = FLAGS_batch_size;
+      }
+    }
+    input_shapes.push_back(shape);
+    input_bytes += Product(shape) * sizeof(float);
+  }
+
+  std::vector<Request> requests(std::max(FLAGS_buffers, 1));
+  for (auto &request : requests) {
+    for (auto &shape : input_shapes) {
+      int num = Product(shape);
+      request.inputs.emplace_back(num);
+      std::fill_n(request.inputs.back().data(), num, 0.5f);
+    }
+  }
+
+  // the shapes of the outputs, found by a run
+  for (size_t i = 0; i < input_names.size(); ++i) {
+    auto input = predictor->GetInputTensor(input_names[i]);
+    input->Reshape(input_shapes[i]);
+    input->copy_from_cpu(requests[0].inputs[i].data());
+  }
+  CHECK(predictor->ZeroCopyRun());
+  std::vector<std::string> output_names = predictor->GetOutputNames();
+  std::vector<std::vector<int>> output_shapes;
+  int64_t output_bytes = 0;
+  for (auto &name : output_names) {
+    output_shapes.push_back(predictor->GetOutputTensor(name)->shape());
+    output_bytes += Product(output_shapes.back()) * sizeof(float);
+  }
+  for (auto &request : requests) {
+    for (auto &shape : output_shapes) {
+      request.outputs.emplace_back(Product(shape));
+    }
+  }
+
+  std::cout << "input bytes: " << input_bytes
+            << ", output bytes: " << output_bytes << std::endl;
+  std::cout << "mode\tmean_ms\tp50_ms\tp99_ms" << std::endl;
+  for (bool share : {false, true}) {
+    // warm up
+    RunBenchmark(predictor.get(), &requests, input_names, input_shapes,
+                 output_names, output_shapes, share);
+    auto latencies =
+        RunBenchmark(predictor.get(), &requests, input_names, input_shapes,
+                     output_names, output_shapes, share);
+    double mean = std::accumulate(latencies.begin(), latencies.end(), 0.0) /
+                  latencies.size();
+    std::cout << (share ? "share" : "copy") << "\t" << mean << "\t"
+              << latencies[latencies.size() / 2] << "\t"
+              << latencies[latencies.size() * 99 / 100] << std::endl;
+  }
+}
+
+}  // namespace paddle
+
+int main(int argc, char *argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  paddle::Run();
+  return 0;
+}
@@ -0,0 +1,293 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/inference/api/numa_predictor_pool.h"
+#include <glog/logging.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
+#include <algorithm>
+#include <exception>
+#include <utility>
+#include "paddle/fluid/platform/cpu_helper.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+
+NumaPredictorPool::NumaPredictorPool(
+    const Creator &create, const std::vector<std::vector<int>> &node_cpus,
+    int workers_per_node)
+    : node_cpus_(node_cpus), workers_per_node_(workers_per_node) {
+  PADDLE_ENFORCE_EQ(node_cpus_.empty(), false,
+                    platform::errors::InvalidArgument(
+                        "NumaPredictorPool needs at least one node."));
+  PADDLE_ENFORCE_GT(workers_per_node_, 0,
+                    platform::errors::InvalidArgument(
+                        "The number of workers of each node of "
+                        "NumaPredictorPool should be greater than 0, but "
+                        "received %d.",
+                        workers_per_node_));
+  for (size_t node = 0; node < node_cpus_.size(); ++node) {
+    const auto &cpus = node_cpus_[node];
+    PADDLE_ENFORCE_EQ(cpus.empty(), false,
+                      platform::errors::InvalidArgument(
+                          "The node %d of NumaPredictorPool has no CPU.",
+                          node));
+    for (int cpu : cpus) {
+      node_of_cpu_.emplace(cpu, static_cast<int>(node));
+    }
+    // an equal share of the CPUs for each worker, or one CPU if the node has
+    // fewer CPUs than workers
+    std::vector<std::vector<int>> worker_cpus;
+    size_t cpu_num = cpus.size(), worker_num = workers_per_node_;
+    for (size_t w = 0; w < worker_num; ++w) {
+      size_t begin = w * cpu_num / worker_num;
+      size_t end = std::max((w + 1) * cpu_num / worker_num, begin + 1);
+      worker_cpus.emplace_back(cpus.begin() + begin, cpus.begin() + end);
+    }
+    worker_cpus_.push_back(std::move(worker_cpus));
+  }
+
+  // The predictors of a node are created by a thread bound to the node, so
+  // their memory is first touched on it. The nodes are created one by one,
+  // since the creator may not be thread safe.
+  predictors_.resize(node_cpus_.size());
+  for (size_t node = 0; node < node_cpus_.size(); ++node) {
+    std::exception_ptr error;
+    std::thread creator([&, node] {
+      try {
+        platform::SetThreadAffinity(node_cpus_[node]);
+        auto &predictors = predictors_[node];
+        predictors.push_back(create(static_cast<int>(node)));
+        PADDLE_ENFORCE_NOT_NULL(
+            predictors[0].get(),
+            platform::errors::PreconditionNotMet(
+                "Fail to create the predictor of the node %d of "
+                "NumaPredictorPool.",
+                node));
+        for (int w = 1; w < workers_per_node_; ++w) {
+          predictors.push_back(predictors[0]->Clone());
+          PADDLE_ENFORCE_NOT_NULL(
+              predictors.back().get(),
+              platform::errors::PreconditionNotMet(
+                  "Fail to clone the predictor of the node %d of "
+                  "NumaPredictorPool.",
+                  node));
+        }
+      } catch (...) {
+        error = std::current_exception();
+      }
+    });
+    creator.join();
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+  for (size_t node = 0; node < node_cpus_.size(); ++node) {
+    nodes_.emplace_back(new Node);
+  }
+  for (size_t node = 0; node < node_cpus_.size(); ++node) {
+    for (int w = 0; w < workers_per_node_; ++w) {
+      workers_.emplace_back(&NumaPredictorPool::WorkerLoop, this,
+                            static_cast<int>(node), predictors_[node][w].get(),
+                            worker_cpus_[node][w]);
+    }
+  }
+}
+
+NumaPredictorPool::~NumaPredictorPool() {
+  for (auto &node : nodes_) {
+    {
+      std::lock_guard<std::mutex> lock(node->mutex);
+      node->stop = true;
+    }
+    node->cv.notify_all();
+  }
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+int NumaPredictorPool::CurrentNode() {
+#ifdef __linux__
+  int cpu = sched_getcpu();
+  auto it = node_of_cpu_.find(cpu);
+  if (it != node_of_cpu_.end()) {
+    return it->second;
+  }
+#endif
+  return static_cast<int>(next_node_++ % nodes_.size());
+}
+
+bool NumaPredictorPool::Run(const std::vector<PaddleTensor> &inputs,
+                            std::vector<PaddleTensor> *output_data,
+                            int batch_size) {
+  PADDLE_ENFORCE_NOT_NULL(output_data,
+                          platform::errors::InvalidArgument(
+                              "The output of Run should not be nullptr."));
+  Request request;
+  request.inputs = &inputs;
+  request.outputs = output_data;
+  int node = CurrentNode();
+  bool local_idle = false;
+  {
+    auto &local = *nodes_[node];
+    std::lock_guard<std::mutex> lock(local.mutex);
+    if (local.stop) {
+      LOG(ERROR) << "NumaPredictorPool is stopped";
+      return false;
+    }
+    local.queue.push_back(&request);
+    local_idle = local.idle_num >= local.queue.size();
+    if (local_idle) {
+      local.cv.notify_one();
+    }
+  }
+  if (!local_idle) {
+    // the workers of the node are busy, wake an idle worker of another node
+    for (size_t i = 1; i < nodes_.size(); ++i) {
+      auto &other = *nodes_[(node + i) % nodes_.size()];
+      std::lock_guard<std::mutex> lock(other.mutex);
+      if (other.idle_num > 0) {
+        other.cv.notify_one();
+        break;
+      }
+    }
+  }
+
+  std::unique_lock<std::mutex> lock(request.mutex);
+  request.cv.wait(lock, [&request] { return request.done; });
+  return request.success;
+}
+
+NumaPredictorPool::Request *NumaPredictorPool::Steal(int node) {
+  for (size_t i = 1; i < nodes_.size(); ++i) {
+    auto &other = *nodes_[(node + i) % nodes_.size()];
+    std::lock_guard<std::mutex> lock(other.mutex);
+    if (!other.queue.empty()) {
+      Request *request = other.queue.front();
+      other.queue.pop_front();
+      return request;
+    }
+  }
+  return nullptr;
+}
+
+void NumaPredictorPool::Finish(Request *request, bool success) {
+  // notified under the lock, since the request lives on the stack of the
+  // waiting thread, which may return as soon as it sees done
+  std::lock_guard<std::mutex> lock(request->mutex);
+  request->success = success;
+  request->done = true;
+  request->cv.notify_one();
+}
+
+void NumaPredictorPool::WorkerLoop(int node, PaddlePredictor *predictor,
+                                   const std::vector<int> &cpus) {
+  platform::SetThreadAffinity(cpus);
+  auto &local = *nodes_[node];
+  while (true) {
+    Request *request = nullptr;
+    {
+      std::unique_lock<std::mutex> lock(local.mutex);
+      if (!local.queue.empty()) {
+        request = local.queue.front();
+        local.queue.pop_front();
+        ++local.local_num;
+      }
+    }
+    if (request == nullptr) {
+      // No other lock is held while stealing, so the nodes never wait for
+      // each other.
+      request = Steal(node);
+      if (request != nullptr) {
+        ++local.stolen_num;
+      }
+    }
+    if (request == nullptr) {
+      std::unique_lock<std::mutex> lock(local.mutex);
+      if (local.queue.empty()) {
+        // the queued requests of the node are run before stopping
+        if (local.stop) {
+          return;
+        }
+        ++local.idle_num;
+        local.cv.wait(lock);
+        --local.idle_num;
+      }
+      continue;
+    }
+
+    bool success = false;
+    try {
+      success = predictor->Run(*request->inputs, request->outputs);
+    } catch (std::exception &e) {
+      LOG(ERROR) << "NumaPredictorPool failed to run a request on the node "
+                 << node << ": " << e.what();
+    }
+    Finish(request, success);
+  }
+}
+
+std::vector<std::string> NumaPredictorPool::GetInputNames() {
+  return predictors_[0][0]->GetInputNames();
+}
+
+std::map<std::string, std::vector<int64_t>>
+NumaPredictorPool::GetInputTensorShape() {
+  return predictors_[0][0]->GetInputTensorShape();
+}
+
+std::vector<std::string> NumaPredictorPool::GetOutputNames() {
+  return predictors_[0][0]->GetOutputNames();
+}
+
+std::map<std::string, std::vector<int64_t>>
+NumaPredictorPool::GetOutputTensorShape() {
+  return predictors_[0][0]->GetOutputTensorShape();
+}
+
+bool NumaPredictorPool::ZeroCopyRun() {
+  LOG(ERROR) << "ZeroCopyRun is not supported with the NUMA pool, please use "
+                "Run instead.";
+  return false;
+}
+
+std::unique_ptr<PaddlePredictor> NumaPredictorPool::Clone() {
+  try {
+    return std::unique_ptr<PaddlePredictor>(new NumaPredictorPool(
+        [this](int node) { return predictors_[node][0]->Clone(); },
+        node_cpus_, workers_per_node_));
+  } catch (std::exception &e) {
+    LOG(ERROR) << "Fail to clone NumaPredictorPool: " << e.what();
+    return nullptr;
+  }
+}
+
+std::string NumaPredictorPool::GetSerializedProgram() const {
+  return predictors_[0][0]->GetSerializedProgram();
+}
+
+NumaPoolStat NumaPredictorPool::GetStat() const {
+  NumaPoolStat stat;
+  for (auto &node : nodes_) {
+    stat.local_num += node->local_num.load();
+    stat.stolen_num += node->stolen_num.load();
+  }
+  stat.request_num = stat.local_num + stat.stolen_num;
+  return stat;
+}
+
+}  // namespace paddle
@@ -0,0 +1,171 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+#include "paddle/fluid/inference/api/paddle_inference_api.h"
+
+///
+/// \file numa_predictor_pool.h
+///
+/// \brief A pool of predictors on the NUMA nodes, with their worker threads
+/// bound to the CPUs of the nodes, returned by CreatePaddlePredictor when
+/// AnalysisConfig::EnableNumaPool is called.
+///
+
+namespace paddle {
+
+///
+/// \brief Statistics of the requests run by a NumaPredictorPool.
+///
+struct NumaPoolStat {
+  size_t request_num{0};  ///< requests run
+  /// requests run by a worker of the node of the thread calling Run
+  size_t local_num{0};
+  /// requests run by a worker of another node, when those of the node of
+  /// the calling thread are busy
+  size_t stolen_num{0};
+};
+
+///
+/// \class NumaPredictorPool
+///
+/// \brief Run is thread safe, and the requests of the threads calling it are
+/// run by the worker threads of the pool, each with its own predictor.
+///
+/// The pool has workers_per_node workers on each NUMA node, each bound to an
+/// equal share of the CPUs of the node. A predictor is created for each node
+/// by a thread bound to the node, so its parameters are first touched, and
+/// thus allocated, on the node, and cloned for the other workers of the node,
+/// which share the parameters. A request is queued to the node of the CPU the
+/// calling thread runs on, and taken by a worker of that node, or by an idle
+/// worker of another node if the workers of the node are busy, so the
+/// requests are not left waiting while other nodes idle.
+///
+/// The threads of the math library created by a worker, e.g. those of
+/// OpenMP, inherit its binding. The temporary memory of a run is allocated
+/// on the node of the worker with FLAGS_allocator_strategy=thread_local; the
+/// default allocator shares its chunks among the threads of all the nodes.
+///
+/// ZeroCopyRun is not supported, since the zero copy tensors belong to a
+/// single predictor.
+///
+class NumaPredictorPool : public PaddlePredictor {
+ public:
+  ///
+  /// \brief Create the predictor of a node, the index of the node in
+  /// node_cpus. It is called by a thread bound to the CPUs of the node.
+  ///
+  using Creator = std::function<std::unique_ptr<PaddlePredictor>(int node)>;
+
+  ///
+  /// \param[in] create The creator of the predictor of each node.
+  /// \param[in] node_cpus The CPUs of each of the nodes the pool uses, as
+  /// returned by platform::GetNumaNodeCpus.
+  /// \param[in] workers_per_node The number of workers of each node.
+  ///
+  NumaPredictorPool(const Creator& create,
+                    const std::vector<std::vector<int>>& node_cpus,
+                    int workers_per_node);
+  ///
+  /// \brief Run the queued requests and stop the worker threads.
+  ///
+  ~NumaPredictorPool() override;
+
+  bool Run(const std::vector<PaddleTensor>& inputs,
+           std::vector<PaddleTensor>* output_data,
+           int batch_size = -1) override;
+
+  std::vector<std::string> GetInputNames() override;
+  std::map<std::string, std::vector<int64_t>> GetInputTensorShape() override;
+  std::vector<std::string> GetOutputNames() override;
+  std::map<std::string, std::vector<int64_t>> GetOutputTensorShape() override;
+
+  bool ZeroCopyRun() override;
+
+  ///
+  /// \brief Clone the predictors of the nodes into a new NumaPredictorPool
+  /// with the same nodes and workers, and its own queues.
+  ///
+  std::unique_ptr<PaddlePredictor> Clone() override;
+
+  std::string GetSerializedProgram() const override;
+
+  NumaPoolStat GetStat() const;
+
+  ///
+  /// \brief The CPUs each worker of each node is bound to.
+  ///
+  const std::vector<std::vector<std::vector<int>>>& worker_cpus() const {
+    return worker_cpus_;
+  }
+
+ private:
+  struct Request {
+    const std::vector<PaddleTensor>* inputs;
+    std::vector<PaddleTensor>* outputs;
+    // the thread calling Run waits on its own request, so a done request
+    // wakes only that thread
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool done{false};
+    bool success{false};
+  };
+
+  // The queue of a node, with its own lock, taken by the workers of other
+  // nodes only when they steal.
+  struct Node {
+    std::mutex mutex;
+    std::deque<Request*> queue;
+    // notified when a request is queued to the node or the pool stops
+    std::condition_variable cv;
+    size_t idle_num{0};
+    bool stop{false};
+    std::atomic<size_t> local_num{0};
+    std::atomic<size_t> stolen_num{0};
+  };
+
+  void WorkerLoop(int node, PaddlePredictor* predictor,
+                  const std::vector<int>& cpus);
+  // The node of the CPU the calling thread runs on.
+  int CurrentNode();
+  // Take a request from the queues of the nodes other than node, each locked
+  // in turn.
+  Request* Steal(int node);
+  // Mark the request done and wake the thread waiting on it.
+  static void Finish(Request* request, bool success);
+
+  std::vector<std::vector<int>> node_cpus_;
+  const int workers_per_node_;
+  // predictors_[node][worker]
+  std::vector<std::vector<std::unique_ptr<PaddlePredictor>>> predictors_;
+  std::vector<std::vector<std::vector<int>>> worker_cpus_;
+  std::map<int, int> node_of_cpu_;
+
+  std::vector<std::unique_ptr<Node>> nodes_;
+  std::vector<std::thread> workers_;
+
+  std::atomic<size_t> next_node_{0};
+};
+
+}  // namespace paddle
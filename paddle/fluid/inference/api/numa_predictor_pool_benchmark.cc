@@ -0,0 +1,266 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Throughput and latency of serving the requests of clients by predictors
+// laid out on the NUMA nodes in several ways:
+//   unpinned: a predictor created by the main thread, and cloned for as many
+//             workers as the NUMA pool has, which the OS schedules freely.
+//   pinned:   the same predictors, with each worker bound to a share of all
+//             the CPUs, regardless of the nodes.
+//   numa:     a NumaPredictorPool, with a predictor created on each node and
+//             cloned for the workers of the node, each bound to a share of
+//             the CPUs of its node.
+// The clients send the requests in closed loops. The model is synthetic: a
+// run reads all its parameters, which the clones of a predictor share, as
+// the memory bound layers of a real model do.
+//
+// Usage:
+//   ./numa_predictor_pool_benchmark --clients=4,16,64 --workers_per_node=4 \
+//       --param_mb=64
+
+#include <algorithm>
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <iostream>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/inference/api/numa_predictor_pool.h"
+#include "paddle/fluid/platform/cpu_helper.h"
+#include "paddle/fluid/platform/cpu_info.h"
+#include "paddle/fluid/string/split.h"
+
+DEFINE_string(clients, "4,16",
+              "Comma separated numbers of client threads to be tested.");
+DEFINE_int32(requests, 20, "Requests sent by each client.");
+DEFINE_int32(workers_per_node, 2, "Workers of each NUMA node.");
+DEFINE_int32(num_nodes, 0, "NUMA nodes used, or all of them if 0.");
+DEFINE_int32(param_mb, 16, "Megabytes of the parameters of the model.");
+DEFINE_int32(width, 64, "Floats of the input of a request.");
+
+namespace paddle {
+
+// A model whose output is the sum of its input scaled by the sum of its
+// parameters, which are first touched by the thread creating it.
+class SyntheticPredictor : public PaddlePredictor {
+ public:
+  SyntheticPredictor()
+      : params_(std::make_shared<std::vector<float>>(
+            static_cast<size_t>(FLAGS_param_mb) * 1024 * 1024 / sizeof(float),
+            1.f / 1024)) {}
+
+  bool Run(const std::vector<PaddleTensor> &inputs,
+           std::vector<PaddleTensor> *output_data,
+           int batch_size = -1) override {
+    const PaddleTensor &x = inputs[0];
+    const float *data = static_cast<const float *>(x.data.data());
+    float x_sum = 0;
+    for (size_t i = 0; i < x.data.length() / sizeof(float); ++i) {
+      x_sum += data[i];
+    }
+    float param_sum = 0;
+    for (float p : *params_) {
+      param_sum += p;
+    }
+    output_data->resize(1);
+    PaddleTensor &out = (*output_data)[0];
+    out.name = "out";
+    out.dtype = PaddleDType::FLOAT32;
+    out.shape = {1};
+    out.data.Resize(sizeof(float));
+    static_cast<float *>(out.data.data())[0] = x_sum * param_sum;
+    return true;
+  }
+
+  std::unique_ptr<PaddlePredictor> Clone() override {
+    return std::unique_ptr<PaddlePredictor>(new SyntheticPredictor(params_));
+  }
+
+ private:
+  explicit SyntheticPredictor(std::shared_ptr<std::vector<float>> params)
+      : params_(params) {}
+
+  std::shared_ptr<std::vector<float>> params_;
+};
+
+// Predictors each serving a request at a time, taken by the clients from a
+// free list. With pinning, each predictor runs on its own share of the CPUs.
+class PredictorPool {
+ public:
+  PredictorPool(int size, const std::vector<std::vector<int>> &worker_cpus)
+      : worker_cpus_(worker_cpus) {
+    predictors_.emplace_back(new SyntheticPredictor);
+    free_.push_back(0);
+    for (int i = 1; i < size; ++i) {
+      predictors_.push_back(predictors_[0]->Clone());
+      free_.push_back(i);
+    }
+  }
+
+  bool Run(const std::vector<PaddleTensor> &inputs,
+           std::vector<PaddleTensor> *outputs) {
+    size_t i;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this] { return !free_.empty(); });
+      i = free_.back();
+      free_.pop_back();
+    }
+    if (!worker_cpus_.empty()) {
+      platform::SetThreadAffinity(worker_cpus_[i]);
+    }
+    bool success = predictors_[i]->Run(inputs, outputs);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      free_.push_back(i);
+    }
+    cv_.notify_one();
+    return success;
+  }
+
+ private:
+  std::vector<std::vector<int>> worker_cpus_;
+  std::vector<std::unique_ptr<PaddlePredictor>> predictors_;
+  std::vector<size_t> free_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+};
+
+// Send the requests of a client, and record their latencies in microseconds.
+template <typename RunFunc>
+static void RunClient(RunFunc run, std::vector<double> *latencies) {
+  std::vector<float> data(FLAGS_width, 1.f);
+  std::vector<PaddleTensor> inputs(1), outputs;
+  PaddleTensor &x = inputs[0];
+  x.name = "x";
+  x.dtype = PaddleDType::FLOAT32;
+  x.shape = {1, FLAGS_width};
+  x.data.Reset(data.data(), data.size() * sizeof(float));
+  for (int i = 0; i < FLAGS_requests; ++i) {
+    outputs.clear();
+    auto start = std::chrono::steady_clock::now();
+    bool success = run(inputs, &outputs);
+    latencies->push_back(std::chrono::duration<double, std::micro>(
+                             std::chrono::steady_clock::now() - start)
+                             .count());
+    CHECK(success);
+  }
+}
+
+template <typename RunFunc>
+static void RunBenchmark(const std::string &layout, int client_num,
+                         RunFunc run, NumaPredictorPool *numa) {
+  std::vector<std::vector<double>> latencies(client_num);
+  std::vector<std::thread> clients;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < client_num; ++i) {
+    clients.emplace_back(RunClient<RunFunc>, run, &latencies[i]);
+  }
+  for (auto &th : clients) {
+    th.join();
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  std::vector<double> all;
+  for (auto &l : latencies) {
+    all.insert(all.end(), l.begin(), l.end());
+  }
+  std::sort(all.begin(), all.end());
+  auto percentile = [&all](double p) {
+    return all[std::min(all.size() - 1, static_cast<size_t>(p * all.size()))];
+  };
+  double local_ratio = 0;
+  if (numa != nullptr) {
+    auto stat = numa->GetStat();
+    local_ratio = static_cast<double>(stat.local_num) /
+                  std::max<size_t>(stat.request_num, 1);
+  }
+  std::cout << layout << "\t" << client_num << "\t" << all.size() / seconds
+            << "\t" << percentile(0.5) << "\t" << percentile(0.99) << "\t"
+            << local_ratio << std::endl;
+}
+
+}  // namespace paddle
+
+int main(int argc, char *argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+
+  auto node_cpus = paddle::platform::GetNumaNodeCpus();
+  if (FLAGS_num_nodes > 0 &&
+      node_cpus.size() > static_cast<size_t>(FLAGS_num_nodes)) {
+    node_cpus.resize(FLAGS_num_nodes);
+  }
+  std::vector<int> all_cpus;
+  for (auto &cpus : node_cpus) {
+    all_cpus.insert(all_cpus.end(), cpus.begin(), cpus.end());
+  }
+  int worker_num = static_cast<int>(node_cpus.size()) * FLAGS_workers_per_node;
+  std::cout << node_cpus.size() << " nodes, " << all_cpus.size() << " CPUs, "
+            << worker_num << " workers" << std::endl;
+
+  // the pinned workers share all the CPUs, like those of the NUMA pool do
+  // within their nodes
+  std::vector<std::vector<int>> pinned_cpus;
+  for (int w = 0; w < worker_num; ++w) {
+    size_t begin = w * all_cpus.size() / worker_num;
+    size_t end = std::max((w + 1) * all_cpus.size() / worker_num, begin + 1);
+    pinned_cpus.emplace_back(all_cpus.begin() + begin,
+                             all_cpus.begin() + end);
+  }
+
+  std::cout << "layout\tclients\trequests/s\tp50 us\tp99 us\tlocal ratio"
+            << std::endl;
+  for (auto &s : paddle::string::Split(FLAGS_clients, ',')) {
+    int client_num = std::stoi(s);
+    using Tensors = std::vector<paddle::PaddleTensor>;
+
+    {
+      paddle::PredictorPool pool(worker_num, {});
+      paddle::RunBenchmark("unpinned", client_num,
+                           [&pool](const Tensors &inputs, Tensors *outputs) {
+                             return pool.Run(inputs, outputs);
+                           },
+                           nullptr);
+    }
+    {
+      paddle::PredictorPool pool(worker_num, pinned_cpus);
+      paddle::RunBenchmark("pinned", client_num,
+                           [&pool](const Tensors &inputs, Tensors *outputs) {
+                             return pool.Run(inputs, outputs);
+                           },
+                           nullptr);
+    }
+    {
+      paddle::NumaPredictorPool numa(
+          [](int node) {
+            return std::unique_ptr<paddle::PaddlePredictor>(
+                new paddle::SyntheticPredictor);
+          },
+          node_cpus, FLAGS_workers_per_node);
+      paddle::RunBenchmark("numa", client_num,
+                           [&numa](const Tensors &inputs, Tensors *outputs) {
+                             return numa.Run(inputs, outputs);
+                           },
+                           &numa);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,261 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/inference/api/numa_predictor_pool.h"
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+#include "paddle/fluid/platform/cpu_info.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+
+// The CPUs the calling thread may run on.
+static std::vector<int> ThreadCpus() {
+  std::vector<int> cpus;
+#ifdef __linux__
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  if (sched_getaffinity(0, sizeof(mask), &mask) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &mask)) {
+        cpus.push_back(cpu);
+      }
+    }
+  }
+#endif
+  return cpus;
+}
+
+/*
+ * A predictor of a model whose output is its float input x plus the node it
+ * is created for. It records the CPUs of the threads creating and running
+ * it.
+ */
+class FakePredictor : public PaddlePredictor {
+ public:
+  FakePredictor(int node, int run_us) : node_(node), run_us_(run_us) {
+    create_cpus_ = ThreadCpus();
+  }
+
+  bool Run(const std::vector<PaddleTensor> &inputs,
+           std::vector<PaddleTensor> *output_data,
+           int batch_size = -1) override {
+    if (inputs.empty() || inputs[0].dtype != PaddleDType::FLOAT32) {
+      return false;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      run_cpus_ = ThreadCpus();
+      ++run_num_;
+    }
+    if (run_us_ > 0) {
+      std::this_thread::sleep_for(std::chrono::microseconds(run_us_));
+    }
+    const PaddleTensor &x = inputs[0];
+    output_data->resize(1);
+    PaddleTensor &out = (*output_data)[0];
+    out.name = "out";
+    out.dtype = PaddleDType::FLOAT32;
+    out.shape = x.shape;
+    out.data.Resize(x.data.length());
+    const float *x_data = static_cast<const float *>(x.data.data());
+    float *out_data = static_cast<float *>(out.data.data());
+    for (size_t i = 0; i < x.data.length() / sizeof(float); ++i) {
+      out_data[i] = x_data[i] + node_;
+    }
+    return true;
+  }
+
+  std::unique_ptr<PaddlePredictor> Clone() override {
+    return std::unique_ptr<PaddlePredictor>(new FakePredictor(node_, run_us_));
+  }
+
+  std::vector<std::string> GetInputNames() override { return {"x"}; }
+
+  int node() const { return node_; }
+  const std::vector<int> &create_cpus() const { return create_cpus_; }
+  std::vector<int> run_cpus() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return run_cpus_;
+  }
+  int run_num() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return run_num_;
+  }
+
+ private:
+  int node_;
+  int run_us_;
+  std::vector<int> create_cpus_;
+  std::mutex mutex_;
+  std::vector<int> run_cpus_;
+  int run_num_{0};
+};
+
+// Two nodes made of the first CPUs the process may run on, or of the same
+// CPU if there is one.
+static std::vector<std::vector<int>> TestNodes() {
+  std::vector<int> cpus;
+  for (auto &node : platform::GetNumaNodeCpus()) {
+    cpus.insert(cpus.end(), node.begin(), node.end());
+  }
+  if (cpus.size() >= 4) {
+    return {{cpus[0], cpus[1]}, {cpus[2], cpus[3]}};
+  }
+  if (cpus.size() >= 2) {
+    return {{cpus[0]}, {cpus[1]}};
+  }
+  return {{cpus[0]}, {cpus[0]}};
+}
+
+static bool RunRequest(PaddlePredictor *predictor, float value, float *out) {
+  std::vector<PaddleTensor> inputs(1), outputs;
+  PaddleTensor &x = inputs[0];
+  x.name = "x";
+  x.dtype = PaddleDType::FLOAT32;
+  x.shape = {1, 2};
+  x.data.Resize(2 * sizeof(float));
+  static_cast<float *>(x.data.data())[0] = value;
+  static_cast<float *>(x.data.data())[1] = value;
+  if (!predictor->Run(inputs, &outputs) || outputs.size() != 1) {
+    return false;
+  }
+  *out = static_cast<float *>(outputs[0].data.data())[1];
+  return true;
+}
+
+TEST(NumaPredictorPool, workers) {
+  auto nodes = TestNodes();
+  std::vector<FakePredictor *> created;
+  NumaPredictorPool pool(
+      [&created](int node) {
+        created.push_back(new FakePredictor(node, 0));
+        return std::unique_ptr<PaddlePredictor>(created.back());
+      },
+      nodes, 2);
+  // a predictor created for each node, on the CPUs of the node
+  ASSERT_EQ(created.size(), 2UL);
+  for (size_t node = 0; node < nodes.size(); ++node) {
+    EXPECT_EQ(created[node]->node(), static_cast<int>(node));
+#ifdef __linux__
+    std::vector<int> cpus = nodes[node];
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    EXPECT_EQ(created[node]->create_cpus(), cpus);
+#endif
+  }
+
+  // the CPUs of the node shared by its workers
+  auto &worker_cpus = pool.worker_cpus();
+  ASSERT_EQ(worker_cpus.size(), 2UL);
+  for (size_t node = 0; node < nodes.size(); ++node) {
+    ASSERT_EQ(worker_cpus[node].size(), 2UL);
+    if (nodes[node].size() == 2) {
+      EXPECT_EQ(worker_cpus[node][0], std::vector<int>{nodes[node][0]});
+      EXPECT_EQ(worker_cpus[node][1], std::vector<int>{nodes[node][1]});
+    } else {
+      EXPECT_EQ(worker_cpus[node][0], nodes[node]);
+      EXPECT_EQ(worker_cpus[node][1], nodes[node]);
+    }
+  }
+
+  EXPECT_EQ(pool.GetInputNames(), std::vector<std::string>{"x"});
+  float out = 0;
+  ASSERT_TRUE(RunRequest(&pool, 1.f, &out));
+  EXPECT_TRUE(out == 1.f || out == 2.f);
+  // the worker running it is bound to its CPUs
+#ifdef __linux__
+  for (size_t node = 0; node < nodes.size(); ++node) {
+    if (created[node]->run_num() > 0 && nodes[node].size() == 2) {
+      EXPECT_EQ(created[node]->run_cpus(), worker_cpus[node][0]);
+    }
+  }
+#endif
+  EXPECT_FALSE(pool.ZeroCopyRun());
+}
+
+TEST(NumaPredictorPool, concurrent) {
+  auto nodes = TestNodes();
+  NumaPredictorPool pool(
+      [](int node) {
+        return std::unique_ptr<PaddlePredictor>(new FakePredictor(node, 200));
+      },
+      nodes, 2);
+
+  const int thread_num = 8, request_num = 50;
+  std::vector<std::thread> threads;
+  std::vector<int> failures(thread_num, 0);
+  for (int t = 0; t < thread_num; ++t) {
+    threads.emplace_back([&pool, &failures, t] {
+      for (int i = 0; i < request_num; ++i) {
+        float out = 0;
+        float value = t * 100 + i;
+        // the output is offset by the node of the worker
+        if (!RunRequest(&pool, value, &out) ||
+            (out != value && out != value + 1)) {
+          ++failures[t];
+        }
+      }
+    });
+  }
+  for (auto &th : threads) {
+    th.join();
+  }
+  for (int t = 0; t < thread_num; ++t) {
+    EXPECT_EQ(failures[t], 0);
+  }
+  auto stat = pool.GetStat();
+  EXPECT_EQ(stat.request_num, static_cast<size_t>(thread_num * request_num));
+  EXPECT_EQ(stat.local_num + stat.stolen_num, stat.request_num);
+
+  // the clone has its own workers on the same nodes
+  auto clone = pool.Clone();
+  ASSERT_NE(clone, nullptr);
+  float out = 0;
+  ASSERT_TRUE(RunRequest(clone.get(), 3.f, &out));
+  EXPECT_TRUE(out == 3.f || out == 4.f);
+  auto *clone_pool = dynamic_cast<NumaPredictorPool *>(clone.get());
+  ASSERT_NE(clone_pool, nullptr);
+  EXPECT_EQ(clone_pool->worker_cpus(), pool.worker_cpus());
+  EXPECT_EQ(pool.GetStat().request_num, stat.request_num);
+}
+
+TEST(NumaPredictorPool, create_failure) {
+  auto nodes = TestNodes();
+  NumaPredictorPool::Creator fail_on_node1 = [](int node) {
+    std::unique_ptr<PaddlePredictor> predictor;
+    if (node == 0) {
+      predictor.reset(new FakePredictor(node, 0));
+    }
+    return predictor;
+  };
+  EXPECT_THROW(NumaPredictorPool(fail_on_node1, nodes, 1),
+               platform::EnforceNotMet);
+  NumaPredictorPool::Creator create = [](int node) {
+    return std::unique_ptr<PaddlePredictor>(new FakePredictor(node, 0));
+  };
+  EXPECT_THROW(NumaPredictorPool(create, {}, 1), platform::EnforceNotMet);
+  EXPECT_THROW(NumaPredictorPool(create, nodes, 0), platform::EnforceNotMet);
+}
+
+}  // namespace paddle
@@ -377,6 +377,84 @@ struct PD_INFER_DECL AnalysisConfig {
     return cpu_math_library_num_threads_;
   }
 
+  ///
+  /// \brief Turn on the dynamic batching of the requests run concurrently.
+  /// Run of the predictor becomes thread safe, and the requests of the
+  /// threads calling it are concatenated into batches, which are run by
+  /// num_workers clones of the predictor. The outputs of a batch are split
+  /// back into the outputs of its requests. The requests are only batched if
+  /// the first dimensions of all the outputs of the model are -1, otherwise
+  /// they are run one by one. ZeroCopyRun is not supported.
+  ///
+  /// \param max_batch_size The maximum number of samples of a batch. The
+  /// samples of a request are the sequences of its first input if it has LoD,
+  /// otherwise the first dimension of it.
+  /// \param max_latency_us The maximum time in microseconds a request waits
+  /// for other requests to join its batch.
+  /// \param num_workers The number of predictors running the batches.
+  ///
+  void EnableDynamicBatching(int max_batch_size, int max_latency_us = 1000,
+                             int num_workers = 1);
+  ///
+  /// \brief A boolean state telling whether the dynamic batching is enabled.
+  ///
+  /// \return bool Whether the dynamic batching is enabled.
+  ///
+  bool dynamic_batching_enabled() const { return dynamic_batching_; }
+  ///
+  /// \brief The maximum number of samples of a dynamic batch.
+  ///
+  int dynamic_batching_max_batch_size() const {
+    return dynamic_batching_max_batch_size_;
+  }
+  ///
+  /// \brief The maximum time in microseconds a request waits for a dynamic
+  /// batch.
+  ///
+  int dynamic_batching_max_latency_us() const {
+    return dynamic_batching_max_latency_us_;
+  }
+  ///
+  /// \brief The number of predictors running the dynamic batches.
+  ///
+  int dynamic_batching_num_workers() const {
+    return dynamic_batching_num_workers_;
+  }
+
+  ///
+  /// \brief Turn on the pool of the predictor on the NUMA nodes. The
+  /// predictor is created on each node, with its own parameters, and cloned
+  /// for workers_per_node worker threads of the node, each bound to an equal
+  /// share of the CPUs of the node. Run of the predictor becomes thread safe,
+  /// and a request is run by a worker of the node the calling thread is on,
+  /// or by an idle worker of another node if those of its node are busy.
+  /// ZeroCopyRun is not supported, nor is the dynamic batching.
+  ///
+  /// The threads of the math library created by a worker, e.g. those of
+  /// OpenMP, are bound to the CPUs of the worker, of which there should be
+  /// no fewer than cpu_math_library_num_threads. The temporary memory of a
+  /// worker is on its node with the thread_local allocator strategy.
+  ///
+  /// \param workers_per_node The number of the workers of each node.
+  /// \param num_nodes The number of the nodes used, or all of them if it is
+  /// 0.
+  ///
+  void EnableNumaPool(int workers_per_node = 1, int num_nodes = 0);
+  ///
+  /// \brief A boolean state telling whether the NUMA pool is enabled.
+  ///
+  /// \return bool Whether the NUMA pool is enabled.
+  ///
+  bool numa_pool_enabled() const { return numa_pool_; }
+  ///
+  /// \brief The number of the workers of each node of the NUMA pool.
+  ///
+  int numa_pool_workers_per_node() const { return numa_pool_workers_per_node_; }
+  ///
+  /// \brief The number of the nodes of the NUMA pool, or 0 for all of them.
+  ///
+  int numa_pool_num_nodes() const { return numa_pool_num_nodes_; }
+
   ///
   /// \brief Transform the AnalysisConfig to NativeConfig.
   ///
@@ -452,6 +530,31 @@ struct PD_INFER_DECL AnalysisConfig {
   ///
   bool enable_memory_optim() const;
 
+  ///
+  /// \brief Turn on the static memory plan of ZeroCopyRun, which needs the
+  /// feed and fetch operators off. The temporary variables of the runs with
+  /// the input shapes and LoDs seen before are placed in one arena allocated
+  /// ahead, at the offsets planned from their lifetimes, so that the runs
+  /// don't allocate them.
+  ///
+  /// \param max_num_plans The number of the input shapes planned at most,
+  /// after which the runs with a new shape allocate as usual.
+  ///
+  void EnableStaticMemoryPlan(int max_num_plans = 8);
+  ///
+  /// \brief A boolean state telling whether the static memory plan is
+  /// enabled.
+  ///
+  /// \return bool Whether the static memory plan is enabled.
+  ///
+  bool static_memory_plan_enabled() const { return static_memory_plan_; }
+  ///
+  /// \brief The number of the input shapes planned at most.
+  ///
+  int static_memory_plan_max_num_plans() const {
+    return static_memory_plan_max_num_plans_;
+  }
+
   ///
   /// \brief Turn on profiling report.
   /// If not turned on, no profiling report will be generated.
@@ -552,6 +655,8 @@ struct PD_INFER_DECL AnalysisConfig {
 
   // memory reuse related.
   bool enable_memory_optim_{false};
+  bool static_memory_plan_{false};
+  int static_memory_plan_max_num_plans_{8};
 
   bool use_mkldnn_{false};
   std::unordered_set<std::string> mkldnn_enabled_op_types_;
@@ -566,6 +671,17 @@ struct PD_INFER_DECL AnalysisConfig {
 
   int cpu_math_library_num_threads_{1};
 
+  // dynamic batching related.
+  bool dynamic_batching_{false};
+  int dynamic_batching_max_batch_size_{32};
+  int dynamic_batching_max_latency_us_{1000};
+  int dynamic_batching_num_workers_{1};
+
+  // NUMA pool related.
+  bool numa_pool_{false};
+  int numa_pool_workers_per_node_{1};
+  int numa_pool_num_nodes_{0};
+
   bool with_profile_{false};
 
   bool with_glog_info_{true};
@@ -206,6 +206,19 @@ class PD_INFER_DECL ZeroCopyTensor {
   template <typename T>
   void copy_to_cpu(T* data);
 
+  /// \brief Bind a caller-owned buffer to the tensor, without copying.
+  /// The buffer is on the place of the predictor, and aligned to sizeof(T).
+  /// An input reads the data of the shape from the buffer. An output is
+  /// written into the buffer if it is of the shape or smaller, and is copied
+  /// there after the run if an op produces it elsewhere.
+  /// The binding lasts until the tensor is bound again, reshaped, or written
+  /// by mutable_data() or copy_from_cpu(), or the predictor is destroyed,
+  /// and the buffer should outlive it.
+  /// \param data The buffer of the tensor.
+  /// \param shape The shape of the data in the buffer.
+  template <typename T>
+  void ShareExternalData(T* data, const std::vector<int>& shape);
+
   /// \brief Return the shape of the Tensor.
   std::vector<int> shape() const;
 
@@ -232,6 +245,7 @@ class PD_INFER_DECL ZeroCopyTensor {
   explicit ZeroCopyTensor(void* scope) : scope_{scope} {}
   void SetName(const std::string& name) { name_ = name; }
   void* FindTensor() const;
+  void UnbindExternalData();
 
  private:
   std::string name_;
@@ -244,6 +258,8 @@ class PD_INFER_DECL ZeroCopyTensor {
   PaddlePlace place_;
   PaddleDType dtype_;
   int device_;
+  // The caller-owned buffers bound to the tensors of the predictor.
+  void* external_data_{nullptr};
 };
 
 /// \brief A Predictor for executing inference on a model.
@@ -327,6 +343,16 @@ class PD_INFER_DECL PaddlePredictor {
     return "NotImplemented";
   }
 
+  // New virtual functions are appended here, after the existing ones, to
+  // keep the vtable layout of the released library.
+
+  /// \brief Get the output shape of the model.
+  /// \return A map contains all the output names and shape defined in the
+  /// model, where -1 is a dimension of any size, e.g. the batch size.
+  virtual std::map<std::string, std::vector<int64_t>> GetOutputTensorShape() {
+    return {};
+  }
+
   /// \brief Base class for NativeConfig and AnalysisConfig.
   struct Config {
     std::string model_dir; /*!< path to the model directory. */
@@ -35,6 +35,7 @@
 #include "paddle/fluid/inference/tests/api/config_printer.h"
 #include "paddle/fluid/inference/tests/test_helper.h"
 #include "paddle/fluid/inference/utils/benchmark.h"
+#include "paddle/fluid/platform/monitor.h"
 #include "paddle/fluid/platform/profiler.h"
 
 DEFINE_string(model_name, "", "model name");
@@ -62,6 +63,9 @@ DEFINE_bool(record_benchmark, false,
 DEFINE_double(accuracy, 1e-3, "Result Accuracy.");
 DEFINE_double(quantized_accuracy, 1e-2, "Result Quantized Accuracy.");
 DEFINE_bool(zero_copy, false, "Use ZeroCopy to speedup Feed/Fetch.");
+DEFINE_bool(static_memory_plan, false,
+            "Plan the memory of the temporary variables of ZeroCopyRun in "
+            "an arena, and report its size against the peak memory.");
 DEFINE_bool(warmup, false,
             "Use warmup to calculate elapsed_time more accurately. "
             "To reduce CI time, it sets false in default.");
@@ -226,11 +230,27 @@ void CompareResult(const std::vector<PaddleTensor> &outputs,
   }
 }
 
+// STAT_cpu_mem_peak is only updated by the stat allocator, which wraps the
+// CPU allocators when they are created, so it has to be enabled before the
+// first allocation, i.e. before the first predictor loads its parameters.
+void EnableCPUMemStat() {
+  if (google::SetCommandLineOption("enable_cpu_mem_stat", "true").empty()) {
+    LOG(WARNING) << "Failed to enable FLAGS_enable_cpu_mem_stat, the peak "
+                    "CPU memory of --static_memory_plan will not be recorded.";
+  }
+}
+
 std::unique_ptr<PaddlePredictor> CreateTestPredictor(
     const PaddlePredictor::Config *config, bool use_analysis = true) {
   const auto *analysis_config =
       reinterpret_cast<const AnalysisConfig *>(config);
   if (use_analysis) {
+    if (FLAGS_static_memory_plan) {
+      EnableCPUMemStat();
+      AnalysisConfig plan_config(*analysis_config);
+      plan_config.EnableStaticMemoryPlan();
+      return CreatePaddlePredictor<AnalysisConfig>(plan_config);
+    }
     return CreatePaddlePredictor<AnalysisConfig>(*analysis_config);
   }
   auto native_config = analysis_config->ToNativeConfig();
@@ -448,6 +468,20 @@ void PredictionRun(PaddlePredictor *predictor,
   }
 }
 
+void SummarizeStaticMemoryPlan() {
+  auto get = [](const std::string &name) -> int64_t {
+    auto *stat = platform::StatRegistry<int64_t>::Instance().get(name);
+    return stat ? stat->get() : 0;
+  };
+  int64_t peak = get("STAT_cpu_mem_peak");
+  LOG(INFO) << "--- Static memory plan: arena "
+            << get("STAT_static_memory_arena_bytes")
+            << " bytes, peak CPU memory " << peak << " bytes";
+  LOG_IF(WARNING, peak == 0)
+      << "The peak CPU memory is not recorded, because the CPU allocators "
+         "were created before FLAGS_enable_cpu_mem_stat was enabled.";
+}
+
 void TestOneThreadPrediction(
     const PaddlePredictor::Config *config,
     const std::vector<std::vector<PaddleTensor>> &inputs,
@@ -460,6 +494,9 @@ void TestOneThreadPrediction(
   }
   PredictionRun(predictor.get(), inputs, outputs, 1, 0, data_type,
                 sample_latency);
+  if (FLAGS_static_memory_plan) {
+    SummarizeStaticMemoryPlan();
+  }
 }
 
 void TestMultiThreadPrediction(
@@ -29,13 +29,15 @@
 #include "paddle/fluid/memory/allocation/locked_allocator.h"
 #include "paddle/fluid/memory/allocation/naive_best_fit_allocator.h"
 #include "paddle/fluid/memory/allocation/retry_allocator.h"
+#include "paddle/fluid/memory/allocation/stat_allocator.h"
+#include "paddle/fluid/memory/allocation/thread_local_allocator.h"
 #include "paddle/fluid/platform/cpu_info.h"
 #include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/platform/op_tracer.h"
 #include "paddle/fluid/platform/place.h"
 #ifdef PADDLE_WITH_CUDA
 #include "paddle/fluid/memory/allocation/cuda_allocator.h"
 #include "paddle/fluid/memory/allocation/pinned_allocator.h"
-#include "paddle/fluid/memory/allocation/thread_local_allocator.h"
 #include "paddle/fluid/platform/cuda_device_guard.h"
 #include "paddle/fluid/platform/gpu_info.h"
 #endif
@@ -49,10 +51,24 @@ DEFINE_bool(use_system_allocator, false,
             "Whether to use system allocator to allocate CPU and GPU memory. "
             "Only used for unittests.");
 
+DEFINE_bool(enable_cpu_mem_stat, false,
+            "Whether to count the CPU memory in use, its peak, fragmentation "
+            "and the sizes of the allocations in the runtime stats. It costs "
+            "several atomic updates by each allocation.");
+
+DEFINE_bool(use_auto_growth_cpu_allocator, false,
+            "Whether the auto_growth allocator strategy allocates CPU memory "
+            "by the auto-growth best fit allocator, which can free the idle "
+            "chunks, rather than by the buddy allocator of naive_best_fit.");
+
 namespace paddle {
 namespace memory {
 namespace allocation {
 
+// Blocks split from the same chunk are aligned to the cache line size, which
+// also satisfies the alignment requirement of AVX-512 loads and stores.
+static constexpr size_t kAutoGrowthCPUAlignment = 64;
+
 class AllocatorFacadePrivate {
  public:
   using AllocatorMap = std::map<platform::Place, std::shared_ptr<Allocator>>;
@@ -73,7 +89,11 @@ class AllocatorFacadePrivate {
       }
 
       case AllocatorStrategy::kAutoGrowth: {
-        InitNaiveBestFitCPUAllocator();
+        if (FLAGS_use_auto_growth_cpu_allocator) {
+          InitAutoGrowthCPUAllocator();
+        } else {
+          InitNaiveBestFitCPUAllocator();
+        }
 #ifdef PADDLE_WITH_CUDA
         for (int dev_id = 0; dev_id < platform::GetCUDADeviceCount();
              ++dev_id) {
@@ -85,7 +105,7 @@ class AllocatorFacadePrivate {
       }
 
       case AllocatorStrategy::kThreadLocal: {
-        InitNaiveBestFitCPUAllocator();
+        InitThreadLocalCPUAllocator();
 #ifdef PADDLE_WITH_CUDA
         for (int dev_id = 0; dev_id < platform::GetCUDADeviceCount();
              ++dev_id) {
@@ -107,6 +127,9 @@ class AllocatorFacadePrivate {
     if (FLAGS_gpu_allocator_retry_time > 0) {
       WrapCUDARetryAllocator(FLAGS_gpu_allocator_retry_time);
     }
+    if (FLAGS_enable_cpu_mem_stat) {
+      WrapCPUStatAllocator();
+    }
 
     CheckAllocThreadSafe();
   }
@@ -143,6 +166,19 @@ class AllocatorFacadePrivate {
         std::make_shared<NaiveBestFitAllocator>(platform::CPUPlace());
   }
 
+  void InitAutoGrowthCPUAllocator() {
+    auto cpu_allocator = std::make_shared<CPUAllocator>();
+    allocators_[platform::CPUPlace()] =
+        std::make_shared<AutoGrowthBestFitAllocator>(
+            cpu_allocator, kAutoGrowthCPUAlignment,
+            platform::CpuMinChunkSize());
+  }
+
+  void InitThreadLocalCPUAllocator() {
+    allocators_[platform::CPUPlace()] =
+        std::make_shared<ThreadLocalCPUAllocator>();
+  }
+
 #ifdef PADDLE_WITH_CUDA
   void InitNaiveBestFitCUDAPinnedAllocator() {
     allocators_[platform::CUDAPinnedPlace()] =
@@ -223,6 +259,15 @@ class AllocatorFacadePrivate {
     }
   }
 
+  void WrapCPUStatAllocator() {
+    for (auto* allocators : {&allocators_, &system_allocators_}) {
+      auto iter = allocators->find(platform::CPUPlace());
+      if (iter != allocators->end()) {
+        iter->second = std::make_shared<StatAllocator>(iter->second);
+      }
+    }
+  }
+
  private:
   AllocatorMap allocators_;
   AllocatorMap zero_size_allocators_;
@@ -247,6 +292,7 @@ std::shared_ptr<Allocation> AllocatorFacade::AllocShared(
 
 AllocationPtr AllocatorFacade::Alloc(const platform::Place& place,
                                      size_t size) {
+  platform::OpTracer::RecordAlloc(size);
   return m_->GetAllocator(place, size)->Allocate(size);
 }
 
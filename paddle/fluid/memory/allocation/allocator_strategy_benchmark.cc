@@ -0,0 +1,123 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Multi-threaded CPU allocation benchmark, which compares the throughput of
+// the naive_best_fit, auto_growth and thread_local allocator strategies.
+//
+// Usage:
+//   ./allocator_strategy_benchmark --threads=1,4,16,32 --iterations=100000
+
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/memory/allocation/auto_growth_best_fit_allocator.h"
+#include "paddle/fluid/memory/allocation/cpu_allocator.h"
+#include "paddle/fluid/memory/allocation/naive_best_fit_allocator.h"
+#include "paddle/fluid/memory/allocation/thread_local_allocator.h"
+#include "paddle/fluid/platform/cpu_info.h"
+#include "paddle/fluid/string/split.h"
+
+DEFINE_string(threads, "1,2,4,8,16,32",
+              "Comma separated thread numbers to be tested.");
+DEFINE_int32(iterations, 100000, "Allocations issued by each thread.");
+DEFINE_int32(live_allocations, 64,
+             "Number of allocations each thread keeps alive at the same "
+             "time, which simulates the lifetime of temporary tensors.");
+DEFINE_int32(max_size, 1 << 16, "The max size (bytes) of each allocation.");
+DEFINE_string(filter, "", "The allocator strategy would be run.");
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+static std::shared_ptr<Allocator> CreateAllocator(const std::string& name) {
+  if (name == "naive_best_fit") {
+    return std::make_shared<NaiveBestFitAllocator>(platform::CPUPlace());
+  } else if (name == "auto_growth") {
+    return std::make_shared<AutoGrowthBestFitAllocator>(
+        std::make_shared<CPUAllocator>(), 64, platform::CpuMinChunkSize());
+  } else if (name == "thread_local") {
+    return std::make_shared<ThreadLocalCPUAllocator>();
+  }
+  LOG(FATAL) << "Unknown allocator strategy " << name;
+  return nullptr;
+}
+
+static void AllocateLoop(Allocator* allocator, unsigned int seed) {
+  // Most tensors in operators are small, so the sizes follow a log-uniform
+  // distribution rather than an uniform one.
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> dist(
+      0, std::log2(static_cast<double>(FLAGS_max_size)));
+  std::vector<AllocationPtr> live(FLAGS_live_allocations);
+  for (int i = 0; i < FLAGS_iterations; ++i) {
+    size_t size = static_cast<size_t>(std::exp2(dist(rng))) + 1;
+    auto& slot = live[i % live.size()];
+    slot = allocator->Allocate(size);
+    *static_cast<char*>(slot->ptr()) = 0;
+  }
+}
+
+static double RunBenchmark(const std::string& name, int thread_num) {
+  auto allocator = CreateAllocator(name);
+  // Warm up, so that the cost of growing chunks is not counted.
+  AllocateLoop(allocator.get(), 0);
+
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < thread_num; ++i) {
+    threads.emplace_back(AllocateLoop, allocator.get(), i + 1);
+  }
+  for (auto& th : threads) {
+    th.join();
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end - start).count();
+}
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+
+  std::vector<int> thread_nums;
+  for (auto& s : paddle::string::Split(FLAGS_threads, ',')) {
+    thread_nums.push_back(std::stoi(s));
+  }
+
+  std::cout << "strategy\tthreads\tseconds\tM allocs/s" << std::endl;
+  for (auto& name : {"naive_best_fit", "auto_growth", "thread_local"}) {
+    if (!FLAGS_filter.empty() && FLAGS_filter != name) {
+      continue;
+    }
+    for (int thread_num : thread_nums) {
+      double seconds =
+          paddle::memory::allocation::RunBenchmark(name, thread_num);
+      double allocs = static_cast<double>(thread_num) * FLAGS_iterations;
+      std::cout << name << "\t" << thread_num << "\t" << seconds << "\t"
+                << allocs / seconds / 1e6 << std::endl;
+    }
+  }
+  return 0;
+}
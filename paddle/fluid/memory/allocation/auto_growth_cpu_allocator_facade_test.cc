@@ -0,0 +1,47 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gflags/gflags.h>
+#include <gtest/gtest.h>
+#include <cstdint>
+#include "paddle/fluid/memory/allocation/allocator_facade.h"
+
+DECLARE_string(allocator_strategy);
+DECLARE_bool(use_auto_growth_cpu_allocator);
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+TEST(allocator, auto_growth_cpu_allocator) {
+  FLAGS_allocator_strategy = "auto_growth";
+  FLAGS_use_auto_growth_cpu_allocator = true;
+
+  auto &instance = AllocatorFacade::Instance();
+  platform::CPUPlace place;
+  for (size_t size : {1, 100, 1024, 5000}) {
+    auto allocation = instance.Alloc(place, size);
+    ASSERT_NE(allocation, nullptr);
+    ASSERT_NE(allocation->ptr(), nullptr);
+    ASSERT_EQ(allocation->place(), place);
+    // the blocks of the auto-growth allocator are aligned to 64 bytes, rather
+    // than to the 1024 bytes of the buddy allocator
+    EXPECT_EQ(allocation->size(), AlignedSize(size, 64));
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(allocation->ptr()) % 64, 0UL);
+  }
+}
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
@@ -18,6 +18,10 @@
 
 #include <string>
 
+#include "paddle/fluid/platform/monitor.h"
+
+USE_INT_STAT(STAT_cpu_mem_reserved);
+
 namespace paddle {
 namespace memory {
 namespace allocation {
@@ -31,6 +35,7 @@ void CPUAllocator::FreeImpl(Allocation *allocation) {
 #else
   free(p);
 #endif
+  STAT_SUB(STAT_cpu_mem_reserved, static_cast<int64_t>(allocation->size()));
   delete allocation;
 }
 
@@ -45,6 +50,7 @@ Allocation *CPUAllocator::AllocateImpl(size_t size) {
       platform::errors::ResourceExhausted(
           "Fail to alloc memory of %ld size, error code is %d.", size, error));
 #endif
+  STAT_ADD(STAT_cpu_mem_reserved, static_cast<int64_t>(size));
   return new Allocation(p, size, platform::CPUPlace());
 }
 }  // namespace allocation
@@ -51,6 +51,13 @@ MemoryMapReaderAllocation::~MemoryMapReaderAllocation() {
   VLOG(3) << "~MemoryMapReaderAllocation: " << this->ipc_name();
 }
 
+MemoryMapFileAllocation::~MemoryMapFileAllocation() {
+  PADDLE_ENFORCE_NE(
+      munmap(map_ptr_, map_size_), -1,
+      platform::errors::Unavailable("could not unmap the file %s",
+                                    this->file_name()));
+}
+
 std::string GetIPCName() {
   static std::random_device rd;
   std::string handle = "/paddle_";
@@ -101,6 +108,28 @@ std::shared_ptr<MemoryMapReaderAllocation> RebuildMemoryMapReaderAllocation(
   return std::make_shared<MemoryMapReaderAllocation>(ptr, size, ipc_name);
 }
 
+std::shared_ptr<MemoryMapFileAllocation> AllocateMemoryMapFileAllocation(
+    const std::string &file_name, size_t offset, size_t size) {
+  int fd = open(file_name.c_str(), O_RDONLY);
+  PADDLE_ENFORCE_NE(fd, -1, platform::errors::Unavailable(
+                                "File %s open failed", file_name.c_str()));
+  size_t page_offset = offset % static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  size_t map_size = size + page_offset;
+  void *map_ptr = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                       fd, static_cast<off_t>(offset - page_offset));
+  close(fd);
+  PADDLE_ENFORCE_NE(
+      map_ptr, MAP_FAILED,
+      platform::errors::Unavailable("Memory map failed when map %d bytes of "
+                                    "file %s at offset %d.",
+                                    size, file_name.c_str(), offset));
+  // read the pages ahead, which are usually read soon after being loaded
+  madvise(map_ptr, map_size, MADV_WILLNEED);
+  return std::make_shared<MemoryMapFileAllocation>(
+      map_ptr, map_size, static_cast<char *>(map_ptr) + page_offset, size,
+      file_name);
+}
+
 MemoryMapFdSet &MemoryMapFdSet::Instance() {  // NOLINT
   static MemoryMapFdSet set;
   return set;
@@ -58,12 +58,39 @@ class MemoryMapReaderAllocation : public Allocation {
   std::string ipc_name_;
 };
 
+// A region of a regular file mapped copy-on-write, which shares the pages of
+// the file until they are written. Unlike MemoryMapReaderAllocation, it does
+// not unlink the file when it is freed.
+class MemoryMapFileAllocation : public Allocation {
+ public:
+  explicit MemoryMapFileAllocation(void *map_ptr, size_t map_size, void *ptr,
+                                   size_t size, std::string file_name)
+      : Allocation(ptr, size, platform::CPUPlace()),
+        map_ptr_(map_ptr),
+        map_size_(map_size),
+        file_name_(std::move(file_name)) {}
+
+  inline const std::string &file_name() const { return file_name_; }
+
+  ~MemoryMapFileAllocation() override;
+
+ private:
+  // the mapping, which starts at the page of ptr
+  void *map_ptr_;
+  size_t map_size_;
+  std::string file_name_;
+};
+
 std::shared_ptr<MemoryMapWriterAllocation> AllocateMemoryMapWriterAllocation(
     size_t size);
 
 std::shared_ptr<MemoryMapReaderAllocation> RebuildMemoryMapReaderAllocation(
     const std::string &ipc_name, size_t size);
 
+// Map size bytes of the file at offset, which needs not be aligned to pages.
+std::shared_ptr<MemoryMapFileAllocation> AllocateMemoryMapFileAllocation(
+    const std::string &file_name, size_t offset, size_t size);
+
 class MemoryMapFdSet {
  public:
   static MemoryMapFdSet &Instance();  // NOLINT
@@ -17,6 +17,11 @@
 #include "paddle/fluid/memory/allocation/mmap_allocator.h"
 
 #include <sys/types.h>
+#include <unistd.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
 
 #include "gtest/gtest.h"
 
@@ -47,6 +52,42 @@ TEST(MemoryMapAllocation, test_allocation_base) {
   }
 }
 
+TEST(MemoryMapAllocation, test_file_allocation) {
+  // the child process forked by the former test runs this test too
+  std::string file_name =
+      "mmap_file_allocation_test_" + std::to_string(getpid()) + ".bin";
+  std::vector<int32_t> data(4096);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<int32_t>(i);
+  }
+  {
+    std::ofstream fout(file_name, std::ios::binary);
+    fout.write(reinterpret_cast<const char*>(data.data()),
+               data.size() * sizeof(int32_t));
+  }
+  // the offset is not aligned to the pages
+  size_t offset = 1001 * sizeof(int32_t);
+  size_t size = 2000 * sizeof(int32_t);
+  auto holder = AllocateMemoryMapFileAllocation(file_name, offset, size);
+  ASSERT_EQ(holder->size(), size);
+  auto* ptr = static_cast<int32_t*>(holder->ptr());
+  for (int32_t i = 0; i < 2000; ++i) {
+    ASSERT_EQ(ptr[i], i + 1001);
+  }
+  // the pages written are copied rather than written to the file
+  ptr[0] = -1;
+  holder.reset();
+  std::ifstream fin(file_name, std::ios::binary);
+  fin.seekg(offset);
+  int32_t value;
+  fin.read(reinterpret_cast<char*>(&value), sizeof(value));
+  ASSERT_EQ(value, 1001);
+
+  ASSERT_THROW(AllocateMemoryMapFileAllocation("not_exist.bin", 0, 8),
+               platform::EnforceNotMet);
+  std::remove(file_name.c_str());
+}
+
 }  // namespace allocation
 }  // namespace memory
 }  // namespace paddle
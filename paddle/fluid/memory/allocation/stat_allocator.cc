@@ -0,0 +1,71 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/memory/allocation/stat_allocator.h"
+
+#include <utility>
+
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/platform/monitor.h"
+
+USE_INT_STAT(STAT_cpu_mem_in_use);
+USE_INT_STAT(STAT_cpu_mem_peak);
+USE_INT_STAT(STAT_cpu_mem_reserved);
+USE_HISTOGRAM_STAT(STAT_cpu_alloc_size);
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+// The fragmentation is sampled when the stats are exported, rather than
+// computed by every allocation. It is registered by the first StatAllocator,
+// since the bytes in use are not counted without one.
+static void RegisterFragmentationGauge() {
+  static platform::FloatStatGauge gauge("STAT_cpu_mem_fragmentation", [] {
+    int64_t reserved = STAT_GET(STAT_cpu_mem_reserved);
+    int64_t in_use = STAT_GET(STAT_cpu_mem_in_use);
+    // The two stats are read without a lock, so the bytes in use may exceed
+    // the reserved ones for a moment.
+    return reserved > in_use ? 1.0f - static_cast<float>(in_use) / reserved
+                             : 0.0f;
+  });
+}
+
+StatAllocator::StatAllocator(std::shared_ptr<Allocator> allocator)
+    : underlying_allocator_(std::move(allocator)) {
+  PADDLE_ENFORCE_NOT_NULL(
+      underlying_allocator_,
+      platform::errors::InvalidArgument(
+          "Underlying allocator of StatAllocator is NULL"));
+  RegisterFragmentationGauge();
+}
+
+void StatAllocator::FreeImpl(Allocation* allocation) {
+  int64_t size = static_cast<int64_t>(allocation->size());
+  underlying_allocator_->Free(allocation);
+  STAT_SUB(STAT_cpu_mem_in_use, size);
+}
+
+Allocation* StatAllocator::AllocateImpl(size_t size) {
+  Allocation* allocation = underlying_allocator_->Allocate(size).release();
+  int64_t in_use = STAT_ADD(STAT_cpu_mem_in_use,
+                            static_cast<int64_t>(allocation->size()));
+  STAT_UPDATE_MAX(STAT_cpu_mem_peak, in_use);
+  STAT_OBSERVE(STAT_cpu_alloc_size, static_cast<int64_t>(size));
+  return allocation;
+}
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
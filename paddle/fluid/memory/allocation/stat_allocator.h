@@ -0,0 +1,57 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <memory>
+
+#include "paddle/fluid/memory/allocation/allocator.h"
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+/*
+ * @brief Counts the CPU memory allocated through the underlying allocator in
+ * the stats of platform/monitor.h:
+ *
+ *   STAT_cpu_mem_in_use: the bytes of the allocations not freed yet.
+ *   STAT_cpu_mem_peak: the maximum of STAT_cpu_mem_in_use.
+ *   STAT_cpu_mem_fragmentation: the fraction of the bytes reserved from the
+ *     system, STAT_cpu_mem_reserved, which are not in use, sampled when the
+ *     stats are exported.
+ *   STAT_cpu_alloc_size: the histogram of the sizes of the allocations.
+ *
+ * Each allocation updates several shared atomics, so the facade only wraps
+ * the CPU allocators with it if FLAGS_enable_cpu_mem_stat is true.
+ */
+class StatAllocator : public Allocator {
+ public:
+  explicit StatAllocator(std::shared_ptr<Allocator> allocator);
+
+  bool IsAllocThreadSafe() const override {
+    return underlying_allocator_->IsAllocThreadSafe();
+  }
+
+ protected:
+  void FreeImpl(Allocation* allocation) override;
+  Allocation* AllocateImpl(size_t size) override;
+
+ private:
+  std::shared_ptr<Allocator> underlying_allocator_;
+};
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
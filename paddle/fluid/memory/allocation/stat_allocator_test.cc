@@ -0,0 +1,74 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/memory/allocation/stat_allocator.h"
+
+#include <memory>
+#include <utility>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/memory/allocation/best_fit_allocator.h"
+#include "paddle/fluid/memory/allocation/cpu_allocator.h"
+#include "paddle/fluid/platform/monitor.h"
+
+USE_INT_STAT(STAT_cpu_mem_in_use);
+USE_INT_STAT(STAT_cpu_mem_peak);
+USE_INT_STAT(STAT_cpu_mem_reserved);
+USE_HISTOGRAM_STAT(STAT_cpu_alloc_size);
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+static float Fragmentation() {
+  for (auto& stat : platform::StatGaugeRegistry::Instance().publish_float()) {
+    if (stat.key == "STAT_cpu_mem_fragmentation") {
+      return stat.value;
+    }
+  }
+  return -1.0f;
+}
+
+TEST(StatAllocator, CountBytes) {
+  int64_t reserved = STAT_GET(STAT_cpu_mem_reserved);
+  int64_t in_use = STAT_GET(STAT_cpu_mem_in_use);
+  int64_t num_allocs = _STAT_cpu_alloc_size.Export("").count;
+
+  CPUAllocator cpu_allocator;
+  size_t chunk_size = 1 << 20;
+  auto chunk = cpu_allocator.Allocate(chunk_size);
+  EXPECT_EQ(STAT_GET(STAT_cpu_mem_reserved),
+            reserved + static_cast<int64_t>(chunk_size));
+
+  StatAllocator allocator(std::make_shared<BestFitAllocator>(chunk.get()));
+  {
+    auto a = allocator.Allocate(chunk_size / 4);
+    auto b = allocator.Allocate(chunk_size / 4);
+    EXPECT_EQ(STAT_GET(STAT_cpu_mem_in_use),
+              in_use + static_cast<int64_t>(chunk_size / 2));
+    EXPECT_GE(STAT_GET(STAT_cpu_mem_peak), STAT_GET(STAT_cpu_mem_in_use));
+    EXPECT_FLOAT_EQ(Fragmentation(),
+                    1.0f - static_cast<float>(STAT_GET(STAT_cpu_mem_in_use)) /
+                               STAT_GET(STAT_cpu_mem_reserved));
+  }
+  EXPECT_EQ(STAT_GET(STAT_cpu_mem_in_use), in_use);
+  EXPECT_EQ(_STAT_cpu_alloc_size.Export("").count, num_allocs + 2);
+
+  chunk.reset();
+  EXPECT_EQ(STAT_GET(STAT_cpu_mem_reserved), reserved);
+}
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
@@ -13,25 +13,51 @@
 // limitations under the License.
 
 #include "paddle/fluid/memory/allocation/thread_local_allocator.h"
+#include <algorithm>
 
 namespace paddle {
 namespace memory {
 namespace allocation {
 
+// Every thread owns a BuddyAllocator, so it should not pre-allocate chunks as
+// large as the global CPU BuddyAllocator does. Larger requests are sent to
+// the system allocator directly and returned to the system once freed.
+static size_t ThreadLocalCPUMaxChunkSize() {
+  constexpr size_t kMaxChunkSize = static_cast<size_t>(64) << 20;
+  return std::min(platform::CpuMaxChunkSize(), kMaxChunkSize);
+}
+
 ThreadLocalAllocatorImpl::ThreadLocalAllocatorImpl(const platform::Place& p)
     : place_(p) {
+#ifdef PADDLE_WITH_CUDA
   if (platform::is_gpu_place(place_)) {
     buddy_allocator_.reset(new memory::detail::BuddyAllocator(
         std::unique_ptr<memory::detail::SystemAllocator>(
             new memory::detail::GPUAllocator(
                 BOOST_GET_CONST(platform::CUDAPlace, place_).device)),
         platform::GpuMinChunkSize(), platform::GpuMaxChunkSize()));
+    return;
+  }
+#endif
+  if (platform::is_cpu_place(place_)) {
+    buddy_allocator_.reset(new memory::detail::BuddyAllocator(
+        std::unique_ptr<memory::detail::SystemAllocator>(
+            new memory::detail::CPUAllocator()),
+        platform::CpuMinChunkSize(), ThreadLocalCPUMaxChunkSize()));
   } else {
     PADDLE_THROW(platform::errors::Unavailable(
-        "Thread local allocator only supports CUDAPlace now."));
+        "Thread local allocator only supports CPUPlace and CUDAPlace now."));
+  }
+}
+
+std::shared_ptr<ThreadLocalAllocatorImpl> ThreadLocalCPUAllocatorPool::Get() {
+  if (allocator_ == nullptr) {
+    allocator_.reset(new ThreadLocalAllocatorImpl(platform::CPUPlace()));
   }
+  return allocator_;
 }
 
+#ifdef PADDLE_WITH_CUDA
 std::shared_ptr<ThreadLocalAllocatorImpl> ThreadLocalCUDAAllocatorPool::Get(
     int gpu_id) {
   auto pos = std::distance(devices_.begin(),
@@ -57,6 +83,7 @@ ThreadLocalCUDAAllocatorPool::ThreadLocalCUDAAllocatorPool()
     init_flags_.emplace_back(new std::once_flag());
   }
 }
+#endif
 
 ThreadLocalAllocation* ThreadLocalAllocatorImpl::AllocateImpl(size_t size) {
   VLOG(10) << "ThreadLocalAllocatorImpl::AllocateImpl " << size;
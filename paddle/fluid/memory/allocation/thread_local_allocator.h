@@ -57,6 +57,43 @@ class ThreadLocalAllocatorImpl
   platform::Place place_;
 };
 
+class ThreadLocalCPUAllocatorPool {
+ public:
+  static ThreadLocalCPUAllocatorPool& Instance() {
+    static thread_local ThreadLocalCPUAllocatorPool pool;
+    return pool;
+  }
+
+  std::shared_ptr<ThreadLocalAllocatorImpl> Get();
+
+ private:
+  ThreadLocalCPUAllocatorPool() = default;
+  std::shared_ptr<ThreadLocalAllocatorImpl> allocator_;
+};
+
+// Each thread owns its own BuddyAllocator, so the allocation path never
+// contends with other threads. An allocation may be freed by any thread, it
+// is always returned to the BuddyAllocator of the thread which allocated it.
+// When a thread exits, its BuddyAllocator is destroyed (and its chunks are
+// returned to the system) once all of its allocations have been freed.
+class ThreadLocalCPUAllocator : public Allocator {
+ public:
+  ThreadLocalCPUAllocator() = default;
+
+  bool IsAllocThreadSafe() const override { return true; }
+
+ protected:
+  Allocation* AllocateImpl(size_t size) override {
+    return ThreadLocalCPUAllocatorPool::Instance().Get()->AllocateImpl(size);
+  }
+  void FreeImpl(Allocation* allocation) override {
+    auto* tl_allocation = static_cast<ThreadLocalAllocation*>(allocation);
+    auto allocator_impl = tl_allocation->GetAllocator();
+    allocator_impl->FreeImpl(tl_allocation);
+  }
+};
+
+#ifdef PADDLE_WITH_CUDA
 class ThreadLocalCUDAAllocatorPool {
  public:
   static ThreadLocalCUDAAllocatorPool& Instance() {
@@ -94,6 +131,7 @@ class ThreadLocalCUDAAllocator : public Allocator {
  private:
   int gpu_id_;
 };
+#endif
 
 }  // namespace allocation
 }  // namespace memory
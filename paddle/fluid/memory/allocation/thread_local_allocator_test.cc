@@ -15,21 +15,67 @@
 #include "paddle/fluid/memory/allocation/thread_local_allocator.h"
 #include <algorithm>
 #include <condition_variable>  // NOLINT
+#include <cstring>
 #include <functional>
 #include <iostream>
 #include <thread>  // NOLINT
 #include <utility>
+#include <vector>
+#include "gflags/gflags.h"
 #include "gtest/gtest.h"
 #include "paddle/fluid/memory/malloc.h"
 #include "paddle/fluid/platform/gpu_info.h"
 
+#ifdef PADDLE_WITH_CUDA
 DECLARE_double(fraction_of_gpu_memory_to_use);
+#endif
 DECLARE_string(allocator_strategy);
 
 namespace paddle {
 namespace memory {
 namespace allocation {
 
+TEST(ThreadLocalAllocator, cpu_cross_thread_release) {
+  FLAGS_allocator_strategy = "thread_local";
+
+  const size_t thread_num = 8;
+  const size_t alloc_num = 100;
+  std::vector<void *> allocator_addresses(thread_num);
+  std::vector<std::vector<AllocationPtr>> thread_allocations(thread_num);
+
+  std::vector<std::thread> threads(thread_num);
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i] = std::thread([&, i]() {
+      for (size_t j = 0; j < alloc_num; ++j) {
+        size_t size = (j + 1) * 64;
+        auto allocation = memory::Alloc(platform::CPUPlace(), size);
+        ASSERT_NE(allocation->ptr(), nullptr);
+        ASSERT_EQ(allocation->size(), size);
+        // Touch the whole allocation to make sure it is writable.
+        memset(allocation->ptr(), static_cast<int>(i), size);
+        thread_allocations[i].emplace_back(std::move(allocation));
+      }
+      allocator_addresses[i] =
+          ThreadLocalCPUAllocatorPool::Instance().Get().get();
+    });
+  }
+
+  for (auto &th : threads) {
+    th.join();
+  }
+
+  std::sort(allocator_addresses.begin(), allocator_addresses.end());
+  ASSERT_EQ(std::adjacent_find(allocator_addresses.begin(),
+                               allocator_addresses.end(),
+                               std::equal_to<void *>()),
+            allocator_addresses.end());
+
+  // All threads have exited, the allocations must be released to the
+  // thread local allocators they come from.
+  thread_allocations.clear();
+}
+
+#ifdef PADDLE_WITH_CUDA
 TEST(ThreadLocalAllocator, cross_scope_release) {
   FLAGS_fraction_of_gpu_memory_to_use = 0.1;
   FLAGS_allocator_strategy = "thread_local";
@@ -87,6 +133,7 @@ TEST(ThreadLocalAllocator, cross_scope_release) {
   ASSERT_EXIT(([&]() { thread_allocations.clear(); }(), exit(0)),
               ::testing::ExitedWithCode(0), ".*");
 }
+#endif
 
 }  // namespace allocation
 }  // namespace memory
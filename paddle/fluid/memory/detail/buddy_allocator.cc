@@ -15,10 +15,13 @@ limitations under the License. */
 #include "paddle/fluid/memory/detail/buddy_allocator.h"
 
 #include <algorithm>
+#include <atomic>
 #include <utility>
 
+#include "gflags/gflags.h"
 #include "glog/logging.h"
 
+DECLARE_uint64(cpu_thread_cache_in_kb);
 #ifdef PADDLE_WITH_CUDA
 DECLARE_uint64(reallocate_gpu_memory_in_mb);
 #endif
@@ -27,17 +30,160 @@ namespace paddle {
 namespace memory {
 namespace detail {
 
+// The blocks of 1 to kThreadCacheClassNum min chunks are cached.
+static constexpr size_t kThreadCacheClassNum = 16;
+// A thread cache returns the blocks left idle to the buddy allocator every
+// kThreadCacheDrainInterval allocations and frees.
+static constexpr size_t kThreadCacheDrainInterval = 4096;
+
+// Guards the links between the allocators and the caches of the threads,
+// i.e. ThreadCache::owner and BuddyAllocator::thread_caches_. Never destroyed,
+// since threads may exit after the static destructors.
+static std::mutex* ThreadCacheMutex() {
+  static std::mutex* mutex = new std::mutex();
+  return mutex;
+}
+
+static std::atomic<uint64_t> g_next_allocator_id{0};
+
+struct ThreadCache {
+  ThreadCache(BuddyAllocator* owner, uint64_t allocator_id)
+      : owner(owner), allocator_id(allocator_id) {
+    std::fill(lists, lists + kThreadCacheClassNum, nullptr);
+    std::fill(nums, nums + kThreadCacheClassNum, 0);
+    std::fill(low_nums, low_nums + kThreadCacheClassNum, 0);
+  }
+
+  // The free lists are linked through the first bytes of the block data.
+  static MemoryBlock*& Next(MemoryBlock* block) {
+    return *static_cast<MemoryBlock**>(block->Data());
+  }
+
+  MemoryBlock* Pop(size_t cls) {
+    MemoryBlock* block = lists[cls];
+    lists[cls] = Next(block);
+    low_nums[cls] = std::min(low_nums[cls], --nums[cls]);
+    return block;
+  }
+
+  void Push(size_t cls, MemoryBlock* block) {
+    Next(block) = lists[cls];
+    lists[cls] = block;
+    ++nums[cls];
+  }
+
+  // Only the owning thread writes the counters, others read them in
+  // GetThreadCacheStat.
+  static void Add(std::atomic<size_t>* counter, int64_t value) {
+    counter->store(counter->load(std::memory_order_relaxed) + value,
+                   std::memory_order_relaxed);
+  }
+
+  // nullptr after the allocator is destroyed, guarded by ThreadCacheMutex()
+  BuddyAllocator* owner;
+  // allocators may be created at the address of destroyed ones
+  uint64_t allocator_id;
+
+  MemoryBlock* lists[kThreadCacheClassNum];
+  size_t nums[kThreadCacheClassNum];
+  // the minimum of nums since the last drain, i.e. the idle blocks
+  size_t low_nums[kThreadCacheClassNum];
+  size_t op_num = 0;
+
+  std::atomic<size_t> hit_num{0};
+  std::atomic<size_t> miss_num{0};
+  std::atomic<size_t> cached_bytes{0};
+};
+
+// The caches of a thread for all allocators, which return their blocks when
+// the thread exits.
+class ThreadCacheList {
+ public:
+  ~ThreadCacheList() {
+    destroyed_ = true;
+    std::lock_guard<std::mutex> lock(*ThreadCacheMutex());
+    for (auto* cache : caches_) {
+      if (cache->owner != nullptr) {
+        cache->owner->RetireThreadCache(cache);
+      }
+      delete cache;
+    }
+  }
+
+  // nullptr once the thread is exiting, then blocks bypass the caches.
+  static ThreadCacheList* Get() {
+    static thread_local ThreadCacheList list;
+    return destroyed_ ? nullptr : &list;
+  }
+
+  ThreadCache* Find(uint64_t allocator_id) {
+    if (last_ != nullptr && last_->allocator_id == allocator_id) {
+      return last_;
+    }
+    for (auto* cache : caches_) {
+      if (cache->allocator_id == allocator_id) {
+        last_ = cache;
+        return cache;
+      }
+    }
+    return nullptr;
+  }
+
+  // Called with ThreadCacheMutex() held.
+  void Add(ThreadCache* cache) {
+    // drop the caches of the destroyed allocators
+    auto end = std::remove_if(caches_.begin(), caches_.end(),
+                              [](ThreadCache* c) {
+                                if (c->owner == nullptr) {
+                                  delete c;
+                                  return true;
+                                }
+                                return false;
+                              });
+    caches_.erase(end, caches_.end());
+    caches_.push_back(cache);
+    last_ = cache;
+  }
+
+ private:
+  std::vector<ThreadCache*> caches_;
+  ThreadCache* last_ = nullptr;
+  static thread_local bool destroyed_;
+};
+
+thread_local bool ThreadCacheList::destroyed_ = false;
+
 BuddyAllocator::BuddyAllocator(
     std::unique_ptr<SystemAllocator> system_allocator, size_t min_chunk_size,
     size_t max_chunk_size)
     : min_chunk_size_(min_chunk_size),
       max_chunk_size_(max_chunk_size),
       cache_(system_allocator->UseGpu()),
-      system_allocator_(std::move(system_allocator)) {}
+      system_allocator_(std::move(system_allocator)),
+      id_(g_next_allocator_id++) {
+  if (!system_allocator_->UseGpu() && FLAGS_cpu_thread_cache_in_kb > 0) {
+    thread_cache_bytes_ = FLAGS_cpu_thread_cache_in_kb << 10;
+    max_cached_size_ = std::min(
+        min_chunk_size_ * kThreadCacheClassNum,
+        std::min(max_chunk_size_, thread_cache_bytes_) / min_chunk_size_ *
+            min_chunk_size_);
+  }
+}
 
 BuddyAllocator::~BuddyAllocator() {
   VLOG(10) << "BuddyAllocator Disconstructor makes sure that all of these "
               "have actually been freed";
+  {
+    // the blocks cached by the threads are returned to the pool first
+    std::lock_guard<std::mutex> lock(*ThreadCacheMutex());
+    for (auto* cache : thread_caches_) {
+      for (size_t cls = 0; cls < kThreadCacheClassNum; ++cls) {
+        DrainThreadCache(cache, cls, cache->nums[cls]);
+      }
+      cache->owner = nullptr;
+    }
+    thread_caches_.clear();
+  }
   while (!pool_.empty()) {
     auto block = static_cast<MemoryBlock*>(std::get<2>(*pool_.begin()));
     auto desc = cache_.LoadDesc(block);
@@ -59,6 +205,29 @@ void* BuddyAllocator::Alloc(size_t unaligned_size) {
   size_t size =
       align(unaligned_size + sizeof(MemoryBlock::Desc), min_chunk_size_);
 
+  // small blocks are served by the cache of this thread without locking
+  if (size <= max_cached_size_) {
+    ThreadCache* thread_cache = GetThreadCache();
+    if (thread_cache != nullptr) {
+      size_t cls = size / min_chunk_size_ - 1;
+      MemoryBlock* block = nullptr;
+      if (thread_cache->lists[cls] != nullptr) {
+        block = thread_cache->Pop(cls);
+        ThreadCache::Add(&thread_cache->hit_num, 1);
+        ThreadCache::Add(&thread_cache->cached_bytes,
+                         -static_cast<int64_t>(size));
+      } else {
+        ThreadCache::Add(&thread_cache->miss_num, 1);
+      }
+      if (++thread_cache->op_num % kThreadCacheDrainInterval == 0) {
+        DrainIdleBlocks(thread_cache);
+      }
+      if (block != nullptr) {
+        return block->Data();
+      }
+    }
+  }
+
   // acquire the allocator lock
   std::lock_guard<std::mutex> lock(mutex_);
 
@@ -98,9 +267,39 @@ void BuddyAllocator::Free(void* p) {
   // Point back to metadata
   auto block = static_cast<MemoryBlock*>(p)->Metadata();
 
+  if (max_cached_size_ > 0) {
+    // The type and size of an allocated block are not written by others, but
+    // its guards are, when its buddies are split or merged with mutex_ held.
+    // So the desc is read directly instead of through cache_.
+    auto* desc = reinterpret_cast<MemoryBlock::Desc*>(block);
+    size_t size = desc->get_total_size();
+    if (desc->get_type() == MemoryBlock::ARENA_CHUNK &&
+        size <= max_cached_size_ && size % min_chunk_size_ == 0) {
+      ThreadCache* thread_cache = GetThreadCache();
+      if (thread_cache != nullptr) {
+        size_t cls = size / min_chunk_size_ - 1;
+        thread_cache->Push(cls, block);
+        size_t cached_bytes =
+            thread_cache->cached_bytes.load(std::memory_order_relaxed) + size;
+        thread_cache->cached_bytes.store(cached_bytes,
+                                         std::memory_order_relaxed);
+        if (cached_bytes > thread_cache_bytes_) {
+          DrainThreadCache(thread_cache, cls, (thread_cache->nums[cls] + 1) / 2);
+        }
+        if (++thread_cache->op_num % kThreadCacheDrainInterval == 0) {
+          DrainIdleBlocks(thread_cache);
+        }
+        return;
+      }
+    }
+  }
+
   // Acquire the allocator lock
   std::lock_guard<std::mutex> lock(mutex_);
+  FreeToPool(block);
+}
 
+void BuddyAllocator::FreeToPool(MemoryBlock* block) {
   VLOG(10) << "Free from address " << block;
 
   auto* desc = cache_.LoadDesc(block);
@@ -163,10 +362,77 @@ void BuddyAllocator::Free(void* p) {
       IndexSizeAddress(desc->get_index(), desc->get_total_size(), block));
 }
 
-size_t BuddyAllocator::Used() { return total_used_; }
+size_t BuddyAllocator::Used() {
+  if (max_cached_size_ == 0) {
+    return total_used_;
+  }
+  // the blocks cached by the threads are not in use
+  return total_used_ - GetThreadCacheStat().cached_bytes;
+}
 size_t BuddyAllocator::GetMinChunkSize() { return min_chunk_size_; }
 size_t BuddyAllocator::GetMaxChunkSize() { return max_chunk_size_; }
 
+BuddyAllocator::ThreadCacheStat BuddyAllocator::GetThreadCacheStat() {
+  std::lock_guard<std::mutex> lock(*ThreadCacheMutex());
+  ThreadCacheStat stat = retired_stat_;
+  for (auto* cache : thread_caches_) {
+    stat.hit_num += cache->hit_num.load(std::memory_order_relaxed);
+    stat.miss_num += cache->miss_num.load(std::memory_order_relaxed);
+    stat.cached_bytes += cache->cached_bytes.load(std::memory_order_relaxed);
+  }
+  return stat;
+}
+
+ThreadCache* BuddyAllocator::GetThreadCache() {
+  ThreadCacheList* list = ThreadCacheList::Get();
+  if (list == nullptr) {
+    return nullptr;
+  }
+  ThreadCache* cache = list->Find(id_);
+  if (cache == nullptr) {
+    cache = new ThreadCache(this, id_);
+    std::lock_guard<std::mutex> lock(*ThreadCacheMutex());
+    list->Add(cache);
+    thread_caches_.push_back(cache);
+  }
+  return cache;
+}
+
+void BuddyAllocator::DrainThreadCache(ThreadCache* cache, size_t cls,
+                                      size_t num) {
+  if (num == 0) {
+    return;
+  }
+  size_t size = (cls + 1) * min_chunk_size_;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < num; ++i) {
+      FreeToPool(cache->Pop(cls));
+    }
+  }
+  ThreadCache::Add(&cache->cached_bytes, -static_cast<int64_t>(num * size));
+}
+
+void BuddyAllocator::DrainIdleBlocks(ThreadCache* cache) {
+  // Half of the blocks which have not been allocated since the last drain are
+  // returned, so that the cache of a class shrinks geometrically while idle.
+  for (size_t cls = 0; cls < kThreadCacheClassNum; ++cls) {
+    DrainThreadCache(cache, cls, (cache->low_nums[cls] + 1) / 2);
+    cache->low_nums[cls] = cache->nums[cls];
+  }
+}
+
+void BuddyAllocator::RetireThreadCache(ThreadCache* cache) {
+  for (size_t cls = 0; cls < kThreadCacheClassNum; ++cls) {
+    DrainThreadCache(cache, cls, cache->nums[cls]);
+  }
+  retired_stat_.hit_num += cache->hit_num.load(std::memory_order_relaxed);
+  retired_stat_.miss_num += cache->miss_num.load(std::memory_order_relaxed);
+  thread_caches_.erase(
+      std::find(thread_caches_.begin(), thread_caches_.end(), cache));
+  cache->owner = nullptr;
+}
+
 void* BuddyAllocator::SystemAlloc(size_t size) {
   size_t index = 0;
   void* p = system_allocator_->Alloc(&index, size);
@@ -14,6 +14,8 @@ limitations under the License. */
 
 #pragma once
 
+#include <stdint.h>
+
 #include <memory>
 #include <mutex>  // NOLINT
 #include <set>
@@ -30,6 +32,9 @@ namespace paddle {
 namespace memory {
 namespace detail {
 
+struct ThreadCache;
+class ThreadCacheList;
+
 class BuddyAllocator {
  public:
   BuddyAllocator(std::unique_ptr<SystemAllocator> system_allocator,
@@ -44,6 +49,20 @@ class BuddyAllocator {
   size_t GetMinChunkSize();
   size_t GetMaxChunkSize();
 
+  // Counters of the thread caches of small CPU blocks, see
+  // FLAGS_cpu_thread_cache_in_kb.
+  struct ThreadCacheStat {
+    size_t hit_num = 0;   // allocations served by the thread caches
+    size_t miss_num = 0;  // allocations of cached sizes which missed
+    size_t cached_bytes = 0;
+
+    double HitRate() const {
+      size_t num = hit_num + miss_num;
+      return num == 0 ? 0. : static_cast<double>(hit_num) / num;
+    }
+  };
+  ThreadCacheStat GetThreadCacheStat();
+
  public:
   // Disable copy and assignment
   BuddyAllocator(const BuddyAllocator&) = delete;
@@ -75,6 +94,23 @@ class BuddyAllocator {
   /*! \brief Find the existing chunk which used to allocation */
   PoolSet::iterator FindExistChunk(size_t size);
 
+  /*! \brief Return a block to the pool, with mutex_ held */
+  void FreeToPool(MemoryBlock* block);
+
+  /*! \brief The cache of the calling thread, or nullptr after thread exit */
+  ThreadCache* GetThreadCache();
+
+  /*! \brief Return num blocks of class cls of a thread cache to the pool */
+  void DrainThreadCache(ThreadCache* cache, size_t cls, size_t num);
+
+  /*! \brief Return the blocks left idle since the last call to the pool */
+  void DrainIdleBlocks(ThreadCache* cache);
+
+  /*! \brief Return all blocks of an exiting thread and unregister it */
+  void RetireThreadCache(ThreadCache* cache);
+
+  friend class ThreadCacheList;
+
  private:
   size_t total_used_ = 0;  // the total size of used memory
   size_t total_free_ = 0;  // the total size of free memory
@@ -100,6 +136,21 @@ class BuddyAllocator {
   /*! Allocate CPU/GPU memory from system */
   std::unique_ptr<SystemAllocator> system_allocator_;
   std::mutex mutex_;
+
+ private:
+  /**
+   * \brief Per-thread free lists of the blocks of 1 to kThreadCacheClassNum
+   *        min chunks, which serve small allocations without mutex_.
+   *
+   * \note  Only CPU allocators cache blocks, since the desc of a GPU block is
+   *        only reachable through cache_ with mutex_ held.
+   */
+  uint64_t id_;  // identifies the caches of this allocator
+  size_t thread_cache_bytes_ = 0;  // the maximum bytes a thread caches
+  size_t max_cached_size_ = 0;     // 0 if the thread caches are disabled
+  // guarded by ThreadCacheMutex()
+  std::vector<ThreadCache*> thread_caches_;
+  ThreadCacheStat retired_stat_;  // of the caches of the exited threads
 };
 
 }  // namespace detail
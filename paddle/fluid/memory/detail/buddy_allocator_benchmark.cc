@@ -0,0 +1,191 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Multi-threaded benchmark of the CPU BuddyAllocator with and without the
+// thread caches of small blocks, under an operator-like allocation mix. Each
+// simulated operator allocates a few shape and index tensors which it frees
+// before returning, an output tensor which lives for the next
+// --live_outputs operators, and every --large_interval operators a large
+// workspace.
+//
+// Usage:
+//   ./buddy_allocator_benchmark --threads=1,4,16 --ops=200000
+
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/memory/detail/buddy_allocator.h"
+#include "paddle/fluid/memory/detail/system_allocator.h"
+#include "paddle/fluid/platform/cpu_info.h"
+#include "paddle/fluid/string/split.h"
+
+DECLARE_uint64(cpu_thread_cache_in_kb);
+
+DEFINE_string(threads, "1,4,16", "Comma separated thread numbers to be tested.");
+DEFINE_int32(ops, 200000, "Operators run by each thread.");
+DEFINE_int32(temp_per_op, 3,
+             "Shape and index tensors of 8 to 512 bytes allocated and freed by "
+             "each operator.");
+DEFINE_int32(max_output_size, 1 << 16,
+             "The max size (bytes) of the output tensor of an operator.");
+DEFINE_int32(live_outputs, 32,
+             "Number of operators an output tensor outlives, which simulates "
+             "the lifetime of the variables of a program.");
+DEFINE_int32(large_interval, 16,
+             "Every large_interval operators allocate a workspace of 256KB to "
+             "4MB. 0 disables the workspaces.");
+
+namespace paddle {
+namespace memory {
+namespace detail {
+
+struct Op {
+  std::vector<size_t> temp_sizes;
+  size_t output_size;
+  size_t workspace_size;
+};
+
+// The sizes are generated before the timing, which only measures the
+// allocator. Sizes follow log-uniform distributions since most tensors are
+// small.
+static std::vector<Op> GenerateOps(unsigned int seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> temp_dist(3, 9);
+  std::uniform_real_distribution<double> output_dist(
+      8, std::log2(static_cast<double>(FLAGS_max_output_size)));
+  std::uniform_real_distribution<double> workspace_dist(18, 22);
+  std::vector<Op> ops(FLAGS_ops);
+  for (int i = 0; i < FLAGS_ops; ++i) {
+    for (int j = 0; j < FLAGS_temp_per_op; ++j) {
+      ops[i].temp_sizes.push_back(
+          static_cast<size_t>(std::exp2(temp_dist(rng))));
+    }
+    ops[i].output_size = static_cast<size_t>(std::exp2(output_dist(rng)));
+    ops[i].workspace_size =
+        FLAGS_large_interval > 0 && i % FLAGS_large_interval == 0
+            ? static_cast<size_t>(std::exp2(workspace_dist(rng)))
+            : 0;
+  }
+  return ops;
+}
+
+static void RunOps(BuddyAllocator* allocator, const std::vector<Op>& ops) {
+  std::vector<void*> outputs(FLAGS_live_outputs, nullptr);
+  std::vector<void*> temps(FLAGS_temp_per_op);
+  for (size_t i = 0; i < ops.size(); ++i) {
+    auto& op = ops[i];
+    for (size_t j = 0; j < temps.size(); ++j) {
+      temps[j] = allocator->Alloc(op.temp_sizes[j]);
+      *static_cast<char*>(temps[j]) = 0;
+    }
+    void* workspace = nullptr;
+    if (op.workspace_size > 0) {
+      workspace = allocator->Alloc(op.workspace_size);
+      *static_cast<char*>(workspace) = 0;
+    }
+    void*& output = outputs[i % outputs.size()];
+    if (output != nullptr) {
+      allocator->Free(output);
+    }
+    output = allocator->Alloc(op.output_size);
+    *static_cast<char*>(output) = 0;
+    if (workspace != nullptr) {
+      allocator->Free(workspace);
+    }
+    for (void* temp : temps) {
+      allocator->Free(temp);
+    }
+  }
+  for (void* output : outputs) {
+    if (output != nullptr) {
+      allocator->Free(output);
+    }
+  }
+}
+
+static void RunBenchmark(bool thread_cache, int thread_num) {
+  uint64_t cache_in_kb = FLAGS_cpu_thread_cache_in_kb;
+  if (!thread_cache) {
+    FLAGS_cpu_thread_cache_in_kb = 0;
+  }
+  BuddyAllocator allocator(std::unique_ptr<SystemAllocator>(new CPUAllocator),
+                           platform::CpuMinChunkSize(),
+                           platform::CpuMaxChunkSize());
+  FLAGS_cpu_thread_cache_in_kb = cache_in_kb;
+
+  std::vector<std::vector<Op>> ops;
+  for (int i = 0; i < thread_num; ++i) {
+    ops.push_back(GenerateOps(i + 1));
+  }
+  // Warm up, so that the cost of growing chunks is not counted.
+  RunOps(&allocator, ops[0]);
+
+  auto stat = allocator.GetThreadCacheStat();
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < thread_num; ++i) {
+    threads.emplace_back(RunOps, &allocator, std::cref(ops[i]));
+  }
+  for (auto& th : threads) {
+    th.join();
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  auto end_stat = allocator.GetThreadCacheStat();
+  size_t hit_num = end_stat.hit_num - stat.hit_num;
+  size_t miss_num = end_stat.miss_num - stat.miss_num;
+  double allocs = static_cast<double>(thread_num) * FLAGS_ops *
+                  (FLAGS_temp_per_op + 1 +
+                   (FLAGS_large_interval > 0 ? 1. / FLAGS_large_interval : 0));
+  std::cout << (thread_cache ? "on" : "off") << "\t" << thread_num << "\t"
+            << seconds << "\t" << allocs / seconds / 1e6 << "\t"
+            << seconds / allocs * 1e9 << "\t"
+            << (hit_num + miss_num == 0
+                    ? 0.
+                    : static_cast<double>(hit_num) / (hit_num + miss_num))
+            << "\t" << end_stat.cached_bytes / 1024. << std::endl;
+}
+
+}  // namespace detail
+}  // namespace memory
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+
+  std::vector<int> thread_nums;
+  for (auto& s : paddle::string::Split(FLAGS_threads, ',')) {
+    thread_nums.push_back(std::stoi(s));
+  }
+
+  // cached KB is of the warm-up thread, the others have exited
+  std::cout << "thread cache\tthreads\tseconds\tM allocs/s\tns/alloc\t"
+            << "hit rate\tcached KB" << std::endl;
+  for (bool thread_cache : {false, true}) {
+    for (int thread_num : thread_nums) {
+      paddle::memory::detail::RunBenchmark(thread_cache, thread_num);
+    }
+  }
+  return 0;
+}
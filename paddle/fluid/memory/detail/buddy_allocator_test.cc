@@ -14,7 +14,10 @@ limitations under the License. */
 
 #include "paddle/fluid/memory/detail/buddy_allocator.h"
 
+#include <cstring>
 #include <memory>
+#include <thread>  // NOLINT
+#include <vector>
 
 #ifdef WITH_GPERFTOOLS
 #include "gperftools/profiler.h"
@@ -24,6 +27,8 @@ limitations under the License. */
 #include "paddle/fluid/memory/detail/system_allocator.h"
 #include "paddle/fluid/platform/gpu_info.h"
 
+DECLARE_uint64(cpu_thread_cache_in_kb);
+
 #ifdef PADDLE_WITH_CUDA
 #include <cuda_runtime.h>
 
@@ -310,6 +315,90 @@ TEST(BuddyAllocator, SpeedAna) {
 
 #endif
 
+TEST(BuddyAllocator, CpuThreadCache) {
+  FLAGS_cpu_thread_cache_in_kb = 64;
+  BuddyAllocator buddy_allocator(
+      std::unique_ptr<SystemAllocator>(new CPUAllocator),
+      platform::CpuMinChunkSize(), 16 << 20);
+
+  TestBuddyAllocator(&buddy_allocator, 10);
+  TestBuddyAllocator(&buddy_allocator, 10 << 10);
+  // larger than the cached blocks
+  TestBuddyAllocator(&buddy_allocator, 1 << 20);
+
+  // a freed small block is reused from the cache
+  void* p = buddy_allocator.Alloc(100);
+  buddy_allocator.Free(p);
+  auto stat = buddy_allocator.GetThreadCacheStat();
+  EXPECT_GE(stat.cached_bytes, platform::CpuMinChunkSize());
+  EXPECT_EQ(buddy_allocator.Alloc(200), p);
+  EXPECT_EQ(buddy_allocator.GetThreadCacheStat().hit_num, stat.hit_num + 1);
+  buddy_allocator.Free(p);
+
+  // a thread caches at most FLAGS_cpu_thread_cache_in_kb
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 100; ++i) {
+    ptrs.push_back(buddy_allocator.Alloc(100));
+  }
+  for (void* ptr : ptrs) {
+    buddy_allocator.Free(ptr);
+  }
+  EXPECT_LE(buddy_allocator.GetThreadCacheStat().cached_bytes, 64UL << 10);
+  EXPECT_EQ(buddy_allocator.Used(), 0UL);
+}
+
+TEST(BuddyAllocator, CpuThreadCacheMultiThread) {
+  FLAGS_cpu_thread_cache_in_kb = 4096;
+  BuddyAllocator buddy_allocator(
+      std::unique_ptr<SystemAllocator>(new CPUAllocator),
+      platform::CpuMinChunkSize(), 16 << 20);
+
+  // blocks may be freed by other threads than the allocating ones
+  std::vector<std::vector<void*>> ptrs(4);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&, t] {
+      for (int round = 0; round < 100; ++round) {
+        for (int i = 0; i < 100; ++i) {
+          void* p = buddy_allocator.Alloc((i % 16 + 1) << 10);
+          memset(p, t, (i % 16 + 1) << 10);
+          ptrs[t].push_back(p);
+        }
+        for (size_t i = 0; i < ptrs[t].size(); i += 2) {
+          buddy_allocator.Free(ptrs[t][i]);
+        }
+        for (size_t i = 1; i < ptrs[t].size(); i += 2) {
+          buddy_allocator.Free(ptrs[t][i]);
+        }
+        ptrs[t].clear();
+      }
+      for (int i = 0; i < 100; ++i) {
+        ptrs[t].push_back(buddy_allocator.Alloc(1000));
+      }
+    });
+  }
+  for (auto& th : threads) {
+    th.join();
+  }
+  auto stat = buddy_allocator.GetThreadCacheStat();
+  EXPECT_GT(stat.HitRate(), 0.9);
+  // the caches of the exited threads are returned
+  EXPECT_EQ(stat.cached_bytes, 0UL);
+
+  std::thread th([&] {
+    for (auto& thread_ptrs : ptrs) {
+      for (void* p : thread_ptrs) {
+        buddy_allocator.Free(p);
+      }
+    }
+  });
+  th.join();
+  EXPECT_EQ(buddy_allocator.Used(), 0UL);
+
+  // the blocks cached by this thread are returned on destruction
+  buddy_allocator.Free(buddy_allocator.Alloc(1000));
+}
+
 }  // namespace detail
 }  // namespace memory
 }  // namespace paddle
@@ -32,6 +32,7 @@ limitations under the License. */
 #include "paddle/fluid/platform/cpu_info.h"
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/platform/gpu_info.h"
+#include "paddle/fluid/platform/monitor.h"
 #ifdef PADDLE_WITH_CUDA
 #include "paddle/fluid/platform/cuda_device_guard.h"
 #endif
@@ -41,6 +42,8 @@ DECLARE_double(fraction_of_gpu_memory_to_use);
 DECLARE_uint64(initial_gpu_memory_in_mb);
 DECLARE_uint64(reallocate_gpu_memory_in_mb);
 
+USE_INT_STAT(STAT_cpu_mem_reserved);
+
 namespace paddle {
 namespace memory {
 namespace detail {
@@ -86,6 +89,7 @@ void* CPUAllocator::Alloc(size_t* index, size_t size) {
       mlock(p, size);  // lock memory
 #endif
     }
+    STAT_ADD(STAT_cpu_mem_reserved, static_cast<int64_t>(size));
   }
 
   return p;
@@ -104,6 +108,9 @@ void CPUAllocator::Free(void* p, size_t size, size_t index) {
 #else
   free(p);
 #endif
+  if (p != nullptr) {
+    STAT_SUB(STAT_cpu_mem_reserved, static_cast<int64_t>(size));
+  }
 }
 
 bool CPUAllocator::UseGpu() const { return false; }
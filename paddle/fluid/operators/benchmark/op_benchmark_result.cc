@@ -0,0 +1,240 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/benchmark/op_benchmark_result.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <iomanip>
+#include <iterator>
+#include <unordered_map>
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace operators {
+namespace benchmark {
+
+// the nearest-rank percentile of the sorted latencies
+static double Percentile(const std::vector<double>& sorted, double p) {
+  size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+  return sorted[std::max<size_t>(rank, 1) - 1];
+}
+
+void OpBenchmarkResult::SetLatencies(std::vector<double> latencies_ms) {
+  PADDLE_ENFORCE_GT(latencies_ms.size(), 0UL,
+                    platform::errors::InvalidArgument(
+                        "The latencies of %s are empty.", key));
+  std::sort(latencies_ms.begin(), latencies_ms.end());
+  repeat = static_cast<int>(latencies_ms.size());
+  double sum = 0;
+  for (double latency : latencies_ms) {
+    sum += latency;
+  }
+  mean_ms = sum / latencies_ms.size();
+  min_ms = latencies_ms.front();
+  p50_ms = Percentile(latencies_ms, 50);
+  p90_ms = Percentile(latencies_ms, 90);
+  p99_ms = Percentile(latencies_ms, 99);
+  max_ms = latencies_ms.back();
+}
+
+static std::string Quote(const std::string& str) {
+  std::string quoted = "\"";
+  for (char c : str) {
+    if (c == '"' || c == '\\') {
+      quoted += '\\';
+    }
+    quoted += c;
+  }
+  return quoted + "\"";
+}
+
+void WriteJson(const std::vector<OpBenchmarkResult>& results,
+               std::ostream& os) {
+  os << "[\n";
+  for (size_t i = 0; i < results.size(); ++i) {
+    auto& result = results[i];
+    os << std::setprecision(6) << "  {\"key\": " << Quote(result.key)
+       << ", \"op_type\": " << Quote(result.op_type)
+       << ", \"num_threads\": " << result.num_threads
+       << ", \"allocator_strategy\": " << Quote(result.allocator_strategy)
+       << ", \"repeat\": " << result.repeat
+       << ", \"mean_ms\": " << result.mean_ms
+       << ", \"min_ms\": " << result.min_ms
+       << ", \"p50_ms\": " << result.p50_ms
+       << ", \"p90_ms\": " << result.p90_ms
+       << ", \"p99_ms\": " << result.p99_ms
+       << ", \"max_ms\": " << result.max_ms << "}"
+       << (i + 1 < results.size() ? ",\n" : "\n");
+  }
+  os << "]\n";
+}
+
+// Reads the array of the flat objects of strings and numbers written by
+// WriteJson.
+class JsonReader {
+ public:
+  explicit JsonReader(std::istream& is)
+      : text_(std::istreambuf_iterator<char>(is),
+              std::istreambuf_iterator<char>()) {}
+
+  std::vector<OpBenchmarkResult> Read() {
+    std::vector<OpBenchmarkResult> results;
+    Expect('[');
+    if (Peek() == ']') {
+      ++pos_;
+      return results;
+    }
+    while (true) {
+      results.push_back(ReadResult());
+      char c = Next();
+      if (c == ']') {
+        break;
+      }
+      PADDLE_ENFORCE_EQ(c, ',', Error("',' or ']'"));
+    }
+    return results;
+  }
+
+ private:
+  OpBenchmarkResult ReadResult() {
+    std::unordered_map<std::string, std::string> strings;
+    std::unordered_map<std::string, double> numbers;
+    Expect('{');
+    while (true) {
+      std::string key = ReadString();
+      Expect(':');
+      if (Peek() == '"') {
+        strings[key] = ReadString();
+      } else {
+        numbers[key] = ReadNumber();
+      }
+      char c = Next();
+      if (c == '}') {
+        break;
+      }
+      PADDLE_ENFORCE_EQ(c, ',', Error("',' or '}'"));
+    }
+
+    OpBenchmarkResult result;
+    result.key = strings["key"];
+    result.op_type = strings["op_type"];
+    result.allocator_strategy = strings["allocator_strategy"];
+    result.num_threads = static_cast<int>(numbers["num_threads"]);
+    result.repeat = static_cast<int>(numbers["repeat"]);
+    result.mean_ms = numbers["mean_ms"];
+    result.min_ms = numbers["min_ms"];
+    result.p50_ms = numbers["p50_ms"];
+    result.p90_ms = numbers["p90_ms"];
+    result.p99_ms = numbers["p99_ms"];
+    result.max_ms = numbers["max_ms"];
+    return result;
+  }
+
+  std::string ReadString() {
+    Expect('"');
+    std::string str;
+    while (pos_ < text_.size() && text_[pos_] != '"') {
+      if (text_[pos_] == '\\') {
+        ++pos_;
+      }
+      if (pos_ < text_.size()) {
+        str += text_[pos_++];
+      }
+    }
+    Expect('"');
+    return str;
+  }
+
+  double ReadNumber() {
+    SkipSpaces();
+    size_t end = pos_;
+    while (end < text_.size() &&
+           (std::isdigit(text_[end]) || text_[end] == '-' ||
+            text_[end] == '+' || text_[end] == '.' || text_[end] == 'e' ||
+            text_[end] == 'E')) {
+      ++end;
+    }
+    PADDLE_ENFORCE_GT(end, pos_, Error("a number"));
+    double value = std::stod(text_.substr(pos_, end - pos_));
+    pos_ = end;
+    return value;
+  }
+
+  void SkipSpaces() {
+    while (pos_ < text_.size() && std::isspace(text_[pos_])) {
+      ++pos_;
+    }
+  }
+
+  char Peek() {
+    SkipSpaces();
+    PADDLE_ENFORCE_LT(pos_, text_.size(), Error("more characters"));
+    return text_[pos_];
+  }
+
+  char Next() {
+    char c = Peek();
+    ++pos_;
+    return c;
+  }
+
+  void Expect(char expected) {
+    char c = Next();
+    PADDLE_ENFORCE_EQ(c, expected, Error(std::string("'") + expected + "'"));
+  }
+
+  platform::ErrorSummary Error(const std::string& expected) {
+    return platform::errors::InvalidArgument(
+        "Failed to read the benchmark results, expected %s at offset %d.",
+        expected, pos_);
+  }
+
+  std::string text_;
+  size_t pos_ = 0;
+};
+
+std::vector<OpBenchmarkResult> ReadJson(std::istream& is) {
+  return JsonReader(is).Read();
+}
+
+std::vector<OpBenchmarkComparison> Compare(
+    const std::vector<OpBenchmarkResult>& baseline,
+    const std::vector<OpBenchmarkResult>& results, double threshold) {
+  std::unordered_map<std::string, const OpBenchmarkResult*> baseline_map;
+  for (auto& result : baseline) {
+    baseline_map[result.key] = &result;
+  }
+  std::vector<OpBenchmarkComparison> comparisons;
+  for (auto& result : results) {
+    auto it = baseline_map.find(result.key);
+    if (it == baseline_map.end()) {
+      continue;
+    }
+    OpBenchmarkComparison comparison;
+    comparison.key = result.key;
+    comparison.baseline_p50_ms = it->second->p50_ms;
+    comparison.p50_ms = result.p50_ms;
+    comparison.ratio = comparison.baseline_p50_ms > 0
+                           ? comparison.p50_ms / comparison.baseline_p50_ms
+                           : 1.0;
+    comparison.regressed = comparison.ratio > 1.0 + threshold;
+    comparisons.push_back(comparison);
+  }
+  return comparisons;
+}
+
+}  // namespace benchmark
+}  // namespace operators
+}  // namespace paddle
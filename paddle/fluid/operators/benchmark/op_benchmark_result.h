@@ -0,0 +1,78 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace paddle {
+namespace operators {
+namespace benchmark {
+
+/*
+ * The latencies of a config of OpTester, which are written to and read from
+ * a JSON file, so that the runs before and after a change can be compared.
+ */
+struct OpBenchmarkResult {
+  // The op type, the dims of the inputs, the attrs and the number of the
+  // threads, which identify the config across the runs.
+  std::string key;
+  std::string op_type;
+  int num_threads{0};
+  std::string allocator_strategy;
+  int repeat{0};
+  double mean_ms{0.0};
+  double min_ms{0.0};
+  double p50_ms{0.0};
+  double p90_ms{0.0};
+  double p99_ms{0.0};
+  double max_ms{0.0};
+
+  // Set the statistics from the latencies of the runs.
+  void SetLatencies(std::vector<double> latencies_ms);
+};
+
+void WriteJson(const std::vector<OpBenchmarkResult>& results,
+               std::ostream& os);
+
+/*
+ * Read the results written by WriteJson.
+ */
+std::vector<OpBenchmarkResult> ReadJson(std::istream& is);
+
+struct OpBenchmarkComparison {
+  std::string key;
+  double baseline_p50_ms{0.0};
+  double p50_ms{0.0};
+  // p50_ms / baseline_p50_ms
+  double ratio{0.0};
+  bool regressed{false};
+};
+
+/*
+ * Compare the median latencies of the results to those of the baseline of
+ * the same keys. A result is regressed if its median latency is longer than
+ * that of the baseline by more than the threshold, e.g. 0.1 for 10%. The
+ * results not in the baseline are skipped.
+ */
+std::vector<OpBenchmarkComparison> Compare(
+    const std::vector<OpBenchmarkResult>& baseline,
+    const std::vector<OpBenchmarkResult>& results, double threshold);
+
+}  // namespace benchmark
+}  // namespace operators
+}  // namespace paddle
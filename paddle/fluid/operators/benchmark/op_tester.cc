@@ -13,23 +13,42 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include "paddle/fluid/operators/benchmark/op_tester.h"
+#include <algorithm>
+#include <chrono>  // NOLINT
 #include <fstream>
+#include <map>
+#include <set>
 #include "gflags/gflags.h"
 #include "gtest/gtest.h"
 #include "paddle/fluid/framework/op_info.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/variable_helper.h"
+#include "paddle/fluid/platform/cpu_helper.h"
 #include "paddle/fluid/platform/init.h"
 #include "paddle/fluid/platform/profiler.h"
 #include "paddle/fluid/platform/timer.h"
 #include "paddle/fluid/pybind/pybind.h"
 
+DECLARE_string(allocator_strategy);
+DECLARE_int32(paddle_num_threads);
+
 namespace paddle {
 namespace operators {
 namespace benchmark {
 
-DEFINE_string(op_config_list, "", "Path of op config file.");
+DEFINE_string(op_config_list, "",
+              "Paths of op config files, separated by commas.");
 DEFINE_int32(specified_config_id, -1, "Test the specified op config.");
+DEFINE_string(op_json_output, "",
+              "Path of the JSON file the latencies are written to.");
+DEFINE_string(op_baseline, "",
+              "Path of the JSON file of a previous run, which the latencies "
+              "are compared to.");
+DEFINE_double(op_regression_threshold, 0.1,
+              "The ratio by which the median latency of a config may exceed "
+              "that of the baseline before it is reported as a regression.");
+DEFINE_bool(op_fail_on_regression, false,
+            "Fail the test if any config regresses from the baseline.");
 
 void OpTester::Init(const std::string &filename) {
   Init(OpTesterConfig(filename));
@@ -69,10 +88,17 @@ void OpTester::Run() {
     LOG(INFO) << DebugString();
   }
 
+  // Always set the number of threads, so that a config without num_threads
+  // does not run with the one left by the previous config.
+  int num_threads = config_.num_threads.empty() ? FLAGS_paddle_num_threads
+                                                : config_.num_threads[0];
+  platform::SetNumThreads(num_threads);
+
   // Warm up
   RunImpl();
 
-  platform::Timer timer;
+  std::vector<double> latencies;
+  latencies.reserve(config_.repeat);
   if (config_.profile) {
     if (platform::is_cpu_place(place_)) {
       platform::EnableProfiler(platform::ProfilerState::kCPU);
@@ -84,24 +110,51 @@ void OpTester::Run() {
       PADDLE_THROW("'CUDAPlace' is not supported in CPU only device.");
 #endif
     }
-
-    timer.Start();
-    for (int i = config_.repeat; i > 0; --i) {
-      RunImpl();
-    }
-    timer.Pause();
+  }
+  for (int i = config_.repeat; i > 0; --i) {
+    auto start = std::chrono::steady_clock::now();
+    RunImpl();
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    latencies.push_back(elapsed.count());
+  }
+  if (config_.profile) {
     platform::DisableProfiler(platform::EventSortingKey::kDefault,
                               "op_tester_profiler");
-  } else {
-    timer.Start();
-    for (int i = config_.repeat; i > 0; --i) {
-      RunImpl();
+  }
+
+  result_ = OpBenchmarkResult();
+  result_.key = Key();
+  result_.op_type = config_.op_type;
+  result_.num_threads = num_threads;
+  result_.allocator_strategy = FLAGS_allocator_strategy;
+  result_.SetLatencies(latencies);
+  config_.runtime = result_.mean_ms;
+  LOG(INFO) << "=== " << result_.key << ": run " << config_.repeat
+            << " times, latency: " << config_.runtime
+            << " ms, p50: " << result_.p50_ms << " ms, p90: " << result_.p90_ms
+            << " ms, p99: " << result_.p99_ms << " ms ===";
+}
+
+std::string OpTester::Key() const {
+  std::stringstream ss;
+  ss << config_.op_type;
+  for (auto &input : config_.inputs) {
+    ss << " " << input.name << ":";
+    for (size_t i = 0; i < input.dims.size(); ++i) {
+      ss << (i == 0 ? "" : "x") << input.dims[i];
     }
-    timer.Pause();
   }
-  config_.runtime = timer.ElapsedMS() / config_.repeat;
-  LOG(INFO) << "=== Run " << config_.repeat
-            << " times, latency: " << config_.runtime << " ms ===";
+  // sorted, so that the key does not depend on the order of the attrs
+  std::map<std::string, std::string> attrs(config_.attrs.begin(),
+                                           config_.attrs.end());
+  for (auto &attr : attrs) {
+    ss << " " << attr.first << "=" << attr.second;
+  }
+  if (!config_.num_threads.empty()) {
+    ss << " threads=" << config_.num_threads[0];
+  }
+  return ss.str();
 }
 
 void OpTester::RunImpl() {
@@ -116,6 +169,10 @@ std::vector<std::string> OpTester::GetOpProtoInputNames() {
       framework::OpInfoMap::Instance().Get(type_).Proto();
   for (int i = 0; i != proto.inputs_size(); ++i) {
     const auto &input = proto.inputs(i);
+    // The dispensable inputs not provided are left out of the op.
+    if (input.dispensable() && config_.GetInput(input.name()) == nullptr) {
+      continue;
+    }
     input_names.push_back(input.name());
   }
   return input_names;
@@ -216,8 +273,10 @@ void OpTester::CreateOpDesc() {
     const std::string &value_str = item.second;
     const framework::proto::AttrType &type = attr_types[name];
     switch (type) {
-      case framework::proto::AttrType::BOOLEAN:
-        break;
+      case framework::proto::AttrType::BOOLEAN: {
+        bool value = value_str == "true" || value_str == "1";
+        op_desc_.SetAttr(name, {value});
+      } break;
       case framework::proto::AttrType::INT: {
         int value = StringTo<int>(value_str);
         op_desc_.SetAttr(name, {value});
@@ -229,12 +288,16 @@ void OpTester::CreateOpDesc() {
       case framework::proto::AttrType::STRING: {
         op_desc_.SetAttr(name, {value_str});
       } break;
+      case framework::proto::AttrType::INTS: {
+        op_desc_.SetAttr(name, StringToList<int>(value_str));
+      } break;
+      case framework::proto::AttrType::FLOATS: {
+        op_desc_.SetAttr(name, StringToList<float>(value_str));
+      } break;
       case framework::proto::AttrType::BOOLEANS:
-      case framework::proto::AttrType::INTS:
-      case framework::proto::AttrType::FLOATS:
       case framework::proto::AttrType::STRINGS:
-        PADDLE_THROW(
-            platform::errors::Unimplemented("Not supported STRINGS type yet."));
+        PADDLE_THROW(platform::errors::Unimplemented(
+            "Not supported BOOLEANS and STRINGS type yet."));
         break;
       case framework::proto::AttrType::LONG: {
         int64_t value = StringTo<int64_t>(value_str);
@@ -278,21 +341,22 @@ void OpTester::SetupTensor(framework::LoDTensor *tensor,
     cpu_ptr = ptr;
   }
 
+  int64_t numel = framework::product(framework::make_ddim(shape));
   if (initializer == "random") {
-    for (int i = 0; i < cpu_tensor.numel(); ++i) {
+    for (int64_t i = 0; i < numel; ++i) {
       cpu_ptr[i] = static_cast<T>(uniform_dist(rng) * (upper - lower) + lower);
     }
   } else if (initializer == "natural") {
-    for (int i = 0; i < cpu_tensor.numel(); ++i) {
+    for (int64_t i = 0; i < numel; ++i) {
       cpu_ptr[i] = static_cast<T>(lower + i);
     }
   } else if (initializer == "zeros") {
-    for (int i = 0; i < cpu_tensor.numel(); ++i) {
+    for (int64_t i = 0; i < numel; ++i) {
       cpu_ptr[i] = static_cast<T>(0);
     }
   } else if (initializer == "file") {
     std::ifstream is(filename);
-    for (int i = 0; i < cpu_tensor.numel(); ++i) {
+    for (int64_t i = 0; i < numel; ++i) {
       T value;
       is >> value;
       cpu_ptr[i] = static_cast<T>(value);
@@ -336,19 +400,22 @@ void OpTester::CreateVariables(framework::Scope *scope) {
     auto *var = scope->Var(var_name);
     auto *tensor = var->GetMutable<framework::LoDTensor>();
     const auto &data_type = var_desc->GetDataType();
+    const double lower = item.second.lower;
+    const double upper = item.second.upper;
     if (data_type == framework::proto::VarType::INT32) {
-      SetupTensor<int>(tensor, shape, 0, 1, item.second.initializer,
+      SetupTensor<int>(tensor, shape, static_cast<int>(lower),
+                       static_cast<int>(upper), item.second.initializer,
                        item.second.filename);
     } else if (data_type == framework::proto::VarType::INT64) {
-      SetupTensor<int64_t>(tensor, shape, 0, 1, item.second.initializer,
-                           item.second.filename);
+      SetupTensor<int64_t>(tensor, shape, static_cast<int64_t>(lower),
+                           static_cast<int64_t>(upper),
+                           item.second.initializer, item.second.filename);
     } else if (data_type == framework::proto::VarType::FP32) {
-      SetupTensor<float>(tensor, shape, static_cast<float>(0.0),
-                         static_cast<float>(1.0), item.second.initializer,
+      SetupTensor<float>(tensor, shape, static_cast<float>(lower),
+                         static_cast<float>(upper), item.second.initializer,
                          item.second.filename);
     } else if (data_type == framework::proto::VarType::FP64) {
-      SetupTensor<double>(tensor, shape, static_cast<double>(0.0),
-                          static_cast<double>(1.0), item.second.initializer,
+      SetupTensor<double>(tensor, shape, lower, upper, item.second.initializer,
                           item.second.filename);
     } else {
       PADDLE_THROW("Unsupported dtype %d.", data_type);
@@ -481,32 +548,77 @@ std::string OpTester::DebugString() {
   return ss.str();
 }
 
+static void ReadConfigs(const std::string &filename,
+                        std::vector<OpTesterConfig> *op_configs) {
+  std::ifstream fin(filename, std::ios::in | std::ios::binary);
+  PADDLE_ENFORCE(static_cast<bool>(fin), "Cannot open file %s",
+                 filename.c_str());
+  while (!fin.eof()) {
+    VLOG(4) << "Reading config " << op_configs->size() << "...";
+    OpTesterConfig config;
+    bool result = config.Init(fin);
+    if (result) {
+      for (auto &expanded : config.Expand()) {
+        op_configs->push_back(expanded);
+      }
+    }
+  }
+}
+
+static void CompareToBaseline(const std::vector<OpBenchmarkResult> &results) {
+  std::ifstream fin(FLAGS_op_baseline);
+  PADDLE_ENFORCE_EQ(static_cast<bool>(fin), true,
+                    platform::errors::NotFound("Cannot open file %s.",
+                                               FLAGS_op_baseline));
+  auto comparisons =
+      Compare(ReadJson(fin), results, FLAGS_op_regression_threshold);
+  int num_regressed = 0;
+  for (auto &comparison : comparisons) {
+    LOG(INFO) << (comparison.regressed ? "[REGRESSED] " : "")
+              << comparison.key << ": " << comparison.baseline_p50_ms
+              << " ms -> " << comparison.p50_ms << " ms ("
+              << comparison.ratio << "x)";
+    num_regressed += comparison.regressed ? 1 : 0;
+  }
+  LOG(INFO) << "=== " << num_regressed << " of " << comparisons.size()
+            << " configs in the baseline regressed by more than "
+            << FLAGS_op_regression_threshold * 100 << "% ===";
+  if (FLAGS_op_fail_on_regression) {
+    EXPECT_EQ(num_regressed, 0);
+  }
+}
+
 TEST(op_tester, base) {
   if (!FLAGS_op_config_list.empty()) {
-    std::ifstream fin(FLAGS_op_config_list, std::ios::in | std::ios::binary);
-    PADDLE_ENFORCE(static_cast<bool>(fin), "Cannot open file %s",
-                   FLAGS_op_config_list.c_str());
     std::vector<OpTesterConfig> op_configs;
-    while (!fin.eof()) {
-      VLOG(4) << "Reading config " << op_configs.size() << "...";
-      OpTesterConfig config;
-      bool result = config.Init(fin);
-      if (result) {
-        op_configs.push_back(config);
-      }
+    for (auto &filename : StringToList<std::string>(FLAGS_op_config_list)) {
+      ReadConfigs(filename, &op_configs);
     }
+    std::vector<OpBenchmarkResult> results;
     if (FLAGS_specified_config_id >= 0 &&
         FLAGS_specified_config_id < static_cast<int>(op_configs.size())) {
       OpTester tester;
       tester.Init(op_configs[FLAGS_specified_config_id]);
       tester.Run();
+      results.push_back(tester.result());
     } else {
       for (size_t i = 0; i < op_configs.size(); ++i) {
         OpTester tester;
         tester.Init(op_configs[i]);
         tester.Run();
+        results.push_back(tester.result());
       }
     }
+    if (!FLAGS_op_json_output.empty()) {
+      std::ofstream fout(FLAGS_op_json_output);
+      PADDLE_ENFORCE_EQ(static_cast<bool>(fout), true,
+                        platform::errors::Unavailable(
+                            "Cannot open file %s.", FLAGS_op_json_output));
+      WriteJson(results, fout);
+    }
+    if (!FLAGS_op_baseline.empty()) {
+      CompareToBaseline(results);
+    }
   } else {
     OpTester tester;
     OpTesterConfig config;
@@ -521,6 +633,90 @@ TEST(op_tester, base) {
   }
 }
 
+TEST(op_tester, expand_grid) {
+  std::istringstream is(
+      "{\n"
+      "  op_type: mul\n"
+      "  input {\n"
+      "    name: X\n"
+      "    dims: Bx512\n"
+      "  }\n"
+      "  input {\n"
+      "    name: Y\n"
+      "    dims: 512xN\n"
+      "  }\n"
+      "  attrs {\n"
+      "    x_num_col_dims: 1;\n"
+      "  }\n"
+      "  grid {\n"
+      "    B: 1,16,64;\n"
+      "    N: 128,256;\n"
+      "  }\n"
+      "  num_threads: 1,4\n"
+      "  repeat: 10\n"
+      "}\n");
+  OpTesterConfig config;
+  ASSERT_TRUE(config.Init(is));
+  auto configs = config.Expand();
+  ASSERT_EQ(configs.size(), 3UL * 2UL * 2UL);
+  std::set<std::string> keys;
+  for (auto &expanded : configs) {
+    ASSERT_EQ(expanded.inputs[0].dims.size(), 2UL);
+    EXPECT_EQ(expanded.inputs[0].dims[1], 512);
+    EXPECT_EQ(expanded.inputs[1].dims[0], 512);
+    EXPECT_EQ(expanded.num_threads.size(), 1UL);
+    EXPECT_EQ(expanded.repeat, 10);
+
+    OpTester tester;
+    tester.Init(expanded);
+    keys.insert(tester.Key());
+  }
+  // every point of the grid is a config of its own
+  EXPECT_EQ(keys.size(), configs.size());
+  EXPECT_EQ(configs[0].inputs[0].dims[0], 1);
+  EXPECT_EQ(configs[0].inputs[1].dims[1], 128);
+  EXPECT_EQ(configs[0].num_threads[0], 1);
+  EXPECT_EQ(configs.back().inputs[0].dims[0], 64);
+  EXPECT_EQ(configs.back().inputs[1].dims[1], 256);
+  EXPECT_EQ(configs.back().num_threads[0], 4);
+}
+
+TEST(op_tester, compare_to_baseline) {
+  OpBenchmarkResult result;
+  result.key = "mul X:16x512 Y:512x128 threads=1";
+  result.op_type = "mul";
+  result.num_threads = 1;
+  result.allocator_strategy = "naive_best_fit";
+  std::vector<double> latencies;
+  for (int i = 1; i <= 100; ++i) {
+    latencies.push_back(i * 0.01);
+  }
+  result.SetLatencies(latencies);
+  EXPECT_NEAR(result.p50_ms, 0.5, 1e-9);
+  EXPECT_NEAR(result.p90_ms, 0.9, 1e-9);
+  EXPECT_NEAR(result.p99_ms, 0.99, 1e-9);
+  EXPECT_NEAR(result.max_ms, 1.0, 1e-9);
+
+  std::stringstream ss;
+  WriteJson({result}, ss);
+  auto baseline = ReadJson(ss);
+  ASSERT_EQ(baseline.size(), 1UL);
+  EXPECT_EQ(baseline[0].key, result.key);
+  EXPECT_EQ(baseline[0].allocator_strategy, result.allocator_strategy);
+  EXPECT_EQ(baseline[0].repeat, 100);
+  EXPECT_NEAR(baseline[0].p99_ms, result.p99_ms, 1e-6);
+
+  OpBenchmarkResult slower = result;
+  slower.p50_ms = 0.6;
+  OpBenchmarkResult other = result;
+  other.key = "mul X:64x512 Y:512x128 threads=1";
+  auto comparisons = Compare(baseline, {result, slower, other}, 0.1);
+  ASSERT_EQ(comparisons.size(), 2UL);
+  EXPECT_FALSE(comparisons[0].regressed);
+  EXPECT_TRUE(comparisons[1].regressed);
+  EXPECT_NEAR(comparisons[1].ratio, 1.2, 1e-6);
+}
+
 }  // namespace benchmark
 }  // namespace operators
 }  // namespace paddle
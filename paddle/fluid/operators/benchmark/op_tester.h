@@ -21,6 +21,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/ddim.h"
 #include "paddle/fluid/framework/op_desc.h"
 #include "paddle/fluid/framework/operator.h"
+#include "paddle/fluid/operators/benchmark/op_benchmark_result.h"
 #include "paddle/fluid/operators/benchmark/op_tester_config.h"
 
 namespace paddle {
@@ -38,6 +39,13 @@ class OpTester {
 
   std::string DebugString();
 
+  // The op type, the dims of the inputs, the attrs and the number of the
+  // threads, which identify the config in the results.
+  std::string Key() const;
+
+  // The latencies of the runs of the last Run.
+  const OpBenchmarkResult &result() const { return result_; }
+
  private:
   std::vector<std::string> GetOpProtoInputNames();
   std::vector<std::string> GetOpProtoOutputNames();
@@ -68,6 +76,7 @@ class OpTester {
   std::unique_ptr<framework::OperatorBase> op_;
   platform::Place place_;
   std::unique_ptr<framework::Scope> scope_;
+  OpBenchmarkResult result_;
 };
 
 }  // namespace benchmark
@@ -39,6 +39,30 @@ static void EraseEndSep(std::string* str,
   }
 }
 
+static std::vector<std::string> Split(const std::string& str, char sep) {
+  std::vector<std::string> tokens;
+  std::string token;
+  std::istringstream token_stream(str);
+  while (std::getline(token_stream, token, sep)) {
+    if (!token.empty()) {
+      tokens.push_back(token);
+    }
+  }
+  return tokens;
+}
+
+static bool IsNumber(const std::string& str) {
+  if (str.empty()) {
+    return false;
+  }
+  for (char c : str) {
+    if (c < '0' || c > '9') {
+      return false;
+    }
+  }
+  return true;
+}
+
 OpInputConfig::OpInputConfig(std::istream& is) {
   std::string sep;
   is >> sep;
@@ -59,6 +83,8 @@ OpInputConfig::OpInputConfig(std::istream& is) {
       } else if (sep == "filename") {
         is >> filename;
         EraseEndSep(&filename);
+      } else if (sep == "range" || sep == "range:") {
+        ParseRange(is);
       }
     }
   }
@@ -101,15 +127,37 @@ void OpInputConfig::ParseInitializer(std::istream& is) {
 void OpInputConfig::ParseDims(std::istream& is) {
   std::string dims_str;
   is >> dims_str;
+  EraseEndSep(&dims_str);
 
   dims.clear();
-  std::string token;
-  std::istringstream token_stream(dims_str);
-  while (std::getline(token_stream, token, 'x')) {
-    dims.push_back(std::stoi(token));
+  dims_expr = Split(dims_str, 'x');
+  bool all_numbers = true;
+  for (auto& token : dims_expr) {
+    all_numbers = all_numbers && IsNumber(token);
+  }
+  if (all_numbers) {
+    for (auto& token : dims_expr) {
+      dims.push_back(std::stoi(token));
+    }
+    dims_expr.clear();
   }
 }
 
+void OpInputConfig::ParseRange(std::istream& is) {
+  std::string range_str;
+  is >> range_str;
+  EraseEndSep(&range_str);
+
+  std::vector<std::string> bounds = Split(range_str, ',');
+  PADDLE_ENFORCE_EQ(bounds.size(), 2UL,
+                    platform::errors::InvalidArgument(
+                        "The range of input %s should be lower,upper, but "
+                        "got %s.",
+                        name, range_str));
+  lower = StringTo<double>(bounds[0]);
+  upper = StringTo<double>(bounds[1]);
+}
+
 void OpInputConfig::ParseLoD(std::istream& is) {
   std::string lod_str;
   std::string start_sep =
@@ -180,6 +228,16 @@ bool OpTesterConfig::Init(std::istream& is) {
         inputs.push_back(input_config);
       } else if (sep == "attrs" || sep == "attrs:") {
         ParseAttrs(is);
+      } else if (sep == "grid" || sep == "grid:") {
+        ParseGrid(is);
+      } else if (sep == "num_threads" || sep == "num_threads:") {
+        std::string num_threads_str;
+        is >> num_threads_str;
+        EraseEndSep(&num_threads_str);
+        num_threads.clear();
+        for (auto& token : Split(num_threads_str, ',')) {
+          num_threads.push_back(StringTo<int>(token));
+        }
       } else {
         if (sep != kEndSeparator) {
           return false;
@@ -215,6 +273,95 @@ bool OpTesterConfig::ParseAttrs(std::istream& is) {
   return true;
 }
 
+bool OpTesterConfig::ParseGrid(std::istream& is) {
+  std::string sep;
+  is >> sep;
+  if (sep == kStartSeparator) {
+    while (true) {
+      std::string key;
+      is >> key;
+      if (key == kEndSeparator) {
+        break;
+      }
+
+      std::string values_str;
+      is >> values_str;
+      EraseEndSep(&key, ":");
+      EraseEndSep(&values_str);
+      std::vector<int64_t> values;
+      for (auto& token : Split(values_str, ',')) {
+        values.push_back(StringTo<int64_t>(token));
+      }
+      PADDLE_ENFORCE_GT(values.size(), 0UL,
+                        platform::errors::InvalidArgument(
+                            "The grid %s of op %s has no values.", key,
+                            op_type));
+      VLOG(4) << "grid: " << key << ", " << values_str;
+      grid.emplace_back(key, values);
+    }
+  }
+  return true;
+}
+
+std::vector<OpTesterConfig> OpTesterConfig::Expand() const {
+  // the points of the grid, as the values of the names
+  std::vector<std::unordered_map<std::string, int64_t>> points(1);
+  for (auto& axis : grid) {
+    std::vector<std::unordered_map<std::string, int64_t>> expanded;
+    for (auto& point : points) {
+      for (auto value : axis.second) {
+        expanded.push_back(point);
+        expanded.back()[axis.first] = value;
+      }
+    }
+    points.swap(expanded);
+  }
+  std::vector<int> threads = num_threads;
+  if (threads.empty()) {
+    threads.push_back(0);
+  }
+
+  std::vector<OpTesterConfig> configs;
+  for (auto& point : points) {
+    OpTesterConfig config = *this;
+    config.grid.clear();
+    for (auto& input : config.inputs) {
+      if (input.dims_expr.empty()) {
+        continue;
+      }
+      input.dims.clear();
+      for (auto& token : input.dims_expr) {
+        if (IsNumber(token)) {
+          input.dims.push_back(std::stoi(token));
+        } else {
+          auto it = point.find(token);
+          PADDLE_ENFORCE_NE(
+              it, point.end(),
+              platform::errors::NotFound(
+                  "The dim %s of input %s of op %s is not in the grid.",
+                  token, input.name, op_type));
+          input.dims.push_back(it->second);
+        }
+      }
+      input.dims_expr.clear();
+    }
+    for (auto& attr : config.attrs) {
+      auto it = point.find(attr.second);
+      if (it != point.end()) {
+        attr.second = std::to_string(it->second);
+      }
+    }
+    for (int n : threads) {
+      configs.push_back(config);
+      configs.back().num_threads.clear();
+      if (n > 0) {
+        configs.back().num_threads.push_back(n);
+      }
+    }
+  }
+  return configs;
+}
+
 const OpInputConfig* OpTesterConfig::GetInput(const std::string& name) {
   for (size_t i = 0; i < inputs.size(); ++i) {
     if (inputs[i].name == name) {
@@ -18,6 +18,7 @@ limitations under the License. */
 #include <sstream>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace paddle {
@@ -32,13 +33,21 @@ struct OpInputConfig {
   void ParseInitializer(std::istream& is);
   void ParseDims(std::istream& is);
   void ParseLoD(std::istream& is);
+  void ParseRange(std::istream& is);
 
   std::string name;
   std::string dtype{"fp32"};  // int32/int, int64/long, fp32/float, fp64/double
   std::string initializer{"random"};  // random, natural, zeros, file
   std::string filename{""};
   std::vector<int64_t> dims;
+  // The dims as they are written, which may name the dims of the grid in
+  // place of the numbers, e.g. Bx512. Empty if they are all numbers.
+  std::vector<std::string> dims_expr;
   std::vector<std::vector<size_t>> lod;
+  // The range of the random values, e.g. of the ids of lookup_table, which
+  // is [0, 1) by default.
+  double lower{0.0};
+  double upper{1.0};
 };
 
 struct OpTesterConfig {
@@ -48,9 +57,17 @@ struct OpTesterConfig {
   bool Init(std::istream& is);
 
   bool ParseAttrs(std::istream& is);
+  bool ParseGrid(std::istream& is);
 
   const OpInputConfig* GetInput(const std::string& name);
 
+  /*
+   * Expand the config to one config for each point of the grid and each
+   * number of threads, in which the names of the grid in the dims and the
+   * attrs are replaced by the values of the point.
+   */
+  std::vector<OpTesterConfig> Expand() const;
+
   std::string op_type;
   std::vector<OpInputConfig> inputs;
   std::unordered_map<std::string, std::string> attrs;
@@ -59,6 +76,13 @@ struct OpTesterConfig {
   int profile{0};
   int print_debug_string{0};
   double runtime{0.0};
+  // The named dims swept by the config, e.g. grid { B: 1,16,64; }, whose
+  // names are upper case so that they are told apart from the 'x' between
+  // the dims.
+  std::vector<std::pair<std::string, std::vector<int64_t>>> grid;
+  // The numbers of the threads of the math library swept by the config,
+  // e.g. num_threads: 1,4. Empty to use FLAGS_paddle_num_threads.
+  std::vector<int> num_threads;
 };
 
 static bool Has(const std::vector<std::string>& vec, const std::string& item) {
@@ -78,6 +102,20 @@ T StringTo(const std::string& str) {
   return value;
 }
 
+// Parse the values separated by commas, e.g. 1,2,3.
+template <typename T>
+std::vector<T> StringToList(const std::string& str) {
+  std::vector<T> values;
+  std::string token;
+  std::istringstream token_stream(str);
+  while (std::getline(token_stream, token, ',')) {
+    if (!token.empty()) {
+      values.push_back(StringTo<T>(token));
+    }
+  }
+  return values;
+}
+
 }  // namespace benchmark
 }  // namespace operators
 }  // namespace paddle
@@ -74,9 +74,10 @@ VarHandlePtr BRPCClient::AsyncSendVar(const std::string& ep,
 
     auto* var = p_scope->FindVar(var_name_val);
     sendrecv::VariableMessage request;
+    auto compressor = WireCompression::Instance().SendCompressor(var_name_val);
     distributed::SerializeToIOBuf(var_name_val, var, *p_ctx, &request,
                                   &cntl->request_attachment(), "", false,
-                                  trainer_id_);
+                                  trainer_id_, "", compressor.get());
 
     google::protobuf::Closure* done = brpc::NewCallback(
         &HandleSendResponse, cntl, response, var_h, ch_ptr, ch_ctx, this);
@@ -183,6 +184,8 @@ VarHandlePtr BRPCClient::_AsyncGetVar(const std::string& ep,
     req.set_varname(var_name_val);
     req.set_out_varname(out_varname_val);
     req.set_trainer_id(trainer_id_);
+    req.set_compression(
+        WireCompression::Instance().RecvCompression(out_varname_val));
 
     google::protobuf::Closure* done = brpc::NewCallback(
         &HandleGetResponse, cntl, response, var_h, ch_ptr, ch_ctx, this);
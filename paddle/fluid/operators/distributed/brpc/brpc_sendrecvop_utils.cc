@@ -18,7 +18,10 @@ limitations under the License. */
 #include <sys/time.h>
 #include <limits>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <thread>  // NOLINT
+#include <unordered_map>
+#include <utility>
 
 #include "paddle/fluid/framework/data_type.h"
 #include "paddle/fluid/operators/distributed/brpc/brpc_rdma_pool.h"
@@ -31,6 +34,41 @@ namespace paddle {
 namespace operators {
 namespace distributed {
 
+// The payloads appended to IOBufs without copy, by their data.
+class ZeroCopyPayloads {
+ public:
+  static void Add(const char* data, void (*destroy)(void*), void* user_data) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    payloads_.emplace(data, std::make_pair(destroy, user_data));
+  }
+
+  // A payload sent several times at once is added several times by the same
+  // data, and any of them is released, since they hold the same memory.
+  static void Release(void* data) {
+    std::pair<void (*)(void*), void*> payload;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = payloads_.find(static_cast<const char*>(data));
+      PADDLE_ENFORCE_EQ(it != payloads_.end(), true,
+                        platform::errors::NotFound(
+                            "The payload appended to IOBuf is not found."));
+      payload = it->second;
+      payloads_.erase(it);
+    }
+    payload.first(payload.second);
+  }
+
+ private:
+  static std::mutex mutex_;
+  static std::unordered_multimap<const char*,
+                                 std::pair<void (*)(void*), void*>>
+      payloads_;
+};
+
+std::mutex ZeroCopyPayloads::mutex_;
+std::unordered_multimap<const char*, std::pair<void (*)(void*), void*>>
+    ZeroCopyPayloads::payloads_;
+
 class IOBufWriter {
  public:
   static void Append(const std::string& varname, butil::IOBuf* iobuf, int k,
@@ -57,16 +95,19 @@ class IOBufWriter {
     iobuf->append(reinterpret_cast<char*>(&k), 4);
     iobuf->append(reinterpret_cast<char*>(&vlen), 8);
 
-    // FIXME(gongwb): use append_zerocopy
-    /*
-    if (in_cuda_pinned) {
-      iobuf->append_zerocopy(v, vlen, IOBufWriter::FreeMemory);
-    } else {
-      iobuf->append_zerocopy(v, vlen, nullptr);
+    if (vlen == 0) {
+      destroy(user_data);
+      return;
+    }
+    // the payload is released once the IOBuf is sent, and IOBuf gives only
+    // the data to the deleter, so the payload is found by its data
+    ZeroCopyPayloads::Add(v, destroy, user_data);
+    if (iobuf->append_user_data(static_cast<void*>(const_cast<char*>(v)), vlen,
+                                ZeroCopyPayloads::Release) != 0) {
+      ZeroCopyPayloads::Release(static_cast<void*>(const_cast<char*>(v)));
+      PADDLE_THROW(platform::errors::Unavailable(
+          "Failed to append the payload of %d bytes to IOBuf.", vlen));
     }
-    */
-    iobuf->append(v, vlen);
-    destroy(user_data);
   }
 
 #ifdef PADDLE_WITH_BRPC_RDMA
@@ -116,7 +157,8 @@ void SerializeToIOBuf(const std::string& name, framework::Variable* var,
                       const platform::DeviceContext& ctx, VarMsg* request,
                       butil::IOBuf* iobuf, const std::string& out_varname,
                       bool var_is_not_stable, int trainer_id,
-                      const std::string& table_name) {
+                      const std::string& table_name,
+                      WireCompressor* compressor) {
   std::unique_ptr<TensorPayload> payload;
 
   request->set_varname(name);
@@ -161,8 +203,25 @@ void SerializeToIOBuf(const std::string& name, framework::Variable* var,
 
   PADDLE_ENFORCE_NOT_NULL(payload);
 
-  // FIXME(gongwb): it seems that can use zero copy.
-  if (var_is_not_stable) {
+  if (compressor != nullptr && request->data_type() == VarMsg::FP32) {
+    int64_t num_rows = 0;
+    int64_t width = 0;
+    WireCompressionRows(framework::make_ddim(std::vector<int64_t>(
+                            request->dims().begin(), request->dims().end())),
+                        &num_rows, &width);
+    const int64_t* ids = nullptr;
+    if (var->IsType<framework::SelectedRows>()) {
+      ids = var->Get<framework::SelectedRows>().rows().data();
+    }
+    std::string compressed;
+    compressor->Compress(static_cast<const float*>(payload->ptr()), num_rows,
+                         width, ids, &compressed);
+    request->set_compression(compressor->type());
+    IOBufWriter::Append(name, iobuf,
+                        ::sendrecv::VariableMessage::kSerializedFieldNumber,
+                        compressed.data(), compressed.size());
+  } else if (var_is_not_stable) {
+    // FIXME(gongwb): it seems that can use zero copy.
     IOBufWriter::Append(
         name, iobuf, ::sendrecv::VariableMessage::kSerializedFieldNumber,
         static_cast<const char*>(payload->ptr()), payload->memory_size());
@@ -28,6 +28,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/var_type.h"
 #include "paddle/fluid/operators/distributed/distributed_pb.h"
 #include "paddle/fluid/operators/distributed/sendrecvop_utils.h"
+#include "paddle/fluid/operators/distributed/wire_compression.h"
 
 namespace paddle {
 namespace operators {
@@ -37,7 +38,8 @@ void SerializeToIOBuf(const std::string& name, framework::Variable* var,
                       const platform::DeviceContext& ctx, VarMsg* request,
                       butil::IOBuf* iobuf, const std::string& out_varname,
                       bool var_is_not_stable, const int trainer_id = 0,
-                      const std::string& table_name = std::string());
+                      const std::string& table_name = std::string(),
+                      WireCompressor* compressor = nullptr);
 
 void DeserializeFromIOBuf(const VarMsg& meta, const butil::IOBuf& iobuf,
                           const platform::DeviceContext& ctx,
@@ -154,9 +154,11 @@ class BRPCServiceImpl : public SendRecvService {
                            out_varname);
 
     if (outvar) {
-      distributed::SerializeToIOBuf(out_varname, outvar,
-                                    *request_get_h_->dev_ctx(), response,
-                                    &cntl->response_attachment(), "", false);
+      auto compressor =
+          distributed::CreateReplyCompressor(request->compression());
+      distributed::SerializeToIOBuf(
+          out_varname, outvar, *request_get_h_->dev_ctx(), response,
+          &cntl->response_attachment(), "", false, 0, "", compressor.get());
     }
   }
 
@@ -186,9 +188,11 @@ class BRPCServiceImpl : public SendRecvService {
                                     out_varname);
 
     if (outvar) {
+      auto compressor =
+          distributed::CreateReplyCompressor(request->compression());
       distributed::SerializeToIOBuf(
           out_varname, outvar, *request_getnobarrier_h_->dev_ctx(), response,
-          &cntl->response_attachment(), "", false);
+          &cntl->response_attachment(), "", false, 0, "", compressor.get());
     }
   }
 
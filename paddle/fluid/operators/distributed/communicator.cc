@@ -74,9 +74,14 @@ void AsyncCommunicator::InitImpl(const RpcCtxMap &send_varname_to_ctx,
   } else {
     send_scope_.reset(new Scope());
     for (auto &iter : send_varname_to_ctx_) {
-      send_varname_to_queue_[iter.first] =
-          std::make_shared<BlockingQueue<std::shared_ptr<Variable>>>(
-              send_queue_size_);
+      auto accumulator = std::make_shared<SendVarAccumulator>(
+          iter.second.merge_add, max_merge_var_num_);
+      send_varname_to_accumulator_[iter.first] = accumulator;
+      AddSendQueueGauge([accumulator] { return accumulator->Count(); });
+      for (auto &name : iter.second.splited_var_names) {
+        WireCompression::Instance().SetSendVar(name, send_compression_,
+                                               error_feedback_);
+      }
     }
     send_threadpool_.reset(new ::ThreadPool(thread_pool_size_));
   }
@@ -85,6 +90,11 @@ void AsyncCommunicator::InitImpl(const RpcCtxMap &send_varname_to_ctx,
     VLOG(0) << "nothing need to be received, will not start recv_thread";
   } else {
     recv_threadpool_.reset(new ::ThreadPool(thread_pool_size_));
+    for (auto &iter : recv_varname_to_ctx_) {
+      for (auto &name : iter.second.splited_var_names) {
+        WireCompression::Instance().SetRecvVar(name, recv_compression_);
+      }
+    }
   }
 }
 
@@ -152,46 +162,42 @@ void AsyncCommunicator::SendThread() {
     task_futures.reserve(send_varname_to_ctx_.size());
     VLOG(4) << "run send graph";
     auto before_run_send_graph = GetCurrentUS();
-    for (auto &iter : send_varname_to_queue_) {
+    for (auto &iter : send_varname_to_accumulator_) {
       auto &var_name = iter.first;
-      auto &var_queue = iter.second;
-      if (var_queue->Size() > 0) {
-        auto send_task = [this, &var_name, &var_queue] {
+      auto &accumulator = iter.second;
+      if (accumulator->Count() > 0) {
+        auto send_task = [this, &var_name, &accumulator] {
           VLOG(4) << var_name << " merge and send";
-          std::vector<std::shared_ptr<Variable>> vars;
-          int merged_var_num = 0;
+          int64_t merged_var_num = accumulator->Count();
           int wait_times = 0;
           while (merged_var_num < max_merge_var_num_) {
-            if (var_queue->Size() == 0) {
-              VLOG(4) << "wait_times -> " << wait_times;
-              if (wait_times >= send_wait_times_) {
-                break;
-              }
-              std::this_thread::sleep_for(std::chrono::milliseconds(10));
-              wait_times++;
-              continue;
-            } else {
+            VLOG(4) << "wait_times -> " << wait_times;
+            if (wait_times >= send_wait_times_) {
+              break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            int64_t var_num = accumulator->Count();
+            if (var_num > merged_var_num) {
               wait_times = 0;
-
-              vars.push_back(var_queue->Pop());
-              // only count the send number of the first var
-              if (var_name == send_varname_to_queue_.begin()->first) {
-                grad_num_.fetch_add(1, std::memory_order_relaxed);
-              }
-              merged_var_num++;
+              merged_var_num = var_num;
+            } else {
+              wait_times++;
             }
           }
           auto before_merge = GetCurrentUS();
           auto &ctx = send_varname_to_ctx_.at(var_name);
-          if (ctx.use_send_handler) {
-            MergeVars<float>(var_name, vars, send_scope_.get(), ctx.merge_add);
-          } else {
-            MergeVars<int64_t>(var_name, vars, send_scope_.get(),
-                               ctx.merge_add);
+          merged_var_num = accumulator->Swap(send_scope_->Var(var_name));
+          // only count the send number of the first var
+          if (var_name == send_varname_to_accumulator_.begin()->first) {
+            grad_num_.fetch_add(merged_var_num, std::memory_order_relaxed);
           }
           auto after_merge = GetCurrentUS();
           VLOG(4) << "merge " << merged_var_num << " " << var_name
                   << " use time " << after_merge - before_merge;
+          if (!send_scope_->FindVar(var_name)->IsInitialized()) {
+            VLOG(4) << var_name << " has only empty gradients to send";
+            return;
+          }
           auto send_functor = distributed::ParameterSend<float>();
           send_functor(ctx, *send_scope_, true, 1);
           auto after_send = GetCurrentUS();
@@ -201,7 +207,7 @@ void AsyncCommunicator::SendThread() {
         task_futures.emplace_back(
             send_threadpool_->enqueue(std::move(send_task)));
       } else {
-        VLOG(4) << var_name << " queue empty";
+        VLOG(4) << var_name << " has no gradient to send";
       }
     }
     for (auto &task_f : task_futures) {
@@ -310,17 +316,15 @@ void AsyncCommunicator::Send(const std::vector<std::string> &var_names,
       var_names.size(), 1,
       platform::errors::InvalidArgument("var_names.size() == 1 is permitted"));
   auto var_name = var_names[0];
-  // push var into send queue by var_name
+  // merge var into the gradients to send by var_name
   auto *grad_var = scope.FindVar(var_name);
   PADDLE_ENFORCE_EQ(
       grad_var->IsInitialized(), true,
       platform::errors::InvalidArgument("grad var should be inited"));
 
-  auto tmp_grad_var = std::make_shared<Variable>();
-  framework::CopyVariable(*grad_var, tmp_grad_var.get());
-  auto &queue = send_varname_to_queue_.at(var_name);
-  VLOG(3) << "send " << var_name << " queue size " << queue->Size();
-  queue->Push(tmp_grad_var);
+  auto &accumulator = send_varname_to_accumulator_.at(var_name);
+  accumulator->Add(*grad_var);
+  VLOG(3) << "send " << var_name << " merged num " << accumulator->Count();
 }
 
 GeoSgdCommunicator::~GeoSgdCommunicator() {
@@ -379,6 +383,10 @@ void GeoSgdCommunicator::InitImpl(const paddle::framework::ProgramDesc &program,
   need_push_queue_ =
       std::make_shared<BlockingQueue<std::shared_ptr<SparseIdsMap>>>(
           geo_need_push_nums_);
+  auto need_push_queue = need_push_queue_;
+  AddSendQueueGauge([need_push_queue] {
+    return static_cast<int64_t>(need_push_queue->Size());
+  });
   delta_scope_.reset(new Scope());
   old_scope_.reset(new Scope());
   pserver_scope_.reset(new Scope());
@@ -958,9 +966,11 @@ void HalfAsyncCommunicator::InitImpl(const RpcCtxMap &send_varname_to_ctx,
   } else {
     send_scope_.reset(new Scope());
     for (auto &iter : send_varname_to_ctx_) {
-      send_varname_to_queue_[iter.first] =
-          std::make_shared<BlockingQueue<std::shared_ptr<Variable>>>(
-              send_queue_size_);
+      auto queue = std::make_shared<BlockingQueue<std::shared_ptr<Variable>>>(
+          send_queue_size_);
+      send_varname_to_queue_[iter.first] = queue;
+      AddSendQueueGauge(
+          [queue] { return static_cast<int64_t>(queue->Size()); });
     }
 
     consume_threadpool_.reset(new ::ThreadPool(thread_pool_size_));
@@ -17,6 +17,7 @@ limitations under the License. */
 #include <ThreadPool.h>
 #include <atomic>
 #include <deque>
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
@@ -31,11 +32,14 @@ limitations under the License. */
 #include "paddle/fluid/operators/distributed/distributed.h"
 #include "paddle/fluid/operators/distributed/rpc_client.h"
 #include "paddle/fluid/operators/distributed/rpc_common.h"
+#include "paddle/fluid/operators/distributed/send_var_accumulator.h"
+#include "paddle/fluid/operators/distributed/wire_compression.h"
 #include "paddle/fluid/operators/distributed_ops/send_recv_util.h"
 #include "paddle/fluid/operators/math/math_function.h"
 #include "paddle/fluid/operators/math/selected_rows_functor.h"
 #include "paddle/fluid/platform/device_context.h"
 #include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/platform/monitor.h"
 #include "paddle/fluid/platform/place.h"
 #include "paddle/fluid/string/split.h"
 
@@ -225,10 +229,18 @@ class Communicator {
   }
 
  protected:
+  // Export the number of the gradients of a variable waiting to be sent,
+  // which are summed over the variables as STAT_communicator_send_queue_size.
+  void AddSendQueueGauge(std::function<int64_t()> getter) {
+    send_queue_gauges_.emplace_back(new platform::StatGauge(
+        "STAT_communicator_send_queue_size", std::move(getter)));
+  }
+
   bool running_ = false;
   static std::shared_ptr<Communicator> communicator_;
   static std::once_flag init_flag_;
   std::unordered_map<std::string, std::string> envs;
+  std::vector<std::unique_ptr<platform::StatGauge>> send_queue_gauges_;
 };
 
 using SparseIdsMap =
@@ -246,9 +258,19 @@ class AsyncCommunicator : public Communicator {
     thread_pool_size_ = std::stoi(envs.at("communicator_thread_pool_size"));
     max_merge_var_num_ = std::stoi(envs.at("communicator_max_merge_var_num"));
     send_wait_times_ = std::stoi(envs.at("communicator_send_wait_times"));
-    send_queue_size_ = std::stoi(envs.at("communicator_send_queue_size"));
     is_sgd_optimizer_ =
         static_cast<bool>(std::stoi(envs.at("communicator_is_sgd_optimizer")));
+    // the wire compression is optional, and off by default
+    auto find = [&envs](const std::string& key, const std::string& value) {
+      auto it = envs.find(key);
+      return it == envs.end() ? value : it->second;
+    };
+    send_compression_ =
+        ParseWireCompression(find("communicator_send_compression", "none"));
+    recv_compression_ =
+        ParseWireCompression(find("communicator_recv_compression", "none"));
+    error_feedback_ =
+        static_cast<bool>(std::stoi(find("communicator_error_feedback", "1")));
     VLOG(0) << "AsyncCommunicator Initialized";
   }
   ~AsyncCommunicator();
@@ -277,14 +299,21 @@ class AsyncCommunicator : public Communicator {
   int thread_pool_size_;
   int max_merge_var_num_;
   int send_wait_times_;
-  int send_queue_size_;
   bool independent_recv_thread_;
   bool is_sgd_optimizer_;
+  // the compression of the gradients sent and the parameters received, and
+  // whether the error of the compression of the gradients is fed back
+  WireCompressionType send_compression_ =
+      sendrecv::VariableMessage::NO_COMPRESSION;
+  WireCompressionType recv_compression_ =
+      sendrecv::VariableMessage::NO_COMPRESSION;
+  bool error_feedback_ = true;
 
  private:
-  std::unordered_map<std::string,
-                     std::shared_ptr<BlockingQueue<std::shared_ptr<Variable>>>>
-      send_varname_to_queue_;
+  // the gradients are merged as they are sent, and at most
+  // max_merge_var_num_ of them are merged before the send thread sends them
+  std::unordered_map<std::string, std::shared_ptr<SendVarAccumulator>>
+      send_varname_to_accumulator_;
   RpcCtxMap send_varname_to_ctx_;
   RpcCtxMap recv_varname_to_ctx_;
   std::unique_ptr<std::thread> send_thread_{nullptr};
@@ -86,7 +86,10 @@ VarHandlePtr GRPCClient::AsyncSendVar(const std::string& ep,
       auto* var = p_scope->FindVar(var_name_val);
 
       ::grpc::ByteBuffer req;
-      SerializeToByteBuffer(var_name_val, var, *p_ctx, &req, "", trainer_id_);
+      auto compressor =
+          WireCompression::Instance().SendCompressor(var_name_val);
+      SerializeToByteBuffer(var_name_val, var, *p_ctx, &req, "", trainer_id_,
+                            "", compressor.get());
 
       VLOG(3) << s->GetVarHandlePtr()->String() << " begin";
 
@@ -203,6 +206,8 @@ VarHandlePtr GRPCClient::_AsyncGetVar(
       req.set_out_varname(out_varname_val);
       req.set_trainer_id(trainer_id_);
       req.set_table_name(table_name_val);
+      req.set_compression(
+          WireCompression::Instance().RecvCompression(out_varname_val));
       ::grpc::ByteBuffer buf;
       RequestToByteBuffer<sendrecv::VariableMessage>(req, &buf);
 
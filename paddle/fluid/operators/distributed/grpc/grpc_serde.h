@@ -25,6 +25,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/tensor_util.h"
 #include "paddle/fluid/framework/var_type.h"
 #include "paddle/fluid/operators/distributed/sendrecvop_utils.h"
+#include "paddle/fluid/operators/distributed/wire_compression.h"
 #include "paddle/fluid/platform/port.h"
 
 #include "paddle/fluid/operators/distributed/distributed_pb.h"
@@ -40,7 +41,8 @@ void SerializeToByteBuffer(const std::string& name, framework::Variable* var,
                            ::grpc::ByteBuffer* msg,
                            const std::string& out_varname = std::string(),
                            const int trainer_id = 0,
-                           const std::string& table_name = std::string());
+                           const std::string& table_name = std::string(),
+                           WireCompressor* compressor = nullptr);
 
 void DeserializeFromByteBuffer(const ::grpc::ByteBuffer& msg,
                                const platform::DeviceContext& ctx,
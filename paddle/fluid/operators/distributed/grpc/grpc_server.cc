@@ -154,8 +154,9 @@ class RequestGet final : public RequestBase {
 
     VLOG(1) << "before SerializeToByteBuffer";
     if (outvar) {
+      auto compressor = CreateReplyCompressor(request_.compression());
       SerializeToByteBuffer(out_varname, outvar, *request_handler_->dev_ctx(),
-                            &reply_);
+                            &reply_, "", 0, "", compressor.get());
     }
     VLOG(1) << "after SerializeToByteBuffer";
     Finish(reply_, &responder_);
@@ -201,8 +202,9 @@ class RequestGetNoBarrier final : public RequestBase {
                              out_varname);
 
     if (outvar) {
+      auto compressor = CreateReplyCompressor(request_.compression());
       SerializeToByteBuffer(out_varname, outvar, *request_handler_->dev_ctx(),
-                            &reply_);
+                            &reply_, "", 0, "", compressor.get());
     }
     Finish(reply_, &responder_);
   }
@@ -27,22 +27,22 @@
 #include "paddle/fluid/framework/tensor.h"
 #include "paddle/fluid/operators/distributed/distributed_pb.h"
 #include "paddle/fluid/operators/distributed/grpc/grpc_bytebuffer_stream.h"
-#include "paddle/fluid/operators/distributed/variable_response.h"
+#include "paddle/fluid/operators/distributed/proto_variable_response.h"
 
 namespace paddle {
 namespace operators {
 namespace distributed {
 
-class GRPCVariableResponse : public VariableResponse {
+class GRPCVariableResponse : public ProtoVariableResponse {
  public:
   GRPCVariableResponse(const framework::Scope* scope,
                        const platform::DeviceContext* dev_ctx,
                        bool create_scope = false)
-      : VariableResponse(scope, dev_ctx, create_scope) {}
+      : ProtoVariableResponse(scope, dev_ctx, create_scope) {}
 
   virtual ~GRPCVariableResponse() {}
 
-  int Parse(Source* source) override;
+  using ProtoVariableResponse::Parse;
 
   // return:
   // 0:ok.
@@ -0,0 +1,43 @@
+//   Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "paddle/fluid/operators/distributed/variable_response.h"
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+// Parses the VariableMessage in the wire format of protobuf, as gRPC sends
+// it, from any Source.
+class ProtoVariableResponse : public VariableResponse {
+ public:
+  ProtoVariableResponse(const framework::Scope* scope,
+                        const platform::DeviceContext* dev_ctx,
+                        bool create_scope = false)
+      : VariableResponse(scope, dev_ctx, create_scope) {}
+
+  virtual ~ProtoVariableResponse() {}
+
+  // return:
+  // 0:ok.
+  // -1: unkown error.
+  // other: number of error field.
+  int Parse(Source* source) override;
+};
+
+};  // namespace distributed
+};  // namespace operators
+};  // namespace paddle
@@ -0,0 +1,304 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/distributed/send_var_accumulator.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "paddle/fluid/framework/data_type.h"
+#include "paddle/fluid/framework/tensor_util.h"
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+namespace {
+
+// The rows of the buffer of SelectedRows grow by at least it at a time.
+constexpr int64_t kMinBufferRows = 64;
+
+// Add src[i] into the row indexes[i] of dst, or copy it to the row if the row
+// is new.
+struct AddRowsFunctor {
+  const void* src;
+  const int64_t* indexes;
+  const bool* is_new;
+  int64_t num;
+  int64_t width;
+  void* dst;
+
+  template <typename T>
+  void apply() const {
+    const T* src_rows = static_cast<const T*>(src);
+    T* dst_rows = static_cast<T*>(dst);
+    for (int64_t i = 0; i < num; ++i) {
+      const T* in = src_rows + i * width;
+      T* out = dst_rows + indexes[i] * width;
+      if (is_new[i]) {
+        std::memcpy(out, in, width * sizeof(T));
+      } else {
+        for (int64_t j = 0; j < width; ++j) {
+          out[j] += in[j];
+        }
+      }
+    }
+  }
+};
+
+struct DivideFunctor {
+  void* data;
+  int64_t numel;
+  int64_t count;
+
+  template <typename T>
+  void apply() const {
+    T* values = static_cast<T*>(data);
+    T divisor = static_cast<T>(count);
+    for (int64_t i = 0; i < numel; ++i) {
+      values[i] /= divisor;
+    }
+  }
+};
+
+}  // namespace
+
+SendVarAccumulator::SendVarAccumulator(bool merge_add, int64_t capacity)
+    : merge_add_(merge_add),
+      capacity_(capacity),
+      active_(new Buffer()),
+      standby_(new Buffer()) {}
+
+void SendVarAccumulator::Add(const framework::Variable& var) {
+  // the gradients on the devices are copied to CPU out of the lock
+  platform::CPUPlace cpu;
+  framework::Variable cpu_var;
+  const framework::Variable* grad = &var;
+  if (var.IsType<framework::LoDTensor>()) {
+    auto& tensor = var.Get<framework::LoDTensor>();
+    if (!platform::is_cpu_place(tensor.place())) {
+      framework::TensorCopySync(
+          tensor, cpu, cpu_var.GetMutable<framework::LoDTensor>());
+      grad = &cpu_var;
+    }
+  } else if (var.IsType<framework::SelectedRows>()) {
+    auto& slr = var.Get<framework::SelectedRows>();
+    if (slr.value().IsInitialized() &&
+        !platform::is_cpu_place(slr.value().place())) {
+      auto* cpu_slr = cpu_var.GetMutable<framework::SelectedRows>();
+      cpu_slr->set_rows(slr.rows());
+      cpu_slr->set_height(slr.height());
+      framework::TensorCopySync(slr.value(), cpu, cpu_slr->mutable_value());
+      grad = &cpu_var;
+    }
+  } else {
+    PADDLE_THROW(platform::errors::InvalidArgument(
+        "Only LoDTensor and SelectedRows can be merged for sending, but the "
+        "gradient is %s.",
+        framework::ToTypeName(var.Type())));
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  cond_.wait(lock,
+             [this] { return capacity_ <= 0 || active_->count < capacity_; });
+  if (grad->IsType<framework::LoDTensor>()) {
+    AddTensor(grad->Get<framework::LoDTensor>(), active_.get());
+  } else {
+    AddSelectedRows(grad->Get<framework::SelectedRows>(), active_.get());
+  }
+  ++active_->count;
+}
+
+void SendVarAccumulator::CheckGradient(bool is_sparse,
+                                       const framework::Tensor& value,
+                                       int64_t height) {
+  if (!initialized_) {
+    auto type = value.type();
+    PADDLE_ENFORCE_EQ(
+        type == framework::proto::VarType::FP32 ||
+            type == framework::proto::VarType::FP64 ||
+            type == framework::proto::VarType::INT32 ||
+            type == framework::proto::VarType::INT64,
+        true, platform::errors::Unimplemented(
+                  "The gradients of %s can not be merged for sending.",
+                  framework::DataTypeToString(type)));
+    initialized_ = true;
+    is_sparse_ = is_sparse;
+    type_ = value.type();
+    dims_ = value.dims();
+    height_ = height;
+    return;
+  }
+  PADDLE_ENFORCE_EQ(is_sparse, is_sparse_,
+                    platform::errors::InvalidArgument(
+                        "The gradients to merge should be all LoDTensors or "
+                        "all SelectedRows."));
+  PADDLE_ENFORCE_EQ(value.type(), type_,
+                    platform::errors::InvalidArgument(
+                        "The data type of the gradients to merge should be "
+                        "%s, but got %s.",
+                        framework::DataTypeToString(type_),
+                        framework::DataTypeToString(value.type())));
+  if (is_sparse) {
+    PADDLE_ENFORCE_EQ(framework::slice_ddim(value.dims(), 1, dims_.size()),
+                      framework::slice_ddim(dims_, 1, dims_.size()),
+                      platform::errors::InvalidArgument(
+                          "The rows of the SelectedRows to merge should have "
+                          "the same dims, but got %s and %s.",
+                          value.dims(), dims_));
+    PADDLE_ENFORCE_EQ(height, height_,
+                      platform::errors::InvalidArgument(
+                          "The SelectedRows to merge should have the same "
+                          "height, but got %d and %d.",
+                          height, height_));
+  } else {
+    PADDLE_ENFORCE_EQ(value.dims(), dims_,
+                      platform::errors::InvalidArgument(
+                          "The LoDTensors to merge should have the same dims, "
+                          "but got %s and %s.",
+                          value.dims(), dims_));
+  }
+}
+
+void SendVarAccumulator::AddTensor(const framework::LoDTensor& tensor,
+                                   Buffer* buffer) {
+  CheckGradient(false, tensor, 0);
+  if (buffer->count == 0) {
+    // the buffer keeps its memory from the former gradients
+    buffer->value.Resize(dims_);
+    std::memcpy(buffer->value.mutable_data(platform::CPUPlace(), type_),
+                tensor.data<void>(),
+                tensor.numel() * framework::SizeOfType(type_));
+    return;
+  }
+  int64_t index = 0;
+  bool is_new = false;
+  framework::VisitDataTypeSmall(
+      type_, AddRowsFunctor{tensor.data<void>(), &index, &is_new, 1,
+                            tensor.numel(), buffer->value.data<void>()});
+}
+
+void SendVarAccumulator::AddSelectedRows(const framework::SelectedRows& slr,
+                                         Buffer* buffer) {
+  auto& rows = slr.rows();
+  if (rows.empty()) {
+    return;
+  }
+  auto& value = slr.value();
+  CheckGradient(true, value, slr.height());
+  int64_t num = static_cast<int64_t>(rows.size());
+  int64_t width = value.numel() / num;
+
+  // find the rows in the buffer, and append the new ones
+  std::vector<int64_t> indexes(num);
+  std::unique_ptr<bool[]> is_new(new bool[num]);
+  buffer->row_index.Find(rows.data(), rows.size(), indexes.data());
+  for (int64_t i = 0; i < num; ++i) {
+    is_new[i] = indexes[i] < 0;
+    if (is_new[i]) {
+      // the rows repeated in the gradient are new only once
+      indexes[i] = buffer->row_index.Find(rows[i]);
+      if (indexes[i] < 0) {
+        indexes[i] = static_cast<int64_t>(buffer->rows.size());
+        buffer->row_index.Insert(rows[i], indexes[i]);
+        buffer->rows.push_back(rows[i]);
+      } else {
+        is_new[i] = false;
+      }
+    }
+  }
+
+  // grow the buffer of rows, which keeps its memory from the former
+  // gradients
+  int64_t buffer_rows = static_cast<int64_t>(buffer->rows.size());
+  int64_t capacity =
+      buffer->value.IsInitialized() ? buffer->value.dims()[0] : 0;
+  if (buffer_rows > capacity) {
+    capacity = std::max(buffer_rows, std::max(capacity * 2, kMinBufferRows));
+    framework::Tensor grown;
+    grown.Resize(framework::make_ddim({capacity, width}));
+    void* data = grown.mutable_data(platform::CPUPlace(), type_);
+    int64_t old_rows = buffer_rows - std::count(is_new.get(),
+                                                is_new.get() + num, true);
+    if (old_rows > 0) {
+      std::memcpy(data, buffer->value.data<void>(),
+                  old_rows * width * framework::SizeOfType(type_));
+    }
+    buffer->value = grown;
+  }
+
+  framework::VisitDataTypeSmall(
+      type_, AddRowsFunctor{value.data<void>(), indexes.data(), is_new.get(),
+                            num, width, buffer->value.data<void>()});
+}
+
+int64_t SendVarAccumulator::Count() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return active_->count;
+}
+
+int64_t SendVarAccumulator::Swap(framework::Variable* var) {
+  // reset the standby buffer, whose gradients have been sent, out of the lock
+  standby_->count = 0;
+  if (!standby_->rows.empty()) {
+    size_t num_rows = standby_->rows.size();
+    standby_->rows.clear();
+    standby_->row_index.Clear();
+    standby_->row_index.Reserve(num_rows);
+  }
+  bool initialized = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::swap(active_, standby_);
+    // the first gradient may be added right now
+    initialized = initialized_;
+  }
+  cond_.notify_all();
+
+  Buffer* buffer = standby_.get();
+  if (buffer->count == 0 || !initialized) {
+    return buffer->count;
+  }
+  framework::Tensor* value = nullptr;
+  if (is_sparse_) {
+    auto* slr = var->GetMutable<framework::SelectedRows>();
+    slr->set_height(height_);
+    slr->set_rows(buffer->rows);
+    value = slr->mutable_value();
+    auto dims = dims_;
+    dims[0] = static_cast<int64_t>(buffer->rows.size());
+    if (buffer->rows.empty()) {
+      value->Resize(dims);
+      value->mutable_data(platform::CPUPlace(), type_);
+    } else {
+      value->ShareDataWith(buffer->value);
+      value->Resize(dims);
+    }
+  } else {
+    value = var->GetMutable<framework::LoDTensor>();
+    value->ShareDataWith(buffer->value);
+  }
+
+  if (!merge_add_ && buffer->count > 1) {
+    framework::VisitDataTypeSmall(
+        type_, DivideFunctor{value->data<void>(), value->numel(),
+                             buffer->count});
+  }
+  return buffer->count;
+}
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
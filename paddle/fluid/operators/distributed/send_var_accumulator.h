@@ -0,0 +1,107 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <stdint.h>
+#include <condition_variable>  // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/selected_rows.h"
+#include "paddle/fluid/framework/sparse_row_index.h"
+#include "paddle/fluid/framework/variable.h"
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+/*
+ * @brief Merges the gradients of a variable as the trainer threads send them,
+ * in place of the queue of their copies, which the send thread merged by
+ * MergeVars before each RPC.
+ *
+ * The rows of the SelectedRows gradients are merged by a hash index into a
+ * buffer of rows, and the LoDTensor gradients are added into a buffer of the
+ * same dims. The buffers are doubled: the trainer threads add into the
+ * active one, while the send thread sends the one it swapped out by Swap.
+ */
+class SendVarAccumulator {
+ public:
+  /*
+   * @param merge_add whether the gradients are summed, or else averaged.
+   * @param capacity the number of the gradients merged into the active
+   * buffer, at which Add blocks until Swap, so that the trainer threads are
+   * held back when the send thread falls behind. 0 for no limit.
+   */
+  SendVarAccumulator(bool merge_add, int64_t capacity);
+
+  /*
+   * @brief Merge the gradient, which is a LoDTensor or a SelectedRows of
+   * float, double, int or int64_t, into the active buffer.
+   */
+  void Add(const framework::Variable& var);
+
+  /*
+   * @return the number of the gradients merged into the active buffer.
+   */
+  int64_t Count() const;
+
+  /*
+   * @brief Swap the buffers, and set var to the gradients merged into the
+   * former active buffer, which shares the memory of the buffer until the
+   * next Swap. Only the send thread may call it.
+   *
+   * @return the number of the merged gradients.
+   */
+  int64_t Swap(framework::Variable* var);
+
+ private:
+  struct Buffer {
+    int64_t count = 0;
+    // the rows of the SelectedRows gradients, and the index from them to
+    // the rows of value
+    std::vector<int64_t> rows;
+    framework::SparseRowIndex row_index;
+    framework::Tensor value;
+  };
+
+  void AddTensor(const framework::LoDTensor& tensor, Buffer* buffer);
+  void AddSelectedRows(const framework::SelectedRows& slr, Buffer* buffer);
+  // Check the type, the dims and the height of the gradient against those of
+  // the former ones.
+  void CheckGradient(bool is_sparse, const framework::Tensor& value,
+                     int64_t height);
+
+  const bool merge_add_;
+  const int64_t capacity_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable cond_;
+  std::unique_ptr<Buffer> active_;
+  std::unique_ptr<Buffer> standby_;
+
+  // set by the first gradient
+  bool initialized_ = false;
+  bool is_sparse_ = false;
+  framework::proto::VarType::Type type_;
+  framework::DDim dims_;
+  int64_t height_ = 0;
+};
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
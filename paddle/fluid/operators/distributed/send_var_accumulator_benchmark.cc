@@ -0,0 +1,199 @@
+//   Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Throughput of the sparse gradients sent by the trainer threads of
+// AsyncCommunicator, for the queue of their copies merged by MergeVars before
+// each send, and for the SendVarAccumulator, which merges them as they are
+// sent. The RPC is stood in by a copy of the merged rows and values into a
+// buffer, so that the time is that of the merge rather than that of the
+// network.
+//
+// Usage:
+//   ./send_var_accumulator_benchmark --trainer_threads=4 --grads=20000 \
+//       --rows_per_grad=512 --height=100000 --width=16 --max_merge_var_num=20
+
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/variable_helper.h"
+#include "paddle/fluid/operators/distributed/communicator.h"
+#include "paddle/fluid/operators/distributed/send_var_accumulator.h"
+#include "paddle/fluid/platform/init.h"
+
+DEFINE_int32(trainer_threads, 4, "Number of the threads sending gradients.");
+DEFINE_int32(grads, 20000, "Number of the gradients sent by each thread.");
+DEFINE_int32(rows_per_grad, 512, "Number of the rows of each gradient.");
+DEFINE_int64(height, 100000, "Height of the sparse parameter.");
+DEFINE_int32(width, 16, "Width of the sparse parameter.");
+DEFINE_int32(max_merge_var_num, 20,
+             "Max number of the gradients merged before each send.");
+DEFINE_int32(send_queue_size, 20, "Size of the queue of the gradients.");
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+// Gradients of zipf-like rows, so that the hot rows repeat across them.
+static std::vector<Variable> CreateGradients(int num) {
+  std::mt19937 engine(0);
+  std::uniform_real_distribution<double> uniform(0, 1);
+  std::vector<Variable> grads(num);
+  for (auto& grad : grads) {
+    std::vector<int64_t> rows;
+    for (int i = 0; i < FLAGS_rows_per_grad; ++i) {
+      double u = uniform(engine);
+      rows.push_back(static_cast<int64_t>(u * u * u * FLAGS_height));
+    }
+    auto* slr = grad.GetMutable<framework::SelectedRows>();
+    slr->set_height(FLAGS_height);
+    slr->set_rows(rows);
+    auto* data = slr->mutable_value()->mutable_data<float>(
+        framework::make_ddim({FLAGS_rows_per_grad, FLAGS_width}),
+        platform::CPUPlace());
+    for (int64_t i = 0; i < slr->value().numel(); ++i) {
+      data[i] = static_cast<float>(uniform(engine));
+    }
+  }
+  return grads;
+}
+
+// Stands in for the RPC, which serializes the rows and the values.
+static size_t FakeSend(const Variable& var, std::string* buffer) {
+  auto& slr = var.Get<framework::SelectedRows>();
+  size_t rows_size = slr.rows().size() * sizeof(int64_t);
+  size_t value_size = slr.value().numel() * sizeof(float);
+  buffer->resize(rows_size + value_size);
+  if (rows_size > 0) {
+    std::memcpy(&(*buffer)[0], slr.rows().data(), rows_size);
+    std::memcpy(&(*buffer)[rows_size], slr.value().data<float>(), value_size);
+  }
+  return slr.rows().size();
+}
+
+struct Result {
+  double ms = 0;
+  int64_t sends = 0;
+  int64_t sent_rows = 0;
+};
+
+// Run the trainer threads, and the send thread, which sends until the
+// gradients of all the trainer threads are merged.
+template <typename AddFunc, typename SendFunc>
+static Result Run(const std::vector<Variable>& grads, AddFunc add,
+                  SendFunc send) {
+  Result result;
+  int64_t total = static_cast<int64_t>(FLAGS_trainer_threads) * FLAGS_grads;
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int t = 0; t < FLAGS_trainer_threads; ++t) {
+    threads.emplace_back([&grads, &add, t] {
+      for (int i = 0; i < FLAGS_grads; ++i) {
+        add(grads[(t + i) % grads.size()]);
+      }
+    });
+  }
+  std::string buffer;
+  int64_t merged = 0;
+  while (merged < total) {
+    int64_t rows = 0;
+    int64_t num = send(&buffer, &rows);
+    if (num > 0) {
+      merged += num;
+      result.sends += 1;
+      result.sent_rows += rows;
+    }
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  result.ms = std::chrono::duration<double, std::milli>(
+                  std::chrono::steady_clock::now() - start)
+                  .count();
+  return result;
+}
+
+static Result RunQueue(const std::vector<Variable>& grads) {
+  BlockingQueue<std::shared_ptr<Variable>> queue(FLAGS_send_queue_size);
+  Scope scope;
+  auto add = [&queue](const Variable& grad) {
+    auto copy = std::make_shared<Variable>();
+    framework::CopyVariable(grad, copy.get());
+    queue.Push(copy);
+  };
+  auto send = [&queue, &scope](std::string* buffer, int64_t* rows) {
+    std::vector<std::shared_ptr<Variable>> vars;
+    // the merged gradients are popped as SendThread does, without waiting
+    while (vars.size() < static_cast<size_t>(FLAGS_max_merge_var_num) &&
+           queue.Size() > 0) {
+      vars.push_back(queue.Pop());
+    }
+    if (vars.empty()) {
+      std::this_thread::yield();
+      return static_cast<int64_t>(0);
+    }
+    MergeVars<float>("grad", vars, &scope, true);
+    *rows = FakeSend(*scope.FindVar("grad"), buffer);
+    return static_cast<int64_t>(vars.size());
+  };
+  return Run(grads, add, send);
+}
+
+static Result RunAccumulator(const std::vector<Variable>& grads) {
+  SendVarAccumulator accumulator(true, FLAGS_max_merge_var_num);
+  Variable out;
+  auto add = [&accumulator](const Variable& grad) { accumulator.Add(grad); };
+  auto send = [&accumulator, &out](std::string* buffer, int64_t* rows) {
+    if (accumulator.Count() == 0) {
+      std::this_thread::yield();
+      return static_cast<int64_t>(0);
+    }
+    int64_t num = accumulator.Swap(&out);
+    *rows = FakeSend(out, buffer);
+    return num;
+  };
+  return Run(grads, add, send);
+}
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  paddle::framework::InitDevices(false);
+  using paddle::operators::distributed::Result;
+
+  auto grads = paddle::operators::distributed::CreateGradients(64);
+  int64_t total = static_cast<int64_t>(FLAGS_trainer_threads) * FLAGS_grads;
+  std::cout << "method\tms\tgrads/s\tsends\trows/send" << std::endl;
+  auto print = [total](const std::string& method, const Result& result) {
+    std::cout << method << "\t" << result.ms << "\t"
+              << total * 1000 / result.ms << "\t" << result.sends << "\t"
+              << static_cast<double>(result.sent_rows) / result.sends
+              << std::endl;
+  };
+  auto queue = paddle::operators::distributed::RunQueue(grads);
+  print("queue+MergeVars", queue);
+  auto accumulator = paddle::operators::distributed::RunAccumulator(grads);
+  print("accumulator", accumulator);
+  std::cout << "speedup\t" << queue.ms / accumulator.ms << std::endl;
+  return 0;
+}
@@ -0,0 +1,243 @@
+//   Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/operators/distributed/send_var_accumulator.h"
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <map>
+#include <thread>  // NOLINT
+#include <vector>
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+using LoDTensor = framework::LoDTensor;
+using SelectedRows = framework::SelectedRows;
+using Variable = framework::Variable;
+
+static const int64_t kHeight = 100;
+static const int64_t kWidth = 4;
+
+// The rows of the gradient have the value of row * scale.
+static void SetSelectedRows(const std::vector<int64_t>& rows, float scale,
+                            Variable* var) {
+  auto* slr = var->GetMutable<SelectedRows>();
+  slr->set_height(kHeight);
+  slr->set_rows(rows);
+  auto dims = framework::make_ddim({static_cast<int64_t>(rows.size()), kWidth});
+  auto* data =
+      slr->mutable_value()->mutable_data<float>(dims, platform::CPUPlace());
+  for (size_t i = 0; i < rows.size(); ++i) {
+    for (int64_t j = 0; j < kWidth; ++j) {
+      data[i * kWidth + j] = rows[i] * scale;
+    }
+  }
+}
+
+static std::map<int64_t, float> GetSelectedRows(const Variable& var) {
+  auto& slr = var.Get<SelectedRows>();
+  EXPECT_EQ(slr.height(), kHeight);
+  EXPECT_EQ(slr.value().dims(),
+            framework::make_ddim(
+                {static_cast<int64_t>(slr.rows().size()), kWidth}));
+  std::map<int64_t, float> values;
+  const float* data = slr.value().data<float>();
+  for (size_t i = 0; i < slr.rows().size(); ++i) {
+    EXPECT_EQ(values.count(slr.rows()[i]), 0UL);
+    for (int64_t j = 1; j < kWidth; ++j) {
+      EXPECT_EQ(data[i * kWidth + j], data[i * kWidth]);
+    }
+    values[slr.rows()[i]] = data[i * kWidth];
+  }
+  return values;
+}
+
+TEST(send_var_accumulator, merge_selected_rows) {
+  for (bool merge_add : {true, false}) {
+    SendVarAccumulator accumulator(merge_add, 0);
+    // the rows repeat in and across the gradients, and the later gradients
+    // grow the buffer
+    std::map<int64_t, float> expected;
+    for (int i = 0; i < 10; ++i) {
+      std::vector<int64_t> rows;
+      for (int64_t k = 0; k <= i * 8; k += 2) {
+        rows.push_back(k);
+      }
+      rows.push_back(i);
+      rows.push_back(i);
+      for (auto row : rows) {
+        expected[row] += row * (i + 1.f);
+      }
+      Variable var;
+      SetSelectedRows(rows, i + 1.f, &var);
+      accumulator.Add(var);
+    }
+    ASSERT_EQ(accumulator.Count(), 10);
+
+    Variable out;
+    ASSERT_EQ(accumulator.Swap(&out), 10);
+    ASSERT_EQ(accumulator.Count(), 0);
+    auto actual = GetSelectedRows(out);
+    ASSERT_EQ(actual.size(), expected.size());
+    for (auto& item : expected) {
+      float value = merge_add ? item.second : item.second / 10;
+      ASSERT_FLOAT_EQ(actual[item.first], value) << item.first;
+    }
+  }
+}
+
+TEST(send_var_accumulator, merge_lod_tensors) {
+  SendVarAccumulator accumulator(false, 0);
+  auto dims = framework::make_ddim({2, 3});
+  for (int i = 0; i < 4; ++i) {
+    Variable var;
+    auto* data = var.GetMutable<LoDTensor>()->mutable_data<double>(
+        dims, platform::CPUPlace());
+    for (int j = 0; j < 6; ++j) {
+      data[j] = i * j;
+    }
+    accumulator.Add(var);
+  }
+  Variable out;
+  ASSERT_EQ(accumulator.Swap(&out), 4);
+  auto& tensor = out.Get<LoDTensor>();
+  ASSERT_EQ(tensor.dims(), dims);
+  for (int j = 0; j < 6; ++j) {
+    ASSERT_DOUBLE_EQ(tensor.data<double>()[j], 1.5 * j);
+  }
+
+  // the gradients to merge should match the former ones
+  Variable other;
+  other.GetMutable<LoDTensor>()->mutable_data<double>(
+      framework::make_ddim({3, 2}), platform::CPUPlace());
+  ASSERT_THROW(accumulator.Add(other), platform::EnforceNotMet);
+  other.GetMutable<LoDTensor>()->mutable_data<float>(dims,
+                                                     platform::CPUPlace());
+  ASSERT_THROW(accumulator.Add(other), platform::EnforceNotMet);
+  Variable sparse;
+  SetSelectedRows({1}, 1.f, &sparse);
+  ASSERT_THROW(accumulator.Add(sparse), platform::EnforceNotMet);
+}
+
+TEST(send_var_accumulator, swap_buffers) {
+  SendVarAccumulator accumulator(true, 0);
+  Variable out;
+  ASSERT_EQ(accumulator.Swap(&out), 0);
+  ASSERT_FALSE(out.IsInitialized());
+
+  Variable var;
+  SetSelectedRows({1, 2, 3}, 1.f, &var);
+  accumulator.Add(var);
+  ASSERT_EQ(accumulator.Swap(&out), 1);
+  // the gradients added after the swap go to the other buffer, and do not
+  // change those swapped out
+  SetSelectedRows({3, 4}, 10.f, &var);
+  accumulator.Add(var);
+  auto first = GetSelectedRows(out);
+  ASSERT_EQ(first, (std::map<int64_t, float>{{1, 1}, {2, 2}, {3, 3}}));
+
+  ASSERT_EQ(accumulator.Swap(&out), 1);
+  ASSERT_EQ(GetSelectedRows(out),
+            (std::map<int64_t, float>{{3, 30}, {4, 40}}));
+  // the buffer swapped out first is reused after it is reset
+  SetSelectedRows({5}, 1.f, &var);
+  accumulator.Add(var);
+  ASSERT_EQ(accumulator.Swap(&out), 1);
+  ASSERT_EQ(GetSelectedRows(out), (std::map<int64_t, float>{{5, 5}}));
+
+  // the empty gradients are only counted
+  var.GetMutable<SelectedRows>()->mutable_rows()->clear();
+  var.GetMutable<SelectedRows>()->mutable_value()->mutable_data<float>(
+      framework::make_ddim({0, kWidth}), platform::CPUPlace());
+  accumulator.Add(var);
+  accumulator.Add(var);
+  ASSERT_EQ(accumulator.Swap(&out), 2);
+  ASSERT_TRUE(GetSelectedRows(out).empty());
+}
+
+TEST(send_var_accumulator, concurrent_add) {
+  const int kThreads = 4;
+  const int kAddsPerThread = 200;
+  SendVarAccumulator accumulator(true, 16);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&accumulator, t] {
+      Variable var;
+      for (int i = 0; i < kAddsPerThread; ++i) {
+        SetSelectedRows({(t * 7 + i) % kHeight, kHeight - 1}, 1.f, &var);
+        accumulator.Add(var);
+      }
+    });
+  }
+
+  // the send thread swaps the gradients out while they are added
+  std::map<int64_t, float> merged;
+  int64_t count = 0;
+  Variable out;
+  while (count < kThreads * kAddsPerThread) {
+    ASSERT_LE(accumulator.Count(), 16);
+    int64_t num = accumulator.Swap(&out);
+    if (num > 0) {
+      count += num;
+      for (auto& item : GetSelectedRows(out)) {
+        merged[item.first] += item.second;
+      }
+    }
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  std::map<int64_t, float> expected;
+  for (int t = 0; t < kThreads; ++t) {
+    for (int i = 0; i < kAddsPerThread; ++i) {
+      int64_t row = (t * 7 + i) % kHeight;
+      expected[row] += row;
+      expected[kHeight - 1] += kHeight - 1;
+    }
+  }
+  ASSERT_EQ(merged.size(), expected.size());
+  for (auto& item : expected) {
+    ASSERT_FLOAT_EQ(merged[item.first], item.second) << item.first;
+  }
+}
+
+TEST(send_var_accumulator, capacity) {
+  SendVarAccumulator accumulator(true, 2);
+  Variable var;
+  SetSelectedRows({1}, 1.f, &var);
+  accumulator.Add(var);
+  accumulator.Add(var);
+
+  // the third gradient waits for the swap
+  std::atomic<bool> added{false};
+  std::thread thread([&] {
+    accumulator.Add(var);
+    added = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  ASSERT_FALSE(added);
+  Variable out;
+  ASSERT_EQ(accumulator.Swap(&out), 2);
+  thread.join();
+  ASSERT_TRUE(added);
+  ASSERT_EQ(accumulator.Count(), 1);
+}
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,234 @@
+//   Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifdef PADDLE_WITH_NCCL
+#include <nccl.h>
+#endif
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/wire_format_lite.h"
+#include "paddle/fluid/operators/distributed/proto_variable_response.h"
+#include "paddle/fluid/operators/distributed/variable_iovec.h"
+#include "paddle/fluid/platform/profiler.h"
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+void VarIOVec::Append(std::string bytes) {
+  if (bytes.empty()) {
+    return;
+  }
+  copies_.emplace_back(std::move(bytes));
+  segments_.push_back({copies_.back().data(), copies_.back().size()});
+  size_ += copies_.back().size();
+}
+
+void VarIOVec::AppendReference(const TensorPayload& payload) {
+  if (payload.memory_size() == 0) {
+    return;
+  }
+  payloads_.push_back(payload);
+  segments_.push_back(
+      {static_cast<const char*>(payload.ptr()), payload.memory_size()});
+  size_ += payload.memory_size();
+}
+
+void VarIOVec::CopyTo(std::string* buffer) const {
+  buffer->resize(size_);
+  size_t offset = 0;
+  for (auto& segment : segments_) {
+    std::memcpy(&(*buffer)[offset], segment.data, segment.size);
+    offset += segment.size;
+  }
+}
+
+// Append the tag and the size of a length-delimited field.
+static void AppendVarlengthBeginning(int field_number, size_t size,
+                                     std::string* bytes) {
+  ::google::protobuf::io::StringOutputStream stream(bytes);
+  ::google::protobuf::io::CodedOutputStream output(&stream);
+  output.WriteTag(
+      static_cast<uint32_t>(field_number) << 3 |
+      ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+  output.WriteVarint64(size);
+}
+
+void SerializeToIOVec(const std::string& name, framework::Variable* var,
+                      const platform::DeviceContext& ctx, VarIOVec* iov,
+                      const std::string& out_varname, const int trainer_id,
+                      const std::string& table_name,
+                      WireCompressor* compressor) {
+  platform::RecordRPCEvent record_event("serial");
+  VarMsg request;
+  std::unique_ptr<TensorPayload> payload;
+
+  request.set_varname(name);
+  request.set_trainer_id(trainer_id);
+  // Note: normally the profiler is enabled in 1 trainer, hence only
+  // 1 trainer returns true for ShouldSendProfileState(). It tells PS
+  // servers the trainer's profiling state so that PS can follow the
+  // trainer.
+  if (platform::ShouldSendProfileState()) {
+    if (platform::IsProfileEnabled()) {
+      request.set_profile(platform::kEnableProfiler);
+    } else {
+      request.set_profile(platform::kDisableProfiler);
+    }
+  }
+  if (!out_varname.empty()) {
+    request.set_out_varname(out_varname);
+  }
+  if (!table_name.empty()) {
+    request.set_table_name(table_name);
+  }
+  if (var->IsType<framework::LoDTensor>()) {
+    request.set_type(::sendrecv::LOD_TENSOR);
+    payload.reset(new TensorPayload(GetTensorPayload(var, ctx, &request)));
+  } else if (var->IsType<framework::SelectedRows>()) {
+    request.set_type(::sendrecv::SELECTED_ROWS);
+    payload.reset(
+        new TensorPayload(GetSelectedRowsPayload(var, ctx, &request)));
+#ifdef PADDLE_WITH_NCCL
+  } else if (var->IsType<ncclUniqueId>()) {
+    request.set_type(::sendrecv::NCCL_ID);
+#endif
+  } else {
+    PADDLE_THROW(platform::errors::Unimplemented(
+        "Serialize does not support type: %s", typeid(var->Type()).name()));
+  }
+
+  std::string compressed;
+  if (compressor != nullptr && payload != nullptr &&
+      request.data_type() == VarMsg::FP32) {
+    int64_t num_rows = 0;
+    int64_t width = 0;
+    WireCompressionRows(framework::make_ddim(std::vector<int64_t>(
+                            request.dims().begin(), request.dims().end())),
+                        &num_rows, &width);
+    const int64_t* ids = nullptr;
+    if (var->IsType<framework::SelectedRows>()) {
+      ids = var->Get<framework::SelectedRows>().rows().data();
+    }
+    compressor->Compress(static_cast<const float*>(payload->ptr()), num_rows,
+                         width, ids, &compressed);
+    request.set_compression(compressor->type());
+  }
+
+  std::string header;
+  request.AppendToString(&header);
+#ifdef PADDLE_WITH_NCCL
+  if (var->IsType<ncclUniqueId>()) {
+    AppendVarlengthBeginning(VarMsg::kSerializedFieldNumber,
+                             NCCL_UNIQUE_ID_BYTES, &header);
+    const ncclUniqueId& uid = var->Get<ncclUniqueId>();
+    header.append(uid.internal, NCCL_UNIQUE_ID_BYTES);
+    iov->Append(std::move(header));
+    return;
+  }
+#endif
+  PADDLE_ENFORCE_NOT_NULL(payload, platform::errors::InvalidArgument(
+                                       "The payload of %s is null.", name));
+  if (payload->memory_size() >= std::numeric_limits<int>::max()) {
+    PADDLE_THROW(platform::errors::InvalidArgument(
+        "Variable %s length %d should less than %d.", name,
+        payload->memory_size(), std::numeric_limits<int>::max()));
+  }
+  if (request.compression() != VarMsg::NO_COMPRESSION) {
+    AppendVarlengthBeginning(VarMsg::kSerializedFieldNumber, compressed.size(),
+                             &header);
+    iov->Append(std::move(header));
+    iov->Append(std::move(compressed));
+  } else {
+    AppendVarlengthBeginning(VarMsg::kSerializedFieldNumber,
+                             payload->memory_size(), &header);
+    iov->Append(std::move(header));
+    iov->AppendReference(*payload);
+  }
+
+  if (var->IsType<framework::SelectedRows>()) {
+    auto* slr = var->GetMutable<framework::SelectedRows>();
+    PADDLE_ENFORCE_EQ(VectorElemName(slr->rows()), typeid(int64_t).name(),
+                      platform::errors::InvalidArgument(
+                          "The rows of SelectedRows should be int64_t."));
+    size_t rows_memory_size = slr->rows().size() * sizeof(int64_t);
+    std::string rows;
+    rows.reserve(rows_memory_size + 16);
+    AppendVarlengthBeginning(VarMsg::kRowsFieldNumber, rows_memory_size,
+                             &rows);
+    rows.append(reinterpret_cast<const char*>(slr->rows().data()),
+                rows_memory_size);
+    iov->Append(std::move(rows));
+  }
+}
+
+bool IOVecInputStream::Next(const void** data, int* size) {
+  // Skip the consumed segments, in case the last one was consumed exactly.
+  while (cur_ < segments_.size() && offset_ == segments_[cur_].size) {
+    ++cur_;
+    offset_ = 0;
+  }
+  if (cur_ >= segments_.size()) {
+    return false;
+  }
+  size_t left = std::min(segments_[cur_].size - offset_,
+                         static_cast<size_t>(std::numeric_limits<int>::max()));
+  *data = segments_[cur_].data + offset_;
+  *size = static_cast<int>(left);
+  offset_ += left;
+  byte_count_ += left;
+  return true;
+}
+
+void IOVecInputStream::BackUp(int count) {
+  offset_ -= count;
+  byte_count_ -= count;
+}
+
+bool IOVecInputStream::Skip(int count) {
+  const void* data;
+  int size;
+  while (Next(&data, &size)) {
+    if (size >= count) {
+      BackUp(size - count);
+      return true;
+    }
+    // size < count;
+    count -= size;
+  }
+  // error or we have too large count;
+  return false;
+}
+
+void DeserializeFromIOVec(const std::vector<VarIOVec::Segment>& segments,
+                          const platform::DeviceContext& ctx,
+                          framework::Variable* var, int* trainer_id) {
+  platform::RecordRPCEvent record_event("deserial");
+  ProtoVariableResponse resp(nullptr, &ctx);
+  resp.SetRecvVar(var);
+  IOVecSource source(segments);
+  PADDLE_ENFORCE_EQ(resp.Parse(&source), 0,
+                    platform::errors::InvalidArgument(
+                        "Failed to parse the segments to a variable."));
+  *trainer_id = resp.GetTrainerId();
+}
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,127 @@
+//   Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "google/protobuf/io/zero_copy_stream.h"
+#include "paddle/fluid/framework/variable.h"
+#include "paddle/fluid/operators/distributed/sendrecvop_utils.h"
+#include "paddle/fluid/operators/distributed/variable_response.h"
+#include "paddle/fluid/operators/distributed/wire_compression.h"
+#include "paddle/fluid/platform/device_context.h"
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+/*
+ * A VariableMessage serialized as the segments of its bytes, in the wire
+ * format of protobuf, for the transports which send by scatter-gather.
+ *
+ * The tensor data is referenced rather than copied, and the allocation
+ * holding it is kept until the VarIOVec is destroyed, so a transport should
+ * keep the VarIOVec until it completes sending. The header, the prefixes of
+ * the fields and the rows of SelectedRows, which can not be shared, are
+ * copied.
+ */
+class VarIOVec {
+ public:
+  struct Segment {
+    const char* data;
+    size_t size;
+  };
+
+  VarIOVec() = default;
+  VarIOVec(const VarIOVec&) = delete;
+  VarIOVec& operator=(const VarIOVec&) = delete;
+
+  // Append a copy of the bytes.
+  void Append(std::string bytes);
+  // Append the bytes of the payload, and keep its allocation.
+  void AppendReference(const TensorPayload& payload);
+
+  const std::vector<Segment>& segments() const { return segments_; }
+  // the number of the bytes of all the segments
+  size_t size() const { return size_; }
+
+  // Copy the segments to a contiguous buffer, for the transports which can
+  // not send by scatter-gather.
+  void CopyTo(std::string* buffer) const;
+
+ private:
+  std::vector<Segment> segments_;
+  // std::deque keeps the copies where they are as it grows
+  std::deque<std::string> copies_;
+  std::vector<TensorPayload> payloads_;
+  size_t size_ = 0;
+};
+
+// Serialize the var as SerializeToByteBuffer does, without copying its
+// tensor data. If compressor is not null, the tensor data of FP32 is
+// compressed by it, into a copy.
+void SerializeToIOVec(const std::string& name, framework::Variable* var,
+                      const platform::DeviceContext& ctx, VarIOVec* iov,
+                      const std::string& out_varname = std::string(),
+                      const int trainer_id = 0,
+                      const std::string& table_name = std::string(),
+                      WireCompressor* compressor = nullptr);
+
+// A ZeroCopyInputStream that reads from the segments.
+class IOVecInputStream : public ::google::protobuf::io::ZeroCopyInputStream {
+ public:
+  explicit IOVecInputStream(const std::vector<VarIOVec::Segment>& segments)
+      : segments_(segments) {}
+
+  bool Next(const void** data, int* size) override;
+  void BackUp(int count) override;
+  bool Skip(int count) override;
+  ::google::protobuf::int64 ByteCount() const override { return byte_count_; }
+
+ private:
+  const std::vector<VarIOVec::Segment>& segments_;
+  size_t cur_ = 0;     // Current segment index.
+  size_t offset_ = 0;  // Offset of the next byte in segments_[cur_].
+  ::google::protobuf::int64 byte_count_ = 0;
+};
+
+class IOVecSource : public Source {
+ public:
+  explicit IOVecSource(const std::vector<VarIOVec::Segment>& segments)
+      : segments_(segments) {}
+
+  ::google::protobuf::io::ZeroCopyInputStream* contents() override {
+    stream_.reset(new IOVecInputStream(segments_));
+    return stream_.get();
+  }
+
+ private:
+  const std::vector<VarIOVec::Segment>& segments_;
+  std::unique_ptr<IOVecInputStream> stream_;
+};
+
+// Deserialize the segments of a VariableMessage into var, whose tensors are
+// reused if they hold enough memory, so that the data is copied straight
+// from the segments into them.
+void DeserializeFromIOVec(const std::vector<VarIOVec::Segment>& segments,
+                          const platform::DeviceContext& ctx,
+                          framework::Variable* var, int* trainer_id);
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
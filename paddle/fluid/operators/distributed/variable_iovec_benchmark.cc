@@ -0,0 +1,130 @@
+//   Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Time of the serialization and the deserialization of a variable in the
+// same process, without a transport, for LoDTensor and SelectedRows of
+// several sizes. "copy" copies the serialized segments to a contiguous
+// buffer, as the transports without scatter-gather do, and deserializes
+// into a new variable each time; "iovec" deserializes from the segments,
+// which reference the tensor data, into a variable reused across the
+// messages.
+//
+// Usage:
+//   ./variable_iovec_benchmark --sizes_kb=4,256,16384 --width=64 --repeat=20
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/selected_rows.h"
+#include "paddle/fluid/operators/distributed/variable_iovec.h"
+
+DEFINE_string(sizes_kb, "4,256,16384",
+              "Sizes of the tensor data in KB, separated by commas.");
+DEFINE_int32(width, 64, "Width of the rows of SelectedRows.");
+DEFINE_int32(repeat, 20, "Times to serialize and deserialize each variable.");
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+template <typename Func>
+static double TimeMs(Func func) {
+  func();
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < FLAGS_repeat; ++i) {
+    func();
+  }
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+             .count() /
+         FLAGS_repeat;
+}
+
+static void CreateVariable(bool sparse, int64_t size_kb,
+                           framework::Variable* var) {
+  int64_t numel = (size_kb << 10) / sizeof(float);
+  framework::Tensor* tensor = nullptr;
+  if (sparse) {
+    int64_t num_rows = std::max<int64_t>(numel / FLAGS_width, 1);
+    auto* slr = var->GetMutable<framework::SelectedRows>();
+    std::vector<int64_t> rows(num_rows);
+    for (int64_t i = 0; i < num_rows; ++i) {
+      rows[i] = i * 7;
+    }
+    slr->set_rows(rows);
+    slr->set_height(num_rows * 7);
+    tensor = slr->mutable_value();
+    tensor->Resize(framework::make_ddim({num_rows, FLAGS_width}));
+  } else {
+    tensor = var->GetMutable<framework::LoDTensor>();
+    tensor->Resize(framework::make_ddim({numel}));
+  }
+  float* data = tensor->mutable_data<float>(platform::CPUPlace());
+  for (int64_t i = 0; i < tensor->numel(); ++i) {
+    data[i] = static_cast<float>(i % 1000);
+  }
+}
+
+static void RunBenchmark(bool sparse, int64_t size_kb) {
+  platform::CPUDeviceContext ctx;
+  framework::Variable var;
+  CreateVariable(sparse, size_kb, &var);
+  int trainer_id = 0;
+
+  double copy_ms = TimeMs([&] {
+    VarIOVec iov;
+    SerializeToIOVec("var", &var, ctx, &iov);
+    std::string buffer;
+    iov.CopyTo(&buffer);
+    std::vector<VarIOVec::Segment> segments{{buffer.data(), buffer.size()}};
+    framework::Variable out;
+    DeserializeFromIOVec(segments, ctx, &out, &trainer_id);
+  });
+
+  framework::Variable out;
+  double iovec_ms = TimeMs([&] {
+    VarIOVec iov;
+    SerializeToIOVec("var", &var, ctx, &iov);
+    DeserializeFromIOVec(iov.segments(), ctx, &out, &trainer_id);
+  });
+
+  std::cout << (sparse ? "SelectedRows" : "LoDTensor") << "\t" << size_kb
+            << "\t" << copy_ms << "\t" << iovec_ms << "\t"
+            << copy_ms / iovec_ms << std::endl;
+}
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+
+  std::cout << "type\tKB\tcopy ms\tiovec ms\tspeedup" << std::endl;
+  for (bool sparse : {false, true}) {
+    std::stringstream sizes(FLAGS_sizes_kb);
+    std::string size;
+    while (std::getline(sizes, size, ',')) {
+      paddle::operators::distributed::RunBenchmark(sparse, std::stoll(size));
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,156 @@
+//   Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/operators/distributed/variable_iovec.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/selected_rows.h"
+
+namespace framework = paddle::framework;
+namespace platform = paddle::platform;
+namespace distributed = paddle::operators::distributed;
+
+static void CreateLoDTensor(framework::Variable* var) {
+  auto* tensor = var->GetMutable<framework::LoDTensor>();
+  tensor->set_lod({{0, 2, 5}});
+  float* data = tensor->mutable_data<float>(framework::make_ddim({5, 31}),
+                                            platform::CPUPlace());
+  for (int64_t i = 0; i < tensor->numel(); ++i) {
+    data[i] = 0.25f * i;
+  }
+}
+
+static void CreateSelectedRows(framework::Variable* var) {
+  auto* slr = var->GetMutable<framework::SelectedRows>();
+  slr->set_height(1000);
+  slr->set_rows({7, 3, 999, 0});
+  auto* data = slr->mutable_value()->mutable_data<int64_t>(
+      framework::make_ddim({4, 9}), platform::CPUPlace());
+  for (int64_t i = 0; i < 36; ++i) {
+    data[i] = (1LL << 40) + i;
+  }
+}
+
+TEST(VarIOVec, LoDTensor) {
+  platform::CPUDeviceContext ctx;
+  distributed::VarIOVec iov;
+  const float* data = nullptr;
+  {
+    framework::Variable var;
+    CreateLoDTensor(&var);
+    data = var.Get<framework::LoDTensor>().data<float>();
+    distributed::SerializeToIOVec("x", &var, ctx, &iov, "out", 3);
+  }
+  // the header, and the data referenced, which outlives the var
+  ASSERT_EQ(iov.segments().size(), 2UL);
+  ASSERT_EQ(iov.segments()[1].data, reinterpret_cast<const char*>(data));
+  ASSERT_EQ(iov.segments()[1].size, 5 * 31 * sizeof(float));
+
+  // the bytes are a VariableMessage
+  std::string buffer;
+  iov.CopyTo(&buffer);
+  ASSERT_EQ(buffer.size(), iov.size());
+  sendrecv::VariableMessage msg;
+  ASSERT_TRUE(msg.ParseFromString(buffer));
+  EXPECT_EQ(msg.varname(), "x");
+  EXPECT_EQ(msg.out_varname(), "out");
+  EXPECT_EQ(msg.trainer_id(), 3);
+  EXPECT_EQ(msg.lod_level(), 1);
+  ASSERT_EQ(msg.serialized().size(), 5 * 31 * sizeof(float));
+
+  framework::Variable expected;
+  CreateLoDTensor(&expected);
+  auto& expected_tensor = expected.Get<framework::LoDTensor>();
+  framework::Variable out;
+  int trainer_id = 0;
+  distributed::DeserializeFromIOVec(iov.segments(), ctx, &out, &trainer_id);
+  EXPECT_EQ(trainer_id, 3);
+  auto& tensor = out.Get<framework::LoDTensor>();
+  ASSERT_EQ(tensor.dims(), expected_tensor.dims());
+  ASSERT_EQ(tensor.lod(), expected_tensor.lod());
+  for (int64_t i = 0; i < tensor.numel(); ++i) {
+    ASSERT_EQ(tensor.data<float>()[i], expected_tensor.data<float>()[i]);
+  }
+}
+
+TEST(VarIOVec, SelectedRows) {
+  platform::CPUDeviceContext ctx;
+  framework::Variable var;
+  CreateSelectedRows(&var);
+  distributed::VarIOVec iov;
+  distributed::SerializeToIOVec("w@GRAD", &var, ctx, &iov);
+  ASSERT_EQ(iov.segments().size(), 3UL);
+
+  // the segments of several bytes each are read in pieces
+  std::string buffer;
+  iov.CopyTo(&buffer);
+  std::vector<distributed::VarIOVec::Segment> pieces;
+  for (size_t i = 0; i < buffer.size(); i += 5) {
+    pieces.push_back(
+        {buffer.data() + i, std::min<size_t>(5, buffer.size() - i)});
+  }
+  auto check = [&](
+      const std::vector<distributed::VarIOVec::Segment>& segments) {
+    framework::Variable out;
+    int trainer_id = -1;
+    distributed::DeserializeFromIOVec(segments, ctx, &out, &trainer_id);
+    EXPECT_EQ(trainer_id, 0);
+    auto& slr = out.Get<framework::SelectedRows>();
+    auto& expected = var.Get<framework::SelectedRows>();
+    ASSERT_EQ(slr.height(), expected.height());
+    ASSERT_EQ(slr.rows(), expected.rows());
+    ASSERT_EQ(slr.value().dims(), expected.value().dims());
+    ASSERT_EQ(slr.value().type(), framework::proto::VarType::INT64);
+    for (int64_t i = 0; i < slr.value().numel(); ++i) {
+      ASSERT_EQ(slr.value().data<int64_t>()[i],
+                expected.value().data<int64_t>()[i]);
+    }
+  };
+  check(iov.segments());
+  check(pieces);
+
+  // truncated
+  pieces.pop_back();
+  framework::Variable out;
+  int trainer_id = 0;
+  ASSERT_THROW(
+      distributed::DeserializeFromIOVec(pieces, ctx, &out, &trainer_id),
+      paddle::platform::EnforceNotMet);
+}
+
+TEST(VarIOVec, PreallocatedDestination) {
+  platform::CPUDeviceContext ctx;
+  framework::Variable var;
+  CreateLoDTensor(&var);
+  distributed::VarIOVec iov;
+  distributed::SerializeToIOVec("x", &var, ctx, &iov);
+
+  // the destination holds more memory than the data needs, which is reused
+  framework::Variable out;
+  float* dest = out.GetMutable<framework::LoDTensor>()->mutable_data<float>(
+      framework::make_ddim({1024}), platform::CPUPlace());
+  int trainer_id = 0;
+  for (int i = 0; i < 2; ++i) {
+    distributed::DeserializeFromIOVec(iov.segments(), ctx, &out, &trainer_id);
+    auto& tensor = out.Get<framework::LoDTensor>();
+    ASSERT_EQ(tensor.data<float>(), dest);
+    ASSERT_EQ(tensor.dims(), framework::make_ddim({5, 31}));
+    ASSERT_EQ(tensor.data<float>()[17], 0.25f * 17);
+  }
+}
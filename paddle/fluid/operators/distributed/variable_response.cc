@@ -13,8 +13,11 @@
 // limitations under the License.
 
 #include "paddle/fluid/operators/distributed/variable_response.h"
+#include <string>
 #include <vector>
+#include "paddle/fluid/framework/tensor_util.h"
 #include "paddle/fluid/operators/distributed/sendrecvop_utils.h"
+#include "paddle/fluid/operators/distributed/wire_compression.h"
 
 DEFINE_string(rpc_server_profile_path, "./profile_ps",
               "the profile log file path");
@@ -91,6 +94,40 @@ bool VariableResponse::ReadRaw(::google::protobuf::io::CodedInputStream* input,
   return true;
 }
 
+bool VariableResponse::ReadCompressed(
+    ::google::protobuf::io::CodedInputStream* input,
+    const platform::DeviceContext& ctx, const framework::DDim& dims,
+    framework::Tensor* tensor, int length) {
+  PADDLE_ENFORCE_EQ(meta_.data_type(), sendrecv::VariableMessage::FP32,
+                    platform::errors::InvalidArgument(
+                        "Only the tensor data of FP32 can be compressed."));
+  std::string compressed(length, '\0');
+  platform::CPUPlace cpu;
+  if (!ReadRaw(input, ctx, cpu, &compressed[0], length)) {
+    return false;
+  }
+
+  // the data is decompressed on CPU, and copied to the GPU tensor
+  framework::Tensor cpu_tensor;
+  framework::Tensor* dest =
+      platform::is_gpu_place(ctx.GetPlace()) ? &cpu_tensor : tensor;
+  dest->Resize(dims);
+  float* data = dest->mutable_data<float>(cpu);
+  int64_t num_rows = 0;
+  int64_t width = 0;
+  WireCompressionRows(dims, &num_rows, &width);
+  if (!WireDecompress(meta_.compression(), compressed.data(),
+                      compressed.size(), num_rows, width, data)) {
+    LOG(ERROR) << "the size of the compressed data of " << meta_.varname()
+               << " is " << length << ", which does not match dims " << dims;
+    return false;
+  }
+  if (dest != tensor) {
+    framework::TensorCopySync(cpu_tensor, ctx.GetPlace(), tensor);
+  }
+  return true;
+}
+
 bool VariableResponse::CopyLodTensorData(
     ::google::protobuf::io::CodedInputStream* input,
     const platform::DeviceContext& ctx, const framework::DDim& dims,
@@ -113,6 +150,10 @@ bool VariableResponse::CopyLodTensorData(
   }
   tensor->set_lod(lod);
 
+  if (meta_.compression() != sendrecv::VariableMessage::NO_COMPRESSION) {
+    return ReadCompressed(input, ctx, dims, tensor, length);
+  }
+
   void* tensor_data =
       tensor->mutable_data(ctx.GetPlace(), ToVarType(meta_.data_type()));
 
@@ -140,6 +181,9 @@ bool VariableResponse::CopySelectRowsTensorData(
   slr->set_height(meta_.slr_height());
   auto* tensor = slr->mutable_value();
   tensor->Resize(dims);
+  if (meta_.compression() != sendrecv::VariableMessage::NO_COMPRESSION) {
+    return ReadCompressed(input, ctx, dims, tensor, length);
+  }
   PADDLE_ENFORCE_EQ(
       static_cast<size_t>(tensor->numel()),
       length / framework::SizeOfType(paddle::operators::distributed::ToVarType(
@@ -183,7 +227,8 @@ bool VariableResponse::ProcSerializedField(
 
   if (meta_.type() == sendrecv::NCCL_ID) {
 #ifdef PADDLE_WITH_CUDA
-    auto* var = scope_->FindVar(meta_.varname());
+    auto* var = recv_var_ != nullptr ? recv_var_
+                                     : scope_->FindVar(meta_.varname());
     if (var != nullptr) {
       ncclUniqueId* id = var->GetMutable<ncclUniqueId>();
       if (!ReadRaw(input, *dev_ctx_, platform::CPUPlace(), id->internal,
@@ -88,8 +88,16 @@ class VariableResponse {
   inline std::string OutVarname() const { return meta_.out_varname(); }
   inline std::string TableName() const { return meta_.table_name(); }
 
+  // Set the var to deserialize into in place of the var of the name in the
+  // scope, so that the data is copied into the memory the var holds, if it
+  // is large enough, rather than into the memory newly allocated.
+  void SetRecvVar(framework::Variable* var) { recv_var_ = var; }
+
   // should call parse first.
   framework::Variable* GetVar() {
+    if (recv_var_ != nullptr) {
+      return recv_var_;
+    }
     if (create_scope_) {
       return local_scope_->Var(meta_.varname());
     }
@@ -103,6 +111,13 @@ class VariableResponse {
                const platform::DeviceContext& dev_ctx, platform::Place place,
                void* dest, int64_t size);
 
+  // Read the tensor data compressed by meta_.compression, and decompress it
+  // to the FP32 tensor of the dims.
+  bool ReadCompressed(::google::protobuf::io::CodedInputStream* input,
+                      const platform::DeviceContext& ctx,
+                      const framework::DDim& dims, framework::Tensor* tensor,
+                      int length);
+
   bool CopySelectRowsTensorData(::google::protobuf::io::CodedInputStream* input,
                                 const platform::DeviceContext& ctx,
                                 const framework::DDim& dims, int length);
@@ -123,6 +138,7 @@ class VariableResponse {
   const platform::DeviceContext* dev_ctx_;
   bool create_scope_ = false;
   framework::Scope* local_scope_ = nullptr;
+  framework::Variable* recv_var_ = nullptr;
 
   sendrecv::VariableMessage meta_;
 };
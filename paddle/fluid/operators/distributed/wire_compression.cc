@@ -0,0 +1,263 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/distributed/wire_compression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/platform/float16.h"
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+using VarMsg = sendrecv::VariableMessage;
+
+WireCompressionType ParseWireCompression(const std::string& name) {
+  if (name.empty() || name == "none") {
+    return VarMsg::NO_COMPRESSION;
+  } else if (name == "fp16") {
+    return VarMsg::FP16_COMPRESSION;
+  } else if (name == "int8") {
+    return VarMsg::INT8_COMPRESSION;
+  }
+  PADDLE_THROW(platform::errors::InvalidArgument(
+      "The wire compression should be none, fp16 or int8, but got %s.",
+      name));
+}
+
+void WireCompressionRows(const framework::DDim& dims, int64_t* num_rows,
+                         int64_t* width) {
+  int64_t numel = framework::product(dims);
+  if (dims.size() >= 2 && dims[0] > 0) {
+    *num_rows = dims[0];
+    *width = numel / dims[0];
+  } else {
+    *num_rows = 1;
+    *width = numel;
+  }
+}
+
+size_t WireCompressedSize(WireCompressionType type, int64_t num_rows,
+                          int64_t width) {
+  size_t numel = static_cast<size_t>(num_rows * width);
+  switch (type) {
+    case VarMsg::NO_COMPRESSION:
+      return numel * sizeof(float);
+    case VarMsg::FP16_COMPRESSION:
+      return numel * sizeof(platform::float16);
+    case VarMsg::INT8_COMPRESSION:
+      return num_rows * sizeof(float) + numel * sizeof(int8_t);
+    default:
+      PADDLE_THROW(platform::errors::Unimplemented(
+          "Unknown wire compression %d.", static_cast<int>(type)));
+  }
+}
+
+// Encode the rows to out, and the rows decoded from it to decoded, which
+// may be nullptr.
+static void Encode(WireCompressionType type, const float* values,
+                   int64_t num_rows, int64_t width, char* out,
+                   float* decoded) {
+  int64_t numel = num_rows * width;
+  if (type == VarMsg::FP16_COMPRESSION) {
+    auto* halves = reinterpret_cast<platform::float16*>(out);
+    for (int64_t i = 0; i < numel; ++i) {
+      halves[i] = static_cast<platform::float16>(values[i]);
+    }
+    if (decoded != nullptr) {
+      for (int64_t i = 0; i < numel; ++i) {
+        decoded[i] = static_cast<float>(halves[i]);
+      }
+    }
+    return;
+  }
+
+  // the scales may be unaligned in out
+  auto* quantized = reinterpret_cast<int8_t*>(out + num_rows * sizeof(float));
+  for (int64_t r = 0; r < num_rows; ++r) {
+    const float* row = values + r * width;
+    float max_abs = 0;
+    for (int64_t j = 0; j < width; ++j) {
+      max_abs = std::max(max_abs, std::fabs(row[j]));
+    }
+    float scale = max_abs / 127.0f;
+    float inv_scale = scale > 0 ? 1.0f / scale : 0.0f;
+    std::memcpy(out + r * sizeof(float), &scale, sizeof(float));
+    int8_t* q = quantized + r * width;
+    for (int64_t j = 0; j < width; ++j) {
+      float v = std::round(row[j] * inv_scale);
+      q[j] = static_cast<int8_t>(std::min(127.0f, std::max(-127.0f, v)));
+    }
+    if (decoded != nullptr) {
+      for (int64_t j = 0; j < width; ++j) {
+        decoded[r * width + j] = q[j] * scale;
+      }
+    }
+  }
+}
+
+bool WireDecompress(WireCompressionType type, const char* data, size_t size,
+                    int64_t num_rows, int64_t width, float* out) {
+  if (size != WireCompressedSize(type, num_rows, width)) {
+    return false;
+  }
+  int64_t numel = num_rows * width;
+  if (type == VarMsg::NO_COMPRESSION) {
+    std::memcpy(out, data, size);
+  } else if (type == VarMsg::FP16_COMPRESSION) {
+    const auto* halves = reinterpret_cast<const platform::float16*>(data);
+    for (int64_t i = 0; i < numel; ++i) {
+      out[i] = static_cast<float>(halves[i]);
+    }
+  } else {
+    const auto* quantized =
+        reinterpret_cast<const int8_t*>(data + num_rows * sizeof(float));
+    for (int64_t r = 0; r < num_rows; ++r) {
+      float scale;
+      std::memcpy(&scale, data + r * sizeof(float), sizeof(float));
+      const int8_t* q = quantized + r * width;
+      for (int64_t j = 0; j < width; ++j) {
+        out[r * width + j] = q[j] * scale;
+      }
+    }
+  }
+  return true;
+}
+
+WireCompressor::WireCompressor(WireCompressionType type, bool error_feedback)
+    : type_(type), error_feedback_(error_feedback) {
+  PADDLE_ENFORCE_NE(type, VarMsg::NO_COMPRESSION,
+                    platform::errors::InvalidArgument(
+                        "WireCompressor needs a compression."));
+}
+
+int64_t WireCompressor::ResidualIndex(int64_t id, int64_t width) {
+  int64_t index = residual_index_.Find(id);
+  if (index < 0) {
+    index = static_cast<int64_t>(residual_index_.size());
+    residual_index_.Insert(id, index);
+    residual_.resize(residual_.size() + width, 0.0f);
+  }
+  return index;
+}
+
+void WireCompressor::Compress(const float* values, int64_t num_rows,
+                              int64_t width, const int64_t* ids,
+                              std::string* out) {
+  out->resize(WireCompressedSize(type_, num_rows, width));
+  if (!error_feedback_) {
+    Encode(type_, values, num_rows, width, &(*out)[0], nullptr);
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (width != width_) {
+    // the residual of another width is of no use, which happens only if the
+    // name is reused for another variable
+    residual_index_.Clear();
+    residual_.clear();
+    width_ = width;
+  }
+  int64_t numel = num_rows * width;
+  compensated_.resize(numel);
+  decoded_.resize(numel);
+  // the indexes are all found before the residual is read, since it grows
+  // for the new ids
+  std::vector<int64_t> indexes(num_rows);
+  for (int64_t r = 0; r < num_rows; ++r) {
+    indexes[r] = ResidualIndex(ids == nullptr ? r : ids[r], width);
+  }
+  std::vector<float*> residuals(num_rows);
+  for (int64_t r = 0; r < num_rows; ++r) {
+    residuals[r] = residual_.data() + indexes[r] * width;
+  }
+  for (int64_t r = 0; r < num_rows; ++r) {
+    const float* row = values + r * width;
+    float* compensated = compensated_.data() + r * width;
+    for (int64_t j = 0; j < width; ++j) {
+      compensated[j] = row[j] + residuals[r][j];
+    }
+  }
+  Encode(type_, compensated_.data(), num_rows, width, &(*out)[0],
+         decoded_.data());
+  for (int64_t r = 0; r < num_rows; ++r) {
+    const float* compensated = compensated_.data() + r * width;
+    const float* row = decoded_.data() + r * width;
+    for (int64_t j = 0; j < width; ++j) {
+      residuals[r][j] = compensated[j] - row[j];
+    }
+  }
+}
+
+std::unique_ptr<WireCompressor> CreateReplyCompressor(
+    WireCompressionType requested) {
+  if (requested == VarMsg::NO_COMPRESSION) {
+    return nullptr;
+  }
+  return std::unique_ptr<WireCompressor>(new WireCompressor(requested, false));
+}
+
+WireCompression& WireCompression::Instance() {
+  static WireCompression instance;
+  return instance;
+}
+
+void WireCompression::SetSendVar(const std::string& name,
+                                 WireCompressionType type,
+                                 bool error_feedback) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (type == VarMsg::NO_COMPRESSION) {
+    send_compressors_.erase(name);
+  } else {
+    send_compressors_[name] =
+        std::make_shared<WireCompressor>(type, error_feedback);
+  }
+}
+
+void WireCompression::SetRecvVar(const std::string& name,
+                                 WireCompressionType type) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (type == VarMsg::NO_COMPRESSION) {
+    recv_compressions_.erase(name);
+  } else {
+    recv_compressions_[name] = type;
+  }
+}
+
+std::shared_ptr<WireCompressor> WireCompression::SendCompressor(
+    const std::string& name) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = send_compressors_.find(name);
+  return it == send_compressors_.end() ? nullptr : it->second;
+}
+
+WireCompressionType WireCompression::RecvCompression(const std::string& name) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = recv_compressions_.find(name);
+  return it == recv_compressions_.end() ? VarMsg::NO_COMPRESSION : it->second;
+}
+
+void WireCompression::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  send_compressors_.clear();
+  recv_compressions_.clear();
+}
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
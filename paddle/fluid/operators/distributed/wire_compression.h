@@ -0,0 +1,146 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "paddle/fluid/framework/ddim.h"
+#include "paddle/fluid/framework/sparse_row_index.h"
+#include "paddle/fluid/operators/distributed/distributed_pb.h"
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+typedef sendrecv::VariableMessage::Compression WireCompressionType;
+
+/*
+ * @brief Parse "none", "fp16" or "int8" to the compression.
+ */
+WireCompressionType ParseWireCompression(const std::string& name);
+
+/*
+ * @brief The rows of a tensor of the dims, which are scaled separately by
+ * INT8_COMPRESSION: the first dim, or a single row for a tensor of rank 1.
+ */
+void WireCompressionRows(const framework::DDim& dims, int64_t* num_rows,
+                         int64_t* width);
+
+/*
+ * @return the number of the bytes of the rows compressed by the compression.
+ */
+size_t WireCompressedSize(WireCompressionType type, int64_t num_rows,
+                          int64_t width);
+
+/*
+ * @brief Decompress the size bytes of the rows to out, which holds
+ * num_rows * width floats.
+ *
+ * @return false if the size does not match the rows.
+ */
+bool WireDecompress(WireCompressionType type, const char* data, size_t size,
+                    int64_t num_rows, int64_t width, float* out);
+
+/*
+ * @brief Compresses the FP32 tensor data of a variable sent to a pserver.
+ *
+ * With error feedback, the error of the compression of each row, which is
+ * the row minus the row decompressed, is kept and added to the row of the
+ * same id before the next compression, so that the error does not
+ * accumulate in the parameter over the sends. The ids of the rows are those
+ * of the SelectedRows, or the indexes of the rows of a LoDTensor.
+ */
+class WireCompressor {
+ public:
+  WireCompressor(WireCompressionType type, bool error_feedback);
+
+  WireCompressionType type() const { return type_; }
+  bool error_feedback() const { return error_feedback_; }
+
+  /*
+   * @brief Compress the num_rows rows of width floats to out.
+   * @param ids the ids of the rows, or nullptr for 0 to num_rows - 1.
+   */
+  void Compress(const float* values, int64_t num_rows, int64_t width,
+                const int64_t* ids, std::string* out);
+
+ private:
+  // the index of the residual of the row of the id in residual_, which is
+  // zeros for a new id
+  int64_t ResidualIndex(int64_t id, int64_t width);
+
+  const WireCompressionType type_;
+  const bool error_feedback_;
+  std::mutex mutex_;
+  int64_t width_ = 0;
+  framework::SparseRowIndex residual_index_;
+  std::vector<float> residual_;
+  // the rows compensated by the residual, and them decoded after the
+  // compression, whose difference is the next residual
+  std::vector<float> compensated_;
+  std::vector<float> decoded_;
+};
+
+/*
+ * @brief The compressor of the reply to a GetVariable request, which
+ * requested the compression, or nullptr for NO_COMPRESSION.
+ */
+std::unique_ptr<WireCompressor> CreateReplyCompressor(
+    WireCompressionType requested);
+
+/*
+ * @brief The compression of the variables a trainer sends and receives,
+ * by the names they are sent as and received into, which the RPC clients
+ * look up.
+ *
+ * The compression of a received variable is requested of the pserver in
+ * the GetVariable request, and the pserver compresses the reply without
+ * error feedback, since it sends the values of the parameter rather than
+ * their updates.
+ */
+class WireCompression {
+ public:
+  static WireCompression& Instance();
+
+  void SetSendVar(const std::string& name, WireCompressionType type,
+                  bool error_feedback);
+  void SetRecvVar(const std::string& name, WireCompressionType type);
+
+  /*
+   * @return the compressor of the sent variable, or nullptr if it is not
+   * compressed.
+   */
+  std::shared_ptr<WireCompressor> SendCompressor(const std::string& name);
+  WireCompressionType RecvCompression(const std::string& name);
+
+  void Clear();
+
+ private:
+  WireCompression() = default;
+
+  std::mutex mutex_;
+  std::unordered_map<std::string, std::shared_ptr<WireCompressor>>
+      send_compressors_;
+  std::unordered_map<std::string, WireCompressionType> recv_compressions_;
+};
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
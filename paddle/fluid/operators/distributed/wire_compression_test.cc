@@ -0,0 +1,241 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/distributed/wire_compression.h"
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/selected_rows.h"
+#include "paddle/fluid/operators/distributed/variable_iovec.h"
+
+namespace framework = paddle::framework;
+namespace platform = paddle::platform;
+namespace distributed = paddle::operators::distributed;
+using VarMsg = sendrecv::VariableMessage;
+
+TEST(WireCompression, Codec) {
+  std::mt19937 engine(0);
+  std::normal_distribution<float> normal(0, 1);
+  const int64_t num_rows = 8;
+  const int64_t width = 100;
+  std::vector<float> values(num_rows * width);
+  for (auto& v : values) {
+    v = normal(engine);
+  }
+  // a row of zeros
+  std::fill(values.begin(), values.begin() + width, 0.0f);
+
+  for (auto type : {VarMsg::FP16_COMPRESSION, VarMsg::INT8_COMPRESSION}) {
+    distributed::WireCompressor compressor(type, false);
+    std::string compressed;
+    compressor.Compress(values.data(), num_rows, width, nullptr, &compressed);
+    ASSERT_EQ(compressed.size(),
+              distributed::WireCompressedSize(type, num_rows, width));
+    std::vector<float> out(values.size());
+    ASSERT_TRUE(distributed::WireDecompress(type, compressed.data(),
+                                            compressed.size(), num_rows, width,
+                                            out.data()));
+    for (int64_t r = 0; r < num_rows; ++r) {
+      float max_abs = 0;
+      for (int64_t j = 0; j < width; ++j) {
+        max_abs = std::max(max_abs, std::fabs(values[r * width + j]));
+      }
+      float bound = type == VarMsg::FP16_COMPRESSION ? max_abs / 1024
+                                                     : max_abs / 254 + 1e-6f;
+      for (int64_t j = 0; j < width; ++j) {
+        ASSERT_NEAR(out[r * width + j], values[r * width + j], bound);
+      }
+    }
+    ASSERT_FALSE(distributed::WireDecompress(type, compressed.data(),
+                                             compressed.size() - 1, num_rows,
+                                             width, out.data()));
+  }
+  EXPECT_EQ(distributed::ParseWireCompression("int8"),
+            VarMsg::INT8_COMPRESSION);
+  EXPECT_THROW(distributed::ParseWireCompression("int4"),
+               paddle::platform::EnforceNotMet);
+}
+
+// The sum of the rows decompressed over the sends follows the sum of the
+// rows sent, by the rows ids, when the error is fed back.
+TEST(WireCompression, ErrorFeedback) {
+  const int64_t width = 16;
+  distributed::WireCompressor with_feedback(VarMsg::INT8_COMPRESSION, true);
+  distributed::WireCompressor without_feedback(VarMsg::INT8_COMPRESSION,
+                                               false);
+  std::vector<double> sent(2 * width, 0), with(2 * width, 0),
+      without(2 * width, 0);
+  std::vector<int64_t> ids = {1000, 7};
+  for (int step = 0; step < 200; ++step) {
+    // a large value in each row, so that the small ones are rounded to zero
+    std::vector<float> values(2 * width, 0.003f);
+    values[0] = values[width] = 1.0f;
+    std::swap(ids[0], ids[1]);
+    std::string compressed;
+    std::vector<float> out(values.size());
+    for (auto* compressor : {&with_feedback, &without_feedback}) {
+      compressor->Compress(values.data(), 2, width, ids.data(), &compressed);
+      ASSERT_TRUE(distributed::WireDecompress(
+          VarMsg::INT8_COMPRESSION, compressed.data(), compressed.size(), 2,
+          width, out.data()));
+      auto& sum = compressor == &with_feedback ? with : without;
+      for (int64_t r = 0; r < 2; ++r) {
+        int64_t slot = ids[r] == 7 ? 0 : 1;
+        for (int64_t j = 0; j < width; ++j) {
+          sum[slot * width + j] += out[r * width + j];
+        }
+      }
+    }
+    for (size_t i = 0; i < sent.size(); ++i) {
+      sent[i] += values[i];
+    }
+  }
+  // the small values are all lost without error feedback
+  EXPECT_EQ(without[1], 0.0);
+  for (size_t i = 0; i < sent.size(); ++i) {
+    EXPECT_NEAR(with[i], sent[i], 1.0 / 254);
+  }
+}
+
+// Send var by SerializeToIOVec, and receive it by DeserializeFromIOVec.
+static size_t Loopback(const std::string& name, framework::Variable* var,
+                       distributed::WireCompressor* compressor,
+                       framework::Variable* out) {
+  platform::CPUDeviceContext ctx;
+  distributed::VarIOVec iov;
+  distributed::SerializeToIOVec(name, var, ctx, &iov, "", 0, "", compressor);
+  int trainer_id = 0;
+  distributed::DeserializeFromIOVec(iov.segments(), ctx, out, &trainer_id);
+  return iov.size();
+}
+
+TEST(WireCompression, SelectedRowsLoopback) {
+  framework::Variable var;
+  auto* slr = var.GetMutable<framework::SelectedRows>();
+  slr->set_height(100);
+  slr->set_rows({3, 50, 99});
+  float* data = slr->mutable_value()->mutable_data<float>(
+      framework::make_ddim({3, 4}), platform::CPUPlace());
+  for (int i = 0; i < 12; ++i) {
+    data[i] = 0.5f * i - 2;
+  }
+  distributed::WireCompressor compressor(VarMsg::FP16_COMPRESSION, true);
+  framework::Variable out;
+  Loopback("w@GRAD", &var, &compressor, &out);
+  auto& out_slr = out.Get<framework::SelectedRows>();
+  EXPECT_EQ(out_slr.height(), 100);
+  EXPECT_EQ(out_slr.rows(), slr->rows());
+  ASSERT_EQ(out_slr.value().dims(), framework::make_ddim({3, 4}));
+  for (int i = 0; i < 12; ++i) {
+    // exact in float16
+    EXPECT_EQ(out_slr.value().data<float>()[i], data[i]);
+  }
+}
+
+struct TrainResult {
+  double loss = 0;
+  size_t bytes = 0;
+};
+
+// Train a linear regression on a pserver in the same process, which the
+// trainer gets the parameter from and sends the gradients to by loopback.
+static TrainResult Train(VarMsg::Compression send, VarMsg::Compression recv,
+                         bool error_feedback) {
+  const int64_t dim = 64;
+  const int64_t batch = 32;
+  const int steps = 300;
+  const float lr = 0.05f;
+  std::mt19937 engine(0);
+  std::normal_distribution<float> normal(0, 1);
+  std::vector<float> target(dim);
+  for (auto& v : target) {
+    v = normal(engine);
+  }
+
+  framework::Variable server_param;
+  float* param = server_param.GetMutable<framework::LoDTensor>()
+                     ->mutable_data<float>(framework::make_ddim({dim}),
+                                           platform::CPUPlace());
+  std::fill(param, param + dim, 0.0f);
+  std::unique_ptr<distributed::WireCompressor> send_compressor;
+  if (send != VarMsg::NO_COMPRESSION) {
+    send_compressor.reset(
+        new distributed::WireCompressor(send, error_feedback));
+  }
+  auto recv_compressor = distributed::CreateReplyCompressor(recv);
+
+  TrainResult result;
+  framework::Variable trainer_param, grad, server_grad;
+  float* g = grad.GetMutable<framework::LoDTensor>()->mutable_data<float>(
+      framework::make_ddim({dim}), platform::CPUPlace());
+  std::vector<float> x(batch * dim), y(batch);
+  for (int step = 0; step < steps; ++step) {
+    result.bytes += Loopback("w", &server_param, recv_compressor.get(),
+                             &trainer_param);
+    const float* w = trainer_param.Get<framework::LoDTensor>().data<float>();
+    std::fill(g, g + dim, 0.0f);
+    for (int64_t b = 0; b < batch; ++b) {
+      float pred = 0;
+      y[b] = 0;
+      for (int64_t i = 0; i < dim; ++i) {
+        x[b * dim + i] = normal(engine);
+        pred += x[b * dim + i] * w[i];
+        y[b] += x[b * dim + i] * target[i];
+      }
+      for (int64_t i = 0; i < dim; ++i) {
+        g[i] += 2 * (pred - y[b]) * x[b * dim + i] / batch;
+      }
+    }
+    result.bytes +=
+        Loopback("w@GRAD", &grad, send_compressor.get(), &server_grad);
+    const float* sg = server_grad.Get<framework::LoDTensor>().data<float>();
+    for (int64_t i = 0; i < dim; ++i) {
+      param[i] -= lr * sg[i];
+    }
+  }
+  for (int64_t i = 0; i < dim; ++i) {
+    result.loss += (param[i] - target[i]) * (param[i] - target[i]);
+  }
+  return result;
+}
+
+TEST(WireCompression, ConvergenceParity) {
+  auto fp32 = Train(VarMsg::NO_COMPRESSION, VarMsg::NO_COMPRESSION, false);
+  auto fp16 = Train(VarMsg::FP16_COMPRESSION, VarMsg::FP16_COMPRESSION, true);
+  auto int8 = Train(VarMsg::INT8_COMPRESSION, VarMsg::INT8_COMPRESSION, true);
+  auto int8_no_feedback =
+      Train(VarMsg::INT8_COMPRESSION, VarMsg::NO_COMPRESSION, false);
+  std::cout << "compression\tbytes on wire\tdistance to target" << std::endl;
+  std::cout << "none\t" << fp32.bytes << "\t" << fp32.loss << std::endl;
+  std::cout << "fp16\t" << fp16.bytes << "\t" << fp16.loss << std::endl;
+  std::cout << "int8\t" << int8.bytes << "\t" << int8.loss << std::endl;
+  std::cout << "int8 gradients without feedback\t" << int8_no_feedback.bytes
+            << "\t" << int8_no_feedback.loss << std::endl;
+
+  // the headers are not compressed
+  EXPECT_LT(fp16.bytes, fp32.bytes * 0.6);
+  EXPECT_LT(int8.bytes, fp32.bytes * 0.35);
+  EXPECT_LT(fp32.loss, 1e-3);
+  EXPECT_LT(fp16.loss, 1e-3);
+  // the parameter received in int8 has its own error, which the gradients
+  // correct towards
+  EXPECT_LT(int8.loss, 1e-2);
+  EXPECT_LT(int8_no_feedback.loss, 1e-2);
+}
@@ -59,6 +59,16 @@ class LoadCombineOpProtoMaker : public framework::OpProtoAndCheckerMaker {
                   "If true, file_path is in memory, and LoDTensors will be "
                   "loaded directly from memory")
         .SetDefault(false);
+    AddAttr<bool>("use_mmap",
+                  "(boolean, default false)"
+                  "If true, the large LoDTensors of a checkpoint saved by "
+                  "save_combine with with_offset_index will be mapped from "
+                  "the file by copy-on-write instead of being read. Only "
+                  "used on CPU. The file must not be modified in place while "
+                  "the tensors are mapped from it, since the pages not yet "
+                  "written to by the tensors are read from the file; "
+                  "save_combine replaces the file instead.")
+        .SetDefault(false);
     AddComment(R"DOC(
 LoadCombine Operator.
 
@@ -71,6 +81,10 @@ in the SaveCombine operator. Hence, the LoadCombine operator is tightly coupled
 with the SaveCombine operator, and can only deserialize one or more LoDTensors
 that were saved using the SaveCombine operator.
 
+The files saved by the SaveCombine operator with with_offset_index are loaded
+by the index of the offsets of the LoDTensors, which are read in parallel, or
+mapped from the file if use_mmap is true.
+
 )DOC");
   }
 };
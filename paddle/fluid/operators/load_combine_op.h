@@ -21,6 +21,8 @@ limitations under the License. */
 #include "paddle/fluid/framework/data_type.h"
 #include "paddle/fluid/framework/data_type_transform.h"
 #include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/framework/tensor_checkpoint.h"
+#include "paddle/fluid/framework/tensor_util.h"
 #include "paddle/fluid/platform/device_context.h"
 
 namespace paddle {
@@ -33,6 +35,7 @@ class LoadCombineOpKernel : public framework::OpKernel<T> {
     auto filename = ctx.Attr<std::string>("file_path");
     auto load_as_fp16 = ctx.Attr<bool>("load_as_fp16");
     auto model_from_memory = ctx.Attr<bool>("model_from_memory");
+    auto use_mmap = ctx.Attr<bool>("use_mmap");
     auto out_var_names = ctx.OutputNames("Out");
 
     PADDLE_ENFORCE_GT(out_var_names.size(), 0UL,
@@ -41,6 +44,11 @@ class LoadCombineOpKernel : public framework::OpKernel<T> {
                           "it to be greater than 0.",
                           out_var_names.size()));
     if (!model_from_memory) {
+      if (framework::IsCheckpointFile(filename)) {
+        LoadParamsFromCheckpoint(ctx, place, filename, false, use_mmap,
+                                 load_as_fp16, out_var_names);
+        return;
+      }
       std::ifstream fin(filename, std::ios::binary);
       PADDLE_ENFORCE_EQ(
           static_cast<bool>(fin), true,
@@ -56,6 +64,11 @@ class LoadCombineOpKernel : public framework::OpKernel<T> {
               "LoadCombine operator fails to open file %s, please check "
               "whether the model file is complete or damaged.",
               filename));
+      if (framework::IsCheckpoint(filename.data(), filename.size())) {
+        LoadParamsFromCheckpoint(ctx, place, filename, true, false,
+                                 load_as_fp16, out_var_names);
+        return;
+      }
       std::stringstream fin(filename, std::ios::in | std::ios::binary);
       LoadParamsFromBuffer(ctx, place, &fin, load_as_fp16, out_var_names);
     }
@@ -87,26 +100,7 @@ class LoadCombineOpKernel : public framework::OpKernel<T> {
       // Get data from fin to tensor
       DeserializeFromStream(*buffer, tensor, dev_ctx);
 
-      auto in_dtype = tensor->type();
-      auto out_dtype =
-          load_as_fp16 ? framework::proto::VarType::FP16 : in_dtype;
-
-      if (in_dtype != out_dtype) {
-        // convert to float16 tensor
-        auto in_kernel_type = framework::OpKernelType(in_dtype, place);
-        auto out_kernel_type = framework::OpKernelType(out_dtype, place);
-        framework::LoDTensor fp16_tensor;
-        // copy LoD info to the new tensor
-        fp16_tensor.set_lod(tensor->lod());
-        framework::TransDataType(in_kernel_type, out_kernel_type, *tensor,
-                                 &fp16_tensor);
-
-        // reset output tensor
-        out_vars[i]->Clear();
-        tensor = out_vars[i]->GetMutable<framework::LoDTensor>();
-        tensor->set_lod(fp16_tensor.lod());
-        tensor->ShareDataWith(fp16_tensor);
-      }
+      CastToFP16(place, load_as_fp16, out_vars[i]);
     }
     buffer->peek();
     PADDLE_ENFORCE_EQ(buffer->eof(), true,
@@ -114,6 +108,69 @@ class LoadCombineOpKernel : public framework::OpKernel<T> {
                           "Not allowed to load partial data via "
                           "load_combine_op, please use load_op instead."));
   }
+
+  // Load the tensors from a checkpoint saved with the offset index, which is
+  // the file path, or the checkpoint itself if from_memory is true. The
+  // tensors are loaded to CPU, and then copied to the place.
+  void LoadParamsFromCheckpoint(
+      const framework::ExecutionContext &context, const platform::Place &place,
+      const std::string &buffer, bool from_memory, bool use_mmap,
+      bool load_as_fp16, const std::vector<std::string> &out_var_names) const {
+    auto out_vars = context.MultiOutputVar("Out");
+    bool is_cpu_place = platform::is_cpu_place(place);
+    std::vector<framework::LoDTensor> cpu_tensors(
+        is_cpu_place ? 0 : out_vars.size());
+    std::vector<framework::LoDTensor *> tensors;
+    for (size_t i = 0; i < out_var_names.size(); i++) {
+      PADDLE_ENFORCE_NOT_NULL(
+          out_vars[i], platform::errors::InvalidArgument(
+                           "The variable %s to be loaded cannot be found.",
+                           out_var_names[i]));
+      tensors.push_back(is_cpu_place
+                            ? out_vars[i]->GetMutable<framework::LoDTensor>()
+                            : &cpu_tensors[i]);
+    }
+    if (from_memory) {
+      framework::LoadCheckpointFromString(buffer, tensors);
+    } else {
+      framework::LoadCheckpoint(buffer, use_mmap && is_cpu_place, tensors);
+    }
+
+    for (size_t i = 0; i < out_vars.size(); i++) {
+      if (!is_cpu_place) {
+        auto *tensor = out_vars[i]->GetMutable<framework::LoDTensor>();
+        framework::TensorCopySync(cpu_tensors[i], place, tensor);
+        tensor->set_lod(cpu_tensors[i].lod());
+      }
+      CastToFP16(place, load_as_fp16, out_vars[i]);
+    }
+  }
+
+  // Convert the tensor loaded to the variable to float16 if load_as_fp16 is
+  // true.
+  void CastToFP16(const platform::Place &place, bool load_as_fp16,
+                  framework::Variable *var) const {
+    auto *tensor = var->GetMutable<framework::LoDTensor>();
+    auto in_dtype = tensor->type();
+    auto out_dtype = load_as_fp16 ? framework::proto::VarType::FP16 : in_dtype;
+
+    if (in_dtype != out_dtype) {
+      // convert to float16 tensor
+      auto in_kernel_type = framework::OpKernelType(in_dtype, place);
+      auto out_kernel_type = framework::OpKernelType(out_dtype, place);
+      framework::LoDTensor fp16_tensor;
+      // copy LoD info to the new tensor
+      fp16_tensor.set_lod(tensor->lod());
+      framework::TransDataType(in_kernel_type, out_kernel_type, *tensor,
+                               &fp16_tensor);
+
+      // reset output tensor
+      var->Clear();
+      tensor = var->GetMutable<framework::LoDTensor>();
+      tensor->set_lod(fp16_tensor.lod());
+      tensor->ShareDataWith(fp16_tensor);
+    }
+  }
 };
 
 }  // namespace operators
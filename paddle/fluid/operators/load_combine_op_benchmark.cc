@@ -0,0 +1,156 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+// Time of save_combine and load_combine against the size of the checkpoint,
+// for the files serialized tensor by tensor and the checkpoints with the
+// offset index, which are read in chunks by several threads, or mapped from
+// the file. The mapped tensors are read by the page faults of their first
+// access, so the time to touch all their pages is given too. The files are
+// read just after they are written, so that they are in the page cache, and
+// the time is that of the copies rather than that of the disk.
+//
+// Usage:
+//   ./load_combine_op_benchmark --sizes_mb=16,256,1024 --num_tensors=64 \
+//       --checkpoint_io_threads=8
+
+#include <unistd.h>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/platform/init.h"
+
+DEFINE_string(sizes_mb, "16,256,1024",
+              "Sizes of the checkpoints in MB, separated by commas.");
+DEFINE_int32(num_tensors, 64,
+             "Number of the tensors of each checkpoint, which share its size "
+             "evenly.");
+DEFINE_int32(repeat, 3, "Times to run each save and load.");
+DEFINE_string(dir, ".", "Directory to save the checkpoints to.");
+
+USE_CPU_ONLY_OP(save_combine);
+USE_CPU_ONLY_OP(load_combine);
+
+namespace paddle {
+namespace operators {
+
+template <typename Func>
+static double TimeMs(Func func) {
+  func();
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < FLAGS_repeat; ++i) {
+    func();
+  }
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+             .count() /
+         FLAGS_repeat;
+}
+
+// Read a float of each page of the tensors, so that the mapped pages are read.
+static float TouchPages(const framework::Scope& scope,
+                        const std::vector<std::string>& names) {
+  const int64_t stride = sysconf(_SC_PAGESIZE) / sizeof(float);
+  float sum = 0;
+  for (auto& name : names) {
+    auto& tensor = scope.FindVar(name)->Get<framework::LoDTensor>();
+    const float* data = tensor.data<float>();
+    for (int64_t i = 0; i < tensor.numel(); i += stride) {
+      sum += data[i];
+    }
+  }
+  return sum;
+}
+
+static void RunBenchmark(int64_t size_mb) {
+  framework::Scope scope;
+  platform::CPUPlace cpu;
+  int64_t numel = (size_mb << 20) / sizeof(float) / FLAGS_num_tensors;
+  std::vector<std::string> in_names;
+  std::vector<std::string> out_names;
+  for (int i = 0; i < FLAGS_num_tensors; ++i) {
+    in_names.push_back("in_" + std::to_string(i));
+    out_names.push_back("out_" + std::to_string(i));
+    auto* tensor =
+        scope.Var(in_names.back())->GetMutable<framework::LoDTensor>();
+    float* data =
+        tensor->mutable_data<float>(framework::make_ddim({numel}), cpu);
+    for (int64_t j = 0; j < tensor->numel(); ++j) {
+      data[j] = static_cast<float>(j % 1000);
+    }
+    scope.Var(out_names.back())->GetMutable<framework::LoDTensor>();
+  }
+
+  auto run = [&](const std::string& file_path, bool with_offset_index,
+                 bool use_mmap, bool touch, double* save_ms) {
+    framework::AttributeMap save_attrs{
+        {"file_path", file_path}, {"with_offset_index", with_offset_index}};
+    auto save_op = framework::OpRegistry::CreateOp(
+        "save_combine", {{"X", in_names}}, {}, save_attrs);
+    if (save_ms != nullptr) {
+      *save_ms = TimeMs([&] { save_op->Run(scope, cpu); });
+    }
+    framework::AttributeMap load_attrs{{"file_path", file_path},
+                                       {"use_mmap", use_mmap}};
+    auto load_op = framework::OpRegistry::CreateOp(
+        "load_combine", {}, {{"Out", out_names}}, load_attrs);
+    return TimeMs([&] {
+      load_op->Run(scope, cpu);
+      if (touch) {
+        TouchPages(scope, out_names);
+      }
+    });
+  };
+
+  std::string stream_path = FLAGS_dir + "/load_combine_benchmark.stream";
+  std::string checkpoint_path = FLAGS_dir + "/load_combine_benchmark.ckpt";
+  double stream_save_ms = 0;
+  double checkpoint_save_ms = 0;
+  double stream_ms = run(stream_path, false, false, false, &stream_save_ms);
+  double read_ms =
+      run(checkpoint_path, true, false, false, &checkpoint_save_ms);
+  double mmap_ms = run(checkpoint_path, true, true, false, nullptr);
+  double mmap_touch_ms = run(checkpoint_path, true, true, true, nullptr);
+  std::remove(stream_path.c_str());
+  std::remove(checkpoint_path.c_str());
+
+  std::cout << size_mb << "\t" << stream_save_ms << "\t" << checkpoint_save_ms
+            << "\t" << stream_ms << "\t" << read_ms << "\t" << mmap_ms << "\t"
+            << mmap_touch_ms << "\t" << stream_ms / read_ms << "\t"
+            << stream_ms / mmap_touch_ms << std::endl;
+}
+
+}  // namespace operators
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  paddle::framework::InitDevices(false);
+
+  std::cout << "MB\tsave ms\tsave index ms\tload ms\tload index ms\t"
+            << "load mmap ms\tload mmap+touch ms\tindex speedup\t"
+            << "mmap+touch speedup" << std::endl;
+  std::stringstream sizes(FLAGS_sizes_mb);
+  std::string size;
+  while (std::getline(sizes, size, ',')) {
+    paddle::operators::RunBenchmark(std::stoll(size));
+  }
+  return 0;
+}
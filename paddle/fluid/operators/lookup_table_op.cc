@@ -78,7 +78,14 @@ class LookupTableOpMaker : public framework::OpProtoAndCheckerMaker {
              "An input with type int64 "
              "contains the ids to be looked up in W. "
              "The last dimension size must be 1.");
-    AddOutput("Out", "The lookup results, which have the same type as W.");
+    AddInput("Scale",
+             "(Tensor, optional) The float scales to dequantize the rows of W "
+             "of int8 when out_dtype is float32, which has an element for "
+             "each row of W, or a single element for all the rows.")
+        .AsDispensable();
+    AddOutput("Out",
+              "The lookup results, which have the same type as W unless "
+              "out_dtype is set.");
     AddAttr<bool>("is_sparse",
                   "(boolean, default false) "
                   "Sparse update.")
@@ -92,6 +99,12 @@ class LookupTableOpMaker : public framework::OpProtoAndCheckerMaker {
                      "Otherwise the given value indicates padding the output "
                      "with zeros whenever lookup encounters it in Ids.")
         .SetDefault(kNoPadding);
+    AddAttr<int>("out_dtype",
+                 "(int, default -1) The data type of Out, which is the type "
+                 "of W if it is -1. The rows of W of float16 or int8 can be "
+                 "dequantized to float32 when they are looked up, so that "
+                 "the table takes less memory.")
+        .SetDefault(-1);
     // NOTE(minqiyang): grad_inplace is an temporal attribute,
     // please do NOT set this attribute in python layer.
     AddAttr<bool>("grad_inplace",
@@ -130,6 +143,19 @@ or not. And the output only shares the LoD information with input Ids.
   }
 };
 
+class LookupTableOpVarTypeInference : public framework::VarTypeInference {
+ public:
+  void operator()(framework::InferVarTypeContext* ctx) const override {
+    int out_dtype = BOOST_GET_CONST(int, ctx->GetAttr("out_dtype"));
+    if (out_dtype >= 0) {
+      ctx->SetOutputDataType(
+          "Out", static_cast<framework::proto::VarType::Type>(out_dtype));
+    } else {
+      ctx->SetOutputDataType("Out", ctx->GetInputDataType("W"));
+    }
+  }
+};
+
 DECLARE_NO_NEED_BUFFER_VARS_INFERER(LookupTableGradOpNoBufferVarsInferer, "W");
 
 template <typename T>
@@ -194,6 +220,7 @@ class LookupTableOpGradVarTypeInference : public framework::VarTypeInference {
 
 namespace ops = paddle::operators;
 REGISTER_OPERATOR(lookup_table, ops::LookupTableOp, ops::LookupTableOpMaker,
+                  ops::LookupTableOpVarTypeInference,
                   ops::LookupTableGradOpMaker<paddle::framework::OpDesc>,
                   ops::LookupTableGradOpMaker<paddle::imperative::OpBase>);
 
@@ -203,6 +230,7 @@ REGISTER_OPERATOR(lookup_table_grad, ops::LookupTableOpGrad,
 
 REGISTER_OP_CPU_KERNEL(lookup_table, ops::LookupTableKernel<float>,
                        ops::LookupTableKernel<double>,
-                       ops::LookupTableKernel<int8_t>);
+                       ops::LookupTableKernel<int8_t>,
+                       ops::LookupTableKernel<paddle::platform::float16>);
 REGISTER_OP_CPU_KERNEL(lookup_table_grad, ops::LookupTableGradKernel<float>,
                        ops::LookupTableGradKernel<double>);
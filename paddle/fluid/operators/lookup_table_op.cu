@@ -97,6 +97,18 @@ class LookupTableCUDAKernel : public framework::OpKernel<T> {
     auto id_name = context.InputNames("Ids").front();
     auto out_name = context.OutputNames("Out").front();
 
+    // the rows are only dequantized by the CPU kernel
+    int out_dtype = context.Attr<int>("out_dtype");
+    auto table_dtype = framework::DataTypeTrait<T>::DataType();
+    PADDLE_ENFORCE_EQ(
+        out_dtype < 0 || out_dtype == static_cast<int>(table_dtype), true,
+        platform::errors::Unimplemented(
+            "The lookup_table on GPU does not dequantize the table of %s to "
+            "out_dtype %s, please run it on CPU or leave out_dtype unset.",
+            framework::DataTypeToString(table_dtype),
+            framework::DataTypeToString(
+                static_cast<framework::proto::VarType::Type>(out_dtype))));
+
     size_t N = table_t->dims()[0];
     size_t D = table_t->dims()[1];
     size_t K = ids_t->numel();
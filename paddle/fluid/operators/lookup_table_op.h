@@ -14,14 +14,17 @@ limitations under the License. */
 
 #pragma once
 
+#include <cstring>
 #include <string>
+#include <type_traits>
 #include <vector>
 
+#include "paddle/fluid/framework/data_type.h"
 #include "paddle/fluid/framework/eigen.h"
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/selected_rows.h"
-#include "paddle/fluid/operators/math/blas.h"
+#include "paddle/fluid/framework/sparse_row_index.h"
 
 #ifdef PADDLE_WITH_DISTRIBUTE
 #include "paddle/fluid/operators/distributed/parameter_prefetch.h"
@@ -36,6 +39,92 @@ using SelectedRows = framework::SelectedRows;
 using DDim = framework::DDim;
 
 constexpr int64_t kNoPadding = -1;
+// The rows are copied by the OpenMP threads when the output has at least this
+// many elements, below which the threads cost more than they save.
+constexpr int64_t kLookupParallelNumel = 1 << 16;
+// The number of the rows ahead of the copied one to prefetch.
+constexpr int64_t kLookupPrefetchDistance = 4;
+
+inline void PrefetchRow(const void *row, size_t size) {
+#if defined(__GNUC__)
+  const char *addr = static_cast<const char *>(row);
+  for (size_t offset = 0; offset < size; offset += 64) {
+    __builtin_prefetch(addr + offset);
+  }
+#endif
+}
+
+// Copy a row of the table to the output, which dequantizes the row when the
+// output has another type than the table.
+template <typename TIn, typename TOut>
+struct LookupRowCopier {
+  static void Copy(const TIn *src, int64_t width, float scale, TOut *dst) {
+    for (int64_t j = 0; j < width; ++j) {
+      dst[j] = static_cast<TOut>(static_cast<float>(src[j]) * scale);
+    }
+  }
+};
+
+template <typename T>
+struct LookupRowCopier<T, T> {
+  static void Copy(const T *src, int64_t width, float scale, T *dst) {
+    std::memcpy(dst, src, width * sizeof(T));
+  }
+};
+
+// The bits of float16 are converted to float32 by a multiplication, which is
+// vectorized unlike the conversion of a float16 at a time.
+template <>
+struct LookupRowCopier<platform::float16, float> {
+  static void Copy(const platform::float16 *src, int64_t width, float scale,
+                   float *dst) {
+    // 2^112, the difference of the exponent biases of float32 and float16
+    constexpr float kExponentScale = 5.192296858534828e33f;
+    for (int64_t j = 0; j < width; ++j) {
+      uint32_t sign = static_cast<uint32_t>(src[j].x & 0x8000) << 16;
+      uint32_t bits = static_cast<uint32_t>(src[j].x & 0x7fff) << 13;
+      float value;
+      std::memcpy(&value, &bits, sizeof(value));
+      // which also normalizes the subnormals of float16
+      value *= kExponentScale;
+      std::memcpy(&bits, &value, sizeof(bits));
+      // the infinities and NaNs of float16
+      if (value >= 65536.0f) {
+        bits |= 0x7f800000;
+      }
+      bits |= sign;
+      std::memcpy(&value, &bits, sizeof(value));
+      dst[j] = value * scale;
+    }
+  }
+};
+
+// Copy the rows of the table to the rows of the output, and fill the rows of
+// negative indexes with 0. The rows are scaled by scales[row * scale_stride]
+// if scales is not null.
+template <typename TIn, typename TOut>
+void LookupRows(const TIn *table, int64_t row_width, const int64_t *rows,
+                int64_t num, const float *scales, int64_t scale_stride,
+                TOut *output) {
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (num * row_width >= kLookupParallelNumel)
+#endif
+  for (int64_t i = 0; i < num; ++i) {
+    if (i + kLookupPrefetchDistance < num &&
+        rows[i + kLookupPrefetchDistance] >= 0) {
+      PrefetchRow(table + rows[i + kLookupPrefetchDistance] * row_width,
+                  row_width * sizeof(TIn));
+    }
+    TOut *dst = output + i * row_width;
+    if (rows[i] < 0) {
+      std::memset(dst, 0, row_width * sizeof(TOut));
+    } else {
+      float scale = scales == nullptr ? 1.0f : scales[rows[i] * scale_stride];
+      LookupRowCopier<TIn, TOut>::Copy(table + rows[i] * row_width, row_width,
+                                       scale, dst);
+    }
+  }
+}
 
 template <typename T>
 class LookupTableKernel : public framework::OpKernel<T> {
@@ -71,72 +160,134 @@ class LookupTableKernel : public framework::OpKernel<T> {
 #endif
     } else {
       int64_t padding_idx = context.Attr<int64_t>("padding_idx");
-      int64_t *ids = const_cast<int64_t *>(ids_t->data<int64_t>());
+      const int64_t *ids = ids_t->data<int64_t>();
       int64_t ids_numel = ids_t->numel();
 
+      // the rows of the ids in the table, -1 for the paddings
+      std::vector<int64_t> rows(ids_numel);
+      const Tensor *table_t = nullptr;
       if (table_var->IsType<LoDTensor>()) {
-        auto *table_t = context.Input<LoDTensor>("W");
+        table_t = context.Input<LoDTensor>("W");
         int64_t row_number = table_t->dims()[0];
-        int64_t row_width = table_t->dims()[1];
-
-        auto *table = table_t->data<T>();
-        auto *output = output_t->mutable_data<T>(context.GetPlace());
-
         for (int64_t i = 0; i < ids_numel; ++i) {
           if (padding_idx != kNoPadding && ids[i] == padding_idx) {
-            memset(output + i * row_width, 0, row_width * sizeof(T));
-          } else {
-            PADDLE_ENFORCE_LT(
-                ids[i], row_number,
-                platform::errors::InvalidArgument(
-                    "Variable value (input) of OP(fluid.layers.embedding) "
-                    "expected >= 0 and < %ld, but got %ld. Please check input "
-                    "value.",
-                    row_number, ids[i]));
-            PADDLE_ENFORCE_GE(
-                ids[i], 0,
-                platform::errors::InvalidArgument(
-                    "Variable value (input) of OP(fluid.layers.embedding) "
-                    "expected >= 0 and < %ld, but got %ld. Please check input "
-                    "value.",
-                    row_number, ids[i]));
-            memcpy(output + i * row_width, table + ids[i] * row_width,
-                   row_width * sizeof(T));
+            rows[i] = -1;
+            continue;
           }
+          PADDLE_ENFORCE_LT(
+              ids[i], row_number,
+              platform::errors::InvalidArgument(
+                  "Variable value (input) of OP(fluid.layers.embedding) "
+                  "expected >= 0 and < %ld, but got %ld. Please check input "
+                  "value.",
+                  row_number, ids[i]));
+          PADDLE_ENFORCE_GE(
+              ids[i], 0,
+              platform::errors::InvalidArgument(
+                  "Variable value (input) of OP(fluid.layers.embedding) "
+                  "expected >= 0 and < %ld, but got %ld. Please check input "
+                  "value.",
+                  row_number, ids[i]));
+          rows[i] = ids[i];
         }
       } else if (table_var->IsType<SelectedRows>()) {
-        const auto &table_t = table_var->Get<SelectedRows>();
-        int64_t row_width = table_t.value().dims()[1];
-        const auto *table = table_t.value().data<T>();
+        const auto &selected_rows = table_var->Get<SelectedRows>();
+        table_t = &selected_rows.value();
+        FindSelectedRows(selected_rows, ids, ids_numel, padding_idx,
+                         rows.data());
+      } else {
+        PADDLE_THROW(platform::errors::InvalidArgument(
+            "The parameter W of a LookupTable must be either LoDTensor or "
+            "SelectedRows."));
+      }
+
+      int64_t row_width = table_t->dims()[1];
+      const T *table = table_t->data<T>();
+      auto table_dtype = framework::DataTypeTrait<T>::DataType();
+      int out_dtype = context.Attr<int>("out_dtype");
+      if (out_dtype < 0 || out_dtype == static_cast<int>(table_dtype)) {
         auto *output = output_t->mutable_data<T>(context.GetPlace());
-        auto input_data_type = table_t.value().type();
-        for (int64_t i = 0; i < ids_numel; ++i) {
-          if (padding_idx != kNoPadding && ids[i] == padding_idx) {
-            memset(output + i * row_width, 0, row_width * sizeof(T));
-          } else {
-            PADDLE_ENFORCE_GE(
-                ids[i], 0,
-                platform::errors::InvalidArgument(
-                    "Variable value (input) of OP(fluid.layers.embedding) "
-                    "expected >= 0. But received %ld",
-                    ids[i]));
-            auto id_index = table_t.Index(ids[i]);
-            PADDLE_ENFORCE_GE(
-                id_index, 0,
-                platform::errors::InvalidArgument(
-                    "the input key should be exists. But received %d.",
-                    id_index));
-            if (input_data_type == framework::proto::VarType::INT8) {
-              memcpy(output + i * row_width, table + id_index * row_width,
-                     row_width * sizeof(T));
-            } else {
-              auto blas = math::GetBlas<platform::CPUDeviceContext, T>(context);
-              blas.VCOPY(row_width, table + id_index * row_width,
-                         output + i * row_width);
-            }
-          }
-        }
+        LookupRows<T, T>(table, row_width, rows.data(), ids_numel, nullptr, 0,
+                         output);
+        return;
+      }
+      bool quantized = std::is_same<T, platform::float16>::value ||
+                       std::is_same<T, int8_t>::value;
+      PADDLE_ENFORCE_EQ(
+          quantized && out_dtype == framework::proto::VarType::FP32, true,
+          platform::errors::Unimplemented(
+              "The lookup_table only dequantizes the tables of float16 or "
+              "int8 to float32, but received the table of %s and out_dtype "
+              "%s.",
+              framework::DataTypeToString(table_dtype),
+              framework::DataTypeToString(
+                  static_cast<framework::proto::VarType::Type>(out_dtype))));
+      const float *scales = nullptr;
+      int64_t scale_stride = 0;
+      auto *scale_t = context.Input<Tensor>("Scale");
+      if (scale_t != nullptr) {
+        int64_t table_rows = table_t->dims()[0];
+        PADDLE_ENFORCE_EQ(
+            scale_t->numel() == 1 || scale_t->numel() == table_rows, true,
+            platform::errors::InvalidArgument(
+                "The Scale of lookup_table should have 1 element, or an "
+                "element for each of the %d rows of W, but received %d "
+                "elements.",
+                table_rows, scale_t->numel()));
+        scales = scale_t->data<float>();
+        scale_stride = scale_t->numel() == 1 ? 0 : 1;
+      }
+      auto *output = output_t->mutable_data<float>(context.GetPlace());
+      LookupRows<T, float>(table, row_width, rows.data(), ids_numel, scales,
+                           scale_stride, output);
+    }
+  }
+
+ private:
+  // Find the rows of the ids in the SelectedRows. The ids are deduplicated,
+  // since the ids of a batch usually repeat, so that each of them is looked up
+  // once.
+  void FindSelectedRows(const SelectedRows &selected_rows, const int64_t *ids,
+                        int64_t ids_numel, int64_t padding_idx,
+                        int64_t *rows) const {
+    framework::SparseRowIndex unique_index;
+    unique_index.Reserve(ids_numel);
+    std::vector<int64_t> unique_ids;
+    // the positions of the ids in unique_ids, -1 for the paddings
+    std::vector<int64_t> positions(ids_numel);
+    for (int64_t i = 0; i < ids_numel; ++i) {
+      if (padding_idx != kNoPadding && ids[i] == padding_idx) {
+        positions[i] = -1;
+        continue;
+      }
+      PADDLE_ENFORCE_GE(
+          ids[i], 0,
+          platform::errors::InvalidArgument(
+              "Variable value (input) of OP(fluid.layers.embedding) "
+              "expected >= 0. But received %ld",
+              ids[i]));
+      int64_t position = unique_index.Find(ids[i]);
+      if (position < 0) {
+        position = static_cast<int64_t>(unique_ids.size());
+        unique_index.Insert(ids[i], position);
+        unique_ids.push_back(ids[i]);
       }
+      positions[i] = position;
+    }
+
+    std::vector<int64_t> unique_rows(unique_ids.size());
+    selected_rows.Index(unique_ids.data(),
+                        static_cast<int64_t>(unique_ids.size()),
+                        unique_rows.data());
+    for (size_t i = 0; i < unique_ids.size(); ++i) {
+      PADDLE_ENFORCE_GE(
+          unique_rows[i], 0,
+          platform::errors::InvalidArgument(
+              "the input key should be exists. But received %d.",
+              unique_ids[i]));
+    }
+    for (int64_t i = 0; i < ids_numel; ++i) {
+      rows[i] = positions[i] < 0 ? -1 : unique_rows[positions[i]];
     }
   }
 };
@@ -0,0 +1,239 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+// Time of the lookup_table operator on CPU against the former kernel, which
+// copies the rows one id at a time and searches the rows of a SelectedRows
+// for each id. The ids are drawn from a skewed distribution, so that they
+// repeat like the ids of the sparse features of CTR models. The tables of
+// float16 and int8 are dequantized to float32 by the operator, and compared
+// with the former kernel on the tables of float32 they are quantized from.
+//
+// Usage:
+//   ./lookup_table_op_benchmark --table_rows=1048576 --width=64 \
+//       --num_ids=65536 --threads=4
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/framework/selected_rows.h"
+#include "paddle/fluid/platform/cpu_helper.h"
+#include "paddle/fluid/platform/float16.h"
+#include "paddle/fluid/platform/init.h"
+
+DEFINE_int64(table_rows, 1 << 20, "Number of the rows of the dense tables.");
+DEFINE_int64(sparse_rows, 1 << 14,
+             "Number of the rows of the SelectedRows table, which the former "
+             "kernel searches linearly for each id.");
+DEFINE_int32(width, 64, "Width of the rows of the tables.");
+DEFINE_int32(num_ids, 1 << 16, "Number of the ids looked up at a time.");
+DEFINE_double(skew, 3.0,
+              "The ids are table_rows * pow(u, skew) for u uniform in [0, 1), "
+              "so that the larger skew is, the more the ids repeat.");
+DEFINE_int32(repeat, 20, "Times to run each lookup.");
+DEFINE_int32(threads, 1, "Number of the OpenMP threads of the operator.");
+
+USE_OP(lookup_table);
+
+namespace paddle {
+namespace operators {
+
+using framework::LoDTensor;
+using framework::SelectedRows;
+
+// The former kernel of lookup_table.
+template <typename T>
+static void LookupTableReference(const framework::Variable& table_var,
+                                 const LoDTensor& ids_t, LoDTensor* output_t) {
+  const int64_t* ids = ids_t.data<int64_t>();
+  int64_t ids_numel = ids_t.numel();
+  if (table_var.IsType<LoDTensor>()) {
+    auto& table_t = table_var.Get<LoDTensor>();
+    int64_t row_number = table_t.dims()[0];
+    int64_t row_width = table_t.dims()[1];
+    const T* table = table_t.data<T>();
+    T* output = output_t->mutable_data<T>(platform::CPUPlace());
+    for (int64_t i = 0; i < ids_numel; ++i) {
+      PADDLE_ENFORCE_LT(ids[i], row_number, platform::errors::InvalidArgument(
+                                                "The id %ld is out of range.",
+                                                ids[i]));
+      PADDLE_ENFORCE_GE(ids[i], 0, platform::errors::InvalidArgument(
+                                       "The id %ld is out of range.", ids[i]));
+      std::memcpy(output + i * row_width, table + ids[i] * row_width,
+                  row_width * sizeof(T));
+    }
+  } else {
+    auto& table_t = table_var.Get<SelectedRows>();
+    int64_t row_width = table_t.value().dims()[1];
+    const T* table = table_t.value().data<T>();
+    T* output = output_t->mutable_data<T>(platform::CPUPlace());
+    for (int64_t i = 0; i < ids_numel; ++i) {
+      PADDLE_ENFORCE_GE(ids[i], 0, platform::errors::InvalidArgument(
+                                       "The id %ld is out of range.", ids[i]));
+      int64_t id_index = table_t.Index(ids[i]);
+      std::memcpy(output + i * row_width, table + id_index * row_width,
+                  row_width * sizeof(T));
+    }
+  }
+}
+
+template <typename Func>
+static double TimeMs(Func func) {
+  func();
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < FLAGS_repeat; ++i) {
+    func();
+  }
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+             .count() /
+         FLAGS_repeat;
+}
+
+static void InitIds(int64_t num_rows, int64_t key_stride, LoDTensor* ids_t) {
+  int64_t* ids = ids_t->mutable_data<int64_t>(
+      framework::make_ddim({FLAGS_num_ids, 1}), platform::CPUPlace());
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<double> dist(0.0, 1.0);
+  for (int64_t i = 0; i < FLAGS_num_ids; ++i) {
+    int64_t row = static_cast<int64_t>(num_rows * std::pow(dist(rng),
+                                                           FLAGS_skew));
+    ids[i] = std::min(row, num_rows - 1) * key_stride;
+  }
+}
+
+// Fill the table of float32 with the values of the table of T, which is
+// quantized from it by scales[row].
+template <typename T>
+static void InitTables(int64_t num_rows, framework::Tensor* table_fp32,
+                       framework::Tensor* table, std::vector<float>* scales) {
+  platform::CPUPlace cpu;
+  auto dims = framework::make_ddim({num_rows, FLAGS_width});
+  float* data_fp32 = table_fp32->mutable_data<float>(dims, cpu);
+  T* data = table->mutable_data<T>(dims, cpu);
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> dist(-1.f, 1.f);
+  scales->resize(num_rows);
+  for (int64_t i = 0; i < num_rows; ++i) {
+    (*scales)[i] = std::is_same<T, int8_t>::value ? 1.f / 127 : 1.f;
+    for (int64_t j = 0; j < FLAGS_width; ++j) {
+      int64_t k = i * FLAGS_width + j;
+      data[k] = static_cast<T>(dist(rng) / (*scales)[i]);
+      data_fp32[k] = static_cast<float>(data[k]) * (*scales)[i];
+    }
+  }
+}
+
+static float MaxDiff(const LoDTensor& x, const LoDTensor& y) {
+  float max_diff = 0;
+  for (int64_t i = 0; i < x.numel(); ++i) {
+    max_diff =
+        std::max(max_diff, std::fabs(x.data<float>()[i] - y.data<float>()[i]));
+  }
+  return max_diff;
+}
+
+// Look up the ids of the scope by the former kernel in the table w_fp32 and by
+// the operator in the table w, and compare the time and the results.
+static void RunBenchmark(const std::string& name, framework::Scope* scope,
+                         const framework::AttributeMap& attrs,
+                         bool with_scale) {
+  framework::VariableNameMap inputs{{"W", {"w"}}, {"Ids", {"ids"}}};
+  if (with_scale) {
+    inputs["Scale"] = {"scale"};
+  }
+  auto op = framework::OpRegistry::CreateOp("lookup_table", inputs,
+                                            {{"Out", {"out"}}}, attrs);
+  auto& w_fp32 = *scope->FindVar("w_fp32");
+  auto& ids = scope->FindVar("ids")->Get<LoDTensor>();
+  auto* out_ref = scope->Var("out_ref")->GetMutable<LoDTensor>();
+  out_ref->Resize(framework::make_ddim({FLAGS_num_ids, FLAGS_width}));
+  scope->Var("out")->GetMutable<LoDTensor>();
+
+  double ref_ms =
+      TimeMs([&] { LookupTableReference<float>(w_fp32, ids, out_ref); });
+  double op_ms = TimeMs([&] { op->Run(*scope, platform::CPUPlace()); });
+  float max_diff = MaxDiff(*out_ref, scope->FindVar("out")->Get<LoDTensor>());
+  std::cout << name << "\t" << ref_ms << "\t" << op_ms << "\t"
+            << ref_ms / op_ms << "\t" << max_diff << std::endl;
+}
+
+template <typename T>
+static void RunDenseBenchmark(const std::string& name) {
+  framework::Scope scope;
+  std::vector<float> scales;
+  InitTables<T>(FLAGS_table_rows,
+                scope.Var("w_fp32")->GetMutable<LoDTensor>(),
+                scope.Var("w")->GetMutable<LoDTensor>(), &scales);
+  auto* scale = scope.Var("scale")->GetMutable<LoDTensor>();
+  std::copy(scales.begin(), scales.end(),
+            scale->mutable_data<float>(framework::make_ddim({FLAGS_table_rows}),
+                                       platform::CPUPlace()));
+  InitIds(FLAGS_table_rows, 1, scope.Var("ids")->GetMutable<LoDTensor>());
+  framework::AttributeMap attrs;
+  if (!std::is_same<T, float>::value) {
+    attrs["out_dtype"] = static_cast<int>(framework::proto::VarType::FP32);
+  }
+  RunBenchmark(name, &scope, attrs, std::is_same<T, int8_t>::value);
+}
+
+// The keys of the rows are strided, and set by set_rows as the tables loaded
+// from the files are.
+static void RunSparseBenchmark(const std::string& name) {
+  constexpr int64_t kKeyStride = 7;
+  framework::Scope scope;
+  auto* w_fp32 = scope.Var("w_fp32")->GetMutable<SelectedRows>();
+  auto* w = scope.Var("w")->GetMutable<SelectedRows>();
+  std::vector<float> scales;
+  InitTables<float>(FLAGS_sparse_rows, w_fp32->mutable_value(),
+                    w->mutable_value(), &scales);
+  std::vector<int64_t> keys(FLAGS_sparse_rows);
+  for (int64_t i = 0; i < FLAGS_sparse_rows; ++i) {
+    keys[i] = i * kKeyStride;
+  }
+  w_fp32->set_rows(keys);
+  w->set_rows(keys);
+  InitIds(FLAGS_sparse_rows, kKeyStride,
+          scope.Var("ids")->GetMutable<LoDTensor>());
+  RunBenchmark(name, &scope, {}, false);
+}
+
+}  // namespace operators
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  paddle::framework::InitDevices(false);
+#ifdef PADDLE_WITH_MKLML
+  paddle::platform::SetNumThreads(FLAGS_threads);
+#endif
+
+  namespace ops = paddle::operators;
+  std::cout << "table\tformer ms\tlookup_table ms\tspeedup\tmax diff"
+            << std::endl;
+  ops::RunDenseBenchmark<float>("dense_fp32");
+  ops::RunDenseBenchmark<paddle::platform::float16>("dense_fp16_to_fp32");
+  ops::RunDenseBenchmark<int8_t>("dense_int8_to_fp32");
+  ops::RunSparseBenchmark("selected_rows_fp32");
+  return 0;
+}
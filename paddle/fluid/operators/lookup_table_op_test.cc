@@ -0,0 +1,240 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/framework/program_desc.h"
+#include "paddle/fluid/framework/selected_rows.h"
+#include "paddle/fluid/operators/lookup_table_op.h"
+#include "paddle/fluid/platform/float16.h"
+
+USE_OP(lookup_table);
+
+namespace paddle {
+namespace operators {
+
+static const int64_t kRows = 100;
+static const int64_t kWidth = 8;
+
+template <typename T>
+static void InitTable(framework::Tensor* table) {
+  T* data = table->mutable_data<T>(framework::make_ddim({kRows, kWidth}),
+                                   platform::CPUPlace());
+  for (int64_t i = 0; i < kRows * kWidth; ++i) {
+    data[i] = static_cast<T>(i % 120 - 60);
+  }
+}
+
+static void InitIds(framework::Scope* scope, const std::vector<int64_t>& ids) {
+  auto* ids_t = scope->Var("ids")->GetMutable<framework::LoDTensor>();
+  int64_t* data = ids_t->mutable_data<int64_t>(
+      framework::make_ddim({static_cast<int64_t>(ids.size()), 1}),
+      platform::CPUPlace());
+  std::copy(ids.begin(), ids.end(), data);
+}
+
+static void RunLookupTable(framework::Scope* scope,
+                           const framework::AttributeMap& attrs,
+                           bool with_scale = false) {
+  framework::VariableNameMap inputs{{"W", {"w"}}, {"Ids", {"ids"}}};
+  if (with_scale) {
+    inputs["Scale"] = {"scale"};
+  }
+  scope->Var("out")->GetMutable<framework::LoDTensor>();
+  auto op = framework::OpRegistry::CreateOp("lookup_table", inputs,
+                                            {{"Out", {"out"}}}, attrs);
+  op->Run(*scope, platform::CPUPlace());
+}
+
+// Check the rows of the ids, where the rows of padding_idx are 0, and
+// element j of the rows of the other ids is expected(row, j).
+template <typename T, typename ExpectedFunc>
+static void CheckOutput(const framework::Scope& scope,
+                        const std::vector<int64_t>& ids,
+                        const std::vector<int64_t>& rows, int64_t padding_idx,
+                        ExpectedFunc expected_func) {
+  auto& out = scope.FindVar("out")->Get<framework::LoDTensor>();
+  ASSERT_EQ(out.dims(), framework::make_ddim(
+                            {static_cast<int64_t>(ids.size()), kWidth}));
+  const T* out_data = out.data<T>();
+  for (size_t i = 0; i < ids.size(); ++i) {
+    for (int64_t j = 0; j < kWidth; ++j) {
+      T expected = static_cast<T>(0);
+      if (ids[i] != padding_idx) {
+        expected = static_cast<T>(expected_func(rows[i], j));
+      }
+      ASSERT_EQ(out_data[i * kWidth + j], expected) << i << " " << j;
+    }
+  }
+}
+
+TEST(LookupTableOp, LoDTensor) {
+  framework::Scope scope;
+  auto* table = scope.Var("w")->GetMutable<framework::LoDTensor>();
+  InitTable<float>(table);
+  // enough ids to copy the rows in parallel
+  std::vector<int64_t> ids(kLookupParallelNumel / kWidth + 1);
+  for (size_t i = 0; i < ids.size(); ++i) {
+    ids[i] = (i * 37) % kRows;
+  }
+  InitIds(&scope, ids);
+  RunLookupTable(&scope, {{"padding_idx", static_cast<int64_t>(3)}});
+
+  const float* data = table->data<float>();
+  CheckOutput<float>(scope, ids, ids, 3, [&](int64_t row, int64_t j) {
+    return data[row * kWidth + j];
+  });
+
+  InitIds(&scope, {1, kRows});
+  ASSERT_THROW(RunLookupTable(&scope, {}), platform::EnforceNotMet);
+  InitIds(&scope, {-1});
+  ASSERT_THROW(RunLookupTable(&scope, {}), platform::EnforceNotMet);
+}
+
+TEST(LookupTableOp, SelectedRows) {
+  for (bool auto_grown : {false, true}) {
+    framework::Scope scope;
+    auto* table = scope.Var("w")->GetMutable<framework::SelectedRows>();
+    InitTable<float>(table->mutable_value());
+    // the keys of the rows are 1000 + 7 * index
+    if (auto_grown) {
+      for (int64_t i = 0; i < kRows; ++i) {
+        ASSERT_EQ(table->AutoGrownIndex(1000 + 7 * i, true), i);
+      }
+    } else {
+      std::vector<int64_t> keys(kRows);
+      for (int64_t i = 0; i < kRows; ++i) {
+        keys[i] = 1000 + 7 * i;
+      }
+      table->set_rows(keys);
+    }
+    table->set_height(kRows);
+
+    std::vector<int64_t> rows{5, 5, 0, 99, 5, 42, 0};
+    std::vector<int64_t> ids(rows.size());
+    for (size_t i = 0; i < rows.size(); ++i) {
+      ids[i] = 1000 + 7 * rows[i];
+    }
+    ids[3] = 1;
+    InitIds(&scope, ids);
+    RunLookupTable(&scope, {{"padding_idx", static_cast<int64_t>(1)}});
+
+    const float* data = table->value().data<float>();
+    CheckOutput<float>(scope, ids, rows, 1, [&](int64_t row, int64_t j) {
+      return data[row * kWidth + j];
+    });
+
+    InitIds(&scope, {1000, 1001});
+    ASSERT_THROW(RunLookupTable(&scope, {}), platform::EnforceNotMet);
+  }
+}
+
+TEST(LookupTableOp, Float16ToFloat32) {
+  framework::Scope scope;
+  auto* table = scope.Var("w")->GetMutable<framework::LoDTensor>();
+  InitTable<platform::float16>(table);
+  // the largest, infinite and subnormal values
+  platform::float16* row = table->data<platform::float16>();
+  std::vector<uint16_t> special_bits{0x7bff, 0x7c00, 0xfc00, 0x0001, 0x83ff};
+  for (size_t j = 0; j < special_bits.size(); ++j) {
+    row[j].x = special_bits[j];
+  }
+  std::vector<int64_t> ids{7, 0, 7, 99};
+  InitIds(&scope, ids);
+
+  RunLookupTable(&scope, {});
+  const platform::float16* data = table->data<platform::float16>();
+  CheckOutput<platform::float16>(
+      scope, ids, ids, kNoPadding,
+      [&](int64_t row, int64_t j) { return data[row * kWidth + j]; });
+
+  RunLookupTable(&scope, {{"out_dtype", static_cast<int>(
+                                            framework::proto::VarType::FP32)}});
+  CheckOutput<float>(scope, ids, ids, kNoPadding,
+                     [&](int64_t row, int64_t j) {
+                       return static_cast<float>(data[row * kWidth + j]);
+                     });
+}
+
+TEST(LookupTableOp, Int8ToFloat32) {
+  framework::Scope scope;
+  auto* table = scope.Var("w")->GetMutable<framework::LoDTensor>();
+  InitTable<int8_t>(table);
+  auto* scale = scope.Var("scale")->GetMutable<framework::LoDTensor>();
+  float* scale_data = scale->mutable_data<float>(framework::make_ddim({kRows}),
+                                                 platform::CPUPlace());
+  for (int64_t i = 0; i < kRows; ++i) {
+    scale_data[i] = 0.5f + 0.25f * i;
+  }
+  std::vector<int64_t> ids{7, 2, 7, 99, 2};
+  InitIds(&scope, ids);
+  const int8_t* data = table->data<int8_t>();
+  framework::AttributeMap attrs{
+      {"out_dtype", static_cast<int>(framework::proto::VarType::FP32)},
+      {"padding_idx", static_cast<int64_t>(2)}};
+
+  RunLookupTable(&scope, attrs, true);
+  CheckOutput<float>(scope, ids, ids, 2, [&](int64_t row, int64_t j) {
+    return data[row * kWidth + j] * scale_data[row];
+  });
+
+  // a single scale for all the rows
+  scale->Resize(framework::make_ddim({1}));
+  RunLookupTable(&scope, attrs, true);
+  CheckOutput<float>(scope, ids, ids, 2, [&](int64_t row, int64_t j) {
+    return data[row * kWidth + j] * scale_data[0];
+  });
+
+  scale->Resize(framework::make_ddim({2}));
+  ASSERT_THROW(RunLookupTable(&scope, attrs, true), platform::EnforceNotMet);
+}
+
+TEST(LookupTableOp, UnsupportedOutDtype) {
+  framework::Scope scope;
+  auto* table = scope.Var("w")->GetMutable<framework::LoDTensor>();
+  InitTable<float>(table);
+  InitIds(&scope, {1, 2});
+  ASSERT_THROW(
+      RunLookupTable(&scope, {{"out_dtype", static_cast<int>(
+                                                framework::proto::VarType::
+                                                    FP64)}}),
+      platform::EnforceNotMet);
+}
+
+TEST(LookupTableOp, InferOutDtype) {
+  framework::ProgramDesc program;
+  auto* block = program.MutableBlock(0);
+  block->Var("w")->SetDataType(framework::proto::VarType::FP16);
+  block->Var("ids")->SetDataType(framework::proto::VarType::INT64);
+  auto* out = block->Var("out");
+  auto* op = block->AppendOp();
+  op->SetType("lookup_table");
+  op->SetInput("W", {"w"});
+  op->SetInput("Ids", {"ids"});
+  op->SetOutput("Out", {"out"});
+  op->CheckAttrs();
+
+  // the type of W by default
+  op->InferVarType(block);
+  EXPECT_EQ(out->GetDataType(), framework::proto::VarType::FP16);
+
+  op->SetAttr("out_dtype", static_cast<int>(framework::proto::VarType::FP32));
+  op->InferVarType(block);
+  EXPECT_EQ(out->GetDataType(), framework::proto::VarType::FP32);
+}
+
+}  // namespace operators
+}  // namespace paddle
@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #pragma once
+#include <vector>
 #include "paddle/fluid/framework/eigen.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/selected_rows.h"
@@ -122,8 +123,12 @@ class SGDOpKernel<platform::CPUDeviceContext, T>
       const auto *lr = learning_rate->data<T>();
       const auto *grad_data = grad.value().data<T>();
       auto *out_data = param_out->mutable_value()->data<T>();
+      std::vector<int64_t> id_indexes(grad.rows().size());
+      param_out->AutoGrownIndex(grad.rows().data(),
+                                static_cast<int64_t>(grad.rows().size()),
+                                id_indexes.data(), false);
       for (size_t i = 0; i < grad.rows().size(); i++) {
-        int64_t id_index = param_out->AutoGrownIndex(grad.rows()[i], false);
+        int64_t id_index = id_indexes[i];
         PADDLE_ENFORCE_GE(id_index, static_cast<int64_t>(0),
                           "id should be in the table");
         for (int64_t j = 0; j < grad_row_width; j++) {
@@ -21,6 +21,7 @@
 #include "paddle/fluid/framework/ddim.h"
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/operators/reader/blocking_queue.h"
+#include "paddle/fluid/platform/monitor.h"
 #include "paddle/fluid/platform/place.h"
 
 namespace paddle {
@@ -30,7 +31,11 @@ namespace reader {
 class LoDTensorBlockingQueue {
  public:
   explicit LoDTensorBlockingQueue(size_t capacity, bool speed_test_mode = false)
-      : queue_(capacity, speed_test_mode) {}
+      : queue_(capacity, speed_test_mode),
+        size_gauge_("STAT_reader_queue_size",
+                    [this] { return static_cast<int64_t>(Size()); }),
+        capacity_gauge_("STAT_reader_queue_capacity",
+                        [this] { return static_cast<int64_t>(Cap()); }) {}
 
   ~LoDTensorBlockingQueue() { VLOG(10) << "Destruct LoDTensorBlockingQueue"; }
 
@@ -68,6 +73,10 @@ class LoDTensorBlockingQueue {
 
  private:
   BlockingQueue<std::vector<framework::LoDTensor>> queue_;
+  // The occupancy of the queues of all the readers, sampled when the stats
+  // are exported. They are destroyed before the queue.
+  platform::StatGauge size_gauge_;
+  platform::StatGauge capacity_gauge_;
 };
 
 class OrderedMultiDeviceLoDTensorBlockingQueue {
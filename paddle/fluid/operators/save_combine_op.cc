@@ -75,6 +75,12 @@ to a file on disk.
                   "(boolean, default false)"
                   "If true, the variables will be saved to binary strings.")
         .SetDefault(false);
+    AddAttr<bool>("with_offset_index",
+                  "(boolean, default false)"
+                  "If true, the variables will be saved to a checkpoint with "
+                  "an index of the offsets of their data, which load_combine "
+                  "reads in parallel or maps from the file.")
+        .SetDefault(false);
     AddOutput("Y",
               "(RAW, default empty)."
               "This output is used when saving variables to binary strings.")
@@ -19,12 +19,15 @@ limitations under the License. */
 #include <numeric>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include "paddle/fluid/framework/data_type.h"
 #include "paddle/fluid/framework/data_type_transform.h"
 #include "paddle/fluid/framework/framework.pb.h"
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/framework/tensor_checkpoint.h"
+#include "paddle/fluid/framework/tensor_util.h"
 #include "paddle/fluid/platform/device_context.h"
 #include "paddle/fluid/platform/port.h"
 
@@ -39,6 +42,7 @@ class SaveCombineOpKernel : public framework::OpKernel<T> {
     auto overwrite = ctx.Attr<bool>("overwrite");
     auto save_as_fp16 = ctx.Attr<bool>("save_as_fp16");
     auto save_to_memory = ctx.Attr<bool>("save_to_memory");
+    auto with_offset_index = ctx.Attr<bool>("with_offset_index");
     auto output = ctx.Output<std::string>("Y");
 
     bool is_present = FileExists(filename);
@@ -62,6 +66,9 @@ class SaveCombineOpKernel : public framework::OpKernel<T> {
     platform::DeviceContextPool &pool = platform::DeviceContextPool::Instance();
     auto &dev_ctx = *pool.Get(place);
 
+    // the tensors to save with the offset index, which are on CPU
+    std::vector<framework::LoDTensor> cpu_tensors;
+    cpu_tensors.reserve(inp_var_names.size());
     for (size_t i = 0; i < inp_var_names.size(); i++) {
       PADDLE_ENFORCE_NOT_NULL(
           inp_vars[i],
@@ -81,17 +88,44 @@ class SaveCombineOpKernel : public framework::OpKernel<T> {
       auto out_dtype =
           save_as_fp16 ? framework::proto::VarType::FP16 : in_dtype;
 
+      framework::LoDTensor out;
+      const framework::LoDTensor *to_save = &tensor;
       if (in_dtype != out_dtype) {
         auto in_kernel_type = framework::OpKernelType(in_dtype, place);
         auto out_kernel_type = framework::OpKernelType(out_dtype, place);
-        framework::LoDTensor out;
         // copy LoD info to the new tensor
         out.set_lod(tensor.lod());
         framework::TransDataType(in_kernel_type, out_kernel_type, tensor, &out);
-        framework::SerializeToStream(ss, out, dev_ctx);
+        to_save = &out;
+      }
+      if (!with_offset_index) {
+        framework::SerializeToStream(ss, *to_save, dev_ctx);
+        continue;
+      }
+      cpu_tensors.emplace_back();
+      if (platform::is_cpu_place(to_save->place())) {
+        cpu_tensors.back().ShareDataWith(*to_save);
+      } else {
+        framework::TensorCopySync(*to_save, platform::CPUPlace(),
+                                  &cpu_tensors.back());
+      }
+      cpu_tensors.back().set_lod(to_save->lod());
+    }
+    if (with_offset_index) {
+      std::vector<const framework::LoDTensor *> tensors;
+      for (auto &cpu_tensor : cpu_tensors) {
+        tensors.push_back(&cpu_tensor);
+      }
+      if (save_to_memory) {
+        PADDLE_ENFORCE_NE(output, nullptr,
+                          platform::errors::InvalidArgument(
+                              "Cannot find variable Y for save_combine_op"));
+        framework::SaveCheckpointToString(tensors, output);
       } else {
-        framework::SerializeToStream(ss, tensor, dev_ctx);
+        MkDirRecursively(DirName(filename).c_str());
+        framework::SaveCheckpoint(tensors, filename);
       }
+      return;
     }
     if (save_to_memory) {
       PADDLE_ENFORCE_NE(output, nullptr,
@@ -344,3 +344,61 @@ TEST(SaveLoadTestWithCombineOp, CPU) {
     }
   }
 }
+
+// Save the tensors to a checkpoint with the offset index, and load them back
+// by reading and by mapping the file, and from the memory.
+TEST(SaveLoadCombineOpWithOffsetIndex, CPU) {
+  paddle::framework::Scope scope;
+  paddle::platform::CPUPlace place;
+
+  std::vector<int> lod1 = {0, 1, 2, 3, 10};
+  int numel1 = 100;
+  paddle::framework::LoD expect_lod1;
+  int* expect1 = CreateForSaveCombineOp<int, int>(10, 10, lod1, "test_var1",
+                                                  place, &scope, &expect_lod1);
+
+  // larger than kCheckpointMmapMinSize, so that it is mapped
+  std::vector<int> lod2 = {0, 100, 1000};
+  int numel2 = 1000 * 100;
+  paddle::framework::LoD expect_lod2;
+  float* expect2 = CreateForSaveCombineOp<float, float>(
+      1000, 100, lod2, "test_var2", place, &scope, &expect_lod2);
+
+  std::string filename = "check_tensor_offset_index.ls";
+  paddle::framework::AttributeMap attrs;
+  attrs.insert({"file_path", std::string(filename)});
+  attrs.insert({"with_offset_index", true});
+  auto save_combine_op = paddle::framework::OpRegistry::CreateOp(
+      "save_combine", {{"X", {"test_var1", "test_var2"}}}, {}, attrs);
+  save_combine_op->Run(scope, place);
+
+  attrs.insert({"save_to_memory", true});
+  scope.Var("test_memory");
+  save_combine_op = paddle::framework::OpRegistry::CreateOp(
+      "save_combine", {{"X", {"test_var1", "test_var2"}}},
+      {{"Y", {"test_memory"}}}, attrs);
+  save_combine_op->Run(scope, place);
+  auto& memory = scope.FindVar("test_memory")->Get<std::string>();
+
+  for (int mode = 0; mode < 3; ++mode) {
+    paddle::framework::AttributeMap load_attrs;
+    load_attrs.insert({"file_path", mode < 2 ? filename : memory});
+    load_attrs.insert({"use_mmap", mode == 1});
+    load_attrs.insert({"model_from_memory", mode == 2});
+
+    auto target1 = GeneratePlaceholderBeforeLoad("out_var1", &scope);
+    auto target2 = GeneratePlaceholderBeforeLoad("out_var2", &scope);
+    auto load_combine_op = paddle::framework::OpRegistry::CreateOp(
+        "load_combine", {}, {{"Out", {"out_var1", "out_var2"}}}, load_attrs);
+    load_combine_op->Run(scope, place);
+
+    paddle::framework::LoD actual_lod1, actual_lod2;
+    int* actual1 =
+        GetValuesAfterLoadCombineOp<int>(target1, scope, &actual_lod1);
+    float* actual2 =
+        GetValuesAfterLoadCombineOp<float>(target2, scope, &actual_lod2);
+    CheckValues<int, int>(expect1, actual1, expect_lod1, actual_lod1, numel1);
+    CheckValues<float, float>(expect2, actual2, expect_lod2, actual_lod2,
+                              numel2);
+  }
+}
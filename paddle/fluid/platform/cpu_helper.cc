@@ -15,6 +15,10 @@ limitations under the License. */
 #include "paddle/fluid/platform/cpu_helper.h"
 #include "paddle/fluid/platform/enforce.h"
 
+#ifdef __linux__
+#include <sched.h>
+#endif
+
 #ifdef PADDLE_WITH_MKLML
 #include <omp.h>
 #include "paddle/fluid/platform/dynload/mklml.h"
@@ -47,5 +51,28 @@ void SetNumThreads(int num_threads) {
 #endif
 }
 
+bool SetThreadAffinity(const std::vector<int>& cpus) {
+#ifdef __linux__
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  for (int cpu : cpus) {
+    if (cpu >= 0 && cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &mask);
+    }
+  }
+  if (CPU_COUNT(&mask) == 0) {
+    return false;
+  }
+  if (sched_setaffinity(0, sizeof(mask), &mask) != 0) {
+    LOG(WARNING) << "Fail to set thread affinity to " << CPU_COUNT(&mask)
+                 << " CPUs";
+    return false;
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
 }  // namespace platform
 }  // namespace paddle
@@ -16,11 +16,17 @@ limitations under the License. */
 
 #include <stddef.h>
 
+#include <vector>
+
 namespace paddle {
 namespace platform {
 
 //! Set the number of threads in use.
 void SetNumThreads(int num_threads);
 
+//! Bind the calling thread to the CPUs. The threads it creates later, e.g.
+//! those of OpenMP, inherit the binding. Returns whether it succeeds.
+bool SetThreadAffinity(const std::vector<int>& cpus);
+
 }  // namespace platform
 }  // namespace paddle
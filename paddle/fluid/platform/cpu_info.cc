@@ -29,7 +29,18 @@ limitations under the License. */
 #include <unistd.h>
 #endif  // _WIN32
 
+#ifdef __linux__
+#include <dirent.h>
+#include <sched.h>
+#endif
+
 #include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
 #include "gflags/gflags.h"
 
 DECLARE_double(fraction_of_cpu_memory_to_use);
@@ -171,5 +182,95 @@ bool MayIUse(const cpu_isa_t cpu_isa) {
 }
 #endif
 
+#ifdef __linux__
+// Parse a list of CPUs in the format of sysfs, e.g. "0-3,8,10-11".
+static std::vector<int> ParseCpuList(const std::string &list) {
+  std::vector<int> cpus;
+  size_t pos = 0;
+  while (pos < list.size()) {
+    size_t end = list.find(',', pos);
+    if (end == std::string::npos) {
+      end = list.size();
+    }
+    std::string range = list.substr(pos, end - pos);
+    size_t dash = range.find('-');
+    try {
+      int first = std::stoi(range.substr(0, dash));
+      int last =
+          dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+      for (int cpu = first; cpu <= last; ++cpu) {
+        cpus.push_back(cpu);
+      }
+    } catch (std::exception &) {
+      // a blank line or a malformed range
+    }
+    pos = end + 1;
+  }
+  return cpus;
+}
+#endif
+
+std::vector<std::vector<int>> GetNumaNodeCpus() {
+  std::vector<std::vector<int>> nodes;
+  std::vector<int> all_cpus;
+#ifdef __linux__
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  bool has_allowed = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+  auto is_allowed = [&](int cpu) {
+    return !has_allowed ||
+           (cpu >= 0 && cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed));
+  };
+
+  // the node ids may not be contiguous
+  std::vector<std::pair<int, std::string>> node_dirs;
+  const std::string root = "/sys/devices/system/node";
+  if (DIR *dir = opendir(root.c_str())) {
+    while (struct dirent *entry = readdir(dir)) {
+      std::string name = entry->d_name;
+      if (name.size() > 4 && name.compare(0, 4, "node") == 0 &&
+          std::all_of(name.begin() + 4, name.end(), ::isdigit)) {
+        node_dirs.emplace_back(std::stoi(name.substr(4)), root + "/" + name);
+      }
+    }
+    closedir(dir);
+  }
+  std::sort(node_dirs.begin(), node_dirs.end());
+  for (auto &node_dir : node_dirs) {
+    std::ifstream file(node_dir.second + "/cpulist");
+    std::string list;
+    std::getline(file, list);
+    std::vector<int> cpus;
+    for (int cpu : ParseCpuList(list)) {
+      if (is_allowed(cpu)) {
+        cpus.push_back(cpu);
+      }
+    }
+    // the nodes of memory only, or of the CPUs not allowed
+    if (!cpus.empty()) {
+      nodes.push_back(std::move(cpus));
+    }
+  }
+  if (has_allowed) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &allowed)) {
+        all_cpus.push_back(cpu);
+      }
+    }
+  }
+#endif
+  if (nodes.empty()) {
+    if (all_cpus.empty()) {
+      int num = std::max(static_cast<int>(std::thread::hardware_concurrency()),
+                         1);
+      for (int cpu = 0; cpu < num; ++cpu) {
+        all_cpus.push_back(cpu);
+      }
+    }
+    nodes.push_back(std::move(all_cpus));
+  }
+  return nodes;
+}
+
 }  // namespace platform
 }  // namespace paddle
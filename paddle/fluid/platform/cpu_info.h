@@ -16,6 +16,8 @@ limitations under the License. */
 
 #include <stddef.h>
 
+#include <vector>
+
 #ifdef _WIN32
 #if defined(__AVX2__)
 #include <immintrin.h>  // avx2
@@ -87,5 +89,9 @@ typedef enum {
 // May I use some instruction
 bool MayIUse(const cpu_isa_t cpu_isa);
 
+//! Get the CPUs the process may run on, grouped by their NUMA nodes, or in
+//! one group if the nodes are unknown.
+std::vector<std::vector<int>> GetNumaNodeCpus();
+
 }  // namespace platform
 }  // namespace paddle
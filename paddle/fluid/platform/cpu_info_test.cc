@@ -14,6 +14,7 @@
 #include "paddle/fluid/platform/cpu_info.h"
 
 #include <ostream>
+#include <set>
 #include <sstream>
 
 #include "gflags/gflags.h"
@@ -32,3 +33,17 @@ TEST(CpuMemoryUsage, Print) {
                                        use_percent, memory_size)
             << std::endl;
 }
+
+TEST(CpuInfo, NumaNodeCpus) {
+  auto nodes = paddle::platform::GetNumaNodeCpus();
+  ASSERT_FALSE(nodes.empty());
+  std::set<int> cpus;
+  for (auto& node : nodes) {
+    EXPECT_FALSE(node.empty());
+    for (int cpu : node) {
+      EXPECT_GE(cpu, 0);
+      // each CPU is of one node
+      EXPECT_TRUE(cpus.insert(cpu).second);
+    }
+  }
+}
@@ -13,14 +13,30 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include "paddle/fluid/platform/device_code.h"
+#include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
 #include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <set>
+#include <sstream>
 #include <utility>
 #include "paddle/fluid/platform/enforce.h"
 
 DECLARE_string(cuda_dir);
 
+DEFINE_string(cpu_jit_compiler, "c++",
+              "The C++ compiler used to compile the code generated for CPU "
+              "at runtime, such as the fused kernels of fusion_group. It is "
+              "the name or the path of the program, which is run without a "
+              "shell.");
+
 namespace paddle {
 namespace platform {
 
@@ -64,27 +80,203 @@ DeviceCodePool::DeviceCodePool(const std::vector<platform::Place>& places) {
       places.size(), 0,
       errors::InvalidArgument(
           "Expected the number of places >= 1. Expected %d.", places.size()));
+  AddPlaces(places);
+}
+
+void DeviceCodePool::AddPlaces(const std::vector<platform::Place>& places) {
   // Remove the duplicated places
   std::set<Place> set;
   for (auto& p : places) {
-    set.insert(p);
+    if (device_codes_.find(p) == device_codes_.end()) {
+      set.insert(p);
+    }
   }
+  bool has_cpu_place = false;
+#ifdef PADDLE_WITH_CUDA
+  bool has_gpu_place = false;
+#endif
   for (auto& p : set) {
     if (is_gpu_place(p)) {
 #ifdef PADDLE_WITH_CUDA
       device_codes_.emplace(p, DeviceCodeMap());
+      has_gpu_place = true;
 #else
       PADDLE_THROW(platform::errors::PreconditionNotMet(
           "CUDAPlace is not supported, please re-compile with WITH_GPU=ON."));
 #endif
+    } else if (is_cpu_place(p)) {
+      device_codes_.emplace(p, DeviceCodeMap());
+      has_cpu_place = true;
     }
   }
 
+  if (has_cpu_place) {
+    CPUDeviceCode::CheckAvailableStatus();
+  }
 #ifdef PADDLE_WITH_CUDA
-  CUDADeviceCode::CheckAvailableStatus();
+  if (has_gpu_place) {
+    CUDADeviceCode::CheckAvailableStatus();
+  }
 #endif
 }
 
+static std::string ReadFile(const std::string& path) {
+  std::ifstream fin(path);
+  std::stringstream ss;
+  ss << fin.rdbuf();
+  return ss.str();
+}
+
+// Run the program args[0], searched in PATH, with the arguments and without
+// a shell, and write its output to log_path. Return whether it exits with 0.
+static bool RunProgram(const std::vector<std::string>& args,
+                       const std::string& log_path) {
+  // The child only calls async-signal-safe functions before exec, since the
+  // other threads of the process may hold the locks, e.g. that of malloc.
+  std::vector<char*> argv;
+  for (auto& arg : args) {
+    argv.push_back(const_cast<char*>(arg.c_str()));
+  }
+  argv.push_back(nullptr);
+  pid_t pid = fork();
+  if (pid < 0) {
+    LOG(WARNING) << "Cannot fork to run " << args[0] << ": "
+                 << strerror(errno);
+    return false;
+  }
+  if (pid == 0) {
+    int fd = open(log_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd >= 0) {
+      dup2(fd, STDOUT_FILENO);
+      dup2(fd, STDERR_FILENO);
+      close(fd);
+    }
+    execvp(argv[0], argv.data());
+    _exit(127);
+  }
+  int status = 0;
+  while (waitpid(pid, &status, 0) < 0) {
+    if (errno != EINTR) {
+      return false;
+    }
+  }
+  return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+bool CPUDeviceCode::available_ = false;
+void CPUDeviceCode::CheckAvailableStatus() {
+  available_ = RunProgram({FLAGS_cpu_jit_compiler, "--version"}, "/dev/null");
+  if (!available_) {
+    LOG_FIRST_N(WARNING, 1) << "The C++ compiler " << FLAGS_cpu_jit_compiler
+                            << " is needed for JIT compiling of CPU code, "
+                               "please specify it by export "
+                               "FLAGS_cpu_jit_compiler=xxx.";
+  }
+}
+
+CPUDeviceCode::CPUDeviceCode(const Place& place, const std::string& name,
+                             const std::string& kernel) {
+  if (!is_cpu_place(place)) {
+    PADDLE_THROW(platform::errors::PermissionDenied(
+        "CPUDeviceCode can only launch on CPU place."));
+  }
+
+  place_ = place;
+  name_ = name;
+  kernel_ = kernel;
+}
+
+CPUDeviceCode::~CPUDeviceCode() {
+  if (handle_ != nullptr) {
+    dlclose(handle_);
+  }
+}
+
+bool CPUDeviceCode::Compile(bool include_path) {
+  is_compiled_ = false;
+  if (handle_ != nullptr) {
+    dlclose(handle_);
+    handle_ = nullptr;
+  }
+  const char* tmp_dir = std::getenv("TMPDIR");
+  std::string dir = std::string(tmp_dir != nullptr ? tmp_dir : "/tmp") +
+                    "/paddle_device_code_XXXXXX";
+  if (mkdtemp(&dir[0]) == nullptr) {
+    LOG_FIRST_N(WARNING, 1) << "Cannot create the directory " << dir
+                            << " for JIT compiling of CPU code.";
+    return false;
+  }
+  std::string src_path = dir + "/" + name_ + ".cc";
+  std::string lib_path = dir + "/" + name_ + ".so";
+  std::string log_path = dir + "/compile.log";
+  auto remove_files = [&] {
+    for (auto& path : {src_path, lib_path, log_path}) {
+      std::remove(path.c_str());
+    }
+    rmdir(dir.c_str());
+  };
+
+  {
+    std::ofstream fout(src_path);
+    fout << kernel_;
+  }
+  // The code is compiled for the instruction set Paddle is built for, e.g.
+  // -mavx with WITH_AVX, so it runs wherever Paddle does. -ffast-math is not
+  // used, so the IEEE semantics are kept, while -fno-math-errno lets sqrt
+  // be vectorized.
+  std::vector<std::string> args{FLAGS_cpu_jit_compiler, "-std=c++11", "-O3",
+                                "-fno-math-errno", "-fPIC", "-shared"};
+#ifdef __SSE3__
+  args.push_back("-msse3");
+#endif
+#ifdef __AVX__
+  args.push_back("-mavx");
+#endif
+#ifdef __AVX2__
+  args.push_back("-mavx2");
+#endif
+#ifdef __FMA__
+  args.push_back("-mfma");
+#endif
+#ifdef __AVX512F__
+  args.push_back("-mavx512f");
+#endif
+  args.insert(args.end(), {"-o", lib_path, src_path});
+  if (!RunProgram(args, log_path)) {
+    LOG(WARNING) << "JIT compiling of CPU code failed:"
+                 << "\n  Kernel name: " << name_ << "\n  Kernel body:\n"
+                 << kernel_ << "\n  Compiling log: " << ReadFile(log_path);
+    remove_files();
+    return false;
+  }
+
+  // The library is mapped into the process, so the files can be removed.
+  handle_ = dlopen(lib_path.c_str(), RTLD_NOW | RTLD_LOCAL);
+  remove_files();
+  if (handle_ == nullptr) {
+    LOG(WARNING) << "Fail to load the JIT compiled CPU code of < " << name_
+                 << " >: " << dlerror();
+    return false;
+  }
+  function_ = reinterpret_cast<KernelFunc>(dlsym(handle_, name_.c_str()));
+  if (function_ == nullptr) {
+    LOG(WARNING) << "Cannot find the function < " << name_
+                 << " > in the JIT compiled CPU code.";
+    return false;
+  }
+
+  is_compiled_ = true;
+  return true;
+}
+
+void CPUDeviceCode::Launch(const size_t n, std::vector<void*>* args) const {
+  PADDLE_ENFORCE_EQ(
+      is_compiled_, true,
+      errors::PreconditionNotMet(
+          "Please compile the code before launching the kernel."));
+  function_(0, n, args->data());
+}
+
 #ifdef PADDLE_WITH_CUDA
 static bool CheckCUDADriverResult(CUresult result, std::string caller,
                                   std::string kernel_name = "") {
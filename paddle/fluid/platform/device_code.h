@@ -43,6 +43,35 @@ class DeviceCode {
   std::string kernel_;
 };
 
+// Compile the code by the host C++ compiler, FLAGS_cpu_jit_compiler, into a
+// shared library, which is loaded into the process. The compiler is run by
+// fork and exec with its arguments, without a shell. The code should define
+// a function with the name of the DeviceCode and the signature:
+//   extern "C" void name(size_t begin, size_t end, void** args);
+// which computes the elements [begin, end). args follows the convention of
+// the CUDA kernels, where args[0] points to the number of elements, and the
+// others point to the arguments.
+class CPUDeviceCode : public DeviceCode {
+ public:
+  explicit CPUDeviceCode(const Place& place, const std::string& name,
+                         const std::string& kernel);
+  ~CPUDeviceCode();
+  bool Compile(bool include_path = false) override;
+  void Launch(const size_t n, std::vector<void*>* args) const override;
+
+  static void CheckAvailableStatus();
+  static bool IsAvailable() { return available_; }
+
+ private:
+  using KernelFunc = void (*)(size_t, size_t, void**);
+
+  static bool available_;
+
+  bool is_compiled_{false};
+  void* handle_{nullptr};
+  KernelFunc function_{nullptr};
+};
+
 #ifdef PADDLE_WITH_CUDA
 class CUDADeviceCode : public DeviceCode {
  public:
@@ -92,6 +121,8 @@ class DeviceCodePool {
   static DeviceCodePool& Init(const std::vector<platform::Place>& places) {
     if (pool == nullptr) {
       pool = new DeviceCodePool(places);
+    } else {
+      pool->AddPlaces(places);
     }
     return *pool;
   }
@@ -110,6 +141,9 @@ class DeviceCodePool {
   }
 
  private:
+  // Support the runtime compiling for the places not added yet.
+  void AddPlaces(const std::vector<platform::Place>& places);
+
   static DeviceCodePool* pool;
   std::map<Place, DeviceCodeMap> device_codes_;
   DISABLE_COPY_AND_ASSIGN(DeviceCodePool);
@@ -13,11 +13,16 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include "paddle/fluid/platform/device_code.h"
+#include <unistd.h>
+#include <string>
 #include <utility>
+#include "gflags/gflags.h"
 #include "gtest/gtest.h"
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/platform/init.h"
 
+DECLARE_string(cpu_jit_compiler);
+
 constexpr auto saxpy_code = R"(
 extern "C" __global__
 void saxpy_kernel(float a, float *x, float* y, float* z, size_t n) {
@@ -108,3 +113,87 @@ TEST(DeviceCodePool, cuda) {
   LOG(INFO) << "get ptr: " << code_get;
 }
 #endif
+
+constexpr auto saxpy_cpu_code = R"(
+#include <stddef.h>
+
+extern "C" void saxpy_cpu(size_t begin, size_t end, void** args) {
+  float a = *static_cast<float*>(args[1]);
+  const float* x = *static_cast<const float* const*>(args[2]);
+  const float* y = *static_cast<const float* const*>(args[3]);
+  float* z = *static_cast<float* const*>(args[4]);
+  for (size_t i = begin; i < end; ++i) {
+    z[i] = a * x[i] + y[i];
+  }
+}
+)";
+
+TEST(DeviceCode, cpu) {
+  paddle::platform::CPUPlace place;
+  paddle::platform::DeviceCodePool::Init({place});
+  if (!paddle::platform::CPUDeviceCode::IsAvailable()) {
+    return;
+  }
+
+  paddle::platform::CPUDeviceCode code(place, "saxpy_cpu", saxpy_cpu_code);
+  EXPECT_EQ(code.Compile(), true);
+
+  size_t n = 1000;
+  float scale = 2;
+  std::vector<float> x(n), y(n, 0.5), z(n, 0);
+  for (size_t i = 0; i < n; ++i) {
+    x[i] = static_cast<float>(i);
+  }
+  float* x_data = x.data();
+  float* y_data = y.data();
+  float* z_data = z.data();
+  std::vector<void*> args = {&n, &scale, &x_data, &y_data, &z_data};
+  code.Launch(n, &args);
+  for (size_t i = 0; i < n; i++) {
+    EXPECT_EQ(z[i], static_cast<float>(i) * scale + 0.5);
+  }
+
+  paddle::platform::CPUDeviceCode wrong_code(place, "saxpy_cpu",
+                                             "invalid c++ code");
+  EXPECT_EQ(wrong_code.Compile(), false);
+}
+
+TEST(DeviceCode, cpu_compiler_without_shell) {
+  paddle::platform::CPUPlace place;
+  paddle::platform::DeviceCodePool::Init({place});
+  if (!paddle::platform::CPUDeviceCode::IsAvailable()) {
+    return;
+  }
+
+  // the compiler is a single program, so the command is not run
+  std::string compiler = FLAGS_cpu_jit_compiler;
+  std::string touched =
+      "/tmp/device_code_test_" + std::to_string(getpid()) + ".touched";
+  FLAGS_cpu_jit_compiler = compiler + " --version; touch " + touched;
+  paddle::platform::CPUDeviceCode::CheckAvailableStatus();
+  EXPECT_FALSE(paddle::platform::CPUDeviceCode::IsAvailable());
+  paddle::platform::CPUDeviceCode code(place, "saxpy_cpu", saxpy_cpu_code);
+  EXPECT_FALSE(code.Compile());
+  EXPECT_NE(access(touched.c_str(), F_OK), 0);
+
+  FLAGS_cpu_jit_compiler = compiler;
+  paddle::platform::CPUDeviceCode::CheckAvailableStatus();
+  EXPECT_TRUE(paddle::platform::CPUDeviceCode::IsAvailable());
+}
+
+TEST(DeviceCodePool, cpu) {
+  paddle::platform::CPUPlace place;
+  paddle::platform::DeviceCodePool& pool =
+      paddle::platform::DeviceCodePool::Init({place});
+  if (!paddle::platform::CPUDeviceCode::IsAvailable()) {
+    return;
+  }
+
+  size_t num_device_codes_before = pool.size(place);
+  std::unique_ptr<paddle::platform::DeviceCode> code(
+      new paddle::platform::CPUDeviceCode(place, "saxpy_cpu_pool",
+                                          saxpy_cpu_code));
+  pool.Set(std::move(code));
+  EXPECT_EQ(pool.size(place), num_device_codes_before + 1);
+  EXPECT_NE(pool.Get(place, "saxpy_cpu_pool"), nullptr);
+}
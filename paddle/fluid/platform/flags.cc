@@ -45,6 +45,62 @@ DEFINE_bool(check_nan_inf, false,
             "Checking whether operator produce NAN/INF or not. It will be "
             "extremely slow so please use this flag wisely.");
 
+/**
+ * Operator related FLAG
+ * Name: FLAGS_op_trace_sample_period
+ * Since Version: 2.0.0
+ * Value Range: int32, default=0
+ * Example: FLAGS_op_trace_sample_period=10, trace one in every 10 runs of the
+ *          ops of each thread.
+ * Note: Enable the always-on OpTracer when the devices are initialized. It
+ *       keeps the last FLAGS_op_trace_buffer_size records of each thread,
+ *       which can be drained at runtime. 0 to disable it.
+ */
+DEFINE_int32(op_trace_sample_period, 0,
+             "Trace one in every op_trace_sample_period runs of the ops of "
+             "each thread by the OpTracer. 0 to disable it.");
+
+/**
+ * Operator related FLAG
+ * Name: FLAGS_op_trace_buffer_size
+ * Since Version: 2.0.0
+ * Value Range: int32, default=4096
+ * Example:
+ * Note: The number of the records the OpTracer keeps for each thread, which
+ *       is rounded up to a power of 2. The oldest records are overwritten
+ *       when the buffer is full.
+ */
+DEFINE_int32(op_trace_buffer_size, 4096,
+             "The number of the records the OpTracer keeps for each thread.");
+
+/**
+ * Operator related FLAG
+ * Name: FLAGS_stat_dump_interval
+ * Since Version: 2.0.0
+ * Value Range: int32, default=0
+ * Example: FLAGS_stat_dump_interval=60, dump the stats every minute.
+ * Note: The seconds between two dumps of the stats of platform/monitor.h,
+ *       e.g. the CPU memory in use and the ops run per second, which start
+ *       when the devices are initialized. 0 to disable the dumps.
+ */
+DEFINE_int32(stat_dump_interval, 0,
+             "The seconds between two dumps of the runtime stats. 0 to "
+             "disable the dumps.");
+
+/**
+ * Operator related FLAG
+ * Name: FLAGS_stat_dump_path
+ * Since Version: 2.0.0
+ * Value Range: string, default=empty
+ * Example: FLAGS_stat_dump_path=/tmp/stats.json
+ * Note: The file the stats are appended to every FLAGS_stat_dump_interval
+ *       seconds, one JSON object per line if it ends with .json, or else the
+ *       text. The stats are logged if it is empty.
+ */
+DEFINE_string(stat_dump_path, "",
+              "The file the runtime stats are appended to, in JSON lines if "
+              "it ends with .json. Empty to log them.");
+
 #ifdef PADDLE_WITH_CUDA
 
 /**
@@ -231,6 +287,21 @@ DEFINE_int32(communicator_send_queue_size, 20,
 DEFINE_int32(dist_threadpool_size, 0,
              "number of threads used for distributed executed.");
 
+/**
+ * Distributed related FLAG
+ * Name: FLAGS_selected_rows_open_addressing_index
+ * Since Version: 2.0.0
+ * Value Range: bool, default=false
+ * Example: FLAGS_selected_rows_open_addressing_index=true
+ * Note: Whether the SelectedRows created afterwards index their rows with an
+ *       open addressing hash table, whose lookups take no lock, instead of a
+ *       std::unordered_map guarded by a read-write lock. It speeds up the
+ *       sparse tables of the parameter server looked up by many threads.
+ */
+DEFINE_bool(selected_rows_open_addressing_index, false,
+            "Whether SelectedRows index their rows with a lock-free open "
+            "addressing hash table instead of std::unordered_map.");
+
 /**
  * Garbage collector related FLAG
  * Name: FLAGS_eager_delete_tensor_gb
@@ -315,7 +386,8 @@ static constexpr char kDefaultAllocatorStrategy[] = "auto_growth";
 #endif
 DEFINE_string(
     allocator_strategy, kDefaultAllocatorStrategy,
-    "The allocation strategy, enum in [naive_best_fit, auto_growth]. "
+    "The allocation strategy, enum in [naive_best_fit, auto_growth, "
+    "thread_local]. "
     "naive_best_fit means the original pre-allocated allocator of Paddle. "
     "auto_growth means the auto-growth allocator. "
     "These two strategies differ in GPU memory allocation. "
@@ -325,7 +397,13 @@ DEFINE_string(
     "size of models may be larger). auto_growth strategy would allocate "
     "GPU memory on demand, which allows users to start several Paddle jobs "
     "on the same GPU card but may lead to more memory fragmentation "
-    "(i.e., maximum batch size of models may be smaller).");
+    "(i.e., maximum batch size of models may be smaller). "
+    "On CPU, auto_growth uses the buddy allocator of naive_best_fit, or "
+    "allocates chunks on demand and can free idle chunks (see "
+    "FLAGS_free_idle_chunk) with FLAGS_use_auto_growth_cpu_allocator, and "
+    "thread_local makes each thread allocate from its own buddy allocator, "
+    "which avoids lock contention when many threads allocate tensors "
+    "concurrently.");
 
 /**
  * Memory related FLAG
@@ -359,6 +437,22 @@ DEFINE_double(fraction_of_cpu_memory_to_use, 1,
 DEFINE_uint64(initial_cpu_memory_in_mb, 500ul,
               "Initial CPU memory for PaddlePaddle, in MD unit.");
 
+/**
+ * Memory related FLAG
+ * Name: FLAGS_cpu_thread_cache_in_kb
+ * Since Version: 2.0.0
+ * Value Range: uint64, default=1024 (KB)
+ * Example: FLAGS_cpu_thread_cache_in_kb=0 disables the thread caches.
+ * Note: The maximum size of the small blocks freed to a CPU buddy allocator
+ *       which each thread caches, in KB. Small allocations are served from
+ *       the cache of the thread without locking the buddy allocator, and the
+ *       blocks left idle in the cache are returned to the buddy allocator
+ *       periodically.
+ */
+DEFINE_uint64(cpu_thread_cache_in_kb, 1024ul,
+              "Maximum size of the small blocks each thread caches for a CPU "
+              "buddy allocator, in KB. 0 disables the thread caches.");
+
 /**
  * Memory related FLAG
  * Name: FLAGS_fraction_of_cuda_pinned_memory_to_use
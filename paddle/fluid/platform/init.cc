@@ -30,10 +30,16 @@ limitations under the License. */
 #endif
 #include "paddle/fluid/platform/device_context.h"
 #include "paddle/fluid/platform/init.h"
+#include "paddle/fluid/platform/monitor.h"
+#include "paddle/fluid/platform/op_tracer.h"
 #include "paddle/fluid/platform/place.h"
 #include "paddle/fluid/string/piece.h"
 
 DECLARE_int32(paddle_num_threads);
+DECLARE_int32(op_trace_sample_period);
+DECLARE_int32(op_trace_buffer_size);
+DECLARE_int32(stat_dump_interval);
+DECLARE_string(stat_dump_path);
 DEFINE_int32(multiple_of_cupti_buffer_size, 1,
              "Multiple of the CUPTI device buffer size. If the timestamps have "
              "been dropped when you are profiling, try increasing this value.");
@@ -176,6 +182,16 @@ void InitDevices(bool init_p2p, const std::vector<int> devices) {
   platform::SetNumThreads(FLAGS_paddle_num_threads);
 #endif
 
+  if (FLAGS_op_trace_sample_period > 0) {
+    platform::OpTracer::Instance().Enable(FLAGS_op_trace_sample_period,
+                                          FLAGS_op_trace_buffer_size);
+  }
+
+  if (FLAGS_stat_dump_interval > 0 && !StatDumper::Instance().IsRunning()) {
+    StatDumper::Instance().Start(FLAGS_stat_dump_interval,
+                                 FLAGS_stat_dump_path);
+  }
+
 #if !defined(_WIN32) && !defined(__APPLE__) && !defined(__OSX__)
   if (platform::MayIUse(platform::avx)) {
 #ifndef __AVX__
@@ -13,10 +13,344 @@
 // limitations under the License.
 
 #include "paddle/fluid/platform/monitor.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
 #include <utility>
 
+#include "paddle/fluid/platform/enforce.h"
+
 namespace paddle {
-namespace platform {}  // namespace platform
+namespace platform {
+
+int64_t ExportedStatHistogram::percentile(double p) const {
+  if (count == 0) {
+    return 0;
+  }
+  int64_t rank = std::max<int64_t>(
+      static_cast<int64_t>(std::ceil(p * static_cast<double>(count))), 1);
+  int64_t seen = 0;
+  for (size_t i = 0; i < buckets.size(); ++i) {
+    seen += buckets[i];
+    if (seen >= rank) {
+      if (i == 0) {
+        return 0;
+      }
+      int64_t upper = i >= 63 ? INT64_MAX : (int64_t{1} << i) - 1;
+      return std::min(upper, max);
+    }
+  }
+  return max;
+}
+
+StatHistogram::StatHistogram(const std::string& name) {
+  for (auto& bucket : buckets_) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+  StatHistogramRegistry::Instance().add(name, this);
+}
+
+ExportedStatHistogram StatHistogram::Export(const std::string& key,
+                                            bool reset) {
+  ExportedStatHistogram exported;
+  exported.key = key;
+  exported.buckets.resize(kNumBuckets);
+  // The fields are not read at once, so they may disagree by the values
+  // observed meanwhile.
+  for (int i = 0; i < kNumBuckets; ++i) {
+    exported.buckets[i] = reset ? buckets_[i].exchange(0)
+                                : buckets_[i].load(std::memory_order_relaxed);
+  }
+  exported.count = reset ? count_.exchange(0) : count_.load();
+  exported.sum = reset ? sum_.exchange(0) : sum_.load();
+  exported.max = reset ? max_.exchange(0) : max_.load();
+  return exported;
+}
+
+StatHistogram* StatHistogramRegistry::get(const std::string& name) {
+  std::lock_guard<std::mutex> lg(mutex_);
+  auto it = histograms_.find(name);
+  return it == histograms_.end() ? nullptr : it->second;
+}
+
+int StatHistogramRegistry::add(const std::string& name,
+                               StatHistogram* histogram) {
+  std::lock_guard<std::mutex> lg(mutex_);
+  return histograms_.emplace(name, histogram).second ? 0 : -1;
+}
+
+std::vector<ExportedStatHistogram> StatHistogramRegistry::publish(bool reset) {
+  std::lock_guard<std::mutex> lg(mutex_);
+  std::vector<ExportedStatHistogram> exported;
+  exported.reserve(histograms_.size());
+  for (auto& kv : histograms_) {
+    exported.emplace_back(kv.second->Export(kv.first, reset));
+  }
+  return exported;
+}
+
+StatGauge::StatGauge(const std::string& name, std::function<int64_t()> getter)
+    : name_(name), getter_(std::move(getter)) {
+  StatGaugeRegistry::Instance().add(this);
+}
+
+StatGauge::~StatGauge() { StatGaugeRegistry::Instance().remove(this); }
+
+void StatGaugeRegistry::add(StatGauge* gauge) {
+  std::lock_guard<std::mutex> lg(mutex_);
+  gauges_.push_back(gauge);
+}
+
+void StatGaugeRegistry::remove(StatGauge* gauge) {
+  std::lock_guard<std::mutex> lg(mutex_);
+  gauges_.erase(std::remove(gauges_.begin(), gauges_.end(), gauge),
+                gauges_.end());
+}
+
+FloatStatGauge::FloatStatGauge(const std::string& name,
+                               std::function<float()> getter)
+    : name_(name), getter_(std::move(getter)) {
+  StatGaugeRegistry::Instance().add(this);
+}
+
+FloatStatGauge::~FloatStatGauge() {
+  StatGaugeRegistry::Instance().remove(this);
+}
+
+void StatGaugeRegistry::add(FloatStatGauge* gauge) {
+  std::lock_guard<std::mutex> lg(mutex_);
+  float_gauges_.push_back(gauge);
+}
+
+void StatGaugeRegistry::remove(FloatStatGauge* gauge) {
+  std::lock_guard<std::mutex> lg(mutex_);
+  float_gauges_.erase(
+      std::remove(float_gauges_.begin(), float_gauges_.end(), gauge),
+      float_gauges_.end());
+}
+
+std::vector<ExportedStatValue<float>> StatGaugeRegistry::publish_float() {
+  std::lock_guard<std::mutex> lg(mutex_);
+  std::vector<ExportedStatValue<float>> exported;
+  exported.reserve(float_gauges_.size());
+  for (auto* gauge : float_gauges_) {
+    exported.push_back({gauge->name(), gauge->get()});
+  }
+  return exported;
+}
+
+std::vector<ExportedStatValue<int64_t>> StatGaugeRegistry::publish() {
+  std::map<std::string, int64_t> sums;
+  {
+    std::lock_guard<std::mutex> lg(mutex_);
+    for (auto* gauge : gauges_) {
+      sums[gauge->name()] += gauge->get();
+    }
+  }
+  std::vector<ExportedStatValue<int64_t>> exported;
+  exported.reserve(sums.size());
+  for (auto& kv : sums) {
+    exported.push_back({kv.first, kv.second});
+  }
+  return exported;
+}
+
+template <typename T>
+static void SortByKey(std::vector<T>* stats) {
+  std::sort(stats->begin(), stats->end(),
+            [](const T& a, const T& b) { return a.key < b.key; });
+}
+
+StatsSnapshot StatsSnapshot::Take() {
+  StatsSnapshot snapshot;
+  snapshot.time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                         std::chrono::system_clock::now().time_since_epoch())
+                         .count();
+  snapshot.int_stats = StatRegistry<int64_t>::Instance().publish();
+  auto gauges = StatGaugeRegistry::Instance().publish();
+  snapshot.int_stats.insert(snapshot.int_stats.end(), gauges.begin(),
+                            gauges.end());
+  snapshot.float_stats = StatRegistry<float>::Instance().publish();
+  auto float_gauges = StatGaugeRegistry::Instance().publish_float();
+  snapshot.float_stats.insert(snapshot.float_stats.end(),
+                              float_gauges.begin(), float_gauges.end());
+  snapshot.histograms = StatHistogramRegistry::Instance().publish();
+  SortByKey(&snapshot.int_stats);
+  SortByKey(&snapshot.float_stats);
+  SortByKey(&snapshot.histograms);
+  return snapshot;
+}
+
+// The increase per second of each int stat since the former snapshot.
+static std::map<std::string, double> Rates(const StatsSnapshot& snapshot,
+                                           const StatsSnapshot* former) {
+  std::map<std::string, double> rates;
+  if (former == nullptr || snapshot.time_ms <= former->time_ms) {
+    return rates;
+  }
+  std::map<std::string, int64_t> former_values;
+  for (auto& stat : former->int_stats) {
+    former_values[stat.key] = stat.value;
+  }
+  double seconds = (snapshot.time_ms - former->time_ms) / 1000.0;
+  for (auto& stat : snapshot.int_stats) {
+    auto it = former_values.find(stat.key);
+    if (it != former_values.end()) {
+      rates[stat.key] = (stat.value - it->second) / seconds;
+    }
+  }
+  return rates;
+}
+
+void StatsSnapshot::WriteText(std::ostream& os,
+                              const StatsSnapshot* former) const {
+  auto rates = Rates(*this, former);
+  os << "[stats] time_ms=" << time_ms << "\n";
+  for (auto& stat : int_stats) {
+    os << stat.key << " " << stat.value;
+    auto it = rates.find(stat.key);
+    if (it != rates.end() && it->second != 0) {
+      os << " (" << std::showpos << it->second << std::noshowpos << "/s)";
+    }
+    os << "\n";
+  }
+  for (auto& stat : float_stats) {
+    os << stat.key << " " << stat.value << "\n";
+  }
+  for (auto& histogram : histograms) {
+    os << histogram.key << " count=" << histogram.count
+       << " mean=" << histogram.mean() << " p50=" << histogram.percentile(0.5)
+       << " p90=" << histogram.percentile(0.9)
+       << " p99=" << histogram.percentile(0.99) << " max=" << histogram.max
+       << "\n";
+  }
+}
+
+void StatsSnapshot::WriteJson(std::ostream& os,
+                              const StatsSnapshot* former) const {
+  auto rates = Rates(*this, former);
+  os << "{\"time_ms\": " << time_ms << ", \"stats\": {";
+  const char* sep = "";
+  for (auto& stat : int_stats) {
+    os << sep << "\"" << stat.key << "\": " << stat.value;
+    sep = ", ";
+  }
+  for (auto& stat : float_stats) {
+    os << sep << "\"" << stat.key << "\": " << stat.value;
+    sep = ", ";
+  }
+  os << "}, \"rates\": {";
+  sep = "";
+  for (auto& rate : rates) {
+    os << sep << "\"" << rate.first << "\": " << rate.second;
+    sep = ", ";
+  }
+  os << "}, \"histograms\": {";
+  sep = "";
+  for (auto& histogram : histograms) {
+    os << sep << "\"" << histogram.key << "\": {\"count\": " << histogram.count
+       << ", \"sum\": " << histogram.sum << ", \"mean\": " << histogram.mean()
+       << ", \"p50\": " << histogram.percentile(0.5)
+       << ", \"p90\": " << histogram.percentile(0.9)
+       << ", \"p99\": " << histogram.percentile(0.99)
+       << ", \"max\": " << histogram.max << "}";
+    sep = ", ";
+  }
+  os << "}}\n";
+}
+
+static bool IsJsonPath(const std::string& path) {
+  const std::string suffix = ".json";
+  return path.size() >= suffix.size() &&
+         path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+void DumpStats(const std::string& path) {
+  std::ofstream fout(path);
+  PADDLE_ENFORCE_EQ(static_cast<bool>(fout), true,
+                    platform::errors::Unavailable(
+                        "Cannot open file %s to dump the stats.", path));
+  auto snapshot = StatsSnapshot::Take();
+  if (IsJsonPath(path)) {
+    snapshot.WriteJson(fout);
+  } else {
+    snapshot.WriteText(fout);
+  }
+}
+
+StatDumper& StatDumper::Instance() {
+  static StatDumper dumper;
+  return dumper;
+}
+
+StatDumper::~StatDumper() { Stop(); }
+
+void StatDumper::Start(int interval_s, const std::string& path) {
+  PADDLE_ENFORCE_GT(interval_s, 0,
+                    platform::errors::InvalidArgument(
+                        "The interval of dumping the stats should be greater "
+                        "than 0, but got %d.",
+                        interval_s));
+  Stop();
+  std::lock_guard<std::mutex> lock(mutex_);
+  stop_ = false;
+  thread_.reset(new std::thread([this, interval_s, path] {
+    auto former = StatsSnapshot::Take();
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!cv_.wait_for(lock, std::chrono::seconds(interval_s),
+                         [this] { return stop_; })) {
+      lock.unlock();
+      Dump(path, &former);
+      lock.lock();
+    }
+  }));
+}
+
+void StatDumper::Dump(const std::string& path, StatsSnapshot* former) {
+  auto snapshot = StatsSnapshot::Take();
+  std::ostringstream os;
+  if (IsJsonPath(path)) {
+    snapshot.WriteJson(os, former);
+  } else {
+    snapshot.WriteText(os, former);
+  }
+  if (path.empty()) {
+    LOG(INFO) << os.str();
+  } else {
+    std::ofstream fout(path, std::ios::app);
+    if (fout) {
+      fout << os.str();
+    } else {
+      LOG(WARNING) << "Cannot open file " << path << " to dump the stats.";
+    }
+  }
+  *former = std::move(snapshot);
+}
+
+void StatDumper::Stop() {
+  std::unique_ptr<std::thread> thread;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+    thread = std::move(thread_);
+  }
+  cv_.notify_all();
+  if (thread) {
+    thread->join();
+  }
+}
+
+bool StatDumper::IsRunning() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return thread_ != nullptr;
+}
+
+}  // namespace platform
 }  // namespace paddle
 
 DEFINE_INT_STATUS(STAT_total_feasign_num_in_mem)
@@ -36,3 +370,11 @@ DEFINE_INT_STATUS(STAT_gpu12_mem_size)
 DEFINE_INT_STATUS(STAT_gpu13_mem_size)
 DEFINE_INT_STATUS(STAT_gpu14_mem_size)
 DEFINE_INT_STATUS(STAT_gpu15_mem_size)
+
+DEFINE_INT_STATUS(STAT_cpu_mem_in_use)
+DEFINE_INT_STATUS(STAT_cpu_mem_peak)
+DEFINE_INT_STATUS(STAT_cpu_mem_reserved)
+DEFINE_HISTOGRAM_STATUS(STAT_cpu_alloc_size)
+DEFINE_INT_STATUS(STAT_executor_op_count)
+DEFINE_HISTOGRAM_STATUS(STAT_executor_run_us)
+DEFINE_INT_STATUS(STAT_static_memory_arena_bytes)
@@ -15,10 +15,15 @@
 #pragma once
 
 #include <stdio.h>
+#include <stdint.h>
 #include <atomic>
+#include <condition_variable>  // NOLINT
+#include <functional>
 #include <memory>
 #include <mutex>  // NOLINT
+#include <ostream>
 #include <string>
+#include <thread>  // NOLINT
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -39,30 +44,45 @@ class MonitorRegistrar {
   void Touch() {}
 };
 
+// Add inc to v without a lock. std::atomic<float> has no fetch_add before
+// C++20, so the generic version retries a compare-and-swap.
+template <typename T>
+inline T AtomicAdd(std::atomic<T>* v, T inc) {
+  T old = v->load(std::memory_order_relaxed);
+  while (!v->compare_exchange_weak(old, old + inc,
+                                   std::memory_order_relaxed)) {
+  }
+  return old + inc;
+}
+
+inline int64_t AtomicAdd(std::atomic<int64_t>* v, int64_t inc) {
+  return v->fetch_add(inc, std::memory_order_relaxed) + inc;
+}
+
 template <typename T>
 class StatValue : public MonitorRegistrar {
-  T v_{0};
-  std::mutex mu_;
-  // We use lock rather than atomic for generic values
+  // The stats are updated on the hot paths, e.g. by each allocation, so they
+  // are lock-free atomics rather than values guarded by a mutex.
+  std::atomic<T> v_{0};
+
  public:
   explicit StatValue(const std::string& n) {
     StatRegistry<T>::Instance().add(n, this);
   }
-  T increase(T inc) {
-    std::lock_guard<std::mutex> lock(mu_);
-    return v_ += inc;
-  }
-  T decrease(T inc) {
-    std::lock_guard<std::mutex> lock(mu_);
-    return v_ -= inc;
-  }
+  T increase(T inc) { return AtomicAdd(&v_, inc); }
+  T decrease(T inc) { return AtomicAdd(&v_, -inc); }
+  // Return the value before the reset, which publish(reset) exports.
   T reset(T value = 0) {
-    std::lock_guard<std::mutex> lock(mu_);
-    return v_ = value;
+    return v_.exchange(value, std::memory_order_relaxed);
   }
-  T get() {
-    std::lock_guard<std::mutex> lock(mu_);
-    return v_;
+  T get() { return v_.load(std::memory_order_relaxed); }
+  // Raise the value to value if it is smaller, e.g. for a peak.
+  T update_max(T value) {
+    T old = v_.load(std::memory_order_relaxed);
+    while (old < value &&
+           !v_.compare_exchange_weak(old, value, std::memory_order_relaxed)) {
+    }
+    return old < value ? value : old;
   }
 };
 
@@ -123,6 +143,206 @@ class StatRegistry {
   std::unordered_map<std::string, StatValue<T>*> stats_;
 };
 
+struct ExportedStatHistogram {
+  std::string key;
+  int64_t count;
+  int64_t sum;
+  int64_t max;
+  // buckets[0] counts the values <= 0, and buckets[i] the values in
+  // [2^(i-1), 2^i)
+  std::vector<int64_t> buckets;
+
+  double mean() const {
+    return count == 0 ? 0.0 : static_cast<double>(sum) / count;
+  }
+  // The upper bound of the bucket of the percentile, which is at most twice
+  // the exact one.
+  int64_t percentile(double p) const;
+};
+
+/*
+ * @brief The distribution of a value, e.g. the latency of a run of a
+ * program, in power-of-2 buckets.
+ *
+ * An observation costs a few relaxed atomic adds, so that it can be made on
+ * the hot paths, and the percentiles are estimated from the buckets when the
+ * histogram is exported.
+ */
+class StatHistogram : public MonitorRegistrar {
+ public:
+  static constexpr int kNumBuckets = 64;
+
+  explicit StatHistogram(const std::string& name);
+
+  void Observe(int64_t value) {
+    buckets_[Bucket(value)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+    int64_t max = max_.load(std::memory_order_relaxed);
+    while (max < value &&
+           !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+    }
+  }
+
+  ExportedStatHistogram Export(const std::string& key, bool reset = false);
+
+  static int Bucket(int64_t value) {
+    if (value <= 0) {
+      return 0;
+    }
+#if defined(__GNUC__) || defined(__clang__)
+    return 64 - __builtin_clzll(static_cast<uint64_t>(value));
+#else
+    int bucket = 0;
+    for (uint64_t v = static_cast<uint64_t>(value); v != 0; v >>= 1) {
+      ++bucket;
+    }
+    return bucket;
+#endif
+  }
+
+ private:
+  std::atomic<int64_t> buckets_[kNumBuckets];
+  std::atomic<int64_t> count_{0};
+  std::atomic<int64_t> sum_{0};
+  std::atomic<int64_t> max_{0};
+};
+
+class StatHistogramRegistry {
+ public:
+  static StatHistogramRegistry& Instance() {
+    static StatHistogramRegistry r;
+    return r;
+  }
+  StatHistogram* get(const std::string& name);
+  int add(const std::string& name, StatHistogram* histogram);
+  std::vector<ExportedStatHistogram> publish(bool reset = false);
+
+ private:
+  std::mutex mutex_;
+  std::unordered_map<std::string, StatHistogram*> histograms_;
+};
+
+/*
+ * @brief A value sampled when the stats are exported, e.g. the depth of a
+ * queue, which would otherwise cost an update of a counter by every push and
+ * pop.
+ *
+ * The gauge is registered while it lives, and the values of the gauges of
+ * the same name are summed, e.g. over the queues of the readers. The getter
+ * is called under the lock of the registry, so the gauge must be destroyed
+ * before the object it samples.
+ */
+class StatGauge {
+ public:
+  StatGauge(const std::string& name, std::function<int64_t()> getter);
+  ~StatGauge();
+
+  const std::string& name() const { return name_; }
+  int64_t get() const { return getter_(); }
+
+ private:
+  std::string name_;
+  std::function<int64_t()> getter_;
+
+  StatGauge(const StatGauge&) = delete;
+  StatGauge& operator=(const StatGauge&) = delete;
+};
+
+/*
+ * @brief A float value sampled when the stats are exported, e.g. a ratio of
+ * two int stats, which would otherwise be computed by every update of them.
+ * Unlike the int gauges, each name has at most one float gauge.
+ */
+class FloatStatGauge {
+ public:
+  FloatStatGauge(const std::string& name, std::function<float()> getter);
+  ~FloatStatGauge();
+
+  const std::string& name() const { return name_; }
+  float get() const { return getter_(); }
+
+ private:
+  std::string name_;
+  std::function<float()> getter_;
+
+  FloatStatGauge(const FloatStatGauge&) = delete;
+  FloatStatGauge& operator=(const FloatStatGauge&) = delete;
+};
+
+class StatGaugeRegistry {
+ public:
+  static StatGaugeRegistry& Instance() {
+    static StatGaugeRegistry r;
+    return r;
+  }
+  void add(StatGauge* gauge);
+  void remove(StatGauge* gauge);
+  void add(FloatStatGauge* gauge);
+  void remove(FloatStatGauge* gauge);
+  // The sums of the gauges of each name.
+  std::vector<ExportedStatValue<int64_t>> publish();
+  std::vector<ExportedStatValue<float>> publish_float();
+
+ private:
+  std::mutex mutex_;
+  std::vector<StatGauge*> gauges_;
+  std::vector<FloatStatGauge*> float_gauges_;
+};
+
+/*
+ * @brief The values of all the registered stats, histograms and gauges at
+ * a time, sorted by the names.
+ */
+struct StatsSnapshot {
+  static StatsSnapshot Take();
+
+  // The increases of the int stats and gauges per second since the former
+  // snapshot are written as their rates if it is given, e.g. the ops run per
+  // second.
+  void WriteText(std::ostream& os, const StatsSnapshot* former = nullptr) const;
+  // One line of JSON object.
+  void WriteJson(std::ostream& os, const StatsSnapshot* former = nullptr) const;
+
+  int64_t time_ms;
+  std::vector<ExportedStatValue<int64_t>> int_stats;
+  std::vector<ExportedStatValue<float>> float_stats;
+  std::vector<ExportedStatHistogram> histograms;
+};
+
+/*
+ * @brief Append a snapshot of the stats to a file periodically, from a
+ * thread of its own.
+ */
+class StatDumper {
+ public:
+  static StatDumper& Instance();
+
+  /*
+   * @param interval_s the seconds between two dumps.
+   * @param path the file the snapshots are appended to, one JSON object per
+   * line if it ends with .json, or else the text. Empty to log them.
+   */
+  void Start(int interval_s, const std::string& path);
+  void Stop();
+  bool IsRunning();
+
+  ~StatDumper();
+
+ private:
+  StatDumper() = default;
+  void Dump(const std::string& path, StatsSnapshot* former);
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stop_{false};
+  std::unique_ptr<std::thread> thread_;
+};
+
+// Write a snapshot of the stats to the file, in JSON if the path ends with
+// .json, or else in the text.
+void DumpStats(const std::string& path);
+
 }  // namespace platform
 }  // namespace paddle
 
@@ -140,6 +360,9 @@ class StatRegistry {
 #define STAT_FLOAT_SUB(item, t) \
   paddle::platform::StatRegistry<float>::Instance().get(item)->decrease(t)
 
+#define STAT_UPDATE_MAX(item, t) _##item.update_max(t)
+#define STAT_OBSERVE(item, t) _##item.Observe(t)
+
 #define STAT_RESET(item, t) _##item.reset(t)
 #define STAT_GET(item) _##item.get()
 
@@ -157,6 +380,13 @@ class StatRegistry {
     return 0;                                          \
   }
 
+#define DEFINE_HISTOGRAM_STATUS(item)             \
+  paddle::platform::StatHistogram _##item(#item); \
+  int TouchStatRegistrar_##item() {               \
+    _##item.Touch();                              \
+    return 0;                                     \
+  }
+
 #define USE_STAT(item)                    \
   extern int TouchStatRegistrar_##item(); \
   UNUSED static int use_stat_##item = TouchStatRegistrar_##item()
@@ -169,6 +399,10 @@ class StatRegistry {
   extern paddle::platform::StatValue<float> _##item; \
   USE_STAT(item)
 
+#define USE_HISTOGRAM_STAT(item)                  \
+  extern paddle::platform::StatHistogram _##item; \
+  USE_STAT(item)
+
 #define USE_GPU_MEM_STAT             \
   USE_INT_STAT(STAT_gpu0_mem_size);  \
   USE_INT_STAT(STAT_gpu1_mem_size);  \
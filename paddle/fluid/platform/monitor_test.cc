@@ -0,0 +1,137 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/platform/monitor.h"
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+
+DEFINE_INT_STATUS(STAT_monitor_test_count)
+DEFINE_FLOAT_STATUS(STAT_monitor_test_ratio)
+DEFINE_HISTOGRAM_STATUS(STAT_monitor_test_latency)
+
+namespace platform = paddle::platform;
+
+TEST(StatValue, ConcurrentIncrease) {
+  STAT_RESET(STAT_monitor_test_count, 0);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([] {
+      for (int j = 0; j < 10000; ++j) {
+        STAT_ADD(STAT_monitor_test_count, 2);
+        STAT_SUB(STAT_monitor_test_count, 1);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(STAT_GET(STAT_monitor_test_count), 40000);
+  EXPECT_EQ(STAT_UPDATE_MAX(STAT_monitor_test_count, 10), 40000);
+  EXPECT_EQ(STAT_UPDATE_MAX(STAT_monitor_test_count, 50000), 50000);
+  EXPECT_EQ(STAT_RESET(STAT_monitor_test_count, 0), 50000);
+
+  STAT_RESET(STAT_monitor_test_ratio, 0.5f);
+  EXPECT_FLOAT_EQ(STAT_FLOAT_ADD("STAT_monitor_test_ratio", 0.25f), 0.75f);
+}
+
+TEST(StatHistogram, Percentile) {
+  EXPECT_EQ(platform::StatHistogram::Bucket(0), 0);
+  EXPECT_EQ(platform::StatHistogram::Bucket(1), 1);
+  EXPECT_EQ(platform::StatHistogram::Bucket(7), 3);
+  EXPECT_EQ(platform::StatHistogram::Bucket(8), 4);
+
+  _STAT_monitor_test_latency.Export("", true);
+  for (int64_t i = 1; i <= 100; ++i) {
+    STAT_OBSERVE(STAT_monitor_test_latency, i);
+  }
+  auto histogram = _STAT_monitor_test_latency.Export("latency");
+  EXPECT_EQ(histogram.count, 100);
+  EXPECT_EQ(histogram.sum, 5050);
+  EXPECT_EQ(histogram.max, 100);
+  EXPECT_DOUBLE_EQ(histogram.mean(), 50.5);
+  // 50 is in [32, 64), 90 and 99 in [64, 128) which is capped by the max
+  EXPECT_EQ(histogram.percentile(0.5), 63);
+  EXPECT_EQ(histogram.percentile(0.9), 100);
+  EXPECT_EQ(histogram.percentile(0.01), 1);
+}
+
+TEST(StatGauge, SumAndRemove) {
+  int64_t size = 3;
+  platform::StatGauge gauge("STAT_monitor_test_queue_size",
+                            [&size] { return size; });
+  std::unique_ptr<platform::StatGauge> other(new platform::StatGauge(
+      "STAT_monitor_test_queue_size", [] { return int64_t{4}; }));
+
+  auto find = [] {
+    for (auto& stat : platform::StatGaugeRegistry::Instance().publish()) {
+      if (stat.key == "STAT_monitor_test_queue_size") {
+        return stat.value;
+      }
+    }
+    return int64_t{-1};
+  };
+  EXPECT_EQ(find(), 7);
+  size = 5;
+  other.reset();
+  EXPECT_EQ(find(), 5);
+}
+
+TEST(FloatStatGauge, SampledBySnapshot) {
+  float ratio = 0.25f;
+  std::unique_ptr<platform::FloatStatGauge> gauge(new platform::FloatStatGauge(
+      "STAT_monitor_test_gauge_ratio", [&ratio] { return ratio; }));
+
+  auto find = [] {
+    for (auto& stat : platform::StatsSnapshot::Take().float_stats) {
+      if (stat.key == "STAT_monitor_test_gauge_ratio") {
+        return stat.value;
+      }
+    }
+    return -1.0f;
+  };
+  EXPECT_FLOAT_EQ(find(), 0.25f);
+  ratio = 0.5f;
+  EXPECT_FLOAT_EQ(find(), 0.5f);
+  gauge.reset();
+  EXPECT_FLOAT_EQ(find(), -1.0f);
+}
+
+TEST(StatsSnapshot, Write) {
+  STAT_RESET(STAT_monitor_test_count, 10);
+  auto former = platform::StatsSnapshot::Take();
+  STAT_ADD(STAT_monitor_test_count, 20);
+  auto snapshot = platform::StatsSnapshot::Take();
+  snapshot.time_ms = former.time_ms + 2000;
+
+  std::ostringstream text;
+  snapshot.WriteText(text, &former);
+  EXPECT_NE(text.str().find("STAT_monitor_test_count 30 (+10/s)\n"),
+            std::string::npos);
+  EXPECT_NE(text.str().find("STAT_monitor_test_latency count="),
+            std::string::npos);
+
+  std::ostringstream json;
+  snapshot.WriteJson(json, &former);
+  EXPECT_NE(json.str().find("\"STAT_monitor_test_count\": 30"),
+            std::string::npos);
+  EXPECT_NE(json.str().find("\"rates\": {"), std::string::npos);
+  EXPECT_NE(json.str().find("\"STAT_monitor_test_latency\": {\"count\": "),
+            std::string::npos);
+}
@@ -0,0 +1,215 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/platform/op_tracer.h"
+
+#include <string.h>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace platform {
+
+static size_t RoundUpToPowerOfTwo(size_t n) {
+  size_t power = 1;
+  while (power < n) {
+    power <<= 1;
+  }
+  return power;
+}
+
+constexpr size_t OpTraceRecord::kMaxNameLength;
+
+OpTraceRing::OpTraceRing(uint32_t thread_id, size_t capacity)
+    : thread_id_(thread_id),
+      records_(RoundUpToPowerOfTwo(std::max<size_t>(capacity, 1))),
+      mask_(records_.size() - 1) {}
+
+size_t OpTraceRing::Drain(std::vector<OpTraceRecord>* out) {
+  uint64_t head = head_.load(std::memory_order_acquire);
+  size_t lost = 0;
+  // the records before head - capacity were overwritten before the drain
+  if (head - tail_ > records_.size()) {
+    lost += head - records_.size() - tail_;
+    tail_ = head - records_.size();
+  }
+  size_t begin = out->size();
+  for (uint64_t i = tail_; i < head; ++i) {
+    out->push_back(records_[i & mask_]);
+  }
+  // The writes started during the copy may have overwritten the records
+  // before the last of them minus the capacity.
+  std::atomic_thread_fence(std::memory_order_acquire);
+  uint64_t started = started_.load(std::memory_order_relaxed);
+  if (started > tail_ + records_.size()) {
+    size_t overwritten = std::min<uint64_t>(
+        started - records_.size() - tail_, head - tail_);
+    out->erase(out->begin() + begin, out->begin() + begin + overwritten);
+    lost += overwritten;
+  }
+  tail_ = head;
+  return lost;
+}
+
+std::atomic<bool> OpTracer::enabled_{false};
+
+OpTracer& OpTracer::Instance() {
+  static OpTracer tracer;
+  return tracer;
+}
+
+void OpTracer::Enable(int sample_period, size_t buffer_size) {
+  PADDLE_ENFORCE_GT(sample_period, 0,
+                    platform::errors::InvalidArgument(
+                        "The sample period of the OpTracer should be greater "
+                        "than 0, but got %d.",
+                        sample_period));
+  PADDLE_ENFORCE_GT(buffer_size, 0UL,
+                    platform::errors::InvalidArgument(
+                        "The buffer size of the OpTracer should be greater "
+                        "than 0."));
+  sample_period_.store(sample_period);
+  buffer_size_.store(buffer_size);
+  enabled_.store(true);
+}
+
+void OpTracer::Disable() { enabled_.store(false); }
+
+namespace {
+
+// Marks the ring of a thread as exited when the thread exits, so that the
+// ring is dropped once drained.
+struct ThreadRingHolder {
+  std::shared_ptr<OpTraceRing> ring;
+  ~ThreadRingHolder() {
+    if (ring) {
+      ring->set_exited();
+    }
+  }
+};
+
+}  // namespace
+
+OpTraceRing* OpTracer::ThreadRing() {
+  static thread_local ThreadRingHolder holder;
+  if (!holder.ring) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    holder.ring.reset(new OpTraceRing(next_thread_id_++, buffer_size_.load()));
+    rings_.push_back(holder.ring);
+  }
+  return holder.ring.get();
+}
+
+int64_t& OpTracer::ThreadAllocatedBytes() {
+  static thread_local int64_t allocated_bytes = 0;
+  return allocated_bytes;
+}
+
+std::vector<OpTraceRecord> OpTracer::Drain() {
+  std::lock_guard<std::mutex> drain_guard(drain_mutex_);
+  std::vector<std::shared_ptr<OpTraceRing>> rings;
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    rings = rings_;
+  }
+
+  std::vector<OpTraceRecord> records;
+  size_t lost = 0;
+  for (auto& ring : rings) {
+    lost += ring->Drain(&records);
+  }
+  lost_ += lost;
+
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    rings_.erase(std::remove_if(rings_.begin(), rings_.end(),
+                                [](const std::shared_ptr<OpTraceRing>& ring) {
+                                  return ring->exited() && ring->empty();
+                                }),
+                 rings_.end());
+  }
+
+  std::sort(records.begin(), records.end(),
+            [](const OpTraceRecord& a, const OpTraceRecord& b) {
+              return a.start_ns < b.start_ns;
+            });
+  return records;
+}
+
+void ScopedOpTrace::Start(const std::string& name) {
+  auto& tracer = OpTracer::Instance();
+  OpTraceRing* ring = tracer.ThreadRing();
+  if (!ring->Sample(tracer.sample_period())) {
+    return;
+  }
+  ring_ = ring;
+  size_t length = std::min(name.size(), OpTraceRecord::kMaxNameLength);
+  memcpy(record_.name, name.data(), length);
+  record_.name[length] = '\0';
+  record_.thread_id = ring->thread_id();
+  record_.allocated_bytes = OpTracer::ThreadAllocatedBytes();
+  record_.start_ns = OpTracer::NowNs();
+}
+
+void ScopedOpTrace::Stop() {
+  record_.end_ns = OpTracer::NowNs();
+  record_.allocated_bytes =
+      OpTracer::ThreadAllocatedBytes() - record_.allocated_bytes;
+  ring_->Push(record_);
+}
+
+static void WriteJsonString(const char* str, std::ostream& os) {
+  os << '"';
+  for (; *str != '\0'; ++str) {
+    if (*str == '"' || *str == '\\') {
+      os << '\\';
+    }
+    os << *str;
+  }
+  os << '"';
+}
+
+void ExportChromeTrace(const std::vector<OpTraceRecord>& records,
+                       std::ostream& os) {
+  os << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+  os << std::fixed << std::setprecision(3);
+  for (size_t i = 0; i < records.size(); ++i) {
+    auto& record = records[i];
+    os << (i == 0 ? "\n" : ",\n") << "{\"name\": ";
+    WriteJsonString(record.name, os);
+    os << ", \"cat\": \"op\", \"ph\": \"X\", \"pid\": 0"
+       << ", \"tid\": " << record.thread_id
+       << ", \"ts\": " << record.start_ns / 1000.0
+       << ", \"dur\": " << (record.end_ns - record.start_ns) / 1000.0
+       << ", \"args\": {\"allocated_bytes\": " << record.allocated_bytes
+       << "}}";
+  }
+  os << "\n]}\n";
+}
+
+size_t DumpOpTrace(const std::string& path) {
+  auto records = OpTracer::Instance().Drain();
+  std::ofstream fout(path);
+  PADDLE_ENFORCE_EQ(static_cast<bool>(fout), true,
+                    platform::errors::Unavailable(
+                        "Cannot open file %s to dump the op trace.", path));
+  ExportChromeTrace(records, fout);
+  return records.size();
+}
+
+}  // namespace platform
+}  // namespace paddle
@@ -0,0 +1,226 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/platform/macros.h"
+
+namespace paddle {
+namespace platform {
+
+// The fixed-size record of a run of an op.
+struct OpTraceRecord {
+  static constexpr size_t kMaxNameLength = 47;
+
+  // the op type, truncated to kMaxNameLength
+  char name[kMaxNameLength + 1];
+  uint32_t thread_id;
+  uint64_t start_ns;
+  uint64_t end_ns;
+  // the bytes allocated by the thread while the op ran
+  int64_t allocated_bytes;
+};
+
+/*
+ * The ring buffer of the records of a thread, which the thread writes
+ * without locks and the OpTracer drains from any thread.
+ *
+ * The writer overwrites the oldest records when the ring is full, so that
+ * tracing neither blocks nor grows the memory. Like a seqlock, the drain
+ * copies the records and then checks the writes started since, and drops
+ * the records the writer may have overwritten during the copy.
+ */
+class OpTraceRing {
+ public:
+  OpTraceRing(uint32_t thread_id, size_t capacity);
+
+  uint32_t thread_id() const { return thread_id_; }
+  size_t capacity() const { return records_.size(); }
+
+  // Called by the thread of the ring only.
+  void Push(const OpTraceRecord& record) {
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    // the record must not be written before the write is marked started,
+    // which the drain checks for overwritten records
+    started_.store(head + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    records_[head & mask_] = record;
+    head_.store(head + 1, std::memory_order_release);
+  }
+
+  // Called by the thread of the ring only, true for every sample_period
+  // calls.
+  bool Sample(int sample_period) {
+    if (++sample_count_ < sample_period) {
+      return false;
+    }
+    sample_count_ = 0;
+    return true;
+  }
+
+  /*
+   * Append the records pushed since the last drain to out. Only one drain
+   * of the ring may run at a time.
+   *
+   * @return the number of the records lost, which were overwritten before
+   * they were drained.
+   */
+  size_t Drain(std::vector<OpTraceRecord>* out);
+
+  // Set by the thread when it exits, after which the ring is dropped once
+  // drained.
+  void set_exited() { exited_.store(true, std::memory_order_release); }
+  bool exited() const { return exited_.load(std::memory_order_acquire); }
+  bool empty() const {
+    return head_.load(std::memory_order_acquire) == tail_;
+  }
+
+ private:
+  const uint32_t thread_id_;
+  std::vector<OpTraceRecord> records_;
+  const uint64_t mask_;
+  // the number of the records pushed, and of the pushes started
+  std::atomic<uint64_t> head_{0};
+  std::atomic<uint64_t> started_{0};
+  // the index of the next record to drain
+  uint64_t tail_{0};
+  int sample_count_{0};
+  std::atomic<bool> exited_{false};
+};
+
+/*
+ * @brief The always-on tracer of the runs of the ops.
+ *
+ * Unlike RecordEvent, which keeps every event until the profiler is
+ * disabled, the tracer keeps the last records of each thread in a ring of
+ * fixed size, and costs a relaxed load when it is disabled. The records can
+ * be drained at any time, e.g. periodically by a serving process, and
+ * exported in the Chrome trace format, which chrome://tracing and Perfetto
+ * open.
+ */
+class OpTracer {
+ public:
+  static OpTracer& Instance();
+
+  static bool IsEnabled() { return enabled_.load(std::memory_order_relaxed); }
+
+  /*
+   * @brief Trace one in every sample_period runs of the ops of each thread.
+   * @param buffer_size the number of the records kept for each thread, which
+   * is rounded up to a power of 2. It applies to the threads which have not
+   * traced yet.
+   */
+  void Enable(int sample_period = 1, size_t buffer_size = 4096);
+  void Disable();
+
+  int sample_period() const {
+    return sample_period_.load(std::memory_order_relaxed);
+  }
+
+  /*
+   * @return the records of all the threads pushed since the last drain,
+   * sorted by the start time.
+   */
+  std::vector<OpTraceRecord> Drain();
+
+  // The number of the records overwritten before they were drained.
+  size_t lost() const { return lost_.load(); }
+
+  // The ring of the calling thread, which is created on the first call.
+  OpTraceRing* ThreadRing();
+
+  // Count the bytes allocated by the calling thread while tracing.
+  static void RecordAlloc(size_t size) {
+    if (IsEnabled()) {
+      ThreadAllocatedBytes() += static_cast<int64_t>(size);
+    }
+  }
+  static int64_t& ThreadAllocatedBytes();
+
+  static uint64_t NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+ private:
+  OpTracer() = default;
+
+  static std::atomic<bool> enabled_;
+  std::atomic<int> sample_period_{1};
+  std::atomic<size_t> buffer_size_{4096};
+  std::atomic<size_t> lost_{0};
+
+  std::mutex mutex_;
+  std::vector<std::shared_ptr<OpTraceRing>> rings_;
+  uint32_t next_thread_id_{0};
+  // only one drain runs at a time
+  std::mutex drain_mutex_;
+
+  DISABLE_COPY_AND_ASSIGN(OpTracer);
+};
+
+/*
+ * @brief Traces the run of an op in its scope, if the tracer is enabled and
+ * the run is sampled.
+ */
+class ScopedOpTrace {
+ public:
+  explicit ScopedOpTrace(const std::string& name) {
+    if (!OpTracer::IsEnabled()) {
+      return;
+    }
+    Start(name);
+  }
+
+  ~ScopedOpTrace() {
+    if (ring_ != nullptr) {
+      Stop();
+    }
+  }
+
+ private:
+  void Start(const std::string& name);
+  void Stop();
+
+  OpTraceRing* ring_{nullptr};
+  OpTraceRecord record_;
+
+  DISABLE_COPY_AND_ASSIGN(ScopedOpTrace);
+};
+
+/*
+ * @brief Write the records in the JSON trace event format of
+ * chrome://tracing, as complete events in microseconds.
+ */
+void ExportChromeTrace(const std::vector<OpTraceRecord>& records,
+                       std::ostream& os);
+
+/*
+ * @brief Drain the records of the OpTracer to the Chrome trace file.
+ * @return the number of the records written.
+ */
+size_t DumpOpTrace(const std::string& path);
+
+}  // namespace platform
+}  // namespace paddle
@@ -0,0 +1,116 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Per-op cost of the OpTracer, disabled, tracing every op and sampling, and
+// of the two RecordEvents of OperatorBase::Run with the CPU profiler
+// enabled. The ops are empty scopes, so the time is the tracing overhead
+// itself. The threads trace concurrently, and a background thread drains
+// the rings every --drain_interval_ms, as a serving process would.
+//
+// Usage:
+//   ./op_tracer_benchmark --threads=4 --ops=200000
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <iostream>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+#include "gflags/gflags.h"
+#include "paddle/fluid/platform/op_tracer.h"
+#include "paddle/fluid/platform/profiler.h"
+
+DEFINE_int32(threads, 4, "Threads running the ops.");
+DEFINE_int32(ops, 200000, "Ops run by each thread.");
+DEFINE_int32(drain_interval_ms, 10,
+             "Interval of the drain of the OpTracer in the background.");
+
+namespace paddle {
+namespace platform {
+
+enum class Mode { kTracerOff, kTracer, kTracerSampled, kProfiler };
+
+static void RunOps(Mode mode, const std::string& type,
+                   const std::string& name) {
+  for (int i = 0; i < FLAGS_ops; ++i) {
+    if (mode == Mode::kProfiler) {
+      RecordEvent type_event(type);
+      RecordEvent name_event(name, EventRole::kUniqueOp);
+    } else {
+      ScopedOpTrace trace(type);
+    }
+  }
+}
+
+static double Run(Mode mode) {
+  auto& tracer = OpTracer::Instance();
+  if (mode == Mode::kTracer) {
+    tracer.Enable(1);
+  } else if (mode == Mode::kTracerSampled) {
+    tracer.Enable(16);
+  } else if (mode == Mode::kProfiler) {
+    EnableProfiler(ProfilerState::kCPU);
+  }
+
+  std::atomic<bool> finished{false};
+  size_t drained = 0;
+  std::thread drainer([&] {
+    while (!finished) {
+      std::this_thread::sleep_for(
+          std::chrono::milliseconds(FLAGS_drain_interval_ms));
+      drained += tracer.Drain().size();
+    }
+  });
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < FLAGS_threads; ++i) {
+    threads.emplace_back(RunOps, mode, "elementwise_add",
+                         "elementwise_add_0.tmp_0/elementwise_add");
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  std::chrono::duration<double, std::nano> elapsed =
+      std::chrono::steady_clock::now() - start;
+  finished = true;
+  drainer.join();
+  drained += tracer.Drain().size();
+
+  tracer.Disable();
+  if (mode == Mode::kProfiler) {
+    DisableProfiler(EventSortingKey::kDefault, "/dev/null");
+  }
+  return elapsed.count() / FLAGS_ops;
+}
+
+}  // namespace platform
+}  // namespace paddle
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  using paddle::platform::Mode;
+  std::cout << "threads: " << FLAGS_threads << ", ops per thread: "
+            << FLAGS_ops << std::endl;
+  std::cout << "mode\tns per op" << std::endl;
+  std::cout << "tracer disabled\t" << paddle::platform::Run(Mode::kTracerOff)
+            << std::endl;
+  std::cout << "tracer, every op\t" << paddle::platform::Run(Mode::kTracer)
+            << std::endl;
+  std::cout << "tracer, 1 in 16 ops\t"
+            << paddle::platform::Run(Mode::kTracerSampled) << std::endl;
+  std::cout << "profiler RecordEvent\t"
+            << paddle::platform::Run(Mode::kProfiler) << std::endl;
+  return 0;
+}
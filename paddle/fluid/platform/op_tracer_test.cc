@@ -0,0 +1,138 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/platform/op_tracer.h"
+
+#include <stdio.h>
+#include <atomic>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace platform = paddle::platform;
+
+static void TraceOps(int num_ops) {
+  for (int i = 0; i < num_ops; ++i) {
+    platform::ScopedOpTrace trace(i % 2 == 0 ? "mul" : "elementwise_add");
+    platform::OpTracer::RecordAlloc(100);
+  }
+}
+
+TEST(OpTracer, DrainThreads) {
+  auto& tracer = platform::OpTracer::Instance();
+  tracer.Drain();
+  tracer.Enable(1, 1024);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back(TraceOps, 100);
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  tracer.Disable();
+  // not traced
+  TraceOps(10);
+
+  auto records = tracer.Drain();
+  ASSERT_EQ(records.size(), 400UL);
+  std::map<uint32_t, int> counts;
+  for (size_t i = 0; i < records.size(); ++i) {
+    auto& record = records[i];
+    EXPECT_TRUE(std::string(record.name) == "mul" ||
+                std::string(record.name) == "elementwise_add");
+    EXPECT_GE(record.end_ns, record.start_ns);
+    EXPECT_EQ(record.allocated_bytes, 100);
+    if (i > 0) {
+      EXPECT_GE(record.start_ns, records[i - 1].start_ns);
+    }
+    ++counts[record.thread_id];
+  }
+  EXPECT_EQ(counts.size(), 4UL);
+  for (auto& count : counts) {
+    EXPECT_EQ(count.second, 100);
+  }
+  EXPECT_TRUE(tracer.Drain().empty());
+}
+
+TEST(OpTracer, OverwriteAndSample) {
+  auto& tracer = platform::OpTracer::Instance();
+  tracer.Drain();
+  size_t lost = tracer.lost();
+  // a ring of 8 records
+  tracer.Enable(1, 5);
+  std::thread(TraceOps, 20).join();
+  auto records = tracer.Drain();
+  EXPECT_EQ(records.size(), 8UL);
+  EXPECT_EQ(tracer.lost(), lost + 12);
+
+  tracer.Enable(4, 1024);
+  std::thread(TraceOps, 100).join();
+  tracer.Disable();
+  EXPECT_EQ(tracer.Drain().size(), 25UL);
+}
+
+TEST(OpTracer, ConcurrentDrain) {
+  platform::OpTraceRing ring(0, 64);
+  const uint64_t num_records = 200000;
+  std::atomic<bool> finished{false};
+  std::thread writer([&] {
+    platform::OpTraceRecord record;
+    snprintf(record.name, sizeof(record.name), "op");
+    record.thread_id = 0;
+    for (uint64_t i = 1; i <= num_records; ++i) {
+      record.start_ns = i;
+      record.end_ns = 2 * i;
+      record.allocated_bytes = static_cast<int64_t>(3 * i);
+      ring.Push(record);
+    }
+    finished = true;
+  });
+  std::vector<platform::OpTraceRecord> records;
+  size_t lost = 0;
+  while (!finished) {
+    lost += ring.Drain(&records);
+  }
+  writer.join();
+  lost += ring.Drain(&records);
+  EXPECT_EQ(records.size() + lost, num_records);
+  // no record is torn by the writer
+  for (size_t i = 0; i < records.size(); ++i) {
+    ASSERT_EQ(records[i].end_ns, 2 * records[i].start_ns);
+    ASSERT_EQ(records[i].allocated_bytes,
+              static_cast<int64_t>(3 * records[i].start_ns));
+    if (i > 0) {
+      ASSERT_GT(records[i].start_ns, records[i - 1].start_ns);
+    }
+  }
+}
+
+TEST(OpTracer, ChromeTrace) {
+  platform::OpTraceRecord record;
+  snprintf(record.name, sizeof(record.name), "fc");
+  record.thread_id = 3;
+  record.start_ns = 2000;
+  record.end_ns = 3500;
+  record.allocated_bytes = 4096;
+  std::stringstream ss;
+  platform::ExportChromeTrace({record}, ss);
+  EXPECT_EQ(ss.str(),
+            "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n"
+            "{\"name\": \"fc\", \"cat\": \"op\", \"ph\": \"X\", \"pid\": 0, "
+            "\"tid\": 3, \"ts\": 2.000, \"dur\": 1.500, \"args\": "
+            "{\"allocated_bytes\": 4096}}\n]}\n");
+}
@@ -249,6 +249,18 @@ void BindDataset(py::module *m) {
            py::call_guard<py::gil_scoped_release>())
       .def("release_memory", &framework::Dataset::ReleaseMemory,
            py::call_guard<py::gil_scoped_release>())
+      .def("save_into_slot_record_file",
+           &framework::Dataset::SaveIntoSlotRecordFile,
+           py::call_guard<py::gil_scoped_release>())
+      .def("set_use_slot_record_file",
+           &framework::Dataset::SetUseSlotRecordFile,
+           py::call_guard<py::gil_scoped_release>())
+      .def("set_file_prefetch_thread_num",
+           &framework::Dataset::SetFilePrefetchThreadNum,
+           py::call_guard<py::gil_scoped_release>())
+      .def("set_lock_free_channel_capacity",
+           &framework::Dataset::SetLockFreeChannelCapacity,
+           py::call_guard<py::gil_scoped_release>())
       .def("local_shuffle", &framework::Dataset::LocalShuffle,
            py::call_guard<py::gil_scoped_release>())
       .def("global_shuffle", &framework::Dataset::GlobalShuffle,
@@ -445,6 +445,14 @@ void BindAnalysisConfig(py::module *m) {
            &AnalysisConfig::SetCpuMathLibraryNumThreads)
       .def("cpu_math_library_num_threads",
            &AnalysisConfig::cpu_math_library_num_threads)
+      .def("enable_dynamic_batching", &AnalysisConfig::EnableDynamicBatching,
+           py::arg("max_batch_size"), py::arg("max_latency_us") = 1000,
+           py::arg("num_workers") = 1)
+      .def("dynamic_batching_enabled",
+           &AnalysisConfig::dynamic_batching_enabled)
+      .def("enable_numa_pool", &AnalysisConfig::EnableNumaPool,
+           py::arg("workers_per_node") = 1, py::arg("num_nodes") = 0)
+      .def("numa_pool_enabled", &AnalysisConfig::numa_pool_enabled)
       .def("to_native_config", &AnalysisConfig::ToNativeConfig)
       .def("enable_quantizer", &AnalysisConfig::EnableMkldnnQuantizer)
 #ifdef PADDLE_WITH_MKLDNN
@@ -500,6 +508,7 @@ void BindAnalysisPredictor(py::module *m) {
       .def("get_input_names", &AnalysisPredictor::GetInputNames)
       .def("get_output_names", &AnalysisPredictor::GetOutputNames)
       .def("get_input_tensor_shape", &AnalysisPredictor::GetInputTensorShape)
+      .def("get_output_tensor_shape", &AnalysisPredictor::GetOutputTensorShape)
       .def("zero_copy_run", &AnalysisPredictor::ZeroCopyRun)
       .def("create_feed_fetch_var", &AnalysisPredictor::CreateFeedFetchVar)
       .def("prepare_feed_fetch", &AnalysisPredictor::PrepareFeedFetch)
@@ -57,6 +57,7 @@ limitations under the License. */
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/platform/init.h"
 #include "paddle/fluid/platform/monitor.h"
+#include "paddle/fluid/platform/op_tracer.h"
 #include "paddle/fluid/platform/place.h"
 #include "paddle/fluid/platform/profiler.h"
 #include "paddle/fluid/pybind/box_helper_py.h"
@@ -1545,6 +1546,10 @@ All parameter, weight, gradient are variables in Paddle.
     for (const auto &stat : float_stats) {
       stats_map[stat.key] = stat.value;
     }
+    for (const auto &stat :
+         paddle::platform::StatGaugeRegistry::Instance().publish_float()) {
+      stats_map[stat.key] = stat.value;
+    }
     return stats_map;
   });
   m.def("get_int_stats", []() {
@@ -1554,8 +1559,37 @@ All parameter, weight, gradient are variables in Paddle.
     for (const auto &stat : int_stats) {
       stats_map[stat.key] = stat.value;
     }
+    for (const auto &stat :
+         paddle::platform::StatGaugeRegistry::Instance().publish()) {
+      stats_map[stat.key] = stat.value;
+    }
     return stats_map;
   });
+  m.def("get_histogram_stats", []() {
+    std::unordered_map<std::string, std::unordered_map<std::string, double>>
+        stats_map;
+    for (const auto &histogram :
+         paddle::platform::StatHistogramRegistry::Instance().publish()) {
+      auto &stat = stats_map[histogram.key];
+      stat["count"] = histogram.count;
+      stat["sum"] = histogram.sum;
+      stat["mean"] = histogram.mean();
+      stat["max"] = histogram.max;
+      stat["p50"] = histogram.percentile(0.5);
+      stat["p90"] = histogram.percentile(0.9);
+      stat["p99"] = histogram.percentile(0.99);
+    }
+    return stats_map;
+  });
+  m.def("dump_stats", paddle::platform::DumpStats);
+  m.def("start_stat_dump",
+        [](int interval, const std::string &path) {
+          paddle::platform::StatDumper::Instance().Start(interval, path);
+        },
+        py::arg("interval"), py::arg("path") = "");
+  m.def("stop_stat_dump", []() {
+    paddle::platform::StatDumper::Instance().Stop();
+  });
   m.def("run_cmd",
         [](const std::string &cmd, int time_out = -1,
            int sleep_inter = -1) -> const std::string {
@@ -1774,6 +1808,16 @@ All parameter, weight, gradient are variables in Paddle.
   m.def("disable_profiler", platform::DisableProfiler);
   m.def("is_profiler_enabled", platform::IsProfileEnabled);
   m.def("reset_profiler", platform::ResetProfiler);
+  m.def("enable_op_trace",
+        [](int sample_period, size_t buffer_size) {
+          platform::OpTracer::Instance().Enable(sample_period, buffer_size);
+        },
+        py::arg("sample_period") = 1, py::arg("buffer_size") = 4096);
+  m.def("disable_op_trace",
+        [] { platform::OpTracer::Instance().Disable(); });
+  m.def("is_op_trace_enabled", platform::OpTracer::IsEnabled);
+  m.def("dump_op_trace", platform::DumpOpTrace,
+        py::call_guard<py::gil_scoped_release>());
   m.def("get_pass", [](const std::string &pass_type) {
     auto pass = framework::ir::PassRegistry::Instance().Get(pass_type);
     return std::shared_ptr<framework::ir::Pass>(std::move(pass));
@@ -1943,7 +1987,21 @@ All parameter, weight, gradient are variables in Paddle.
                     [](const ExecutionStrategy &self) { return self.dry_run_; },
                     [](ExecutionStrategy &self, bool dry_run) {
                       self.dry_run_ = dry_run;
-                    });
+                    })
+      .def_property(
+          "use_work_stealing_pool",
+          [](const ExecutionStrategy &self) {
+            return self.use_work_stealing_pool_;
+          },
+          [](ExecutionStrategy &self, bool use_work_stealing_pool) {
+            self.use_work_stealing_pool_ = use_work_stealing_pool;
+          },
+          R"DOC(The type is BOOL, use_work_stealing_pool indicates whether
+                the experimental executor schedules ops in a work-stealing
+                thread pool, in which every thread owns a task queue. It
+                reduces the scheduling overhead of graphs with many small
+                ops. Default False.
+              )DOC");
 
   exec_strategy.def_property(
       "use_experimental_executor",
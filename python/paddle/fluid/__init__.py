@@ -176,7 +176,12 @@ def __bootstrap__():
         'enable_parallel_graph', 'fuse_parameter_groups_size',
         'multiple_of_cupti_buffer_size', 'fuse_parameter_memory_size',
         'tracer_profile_fname', 'dygraph_debug', 'use_system_allocator',
-        'enable_unused_var_check', 'free_idle_chunk', 'free_when_no_cache_hit'
+        'enable_unused_var_check', 'free_idle_chunk', 'free_when_no_cache_hit',
+        'cpu_thread_cache_in_kb', 'selected_rows_open_addressing_index',
+        'op_trace_sample_period', 'op_trace_buffer_size', 'stat_dump_interval',
+        'stat_dump_path', 'dygraph_cache_prepared_op',
+        'dygraph_backward_threads', 'enable_cpu_mem_stat',
+        'use_auto_growth_cpu_allocator'
     ]
     if 'Darwin' not in sysstr:
         read_env_flags.append('use_pinned_memory')
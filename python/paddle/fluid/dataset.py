@@ -349,6 +349,8 @@ class InMemoryDataset(DatasetBase):
         self.enable_pv_merge = False
         self.merge_by_lineid = False
         self.fleet_send_sleep_seconds = None
+        self.use_slot_record_file = False
+        self.file_prefetch_thread_num = 0
 
     def set_feed_type(self, data_feed_type):
         """
@@ -372,6 +374,9 @@ class InMemoryDataset(DatasetBase):
         self.dataset.set_parse_logkey(self.parse_logkey)
         self.dataset.set_merge_by_sid(self.merge_by_sid)
         self.dataset.set_enable_pv_merge(self.enable_pv_merge)
+        self.dataset.set_use_slot_record_file(self.use_slot_record_file)
+        self.dataset.set_file_prefetch_thread_num(
+            self.file_prefetch_thread_num)
         self.dataset.set_data_feed_desc(self.desc())
         self.dataset.create_channel()
         self.dataset.create_readers()
@@ -455,6 +460,44 @@ class InMemoryDataset(DatasetBase):
         """
         self.parse_logkey = parse_logkey
 
+    def set_use_slot_record_file(self, use_slot_record_file):
+        """
+        Set if the filelist are slot record files saved by
+        save_into_slot_record_file. Slot record files are memory-mapped
+        in load_into_memory rather than parsed, and local_shuffle only
+        shuffles the index of the records.
+
+        Args:
+            use_slot_record_file(bool): if use slot record file or not
+
+        Examples:
+            .. code-block:: python
+
+              import paddle.fluid as fluid
+              dataset = fluid.DatasetFactory().create_dataset("InMemoryDataset")
+              dataset.set_use_slot_record_file(True)
+
+        """
+        self.use_slot_record_file = use_slot_record_file
+
+    def set_file_prefetch_thread_num(self, thread_num):
+        """
+        Set the num of threads reading files ahead of the readers in
+        load_into_memory and preload_into_memory, 0 means no prefetching.
+
+        Args:
+            thread_num(int): prefetch thread num
+
+        Examples:
+            .. code-block:: python
+
+              import paddle.fluid as fluid
+              dataset = fluid.DatasetFactory().create_dataset("InMemoryDataset")
+              dataset.set_file_prefetch_thread_num(4)
+
+        """
+        self.file_prefetch_thread_num = thread_num
+
     def set_merge_by_sid(self, merge_by_sid):
         """
         Set if Dataset need to merge sid. If not, one ins means one Pv.
@@ -750,6 +793,27 @@ class InMemoryDataset(DatasetBase):
         """
         self.dataset.release_memory()
 
+    def save_into_slot_record_file(self, filename):
+        """
+        Save the data in memory into a local slot record file, which can be
+        loaded without parsing by set_use_slot_record_file(True).
+
+        Args:
+            filename(str): the local file to save
+
+        Examples:
+            .. code-block:: python
+
+              import paddle.fluid as fluid
+              dataset = fluid.DatasetFactory().create_dataset("InMemoryDataset")
+              filelist = ["a.txt", "b.txt"]
+              dataset.set_filelist(filelist)
+              dataset.load_into_memory()
+              dataset.save_into_slot_record_file("a.bin")
+
+        """
+        self.dataset.save_into_slot_record_file(filename)
+
     def get_pv_data_size(self):
         """
         Get memory data size of Pv, user can call this function to know the pv num
@@ -868,6 +932,7 @@ class QueueDataset(DatasetBase):
         """
         super(QueueDataset, self).__init__()
         self.proto_desc.name = "MultiSlotDataFeed"
+        self.lock_free_channel_capacity = 0
 
     def _prepare_to_run(self):
         """
@@ -880,9 +945,36 @@ class QueueDataset(DatasetBase):
             self.thread_num = 1
         self.dataset.set_thread_num(self.thread_num)
         self.dataset.set_filelist(self.filelist)
+        self.dataset.set_lock_free_channel_capacity(
+            self.lock_free_channel_capacity)
         self.dataset.set_data_feed_desc(self.desc())
         self.dataset.create_readers()
 
+    def set_lock_free_channel_capacity(self, capacity):
+        """
+        Create the queue from the reading thread of each reader to the
+        trainer with the lock-free backend, so that the reading threads
+        and the trainer threads don't contend on the lock of the queue. 0,
+        the default, means the queue guarded by a mutex.
+
+        A lock-free queue holds at most capacity instances, rounded up to a
+        power of 2, and allocates them when it is created. The reading
+        thread waits when the queue is full, until the trainer reads the
+        instances.
+
+        Args:
+            capacity(int): the most instances of the queue of a reader
+
+        Examples:
+            .. code-block:: python
+
+              import paddle.fluid as fluid
+              dataset = fluid.DatasetFactory().create_dataset("QueueDataset")
+              dataset.set_lock_free_channel_capacity(4096)
+
+        """
+        self.lock_free_channel_capacity = capacity
+
     def local_shuffle(self):
         """
         Local shuffle data.
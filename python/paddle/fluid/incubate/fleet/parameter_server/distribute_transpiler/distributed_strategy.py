@@ -44,6 +44,13 @@ class TrainerRuntimeConfig(object):
             "FLAGS_communicator_send_wait_times", "5")
         self.runtime_configs['communicator_is_sgd_optimizer'] = os.getenv(
             "FLAGS_communicator_is_sgd_optimizer", "1")
+        # none, fp16 or int8
+        self.runtime_configs['communicator_send_compression'] = os.getenv(
+            "FLAGS_communicator_send_compression", "none")
+        self.runtime_configs['communicator_recv_compression'] = os.getenv(
+            "FLAGS_communicator_recv_compression", "none")
+        self.runtime_configs['communicator_error_feedback'] = os.getenv(
+            "FLAGS_communicator_error_feedback", "1")
 
         # not used 
         self.runtime_configs['rpc_deadline'] = os.getenv("FLAGS_rpc_deadline",
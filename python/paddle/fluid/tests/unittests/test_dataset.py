@@ -257,6 +257,50 @@ class TestDataset(unittest.TestCase):
         os.remove("./test_in_memory_dataset_run_a.txt")
         os.remove("./test_in_memory_dataset_run_b.txt")
 
+    def test_queue_dataset_lock_free_channel(self):
+        """
+        Testcase for QueueDataset with lock-free queues holding fewer
+        instances than the files.
+        """
+        with open("test_queue_dataset_lock_free_a.txt", "w") as f:
+            data = ""
+            for i in range(50):
+                data += "1 %d 2 3 3 4 5 5 5 5 1 %d\n" % (i, i)
+            f.write(data)
+        with open("test_queue_dataset_lock_free_b.txt", "w") as f:
+            data = ""
+            for i in range(50, 100):
+                data += "1 %d 2 3 4 4 6 6 6 6 1 %d\n" % (i, i)
+            f.write(data)
+
+        slots = ["slot1", "slot2", "slot3", "slot4"]
+        slots_vars = []
+        for slot in slots:
+            var = fluid.layers.data(
+                name=slot, shape=[1], dtype="int64", lod_level=1)
+            slots_vars.append(var)
+
+        dataset = fluid.DatasetFactory().create_dataset("QueueDataset")
+        dataset.set_batch_size(8)
+        dataset.set_thread(2)
+        dataset.set_filelist([
+            "test_queue_dataset_lock_free_a.txt",
+            "test_queue_dataset_lock_free_b.txt"
+        ])
+        dataset.set_pipe_command("cat")
+        dataset.set_use_var(slots_vars)
+        dataset.set_lock_free_channel_capacity(4)
+        exe = fluid.Executor(fluid.CPUPlace())
+        exe.run(fluid.default_startup_program())
+        for i in range(self.epoch_num):
+            try:
+                exe.train_from_dataset(fluid.default_main_program(), dataset)
+            except Exception as e:
+                self.assertTrue(False)
+
+        os.remove("./test_queue_dataset_lock_free_a.txt")
+        os.remove("./test_queue_dataset_lock_free_b.txt")
+
     def test_in_memory_dataset_masterpatch(self):
         """
         Testcase for InMemoryDataset from create to run.
@@ -16,10 +16,14 @@ TestCases for Monitor
 """
 
 from __future__ import print_function
+import os
+# the CPU memory stats are counted only if the flag is set before the
+# allocators are created
+os.environ['FLAGS_enable_cpu_mem_stat'] = 'true'
 import paddle.fluid as fluid
 import paddle.fluid.core as core
+import json
 import numpy as np
-import os
 import unittest
 
 
@@ -89,5 +93,41 @@ class TestDatasetWithStat(unittest.TestCase):
         os.remove("./test_in_memory_dataset_run_b.txt")
 
 
+class TestRuntimeStats(unittest.TestCase):
+    """  TestCases for the runtime stats of the allocator and executor. """
+
+    def test_executor_and_allocator_stats(self):
+        x = fluid.layers.data(name="x", shape=[16], dtype="float32")
+        y = fluid.layers.fc(input=x, size=8)
+        exe = fluid.Executor(fluid.CPUPlace())
+        exe.run(fluid.default_startup_program())
+
+        op_count = core.get_int_stats()["STAT_executor_op_count"]
+        for i in range(5):
+            exe.run(fluid.default_main_program(),
+                    feed={"x": np.random.random((4, 16)).astype("float32")},
+                    fetch_list=[y])
+
+        int_stats = core.get_int_stats()
+        self.assertGreater(int_stats["STAT_executor_op_count"], op_count)
+        self.assertGreater(int_stats["STAT_cpu_mem_peak"], 0)
+        self.assertGreaterEqual(int_stats["STAT_cpu_mem_peak"],
+                                int_stats["STAT_cpu_mem_in_use"])
+        self.assertGreater(int_stats["STAT_cpu_mem_reserved"], 0)
+        fragmentation = core.get_float_stats()["STAT_cpu_mem_fragmentation"]
+        self.assertTrue(0.0 <= fragmentation <= 1.0)
+
+        histograms = core.get_histogram_stats()
+        self.assertGreaterEqual(histograms["STAT_executor_run_us"]["count"], 5)
+        self.assertGreater(histograms["STAT_cpu_alloc_size"]["count"], 0)
+
+        core.dump_stats("test_runtime_stats.json")
+        with open("test_runtime_stats.json") as f:
+            dumped = json.loads(f.read())
+        self.assertIn("STAT_executor_op_count", dumped["stats"])
+        self.assertIn("STAT_executor_run_us", dumped["histograms"])
+        os.remove("test_runtime_stats.json")
+
+
 if __name__ == '__main__':
     unittest.main()